@@ -25,6 +25,7 @@ include(CheckFunctionExists)
 check_function_exists(getifaddrs AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_GETIFADDRS)
 
 include(CheckSymbolExists)
+check_symbol_exists("epoll_create1" "sys/epoll.h" AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_EPOLL)
 check_symbol_exists("gai_strerror" "netdb.h" AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_GAI_STRERROR)
 check_symbol_exists("getnameinfo" "netdb.h" AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_GETNAMEINFO)
 check_symbol_exists("inet_ntop" "arpa/inet.h" AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_INET_NTOP)
@@ -50,4 +51,14 @@ else()
     message(STATUS "Checking if IN6_IS_ADDR_V4MAPPED is usable - no")
 endif()
 
+check_symbol_exists("UDP_SEGMENT" "netinet/udp.h" AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_UDP_SEGMENT)
+check_symbol_exists("UDP_GRO" "netinet/udp.h" AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_UDP_GRO)
+check_symbol_exists("sendfile" "sys/sendfile.h" AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDFILE)
+
+# recvmmsg() and sendmmsg() are GNU extensions; avs_net_impl.c defines
+# _GNU_SOURCE if they are available.
+set(CMAKE_REQUIRED_DEFINITIONS ${STORED_REQUIRED_DEFINITIONS} -D_GNU_SOURCE)
+check_symbol_exists("recvmmsg" "sys/socket.h" AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_RECVMMSG)
+check_symbol_exists("sendmmsg" "sys/socket.h" AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDMMSG)
+
 set(CMAKE_REQUIRED_DEFINITIONS "${STORED_REQUIRED_DEFINITIONS}")
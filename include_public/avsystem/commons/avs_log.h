@@ -261,6 +261,144 @@ int avs_log_set_level__(const char *module, avs_log_level_t level);
 #define avs_log_set_default_level(Level) \
     ((void) avs_log_set_level__(NULL, Level))
 
+/**
+ * User-defined sink for binary log records, see
+ * @ref avs_log_set_binary_writer .
+ *
+ * @param data Chunk of the binary log stream.
+ *
+ * @param size Number of bytes in @p data .
+ *
+ * @param arg  Opaque argument passed to @ref avs_log_set_binary_writer .
+ */
+typedef void avs_log_binary_writer_t(const void *data, size_t size, void *arg);
+
+/**
+ * Switches the logging system into binary mode.
+ *
+ * In binary mode, log messages are not formatted at all. Instead, a compact
+ * record containing the log level, references to the module name, source file
+ * name and format string, the line number and raw values of the format
+ * arguments is passed to @p writer . Each distinct string is included in the
+ * stream only once, when it is first used; the library keeps copies of up to
+ * 256 strings, of up to 8 KiB in total, and sends them again once these limits
+ * are exceeded. Each record is prefixed with its length. Records are never
+ * truncated, so <c>AVS_COMMONS_LOG_MAX_LINE_LENGTH</c> does not apply.
+ * Messages that cannot be encoded, e.g. due to an out-of-memory condition,
+ * are passed to the log handler as text instead.
+ *
+ * The stream may be converted into regular text logs using the
+ * <c>tools/avs_log_decode.py</c> script. Each call to this function starts a
+ * new stream, beginning with a header.
+ *
+ * Binary mode is only available if the library is compiled with the
+ * <c>WITH_AVS_LOG_BINARY</c> CMake option. It takes precedence over both the
+ * log handler and the asynchronous mode (see @ref avs_log_async_start ).
+ *
+ * NOTE: Wide character conversions (<c>%ls</c>) are not supported.
+ *
+ * NOTE: @p writer is called with the logging system locked, so it MUST NOT
+ * log anything itself.
+ *
+ * @param writer     Function to pass the binary log stream to. If NULL, binary
+ *                   mode is disabled and log messages are passed to the log
+ *                   handler again.
+ *
+ * @param writer_arg Opaque argument to pass to @p writer .
+ *
+ * @returns
+ * - 0 on success
+ * - negative value if @p writer is not NULL and the library has been compiled
+ *   without binary logging support
+ */
+int avs_log_set_binary_writer(avs_log_binary_writer_t *writer,
+                              void *writer_arg);
+
+/**
+ * Counters describing the asynchronous logging mode, as returned by
+ * @ref avs_log_async_stats .
+ */
+typedef struct {
+    /** Number of messages queued for asynchronous processing. */
+    unsigned long queued;
+
+    /** Number of messages discarded because the queue was full. */
+    unsigned long dropped;
+} avs_log_async_stats_t;
+
+/**
+ * Switches the logging system into asynchronous mode.
+ *
+ * In asynchronous mode, log messages are formatted by the logging thread and
+ * stored in a queue of <c>AVS_COMMONS_LOG_ASYNC_QUEUE_SIZE</c> entries, instead
+ * of being passed to the log handler directly. Logging threads only hold the
+ * global log lock in shared mode while publishing a message, and never wait
+ * for the log handler. The handler is
+ * then called from within @ref avs_log_async_drainer_run , @ref
+ * avs_log_async_flush or @ref avs_log_async_stop , so a slow log sink no longer
+ * stalls the threads that log. If the queue is full, messages are discarded and
+ * counted; the number of discarded messages is then reported through the log
+ * handler as a warning.
+ *
+ * Asynchronous mode is only available if the library is compiled with the
+ * <c>WITH_AVS_LOG_ASYNC</c> CMake option.
+ *
+ * NOTE: Module names and source file names are not copied into the queue, so
+ * they MUST remain valid until the message is processed. This is always true
+ * for messages logged using the @ref avs_log family of macros.
+ *
+ * @returns
+ * - 0 on success, or if the asynchronous mode is already active
+ * - negative value in case of error, or if the library has been compiled
+ *   without asynchronous logging support
+ */
+int avs_log_async_start(void);
+
+/**
+ * Passes queued log messages to the log handler on the calling thread.
+ *
+ * This function is intended to be called on a dedicated thread owned by the
+ * application. It blocks, waiting for new messages, until @ref
+ * avs_log_async_stop is called. At most one such thread may be active at a
+ * time.
+ *
+ * @returns
+ * - 0 after the asynchronous mode has been stopped
+ * - negative value if the asynchronous mode is not active, another thread is
+ *   already running this function, or an error occurred
+ */
+int avs_log_async_drainer_run(void);
+
+/**
+ * Synchronously passes all log messages queued so far to the log handler. Does
+ * nothing if the asynchronous mode has never been started.
+ */
+void avs_log_async_flush(void);
+
+/**
+ * Flushes all queued log messages, switches the logging system back to the
+ * synchronous mode and makes @ref avs_log_async_drainer_run return. After this
+ * function returns, the drainer thread may be joined. Messages logged
+ * concurrently with this function are either flushed by it, or passed to the
+ * log handler synchronously; none are left in the queue.
+ *
+ * This function is also called by @ref avs_log_reset .
+ */
+void avs_log_async_stop(void);
+
+/**
+ * Retrieves the counters of the asynchronous logging mode, accumulated since
+ * the first call to @ref avs_log_async_start .
+ *
+ * @param out_stats Structure to fill with the counters.
+ *
+ * @returns
+ * - 0 on success
+ * - negative value if the library has been compiled without asynchronous
+ *   logging support
+ */
+int avs_log_async_stats(avs_log_async_stats_t *out_stats);
+
 #ifndef AVS_COMMONS_WITH_MICRO_LOGS
 #    define AVS_DISPOSABLE_LOG(Arg) Arg
 #else
@@ -0,0 +1,225 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file avs_net_dtls_server.h
+ */
+
+#ifndef AVS_COMMONS_NET_DTLS_SERVER_H
+#define AVS_COMMONS_NET_DTLS_SERVER_H
+
+#include <stddef.h>
+
+#include <avsystem/commons/avs_errno.h>
+#include <avsystem/commons/avs_socket.h>
+#include <avsystem/commons/avs_time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * DTLS-PSK server terminating the sessions of many peers on a single UDP
+ * socket, using a single tinyDTLS context. It is only available in the
+ * <c>avs_net_tinydtls</c> library.
+ *
+ * Each peer, identified by its remote address and port, is represented by a
+ * virtual socket owned by the server. All memory is allocated when the server
+ * is created: the number of peers is limited by
+ * @ref avs_net_dtls_server_config_t::max_peers , and datagrams from new peers
+ * are dropped if that limit has been reached. Memory used internally by
+ * tinyDTLS for each peer is bounded by the same limit.
+ *
+ * The server does not block on its own: all network traffic is handled by
+ * @ref avs_net_dtls_server_process , which processes at most a single
+ * datagram per call, and by @ref avs_net_dtls_server_next_timeout , which
+ * retransmits handshake messages. Typical event loop:
+ *
+ * - Add @ref avs_net_dtls_server_socket to an @ref avs_net_poller_t , for
+ *   reading, and set its receive timeout to zero.
+ * - Call @ref avs_net_dtls_server_next_timeout and wait for the socket to
+ *   become readable, but no longer than until the returned deadline. Repeat
+ *   this step whenever the deadline passes.
+ * - Whenever the socket becomes readable, call
+ *   @ref avs_net_dtls_server_process until it returns
+ *   <c>avs_errno(AVS_ETIMEDOUT)</c>, then go back to the previous step.
+ * - If it reports @ref AVS_NET_DTLS_SERVER_PEER_NEW , a handshake with a new
+ *   peer has been completed; the socket is now owned by the application,
+ *   until it calls @ref avs_net_socket_cleanup on it.
+ * - If it reports @ref AVS_NET_DTLS_SERVER_PEER_DATA , possibly along with
+ *   @ref AVS_NET_DTLS_SERVER_PEER_NEW , call @ref avs_net_socket_receive on
+ *   the reported socket before the next call to
+ *   @ref avs_net_dtls_server_process .
+ * - If it reports @ref AVS_NET_DTLS_SERVER_PEER_CLOSED , the peer has closed
+ *   the connection; the application is expected to clean up the socket.
+ *
+ * Peer sockets support @ref avs_net_socket_send , @ref avs_net_socket_receive ,
+ * @ref avs_net_socket_close , @ref avs_net_socket_cleanup , querying the
+ * remote and local address, and the @ref AVS_NET_SOCKET_OPT_STATE ,
+ * @ref AVS_NET_SOCKET_OPT_MTU and @ref AVS_NET_SOCKET_OPT_INNER_MTU options.
+ * Receiving never blocks: if no data is pending for the peer,
+ * <c>avs_errno(AVS_ETIMEDOUT)</c> is returned.
+ *
+ * The server and its peer sockets MUST NOT be used concurrently from multiple
+ * threads.
+ */
+typedef struct avs_net_dtls_server_struct avs_net_dtls_server_t;
+
+/**
+ * Callback used to look up the pre-shared key for a PSK identity presented by
+ * a peer.
+ *
+ * @param arg           Opaque argument, as passed in
+ *                      @ref avs_net_dtls_server_config_t::psk_lookup_arg .
+ * @param identity      PSK identity presented by the peer.
+ * @param identity_size Size of @p identity , in bytes.
+ * @param out_key       Buffer to copy the key into.
+ * @param key_capacity  Size of @p out_key , in bytes.
+ * @param out_key_size  Pointer to a variable that shall be set to the size of
+ *                      the key, in bytes.
+ *
+ * @returns @ref AVS_OK for success, or an error condition if the identity is
+ *          unknown, in which case the handshake is aborted.
+ */
+typedef avs_error_t avs_net_dtls_server_psk_lookup_t(void *arg,
+                                                     const void *identity,
+                                                     size_t identity_size,
+                                                     void *out_key,
+                                                     size_t key_capacity,
+                                                     size_t *out_key_size);
+
+typedef struct {
+    /**
+     * Maximum number of peers, including the ones that are in the middle of a
+     * handshake. MUST be nonzero.
+     */
+    size_t max_peers;
+
+    /**
+     * Key and identity accepted from all peers. Ignored if @ref psk_lookup is
+     * not NULL. Both MUST be stored in buffers.
+     */
+    avs_net_psk_info_t psk;
+
+    /**
+     * Callback to look up the key for each peer's identity, or NULL to use
+     * @ref psk instead.
+     */
+    avs_net_dtls_server_psk_lookup_t *psk_lookup;
+
+    /** Opaque argument passed to @ref psk_lookup . */
+    void *psk_lookup_arg;
+
+    /** Configuration of the underlying UDP socket. */
+    avs_net_socket_configuration_t backend_configuration;
+} avs_net_dtls_server_config_t;
+
+/**
+ * Creates a new DTLS server.
+ *
+ * @param[out] out_server Pointer to a variable that will be set to the newly
+ *                        created server. It MUST be NULL when calling this
+ *                        function.
+ * @param      config     Server configuration. The PSK data is copied, so it
+ *                        does not need to remain valid.
+ *
+ * @returns @ref AVS_OK for success, or an error condition for which the
+ *          operation failed.
+ */
+avs_error_t
+avs_net_dtls_server_create(avs_net_dtls_server_t **out_server,
+                           const avs_net_dtls_server_config_t *config);
+
+/**
+ * Destroys a DTLS server, along with all its sessions, and sets
+ * <c>*server</c> to NULL. Does nothing if <c>*server</c> is NULL.
+ *
+ * All peer sockets owned by the application MUST be cleaned up before calling
+ * this function.
+ */
+void avs_net_dtls_server_cleanup(avs_net_dtls_server_t **server);
+
+/**
+ * Binds the underlying UDP socket to a local address and port, see
+ * @ref avs_net_socket_bind .
+ */
+avs_error_t avs_net_dtls_server_bind(avs_net_dtls_server_t *server,
+                                     const char *address,
+                                     const char *port);
+
+/**
+ * Returns the underlying UDP socket of @p server . It becomes readable whenever
+ * @ref avs_net_dtls_server_process has a datagram to process.
+ *
+ * The socket is owned by the server. It MAY be used to set options such as the
+ * receive timeout, and to wait for readiness, but MUST NOT be used to send or
+ * receive data.
+ */
+avs_net_socket_t *avs_net_dtls_server_socket(avs_net_dtls_server_t *server);
+
+/** The peer has just completed its handshake. */
+#define AVS_NET_DTLS_SERVER_PEER_NEW (1 << 0)
+/** Application data from the peer is pending. */
+#define AVS_NET_DTLS_SERVER_PEER_DATA (1 << 1)
+/** The peer has closed the connection. */
+#define AVS_NET_DTLS_SERVER_PEER_CLOSED (1 << 2)
+
+/**
+ * Performs any pending retransmissions of handshake messages, and returns the
+ * time at which the next one is due.
+ *
+ * @returns Time at which this function shall be called again, or
+ *          @ref AVS_TIME_MONOTONIC_INVALID if no handshake is in progress.
+ *          Returned time MAY be in the past, if the retransmission is already
+ *          due.
+ */
+avs_time_monotonic_t
+avs_net_dtls_server_next_timeout(avs_net_dtls_server_t *server);
+
+/**
+ * Receives and processes a single datagram, and performs any pending
+ * retransmissions of handshake messages.
+ *
+ * Application data delivered by the previous call, if not received using
+ * @ref avs_net_socket_receive yet, is discarded. Only the first application
+ * data record of each datagram is delivered.
+ *
+ * @param      server     DTLS server to operate on.
+ * @param[out] out_peer   Set to the peer socket whose state has changed, or
+ *                        to NULL if the datagram did not result in any
+ *                        change reported to the application.
+ * @param[out] out_events Set to a bitmask of AVS_NET_DTLS_SERVER_PEER_*
+ *                        flags describing the change, or to 0 if
+ *                        @p out_peer is NULL. A datagram that completes the
+ *                        handshake may also carry application data, in which
+ *                        case both @ref AVS_NET_DTLS_SERVER_PEER_NEW and
+ *                        @ref AVS_NET_DTLS_SERVER_PEER_DATA are set.
+ *
+ * @returns @ref AVS_OK for success, or an error condition reported by the
+ *          underlying UDP socket, in particular <c>avs_errno(AVS_ETIMEDOUT)</c>
+ *          if no datagram has been received within its receive timeout.
+ *          Malformed datagrams and failed handshakes are not considered
+ *          errors.
+ */
+avs_error_t avs_net_dtls_server_process(avs_net_dtls_server_t *server,
+                                        avs_net_socket_t **out_peer,
+                                        int *out_events);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AVS_COMMONS_NET_DTLS_SERVER_H */
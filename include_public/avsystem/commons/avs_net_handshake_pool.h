@@ -0,0 +1,149 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file avs_net_handshake_pool.h
+ */
+
+#ifndef AVS_COMMONS_NET_HANDSHAKE_POOL_H
+#define AVS_COMMONS_NET_HANDSHAKE_POOL_H
+
+#include <stddef.h>
+
+#include <avsystem/commons/avs_errno.h>
+#include <avsystem/commons/avs_socket.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Pool of worker threads performing the steps of asynchronous (D)TLS
+ * handshakes started using @ref avs_net_socket_decorate_async , so that the
+ * expensive cryptographic operations do not block the thread that drives the
+ * handshakes.
+ *
+ * Worker threads are created by the application and call
+ * @ref avs_net_handshake_pool_worker_run . Completion of the steps is
+ * signalled through readiness of the notifier socket, see
+ * @ref avs_net_handshake_pool_notifier , so that the driving thread may wait
+ * for it using the same @ref avs_net_poller_t as for the network sockets.
+ *
+ * Typical usage on the driving thread:
+ *
+ * - Add @ref avs_net_handshake_pool_notifier to the poller, for reading.
+ * - Call @ref avs_net_socket_decorate_async for each accepted socket. If it
+ *   returns <c>avs_errno(AVS_EAGAIN)</c>, add the socket to the poller, for
+ *   reading, and call @ref avs_net_socket_handshake_continue when it becomes
+ *   readable.
+ * - If either of these functions returns <c>avs_errno(AVS_EINPROGRESS)</c>,
+ *   stop waiting on that socket until it is reported by
+ *   @ref avs_net_handshake_pool_get_completed , which shall be called
+ *   whenever the notifier socket becomes readable. Then, call
+ *   @ref avs_net_socket_handshake_continue on it.
+ *
+ * The PRNG and the SSL context used by the sockets are accessed from the
+ * worker threads, so they MUST be safe to use concurrently.
+ *
+ * All functions are thread-safe, but @ref avs_net_handshake_pool_get_completed
+ * is intended to be called from a single driving thread.
+ */
+
+/**
+ * Creates a new handshake pool.
+ *
+ * @param[out] out_pool Pointer to a variable that will be set to the newly
+ *                      created pool. It MUST be NULL when calling this
+ *                      function.
+ *
+ * @returns @ref AVS_OK for success, or an error condition for which the
+ *          operation failed.
+ */
+avs_error_t avs_net_handshake_pool_create(avs_net_handshake_pool_t **out_pool);
+
+/**
+ * Destroys a handshake pool and sets <c>*pool</c> to NULL. Does nothing if
+ * <c>*pool</c> is NULL.
+ *
+ * All workers MUST be stopped using @ref avs_net_handshake_pool_workers_stop ,
+ * and all sockets using the pool MUST be cleaned up, before calling this
+ * function.
+ */
+void avs_net_handshake_pool_cleanup(avs_net_handshake_pool_t **pool);
+
+/**
+ * Returns the notifier socket of @p pool . It becomes readable whenever there
+ * are sockets to be reported by @ref avs_net_handshake_pool_get_completed .
+ *
+ * The socket is owned by the pool. It MUST NOT be used for anything other than
+ * waiting for readiness, e.g. using @ref avs_net_poller_add or
+ * @ref avs_net_socket_get_system .
+ */
+avs_net_socket_t *
+avs_net_handshake_pool_notifier(avs_net_handshake_pool_t *pool);
+
+/**
+ * Retrieves the sockets whose handshake steps have been completed by the
+ * workers since the last call. @ref avs_net_socket_handshake_continue shall be
+ * called on each of them.
+ *
+ * If more than @p max_sockets sockets are waiting to be reported, the notifier
+ * socket remains readable.
+ *
+ * @param pool        Handshake pool to query.
+ * @param out_sockets Array to fill with the sockets.
+ * @param max_sockets Number of elements in @p out_sockets .
+ *
+ * @returns Number of sockets stored in @p out_sockets .
+ */
+size_t avs_net_handshake_pool_get_completed(avs_net_handshake_pool_t *pool,
+                                            avs_net_socket_t **out_sockets,
+                                            size_t max_sockets);
+
+/**
+ * Performs queued handshake steps as one of the worker threads of @p pool .
+ *
+ * This function is intended to be called from a number of threads created by
+ * the application. It waits until a step is queued, performs it, and repeats,
+ * until @ref avs_net_handshake_pool_workers_stop is called.
+ *
+ * @returns
+ * - 0 when the worker has been stopped using
+ *   @ref avs_net_handshake_pool_workers_stop
+ * - A negative value in case of error when using synchronization primitives.
+ */
+int avs_net_handshake_pool_worker_run(avs_net_handshake_pool_t *pool);
+
+/**
+ * Makes all calls to @ref avs_net_handshake_pool_worker_run on @p pool return,
+ * and waits until they do.
+ *
+ * Steps currently being performed are allowed to finish. Steps that have not
+ * been started yet are completed with <c>avs_errno(AVS_EINTR)</c>, so the
+ * corresponding handshakes fail when continued. Handshake steps submitted
+ * afterwards fail immediately with the same error.
+ *
+ * @returns
+ * - 0 on success
+ * - A negative value in case of error when using synchronization primitives.
+ */
+int avs_net_handshake_pool_workers_stop(avs_net_handshake_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AVS_COMMONS_NET_HANDSHAKE_POOL_H */
@@ -0,0 +1,201 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file avs_net_poller.h
+ */
+
+#ifndef AVS_COMMONS_NET_POLLER_H
+#define AVS_COMMONS_NET_POLLER_H
+
+#include <stddef.h>
+
+#include <avsystem/commons/avs_errno.h>
+#include <avsystem/commons/avs_socket.h>
+#include <avsystem/commons/avs_time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Object that waits for readiness of many sockets at once.
+ *
+ * On Linux, it is implemented using <c>epoll</c>, so the cost of waiting does
+ * not depend on the number of registered sockets. Elsewhere, <c>poll()</c> is
+ * used.
+ *
+ * The poller is not thread-safe; all calls on a single poller object shall be
+ * made from one thread at a time.
+ */
+typedef struct avs_net_poller_struct avs_net_poller_t;
+
+/**
+ * Event flag: the socket has data to receive, has a connection to accept, or
+ * has been closed by the remote end.
+ */
+#define AVS_NET_POLLER_READ (1 << 0)
+
+/**
+ * Event flag: data may be sent on the socket without blocking.
+ */
+#define AVS_NET_POLLER_WRITE (1 << 1)
+
+/**
+ * Event flag, only reported by @ref avs_net_poller_wait : an error condition
+ * or a hangup has been detected on the socket. The next operation on the
+ * socket will return the error.
+ */
+#define AVS_NET_POLLER_ERROR (1 << 2)
+
+/**
+ * Readiness event reported by @ref avs_net_poller_wait .
+ */
+typedef struct {
+    /** Socket that is ready. */
+    avs_net_socket_t *socket;
+
+    /** User data passed to @ref avs_net_poller_add . */
+    void *user_data;
+
+    /** Combination of <c>AVS_NET_POLLER_*</c> flags. */
+    int events;
+} avs_net_poller_event_t;
+
+/**
+ * Creates a new poller object.
+ *
+ * @param[out] out_poller Pointer to a variable that will be set to the newly
+ *                        created poller. <c>*out_poller</c> MUST be NULL.
+ *
+ * @returns @ref AVS_OK for success, or an error condition for which the
+ *          operation failed. <c>AVS_ENOTSUP</c> is returned if neither
+ *          <c>epoll</c> nor <c>poll()</c> is available on the platform.
+ */
+avs_error_t avs_net_poller_create(avs_net_poller_t **out_poller);
+
+/**
+ * Destroys a poller object and sets <c>*poller</c> to NULL. The registered
+ * sockets are not affected. Does nothing if <c>*poller</c> is NULL.
+ */
+void avs_net_poller_cleanup(avs_net_poller_t **poller);
+
+/**
+ * Registers a socket in the poller.
+ *
+ * The socket MUST already have an underlying system socket, i.e. it MUST have
+ * been connected, bound or accepted. The socket is identified by its system
+ * socket, so if it is closed and reopened (e.g. reconnected), it MUST be
+ * removed and added again.
+ *
+ * For (D)TLS sockets, readiness refers to the underlying network socket.
+ * Decrypted data may remain buffered inside the socket after a receive
+ * operation - check the @ref AVS_NET_SOCKET_HAS_BUFFERED_DATA option before
+ * waiting again.
+ *
+ * @param poller    Poller object to operate on.
+ *
+ * @param socket    Socket to register.
+ *
+ * @param events    Combination of @ref AVS_NET_POLLER_READ and
+ *                  @ref AVS_NET_POLLER_WRITE flags to wait for.
+ *
+ * @param user_data Opaque pointer that will be reported along with the events
+ *                  on @p socket .
+ *
+ * @returns @ref AVS_OK for success, or an error condition for which the
+ *          operation failed. <c>AVS_EEXIST</c> is returned if the socket is
+ *          already registered, and <c>AVS_EBADF</c> if it has no system socket.
+ */
+avs_error_t avs_net_poller_add(avs_net_poller_t *poller,
+                               avs_net_socket_t *socket,
+                               int events,
+                               void *user_data);
+
+/**
+ * Changes the set of events waited for on a registered socket.
+ *
+ * @returns @ref AVS_OK for success, or an error condition for which the
+ *          operation failed. <c>AVS_ENOENT</c> is returned if the socket is
+ *          not registered.
+ */
+avs_error_t avs_net_poller_modify(avs_net_poller_t *poller,
+                                  avs_net_socket_t *socket,
+                                  int events);
+
+/**
+ * Unregisters a socket from the poller. This MUST be done before the socket
+ * is cleaned up, and SHOULD be done before it is closed.
+ *
+ * @returns @ref AVS_OK for success, or <c>AVS_ENOENT</c> if the socket is not
+ *          registered.
+ */
+avs_error_t avs_net_poller_remove(avs_net_poller_t *poller,
+                                  avs_net_socket_t *socket);
+
+/**
+ * Waits until at least one registered socket is ready, or the timeout expires.
+ *
+ * This function is designed to be used in an event loop along with avs_sched:
+ *
+ * @code
+ * while (running) {
+ *     avs_net_poller_event_t events[64];
+ *     size_t count;
+ *     if (avs_is_err(avs_net_poller_wait(poller, events,
+ *                                        AVS_ARRAY_SIZE(events), &count,
+ *                                        avs_sched_time_to_next(sched)))) {
+ *         break;
+ *     }
+ *     for (size_t i = 0; i < count; ++i) {
+ *         handle_event(&events[i]);
+ *     }
+ *     avs_sched_run(sched);
+ * }
+ * @endcode
+ *
+ * If more sockets are ready than fit in @p out_events , the remaining ones
+ * will be reported by subsequent calls.
+ *
+ * @param poller     Poller object to operate on.
+ *
+ * @param out_events Array to fill with readiness events.
+ *
+ * @param max_events Size of the @p out_events array. MUST be positive.
+ *
+ * @param out_count  Variable to set to the number of events stored in
+ *                   @p out_events . It may be set to 0 if the timeout expired,
+ *                   or if the wait was interrupted by a signal.
+ *
+ * @param timeout    Maximum time to wait. Negative values mean not to wait at
+ *                   all, and an invalid duration means waiting indefinitely -
+ *                   both consistent with the semantics of
+ *                   <c>avs_sched_time_to_next()</c>.
+ *
+ * @returns @ref AVS_OK for success (including a timeout), or an error
+ *          condition for which the operation failed.
+ */
+avs_error_t avs_net_poller_wait(avs_net_poller_t *poller,
+                                avs_net_poller_event_t *out_events,
+                                size_t max_events,
+                                size_t *out_count,
+                                avs_time_duration_t timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AVS_COMMONS_NET_POLLER_H */
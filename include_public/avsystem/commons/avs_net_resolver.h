@@ -0,0 +1,278 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file avs_net_resolver.h
+ */
+
+#ifndef AVS_COMMONS_NET_RESOLVER_H
+#define AVS_COMMONS_NET_RESOLVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <avsystem/commons/avs_addrinfo.h>
+#include <avsystem/commons/avs_errno.h>
+#include <avsystem/commons/avs_socket.h>
+#include <avsystem/commons/avs_time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Caching, asynchronous host name resolver built on top of
+ * @ref avs_net_addrinfo_resolve_ex .
+ *
+ * Results of successful and failed lookups are cached for a configurable time,
+ * so that e.g. many clients reconnecting to the same server after a network
+ * outage cause a single DNS query instead of one per client. Concurrent
+ * asynchronous queries for the same name are also coalesced into a single
+ * lookup.
+ *
+ * Asynchronous lookups are performed by worker threads created by the
+ * application, which call @ref avs_net_resolver_worker_run .
+ *
+ * All functions are thread-safe.
+ */
+typedef struct avs_net_resolver_struct avs_net_resolver_t;
+
+/**
+ * Maximum number of addresses stored for a single cached host name. Any
+ * further addresses returned by the system resolver are ignored.
+ */
+#define AVS_NET_RESOLVER_MAX_ENDPOINTS 8
+
+/**
+ * Configuration of a resolver object, passed to @ref avs_net_resolver_create .
+ */
+typedef struct {
+    /**
+     * Maximum number of cached lookup results. When it is exceeded, the least
+     * recently used entries are discarded. If 0, results are not cached, but
+     * concurrent asynchronous queries are still coalesced.
+     */
+    size_t cache_size;
+
+    /**
+     * Time for which successful lookup results are reused. The system resolver
+     * API does not expose TTL values of DNS records, so this needs to be
+     * configured explicitly.
+     */
+    avs_time_duration_t positive_ttl;
+
+    /**
+     * Time for which failed lookups are remembered, so that repeated queries
+     * for a nonexistent or unreachable name fail immediately.
+     */
+    avs_time_duration_t negative_ttl;
+} avs_net_resolver_config_t;
+
+/**
+ * Counters describing the effectiveness of the cache, as returned by
+ * @ref avs_net_resolver_stats .
+ */
+typedef struct {
+    /**
+     * Number of queries answered from the cache, including negative entries
+     * and asynchronous queries attached to a lookup already in progress.
+     */
+    uint64_t cache_hits;
+
+    /** Number of queries that needed a call to the system resolver. */
+    uint64_t cache_misses;
+
+    /** Number of queries answered with a cached failure. */
+    uint64_t negative_hits;
+} avs_net_resolver_stats_t;
+
+/**
+ * Result of a lookup, passed to @ref avs_net_resolver_callback_t or filled by
+ * @ref avs_net_resolver_resolve .
+ */
+typedef struct {
+    /** Resolved addresses, in the order they shall be tried. */
+    avs_net_resolved_endpoint_t endpoints[AVS_NET_RESOLVER_MAX_ENDPOINTS];
+
+    /** Number of valid elements in @c endpoints ; at least 1 on success. */
+    size_t count;
+} avs_net_resolver_result_t;
+
+/**
+ * Callback called when an asynchronous lookup started using
+ * @ref avs_net_resolver_resolve_async completes.
+ *
+ * @param arg    Opaque argument passed to
+ *               @ref avs_net_resolver_resolve_async .
+ * @param err    @ref AVS_OK if the name has been resolved, or an error
+ *               condition otherwise. <c>avs_errno(AVS_EINTR)</c> is passed
+ *               if the query has been discarded by
+ *               @ref avs_net_resolver_workers_stop .
+ * @param result Lookup result. Only valid during the call, and only if @p err
+ *               is @ref AVS_OK.
+ */
+typedef void avs_net_resolver_callback_t(void *arg,
+                                         avs_error_t err,
+                                         const avs_net_resolver_result_t *result);
+
+/**
+ * Creates a new resolver object.
+ *
+ * @param[out] out_resolver Pointer to a variable that will be set to the newly
+ *                          created resolver. It MUST be NULL when calling this
+ *                          function.
+ * @param[in]  config       Resolver configuration.
+ *
+ * @returns @ref AVS_OK for success, or an error condition for which the
+ *          operation failed.
+ */
+avs_error_t avs_net_resolver_create(avs_net_resolver_t **out_resolver,
+                                    const avs_net_resolver_config_t *config);
+
+/**
+ * Destroys a resolver object and sets <c>*resolver</c> to NULL. Does nothing
+ * if <c>*resolver</c> is NULL.
+ *
+ * All workers MUST be stopped using @ref avs_net_resolver_workers_stop before
+ * calling this function.
+ */
+void avs_net_resolver_cleanup(avs_net_resolver_t **resolver);
+
+/**
+ * Resolves a host name synchronously, using the cache if possible.
+ *
+ * On a cache miss, the system resolver is called on the calling thread and its
+ * result is stored in the cache.
+ *
+ * @param resolver    Resolver object to use.
+ * @param socket_type Type of the socket the address will be used with.
+ * @param family      Address family to look up.
+ * @param host        Host name or numeric address to resolve.
+ * @param port        Port to put in the resolved endpoints.
+ * @param flags       Flags as for @ref avs_net_addrinfo_resolve_ex .
+ * @param out_result  Structure to fill with the lookup result.
+ *
+ * @returns @ref AVS_OK for success, <c>avs_errno(AVS_EADDRNOTAVAIL)</c> if the
+ *          name could not be resolved (now or when a negative entry was
+ *          cached), or another error condition for which the operation failed.
+ */
+avs_error_t avs_net_resolver_resolve(avs_net_resolver_t *resolver,
+                                     avs_net_socket_type_t socket_type,
+                                     avs_net_af_t family,
+                                     const char *host,
+                                     const char *port,
+                                     int flags,
+                                     avs_net_resolver_result_t *out_result);
+
+/**
+ * Starts resolving a host name asynchronously.
+ *
+ * If the result is cached, @p callback is called before this function
+ * returns, on the calling thread. Otherwise, the query is queued and
+ * @p callback will be called from one of the threads running
+ * @ref avs_net_resolver_worker_run . Queries for the same name made before
+ * the lookup completes are attached to it and do not cause additional
+ * lookups.
+ *
+ * The arguments have the same meaning as for @ref avs_net_resolver_resolve .
+ *
+ * @param callback Function to call when the lookup completes.
+ * @param arg      Opaque argument to pass to @p callback .
+ *
+ * @returns @ref AVS_OK if the query has been answered from the cache or
+ *          queued, or an error condition for which the operation failed - in
+ *          that case, @p callback is not called.
+ */
+avs_error_t avs_net_resolver_resolve_async(avs_net_resolver_t *resolver,
+                                           avs_net_socket_type_t socket_type,
+                                           avs_net_af_t family,
+                                           const char *host,
+                                           const char *port,
+                                           int flags,
+                                           avs_net_resolver_callback_t *callback,
+                                           void *arg);
+
+/**
+ * Cancels all pending asynchronous queries with the specified @p callback and
+ * @p arg . If any of them is currently being delivered by a worker thread,
+ * waits until the callback returns, so that @p arg may be safely freed
+ * afterwards.
+ *
+ * NOTE: This function MUST NOT be called from within the callback that is
+ * being cancelled, as that would cause a deadlock.
+ *
+ * @returns Number of queries that have been cancelled.
+ */
+size_t avs_net_resolver_cancel(avs_net_resolver_t *resolver,
+                               avs_net_resolver_callback_t *callback,
+                               void *arg);
+
+/**
+ * Performs queued lookups on the specified resolver as one of its worker
+ * threads.
+ *
+ * This function is intended to be called from a number of threads created by
+ * the application. Each call waits until a query is queued, performs the
+ * lookup using the system resolver, calls the callbacks of all queries
+ * attached to it, and repeats, until @ref avs_net_resolver_workers_stop is
+ * called. Lookups for different names may be performed concurrently by
+ * different workers.
+ *
+ * @param resolver Resolver object to access.
+ *
+ * @returns
+ * - 0 when the worker has been stopped using
+ *   @ref avs_net_resolver_workers_stop
+ * - A negative value in case of error when using synchronization primitives.
+ */
+int avs_net_resolver_worker_run(avs_net_resolver_t *resolver);
+
+/**
+ * Makes all calls to @ref avs_net_resolver_worker_run on the specified
+ * resolver return, and waits until they do.
+ *
+ * Lookups currently being performed are allowed to finish and their callbacks
+ * are called. Queries that have not been started yet are completed with
+ * <c>avs_errno(AVS_EINTR)</c>. After this function returns, the worker
+ * threads may be joined, and @ref avs_net_resolver_resolve_async fails with
+ * <c>avs_errno(AVS_EINTR)</c> for queries that are not answered from the
+ * cache.
+ *
+ * NOTE: This function MUST NOT be called from within a resolver callback, as
+ * that would cause a deadlock.
+ *
+ * @returns
+ * - 0 on success
+ * - A negative value in case of error when using synchronization primitives.
+ */
+int avs_net_resolver_workers_stop(avs_net_resolver_t *resolver);
+
+/**
+ * Removes all entries from the cache. Lookups in progress are not affected.
+ */
+void avs_net_resolver_flush(avs_net_resolver_t *resolver);
+
+/**
+ * Retrieves the cache counters, accumulated since the resolver was created.
+ */
+void avs_net_resolver_stats(avs_net_resolver_t *resolver,
+                            avs_net_resolver_stats_t *out_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AVS_COMMONS_NET_RESOLVER_H */
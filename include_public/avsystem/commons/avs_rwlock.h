@@ -0,0 +1,122 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef AVS_COMMONS_RWLOCK_H
+#define AVS_COMMONS_RWLOCK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A reader-writer lock object. It may be held either by any number of readers
+ * at the same time, or by a single writer.
+ *
+ * Whether waiting writers take precedence over new readers depends on the
+ * implementation. The atomic_spinlock and futex implementations prefer writers,
+ * so that a steady stream of readers does not starve them.
+ *
+ * Custom threading backends (<c>WITH_CUSTOM_AVS_THREADING</c>) do not need to
+ * implement it: unless <c>WITH_AVS_COMPAT_THREADING_GENERIC_RWLOCK</c> is
+ * disabled, a writer-preferring implementation built on top of
+ * @ref avs_mutex_t and @ref avs_condvar_t is linked in.
+ */
+typedef struct avs_rwlock avs_rwlock_t;
+
+/**
+ * Creates a reader-writer lock object.
+ *
+ * @param[out] out_rwlock Pointer to the lock handle to initialize.
+ *                        Should point to NULL when the function is called.
+ *
+ * @returns @li 0 on success,
+ *          @li a negative value in case of error.
+ */
+int avs_rwlock_create(avs_rwlock_t **out_rwlock);
+
+/**
+ * Acquires the lock for reading, i.e. in shared mode. Blocks until successful
+ * or an irrecoverable failure happens.
+ *
+ * NOTE: the behavior is undefined if @p rwlock is not a lock object
+ * previously created by @ref avs_rwlock_create .
+ *
+ * WARNING: the lock is NOT recursive. Acquiring it again from a thread that
+ * already holds it, in any mode, may result in a deadlock.
+ *
+ * @param rwlock Lock to acquire.
+ *
+ * @returns @li 0 if the lock was successfully acquired,
+ *          @li a negative value on failure.
+ */
+int avs_rwlock_read_lock(avs_rwlock_t *rwlock);
+
+/**
+ * Releases the lock previously acquired using @ref avs_rwlock_read_lock .
+ *
+ * @param rwlock Lock to release.
+ *
+ * @returns @li 0 if the lock was successfully released,
+ *          @li a negative value on failure.
+ */
+int avs_rwlock_read_unlock(avs_rwlock_t *rwlock);
+
+/**
+ * Acquires the lock for writing, i.e. in exclusive mode. Blocks until
+ * successful or an irrecoverable failure happens.
+ *
+ * NOTE: the behavior is undefined if @p rwlock is not a lock object
+ * previously created by @ref avs_rwlock_create .
+ *
+ * WARNING: the lock is NOT recursive. Acquiring it again from a thread that
+ * already holds it, in any mode, results in undefined behavior.
+ *
+ * @param rwlock Lock to acquire.
+ *
+ * @returns @li 0 if the lock was successfully acquired,
+ *          @li a negative value on failure.
+ */
+int avs_rwlock_write_lock(avs_rwlock_t *rwlock);
+
+/**
+ * Releases the lock previously acquired using @ref avs_rwlock_write_lock .
+ *
+ * @param rwlock Lock to release.
+ *
+ * @returns @li 0 if the lock was successfully released,
+ *          @li a negative value on failure.
+ */
+int avs_rwlock_write_unlock(avs_rwlock_t *rwlock);
+
+/**
+ * Deletes a reader-writer lock object. Does nothing if <c>*rwlock</c> is NULL.
+ *
+ * NOTE: the behavior is undefined if @p rwlock is not a lock object
+ * previously created by @ref avs_rwlock_create , <c>rwlock == NULL</c>
+ * or @p rwlock points to a lock that is currently held.
+ *
+ * @param[inout] rwlock Pointer to the lock handle to delete.
+ *                      After a successful call to this function,
+ *                      <c>*rwlock</c> is set to NULL.
+ */
+void avs_rwlock_cleanup(avs_rwlock_t **rwlock);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* AVS_COMMONS_RWLOCK_H */
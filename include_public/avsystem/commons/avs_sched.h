@@ -119,6 +119,9 @@ void *avs_sched_data(avs_sched_t *sched);
  *
  * NOTE: The returned time may be in the past, if the application did not run
  * @ref avs_sched_run on time.
+ *
+ * NOTE: If timer slack has been set using @ref avs_sched_set_slack, it is
+ * added to the instant at which the earliest job is scheduled.
  */
 avs_time_monotonic_t avs_sched_time_of_next(avs_sched_t *sched);
 
@@ -147,6 +150,213 @@ static inline avs_time_duration_t avs_sched_time_to_next(avs_sched_t *sched) {
                    : result;
 }
 
+/**
+ * Sets the timer slack of the specified scheduler.
+ *
+ * Timer slack is the amount of time by which the scheduler is allowed to delay
+ * execution of jobs, so that jobs scheduled close to each other can be executed
+ * during a single wake-up instead of separate ones. If set to a non-zero value,
+ * @ref avs_sched_time_of_next, @ref avs_sched_time_to_next,
+ * @ref avs_sched_wait_until_next and @ref avs_sched_worker_run will consider
+ * the earliest job due only at its scheduled instant plus the slack. All the
+ * jobs scheduled up to that point will then be executed together.
+ *
+ * The default slack is zero, i.e. no coalescing of wake-ups is performed.
+ *
+ * @param sched Scheduler object to access.
+ *
+ * @param slack Maximum time by which execution of jobs may be delayed. Must be
+ *              a valid, non-negative duration.
+ *
+ * @returns
+ * - 0 on success
+ * - negative value if @p slack is invalid or negative
+ */
+int avs_sched_set_slack(avs_sched_t *sched, avs_time_duration_t slack);
+
+/**
+ * Maximum number of size classes that may be configured for the job pool using
+ * @ref avs_sched_pool_configure .
+ */
+#define AVS_SCHED_POOL_MAX_CLASSES 8
+
+/**
+ * Job pool usage statistics, as returned by @ref avs_sched_pool_stats .
+ */
+typedef struct {
+    /**
+     * Number of jobs that have been scheduled using a cached job record.
+     */
+    uint64_t hits;
+
+    /**
+     * Number of jobs for which a new job record had to be allocated.
+     */
+    uint64_t misses;
+
+    /**
+     * Number of job records currently cached for reuse.
+     */
+    size_t cached;
+} avs_sched_pool_stats_t;
+
+/**
+ * Configures the job pool of the specified scheduler.
+ *
+ * Each job record is a single memory block that contains a copy of the callback
+ * data. If the library is compiled with the <c>WITH_SCHEDULER_JOB_POOL</c>
+ * CMake option, records of jobs that have been executed or cancelled are not
+ * freed, but kept on per-scheduler free lists, grouped in size classes by the
+ * amount of callback data they can hold. Scheduling a new job then reuses a
+ * cached record of the smallest class that fits its data, if one is available.
+ * Jobs with more data than the largest class can hold are always allocated and
+ * freed directly.
+ *
+ * By default, size classes of 16, 64 and 256 bytes are used, with up to 32
+ * records cached in each.
+ *
+ * Calling this function frees all currently cached job records. Jobs that are
+ * currently scheduled are not affected.
+ *
+ * @param sched                Scheduler object to access.
+ *
+ * @param class_data_sizes     Array of callback data sizes for each size
+ *                             class, in strictly increasing order. May be
+ *                             <c>NULL</c> if @p class_count is 0.
+ *
+ * @param class_count          Number of elements in @p class_data_sizes . At
+ *                             most @ref AVS_SCHED_POOL_MAX_CLASSES . Passing 0
+ *                             disables pooling.
+ *
+ * @param max_cached_per_class Maximum number of job records cached in each
+ *                             size class.
+ *
+ * @returns
+ * - 0 on success
+ * - negative value if the configuration is invalid, or if the library has been
+ *   compiled without job pool support
+ */
+int avs_sched_pool_configure(avs_sched_t *sched,
+                             const size_t *class_data_sizes,
+                             size_t class_count,
+                             size_t max_cached_per_class);
+
+/**
+ * Retrieves job pool usage statistics of the specified scheduler. The hit rate
+ * of the pool may be calculated as <c>hits / (hits + misses)</c>.
+ *
+ * @param sched     Scheduler object to access.
+ *
+ * @param out_stats Structure to fill with the statistics.
+ *
+ * @returns
+ * - 0 on success
+ * - negative value if the library has been compiled without job pool support
+ */
+int avs_sched_pool_stats(avs_sched_t *sched, avs_sched_pool_stats_t *out_stats);
+
+/**
+ * Number of buckets in @ref avs_sched_histogram_t .
+ */
+#define AVS_SCHED_HISTOGRAM_BUCKETS 24
+
+/**
+ * Number of slowest job call sites tracked in @ref avs_sched_stats_t .
+ */
+#define AVS_SCHED_STATS_SLOW_JOBS 8
+
+/**
+ * Histogram of durations, with logarithmic buckets.
+ */
+typedef struct {
+    /**
+     * Number of samples in each bucket. <c>buckets[0]</c> counts samples
+     * shorter than 1 microsecond, <c>buckets[i]</c> counts samples in range
+     * [2^(i-1), 2^i) microseconds, and the last bucket also counts all samples
+     * longer than that.
+     */
+    uint64_t buckets[AVS_SCHED_HISTOGRAM_BUCKETS];
+
+    /** Total number of samples. */
+    uint64_t count;
+
+    /** Sum of all samples. */
+    avs_time_duration_t total;
+
+    /** Longest sample. */
+    avs_time_duration_t max;
+} avs_sched_histogram_t;
+
+/**
+ * Call site of a slow job, as reported in @ref avs_sched_stats_t .
+ */
+typedef struct {
+    /**
+     * Source file and line from which the job has been scheduled, and the
+     * stringified callback name. These are only available if
+     * <c>AVS_LOG_WITH_TRACE</c> was defined when compiling the code that
+     * scheduled the job; <c>NULL</c> and 0 otherwise.
+     */
+    const char *file;
+    unsigned line;
+    const char *name;
+
+    /** Longest execution time of a job scheduled from this call site. */
+    avs_time_duration_t max_exec_time;
+} avs_sched_slow_job_t;
+
+/**
+ * Job execution statistics, as returned by @ref avs_sched_stats .
+ */
+typedef struct {
+    /**
+     * Histogram of dispatch lateness, i.e. time between the instant at which
+     * each job was scheduled and the actual start of its execution.
+     */
+    avs_sched_histogram_t lateness;
+
+    /** Histogram of time spent executing job callbacks. */
+    avs_sched_histogram_t exec_time;
+
+    /**
+     * Call sites of the jobs that took longest to execute, sorted by
+     * @ref avs_sched_slow_job_t::max_exec_time in descending order.
+     */
+    avs_sched_slow_job_t slow_jobs[AVS_SCHED_STATS_SLOW_JOBS];
+
+    /** Number of valid entries in @ref avs_sched_stats_t::slow_jobs . */
+    size_t slow_jobs_count;
+} avs_sched_stats_t;
+
+/**
+ * Retrieves job execution statistics of the specified scheduler, gathered
+ * since its creation or the last call to @ref avs_sched_stats_reset .
+ *
+ * Statistics are only gathered if the library is compiled with the
+ * <c>WITH_SCHEDULER_STATS</c> CMake option. Doing so adds two clock reads to
+ * the execution of each job.
+ *
+ * @param sched     Scheduler object to access.
+ *
+ * @param out_stats Structure to fill with the statistics.
+ *
+ * @returns
+ * - 0 on success
+ * - negative value if the library has been compiled without statistics support
+ */
+int avs_sched_stats(avs_sched_t *sched, avs_sched_stats_t *out_stats);
+
+/**
+ * Resets job execution statistics of the specified scheduler.
+ *
+ * @param sched Scheduler object to access.
+ *
+ * @returns
+ * - 0 on success
+ * - negative value if the library has been compiled without statistics support
+ */
+int avs_sched_stats_reset(avs_sched_t *sched);
+
 /**
  * Waits until it is time to run a job (call @ref avs_sched_run) on the
  * specified scheduler.
@@ -216,6 +426,58 @@ static inline int avs_sched_wait_for_next(avs_sched_t *sched,
  */
 void avs_sched_run(avs_sched_t *sched);
 
+/**
+ * Executes jobs on the specified scheduler as one of its worker threads.
+ *
+ * This function is intended to be called from a number of threads created by
+ * the application, forming a worker pool for the scheduler. Each call waits
+ * until a job is due for execution, executes it, and repeats, until
+ * @ref avs_sched_workers_stop is called. Jobs may be scheduled, rescheduled
+ * and cancelled concurrently from any thread, as usual.
+ *
+ * Jobs executed by different workers may run concurrently. Use
+ * @ref AVS_SCHED_AT_WITH_AFFINITY and related macros to prevent that for jobs
+ * that access the same data. Jobs with different affinity keys are not
+ * guaranteed to be started in the order of their scheduled instants.
+ *
+ * Calling @ref avs_sched_run while worker threads are active is allowed; it
+ * respects the affinity keys as well.
+ *
+ * NOTE: The function currently only works if the scheduler module has been
+ * compiled with thread safety enabled. Otherwise it will always return an error
+ * immediately.
+ *
+ * @param sched Scheduler object to access.
+ *
+ * @returns
+ * - 0 when the worker has been stopped using @ref avs_sched_workers_stop
+ * - A negative value in case of error when using synchronization primitives.
+ */
+int avs_sched_worker_run(avs_sched_t *sched);
+
+/**
+ * Makes all calls to @ref avs_sched_worker_run on the specified scheduler
+ * return, and waits until they do.
+ *
+ * Jobs currently being executed by the workers are allowed to finish. Jobs that
+ * are not executed yet remain scheduled, and may still be executed using
+ * @ref avs_sched_run . After this function returns, the worker threads may be
+ * joined. Any subsequent calls to @ref avs_sched_worker_run on the same
+ * scheduler will return immediately.
+ *
+ * NOTE: This function MUST NOT be called from within a job executed by a
+ * worker, as that would cause a deadlock. All workers MUST be stopped before
+ * calling @ref avs_sched_cleanup .
+ *
+ * @param sched Scheduler object to access.
+ *
+ * @returns
+ * - 0 on success
+ * - A negative value in case of error when using synchronization primitives,
+ *   or if the scheduler module has been compiled with thread safety disabled.
+ */
+int avs_sched_workers_stop(avs_sched_t *sched);
+
 /**
  * @name Internal functions
  *
@@ -232,6 +494,17 @@ int avs_sched_at_impl__(avs_sched_t *sched,
                         const void *clb_data,
                         size_t clb_data_size);
 
+int avs_sched_at_with_affinity_impl__(avs_sched_t *sched,
+                                      avs_sched_handle_t *out_handle,
+                                      avs_time_monotonic_t instant,
+                                      const void *affinity_key,
+                                      const char *log_file,
+                                      unsigned log_line,
+                                      const char *log_name,
+                                      avs_sched_clb_t *clb,
+                                      const void *clb_data,
+                                      size_t clb_data_size);
+
 int avs_resched_at_impl__(avs_sched_handle_t *handle_ptr,
                           avs_time_monotonic_t instant);
 
@@ -345,6 +618,68 @@ int avs_resched_at_impl__(avs_sched_handle_t *handle_ptr,
                  ClbData,                                          \
                  ClbDataSize)
 
+/**
+ * A variant of @ref AVS_SCHED_AT that additionally assigns an affinity key to
+ * the job.
+ *
+ * Jobs that share the same non-<c>NULL</c> affinity key are never executed
+ * concurrently, even if the scheduler is served by multiple worker threads
+ * (see @ref avs_sched_worker_run), and are executed in the order of their
+ * scheduled instants. A typical affinity key is a pointer to the session or
+ * connection object that the job operates on. Passing <c>NULL</c> is
+ * equivalent to using @ref AVS_SCHED_AT .
+ *
+ * The affinity key is retained if the job is rescheduled using
+ * @ref AVS_RESCHED_AT or related macros. It has no effect if the scheduler
+ * module has been compiled with thread safety disabled.
+ *
+ * @param[in]  AffinityKey Opaque pointer used as the affinity key
+ *                         (<c>const void *</c>). It is only compared with other
+ *                         keys and never dereferenced.
+ *
+ * See @ref AVS_SCHED_AT for documentation of the other arguments.
+ */
+#define AVS_SCHED_AT_WITH_AFFINITY(Sched, OutHandle, Instant, AffinityKey, \
+                                   Clb, ClbData, ClbDataSize)              \
+    avs_sched_at_with_affinity_impl__(                                     \
+            (Sched),                                                       \
+            (OutHandle),                                                   \
+            (Instant),                                                     \
+            (AffinityKey),                                                 \
+            AVS_SCHED_LOG_ARGS__(Clb, (ClbData, ClbDataSize)),             \
+            (Clb),                                                         \
+            (ClbData),                                                     \
+            (ClbDataSize))
+
+/**
+ * A variant of @ref AVS_SCHED_AT_WITH_AFFINITY that uses a delay relative to
+ * "now", instead of an absolute instant at which to schedule the job.
+ */
+#define AVS_SCHED_DELAYED_WITH_AFFINITY(Sched, OutHandle, Delay, AffinityKey, \
+                                        Clb, ClbData, ClbDataSize)            \
+    AVS_SCHED_AT_WITH_AFFINITY(                                               \
+            Sched,                                                            \
+            OutHandle,                                                        \
+            avs_time_monotonic_add(avs_time_monotonic_now(), Delay),          \
+            AffinityKey,                                                      \
+            Clb,                                                              \
+            ClbData,                                                          \
+            ClbDataSize)
+
+/**
+ * A variant of @ref AVS_SCHED_AT_WITH_AFFINITY that schedules the job to
+ * execute "now" (at earliest possible time).
+ */
+#define AVS_SCHED_NOW_WITH_AFFINITY(Sched, OutHandle, AffinityKey, Clb, \
+                                    ClbData, ClbDataSize)               \
+    AVS_SCHED_AT_WITH_AFFINITY(Sched,                                   \
+                               OutHandle,                               \
+                               avs_time_monotonic_now(),                \
+                               AffinityKey,                             \
+                               Clb,                                     \
+                               ClbData,                                 \
+                               ClbDataSize)
+
 /**
  * Reschedules a job to the specific point in time in the system monotonic
  * clock's domain.
@@ -379,6 +714,64 @@ int avs_resched_at_impl__(avs_sched_handle_t *handle_ptr,
  */
 #define AVS_RESCHED_NOW(Handle) AVS_RESCHED_AT(Handle, avs_time_monotonic_now())
 
+/**
+ * Description of a single job to schedule using @ref avs_sched_at_batch .
+ *
+ * The fields correspond to arguments of the @ref AVS_SCHED_AT_WITH_AFFINITY
+ * macro - please refer to its documentation for details.
+ */
+typedef struct {
+    /** Optional pointer to a handle variable; may be <c>NULL</c>. */
+    avs_sched_handle_t *out_handle;
+
+    /** Point in time at which to schedule the job. */
+    avs_time_monotonic_t instant;
+
+    /** Optional affinity key of the job; may be <c>NULL</c>. */
+    const void *affinity_key;
+
+    /** Function to call when executing the job. */
+    avs_sched_clb_t *clb;
+
+    /** Pointer to data that will be copied and passed to @ref clb . */
+    const void *clb_data;
+
+    /** Number of bytes at @ref clb_data . */
+    size_t clb_data_size;
+} avs_sched_batch_entry_t;
+
+/**
+ * Schedules multiple jobs at once.
+ *
+ * This is equivalent to calling @ref AVS_SCHED_AT_WITH_AFFINITY for each of
+ * the @p entries, in order, but the scheduler is locked only once for the whole
+ * batch, which considerably reduces overhead when scheduling large numbers of
+ * jobs, e.g. when restoring state at application startup.
+ *
+ * The batch is scheduled atomically: either all the jobs are scheduled, or, in
+ * case of an error, none of them are, and no handle variables are modified.
+ *
+ * NOTE: No file and line information is recorded for jobs scheduled this way,
+ * even if <c>AVS_LOG_WITH_TRACE</c> is defined.
+ *
+ * @param sched   Scheduler object to access.
+ *
+ * @param entries Array of descriptions of jobs to schedule.
+ *
+ * @param count   Number of elements in the @p entries array.
+ *
+ * @returns
+ * - 0 on success
+ * - negative value on one of the following failure conditions:
+ *   - <c>clb</c> is <c>NULL</c> in any of the entries
+ *   - <c>instant</c> is an invalid time value in any of the entries
+ *   - not enough memory available
+ *   - the scheduler is being shut down
+ */
+int avs_sched_at_batch(avs_sched_t *sched,
+                       const avs_sched_batch_entry_t *entries,
+                       size_t count);
+
 /**
  * Returns a point in time at which execution of a specified job is scheduled.
  *
@@ -409,6 +802,24 @@ avs_time_monotonic_t avs_sched_time(avs_sched_handle_t *handle_ptr);
  */
 void avs_sched_del(avs_sched_handle_t *handle_ptr);
 
+/**
+ * Unschedules multiple jobs at once.
+ *
+ * This is equivalent to calling @ref avs_sched_del for each of the handle
+ * pointers, but consecutive jobs belonging to the same scheduler are cancelled
+ * with the scheduler locked only once.
+ *
+ * @param handle_ptrs Array of pointers to job handle variables to unschedule.
+ *                    <c>NULL</c> elements, as well as pointers to <c>NULL</c>
+ *                    handles, are ignored.
+ *
+ * @param count       Number of elements in the @p handle_ptrs array.
+ *
+ * NOTE: On return from this function, all the handle variables will be set to
+ * <c>NULL</c>.
+ */
+void avs_sched_del_batch(avs_sched_handle_t *const *handle_ptrs, size_t count);
+
 /**
  * Detaches a handle variable from a scheduled job.
  *
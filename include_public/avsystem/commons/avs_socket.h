@@ -36,8 +36,15 @@
 #    include <avsystem/commons/avs_crypto_pki.h>
 #    include <avsystem/commons/avs_crypto_psk.h>
 #    include <avsystem/commons/avs_prng.h>
+#    ifdef AVS_COMMONS_WITH_AVS_PERSISTENCE
+#        include <avsystem/commons/avs_persistence.h>
+#    endif // AVS_COMMONS_WITH_AVS_PERSISTENCE
 #endif // AVS_COMMONS_WITH_AVS_CRYPTO
 
+#ifdef AVS_COMMONS_STREAM_WITH_FILE
+#    include <stdio.h>
+#endif // AVS_COMMONS_STREAM_WITH_FILE
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -48,6 +55,10 @@ extern "C" {
 /* 30 sec timeout */
 extern const avs_time_duration_t AVS_NET_SOCKET_DEFAULT_RECV_TIMEOUT;
 
+/* 250 ms, as recommended by RFC 8305 */
+extern const avs_time_duration_t
+        AVS_NET_SOCKET_RECOMMENDED_CONNECTION_ATTEMPT_DELAY;
+
 typedef struct {
     uint8_t size;
     union {
@@ -78,6 +89,13 @@ typedef enum {
 struct avs_net_socket_struct;
 typedef struct avs_net_socket_struct avs_net_socket_t;
 
+/**
+ * Pool of worker threads performing steps of asynchronous (D)TLS handshakes.
+ * See <c>avs_net_handshake_pool.h</c> and
+ * @ref avs_net_socket_decorate_async .
+ */
+typedef struct avs_net_handshake_pool_struct avs_net_handshake_pool_t;
+
 /**
  * This is a type of data used for binding socket to a specific network
  * interface. For POSIX interfaces it is array of IF_NAMESIZE characters.
@@ -199,6 +217,62 @@ typedef struct {
      * <c>AVS_NET_UNSPEC</c>.
      */
     avs_net_af_t preferred_family;
+
+    /**
+     * Enables optimistic I/O. By default, every send, receive or accept
+     * operation first waits for the socket to become ready using
+     * <c>poll()</c> (or <c>select()</c>), and only then performs the actual
+     * operation. If this flag is set, the operation is attempted immediately,
+     * and waiting is only done if it would block.
+     *
+     * This saves one system call per operation whenever data is already
+     * queued in the kernel, which is typical for busy sockets and for sockets
+     * used along with an event loop such as @ref avs_net_poller_t. For sockets
+     * that are usually idle, it may instead add an extra failing call.
+     */
+    bool optimistic_io;
+
+    /**
+     * Delay between starting consecutive connection attempts when a TCP
+     * socket is being connected to a host name that resolves to multiple
+     * addresses ("Happy Eyeballs", RFC 8305). If an attempt does not succeed
+     * within that time, the next address is tried without abandoning the
+     * previous attempt, and the first connection to be established wins. A
+     * failed attempt causes the next one to be started immediately.
+     *
+     * If <c>address_family</c> and <c>preferred_family</c> are both
+     * <c>AVS_NET_UNSPEC</c>, IPv6 and IPv4 addresses are tried alternately.
+     * Otherwise, the semantics of <c>preferred_family</c> described above are
+     * retained - other families are only tried after all attempts using the
+     * preferred one have failed.
+     *
+     * Staggered connection attempts are only used if this is set to a positive
+     * duration, such as @ref AVS_NET_SOCKET_RECOMMENDED_CONNECTION_ATTEMPT_DELAY.
+     * By default (zero), and if set to a negative or invalid duration, the
+     * addresses are tried one by one, each attempt being given the full
+     * connection timeout.
+     */
+    avs_time_duration_t connection_attempt_delay;
+
+    /**
+     * Used to set <c>SO_REUSEPORT</c> on the underlying system socket when it
+     * is bound.
+     *
+     * This allows multiple sockets, each with this flag set, to be bound to the
+     * same local address and port - the system then distributes incoming
+     * connections (for TCP) or datagrams from new peers (for UDP) between them.
+     * Such a group of sockets forms a "sharded" listener, in which each socket
+     * may be owned by a different thread, so that accepting new connections
+     * does not need to be serialized through a single socket. See
+     * @ref avs_net_socket_bind_shards for a convenient way of binding them.
+     *
+     * When this flag is set, it may be used instead of <c>reuse_addr</c> to
+     * allow calling @ref avs_net_socket_accept on UDP sockets.
+     *
+     * If the system does not support <c>SO_REUSEPORT</c>, binding a socket
+     * with this flag set fails with <c>avs_errno(AVS_ENOTSUP)</c>.
+     */
+    bool reuse_port;
 } avs_net_socket_configuration_t;
 
 #ifdef AVS_COMMONS_WITH_AVS_CRYPTO
@@ -383,6 +457,80 @@ static inline uint8_t avs_net_ssl_alert_description(avs_error_t error) {
 }
 
 #ifdef AVS_COMMONS_WITH_AVS_CRYPTO
+/**
+ * (D)TLS configuration - security credentials, protocol version and
+ * ciphersuites - prepared once and shared between any number of secure sockets.
+ * See @ref avs_net_ssl_context_create.
+ */
+typedef struct avs_net_ssl_context_struct avs_net_ssl_context_t;
+
+/**
+ * Configuration of a library-managed cache of client-side (D)TLS sessions,
+ * kept in a shared (D)TLS context. See
+ * @ref avs_net_ssl_configuration_t#session_cache.
+ */
+typedef struct {
+    /**
+     * Maximum number of sessions to keep. Least recently used sessions are
+     * discarded first.
+     */
+    size_t max_entries;
+
+    /**
+     * Size of the buffer each socket uses to exchange session data with the
+     * cache, as in <c>session_resumption_buffer_size</c>. Sessions that do not
+     * fit are not cached. Only the used part of the buffer is kept in memory.
+     */
+    size_t max_session_size;
+
+    /**
+     * Time after which a cached session is no longer offered for resumption.
+     */
+    avs_time_duration_t ttl;
+} avs_net_ssl_session_cache_config_t;
+
+/**
+ * Configuration of server-side (D)TLS session resumption, kept in a shared
+ * (D)TLS context. See @ref avs_net_ssl_configuration_t#server_sessions.
+ */
+typedef struct {
+    /**
+     * Maximum number of sessions kept in the server-side session cache, for
+     * resumption by session ID. Zero disables the cache.
+     */
+    size_t max_sessions;
+
+    /**
+     * Enables issuing stateless session tickets (RFC 5077). The keys that
+     * protect them are generated at random and rotated every
+     * <c>lifetime</c>; tickets issued with the previous key are still
+     * accepted and then replaced with fresh ones.
+     */
+    bool use_tickets;
+
+    /**
+     * Time after which a session may no longer be resumed. Must be at least
+     * one second.
+     */
+    avs_time_duration_t lifetime;
+} avs_net_ssl_server_session_config_t;
+
+/**
+ * Counters of handshakes performed on server-side sockets created from
+ * a shared (D)TLS context. See
+ * @ref avs_net_ssl_context_get_server_session_stats.
+ */
+typedef struct {
+    /** Number of successful server-side handshakes. */
+    uint64_t handshakes;
+
+    /**
+     * Number of those handshakes that resumed a previous session, either from
+     * the server-side session cache or from a session ticket.
+     */
+    uint64_t resumed;
+} avs_net_ssl_server_session_stats_t;
+
 typedef struct {
     /** Array of ciphersuite IDs, or NULL to enable all ciphers */
     uint32_t *ids;
@@ -490,9 +638,55 @@ typedef struct {
 
     /**
      * PRNG context to use. It must outlive the created socket. MUST NOT be
-     * @c NULL .
+     * @c NULL , unless <c>context</c> is set.
      */
     avs_crypto_prng_ctx_t *prng_ctx;
+
+    /**
+     * Shared (D)TLS context to create the socket from, or NULL to prepare
+     * a private one from this configuration.
+     *
+     * If set, the <c>version</c>, <c>security</c>, <c>ciphersuites</c>,
+     * <c>additional_configuration_clb</c> and <c>prng_ctx</c> fields are
+     * ignored and the values the context has been created with are used
+     * instead. The socket holds its own reference to the context, so
+     * @ref avs_net_ssl_context_cleanup may be called while the socket is still
+     * in use. Ignored by @ref avs_net_ssl_context_create and
+     * @ref avs_net_dtls_context_create.
+     */
+    avs_net_ssl_context_t *context;
+
+    /**
+     * If non-NULL, @ref avs_net_ssl_context_create and
+     * @ref avs_net_dtls_context_create create a session cache in the new
+     * context. Client sockets created from that context with
+     * <c>session_resumption_buffer_size</c> equal to zero then automatically
+     * offer the session last negotiated for the same host, port and SNI by any
+     * socket using the context, and store newly negotiated sessions in it.
+     *
+     * The cache is thread-safe. It is ignored when creating sockets without a
+     * shared context. Sessions established with @ref avs_net_socket_decorate
+     * are not cached.
+     *
+     * Requires <c>AVS_COMMONS_NET_WITH_TLS_SESSION_CACHE</c> and a TLS backend
+     * that supports session resumption (OpenSSL or Mbed TLS).
+     */
+    const avs_net_ssl_session_cache_config_t *session_cache;
+
+    /**
+     * If non-NULL, @ref avs_net_ssl_context_create and
+     * @ref avs_net_dtls_context_create enable resumption of sessions by
+     * clients of server-side sockets, i.e. ones handshaking through
+     * @ref avs_net_socket_decorate on an accepted socket, created from the new
+     * context.
+     *
+     * The session cache and ticket keys are thread-safe. This field is ignored
+     * when creating sockets without a shared context.
+     *
+     * Requires a TLS backend that supports server-side session resumption
+     * (OpenSSL or Mbed TLS).
+     */
+    const avs_net_ssl_server_session_config_t *server_sessions;
 } avs_net_ssl_configuration_t;
 #endif // AVS_COMMONS_WITH_AVS_CRYPTO
 
@@ -594,6 +788,31 @@ typedef enum {
      * Used to set the timeouts for the DTLS handshake.
      */
     AVS_NET_SOCKET_OPT_DTLS_HANDSHAKE_TIMEOUTS,
+
+    /**
+     * Used to enable or disable UDP Generic Receive Offload on a bound or
+     * connected UDP socket. The value is passed in the <c>flag</c> field of the
+     * @ref avs_net_socket_opt_value_t union.
+     *
+     * When enabled, the operating system may coalesce multiple consecutive
+     * datagrams of equal size from the same sender into a single buffer, which
+     * greatly reduces per-datagram overhead for bulk transfers. Such buffers
+     * shall be received using @ref avs_net_socket_receive_segmented , which
+     * reports the original datagram size. Plain @ref avs_net_socket_receive
+     * would return the coalesced data as a single datagram.
+     *
+     * NOTE: Attempting to set this option on platforms or socket types that do
+     * not support it will yield an error.
+     */
+    AVS_NET_SOCKET_OPT_UDP_GRO,
+
+    /**
+     * Used to check whether the socket is datagram-oriented, i.e. whether it
+     * preserves message boundaries (as UDP and DTLS sockets do) instead of
+     * providing a byte stream. The value is read-only and passed in the
+     * <c>flag</c> field of the @ref avs_net_socket_opt_value_t union.
+     */
+    AVS_NET_SOCKET_OPT_DATAGRAM,
 } avs_net_socket_opt_key_t;
 
 typedef enum {
@@ -743,6 +962,108 @@ avs_net_ssl_socket_create(avs_net_socket_t **socket,
 #endif // AVS_COMMONS_WITH_AVS_CRYPTO
 /**@}*/
 
+#ifdef AVS_COMMONS_WITH_AVS_CRYPTO
+/**
+ * @name Shared (D)TLS contexts
+ * Loads the trust store, client certificate chain and private key or PSK,
+ * selects the protocol version and ciphersuites, and prepares the TLS
+ * backend's configuration object once, so that they can be reused by any
+ * number of sockets created with @ref avs_net_ssl_configuration_t#context
+ * pointing to the new context.
+ *
+ * Contexts created with @ref avs_net_ssl_context_create can only be used with
+ * @ref avs_net_ssl_socket_create, and ones created with
+ * @ref avs_net_dtls_context_create - with @ref avs_net_dtls_socket_create.
+ *
+ * The context is reference-counted; it is safe to create and clean up sockets
+ * using the same context from multiple threads. Each socket still performs its
+ * own handshake; SNI, session resumption buffer, DTLS handshake timeouts and
+ * backend configuration are taken from the configuration each socket is
+ * created with.
+ *
+ * @param[out] out_context Variable to store the newly created context in.
+ *                         <c>*out_context</c> MUST be NULL.
+ *
+ * @param      config      (D)TLS configuration to prepare. Only the
+ *                         <c>version</c>, <c>security</c>,
+ *                         <c>ciphersuites</c>,
+ *                         <c>additional_configuration_clb</c>,
+ *                         <c>prng_ctx</c>, <c>session_cache</c> and
+ *                         <c>server_sessions</c> fields are used. All data is
+ *                         copied, except for <c>prng_ctx</c>, which MUST
+ *                         outlive the context and all sockets created from it.
+ *
+ * @returns @ref AVS_OK for success, or an error condition for which the
+ *          operation failed. <c>avs_errno(AVS_ENOTSUP)</c> is returned if
+ *          (D)TLS support is disabled, or if the configuration requests a
+ *          feature that cannot be shared between sockets with the TLS backend
+ *          in use (e.g. DANE with Mbed TLS), or a session cache or
+ *          server-side session resumption without support for it.
+ *
+ * @{
+ */
+avs_error_t
+avs_net_ssl_context_create(avs_net_ssl_context_t **out_context,
+                           const avs_net_ssl_configuration_t *config);
+
+avs_error_t
+avs_net_dtls_context_create(avs_net_ssl_context_t **out_context,
+                            const avs_net_ssl_configuration_t *config);
+/**@}*/
+
+/**
+ * Releases the caller's reference to a (D)TLS context and sets
+ * <c>*context</c> to NULL. The context is freed when the last socket created
+ * from it is cleaned up.
+ *
+ * @param[inout] context Context to release. NULL is a no-op.
+ */
+void avs_net_ssl_context_cleanup(avs_net_ssl_context_t **context);
+
+/**
+ * Retrieves the counters of handshakes performed so far on server-side sockets
+ * created from @p context . They are gathered regardless of
+ * @ref avs_net_ssl_configuration_t#server_sessions , so that the hit rate of
+ * session resumption may also be compared against a baseline without it.
+ *
+ * @param context   Context to query.
+ *
+ * @param out_stats Structure to fill.
+ *
+ * @returns @ref AVS_OK for success, or <c>avs_errno(AVS_ENOTSUP)</c> if the
+ *          TLS backend in use does not support server-side session
+ *          resumption.
+ */
+avs_error_t avs_net_ssl_context_get_server_session_stats(
+        avs_net_ssl_context_t *context,
+        avs_net_ssl_server_session_stats_t *out_stats);
+
+#    ifdef AVS_COMMONS_WITH_AVS_PERSISTENCE
+/**
+ * Stores or restores (depending on the direction of @p ctx ) the sessions
+ * kept in the session cache of @p context , along with their expiration times,
+ * which are stored as real time. On restore, the current contents of the cache
+ * are replaced, and sessions that have expired in the meantime are dropped.
+ *
+ * Session data format is specific to the TLS backend; sessions shall only be
+ * restored into a context created with the same configuration.
+ *
+ * @param ctx     Persistence context to operate on.
+ *
+ * @param context Context created with
+ *                @ref avs_net_ssl_configuration_t#session_cache set.
+ *
+ * @returns @ref AVS_OK for success, <c>avs_errno(AVS_EINVAL)</c> if
+ *          @p context has no session cache, <c>avs_errno(AVS_ENOTSUP)</c> if
+ *          session cache support is disabled, or an error condition for which
+ *          the persistence operation failed.
+ */
+avs_error_t
+avs_net_ssl_context_session_cache_persistence(avs_persistence_context_t *ctx,
+                                              avs_net_ssl_context_t *context);
+#    endif // AVS_COMMONS_WITH_AVS_PERSISTENCE
+#endif // AVS_COMMONS_WITH_AVS_CRYPTO
+
 /**
  * Shuts down @p socket , cleans up any allocated resources and sets
  * <c>*socket</c> to NULL. When called on a socket decorator, also cleans up all
@@ -798,6 +1119,65 @@ avs_error_t avs_net_socket_connect(avs_net_socket_t *socket,
 avs_error_t avs_net_socket_decorate(avs_net_socket_t *socket,
                                     avs_net_socket_t *backend_socket);
 
+/**
+ * Variant of @ref avs_net_socket_decorate that performs the handshake
+ * asynchronously, so that a single thread may drive any number of concurrent
+ * handshakes, e.g. using @ref avs_net_poller_t .
+ *
+ * The handshake is performed in steps. Each step processes whatever data has
+ * already been received and sends the response, but never waits for more data
+ * to arrive. Sending a handshake flight may still block briefly if the socket
+ * send buffer is full.
+ *
+ * If @p pool is not NULL, the steps are performed by worker threads of that
+ * pool, so that the cryptographic operations do not block the calling thread.
+ * Otherwise, they are performed on the calling thread.
+ *
+ * While the handshake is in progress, no operations other than
+ * @ref avs_net_socket_handshake_continue , @ref avs_net_socket_get_system and
+ * @ref avs_net_socket_cleanup may be performed on @p socket .
+ *
+ * The default SSL/TLS socket implementation supports this for stream sockets
+ * only, and only with the OpenSSL (1.0.2 or newer) and Mbed TLS backends.
+ *
+ * @param socket         Wrapper socket. It must be a newly-created socket
+ *                       object (in @ref AVS_NET_SOCKET_STATE_CLOSED state).
+ * @param backend_socket Lower-layer socket to wrap. It MUST already be
+ *                       connected or accepted.
+ * @param pool           Worker pool to perform the handshake steps, or NULL.
+ *
+ * @returns
+ * - @ref AVS_OK if the handshake has been completed already
+ * - <c>avs_errno(AVS_EAGAIN)</c> if more data from the peer is necessary -
+ *   @ref avs_net_socket_handshake_continue shall be called when @p socket
+ *   becomes readable
+ * - <c>avs_errno(AVS_EINPROGRESS)</c> if a step has been passed to @p pool -
+ *   @ref avs_net_socket_handshake_continue shall be called when @p socket is
+ *   reported by @ref avs_net_handshake_pool_get_completed
+ * - any other error condition if the handshake could not be started or has
+ *   failed; <c>avs_errno(AVS_ENOTSUP)</c> if asynchronous handshakes are not
+ *   supported by @p socket
+ *
+ * In the first two cases, @p socket takes over @p backend_socket , just like
+ * in case of success. Otherwise, @p backend_socket is left intact.
+ */
+avs_error_t avs_net_socket_decorate_async(avs_net_socket_t *socket,
+                                          avs_net_socket_t *backend_socket,
+                                          avs_net_handshake_pool_t *pool);
+
+/**
+ * Continues an asynchronous handshake started by
+ * @ref avs_net_socket_decorate_async .
+ *
+ * @param socket Socket to operate on.
+ *
+ * @returns The same values as @ref avs_net_socket_decorate_async . If the
+ *          handshake fails, the backend socket is closed, but still owned by
+ *          @p socket . If the handshake has already been completed,
+ *          @ref AVS_OK is returned.
+ */
+avs_error_t avs_net_socket_handshake_continue(avs_net_socket_t *socket);
+
 #ifdef AVS_COMMONS_WITH_AVS_CRYPTO
 /**
  * @name Sockets decorators
@@ -943,6 +1323,313 @@ avs_error_t avs_net_socket_receive_from(avs_net_socket_t *socket,
                                         char *port,
                                         size_t port_size);
 
+/**
+ * Single datagram to be sent using @ref avs_net_socket_send_batch .
+ */
+typedef struct {
+    /** Datagram payload. */
+    const void *data;
+
+    /** Number of bytes in @ref avs_net_socket_outgoing_datagram_t::data . */
+    size_t data_length;
+
+    /**
+     * Remote host to send the datagram to, as in
+     * @ref avs_net_socket_send_to . If NULL, the datagram is sent to the
+     * connected remote endpoint, as in @ref avs_net_socket_send .
+     */
+    const char *host;
+
+    /** Remote port to send the datagram to. Ignored if @c host is NULL. */
+    const char *port;
+} avs_net_socket_outgoing_datagram_t;
+
+/**
+ * Buffer for a single datagram received using
+ * @ref avs_net_socket_receive_batch .
+ */
+typedef struct {
+    /** Buffer to write the datagram payload to. */
+    void *buffer;
+
+    /**
+     * Number of bytes available in
+     * @ref avs_net_socket_received_datagram_t::buffer .
+     */
+    size_t buffer_length;
+
+    /**
+     * Buffer to store the sender host in, as in
+     * @ref avs_net_socket_receive_from . May be NULL if not needed - this
+     * saves the cost of converting the address to a string.
+     */
+    char *host;
+
+    /** Number of bytes available in @c host . */
+    size_t host_size;
+
+    /** Buffer to store the sender port in. May be NULL if not needed. */
+    char *port;
+
+    /** Number of bytes available in @c port . */
+    size_t port_size;
+
+    /** Output: number of bytes written into @c buffer . */
+    size_t bytes_received;
+
+    /**
+     * Output: set to true if the datagram was longer than @c buffer_length and
+     * has been truncated. This is reported as <c>avs_errno(AVS_EMSGSIZE)</c> by
+     * @ref avs_net_socket_receive .
+     */
+    bool truncated;
+} avs_net_socket_received_datagram_t;
+
+/**
+ * Sends multiple datagrams using @p socket , in order.
+ *
+ * On platforms that support it, all datagrams are passed to the operating
+ * system using a single <c>sendmmsg()</c> call, which is much cheaper than
+ * calling @ref avs_net_socket_send_to for each datagram separately. Otherwise,
+ * or for socket types that do not implement batch operations natively, the
+ * datagrams are sent one by one.
+ *
+ * For stream sockets, the payloads are sent one after another, as if
+ * @ref avs_net_socket_send was called for each of them.
+ *
+ * @param[in]  socket      Socket object to send data to.
+ * @param[in]  datagrams   Array of datagrams to send.
+ * @param[in]  count       Number of elements in @p datagrams .
+ * @param[out] out_sent    If not NULL, set to the number of datagrams that
+ *                         have been sent successfully. If the function fails,
+ *                         the error pertains to the datagram at that index.
+ *
+ * @returns @ref AVS_OK if all datagrams have been sent, or an error condition
+ *          for which the operation failed.
+ */
+avs_error_t
+avs_net_socket_send_batch(avs_net_socket_t *socket,
+                          const avs_net_socket_outgoing_datagram_t *datagrams,
+                          size_t count,
+                          size_t *out_sent);
+
+/**
+ * Receives multiple datagrams from @p socket .
+ *
+ * The function waits for the first datagram for at most the time configured
+ * as @ref AVS_NET_SOCKET_OPT_RECV_TIMEOUT . Then, it receives as many datagrams
+ * as are available without waiting, up to @p count .
+ *
+ * On platforms that support it, this is done using <c>recvmmsg()</c>, so that
+ * a burst of datagrams costs one system call instead of one per datagram.
+ * Otherwise, or for socket types that do not implement batch operations
+ * natively, the datagrams are received one by one.
+ *
+ * For stream sockets, consecutive chunks of the stream are received into
+ * subsequent buffers.
+ *
+ * @param[in]    socket       Socket object to read data from.
+ * @param[inout] datagrams    Array of buffers to receive datagrams into. See
+ *                            @ref avs_net_socket_received_datagram_t for
+ *                            details.
+ * @param[in]    count        Number of elements in @p datagrams .
+ * @param[out]   out_received Set to the number of datagrams that have been
+ *                            received. On success, it is at least 1.
+ *
+ * @returns @ref AVS_OK if at least one datagram has been received, or an
+ *          error condition for which the operation failed. Errors that occur
+ *          after the first datagram has been received are not reported - they
+ *          will be reported by the next receive operation instead.
+ */
+avs_error_t
+avs_net_socket_receive_batch(avs_net_socket_t *socket,
+                             avs_net_socket_received_datagram_t *datagrams,
+                             size_t count,
+                             size_t *out_received);
+
+/**
+ * Sends @p buffer as a series of datagrams of @p segment_size bytes each (the
+ * last one may be shorter) to the remote endpoint @p socket is connected to.
+ *
+ * On platforms that support UDP Generic Segmentation Offload, the whole buffer
+ * is passed to the operating system in as few calls as possible and split into
+ * datagrams by the network stack or the network card. Otherwise, or for socket
+ * types that do not support it, this is equivalent to sending each segment
+ * using @ref avs_net_socket_send_batch .
+ *
+ * @param socket       Connected socket object to send data to.
+ * @param buffer       Data to send.
+ * @param length       Number of bytes in @p buffer .
+ * @param segment_size Size of each datagram. If 0, the value of
+ *                     @ref AVS_NET_SOCKET_OPT_INNER_MTU is used.
+ *
+ * @returns @ref AVS_OK for success, or an error condition for which the
+ *          operation failed.
+ */
+avs_error_t avs_net_socket_send_segmented(avs_net_socket_t *socket,
+                                          const void *buffer,
+                                          size_t length,
+                                          size_t segment_size);
+
+/**
+ * Receives data from @p socket , possibly consisting of multiple datagrams
+ * coalesced by the operating system if @ref AVS_NET_SOCKET_OPT_UDP_GRO is
+ * enabled.
+ *
+ * The received data consists of datagrams of @p out_segment_size bytes each,
+ * except for the last one, which may be shorter. If no datagrams have been
+ * coalesced, @p out_segment_size is equal to @p out_bytes_received .
+ *
+ * The coalesced data may be up to 64 KB long, so @p buffer should be at least
+ * that large - otherwise the data will be truncated and
+ * <c>avs_errno(AVS_EMSGSIZE)</c> will be returned, as with
+ * @ref avs_net_socket_receive .
+ *
+ * @param[in]  socket             Socket object to read data from.
+ * @param[out] out_bytes_received Number of bytes written into @p buffer .
+ * @param[out] buffer             Buffer to write the data to.
+ * @param[in]  buffer_length      Number of bytes available in @p buffer .
+ * @param[out] out_segment_size   Size of each received datagram.
+ *
+ * @returns @ref AVS_OK for success, or an error condition for which the
+ *          operation failed.
+ */
+avs_error_t avs_net_socket_receive_segmented(avs_net_socket_t *socket,
+                                             size_t *out_bytes_received,
+                                             void *buffer,
+                                             size_t buffer_length,
+                                             size_t *out_segment_size);
+
+#ifdef AVS_COMMONS_STREAM_WITH_FILE
+/**
+ * Sends up to @p length bytes read from @p file , starting at its current
+ * position, to the remote endpoint @p socket is connected to, with the data
+ * passed from the file to the socket by the kernel (e.g. using
+ * <c>sendfile()</c>), without being copied through user space. On success,
+ * the file position is advanced by the number of bytes sent; after an error,
+ * it is unspecified.
+ *
+ * If the end of the file is reached before @p length bytes have been sent,
+ * sending stops and @ref AVS_OK is returned, with <c>*out_bytes_sent</c> set
+ * to the (possibly zero) number of bytes sent until then. Callers that need
+ * exactly @p length bytes shall check it.
+ *
+ * Only plain TCP sockets on platforms that support it can send files this way.
+ * Other socket types (e.g. SSL/TLS sockets, which need to encrypt the data)
+ * and files that cannot be used this way (e.g. pipes) are rejected with
+ * <c>avs_errno(AVS_ENOTSUP)</c>, without sending any data or moving the file
+ * position; the caller shall read the file and use @ref avs_net_socket_send
+ * instead. @ref avs_stream_copy does so automatically for netbuf streams.
+ *
+ * This function is only available if the library has been compiled with
+ * file stream support (<c>AVS_COMMONS_STREAM_WITH_FILE</c>).
+ *
+ * @param socket              Connected socket object to send data to.
+ * @param file                File to send the data from; must be open for
+ *                            reading.
+ * @param length              Maximum number of bytes to send. Pass
+ *                            <c>SIZE_MAX</c> to send everything up to the end
+ *                            of the file.
+ * @param[out] out_bytes_sent Set to the number of bytes actually sent, which
+ *                            is less than @p length if the end of the file
+ *                            has been reached, or if an error occurred. May
+ *                            be NULL.
+ *
+ * @returns @ref AVS_OK for success, including the end of the file having been
+ *          reached early, or an error condition for which the operation
+ *          failed. <c>avs_errno(AVS_ENOTSUP)</c> if the socket or the file
+ *          does not support this operation, in which case nothing has been
+ *          sent.
+ */
+avs_error_t avs_net_socket_send_file(avs_net_socket_t *socket,
+                                     FILE *file,
+                                     size_t length,
+                                     size_t *out_bytes_sent);
+#endif // AVS_COMMONS_STREAM_WITH_FILE
+
+/**
+ * Single fragment of data to be sent using @ref avs_net_socket_sendv .
+ */
+typedef struct {
+    /** Fragment data. */
+    const void *data;
+
+    /** Number of bytes in @ref avs_net_socket_outgoing_buffer_t::data . */
+    size_t data_length;
+} avs_net_socket_outgoing_buffer_t;
+
+/**
+ * Single buffer to receive data into using @ref avs_net_socket_receivev .
+ */
+typedef struct {
+    /** Buffer to write the data to. */
+    void *buffer;
+
+    /**
+     * Number of bytes available in
+     * @ref avs_net_socket_incoming_buffer_t::buffer .
+     */
+    size_t buffer_length;
+} avs_net_socket_incoming_buffer_t;
+
+/**
+ * Sends data gathered from multiple buffers to the remote endpoint @p socket
+ * is connected to, as if their concatenation was passed to
+ * @ref avs_net_socket_send .
+ *
+ * On platforms that support it, this is done using a single
+ * <c>sendmsg()</c> call (or a few of them, if the operating system accepts
+ * only a part of the data), so that e.g. a protocol header and a payload
+ * stored separately do not need to be copied into a common buffer nor sent
+ * with separate system calls. Otherwise, or for socket types that do not
+ * implement vectored I/O natively, each non-empty buffer of a stream socket is
+ * sent using a separate @ref avs_net_socket_send call. Datagram sockets (see
+ * @ref AVS_NET_SOCKET_OPT_DATAGRAM ), and sockets that do not report their
+ * type, always send the data as a single datagram - the buffers are copied
+ * into a temporary heap buffer in that case.
+ *
+ * @param socket  Connected socket object to send data to.
+ * @param buffers Array of buffers to send, in order.
+ * @param count   Number of elements in @p buffers .
+ *
+ * @returns @ref AVS_OK for success, or an error condition for which the
+ *          operation failed.
+ */
+avs_error_t
+avs_net_socket_sendv(avs_net_socket_t *socket,
+                     const avs_net_socket_outgoing_buffer_t *buffers,
+                     size_t count);
+
+/**
+ * Receives data from @p socket and scatters it across multiple buffers, as if
+ * they were a single contiguous buffer passed to
+ * @ref avs_net_socket_receive .
+ *
+ * On platforms that support it, this is done using a single
+ * <c>recvmsg()</c> call. Otherwise, or for socket types that do not implement
+ * vectored I/O natively, the data is received into the first non-empty buffer
+ * only - as with @ref avs_net_socket_receive on stream sockets, callers shall
+ * be prepared to receive less data than requested. For datagram sockets, this
+ * means that datagrams that do not fit in the first buffer are truncated in
+ * that case.
+ *
+ * @param[in]  socket             Socket object to read data from.
+ * @param[out] out_bytes_received Total number of bytes written into the
+ *                                buffers. The buffers are filled in order.
+ * @param[in]  buffers            Array of buffers to receive the data into.
+ * @param[in]  count              Number of elements in @p buffers .
+ *
+ * @returns @ref AVS_OK for success, or an error condition for which the
+ *          operation failed. As with @ref avs_net_socket_receive ,
+ *          <c>avs_errno(AVS_EMSGSIZE)</c> is returned if a datagram has been
+ *          truncated.
+ */
+avs_error_t
+avs_net_socket_receivev(avs_net_socket_t *socket,
+                        size_t *out_bytes_received,
+                        const avs_net_socket_incoming_buffer_t *buffers,
+                        size_t count);
+
 /**
  * Binds @p socket to specified local @p address and @p port .
  *
@@ -957,6 +1644,33 @@ avs_error_t avs_net_socket_bind(avs_net_socket_t *socket,
                                 const char *address,
                                 const char *port);
 
+/**
+ * Binds all sockets in @p shards to the same local @p address and @p port ,
+ * forming a sharded listener.
+ *
+ * All the sockets shall be of the same type and shall have been created with
+ * @ref avs_net_socket_configuration_t::reuse_port set. If @p port is
+ * <c>NULL</c>, empty or <c>"0"</c>, the first socket is bound to an ephemeral
+ * port, and the remaining ones are bound to the same port.
+ *
+ * Afterwards, each of the sockets may be used independently, e.g. by calling
+ * @ref avs_net_socket_accept on it from a separate thread - the system
+ * distributes new connections between them.
+ *
+ * @param shards  Array of unbound sockets to operate on.
+ * @param count   Number of elements in @p shards .
+ * @param address Local IP address to bind to.
+ * @param port    Local port to bind to.
+ *
+ * @returns @ref AVS_OK for success, or an error condition for which the
+ *          operation failed. In case of failure, all the sockets that have been
+ *          bound by this function are closed.
+ */
+avs_error_t avs_net_socket_bind_shards(avs_net_socket_t *const *shards,
+                                       size_t count,
+                                       const char *address,
+                                       const char *port);
+
 /**
  * Accepts an incoming connection targeted at @p server_socket and prepares
  * @p client_socket for communication with connecting host.
@@ -1150,6 +1864,122 @@ avs_error_t avs_net_socket_set_opt(avs_net_socket_t *socket,
  */
 const void *avs_net_socket_get_system(avs_net_socket_t *socket);
 
+/**
+ * Number of buckets in @ref avs_net_socket_histogram_t .
+ */
+#define AVS_NET_SOCKET_HISTOGRAM_BUCKETS 24
+
+/**
+ * Histogram of durations, with logarithmic buckets.
+ */
+typedef struct {
+    /**
+     * Number of samples in each bucket. <c>buckets[0]</c> counts samples
+     * shorter than 1 microsecond, <c>buckets[i]</c> counts samples in range
+     * [2^(i-1), 2^i) microseconds, and the last bucket also counts all samples
+     * longer than that.
+     */
+    uint64_t buckets[AVS_NET_SOCKET_HISTOGRAM_BUCKETS];
+
+    /** Total number of samples. */
+    uint64_t count;
+
+    /** Sum of all samples. */
+    avs_time_duration_t total;
+
+    /** Longest sample. */
+    avs_time_duration_t max;
+} avs_net_socket_histogram_t;
+
+/**
+ * Socket I/O statistics, as returned by @ref avs_net_socket_get_stats and
+ * @ref avs_net_get_global_stats .
+ */
+typedef struct {
+    /**
+     * Histogram of time spent in send operations (@ref avs_net_socket_send ,
+     * @ref avs_net_socket_send_to and their batch, segmented, vectored and
+     * file variants), including waiting for the socket to become writable.
+     */
+    avs_net_socket_histogram_t send_latency;
+
+    /**
+     * Histogram of time spent in receive operations
+     * (@ref avs_net_socket_receive , @ref avs_net_socket_receive_from and
+     * their batch, segmented and vectored variants), including waiting for
+     * data.
+     */
+    avs_net_socket_histogram_t receive_latency;
+
+    /** Histogram of (D)TLS handshake durations. */
+    avs_net_socket_histogram_t handshake_time;
+
+    /**
+     * Number of system calls that transferred data or connections on the
+     * underlying system socket, including the ones that failed. Only counted
+     * by the default TCP and UDP socket implementation.
+     */
+    uint64_t syscalls;
+
+    /**
+     * Number of such system calls that failed with <c>EAGAIN</c> or
+     * <c>EWOULDBLOCK</c>, e.g. when the socket has been reported as ready by
+     * <c>poll()</c> spuriously, or with the
+     * @ref avs_net_socket_configuration_t::optimistic_io option enabled.
+     */
+    uint64_t would_block;
+
+    /** Number of calls to <c>poll()</c> or <c>select()</c>. */
+    uint64_t polls;
+
+    /** Total time spent in <c>poll()</c> or <c>select()</c>. */
+    avs_time_duration_t poll_wait_time;
+} avs_net_socket_stats_t;
+
+/**
+ * Retrieves I/O statistics of @p socket , gathered since its creation.
+ *
+ * Statistics are only gathered if the library is compiled with the
+ * <c>WITH_SOCKET_STATS</c> CMake option. Doing so adds two clock reads to each
+ * send and receive operation and to each <c>poll()</c> call.
+ *
+ * Each layer of a layered socket (e.g. a (D)TLS socket and its backend TCP or
+ * UDP socket) has its own statistics - for example, the system call counters
+ * of a (D)TLS socket are always zero, but those of its backend socket are not.
+ *
+ * @param socket    Socket to operate on.
+ * @param out_stats Structure to fill with the statistics.
+ *
+ * @returns @ref AVS_OK for success, or <c>avs_errno(AVS_ENOTSUP)</c> if the
+ *          library has been compiled without statistics support or the socket
+ *          implementation does not support gathering them.
+ */
+avs_error_t avs_net_socket_get_stats(avs_net_socket_t *socket,
+                                     avs_net_socket_stats_t *out_stats);
+
+/**
+ * Retrieves I/O statistics of all sockets, gathered since library
+ * initialization or the last call to @ref avs_net_reset_global_stats .
+ *
+ * Operations on each layer of a layered socket are counted separately, so for
+ * example a single send on a (D)TLS socket is counted in
+ * @ref avs_net_socket_stats_t::send_latency at least twice.
+ *
+ * @param out_stats Structure to fill with the statistics.
+ *
+ * @returns @ref AVS_OK for success, or <c>avs_errno(AVS_ENOTSUP)</c> if the
+ *          library has been compiled without statistics support.
+ */
+avs_error_t avs_net_get_global_stats(avs_net_socket_stats_t *out_stats);
+
+/**
+ * Resets the statistics returned by @ref avs_net_get_global_stats .
+ *
+ * @returns @ref AVS_OK for success, or <c>avs_errno(AVS_ENOTSUP)</c> if the
+ *          library has been compiled without statistics support.
+ */
+avs_error_t avs_net_reset_global_stats(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -90,6 +90,59 @@ typedef avs_error_t (*avs_net_socket_set_opt_t)(
         avs_net_socket_opt_key_t option_key,
         avs_net_socket_opt_value_t option_value);
 
+typedef avs_error_t (*avs_net_socket_send_batch_t)(
+        avs_net_socket_t *socket,
+        const avs_net_socket_outgoing_datagram_t *datagrams,
+        size_t count,
+        size_t *out_sent);
+
+typedef avs_error_t (*avs_net_socket_receive_batch_t)(
+        avs_net_socket_t *socket,
+        avs_net_socket_received_datagram_t *datagrams,
+        size_t count,
+        size_t *out_received);
+
+typedef avs_error_t (*avs_net_socket_send_segmented_t)(avs_net_socket_t *socket,
+                                                       const void *buffer,
+                                                       size_t length,
+                                                       size_t segment_size);
+
+typedef avs_error_t (*avs_net_socket_receive_segmented_t)(
+        avs_net_socket_t *socket,
+        size_t *out_bytes_received,
+        void *buffer,
+        size_t buffer_length,
+        size_t *out_segment_size);
+
+#ifdef AVS_COMMONS_STREAM_WITH_FILE
+typedef avs_error_t (*avs_net_socket_send_file_t)(avs_net_socket_t *socket,
+                                                  FILE *file,
+                                                  size_t length,
+                                                  size_t *out_bytes_sent);
+#endif // AVS_COMMONS_STREAM_WITH_FILE
+
+typedef avs_error_t (*avs_net_socket_sendv_t)(
+        avs_net_socket_t *socket,
+        const avs_net_socket_outgoing_buffer_t *buffers,
+        size_t count);
+
+typedef avs_error_t (*avs_net_socket_receivev_t)(
+        avs_net_socket_t *socket,
+        size_t *out_bytes_received,
+        const avs_net_socket_incoming_buffer_t *buffers,
+        size_t count);
+
+typedef avs_net_socket_stats_t *(*avs_net_socket_get_stats_t)(
+        avs_net_socket_t *socket);
+
+typedef avs_error_t (*avs_net_socket_decorate_async_t)(
+        avs_net_socket_t *socket,
+        avs_net_socket_t *backend_socket,
+        avs_net_handshake_pool_t *pool);
+
+typedef avs_error_t (*avs_net_socket_handshake_continue_t)(
+        avs_net_socket_t *socket);
+
 typedef struct {
     avs_net_socket_connect_t connect;
     avs_net_socket_decorate_t decorate;
@@ -111,6 +164,70 @@ typedef struct {
     avs_net_socket_get_local_port_t get_local_port;
     avs_net_socket_get_opt_t get_opt;
     avs_net_socket_set_opt_t set_opt;
+    /**
+     * Optional - if NULL or if it returns <c>avs_errno(AVS_ENOTSUP)</c>,
+     * @ref avs_net_socket_send_batch falls back to calling @c send or
+     * @c send_to for each datagram.
+     */
+    avs_net_socket_send_batch_t send_batch;
+    /**
+     * Optional - if NULL or if it returns <c>avs_errno(AVS_ENOTSUP)</c>,
+     * @ref avs_net_socket_receive_batch falls back to calling @c receive or
+     * @c receive_from for each datagram.
+     */
+    avs_net_socket_receive_batch_t receive_batch;
+    /**
+     * Optional - if NULL or if it returns <c>avs_errno(AVS_ENOTSUP)</c>,
+     * @ref avs_net_socket_send_segmented falls back to
+     * @ref avs_net_socket_send_batch .
+     */
+    avs_net_socket_send_segmented_t send_segmented;
+    /**
+     * Optional - if NULL or if it returns <c>avs_errno(AVS_ENOTSUP)</c>,
+     * @ref avs_net_socket_receive_segmented falls back to @c receive.
+     */
+    avs_net_socket_receive_segmented_t receive_segmented;
+#ifdef AVS_COMMONS_STREAM_WITH_FILE
+    /**
+     * Optional - if NULL, @ref avs_net_socket_send_file fails with
+     * <c>avs_errno(AVS_ENOTSUP)</c>. The implementation shall only return
+     * <c>avs_errno(AVS_ENOTSUP)</c> if it has neither sent any data nor moved
+     * the file position.
+     */
+    avs_net_socket_send_file_t send_file;
+#endif // AVS_COMMONS_STREAM_WITH_FILE
+    /**
+     * Optional - if NULL or if it returns <c>avs_errno(AVS_ENOTSUP)</c>,
+     * @ref avs_net_socket_sendv falls back to calling @c send for each
+     * buffer of a stream socket, or once with the buffers copied together for
+     * a datagram socket. The implementation shall only return
+     * <c>avs_errno(AVS_ENOTSUP)</c> if it has not sent any data.
+     */
+    avs_net_socket_sendv_t sendv;
+    /**
+     * Optional - if NULL or if it returns <c>avs_errno(AVS_ENOTSUP)</c>,
+     * @ref avs_net_socket_receivev falls back to calling @c receive with the
+     * first non-empty buffer.
+     */
+    avs_net_socket_receivev_t receivev;
+    /**
+     * Optional - returns a pointer to the statistics structure stored in the
+     * socket, which is updated by the generic layer on each operation. If
+     * NULL, or if it returns NULL, @ref avs_net_socket_get_stats fails with
+     * <c>avs_errno(AVS_ENOTSUP)</c>, but the operations are still counted in
+     * @ref avs_net_get_global_stats .
+     */
+    avs_net_socket_get_stats_t get_stats;
+    /**
+     * Optional - if NULL, @ref avs_net_socket_decorate_async fails with
+     * <c>avs_errno(AVS_ENOTSUP)</c>.
+     */
+    avs_net_socket_decorate_async_t decorate_async;
+    /**
+     * Optional - if NULL, @ref avs_net_socket_handshake_continue fails with
+     * <c>avs_errno(AVS_ENOTSUP)</c>.
+     */
+    avs_net_socket_handshake_continue_t handshake_continue;
 } avs_net_socket_v_table_t;
 
 #ifdef __cplusplus
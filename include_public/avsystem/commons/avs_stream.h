@@ -367,6 +367,11 @@ avs_error_t avs_stream_peekline(avs_stream_t *stream,
  * @p output_stream, until <c>*out_message_finished</c> is true on the input
  * stream or an error occurs.
  *
+ * If @p output_stream implements @ref AVS_STREAM_V_TABLE_EXTENSION_COPY and
+ * supports @p input_stream , the copy is delegated to it instead - e.g. a
+ * netbuf stream sends the contents of a file stream using
+ * @ref avs_net_socket_send_file .
+ *
  * NOTE: @ref avs_stream_finish_message is NOT called on the output stream, so
  * you need to call it manually if needed.
  *
@@ -17,6 +17,8 @@
 #ifndef AVS_COMMONS_STREAM_FILE_H
 #define AVS_COMMONS_STREAM_FILE_H
 
+#include <stdio.h>
+
 #include <avsystem/commons/avs_stream.h>
 
 #ifdef __cplusplus
@@ -104,6 +106,21 @@ typedef struct avs_file_stream_struct avs_stream_file_t;
  */
 avs_stream_t *avs_stream_file_create(const char *path, uint8_t mode);
 
+/**
+ * Returns the stdio file handle used by a stream created with
+ * @ref avs_stream_file_create , so that its contents can be passed to
+ * functions that operate on files directly, such as
+ * @ref avs_net_socket_send_file .
+ *
+ * The handle remains owned by the stream. Its position is shared with the
+ * stream, so reading from it advances the stream as well.
+ *
+ * @param stream Stream to operate on.
+ *
+ * @returns The file handle, or NULL if @p stream is not a file stream.
+ */
+FILE *avs_stream_file_get_fp(avs_stream_t *stream);
+
 #ifdef __cplusplus
 }
 #endif
@@ -222,6 +222,33 @@ typedef struct {
     avs_stream_offset_t offset;
 } avs_stream_v_table_extension_offset_t;
 
+#define AVS_STREAM_V_TABLE_EXTENSION_COPY 0x434F5059UL /* "COPY" */
+
+/**
+ * Optional @ref avs_stream_copy implementation callback type, provided by the
+ * output stream.
+ *
+ * Copies the rest of the message from @p input_stream into @p output_stream
+ * in a more efficient way than through an intermediate buffer, e.g. by having
+ * the kernel send a file directly to a socket.
+ *
+ * @param output_stream Stream to write the data to.
+ *
+ * @param input_stream  Stream to read the data from.
+ *
+ * @returns @ref AVS_OK for success, or an error condition for which the
+ *          operation failed. <c>avs_errno(AVS_ENOTSUP)</c> shall be returned,
+ *          without consuming any data, if this kind of input stream is not
+ *          supported - @ref avs_stream_copy then falls back to the regular
+ *          read/write loop.
+ */
+typedef avs_error_t (*avs_stream_copy_from_t)(avs_stream_t *output_stream,
+                                              avs_stream_t *input_stream);
+
+typedef struct {
+    avs_stream_copy_from_t copy_from;
+} avs_stream_v_table_extension_copy_t;
+
 #ifdef __cplusplus
 }
 #endif
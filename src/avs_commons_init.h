@@ -62,6 +62,13 @@
 #    error "AVS_COMMONS_WITH_AVS_PERSISTENCE is required for AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE"
 #endif
 
+#if defined(AVS_COMMONS_WITH_AVS_NET)                              \
+        && defined(AVS_COMMONS_NET_WITH_TLS_SESSION_CACHE)         \
+        && (!defined(AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE) \
+            || !defined(AVS_COMMONS_WITH_AVS_LIST))
+#    error "AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE and AVS_COMMONS_WITH_AVS_LIST are required for AVS_COMMONS_NET_WITH_TLS_SESSION_CACHE"
+#endif
+
 #if !defined(AVS_COMMONS_WITH_AVS_STREAM) \
         && defined(AVS_COMMONS_STREAM_WITH_FILE)
 #    error "AVS_COMMONS_WITH_AVS_STREAM is required for AVS_COMMONS_STREAM_WITH_FILE"
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avs_commons_init.h>
+
+#if defined(AVS_COMMONS_WITH_AVS_COMPAT_THREADING) \
+        && defined(AVS_COMMONS_COMPAT_THREADING_WITH_ATOMIC_SPINLOCK)
+
+#    include <avsystem/commons/avs_defs.h>
+#    include <avsystem/commons/avs_memory.h>
+#    include <avsystem/commons/avs_rwlock.h>
+
+#    include <stdatomic.h>
+
+#    include "avs_atomic_spinlock_structs.h"
+
+#    define MODULE_NAME rwlock_atomic_spinlock
+#    include <avs_x_log_config.h>
+
+VISIBILITY_SOURCE_BEGIN
+
+// a writer is waiting for the readers to release the lock
+#    define RWLOCK_WRITER_PENDING (1U << 30)
+// a writer holds the lock
+#    define RWLOCK_WRITER_HELD (1U << 31)
+
+int avs_rwlock_create(avs_rwlock_t **out_rwlock) {
+    AVS_ASSERT(!*out_rwlock, "possible attempt to reinitialize a rwlock");
+
+    *out_rwlock = (avs_rwlock_t *) avs_calloc(1, sizeof(avs_rwlock_t));
+    if (*out_rwlock) {
+        _avs_mutex_init(&(*out_rwlock)->writer_mutex);
+        atomic_init(&(*out_rwlock)->state, 0);
+        return 0;
+    }
+    return -1;
+}
+
+int avs_rwlock_read_lock(avs_rwlock_t *rwlock) {
+    unsigned state = atomic_load(&rwlock->state);
+    while ((state & (RWLOCK_WRITER_PENDING | RWLOCK_WRITER_HELD))
+           || !atomic_compare_exchange_weak(&rwlock->state, &state,
+                                            state + 1)) {
+        state = atomic_load(&rwlock->state);
+    }
+    return 0;
+}
+
+int avs_rwlock_read_unlock(avs_rwlock_t *rwlock) {
+    atomic_fetch_sub(&rwlock->state, 1);
+    return 0;
+}
+
+int avs_rwlock_write_lock(avs_rwlock_t *rwlock) {
+    avs_mutex_lock(&rwlock->writer_mutex);
+    // stop new readers from coming in, and wait for the current ones to leave
+    atomic_fetch_or(&rwlock->state, RWLOCK_WRITER_PENDING);
+    unsigned expected = RWLOCK_WRITER_PENDING;
+    while (!atomic_compare_exchange_weak(&rwlock->state, &expected,
+                                         RWLOCK_WRITER_HELD)) {
+        expected = RWLOCK_WRITER_PENDING;
+    }
+    return 0;
+}
+
+int avs_rwlock_write_unlock(avs_rwlock_t *rwlock) {
+    atomic_store(&rwlock->state, 0);
+    avs_mutex_unlock(&rwlock->writer_mutex);
+    return 0;
+}
+
+void avs_rwlock_cleanup(avs_rwlock_t **rwlock) {
+    if (!*rwlock) {
+        return;
+    }
+
+    AVS_ASSERT(atomic_load(&(*rwlock)->state) == 0,
+               "attempted to cleanup a locked rwlock");
+    _avs_mutex_destroy(&(*rwlock)->writer_mutex);
+    avs_free(*rwlock);
+    *rwlock = NULL;
+}
+
+#endif // defined(AVS_COMMONS_WITH_AVS_COMPAT_THREADING) &&
+       // defined(AVS_COMMONS_COMPAT_THREADING_WITH_ATOMIC_SPINLOCK)
@@ -19,6 +19,7 @@
 
 #include <avsystem/commons/avs_condvar.h>
 #include <avsystem/commons/avs_mutex.h>
+#include <avsystem/commons/avs_rwlock.h>
 
 #include <stdatomic.h>
 
@@ -41,6 +42,14 @@ struct avs_condvar {
     condvar_waiter_node_t *first_waiter;
 };
 
+struct avs_rwlock {
+    // serializes writers, so that only one of them may be pending at a time
+    avs_mutex_t writer_mutex;
+    // number of readers holding the lock, combined with the RWLOCK_WRITER_*
+    // flags defined in avs_atomic_spinlock_rwlock.c
+    volatile atomic_uint state;
+};
+
 void _avs_mutex_init(avs_mutex_t *mutex);
 void _avs_mutex_destroy(avs_mutex_t *mutex);
 
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avsystem/commons/avs_commons_config.h>
+
+#if defined(AVS_COMMONS_WITH_AVS_COMPAT_THREADING) \
+        && defined(AVS_COMMONS_COMPAT_THREADING_WITH_FUTEX)
+
+#    include <avs_commons_posix_init.h>
+
+#    include <avsystem/commons/avs_condvar.h>
+#    include <avsystem/commons/avs_defs.h>
+#    include <avsystem/commons/avs_memory.h>
+
+#    include <limits.h>
+#    include <stdatomic.h>
+
+#    include "avs_futex_structs.h"
+
+#    define MODULE_NAME condvar_futex
+#    include <avs_x_log_config.h>
+
+VISIBILITY_SOURCE_BEGIN
+
+int avs_condvar_create(avs_condvar_t **out_condvar) {
+    AVS_ASSERT(!*out_condvar,
+               "possible attempt to reinitialize a condition variable");
+
+    *out_condvar = (avs_condvar_t *) avs_calloc(1, sizeof(avs_condvar_t));
+    if (!*out_condvar) {
+        return -1;
+    }
+    atomic_init(&(*out_condvar)->seq, 0);
+    return 0;
+}
+
+int avs_condvar_notify_all(avs_condvar_t *condvar) {
+    atomic_fetch_add(&condvar->seq, 1);
+    _avs_futex_wake(&condvar->seq, INT_MAX);
+    return 0;
+}
+
+int avs_condvar_wait(avs_condvar_t *condvar,
+                     avs_mutex_t *mutex,
+                     avs_time_monotonic_t deadline) {
+    // Any notification sent after this point, i.e. after the mutex is
+    // unlocked, will change the sequence number, so the futex wait will not
+    // block in that case.
+    unsigned seq = atomic_load(&condvar->seq);
+    avs_mutex_unlock(mutex);
+
+    int result;
+    if (avs_time_monotonic_valid(deadline)) {
+        avs_time_duration_t remaining =
+                avs_time_monotonic_diff(deadline, avs_time_monotonic_now());
+        if (!avs_time_duration_less(AVS_TIME_DURATION_ZERO, remaining)) {
+            result = AVS_CONDVAR_TIMEOUT;
+        } else {
+            struct timespec timeout = {
+                .tv_sec = (time_t) remaining.seconds,
+                .tv_nsec = remaining.nanoseconds
+            };
+            result = _avs_futex_wait(&condvar->seq, seq, &timeout);
+        }
+    } else {
+        result = _avs_futex_wait(&condvar->seq, seq, NULL);
+    }
+
+    _avs_mutex_lock_contended(mutex);
+    return result;
+}
+
+void avs_condvar_cleanup(avs_condvar_t **condvar) {
+    if (!*condvar) {
+        return;
+    }
+
+    avs_free(*condvar);
+    *condvar = NULL;
+}
+
+#endif // defined(AVS_COMMONS_WITH_AVS_COMPAT_THREADING) &&
+       // defined(AVS_COMMONS_COMPAT_THREADING_WITH_FUTEX)
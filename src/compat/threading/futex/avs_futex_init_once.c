@@ -0,0 +1,66 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avs_commons_init.h>
+
+#if defined(AVS_COMMONS_WITH_AVS_COMPAT_THREADING) \
+        && defined(AVS_COMMONS_COMPAT_THREADING_WITH_FUTEX)
+
+#    include <avsystem/commons/avs_defs.h>
+#    include <avsystem/commons/avs_init_once.h>
+
+#    include <limits.h>
+#    include <stdatomic.h>
+
+#    include "avs_futex_structs.h"
+
+#    define MODULE_NAME init_once_futex
+#    include <avs_x_log_config.h>
+
+VISIBILITY_SOURCE_BEGIN
+
+AVS_STATIC_ASSERT(sizeof(avs_init_once_handle_t) >= sizeof(atomic_uint),
+                  avs_init_once_handle_too_small);
+AVS_STATIC_ASSERT(AVS_ALIGNOF(avs_init_once_handle_t)
+                          >= AVS_ALIGNOF(atomic_uint),
+                  avs_init_once_alignment_incompatible);
+
+enum init_state { INIT_NOT_STARTED, INIT_IN_PROGRESS, INIT_DONE };
+
+int avs_init_once(volatile avs_init_once_handle_t *handle,
+                  avs_init_once_func_t *func,
+                  void *func_arg) {
+    volatile atomic_uint *state = (volatile atomic_uint *) handle;
+
+    unsigned expected = INIT_NOT_STARTED;
+    while (!atomic_compare_exchange_strong(state, &expected,
+                                           INIT_IN_PROGRESS)) {
+        if (expected == INIT_DONE) {
+            return 0;
+        }
+        // another thread is running the initialization - wait for it
+        _avs_futex_wait(state, INIT_IN_PROGRESS, NULL);
+        expected = INIT_NOT_STARTED;
+    }
+
+    int result = func(func_arg);
+    atomic_store(state, result ? INIT_NOT_STARTED : INIT_DONE);
+    _avs_futex_wake(state, INT_MAX);
+    return result;
+}
+
+#endif // defined(AVS_COMMONS_WITH_AVS_COMPAT_THREADING) &&
+       // defined(AVS_COMMONS_COMPAT_THREADING_WITH_FUTEX)
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _GNU_SOURCE // for syscall()
+#include <avs_commons_init.h>
+
+#if defined(AVS_COMMONS_WITH_AVS_COMPAT_THREADING) \
+        && defined(AVS_COMMONS_COMPAT_THREADING_WITH_FUTEX)
+
+#    include <avsystem/commons/avs_defs.h>
+#    include <avsystem/commons/avs_memory.h>
+#    include <avsystem/commons/avs_mutex.h>
+
+#    include <errno.h>
+#    include <stdatomic.h>
+#    include <stdint.h>
+
+#    include <linux/futex.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+
+#    include "avs_futex_structs.h"
+
+#    define MODULE_NAME mutex_futex
+#    include <avs_x_log_config.h>
+
+VISIBILITY_SOURCE_BEGIN
+
+AVS_STATIC_ASSERT(sizeof(atomic_uint) == sizeof(uint32_t),
+                  atomic_uint_not_usable_as_futex_word);
+
+// Mutex states, as described in "Futexes Are Tricky" by Ulrich Drepper
+enum {
+    MUTEX_UNLOCKED = 0,
+    MUTEX_LOCKED = 1,
+    // locked, and other threads might be sleeping on the futex
+    MUTEX_CONTENDED = 2
+};
+
+// Number of spinning rounds before going to sleep. The number of busy-wait
+// iterations is doubled with each round, so at most 2^SPIN_ROUNDS - 1 CPU relax
+// hints are issued before falling back to the kernel.
+#    define SPIN_ROUNDS 8
+
+static inline void cpu_relax(void) {
+#    if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+    __asm__ __volatile__("pause");
+#    elif defined(__GNUC__)                                        \
+            && (defined(__aarch64__)                               \
+                || (defined(__arm__) && defined(__ARM_ARCH)        \
+                    && (__ARM_ARCH >= 7 || defined(__ARM_ARCH_6K__) \
+                        || defined(__ARM_ARCH_6KZ__))))
+    __asm__ __volatile__("yield");
+#    elif defined(__GNUC__)
+    // no hint instruction before ARMv6K; at least prevent the compiler from
+    // merging the busy-wait iterations
+    __asm__ __volatile__("" ::: "memory");
+#    endif
+}
+
+int _avs_futex_wait(volatile atomic_uint *word,
+                    unsigned expected,
+                    const struct timespec *timeout) {
+    if (syscall(SYS_futex, (uint32_t *) (uintptr_t) word, FUTEX_WAIT_PRIVATE,
+                expected, timeout, NULL, 0)) {
+        if (errno == ETIMEDOUT) {
+            return AVS_CONDVAR_TIMEOUT;
+        } else if (errno != EAGAIN && errno != EINTR) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void _avs_futex_wake(volatile atomic_uint *word, int count) {
+    syscall(SYS_futex, (uint32_t *) (uintptr_t) word, FUTEX_WAKE_PRIVATE,
+            count, NULL, NULL, 0);
+}
+
+int avs_mutex_create(avs_mutex_t **out_mutex) {
+    AVS_ASSERT(!*out_mutex, "possible attempt to reinitialize a mutex");
+
+    *out_mutex = (avs_mutex_t *) avs_calloc(1, sizeof(avs_mutex_t));
+    if (!*out_mutex) {
+        return -1;
+    }
+    atomic_init(&(*out_mutex)->state, MUTEX_UNLOCKED);
+    return 0;
+}
+
+void _avs_mutex_lock_contended(avs_mutex_t *mutex) {
+    while (atomic_exchange(&mutex->state, MUTEX_CONTENDED) != MUTEX_UNLOCKED) {
+        _avs_futex_wait(&mutex->state, MUTEX_CONTENDED, NULL);
+    }
+}
+
+int avs_mutex_lock(avs_mutex_t *mutex) {
+    unsigned state = MUTEX_UNLOCKED;
+    if (atomic_compare_exchange_strong(&mutex->state, &state, MUTEX_LOCKED)) {
+        return 0;
+    }
+    // The lock is usually held only for a short while, so spin for a bit
+    // before going to sleep. Don't bother if other threads are already asleep.
+    for (unsigned round = 0; round < SPIN_ROUNDS && state != MUTEX_CONTENDED;
+         ++round) {
+        for (unsigned i = 0; i < (1U << round); ++i) {
+            cpu_relax();
+        }
+        state = atomic_load_explicit(&mutex->state, memory_order_relaxed);
+        if (state == MUTEX_UNLOCKED
+                && atomic_compare_exchange_weak(&mutex->state, &state,
+                                                MUTEX_LOCKED)) {
+            return 0;
+        }
+    }
+    _avs_mutex_lock_contended(mutex);
+    return 0;
+}
+
+int avs_mutex_try_lock(avs_mutex_t *mutex) {
+    unsigned state = MUTEX_UNLOCKED;
+    return atomic_compare_exchange_strong(&mutex->state, &state, MUTEX_LOCKED)
+                   ? 0
+                   : 1;
+}
+
+int avs_mutex_unlock(avs_mutex_t *mutex) {
+    if (atomic_exchange(&mutex->state, MUTEX_UNLOCKED) == MUTEX_CONTENDED) {
+        _avs_futex_wake(&mutex->state, 1);
+    }
+    return 0;
+}
+
+void avs_mutex_cleanup(avs_mutex_t **mutex) {
+    if (!*mutex) {
+        return;
+    }
+
+    AVS_ASSERT(atomic_load(&(*mutex)->state) == MUTEX_UNLOCKED,
+               "attempted to cleanup a locked mutex");
+    avs_free(*mutex);
+    *mutex = NULL;
+}
+
+#endif // defined(AVS_COMMONS_WITH_AVS_COMPAT_THREADING) &&
+       // defined(AVS_COMMONS_COMPAT_THREADING_WITH_FUTEX)
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avs_commons_init.h>
+
+#if defined(AVS_COMMONS_WITH_AVS_COMPAT_THREADING) \
+        && defined(AVS_COMMONS_COMPAT_THREADING_WITH_FUTEX)
+
+#    include <avsystem/commons/avs_defs.h>
+#    include <avsystem/commons/avs_memory.h>
+#    include <avsystem/commons/avs_rwlock.h>
+
+#    include <limits.h>
+#    include <stdatomic.h>
+
+#    include "avs_futex_structs.h"
+
+#    define MODULE_NAME rwlock_futex
+#    include <avs_x_log_config.h>
+
+VISIBILITY_SOURCE_BEGIN
+
+// number of readers holding the lock
+#    define RWLOCK_READERS_MASK ((1U << 29) - 1)
+// some readers are sleeping, waiting for a writer to release the lock
+#    define RWLOCK_READERS_WAITING (1U << 29)
+// a writer is waiting for the readers to release the lock
+#    define RWLOCK_WRITER_PENDING (1U << 30)
+// a writer holds the lock
+#    define RWLOCK_WRITER_HELD (1U << 31)
+
+int avs_rwlock_create(avs_rwlock_t **out_rwlock) {
+    AVS_ASSERT(!*out_rwlock, "possible attempt to reinitialize a rwlock");
+
+    *out_rwlock = (avs_rwlock_t *) avs_calloc(1, sizeof(avs_rwlock_t));
+    if (!*out_rwlock) {
+        return -1;
+    }
+    atomic_init(&(*out_rwlock)->writer_mutex.state, 0);
+    atomic_init(&(*out_rwlock)->state, 0);
+    return 0;
+}
+
+int avs_rwlock_read_lock(avs_rwlock_t *rwlock) {
+    unsigned state = atomic_load(&rwlock->state);
+    while (true) {
+        if (!(state & (RWLOCK_WRITER_PENDING | RWLOCK_WRITER_HELD))) {
+            if (atomic_compare_exchange_weak(&rwlock->state, &state,
+                                             state + 1)) {
+                return 0;
+            }
+        } else if ((state & RWLOCK_READERS_WAITING)
+                   || atomic_compare_exchange_weak(
+                              &rwlock->state, &state,
+                              state | RWLOCK_READERS_WAITING)) {
+            _avs_futex_wait(&rwlock->state, state | RWLOCK_READERS_WAITING,
+                            NULL);
+            state = atomic_load(&rwlock->state);
+        }
+    }
+}
+
+int avs_rwlock_read_unlock(avs_rwlock_t *rwlock) {
+    unsigned state = atomic_fetch_sub(&rwlock->state, 1) - 1;
+    if (!(state & RWLOCK_READERS_MASK) && (state & RWLOCK_WRITER_PENDING)) {
+        // the pending writer is waiting for the last reader to leave
+        _avs_futex_wake(&rwlock->state, INT_MAX);
+    }
+    return 0;
+}
+
+int avs_rwlock_write_lock(avs_rwlock_t *rwlock) {
+    avs_mutex_lock(&rwlock->writer_mutex);
+    // stop new readers from coming in, and wait for the current ones to leave
+    unsigned state = atomic_fetch_or(&rwlock->state, RWLOCK_WRITER_PENDING)
+                     | RWLOCK_WRITER_PENDING;
+    while (true) {
+        if (!(state & RWLOCK_READERS_MASK)) {
+            if (atomic_compare_exchange_weak(
+                        &rwlock->state, &state,
+                        (state & ~RWLOCK_WRITER_PENDING)
+                                | RWLOCK_WRITER_HELD)) {
+                return 0;
+            }
+        } else {
+            _avs_futex_wait(&rwlock->state, state, NULL);
+            state = atomic_load(&rwlock->state);
+        }
+    }
+}
+
+int avs_rwlock_write_unlock(avs_rwlock_t *rwlock) {
+    if (atomic_exchange(&rwlock->state, 0) & RWLOCK_READERS_WAITING) {
+        _avs_futex_wake(&rwlock->state, INT_MAX);
+    }
+    avs_mutex_unlock(&rwlock->writer_mutex);
+    return 0;
+}
+
+void avs_rwlock_cleanup(avs_rwlock_t **rwlock) {
+    if (!*rwlock) {
+        return;
+    }
+
+    AVS_ASSERT(atomic_load(&(*rwlock)->state) == 0,
+               "attempted to cleanup a locked rwlock");
+    avs_free(*rwlock);
+    *rwlock = NULL;
+}
+
+#endif // defined(AVS_COMMONS_WITH_AVS_COMPAT_THREADING) &&
+       // defined(AVS_COMMONS_COMPAT_THREADING_WITH_FUTEX)
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AVS_COMMONS_COMPAT_THREADING_FUTEX_STRUCTS_H
+#define AVS_COMMONS_COMPAT_THREADING_FUTEX_STRUCTS_H
+
+#include <avsystem/commons/avs_condvar.h>
+#include <avsystem/commons/avs_mutex.h>
+#include <avsystem/commons/avs_rwlock.h>
+
+#include <stdatomic.h>
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+struct timespec;
+
+struct avs_mutex {
+    // one of the MUTEX_* constants defined in avs_futex_mutex.c
+    volatile atomic_uint state;
+};
+
+struct avs_condvar {
+    // incremented on each notification; waiters sleep on this word
+    volatile atomic_uint seq;
+};
+
+struct avs_rwlock {
+    // serializes writers, so that only one of them may be pending at a time
+    avs_mutex_t writer_mutex;
+    // number of readers holding the lock, combined with the RWLOCK_* flags
+    // defined in avs_futex_rwlock.c; waiters sleep on this word
+    volatile atomic_uint state;
+};
+
+/**
+ * Blocks until @p word is woken up using @ref _avs_futex_wake, as long as its
+ * value is equal to @p expected at the time of the call.
+ *
+ * @returns 0 when woken up (possibly spuriously), or if the value was not
+ *          equal to @p expected, @ref AVS_CONDVAR_TIMEOUT if @p timeout, which
+ *          is relative, elapsed, or a negative value in case of error.
+ */
+int _avs_futex_wait(volatile atomic_uint *word,
+                    unsigned expected,
+                    const struct timespec *timeout);
+
+/**
+ * Wakes up at most @p count threads blocked on @p word.
+ */
+void _avs_futex_wake(volatile atomic_uint *word, int count);
+
+/**
+ * Locks @p mutex, assuming that there are other threads waiting for it. This is
+ * used to relock the mutex after waiting on a condition variable, so that
+ * unlocking it wakes up any other threads woken up by the same notification.
+ */
+void _avs_mutex_lock_contended(avs_mutex_t *mutex);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* AVS_COMMONS_COMPAT_THREADING_FUTEX_STRUCTS_H */
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avs_commons_init.h>
+
+#ifdef AVS_COMMONS_WITH_AVS_COMPAT_THREADING
+
+#    include <avsystem/commons/avs_condvar.h>
+#    include <avsystem/commons/avs_defs.h>
+#    include <avsystem/commons/avs_memory.h>
+#    include <avsystem/commons/avs_mutex.h>
+#    include <avsystem/commons/avs_rwlock.h>
+
+#    define MODULE_NAME rwlock_generic
+#    include <avs_x_log_config.h>
+
+VISIBILITY_SOURCE_BEGIN
+
+/**
+ * Reader-writer lock implemented only in terms of avs_mutex_t and
+ * avs_condvar_t, for threading backends that do not provide one. Like the
+ * atomic_spinlock and futex implementations, it prefers writers.
+ */
+struct avs_rwlock {
+    avs_mutex_t *mutex;
+    /** Notified whenever the lock is released. */
+    avs_condvar_t *condvar;
+    size_t readers;
+    size_t waiting_writers;
+    bool writer;
+};
+
+int avs_rwlock_create(avs_rwlock_t **out_rwlock) {
+    AVS_ASSERT(!*out_rwlock, "possible attempt to reinitialize a rwlock");
+
+    *out_rwlock = (avs_rwlock_t *) avs_calloc(1, sizeof(avs_rwlock_t));
+    if (!*out_rwlock) {
+        return -1;
+    }
+
+    if (avs_mutex_create(&(*out_rwlock)->mutex)
+            || avs_condvar_create(&(*out_rwlock)->condvar)) {
+        avs_rwlock_cleanup(out_rwlock);
+        return -1;
+    }
+
+    return 0;
+}
+
+int avs_rwlock_read_lock(avs_rwlock_t *rwlock) {
+    if (avs_mutex_lock(rwlock->mutex)) {
+        return -1;
+    }
+    int result = 0;
+    while (rwlock->writer || rwlock->waiting_writers) {
+        if ((result = avs_condvar_wait(rwlock->condvar, rwlock->mutex,
+                                       AVS_TIME_MONOTONIC_INVALID))
+                < 0) {
+            break;
+        }
+    }
+    if (!result) {
+        ++rwlock->readers;
+    }
+    avs_mutex_unlock(rwlock->mutex);
+    return result < 0 ? -1 : 0;
+}
+
+int avs_rwlock_read_unlock(avs_rwlock_t *rwlock) {
+    if (avs_mutex_lock(rwlock->mutex)) {
+        return -1;
+    }
+    AVS_ASSERT(rwlock->readers, "rwlock not held for reading");
+    if (!--rwlock->readers) {
+        avs_condvar_notify_all(rwlock->condvar);
+    }
+    return avs_mutex_unlock(rwlock->mutex);
+}
+
+int avs_rwlock_write_lock(avs_rwlock_t *rwlock) {
+    if (avs_mutex_lock(rwlock->mutex)) {
+        return -1;
+    }
+    int result = 0;
+    ++rwlock->waiting_writers;
+    while (rwlock->writer || rwlock->readers) {
+        if ((result = avs_condvar_wait(rwlock->condvar, rwlock->mutex,
+                                       AVS_TIME_MONOTONIC_INVALID))
+                < 0) {
+            break;
+        }
+    }
+    --rwlock->waiting_writers;
+    if (!result) {
+        rwlock->writer = true;
+    } else if (!rwlock->waiting_writers) {
+        // readers might have been waiting only because of us
+        avs_condvar_notify_all(rwlock->condvar);
+    }
+    avs_mutex_unlock(rwlock->mutex);
+    return result < 0 ? -1 : 0;
+}
+
+int avs_rwlock_write_unlock(avs_rwlock_t *rwlock) {
+    if (avs_mutex_lock(rwlock->mutex)) {
+        return -1;
+    }
+    AVS_ASSERT(rwlock->writer, "rwlock not held for writing");
+    rwlock->writer = false;
+    avs_condvar_notify_all(rwlock->condvar);
+    return avs_mutex_unlock(rwlock->mutex);
+}
+
+void avs_rwlock_cleanup(avs_rwlock_t **rwlock) {
+    if (!*rwlock) {
+        return;
+    }
+
+    AVS_ASSERT(!(*rwlock)->readers && !(*rwlock)->writer,
+               "attempted to cleanup a held rwlock");
+    avs_condvar_cleanup(&(*rwlock)->condvar);
+    avs_mutex_cleanup(&(*rwlock)->mutex);
+    avs_free(*rwlock);
+    *rwlock = NULL;
+}
+
+#endif // AVS_COMMONS_WITH_AVS_COMPAT_THREADING
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avsystem/commons/avs_commons_config.h>
+
+#if defined(AVS_COMMONS_WITH_AVS_COMPAT_THREADING) \
+        && defined(AVS_COMMONS_COMPAT_THREADING_WITH_PTHREAD)
+
+#    include <avs_commons_posix_init.h>
+
+#    include <avsystem/commons/avs_defs.h>
+#    include <avsystem/commons/avs_memory.h>
+#    include <avsystem/commons/avs_rwlock.h>
+
+#    include <pthread.h>
+
+#    include "avs_pthread_structs.h"
+
+#    define MODULE_NAME rwlock_pthread
+#    include <avs_x_log_config.h>
+
+VISIBILITY_SOURCE_BEGIN
+
+int avs_rwlock_create(avs_rwlock_t **out_rwlock) {
+    AVS_ASSERT(!*out_rwlock, "possible attempt to reinitialize a rwlock");
+
+    *out_rwlock = (avs_rwlock_t *) avs_calloc(1, sizeof(avs_rwlock_t));
+    if (!*out_rwlock) {
+        return -1;
+    }
+
+    if (pthread_rwlock_init(&(*out_rwlock)->pthread_rwlock, NULL)) {
+        avs_free(*out_rwlock);
+        *out_rwlock = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+int avs_rwlock_read_lock(avs_rwlock_t *rwlock) {
+    return pthread_rwlock_rdlock(&rwlock->pthread_rwlock);
+}
+
+int avs_rwlock_read_unlock(avs_rwlock_t *rwlock) {
+    return pthread_rwlock_unlock(&rwlock->pthread_rwlock);
+}
+
+int avs_rwlock_write_lock(avs_rwlock_t *rwlock) {
+    return pthread_rwlock_wrlock(&rwlock->pthread_rwlock);
+}
+
+int avs_rwlock_write_unlock(avs_rwlock_t *rwlock) {
+    return pthread_rwlock_unlock(&rwlock->pthread_rwlock);
+}
+
+void avs_rwlock_cleanup(avs_rwlock_t **rwlock) {
+    if (!*rwlock) {
+        return;
+    }
+
+    int result = pthread_rwlock_destroy(&(*rwlock)->pthread_rwlock);
+    (void) result;
+    AVS_ASSERT(result == 0, "pthread_rwlock_destroy failed");
+
+    avs_free(*rwlock);
+    *rwlock = NULL;
+}
+
+#endif // defined(AVS_COMMONS_WITH_AVS_COMPAT_THREADING) &&
+       // defined(AVS_COMMONS_COMPAT_THREADING_WITH_PTHREAD)
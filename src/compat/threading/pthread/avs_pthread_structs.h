@@ -19,6 +19,7 @@
 
 #include <avsystem/commons/avs_condvar.h>
 #include <avsystem/commons/avs_mutex.h>
+#include <avsystem/commons/avs_rwlock.h>
 
 #include <pthread.h>
 
@@ -32,6 +33,10 @@ struct avs_mutex {
     pthread_mutex_t pthread_mutex;
 };
 
+struct avs_rwlock {
+    pthread_rwlock_t pthread_rwlock;
+};
+
 VISIBILITY_PRIVATE_HEADER_END
 
 #endif /* AVS_COMMONS_COMPAT_THREADING_PTHREAD_STRUCTS_H */
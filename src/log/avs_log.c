@@ -20,18 +20,38 @@
 #if defined(AVS_COMMONS_WITH_AVS_LOG) \
         && !defined(AVS_COMMONS_WITH_EXTERNAL_LOGGER_HEADER)
 
+#    include <limits.h>
 #    include <stdarg.h>
+#    include <stdint.h>
 #    include <stdio.h>
 #    include <string.h>
 
 #    include <avsystem/commons/avs_list.h>
 #    include <avsystem/commons/avs_log.h>
 
+#    if defined(AVS_COMMONS_LOG_WITH_LEVEL_CACHE)  \
+            || defined(AVS_COMMONS_LOG_WITH_ASYNC) \
+            || defined(AVS_COMMONS_LOG_WITH_BINARY)
+#        include <stdatomic.h>
+#    endif // defined(AVS_COMMONS_LOG_WITH_LEVEL_CACHE) ||
+           // defined(AVS_COMMONS_LOG_WITH_ASYNC) ||
+           // defined(AVS_COMMONS_LOG_WITH_BINARY)
+
+#    ifdef AVS_COMMONS_LOG_WITH_ASYNC
+#        include <avsystem/commons/avs_condvar.h>
+#        include <avsystem/commons/avs_memory.h>
+#        include <avsystem/commons/avs_mutex.h>
+#    endif // AVS_COMMONS_LOG_WITH_ASYNC
+
 #    ifdef AVS_COMMONS_WITH_AVS_COMPAT_THREADING
 #        include <avsystem/commons/avs_init_once.h>
-#        include <avsystem/commons/avs_mutex.h>
+#        include <avsystem/commons/avs_rwlock.h>
 #    endif // AVS_COMMONS_WITH_AVS_COMPAT_THREADING
 
+#    ifdef AVS_COMMONS_LOG_WITH_BINARY
+#        include "avs_log_binary.h"
+#    endif // AVS_COMMONS_LOG_WITH_BINARY
+
 VISIBILITY_SOURCE_BEGIN
 
 static void default_log_handler(avs_log_level_t level,
@@ -60,6 +80,10 @@ static struct {
     avs_log_level_t default_level;
     AVS_LIST(module_level_t) module_levels;
 
+#    ifdef AVS_COMMONS_LOG_WITH_BINARY
+    avs_log_binary_t binary;
+#    endif // AVS_COMMONS_LOG_WITH_BINARY
+
 #    ifdef AVS_COMMONS_LOG_USE_GLOBAL_BUFFER
     char buffer[AVS_COMMONS_LOG_MAX_LINE_LENGTH];
 #    endif // AVS_COMMONS_LOG_USE_GLOBAL_BUFFER
@@ -70,19 +94,30 @@ static struct {
 };
 
 #    ifdef AVS_COMMONS_WITH_AVS_COMPAT_THREADING
-static avs_mutex_t *g_log_mutex;
+/**
+ * Guards @ref g_log. Most accesses only read the module level table, so they
+ * may take the lock in shared mode.
+ */
+static avs_rwlock_t *g_log_lock;
 static avs_init_once_handle_t g_log_init_handle;
 
+#        ifdef AVS_COMMONS_LOG_WITH_ASYNC
+static void async_cleanup(void);
+#        else // AVS_COMMONS_LOG_WITH_ASYNC
+#            define async_cleanup() ((void) 0)
+#        endif // AVS_COMMONS_LOG_WITH_ASYNC
+
 void _avs_log_cleanup_global_state(void);
 void _avs_log_cleanup_global_state(void) {
     avs_log_reset();
-    avs_mutex_cleanup(&g_log_mutex);
+    async_cleanup();
+    avs_rwlock_cleanup(&g_log_lock);
     g_log_init_handle = NULL;
 }
 
 static int initialize_global_state(void *unused) {
     (void) unused;
-    return avs_mutex_create(&g_log_mutex);
+    return avs_rwlock_create(&g_log_lock);
 }
 
 static void log_with_buffer_unlocked_v(char *log_buf,
@@ -94,14 +129,14 @@ static void log_with_buffer_unlocked_v(char *log_buf,
                                        const char *msg,
                                        va_list ap);
 
-static int _log_lock(const char *file, unsigned line, ...) {
+static int _log_lock(bool exclusive, const char *file, unsigned line, ...) {
 
     const char *out_msg = NULL;
     if (avs_init_once(&g_log_init_handle, initialize_global_state, NULL)) {
         out_msg = "could not initialize global log state";
-    }
-    if (avs_mutex_lock(g_log_mutex) && !out_msg) {
-        out_msg = "could not lock log mutex";
+    } else if (exclusive ? avs_rwlock_write_lock(g_log_lock)
+                         : avs_rwlock_read_lock(g_log_lock)) {
+        out_msg = "could not lock global log state";
     }
     if (out_msg) {
         char log_buf[AVS_COMMONS_LOG_MAX_LINE_LENGTH];
@@ -115,17 +150,111 @@ static int _log_lock(const char *file, unsigned line, ...) {
     return 0;
 }
 
-#        define LOG_LOCK() _log_lock(__FILE__, __LINE__)
+#        define LOG_LOCK() _log_lock(true, __FILE__, __LINE__)
+
+#        define LOG_UNLOCK() avs_rwlock_write_unlock(g_log_lock)
 
-#        define LOG_UNLOCK() avs_mutex_unlock(g_log_mutex)
+#        define LOG_READ_LOCK() _log_lock(false, __FILE__, __LINE__)
+
+#        define LOG_READ_UNLOCK() avs_rwlock_read_unlock(g_log_lock)
 
 #    else // AVS_COMMONS_WITH_AVS_COMPAT_THREADING
 
 #        define LOG_LOCK() 0
 #        define LOG_UNLOCK()
+#        define LOG_READ_LOCK() 0
+#        define LOG_READ_UNLOCK()
 
 #    endif // AVS_COMMONS_WITH_AVS_COMPAT_THREADING
 
+#    ifdef AVS_COMMONS_LOG_WITH_LEVEL_CACHE
+/**
+ * Number of entries in the level cache; MUST be a power of two. Each distinct
+ * module name string used by the log call sites takes one entry. Modules that
+ * do not fit fall back to checking the level under the lock.
+ */
+#        define LEVEL_CACHE_SIZE 64
+/** Maximum number of entries visited when looking up a module. */
+#        define LEVEL_CACHE_MAX_PROBES 8
+
+#        define LEVEL_CACHE_LEVEL_BITS 4
+#        define LEVEL_CACHE_LEVEL_MASK ((1UL << LEVEL_CACHE_LEVEL_BITS) - 1)
+#        define LEVEL_CACHE_MAX_GENERATION (ULONG_MAX >> LEVEL_CACHE_LEVEL_BITS)
+
+AVS_STATIC_ASSERT((LEVEL_CACHE_SIZE & (LEVEL_CACHE_SIZE - 1)) == 0,
+                  level_cache_size_is_power_of_two);
+AVS_STATIC_ASSERT(AVS_LOG_QUIET <= LEVEL_CACHE_LEVEL_MASK,
+                  log_levels_fit_in_level_cache);
+
+/**
+ * Cached level threshold for a single module name string. Entries are keyed
+ * by the address of the string, which is what the logging macros pass, so the
+ * fast path does not need to compare names. Once claimed, an entry is never
+ * reassigned to a different string, so @p value always refers to @p module .
+ */
+typedef struct {
+    volatile atomic_uintptr_t module;
+    /**
+     * Generation for which the entry has been filled, shifted left by
+     * @ref LEVEL_CACHE_LEVEL_BITS, combined with the level threshold. Zero is
+     * never valid, as generations start from 1.
+     */
+    volatile atomic_ulong value;
+} level_cache_entry_t;
+
+static level_cache_entry_t g_log_level_cache[LEVEL_CACHE_SIZE];
+
+/**
+ * Incremented each time any log level is changed, which invalidates all the
+ * level cache entries. Only modified with the exclusive lock held.
+ */
+static volatile atomic_ulong g_log_level_generation = ATOMIC_VAR_INIT(1);
+
+static inline void invalidate_level_caches_unlocked(void) {
+    unsigned long generation = atomic_load_explicit(&g_log_level_generation,
+                                                    memory_order_relaxed);
+    if (generation < LEVEL_CACHE_MAX_GENERATION) {
+        atomic_store_explicit(&g_log_level_generation, generation + 1,
+                              memory_order_relaxed);
+        return;
+    }
+    // Wrapping the counter would make stale entries look valid again, so
+    // start over with all of them cleared. Entries are only filled with the
+    // lock held in shared mode, so none can be filled concurrently.
+    for (size_t i = 0; i < LEVEL_CACHE_SIZE; ++i) {
+        atomic_store_explicit(&g_log_level_cache[i].value, 0,
+                              memory_order_relaxed);
+    }
+    atomic_store_explicit(&g_log_level_generation, 1, memory_order_relaxed);
+}
+
+static level_cache_entry_t *level_cache_entry(const char *module) {
+    uintptr_t key = (uintptr_t) module;
+    // string literals are not aligned, but the low bits are mixed in anyway
+    size_t index = (size_t) ((key ^ (key >> 6) ^ (key >> 12))
+                             & (LEVEL_CACHE_SIZE - 1));
+    for (size_t i = 0; i < LEVEL_CACHE_MAX_PROBES; ++i) {
+        level_cache_entry_t *entry =
+                &g_log_level_cache[(index + i) & (LEVEL_CACHE_SIZE - 1)];
+        uintptr_t entry_module =
+                atomic_load_explicit(&entry->module, memory_order_relaxed);
+        // if claiming a free entry fails, entry_module is set to the string
+        // that another thread has claimed it for
+        if (!entry_module
+                && atomic_compare_exchange_strong(&entry->module,
+                                                  &entry_module, key)) {
+            return entry;
+        }
+        if (entry_module == key) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+#    else // AVS_COMMONS_LOG_WITH_LEVEL_CACHE
+#        define invalidate_level_caches_unlocked() ((void) 0)
+#    endif // AVS_COMMONS_LOG_WITH_LEVEL_CACHE
+
 static inline void set_log_handler_unlocked(avs_log_handler_t *log_handler) {
     g_log.handler.normal = (log_handler ? log_handler : default_log_handler);
     g_log.is_extended_handler = false;
@@ -158,6 +287,64 @@ void avs_log_set_extended_handler(avs_log_extended_handler_t *log_handler) {
     LOG_UNLOCK();
 }
 
+#    ifdef AVS_COMMONS_LOG_WITH_BINARY
+/**
+ * Mirrors whether @ref g_log.binary has a writer set, so that logging does not
+ * need to take the exclusive lock when binary mode is not active.
+ */
+static volatile atomic_bool g_log_binary_active;
+
+static inline void set_binary_writer_unlocked(avs_log_binary_writer_t *writer,
+                                              void *writer_arg) {
+    _avs_log_binary_start(&g_log.binary, writer, writer_arg);
+    atomic_store_explicit(&g_log_binary_active, !!writer,
+                          memory_order_relaxed);
+}
+
+/**
+ * Writes a log message as a binary record, if binary mode is enabled.
+ *
+ * @returns true if the message has been handled, false if it shall be
+ *          formatted as text - including when it could not be encoded.
+ */
+static bool binary_log_v(avs_log_level_t level,
+                         const char *module,
+                         const char *file,
+                         unsigned line,
+                         const char *msg,
+                         va_list ap) {
+    if (!atomic_load_explicit(&g_log_binary_active, memory_order_relaxed)
+            || LOG_LOCK()) {
+        return false;
+    }
+    // binary mode might have been disabled in the meantime
+    bool result = g_log.binary.writer
+                  && !_avs_log_binary_write_v(&g_log.binary, level, module,
+                                              file, line, msg, ap);
+    LOG_UNLOCK();
+    return result;
+}
+
+int avs_log_set_binary_writer(avs_log_binary_writer_t *writer,
+                              void *writer_arg) {
+    if (LOG_LOCK()) {
+        return -1;
+    }
+    set_binary_writer_unlocked(writer, writer_arg);
+    LOG_UNLOCK();
+    return 0;
+}
+#    else // AVS_COMMONS_LOG_WITH_BINARY
+#        define set_binary_writer_unlocked(...) ((void) 0)
+#        define binary_log_v(...) false
+
+int avs_log_set_binary_writer(avs_log_binary_writer_t *writer,
+                              void *writer_arg) {
+    (void) writer_arg;
+    return writer ? -1 : 0;
+}
+#    endif // AVS_COMMONS_LOG_WITH_BINARY
+
 static avs_log_level_t *level_for(const char *module, int create) {
     if (module) {
         AVS_LIST(module_level_t) *entry_ptr;
@@ -198,6 +385,7 @@ static int set_log_level_unlocked(const char *module, avs_log_level_t level) {
         return -1;
     }
     *level_ptr = level;
+    invalidate_level_caches_unlocked();
     return 0;
 }
 
@@ -211,27 +399,65 @@ int avs_log_set_level__(const char *module, avs_log_level_t level) {
 }
 
 void avs_log_reset(void) {
+    avs_log_async_stop();
     if (LOG_LOCK()) {
         return;
     }
     AVS_LIST_CLEAR(&g_log.module_levels);
     set_log_handler_unlocked(default_log_handler);
+    set_binary_writer_unlocked(NULL, NULL);
     set_log_level_unlocked(NULL, AVS_LOG_INFO);
     LOG_UNLOCK();
 }
 
+#    ifdef AVS_COMMONS_LOG_WITH_LEVEL_CACHE
 int avs_log_should_log__(avs_log_level_t level, const char *module) {
     if (level >= AVS_LOG_QUIET) {
         return 1;
     }
 
-    if (LOG_LOCK()) {
+    level_cache_entry_t *entry = module ? level_cache_entry(module) : NULL;
+    if (entry) {
+        unsigned long cached =
+                atomic_load_explicit(&entry->value, memory_order_relaxed);
+        unsigned long generation = atomic_load_explicit(
+                &g_log_level_generation, memory_order_relaxed);
+        if (cached >> LEVEL_CACHE_LEVEL_BITS == generation) {
+            return level >= (avs_log_level_t) (cached & LEVEL_CACHE_LEVEL_MASK);
+        }
+    }
+
+    if (LOG_READ_LOCK()) {
+        return 1;
+    }
+    avs_log_level_t threshold = *level_for(module, 0);
+    if (entry) {
+        // levels and the generation are only ever changed together, under the
+        // exclusive lock, so they are consistent with each other here
+        unsigned long generation = atomic_load_explicit(
+                &g_log_level_generation, memory_order_relaxed);
+        atomic_store_explicit(&entry->value,
+                              (generation << LEVEL_CACHE_LEVEL_BITS)
+                                      | (unsigned long) threshold,
+                              memory_order_relaxed);
+    }
+    LOG_READ_UNLOCK();
+    return level >= threshold;
+}
+#    else  // AVS_COMMONS_LOG_WITH_LEVEL_CACHE
+int avs_log_should_log__(avs_log_level_t level, const char *module) {
+    if (level >= AVS_LOG_QUIET) {
+        return 1;
+    }
+
+    if (LOG_READ_LOCK()) {
         return 1;
     }
     int result = (level >= *level_for(module, 0));
-    LOG_UNLOCK();
+    LOG_READ_UNLOCK();
     return result;
 }
+#    endif // AVS_COMMONS_LOG_WITH_LEVEL_CACHE
 
 static const char *level_as_string(avs_log_level_t level) {
     switch (level) {
@@ -250,6 +476,28 @@ static const char *level_as_string(avs_log_level_t level) {
     }
 }
 
+static int format_message(char *log_buf_ptr,
+                          size_t log_buf_left,
+                          const char *msg,
+                          va_list ap) {
+    if (log_buf_left) {
+        int pfresult = vsnprintf(log_buf_ptr, log_buf_left, msg, ap);
+        if (pfresult < 0) {
+            // erroneous user-provided format string?
+            return -1;
+        }
+        if ((size_t) pfresult > log_buf_left) {
+            pfresult = (int) log_buf_left - 1;
+            log_buf_ptr = log_buf_ptr + pfresult - 3;
+            for (int i = 0; i < 3; i++) {
+                *log_buf_ptr = '.';
+                ++log_buf_ptr;
+            }
+        }
+    }
+    return 0;
+}
+
 static void log_with_buffer_unlocked_v(char *log_buf,
                                        size_t log_buf_size,
                                        avs_log_level_t level,
@@ -278,20 +526,8 @@ static void log_with_buffer_unlocked_v(char *log_buf,
         log_buf_left -= (size_t) pfresult;
     }
 
-    if (log_buf_left) {
-        pfresult = vsnprintf(log_buf_ptr, log_buf_left, msg, ap);
-        if (pfresult < 0) {
-            // erroneous user-provided format string?
-            return;
-        }
-        if ((size_t) pfresult > log_buf_left) {
-            pfresult = (int) log_buf_left - 1;
-            log_buf_ptr = log_buf_ptr + pfresult - 3;
-            for (int i = 0; i < 3; i++) {
-                *log_buf_ptr = '.';
-                ++log_buf_ptr;
-            }
-        }
+    if (format_message(log_buf_ptr, log_buf_left, msg, ap)) {
+        return;
     }
 
     if (g_log.is_extended_handler) {
@@ -301,12 +537,352 @@ static void log_with_buffer_unlocked_v(char *log_buf,
     }
 }
 
+#    ifdef AVS_COMMONS_LOG_WITH_ASYNC
+#        define ASYNC_QUEUE_SIZE ((size_t) AVS_COMMONS_LOG_ASYNC_QUEUE_SIZE)
+
+AVS_STATIC_ASSERT(ASYNC_QUEUE_SIZE > 0
+                          && (ASYNC_QUEUE_SIZE & (ASYNC_QUEUE_SIZE - 1)) == 0,
+                  log_async_queue_size_is_power_of_two);
+
+typedef struct {
+    /**
+     * Equal to the queue position for which the record may be filled by a
+     * producer, or to that position plus one once it has been filled and may
+     * be consumed.
+     */
+    volatile atomic_size_t sequence;
+    avs_log_level_t level;
+    const char *module;
+    const char *file;
+    unsigned line;
+    char message[AVS_COMMONS_LOG_MAX_LINE_LENGTH];
+} async_record_t;
+
+/**
+ * Bounded multi-producer, single-consumer queue of preformatted log messages.
+ * Producers reserve records by advancing @p enqueue_pos without taking any
+ * locks. The consumer role is held by whoever locks @p consumer_mutex - either
+ * the drainer thread, or a thread calling @ref avs_log_async_flush or
+ * @ref avs_log_async_stop .
+ */
+static struct {
+    async_record_t *records;
+    volatile atomic_bool initialized;
+    volatile atomic_bool active;
+    volatile atomic_bool drainer_waiting;
+    volatile atomic_size_t enqueue_pos;
+    volatile atomic_ulong queued;
+    volatile atomic_ulong dropped;
+
+    // fields below are guarded by consumer_mutex
+    avs_mutex_t *consumer_mutex;
+    avs_condvar_t *condvar;
+    size_t dequeue_pos;
+    unsigned long dropped_reported;
+    bool drainer_running;
+    bool stopping;
+} g_log_async;
+
+static avs_init_once_handle_t g_log_async_init_handle;
+
+static int async_initialize(void *unused) {
+    (void) unused;
+    async_record_t *records = (async_record_t *) avs_calloc(
+            ASYNC_QUEUE_SIZE, sizeof(async_record_t));
+    if (!records) {
+        return -1;
+    }
+    if (avs_mutex_create(&g_log_async.consumer_mutex)) {
+        avs_free(records);
+        return -1;
+    }
+    if (avs_condvar_create(&g_log_async.condvar)) {
+        avs_mutex_cleanup(&g_log_async.consumer_mutex);
+        avs_free(records);
+        return -1;
+    }
+    for (size_t i = 0; i < ASYNC_QUEUE_SIZE; ++i) {
+        atomic_init(&records[i].sequence, i);
+    }
+    atomic_init(&g_log_async.enqueue_pos, 0);
+    g_log_async.dequeue_pos = 0;
+    g_log_async.records = records;
+    atomic_store_explicit(&g_log_async.initialized, true,
+                          memory_order_release);
+    return 0;
+}
+
+static void async_cleanup(void) {
+    avs_log_async_stop();
+    atomic_store_explicit(&g_log_async.initialized, false,
+                          memory_order_relaxed);
+    avs_condvar_cleanup(&g_log_async.condvar);
+    avs_mutex_cleanup(&g_log_async.consumer_mutex);
+    avs_free(g_log_async.records);
+    g_log_async.records = NULL;
+    g_log_async_init_handle = NULL;
+}
+
+static bool async_initialized(void) {
+    return atomic_load_explicit(&g_log_async.initialized,
+                                memory_order_acquire);
+}
+
+static async_record_t *async_reserve(size_t *out_pos) {
+    size_t pos = atomic_load_explicit(&g_log_async.enqueue_pos,
+                                      memory_order_relaxed);
+    while (true) {
+        async_record_t *record =
+                &g_log_async.records[pos & (ASYNC_QUEUE_SIZE - 1)];
+        size_t sequence =
+                atomic_load_explicit(&record->sequence, memory_order_acquire);
+        if (sequence == pos) {
+            if (atomic_compare_exchange_weak_explicit(
+                        &g_log_async.enqueue_pos, &pos, pos + 1,
+                        memory_order_relaxed, memory_order_relaxed)) {
+                *out_pos = pos;
+                return record;
+            }
+        } else if ((ptrdiff_t) (sequence - pos) < 0) {
+            // the record has not been consumed yet since the previous lap
+            return NULL;
+        } else {
+            pos = atomic_load_explicit(&g_log_async.enqueue_pos,
+                                       memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * Queues a log message if the asynchronous mode is active.
+ *
+ * @returns true if the message has been handled (queued or dropped), false if
+ *          it shall be logged synchronously.
+ */
+static bool async_log_v(avs_log_level_t level,
+                        const char *module,
+                        const char *file,
+                        unsigned line,
+                        const char *msg,
+                        va_list ap) {
+    if (!atomic_load_explicit(&g_log_async.active, memory_order_relaxed)) {
+        return false;
+    }
+    // avs_log_async_stop() clears the flag with the lock held exclusively, so
+    // once it drains the queue, no producer may still be about to publish
+    if (LOG_READ_LOCK()) {
+        return false;
+    }
+    if (!atomic_load_explicit(&g_log_async.active, memory_order_acquire)) {
+        LOG_READ_UNLOCK();
+        return false;
+    }
+    size_t pos;
+    async_record_t *record = async_reserve(&pos);
+    if (!record) {
+        LOG_READ_UNLOCK();
+        atomic_fetch_add_explicit(&g_log_async.dropped, 1,
+                                  memory_order_relaxed);
+        return true;
+    }
+    record->level = level;
+    record->module = module;
+    record->file = file;
+    record->line = line;
+    if (format_message(record->message, sizeof(record->message), msg, ap)) {
+        record->message[0] = '\0';
+    }
+    atomic_store_explicit(&record->sequence, pos + 1, memory_order_release);
+    atomic_fetch_add_explicit(&g_log_async.queued, 1, memory_order_relaxed);
+    // the drainer may take the lock while holding consumer_mutex, so it needs
+    // to be released before locking the latter
+    LOG_READ_UNLOCK();
+
+    // pairs with the fence in avs_log_async_drainer_run(): either we see that
+    // the drainer is about to sleep, or it sees the record we just published
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&g_log_async.drainer_waiting,
+                             memory_order_relaxed)) {
+        avs_mutex_lock(g_log_async.consumer_mutex);
+        avs_condvar_notify_all(g_log_async.condvar);
+        avs_mutex_unlock(g_log_async.consumer_mutex);
+    }
+    return true;
+}
+
+static async_record_t *async_front_locked(void) {
+    async_record_t *record =
+            &g_log_async.records[g_log_async.dequeue_pos
+                                 & (ASYNC_QUEUE_SIZE - 1)];
+    if (atomic_load_explicit(&record->sequence, memory_order_acquire)
+            != g_log_async.dequeue_pos + 1) {
+        return NULL;
+    }
+    return record;
+}
+
+static void log_with_buffer_unlocked_l(char *log_buf,
+                                       size_t log_buf_size,
+                                       avs_log_level_t level,
+                                       const char *module,
+                                       const char *file,
+                                       unsigned line,
+                                       const char *msg,
+                                       ...) {
+    va_list ap;
+    va_start(ap, msg);
+    log_with_buffer_unlocked_v(log_buf, log_buf_size, level, module, file,
+                               line, msg, ap);
+    va_end(ap);
+}
+
+static void async_drain_locked(void) {
+    char log_buf[AVS_COMMONS_LOG_MAX_LINE_LENGTH];
+    async_record_t *record;
+    while ((record = async_front_locked())) {
+        log_with_buffer_unlocked_l(log_buf, sizeof(log_buf), record->level,
+                                   record->module, record->file, record->line,
+                                   "%s", record->message);
+        atomic_store_explicit(&record->sequence,
+                              g_log_async.dequeue_pos + ASYNC_QUEUE_SIZE,
+                              memory_order_release);
+        ++g_log_async.dequeue_pos;
+    }
+
+    unsigned long dropped =
+            atomic_load_explicit(&g_log_async.dropped, memory_order_relaxed);
+    if (dropped != g_log_async.dropped_reported) {
+        if (avs_log_should_log__(AVS_LOG_WARNING, "avs_log")) {
+            log_with_buffer_unlocked_l(
+                    log_buf, sizeof(log_buf), AVS_LOG_WARNING, "avs_log",
+                    __FILE__, __LINE__, "%lu log messages dropped",
+                    dropped - g_log_async.dropped_reported);
+        }
+        g_log_async.dropped_reported = dropped;
+    }
+}
+
+int avs_log_async_start(void) {
+    if (avs_init_once(&g_log_async_init_handle, async_initialize, NULL)) {
+        return -1;
+    }
+    avs_mutex_lock(g_log_async.consumer_mutex);
+    g_log_async.stopping = false;
+    atomic_store_explicit(&g_log_async.active, true, memory_order_release);
+    avs_mutex_unlock(g_log_async.consumer_mutex);
+    return 0;
+}
+
+int avs_log_async_drainer_run(void) {
+    if (!async_initialized() || avs_mutex_lock(g_log_async.consumer_mutex)) {
+        return -1;
+    }
+    if (g_log_async.drainer_running || g_log_async.stopping
+            || !atomic_load_explicit(&g_log_async.active,
+                                     memory_order_relaxed)) {
+        avs_mutex_unlock(g_log_async.consumer_mutex);
+        return -1;
+    }
+    int result = 0;
+    g_log_async.drainer_running = true;
+    while (!g_log_async.stopping) {
+        async_drain_locked();
+        atomic_store_explicit(&g_log_async.drainer_waiting, true,
+                              memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (!async_front_locked()) {
+            result = avs_condvar_wait(g_log_async.condvar,
+                                      g_log_async.consumer_mutex,
+                                      AVS_TIME_MONOTONIC_INVALID);
+        }
+        atomic_store_explicit(&g_log_async.drainer_waiting, false,
+                              memory_order_relaxed);
+        if (result < 0) {
+            break;
+        }
+    }
+    g_log_async.drainer_running = false;
+    avs_mutex_unlock(g_log_async.consumer_mutex);
+    return result < 0 ? result : 0;
+}
+
+static void async_flush_locked(void) {
+    // messages logged by the handler on this thread must not try to wake up
+    // the drainer, as that would require locking consumer_mutex again
+    atomic_store_explicit(&g_log_async.drainer_waiting, false,
+                          memory_order_relaxed);
+    async_drain_locked();
+    if (g_log_async.drainer_running) {
+        // make the drainer re-evaluate its state and resume waiting
+        avs_condvar_notify_all(g_log_async.condvar);
+    }
+}
+
+void avs_log_async_flush(void) {
+    if (!async_initialized() || avs_mutex_lock(g_log_async.consumer_mutex)) {
+        return;
+    }
+    async_flush_locked();
+    avs_mutex_unlock(g_log_async.consumer_mutex);
+}
+
+void avs_log_async_stop(void) {
+    if (!async_initialized()) {
+        return;
+    }
+    // wait for the producers that have seen the flag set to publish their
+    // records, so that the final flush below does not miss any of them
+    bool locked = !LOG_LOCK();
+    atomic_store_explicit(&g_log_async.active, false, memory_order_relaxed);
+    if (locked) {
+        LOG_UNLOCK();
+    }
+    if (avs_mutex_lock(g_log_async.consumer_mutex)) {
+        return;
+    }
+    g_log_async.stopping = true;
+    async_flush_locked();
+    avs_mutex_unlock(g_log_async.consumer_mutex);
+}
+
+int avs_log_async_stats(avs_log_async_stats_t *out_stats) {
+    out_stats->queued =
+            atomic_load_explicit(&g_log_async.queued, memory_order_relaxed);
+    out_stats->dropped =
+            atomic_load_explicit(&g_log_async.dropped, memory_order_relaxed);
+    return 0;
+}
+#    else // AVS_COMMONS_LOG_WITH_ASYNC
+#        define async_log_v(...) false
+
+int avs_log_async_start(void) {
+    return -1;
+}
+
+int avs_log_async_drainer_run(void) {
+    return -1;
+}
+
+void avs_log_async_flush(void) {}
+
+void avs_log_async_stop(void) {}
+
+int avs_log_async_stats(avs_log_async_stats_t *out_stats) {
+    (void) out_stats;
+    return -1;
+}
+#    endif // AVS_COMMONS_LOG_WITH_ASYNC
+
 void avs_log_internal_forced_v__(avs_log_level_t level,
                                  const char *module,
                                  const char *file,
                                  unsigned line,
                                  const char *msg,
                                  va_list ap) {
+    if (binary_log_v(level, module, file, line, msg, ap)
+            || async_log_v(level, module, file, line, msg, ap)) {
+        return;
+    }
 #    ifdef AVS_COMMONS_LOG_USE_GLOBAL_BUFFER
     if (LOG_LOCK()) {
         return;
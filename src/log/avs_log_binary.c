@@ -0,0 +1,490 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avs_commons_init.h>
+
+#if defined(AVS_COMMONS_WITH_AVS_LOG) && defined(AVS_COMMONS_LOG_WITH_BINARY) \
+        && !defined(AVS_COMMONS_WITH_EXTERNAL_LOGGER_HEADER)
+
+#    include <limits.h>
+#    include <stdarg.h>
+#    include <stdbool.h>
+#    include <stdint.h>
+#    include <string.h>
+
+#    include <avsystem/commons/avs_defs.h>
+#    include <avsystem/commons/avs_memory.h>
+
+#    include "avs_log_binary.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+AVS_STATIC_ASSERT(sizeof(double) == sizeof(uint64_t), double_is_64_bit);
+
+#    define ENCODER_BUFFER_SIZE 128
+
+/**
+ * Limits of the string table. Once either is reached, the table is cleared
+ * and all strings are sent again as they are used.
+ */
+#    define MAX_STRINGS 256
+#    define MAX_STRINGS_SIZE 8192
+
+typedef struct {
+    avs_log_binary_t *binary;
+    /**
+     * If true, the encoder does not write anything, but only counts the bytes
+     * in @p measured .
+     */
+    bool measuring;
+    size_t measured;
+    size_t size;
+    uint8_t buffer[ENCODER_BUFFER_SIZE];
+} encoder_t;
+
+typedef enum {
+    LENGTH_NONE,
+    LENGTH_HH,
+    LENGTH_H,
+    LENGTH_L,
+    LENGTH_LL,
+    LENGTH_J,
+    LENGTH_Z,
+    LENGTH_T,
+    LENGTH_BIG_L
+} length_modifier_t;
+
+static void encoder_flush(encoder_t *enc) {
+    if (enc->size) {
+        enc->binary->writer(enc->buffer, enc->size, enc->binary->writer_arg);
+        enc->size = 0;
+    }
+}
+
+static void write_bytes(encoder_t *enc, const void *data, size_t size) {
+    if (enc->measuring) {
+        enc->measured += size;
+        return;
+    }
+    const uint8_t *ptr = (const uint8_t *) data;
+    while (size) {
+        if (enc->size == sizeof(enc->buffer)) {
+            encoder_flush(enc);
+        }
+        size_t chunk = AVS_MIN(size, sizeof(enc->buffer) - enc->size);
+        memcpy(enc->buffer + enc->size, ptr, chunk);
+        enc->size += chunk;
+        ptr += chunk;
+        size -= chunk;
+    }
+}
+
+static void write_byte(encoder_t *enc, uint8_t value) {
+    write_bytes(enc, &value, 1);
+}
+
+static void write_varint(encoder_t *enc, uint64_t value) {
+    uint8_t bytes[10];
+    size_t size = 0;
+    do {
+        bytes[size] = (uint8_t) (value & 0x7F);
+        value >>= 7;
+        if (value) {
+            bytes[size] |= 0x80;
+        }
+        ++size;
+    } while (value);
+    write_bytes(enc, bytes, size);
+}
+
+static void write_zigzag(encoder_t *enc, int64_t value) {
+    write_varint(enc, value < 0 ? ((uint64_t) (-(value + 1)) << 1) | 1
+                                : (uint64_t) value << 1);
+}
+
+static void write_double(encoder_t *enc, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint8_t bytes[8];
+    for (size_t i = 0; i < sizeof(bytes); ++i) {
+        bytes[i] = (uint8_t) (bits >> (8 * i));
+    }
+    write_bytes(enc, bytes, sizeof(bytes));
+}
+
+static void write_string(encoder_t *enc, const char *str, int precision) {
+    if (!str) {
+        str = "(null)";
+    }
+    size_t length = 0;
+    while ((precision < 0 || length < (size_t) precision) && str[length]) {
+        ++length;
+    }
+    write_varint(enc, length);
+    write_bytes(enc, str, length);
+}
+
+static size_t varint_size(uint64_t value) {
+    size_t size = 1;
+    while (value >>= 7) {
+        ++size;
+    }
+    return size;
+}
+
+static void write_record_header(encoder_t *enc,
+                                uint8_t type,
+                                size_t payload_size) {
+    write_byte(enc, type);
+    write_varint(enc, payload_size);
+}
+
+static uint32_t hash_string(const char *str) {
+    // 32-bit FNV-1a
+    uint32_t hash = UINT32_C(2166136261);
+    for (; *str; ++str) {
+        hash = (hash ^ (uint8_t) *str) * UINT32_C(16777619);
+    }
+    return hash;
+}
+
+static void clear_strings(avs_log_binary_t *binary) {
+    for (size_t i = 0; i < binary->strings_capacity; ++i) {
+        avs_free(binary->strings[i].str);
+        binary->strings[i].str = NULL;
+    }
+    binary->strings_count = 0;
+    binary->strings_size = 0;
+}
+
+static int grow_strings(avs_log_binary_t *binary) {
+    size_t new_capacity =
+            binary->strings_capacity ? 2 * binary->strings_capacity : 32;
+    avs_log_binary_string_t *new_strings = (avs_log_binary_string_t *)
+            avs_calloc(new_capacity, sizeof(avs_log_binary_string_t));
+    if (!new_strings) {
+        return -1;
+    }
+    for (size_t i = 0; i < binary->strings_capacity; ++i) {
+        if (binary->strings[i].str) {
+            size_t index = binary->strings[i].hash & (new_capacity - 1);
+            while (new_strings[index].str) {
+                index = (index + 1) & (new_capacity - 1);
+            }
+            new_strings[index] = binary->strings[i];
+        }
+    }
+    avs_free(binary->strings);
+    binary->strings = new_strings;
+    binary->strings_capacity = new_capacity;
+    return 0;
+}
+
+/**
+ * Makes sure that @p count new strings of total length @p size (excluding
+ * terminators) may be added to the table without exceeding its limits, by
+ * clearing the table if necessary. This is done before interning all strings
+ * of a message, so that their IDs stay valid until the message is written.
+ */
+static int reserve_strings(avs_log_binary_t *binary,
+                           size_t count,
+                           size_t size) {
+    if (size + count > MAX_STRINGS_SIZE) {
+        return -1;
+    }
+    if (binary->strings_count + count > MAX_STRINGS
+            || binary->strings_size + size + count > MAX_STRINGS_SIZE) {
+        clear_strings(binary);
+    }
+    if (4 * (binary->strings_count + count) > 3 * binary->strings_capacity) {
+        return grow_strings(binary);
+    }
+    return 0;
+}
+
+/**
+ * Looks up the ID of a string that has already been sent in the stream, or
+ * assigns a new one and writes the string definition record. Space for the
+ * string MUST have been reserved using @ref reserve_strings .
+ */
+static int intern_string(encoder_t *enc, const char *str, uint32_t *out_id) {
+    avs_log_binary_t *binary = enc->binary;
+    if (!str) {
+        *out_id = 0;
+        return 0;
+    }
+    uint32_t hash = hash_string(str);
+    size_t index = hash & (binary->strings_capacity - 1);
+    while (binary->strings[index].str) {
+        if (binary->strings[index].hash == hash
+                && strcmp(binary->strings[index].str, str) == 0) {
+            *out_id = binary->strings[index].id;
+            return 0;
+        }
+        index = (index + 1) & (binary->strings_capacity - 1);
+    }
+    size_t length = strlen(str);
+    char *copy = (char *) avs_malloc(length + 1);
+    if (!copy) {
+        return -1;
+    }
+    memcpy(copy, str, length + 1);
+    binary->strings[index].str = copy;
+    binary->strings[index].hash = hash;
+    binary->strings[index].id = ++binary->strings_count;
+    binary->strings_size += length + 1;
+    *out_id = binary->strings[index].id;
+
+    write_record_header(enc, AVS_LOG_BINARY_STRING,
+                        varint_size(*out_id) + varint_size(length) + length);
+    write_varint(enc, *out_id);
+    write_string(enc, str, -1);
+    return 0;
+}
+
+static int64_t read_signed(va_list *ap, length_modifier_t length) {
+    switch (length) {
+    case LENGTH_HH:
+        return (signed char) va_arg(*ap, int);
+    case LENGTH_H:
+        return (short) va_arg(*ap, int);
+    case LENGTH_L:
+        return va_arg(*ap, long);
+    case LENGTH_LL:
+        return va_arg(*ap, long long);
+    case LENGTH_J:
+        return va_arg(*ap, intmax_t);
+    case LENGTH_Z:
+        return (int64_t) va_arg(*ap, size_t);
+    case LENGTH_T:
+        return va_arg(*ap, ptrdiff_t);
+    default:
+        return va_arg(*ap, int);
+    }
+}
+
+static uint64_t read_unsigned(va_list *ap, length_modifier_t length) {
+    switch (length) {
+    case LENGTH_HH:
+        return (unsigned char) va_arg(*ap, unsigned);
+    case LENGTH_H:
+        return (unsigned short) va_arg(*ap, unsigned);
+    case LENGTH_L:
+        return va_arg(*ap, unsigned long);
+    case LENGTH_LL:
+        return va_arg(*ap, unsigned long long);
+    case LENGTH_J:
+        return va_arg(*ap, uintmax_t);
+    case LENGTH_Z:
+        return va_arg(*ap, size_t);
+    case LENGTH_T:
+        return (uint64_t) va_arg(*ap, ptrdiff_t);
+    default:
+        return va_arg(*ap, unsigned);
+    }
+}
+
+static length_modifier_t parse_length_modifier(const char **fmt_ptr) {
+    const char *fmt = *fmt_ptr;
+    length_modifier_t result = LENGTH_NONE;
+    switch (*fmt) {
+    case 'h':
+        result = (fmt[1] == 'h' ? LENGTH_HH : LENGTH_H);
+        break;
+    case 'l':
+        result = (fmt[1] == 'l' ? LENGTH_LL : LENGTH_L);
+        break;
+    case 'j':
+        result = LENGTH_J;
+        break;
+    case 'z':
+        result = LENGTH_Z;
+        break;
+    case 't':
+        result = LENGTH_T;
+        break;
+    case 'L':
+        result = LENGTH_BIG_L;
+        break;
+    default:
+        return LENGTH_NONE;
+    }
+    *fmt_ptr += (result == LENGTH_HH || result == LENGTH_LL) ? 2 : 1;
+    return result;
+}
+
+static void encode_args(encoder_t *enc, const char *fmt, va_list *ap) {
+    while ((fmt = strchr(fmt, '%'))) {
+        ++fmt;
+        if (*fmt == '%') {
+            ++fmt;
+            continue;
+        }
+        fmt += strspn(fmt, "-+ #0");
+        if (*fmt == '*') {
+            write_zigzag(enc, va_arg(*ap, int));
+            ++fmt;
+        } else {
+            fmt += strspn(fmt, "0123456789");
+        }
+        int precision = -1;
+        if (*fmt == '.') {
+            ++fmt;
+            if (*fmt == '*') {
+                precision = va_arg(*ap, int);
+                write_zigzag(enc, precision);
+                ++fmt;
+            } else {
+                precision = 0;
+                while (*fmt >= '0' && *fmt <= '9' && precision < INT_MAX / 10) {
+                    precision = 10 * precision + (*fmt++ - '0');
+                }
+                fmt += strspn(fmt, "0123456789");
+            }
+        }
+        length_modifier_t length = parse_length_modifier(&fmt);
+        switch (*fmt++) {
+        case 'd':
+        case 'i':
+            write_zigzag(enc, read_signed(ap, length));
+            break;
+        case 'c':
+            write_zigzag(enc, va_arg(*ap, int));
+            break;
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            write_varint(enc, read_unsigned(ap, length));
+            break;
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'F':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            write_double(enc, length == LENGTH_BIG_L
+                                      ? (double) va_arg(*ap, long double)
+                                      : va_arg(*ap, double));
+            break;
+        case 's':
+            if (length != LENGTH_NONE) {
+                // wide strings are not supported
+                return;
+            }
+            write_string(enc, va_arg(*ap, const char *), precision);
+            break;
+        case 'p':
+            write_varint(enc, (uintptr_t) va_arg(*ap, void *));
+            break;
+        case 'n':
+            (void) va_arg(*ap, void *);
+            break;
+        default:
+            return;
+        }
+    }
+}
+
+void _avs_log_binary_start(avs_log_binary_t *binary,
+                           avs_log_binary_writer_t *writer,
+                           void *writer_arg) {
+    clear_strings(binary);
+    avs_free(binary->strings);
+    memset(binary, 0, sizeof(*binary));
+    if (writer) {
+        binary->writer = writer;
+        binary->writer_arg = writer_arg;
+        encoder_t enc = {
+            .binary = binary
+        };
+        write_bytes(&enc, AVS_LOG_BINARY_MAGIC,
+                    sizeof(AVS_LOG_BINARY_MAGIC) - 1);
+        write_byte(&enc, AVS_LOG_BINARY_VERSION);
+        encoder_flush(&enc);
+    }
+}
+
+static void write_message_payload(encoder_t *enc,
+                                  avs_log_level_t level,
+                                  const uint32_t ids[3],
+                                  unsigned line,
+                                  const char *msg,
+                                  va_list ap) {
+    write_byte(enc, (uint8_t) level);
+    write_varint(enc, ids[0]);
+    write_varint(enc, ids[1]);
+    write_varint(enc, line);
+    write_varint(enc, ids[2]);
+
+    if (msg) {
+        va_list args;
+        va_copy(args, ap);
+        encode_args(enc, msg, &args);
+        va_end(args);
+    }
+}
+
+int _avs_log_binary_write_v(avs_log_binary_t *binary,
+                            avs_log_level_t level,
+                            const char *module,
+                            const char *file,
+                            unsigned line,
+                            const char *msg,
+                            va_list ap) {
+    encoder_t enc = {
+        .binary = binary
+    };
+    const char *strings[] = { module, file, msg };
+    size_t count = 0;
+    size_t size = 0;
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(strings); ++i) {
+        if (strings[i]) {
+            ++count;
+            size += strlen(strings[i]);
+        }
+    }
+    uint32_t ids[AVS_ARRAY_SIZE(strings)];
+    if (reserve_strings(binary, count, size)) {
+        return -1;
+    }
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(strings); ++i) {
+        if (intern_string(&enc, strings[i], &ids[i])) {
+            // string definitions written so far are still valid
+            encoder_flush(&enc);
+            return -1;
+        }
+    }
+
+    // the payload is encoded twice: first only to determine its length
+    enc.measuring = true;
+    write_message_payload(&enc, level, ids, line, msg, ap);
+    enc.measuring = false;
+    write_record_header(&enc, AVS_LOG_BINARY_MESSAGE, enc.measured);
+    write_message_payload(&enc, level, ids, line, msg, ap);
+    encoder_flush(&enc);
+    return 0;
+}
+
+#    ifdef AVS_UNIT_TESTING
+#        include "tests/log/test_log_binary.c"
+#    endif
+
+#endif // defined(AVS_COMMONS_WITH_AVS_LOG) &&
+       // defined(AVS_COMMONS_LOG_WITH_BINARY) &&
+       // !defined(AVS_COMMONS_WITH_EXTERNAL_LOGGER_HEADER)
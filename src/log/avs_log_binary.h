@@ -0,0 +1,112 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AVS_COMMONS_LOG_BINARY_H
+#define AVS_COMMONS_LOG_BINARY_H
+
+#include <stdarg.h>
+#include <stdint.h>
+
+#include <avsystem/commons/avs_log.h>
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+/**
+ * Binary log stream format, version 2. All multi-byte integers are unsigned
+ * LEB128 varints; signed integers are zigzag-encoded first.
+ *
+ * The stream starts with @ref AVS_LOG_BINARY_MAGIC followed by a single
+ * version byte. Then a sequence of records follows, each consisting of a type
+ * byte, the length of the record payload and the payload itself. Decoders
+ * skip records of unknown types, and any trailing payload bytes they do not
+ * understand.
+ *
+ * - <c>AVS_LOG_BINARY_STRING</c> records contain a string ID and the length
+ *   and contents of the string. Each distinct string is sent only once,
+ *   before the first message that refers to it. When the number or total size
+ *   of strings reaches the limits, all of them are forgotten and IDs are
+ *   assigned from 1 again, so a later definition of an ID replaces the
+ *   earlier one.
+ * - <c>AVS_LOG_BINARY_MESSAGE</c> records contain a level byte, the string
+ *   IDs of the module name and source file name, the line number and the
+ *   string ID of the format string. ID 0 stands for a NULL string. Then all
+ *   the arguments consumed by the format string follow, in order:
+ *   - integers (including <c>%c</c> and <c>*</c> widths and precisions) as
+ *     varints, zigzag-encoded for signed conversions,
+ *   - floating-point values as 8-byte little-endian IEEE 754 doubles,
+ *   - <c>%s</c> as the length and contents of the string (subject to the
+ *     precision, if specified),
+ *   - <c>%p</c> as a varint,
+ *   - <c>%n</c> is not encoded at all.
+ *   Encoding stops at the first unrecognized conversion specification.
+ *
+ * tools/avs_log_decode.py decodes such streams into text log lines.
+ */
+#define AVS_LOG_BINARY_MAGIC "AVSB"
+#define AVS_LOG_BINARY_VERSION 2
+#define AVS_LOG_BINARY_STRING 0x01
+#define AVS_LOG_BINARY_MESSAGE 0x02
+
+typedef struct {
+    /** Copy of the string, owned by the table; NULL for unused entries. */
+    char *str;
+    uint32_t hash;
+    uint32_t id;
+} avs_log_binary_string_t;
+
+typedef struct {
+    avs_log_binary_writer_t *writer;
+    void *writer_arg;
+
+    /**
+     * Open addressing hash table of strings already sent in the stream, keyed
+     * by their contents.
+     */
+    avs_log_binary_string_t *strings;
+    size_t strings_capacity;
+    uint32_t strings_count;
+    /** Total size of the strings in the table, including terminators. */
+    size_t strings_size;
+} avs_log_binary_t;
+
+/**
+ * Starts a new binary log stream: forgets all previously sent strings and
+ * writes the stream header using @p writer . Passing NULL as @p writer
+ * disables binary logging and frees all associated resources.
+ */
+void _avs_log_binary_start(avs_log_binary_t *binary,
+                           avs_log_binary_writer_t *writer,
+                           void *writer_arg);
+
+/**
+ * Encodes a single log message as a binary record, preceded by definitions of
+ * any strings not sent before, and passes it to the writer.
+ *
+ * @returns 0 on success, or a negative value if the message could not be
+ *          encoded, due to an out-of-memory condition or its strings not
+ *          fitting in the string table.
+ */
+int _avs_log_binary_write_v(avs_log_binary_t *binary,
+                            avs_log_level_t level,
+                            const char *module,
+                            const char *file,
+                            unsigned line,
+                            const char *msg,
+                            va_list ap);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* AVS_COMMONS_LOG_BINARY_H */
@@ -25,6 +25,9 @@
 #    include <string.h>
 
 #    include <avsystem/commons/avs_memory.h>
+#    ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+#        include <avsystem/commons/avs_mutex.h>
+#    endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
 #    include <avsystem/commons/avs_net.h>
 #    include <avsystem/commons/avs_socket.h>
 #    include <avsystem/commons/avs_socket_v_table.h>
@@ -36,6 +39,8 @@
 VISIBILITY_SOURCE_BEGIN
 
 const avs_time_duration_t AVS_NET_SOCKET_DEFAULT_RECV_TIMEOUT = { 30, 0 };
+const avs_time_duration_t AVS_NET_SOCKET_RECOMMENDED_CONNECTION_ATTEMPT_DELAY =
+        { 0, 250000000 };
 
 #    ifdef AVS_COMMONS_WITH_AVS_CRYPTO
 avs_net_security_info_t avs_net_security_info_from_psk(avs_net_psk_info_t psk) {
@@ -114,6 +119,198 @@ struct avs_net_socket_struct {
     const avs_net_socket_v_table_t *const operations;
 };
 
+static bool is_enotsup(avs_error_t err) {
+    return err.category == AVS_ERRNO_CATEGORY && err.code == AVS_ENOTSUP;
+}
+
+typedef enum {
+    STATS_SEND,
+    STATS_RECEIVE,
+    STATS_HANDSHAKE
+} stats_histogram_t;
+
+#    ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+static avs_mutex_t *g_stats_mutex;
+static avs_net_socket_stats_t g_stats;
+
+avs_error_t _avs_net_initialize_global_stats_state(void) {
+    memset(&g_stats, 0, sizeof(g_stats));
+    if (avs_mutex_create(&g_stats_mutex)) {
+        return avs_errno(AVS_ENOMEM);
+    }
+    return AVS_OK;
+}
+
+void _avs_net_cleanup_global_stats_state(void) {
+    avs_mutex_cleanup(&g_stats_mutex);
+}
+
+static void histogram_record(avs_net_socket_histogram_t *histogram,
+                             avs_time_duration_t value) {
+    int64_t value_us;
+    size_t bucket = 0;
+    if (!avs_time_duration_to_scalar(&value_us, AVS_TIME_US, value)
+            && value_us > 0) {
+        bucket = 1;
+        while (bucket < AVS_NET_SOCKET_HISTOGRAM_BUCKETS - 1
+               && value_us >= ((int64_t) 1 << bucket)) {
+            ++bucket;
+        }
+    }
+    ++histogram->buckets[bucket];
+    ++histogram->count;
+    histogram->total = avs_time_duration_add(histogram->total, value);
+    if (avs_time_duration_less(histogram->max, value)) {
+        histogram->max = value;
+    }
+}
+
+static avs_net_socket_histogram_t *select_histogram(
+        avs_net_socket_stats_t *stats, stats_histogram_t which) {
+    switch (which) {
+    case STATS_SEND:
+        return &stats->send_latency;
+    case STATS_RECEIVE:
+        return &stats->receive_latency;
+    case STATS_HANDSHAKE:
+        break;
+    }
+    return &stats->handshake_time;
+}
+
+static void record_duration(avs_net_socket_stats_t *stats,
+                            stats_histogram_t which,
+                            avs_time_duration_t duration) {
+    if (stats) {
+        histogram_record(select_histogram(stats, which), duration);
+    }
+    // operations on sockets created before initialization of the global
+    // state (e.g. custom socket implementations) are not counted globally
+    if (g_stats_mutex && !avs_mutex_lock(g_stats_mutex)) {
+        histogram_record(select_histogram(&g_stats, which), duration);
+        avs_mutex_unlock(g_stats_mutex);
+    }
+}
+
+static void add_io_counters(avs_net_socket_stats_t *stats,
+                            const _avs_net_io_counters_t *counters) {
+    stats->syscalls += counters->syscalls;
+    stats->would_block += counters->would_block;
+    stats->polls += counters->polls;
+    stats->poll_wait_time = avs_time_duration_add(stats->poll_wait_time,
+                                                  counters->poll_wait_time);
+}
+
+void _avs_net_stats_record_io(avs_net_socket_stats_t *stats,
+                              const _avs_net_io_counters_t *counters) {
+    if (stats) {
+        add_io_counters(stats, counters);
+    }
+    if (g_stats_mutex && !avs_mutex_lock(g_stats_mutex)) {
+        add_io_counters(&g_stats, counters);
+        avs_mutex_unlock(g_stats_mutex);
+    }
+}
+
+void _avs_net_stats_record_handshake(avs_net_socket_stats_t *stats,
+                                     avs_time_duration_t duration) {
+    record_duration(stats, STATS_HANDSHAKE, duration);
+}
+
+static avs_time_monotonic_t stats_now(void) {
+    return avs_time_monotonic_now();
+}
+
+/**
+ * Records the duration of an operation on @p socket that started at
+ * @p started and finished with @p err , unless the operation is not
+ * supported - in that case, the fallback is expected to record it.
+ */
+static avs_error_t stats_record(avs_net_socket_t *socket,
+                                stats_histogram_t which,
+                                avs_time_monotonic_t started,
+                                avs_error_t err) {
+    if (!is_enotsup(err)) {
+        record_duration(socket->operations->get_stats
+                                ? socket->operations->get_stats(socket)
+                                : NULL,
+                        which,
+                        avs_time_monotonic_diff(avs_time_monotonic_now(),
+                                                started));
+    }
+    return err;
+}
+
+avs_error_t avs_net_socket_get_stats(avs_net_socket_t *socket,
+                                     avs_net_socket_stats_t *out_stats) {
+    avs_net_socket_stats_t *stats =
+            socket->operations->get_stats
+                    ? socket->operations->get_stats(socket)
+                    : NULL;
+    if (!stats) {
+        return avs_errno(AVS_ENOTSUP);
+    }
+    *out_stats = *stats;
+    return AVS_OK;
+}
+
+avs_error_t avs_net_get_global_stats(avs_net_socket_stats_t *out_stats) {
+    avs_error_t err = _avs_net_ensure_global_state();
+    if (avs_is_err(err)) {
+        return err;
+    }
+    if (avs_mutex_lock(g_stats_mutex)) {
+        return avs_errno(AVS_EBUSY);
+    }
+    *out_stats = g_stats;
+    avs_mutex_unlock(g_stats_mutex);
+    return AVS_OK;
+}
+
+avs_error_t avs_net_reset_global_stats(void) {
+    avs_error_t err = _avs_net_ensure_global_state();
+    if (avs_is_err(err)) {
+        return err;
+    }
+    if (avs_mutex_lock(g_stats_mutex)) {
+        return avs_errno(AVS_EBUSY);
+    }
+    memset(&g_stats, 0, sizeof(g_stats));
+    avs_mutex_unlock(g_stats_mutex);
+    return AVS_OK;
+}
+#    else  // AVS_COMMONS_NET_WITH_SOCKET_STATS
+static avs_time_monotonic_t stats_now(void) {
+    return AVS_TIME_MONOTONIC_INVALID;
+}
+
+static avs_error_t stats_record(avs_net_socket_t *socket,
+                                stats_histogram_t which,
+                                avs_time_monotonic_t started,
+                                avs_error_t err) {
+    (void) socket;
+    (void) which;
+    (void) started;
+    return err;
+}
+
+avs_error_t avs_net_socket_get_stats(avs_net_socket_t *socket,
+                                     avs_net_socket_stats_t *out_stats) {
+    (void) socket;
+    (void) out_stats;
+    return avs_errno(AVS_ENOTSUP);
+}
+
+avs_error_t avs_net_get_global_stats(avs_net_socket_stats_t *out_stats) {
+    (void) out_stats;
+    return avs_errno(AVS_ENOTSUP);
+}
+
+avs_error_t avs_net_reset_global_stats(void) {
+    return avs_errno(AVS_ENOTSUP);
+}
+#    endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
+
 avs_error_t avs_net_socket_connect(avs_net_socket_t *socket,
                                    const char *host,
                                    const char *port) {
@@ -131,13 +328,32 @@ avs_error_t avs_net_socket_decorate(avs_net_socket_t *socket,
     return socket->operations->decorate(socket, backend_socket);
 }
 
+avs_error_t avs_net_socket_decorate_async(avs_net_socket_t *socket,
+                                          avs_net_socket_t *backend_socket,
+                                          avs_net_handshake_pool_t *pool) {
+    if (!socket->operations->decorate_async) {
+        return avs_errno(AVS_ENOTSUP);
+    }
+    return socket->operations->decorate_async(socket, backend_socket, pool);
+}
+
+avs_error_t avs_net_socket_handshake_continue(avs_net_socket_t *socket) {
+    if (!socket->operations->handshake_continue) {
+        return avs_errno(AVS_ENOTSUP);
+    }
+    return socket->operations->handshake_continue(socket);
+}
+
 avs_error_t avs_net_socket_send(avs_net_socket_t *socket,
                                 const void *buffer,
                                 size_t buffer_length) {
     if (!socket->operations->send) {
         return avs_errno(AVS_ENOTSUP);
     }
-    return socket->operations->send(socket, buffer, buffer_length);
+    const avs_time_monotonic_t started = stats_now();
+    return stats_record(socket, STATS_SEND, started,
+                        socket->operations->send(socket, buffer,
+                                                 buffer_length));
 }
 
 avs_error_t avs_net_socket_send_to(avs_net_socket_t *socket,
@@ -148,8 +364,11 @@ avs_error_t avs_net_socket_send_to(avs_net_socket_t *socket,
     if (!socket->operations->send_to) {
         return avs_errno(AVS_ENOTSUP);
     }
-    return socket->operations->send_to(socket, buffer, buffer_length, host,
-                                       port);
+    const avs_time_monotonic_t started = stats_now();
+    return stats_record(socket, STATS_SEND, started,
+                        socket->operations->send_to(socket, buffer,
+                                                    buffer_length, host,
+                                                    port));
 }
 
 avs_error_t avs_net_socket_receive(avs_net_socket_t *socket,
@@ -159,8 +378,10 @@ avs_error_t avs_net_socket_receive(avs_net_socket_t *socket,
     if (!socket->operations->receive) {
         return avs_errno(AVS_ENOTSUP);
     }
-    return socket->operations->receive(socket, out_bytes_received, buffer,
-                                       buffer_length);
+    const avs_time_monotonic_t started = stats_now();
+    return stats_record(socket, STATS_RECEIVE, started,
+                        socket->operations->receive(socket, out_bytes_received,
+                                                    buffer, buffer_length));
 }
 
 avs_error_t avs_net_socket_receive_from(avs_net_socket_t *socket,
@@ -174,9 +395,353 @@ avs_error_t avs_net_socket_receive_from(avs_net_socket_t *socket,
     if (!socket->operations->receive_from) {
         return avs_errno(AVS_ENOTSUP);
     }
-    return socket->operations->receive_from(socket, out_bytes_received, buffer,
-                                            buffer_length, host, host_size,
-                                            port, port_size);
+    const avs_time_monotonic_t started = stats_now();
+    return stats_record(socket, STATS_RECEIVE, started,
+                        socket->operations->receive_from(
+                                socket, out_bytes_received, buffer,
+                                buffer_length, host, host_size, port,
+                                port_size));
+}
+
+static avs_error_t
+send_batch_fallback(avs_net_socket_t *socket,
+                    const avs_net_socket_outgoing_datagram_t *datagrams,
+                    size_t count,
+                    size_t *out_sent) {
+    avs_error_t err = AVS_OK;
+    size_t sent;
+    for (sent = 0; sent < count; ++sent) {
+        const avs_net_socket_outgoing_datagram_t *datagram = &datagrams[sent];
+        if (datagram->host) {
+            err = avs_net_socket_send_to(socket, datagram->data,
+                                         datagram->data_length, datagram->host,
+                                         datagram->port);
+        } else {
+            err = avs_net_socket_send(socket, datagram->data,
+                                      datagram->data_length);
+        }
+        if (avs_is_err(err)) {
+            break;
+        }
+    }
+    if (out_sent) {
+        *out_sent = sent;
+    }
+    return err;
+}
+
+avs_error_t
+avs_net_socket_send_batch(avs_net_socket_t *socket,
+                          const avs_net_socket_outgoing_datagram_t *datagrams,
+                          size_t count,
+                          size_t *out_sent) {
+    if (socket->operations->send_batch) {
+        const avs_time_monotonic_t started = stats_now();
+        avs_error_t err = stats_record(
+                socket, STATS_SEND, started,
+                socket->operations->send_batch(socket, datagrams, count,
+                                               out_sent));
+        if (!is_enotsup(err)) {
+            return err;
+        }
+    }
+    return send_batch_fallback(socket, datagrams, count, out_sent);
+}
+
+static avs_error_t
+receive_single_datagram(avs_net_socket_t *socket,
+                        avs_net_socket_received_datagram_t *datagram) {
+    avs_error_t err;
+    if (datagram->host || datagram->port) {
+        char host[NET_MAX_HOSTNAME_SIZE];
+        char port[NET_PORT_SIZE];
+        err = avs_net_socket_receive_from(
+                socket, &datagram->bytes_received, datagram->buffer,
+                datagram->buffer_length, datagram->host ? datagram->host : host,
+                datagram->host ? datagram->host_size : sizeof(host),
+                datagram->port ? datagram->port : port,
+                datagram->port ? datagram->port_size : sizeof(port));
+    } else {
+        err = avs_net_socket_receive(socket, &datagram->bytes_received,
+                                     datagram->buffer, datagram->buffer_length);
+    }
+    datagram->truncated =
+            (err.category == AVS_ERRNO_CATEGORY && err.code == AVS_EMSGSIZE);
+    return datagram->truncated ? AVS_OK : err;
+}
+
+static avs_error_t
+receive_batch_fallback(avs_net_socket_t *socket,
+                       avs_net_socket_received_datagram_t *datagrams,
+                       size_t count,
+                       size_t *out_received) {
+    avs_error_t err = receive_single_datagram(socket, &datagrams[0]);
+    if (avs_is_err(err)) {
+        return err;
+    }
+    *out_received = 1;
+
+    // receive whatever else is available without waiting
+    avs_net_socket_opt_value_t recv_timeout;
+    avs_net_socket_opt_value_t no_wait;
+    no_wait.recv_timeout = AVS_TIME_DURATION_ZERO;
+    if (count > 1
+            && avs_is_ok(avs_net_socket_get_opt(socket,
+                                                AVS_NET_SOCKET_OPT_RECV_TIMEOUT,
+                                                &recv_timeout))
+            && avs_is_ok(avs_net_socket_set_opt(
+                       socket, AVS_NET_SOCKET_OPT_RECV_TIMEOUT, no_wait))) {
+        while (*out_received < count
+               && avs_is_ok(receive_single_datagram(
+                          socket, &datagrams[*out_received]))) {
+            ++*out_received;
+        }
+        avs_net_socket_set_opt(socket, AVS_NET_SOCKET_OPT_RECV_TIMEOUT,
+                               recv_timeout);
+    }
+    return AVS_OK;
+}
+
+avs_error_t
+avs_net_socket_receive_batch(avs_net_socket_t *socket,
+                             avs_net_socket_received_datagram_t *datagrams,
+                             size_t count,
+                             size_t *out_received) {
+    *out_received = 0;
+    if (!count) {
+        return avs_errno(AVS_EINVAL);
+    }
+    if (socket->operations->receive_batch) {
+        const avs_time_monotonic_t started = stats_now();
+        avs_error_t err = stats_record(
+                socket, STATS_RECEIVE, started,
+                socket->operations->receive_batch(socket, datagrams, count,
+                                                  out_received));
+        if (!is_enotsup(err)) {
+            return err;
+        }
+    }
+    return receive_batch_fallback(socket, datagrams, count, out_received);
+}
+
+static avs_error_t send_segmented_fallback(avs_net_socket_t *socket,
+                                           const char *buffer,
+                                           size_t length,
+                                           size_t segment_size) {
+    avs_net_socket_outgoing_datagram_t datagrams[32];
+    size_t offset = 0;
+    do {
+        size_t count = 0;
+        while (count < AVS_ARRAY_SIZE(datagrams)
+               && (offset < length || (!length && !count))) {
+            datagrams[count].data = buffer + offset;
+            datagrams[count].data_length = AVS_MIN(length - offset,
+                                                   segment_size);
+            datagrams[count].host = NULL;
+            datagrams[count].port = NULL;
+            offset += datagrams[count].data_length;
+            ++count;
+        }
+        avs_error_t err =
+                avs_net_socket_send_batch(socket, datagrams, count, NULL);
+        if (avs_is_err(err)) {
+            return err;
+        }
+    } while (offset < length);
+    return AVS_OK;
+}
+
+avs_error_t avs_net_socket_send_segmented(avs_net_socket_t *socket,
+                                          const void *buffer,
+                                          size_t length,
+                                          size_t segment_size) {
+    if (!segment_size) {
+        avs_net_socket_opt_value_t inner_mtu;
+        avs_error_t err =
+                avs_net_socket_get_opt(socket, AVS_NET_SOCKET_OPT_INNER_MTU,
+                                       &inner_mtu);
+        if (avs_is_err(err)) {
+            return err;
+        }
+        if (inner_mtu.mtu <= 0) {
+            return avs_errno(AVS_EINVAL);
+        }
+        segment_size = (size_t) inner_mtu.mtu;
+    }
+    if (socket->operations->send_segmented) {
+        const avs_time_monotonic_t started = stats_now();
+        avs_error_t err = stats_record(
+                socket, STATS_SEND, started,
+                socket->operations->send_segmented(socket, buffer, length,
+                                                   segment_size));
+        if (!is_enotsup(err)) {
+            return err;
+        }
+    }
+    return send_segmented_fallback(socket, (const char *) buffer, length,
+                                   segment_size);
+}
+
+avs_error_t avs_net_socket_receive_segmented(avs_net_socket_t *socket,
+                                             size_t *out_bytes_received,
+                                             void *buffer,
+                                             size_t buffer_length,
+                                             size_t *out_segment_size) {
+    if (socket->operations->receive_segmented) {
+        const avs_time_monotonic_t started = stats_now();
+        avs_error_t err = stats_record(
+                socket, STATS_RECEIVE, started,
+                socket->operations->receive_segmented(
+                        socket, out_bytes_received, buffer, buffer_length,
+                        out_segment_size));
+        if (!is_enotsup(err)) {
+            return err;
+        }
+    }
+    avs_error_t err = avs_net_socket_receive(socket, out_bytes_received,
+                                             buffer, buffer_length);
+    *out_segment_size = *out_bytes_received;
+    return err;
+}
+
+#    ifdef AVS_COMMONS_STREAM_WITH_FILE
+avs_error_t avs_net_socket_send_file(avs_net_socket_t *socket,
+                                     FILE *file,
+                                     size_t length,
+                                     size_t *out_bytes_sent) {
+    size_t bytes_sent;
+    if (!out_bytes_sent) {
+        out_bytes_sent = &bytes_sent;
+    }
+    *out_bytes_sent = 0;
+    if (!socket->operations->send_file) {
+        return avs_errno(AVS_ENOTSUP);
+    }
+    const avs_time_monotonic_t started = stats_now();
+    return stats_record(socket, STATS_SEND, started,
+                        socket->operations->send_file(socket, file, length,
+                                                      out_bytes_sent));
+}
+#    endif // AVS_COMMONS_STREAM_WITH_FILE
+
+static bool is_stream_socket(avs_net_socket_t *socket) {
+    avs_net_socket_opt_value_t datagram;
+    return avs_is_ok(avs_net_socket_get_opt(socket, AVS_NET_SOCKET_OPT_DATAGRAM,
+                                            &datagram))
+           && !datagram.flag;
+}
+
+static avs_error_t
+sendv_separately(avs_net_socket_t *socket,
+                 const avs_net_socket_outgoing_buffer_t *buffers,
+                 size_t count) {
+    bool sent_anything = false;
+    for (size_t i = 0; i < count; ++i) {
+        if (buffers[i].data_length) {
+            avs_error_t err = avs_net_socket_send(socket, buffers[i].data,
+                                                  buffers[i].data_length);
+            if (avs_is_err(err)) {
+                return err;
+            }
+            sent_anything = true;
+        }
+    }
+    if (!sent_anything) {
+        return avs_net_socket_send(socket, count ? buffers[0].data : NULL, 0);
+    }
+    return AVS_OK;
+}
+
+static avs_error_t
+sendv_coalesced(avs_net_socket_t *socket,
+                const avs_net_socket_outgoing_buffer_t *buffers,
+                size_t count) {
+    size_t total_length = 0;
+    size_t nonempty_count = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (buffers[i].data_length) {
+            if (buffers[i].data_length > SIZE_MAX - total_length) {
+                return avs_errno(AVS_EMSGSIZE);
+            }
+            total_length += buffers[i].data_length;
+            ++nonempty_count;
+        }
+    }
+    if (nonempty_count <= 1) {
+        // at most one buffer to send, no need to copy anything
+        return sendv_separately(socket, buffers, count);
+    }
+    char *datagram = (char *) avs_malloc(total_length);
+    if (!datagram) {
+        LOG(ERROR, _("out of memory"));
+        return avs_errno(AVS_ENOMEM);
+    }
+    size_t offset = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (buffers[i].data_length) {
+            memcpy(datagram + offset, buffers[i].data, buffers[i].data_length);
+            offset += buffers[i].data_length;
+        }
+    }
+    avs_error_t err = avs_net_socket_send(socket, datagram, total_length);
+    avs_free(datagram);
+    return err;
+}
+
+static avs_error_t
+sendv_fallback(avs_net_socket_t *socket,
+               const avs_net_socket_outgoing_buffer_t *buffers,
+               size_t count) {
+    // message boundaries need to be preserved for datagram sockets, so unless
+    // the socket is known to be a stream one, the buffers are sent together
+    if (is_stream_socket(socket)) {
+        return sendv_separately(socket, buffers, count);
+    } else {
+        return sendv_coalesced(socket, buffers, count);
+    }
+}
+
+avs_error_t
+avs_net_socket_sendv(avs_net_socket_t *socket,
+                     const avs_net_socket_outgoing_buffer_t *buffers,
+                     size_t count) {
+    if (socket->operations->sendv) {
+        const avs_time_monotonic_t started = stats_now();
+        avs_error_t err =
+                stats_record(socket, STATS_SEND, started,
+                             socket->operations->sendv(socket, buffers, count));
+        if (!is_enotsup(err)) {
+            return err;
+        }
+    }
+    return sendv_fallback(socket, buffers, count);
+}
+
+avs_error_t
+avs_net_socket_receivev(avs_net_socket_t *socket,
+                        size_t *out_bytes_received,
+                        const avs_net_socket_incoming_buffer_t *buffers,
+                        size_t count) {
+    *out_bytes_received = 0;
+    if (!count) {
+        return avs_errno(AVS_EINVAL);
+    }
+    if (socket->operations->receivev) {
+        const avs_time_monotonic_t started = stats_now();
+        avs_error_t err = stats_record(
+                socket, STATS_RECEIVE, started,
+                socket->operations->receivev(socket, out_bytes_received,
+                                             buffers, count));
+        if (!is_enotsup(err)) {
+            return err;
+        }
+    }
+    size_t i = 0;
+    while (i < count - 1 && !buffers[i].buffer_length) {
+        ++i;
+    }
+    return avs_net_socket_receive(socket, out_bytes_received, buffers[i].buffer,
+                                  buffers[i].buffer_length);
 }
 
 avs_error_t avs_net_socket_bind(avs_net_socket_t *socket,
@@ -188,6 +753,40 @@ avs_error_t avs_net_socket_bind(avs_net_socket_t *socket,
     return socket->operations->bind(socket, address, port);
 }
 
+avs_error_t avs_net_socket_bind_shards(avs_net_socket_t *const *shards,
+                                       size_t count,
+                                       const char *address,
+                                       const char *port) {
+    if (!count) {
+        return avs_errno(AVS_EINVAL);
+    }
+    // the first shard determines the actual port, in case an ephemeral one
+    // has been requested
+    avs_error_t err = avs_net_socket_bind(shards[0], address, port);
+    if (avs_is_err(err)) {
+        return err;
+    }
+    size_t bound = 1;
+    char bound_port[NET_PORT_SIZE];
+    if (avs_is_ok((err = avs_net_socket_get_local_port(
+                           shards[0], bound_port, sizeof(bound_port))))) {
+        for (; bound < count; ++bound) {
+            if (avs_is_err((err = avs_net_socket_bind(shards[bound], address,
+                                                      bound_port)))) {
+                LOG(ERROR, _("could not bind shard ") "%u" _(" of ") "%u",
+                    (unsigned) bound, (unsigned) count);
+                break;
+            }
+        }
+    }
+    if (avs_is_err(err)) {
+        while (bound--) {
+            avs_net_socket_close(shards[bound]);
+        }
+    }
+    return err;
+}
+
 avs_error_t avs_net_socket_accept(avs_net_socket_t *server_socket,
                                   avs_net_socket_t *client_socket) {
     if (!server_socket->operations->accept) {
@@ -366,6 +965,22 @@ static void debug_init(void) {
     }
 }
 
+static avs_net_socket_t *debug_backend(avs_net_socket_t *debug_socket) {
+    return ((avs_net_socket_debug_t *) debug_socket)->socket;
+}
+
+/**
+ * Calls an I/O operation of the backend socket directly, instead of through
+ * the public API. Statistics are then recorded, and fallbacks for unsupported
+ * operations applied, only once - by the public API called on the debug
+ * socket itself.
+ */
+#        define DEBUG_FORWARD(DebugSocket, Op, ...)                         \
+            (debug_backend(DebugSocket)->operations->Op                   \
+                     ? debug_backend(DebugSocket)->operations->Op(        \
+                               debug_backend(DebugSocket), __VA_ARGS__)   \
+                     : avs_errno(AVS_ENOTSUP))
+
 static avs_error_t connect_debug(avs_net_socket_t *debug_socket,
                                  const char *host,
                                  const char *port) {
@@ -394,9 +1009,7 @@ static avs_error_t decorate_debug(avs_net_socket_t *debug_socket,
 static avs_error_t send_debug(avs_net_socket_t *debug_socket,
                               const void *buffer,
                               size_t buffer_length) {
-    avs_error_t err = avs_net_socket_send(
-            ((avs_net_socket_debug_t *) debug_socket)->socket, buffer,
-            buffer_length);
+    avs_error_t err = DEBUG_FORWARD(debug_socket, send, buffer, buffer_length);
     if (avs_is_ok(err)) {
         fprintf(communication_log, "\n----------SEND----------\n");
         fwrite(buffer, 1, buffer_length, communication_log);
@@ -413,9 +1026,8 @@ static avs_error_t send_to_debug(avs_net_socket_t *debug_socket,
                                  size_t buffer_length,
                                  const char *host,
                                  const char *port) {
-    avs_error_t err = avs_net_socket_send_to(
-            ((avs_net_socket_debug_t *) debug_socket)->socket, buffer,
-            buffer_length, host, port);
+    avs_error_t err = DEBUG_FORWARD(debug_socket, send_to, buffer,
+                                    buffer_length, host, port);
     if (avs_is_ok(err)) {
         fprintf(communication_log, "\n--------SEND-TO---------\n");
         fprintf(communication_log, "%s:%s\n", host, port);
@@ -433,9 +1045,8 @@ static avs_error_t receive_debug(avs_net_socket_t *debug_socket,
                                  size_t *out_bytes_received,
                                  void *buffer,
                                  size_t buffer_length) {
-    avs_error_t err = avs_net_socket_receive(
-            ((avs_net_socket_debug_t *) debug_socket)->socket,
-            out_bytes_received, buffer, buffer_length);
+    avs_error_t err = DEBUG_FORWARD(debug_socket, receive, out_bytes_received,
+                                    buffer, buffer_length);
     if (avs_is_ok(err)) {
         fprintf(communication_log, "\n----------RECV----------\n");
         fwrite(buffer, 1, (size_t) *out_bytes_received, communication_log);
@@ -455,10 +1066,9 @@ static avs_error_t receive_from_debug(avs_net_socket_t *debug_socket,
                                       size_t host_size,
                                       char *port,
                                       size_t port_size) {
-    avs_error_t err = avs_net_socket_receive_from(
-            ((avs_net_socket_debug_t *) debug_socket)->socket,
-            out_bytes_received, buffer, buffer_length, host, host_size, port,
-            port_size);
+    avs_error_t err = DEBUG_FORWARD(debug_socket, receive_from,
+                                    out_bytes_received, buffer, buffer_length,
+                                    host, host_size, port, port_size);
     if (avs_is_ok(err)) {
         fprintf(communication_log, "\n--------RECV-FROM--------\n");
         fprintf(communication_log, "%s:%s\n", host, port);
@@ -645,14 +1255,223 @@ static avs_error_t cleanup_debug(avs_net_socket_t **debug_socket) {
     return err;
 }
 
+static avs_error_t
+send_batch_debug(avs_net_socket_t *debug_socket,
+                 const avs_net_socket_outgoing_datagram_t *datagrams,
+                 size_t count,
+                 size_t *out_sent) {
+    avs_error_t err =
+            DEBUG_FORWARD(debug_socket, send_batch, datagrams, count, out_sent);
+    if (avs_is_ok(err)) {
+        fprintf(communication_log, "\n-------SEND-BATCH-------\n");
+        for (size_t i = 0; i < count; ++i) {
+            fwrite(datagrams[i].data, 1, datagrams[i].data_length,
+                   communication_log);
+            fprintf(communication_log, "\n------------------------\n");
+        }
+        fprintf(communication_log, "------SEND-BATCH-END----\n");
+        fflush(communication_log);
+    } else if (!is_enotsup(err)) {
+        fprintf(communication_log, "\n---SEND-BATCH-FAILURE---\n");
+    }
+    return err;
+}
+
+static avs_error_t
+receive_batch_debug(avs_net_socket_t *debug_socket,
+                    avs_net_socket_received_datagram_t *datagrams,
+                    size_t count,
+                    size_t *out_received) {
+    avs_error_t err = DEBUG_FORWARD(debug_socket, receive_batch, datagrams,
+                                    count, out_received);
+    if (avs_is_ok(err)) {
+        fprintf(communication_log, "\n-------RECV-BATCH-------\n");
+        for (size_t i = 0; i < *out_received; ++i) {
+            fwrite(datagrams[i].buffer, 1, datagrams[i].bytes_received,
+                   communication_log);
+            fprintf(communication_log, "\n------------------------\n");
+        }
+        fprintf(communication_log, "------RECV-BATCH-END----\n");
+        fflush(communication_log);
+    } else if (!is_enotsup(err)) {
+        fprintf(communication_log, "\n---RECV-BATCH-FAILURE---\n");
+    }
+    return err;
+}
+
+static avs_error_t send_segmented_debug(avs_net_socket_t *debug_socket,
+                                        const void *buffer,
+                                        size_t length,
+                                        size_t segment_size) {
+    avs_error_t err = DEBUG_FORWARD(debug_socket, send_segmented, buffer,
+                                    length, segment_size);
+    if (avs_is_ok(err)) {
+        fprintf(communication_log, "\n-----SEND-SEGMENTED-----\n");
+        fprintf(communication_log, "segment size: %lu\n",
+                (unsigned long) segment_size);
+        fprintf(communication_log, "------------------------\n");
+        fwrite(buffer, 1, length, communication_log);
+        fprintf(communication_log, "\n--------SEND-END--------\n");
+        fflush(communication_log);
+    } else if (!is_enotsup(err)) {
+        fprintf(communication_log, "\n-SEND-SEGMENTED-FAILURE-\n");
+    }
+    return err;
+}
+
+static avs_error_t receive_segmented_debug(avs_net_socket_t *debug_socket,
+                                           size_t *out_bytes_received,
+                                           void *buffer,
+                                           size_t buffer_length,
+                                           size_t *out_segment_size) {
+    avs_error_t err = DEBUG_FORWARD(debug_socket, receive_segmented,
+                                    out_bytes_received, buffer, buffer_length,
+                                    out_segment_size);
+    if (avs_is_ok(err)) {
+        fprintf(communication_log, "\n-----RECV-SEGMENTED-----\n");
+        fprintf(communication_log, "segment size: %lu\n",
+                (unsigned long) *out_segment_size);
+        fprintf(communication_log, "------------------------\n");
+        fwrite(buffer, 1, *out_bytes_received, communication_log);
+        fprintf(communication_log, "\n--------RECV-END--------\n");
+        fflush(communication_log);
+    } else if (!is_enotsup(err)) {
+        fprintf(communication_log, "\n-RECV-SEGMENTED-FAILURE-\n");
+    }
+    return err;
+}
+
+#        ifdef AVS_COMMONS_STREAM_WITH_FILE
+static avs_error_t send_file_debug(avs_net_socket_t *debug_socket,
+                                   FILE *file,
+                                   size_t length,
+                                   size_t *out_bytes_sent) {
+    avs_error_t err = DEBUG_FORWARD(debug_socket, send_file, file, length,
+                                    out_bytes_sent);
+    if (avs_is_ok(err)) {
+        fprintf(communication_log, "Sent %lu bytes from file\n",
+                (unsigned long) *out_bytes_sent);
+    } else if (!is_enotsup(err)) {
+        fprintf(communication_log, "Sending file failed after %lu bytes\n",
+                (unsigned long) *out_bytes_sent);
+    }
+    return err;
+}
+#        endif // AVS_COMMONS_STREAM_WITH_FILE
+
+static avs_error_t sendv_debug(avs_net_socket_t *debug_socket,
+                               const avs_net_socket_outgoing_buffer_t *buffers,
+                               size_t count) {
+    avs_error_t err = DEBUG_FORWARD(debug_socket, sendv, buffers, count);
+    if (avs_is_ok(err)) {
+        fprintf(communication_log, "\n----------SENDV---------\n");
+        for (size_t i = 0; i < count; ++i) {
+            fwrite(buffers[i].data, 1, buffers[i].data_length,
+                   communication_log);
+        }
+        fprintf(communication_log, "\n--------SEND-END--------\n");
+        fflush(communication_log);
+    } else if (!is_enotsup(err)) {
+        fprintf(communication_log, "\n------SENDV-FAILURE-----\n");
+    }
+    return err;
+}
+
+static avs_error_t
+receivev_debug(avs_net_socket_t *debug_socket,
+               size_t *out_bytes_received,
+               const avs_net_socket_incoming_buffer_t *buffers,
+               size_t count) {
+    avs_error_t err = DEBUG_FORWARD(debug_socket, receivev, out_bytes_received,
+                                    buffers, count);
+    if (avs_is_ok(err)) {
+        fprintf(communication_log, "\n---------RECVV----------\n");
+        size_t remaining = *out_bytes_received;
+        for (size_t i = 0; i < count && remaining; ++i) {
+            size_t chunk = AVS_MIN(remaining, buffers[i].buffer_length);
+            fwrite(buffers[i].buffer, 1, chunk, communication_log);
+            remaining -= chunk;
+        }
+        fprintf(communication_log, "\n--------RECV-END--------\n");
+        fflush(communication_log);
+    } else if (!is_enotsup(err)) {
+        fprintf(communication_log, "\n------RECVV-FAILURE-----\n");
+    }
+    return err;
+}
+
+static avs_net_socket_stats_t *get_stats_debug(avs_net_socket_t *debug_socket) {
+    avs_net_socket_t *backend = debug_backend(debug_socket);
+    return backend->operations->get_stats
+                   ? backend->operations->get_stats(backend)
+                   : NULL;
+}
+
+static void log_handshake_result(avs_error_t err) {
+    if (avs_is_ok(err)) {
+        fprintf(communication_log, "Handshake finished\n");
+    } else if (err.category == AVS_ERRNO_CATEGORY
+               && (err.code == AVS_EAGAIN || err.code == AVS_EINPROGRESS)) {
+        fprintf(communication_log, "Handshake in progress\n");
+    } else {
+        fprintf(communication_log, "Handshake failed\n");
+    }
+}
+
+/**
+ * NOTE: The handshake steps are submitted to @p pool by the backend socket,
+ * so it is the backend socket that is reported by
+ * avs_net_handshake_pool_get_completed().
+ */
+static avs_error_t decorate_async_debug(avs_net_socket_t *debug_socket,
+                                        avs_net_socket_t *backend_socket,
+                                        avs_net_handshake_pool_t *pool) {
+    avs_error_t err = avs_net_socket_decorate_async(
+            debug_backend(debug_socket), backend_socket, pool);
+    log_handshake_result(err);
+    return err;
+}
+
+static avs_error_t handshake_continue_debug(avs_net_socket_t *debug_socket) {
+    avs_error_t err =
+            avs_net_socket_handshake_continue(debug_backend(debug_socket));
+    log_handshake_result(err);
+    return err;
+}
+
 static const avs_net_socket_v_table_t debug_vtable = {
-    connect_debug,        decorate_debug,    send_debug,
-    send_to_debug,        receive_debug,     receive_from_debug,
-    bind_debug,           accept_debug,      close_debug,
-    shutdown_debug,       cleanup_debug,     system_socket_debug,
-    interface_name_debug, remote_host_debug, remote_hostname_debug,
-    remote_port_debug,    local_host_debug,  local_port_debug,
-    get_opt_debug,        set_opt_debug
+    .connect = connect_debug,
+    .decorate = decorate_debug,
+    .send = send_debug,
+    .send_to = send_to_debug,
+    .receive = receive_debug,
+    .receive_from = receive_from_debug,
+    .bind = bind_debug,
+    .accept = accept_debug,
+    .close = close_debug,
+    .shutdown = shutdown_debug,
+    .cleanup = cleanup_debug,
+    .get_system_socket = system_socket_debug,
+    .get_interface_name = interface_name_debug,
+    .get_remote_host = remote_host_debug,
+    .get_remote_hostname = remote_hostname_debug,
+    .get_remote_port = remote_port_debug,
+    .get_local_host = local_host_debug,
+    .get_local_port = local_port_debug,
+    .get_opt = get_opt_debug,
+    .set_opt = set_opt_debug,
+    .send_batch = send_batch_debug,
+    .receive_batch = receive_batch_debug,
+    .send_segmented = send_segmented_debug,
+    .receive_segmented = receive_segmented_debug,
+#        ifdef AVS_COMMONS_STREAM_WITH_FILE
+    .send_file = send_file_debug,
+#        endif // AVS_COMMONS_STREAM_WITH_FILE
+    .sendv = sendv_debug,
+    .receivev = receivev_debug,
+    .get_stats = get_stats_debug,
+    .decorate_async = decorate_async_debug,
+    .handshake_continue = handshake_continue_debug
 };
 
 static avs_error_t create_socket_debug(avs_net_socket_t **debug_socket,
@@ -719,7 +1538,7 @@ avs_error_t
 avs_net_dtls_socket_create(avs_net_socket_t **socket,
                            const avs_net_ssl_configuration_t *config) {
 #        ifndef AVS_COMMONS_WITHOUT_TLS
-    if (!config->prng_ctx) {
+    if (!config->prng_ctx && !config->context) {
         LOG(ERROR, _("PRNG ctx MUST NOT be NULL"));
         return avs_errno(AVS_EINVAL);
     }
@@ -738,7 +1557,7 @@ avs_error_t
 avs_net_ssl_socket_create(avs_net_socket_t **socket,
                           const avs_net_ssl_configuration_t *config) {
 #        ifndef AVS_COMMONS_WITHOUT_TLS
-    if (!config->prng_ctx) {
+    if (!config->prng_ctx && !config->context) {
         LOG(ERROR, _("PRNG ctx MUST NOT be NULL"));
         return avs_errno(AVS_EINVAL);
     }
@@ -752,6 +1571,106 @@ avs_net_ssl_socket_create(avs_net_socket_t **socket,
     return avs_errno(AVS_ENOTSUP);
 #        endif // AVS_COMMONS_WITHOUT_TLS
 }
+
+#        ifndef AVS_COMMONS_WITHOUT_TLS
+typedef avs_error_t (*ssl_context_constructor_t)(
+        avs_net_ssl_context_t **out_context,
+        const avs_net_ssl_configuration_t *configuration);
+
+static avs_error_t
+create_ssl_context(avs_net_ssl_context_t **out_context,
+                   ssl_context_constructor_t constructor,
+                   const avs_net_ssl_configuration_t *config) {
+    if (!out_context || *out_context || !config) {
+        return avs_errno(AVS_EINVAL);
+    }
+    if (!config->prng_ctx) {
+        LOG(ERROR, _("PRNG ctx MUST NOT be NULL"));
+        return avs_errno(AVS_EINVAL);
+    }
+    avs_error_t err = _avs_net_ensure_global_state();
+    if (avs_is_err(err)) {
+        LOG(ERROR, _("avs_net global state initialization error"));
+        return err;
+    }
+    return constructor(out_context, config);
+}
+#        endif // AVS_COMMONS_WITHOUT_TLS
+
+avs_error_t
+avs_net_ssl_context_create(avs_net_ssl_context_t **out_context,
+                           const avs_net_ssl_configuration_t *config) {
+#        ifndef AVS_COMMONS_WITHOUT_TLS
+    return create_ssl_context(out_context, _avs_net_create_ssl_context, config);
+#        else  // AVS_COMMONS_WITHOUT_TLS
+    (void) out_context;
+    (void) config;
+    LOG(ERROR, _("could not create secure context: (D)TLS support is ")
+                       _("disabled"));
+    return avs_errno(AVS_ENOTSUP);
+#        endif // AVS_COMMONS_WITHOUT_TLS
+}
+
+avs_error_t
+avs_net_dtls_context_create(avs_net_ssl_context_t **out_context,
+                            const avs_net_ssl_configuration_t *config) {
+#        ifndef AVS_COMMONS_WITHOUT_TLS
+    return create_ssl_context(out_context, _avs_net_create_dtls_context,
+                              config);
+#        else  // AVS_COMMONS_WITHOUT_TLS
+    (void) out_context;
+    (void) config;
+    LOG(ERROR, _("could not create secure context: (D)TLS support is ")
+                       _("disabled"));
+    return avs_errno(AVS_ENOTSUP);
+#        endif // AVS_COMMONS_WITHOUT_TLS
+}
+
+void avs_net_ssl_context_cleanup(avs_net_ssl_context_t **context) {
+#        ifndef AVS_COMMONS_WITHOUT_TLS
+    _avs_net_release_ssl_context(context);
+#        else  // AVS_COMMONS_WITHOUT_TLS
+    (void) context;
+#        endif // AVS_COMMONS_WITHOUT_TLS
+}
+
+avs_error_t avs_net_ssl_context_get_server_session_stats(
+        avs_net_ssl_context_t *context,
+        avs_net_ssl_server_session_stats_t *out_stats) {
+#        ifndef AVS_COMMONS_WITHOUT_TLS
+    if (!context || !out_stats) {
+        return avs_errno(AVS_EINVAL);
+    }
+    return _avs_net_ssl_context_get_server_session_stats(context, out_stats);
+#        else  // AVS_COMMONS_WITHOUT_TLS
+    (void) context;
+    (void) out_stats;
+    return avs_errno(AVS_ENOTSUP);
+#        endif // AVS_COMMONS_WITHOUT_TLS
+}
+
+#        ifdef AVS_COMMONS_WITH_AVS_PERSISTENCE
+avs_error_t
+avs_net_ssl_context_session_cache_persistence(avs_persistence_context_t *ctx,
+                                              avs_net_ssl_context_t *context) {
+#            if defined(AVS_COMMONS_NET_WITH_TLS_SESSION_CACHE) \
+                    && !defined(AVS_COMMONS_WITHOUT_TLS)
+    _avs_net_session_cache_t *cache =
+            context ? _avs_net_ssl_context_session_cache(context) : NULL;
+    if (!ctx || !cache) {
+        return avs_errno(AVS_EINVAL);
+    }
+    return _avs_net_session_cache_persistence(ctx, cache);
+#            else  // defined(AVS_COMMONS_NET_WITH_TLS_SESSION_CACHE) &&
+                   // !defined(AVS_COMMONS_WITHOUT_TLS)
+    (void) ctx;
+    (void) context;
+    LOG(ERROR, _("session cache support is disabled"));
+    return avs_errno(AVS_ENOTSUP);
+#            endif // defined(AVS_COMMONS_NET_WITH_TLS_SESSION_CACHE) &&
+                   // !defined(AVS_COMMONS_WITHOUT_TLS)
+}
+#        endif // AVS_COMMONS_WITH_AVS_PERSISTENCE
 #    endif // AVS_COMMONS_WITH_AVS_CRYPTO
 
 #endif // AVS_COMMONS_WITH_AVS_NET
@@ -39,10 +39,18 @@ static int initialize_global(void *err_ptr_) {
             _avs_net_cleanup_global_compat_state();
         }
     }
+    if (avs_is_ok(*err_ptr)) {
+        *err_ptr = _avs_net_initialize_global_stats_state();
+        if (avs_is_err(*err_ptr)) {
+            _avs_net_cleanup_global_ssl_state();
+            _avs_net_cleanup_global_compat_state();
+        }
+    }
     return avs_is_ok(*err_ptr) ? 0 : -1;
 }
 
 void _avs_net_cleanup_global_state(void) {
+    _avs_net_cleanup_global_stats_state();
     _avs_net_cleanup_global_ssl_state();
     _avs_net_cleanup_global_compat_state();
     g_net_init_handle = NULL;
@@ -34,6 +34,15 @@ void _avs_net_cleanup_global_ssl_state(void);
 #    define _avs_net_cleanup_global_ssl_state(...) ((void) 0)
 #endif // AVS_COMMONS_WITHOUT_TLS
 
+#ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+avs_error_t _avs_net_initialize_global_stats_state(void);
+
+void _avs_net_cleanup_global_stats_state(void);
+#else // AVS_COMMONS_NET_WITH_SOCKET_STATS
+#    define _avs_net_initialize_global_stats_state(...) AVS_OK
+#    define _avs_net_cleanup_global_stats_state(...) ((void) 0)
+#endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
+
 avs_error_t _avs_net_ensure_global_state(void);
 void _avs_net_cleanup_global_state(void);
 
@@ -0,0 +1,434 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avs_commons_init.h>
+
+#if defined(AVS_COMMONS_WITH_AVS_NET) \
+        && defined(AVS_COMMONS_NET_WITH_HANDSHAKE_POOL)
+
+#    include <assert.h>
+#    include <string.h>
+
+#    include <avsystem/commons/avs_condvar.h>
+#    include <avsystem/commons/avs_list.h>
+#    include <avsystem/commons/avs_memory.h>
+#    include <avsystem/commons/avs_mutex.h>
+#    include <avsystem/commons/avs_net_handshake_pool.h>
+
+#    include "avs_net_impl.h"
+
+#    ifdef AVS_UNIT_TESTING
+#        include "tests/net/handshake_pool_mocks.h"
+#    endif // AVS_UNIT_TESTING
+
+VISIBILITY_SOURCE_BEGIN
+
+#    ifdef AVS_COMMONS_NET_WITH_IPV4
+#        define NOTIFIER_ADDRESS "127.0.0.1"
+#        define NOTIFIER_FAMILY AVS_NET_AF_INET4
+#    else // AVS_COMMONS_NET_WITH_IPV4
+#        define NOTIFIER_ADDRESS "::1"
+#        define NOTIFIER_FAMILY AVS_NET_AF_INET6
+#    endif // AVS_COMMONS_NET_WITH_IPV4
+
+typedef enum {
+    /** Waiting for a worker to pick it up. */
+    JOB_QUEUED,
+    /** Being performed by a worker; the socket may not be touched. */
+    JOB_RUNNING,
+    /** Result stored in @c err . */
+    JOB_DONE
+} handshake_job_state_t;
+
+typedef struct {
+    avs_net_socket_t *socket;
+    _avs_net_handshake_step_t *step;
+    handshake_job_state_t state;
+    /** Set once returned from avs_net_handshake_pool_get_completed(). */
+    bool reported;
+    avs_error_t err;
+} handshake_job_t;
+
+struct avs_net_handshake_pool_struct {
+    avs_mutex_t *mutex;
+    /**
+     * Notified whenever a job is queued, a job is finished, or a worker exits.
+     */
+    avs_condvar_t *condvar;
+
+    /**
+     * UDP socket that a datagram is sent to when a job is finished, so that it
+     * becomes readable. Only accessed with the mutex held.
+     */
+    avs_net_socket_t *notifier;
+    /**
+     * UDP socket connected to the notifier. Only accessed, with the mutex
+     * released, by the thread that has set @c sending .
+     */
+    avs_net_socket_t *notifier_sender;
+    /**
+     * Whether a datagram sent to the notifier, or about to be sent, is waiting
+     * to be received.
+     */
+    bool notified;
+    /** Whether some thread is sending a datagram to the notifier. */
+    bool sending;
+    /**
+     * Whether the notifier has been drained while @c sending , and has to be
+     * notified again once the sending thread is done.
+     */
+    bool renotify;
+
+    /** Jobs in the order of submission. */
+    AVS_LIST(handshake_job_t) jobs;
+
+    size_t running_workers;
+    bool stopping;
+};
+
+static avs_error_t create_bound_socket(avs_net_socket_t **out_socket,
+                                       char *out_port) {
+    avs_net_socket_configuration_t config;
+    memset(&config, 0, sizeof(config));
+    config.address_family = NOTIFIER_FAMILY;
+    avs_error_t err;
+    (void) (avs_is_err((err = avs_net_udp_socket_create(out_socket, &config)))
+            || avs_is_err((err = avs_net_socket_bind(*out_socket,
+                                                     NOTIFIER_ADDRESS, "0")))
+            || avs_is_err((err = avs_net_socket_get_local_port(
+                                   *out_socket, out_port, NET_PORT_SIZE))));
+    return err;
+}
+
+/**
+ * Creates a pair of UDP sockets connected to each other, so that the notifier
+ * does not receive datagrams from anyone else.
+ */
+static avs_error_t create_notifier(avs_net_handshake_pool_t *pool) {
+    char notifier_port[NET_PORT_SIZE];
+    char sender_port[NET_PORT_SIZE];
+    avs_error_t err;
+    (void) (avs_is_err((err = create_bound_socket(&pool->notifier,
+                                                  notifier_port)))
+            || avs_is_err((err = create_bound_socket(&pool->notifier_sender,
+                                                     sender_port)))
+            || avs_is_err((err = avs_net_socket_connect(
+                                   pool->notifier_sender, NOTIFIER_ADDRESS,
+                                   notifier_port)))
+            || avs_is_err((err = avs_net_socket_connect(
+                                   pool->notifier, NOTIFIER_ADDRESS,
+                                   sender_port)))
+            || avs_is_err((err = avs_net_socket_set_opt(
+                                   pool->notifier,
+                                   AVS_NET_SOCKET_OPT_RECV_TIMEOUT,
+                                   (avs_net_socket_opt_value_t) {
+                                       .recv_timeout = AVS_TIME_DURATION_ZERO
+                                   }))));
+    return err;
+}
+
+avs_error_t avs_net_handshake_pool_create(avs_net_handshake_pool_t **out_pool) {
+    assert(out_pool && !*out_pool);
+    avs_net_handshake_pool_t *pool = (avs_net_handshake_pool_t *) avs_calloc(
+            1, sizeof(avs_net_handshake_pool_t));
+    if (!pool) {
+        LOG(ERROR, _("out of memory"));
+        return avs_errno(AVS_ENOMEM);
+    }
+    if (avs_mutex_create(&pool->mutex) || avs_condvar_create(&pool->condvar)) {
+        LOG(ERROR, _("could not create synchronization primitives"));
+        avs_net_handshake_pool_cleanup(&pool);
+        return avs_errno(AVS_ENOMEM);
+    }
+    avs_error_t err = create_notifier(pool);
+    if (avs_is_err(err)) {
+        LOG(ERROR, _("could not create notifier socket"));
+        avs_net_handshake_pool_cleanup(&pool);
+        return err;
+    }
+    *out_pool = pool;
+    return AVS_OK;
+}
+
+void avs_net_handshake_pool_cleanup(avs_net_handshake_pool_t **pool) {
+    if (!*pool) {
+        return;
+    }
+    assert(!(*pool)->running_workers);
+    assert(!(*pool)->jobs);
+    AVS_LIST_CLEAR(&(*pool)->jobs);
+    avs_net_socket_cleanup(&(*pool)->notifier_sender);
+    avs_net_socket_cleanup(&(*pool)->notifier);
+    avs_condvar_cleanup(&(*pool)->condvar);
+    avs_mutex_cleanup(&(*pool)->mutex);
+    avs_free(*pool);
+    *pool = NULL;
+}
+
+avs_net_socket_t *
+avs_net_handshake_pool_notifier(avs_net_handshake_pool_t *pool) {
+    return pool->notifier;
+}
+
+/**
+ * Marks the notifier as to be made readable. Called with the mutex held.
+ *
+ * @returns true if the caller is responsible for calling send_notification()
+ *          after releasing the mutex.
+ */
+static bool notify(avs_net_handshake_pool_t *pool) {
+    if (pool->notified) {
+        return false;
+    }
+    pool->notified = true;
+    if (pool->sending) {
+        // the datagram being sent might have been drained already
+        pool->renotify = true;
+        return false;
+    }
+    pool->sending = true;
+    return true;
+}
+
+/**
+ * Sends the datagram promised by notify(), and any further ones requested in
+ * the meantime. Called with the mutex released, so that the system call does
+ * not block the other threads.
+ */
+static void send_notification(avs_net_handshake_pool_t *pool) {
+    bool send = true;
+    while (send) {
+        avs_error_t err = avs_net_socket_send(pool->notifier_sender, "", 1);
+        avs_mutex_lock(pool->mutex);
+        if (avs_is_err(err)) {
+            LOG(WARNING, _("could not signal handshake step completion"));
+            pool->notified = false;
+        }
+        send = pool->renotify;
+        pool->renotify = false;
+        pool->sending = send;
+        avs_mutex_unlock(pool->mutex);
+    }
+}
+
+static void drain_notifier(avs_net_handshake_pool_t *pool) {
+    if (pool->notified) {
+        char buffer[16];
+        size_t received;
+        while (avs_is_ok(avs_net_socket_receive(pool->notifier, &received,
+                                                buffer, sizeof(buffer)))) {
+        }
+        pool->notified = false;
+    }
+}
+
+/**
+ * @returns Value of notify(), see there.
+ */
+static bool finish_job(avs_net_handshake_pool_t *pool,
+                       handshake_job_t *job,
+                       avs_error_t err) {
+    job->state = JOB_DONE;
+    job->err = err;
+    avs_condvar_notify_all(pool->condvar);
+    return notify(pool);
+}
+
+size_t avs_net_handshake_pool_get_completed(avs_net_handshake_pool_t *pool,
+                                            avs_net_socket_t **out_sockets,
+                                            size_t max_sockets) {
+    size_t count = 0;
+    bool send = false;
+    avs_mutex_lock(pool->mutex);
+    drain_notifier(pool);
+    AVS_LIST(handshake_job_t) job;
+    AVS_LIST_FOREACH(job, pool->jobs) {
+        if (job->state == JOB_DONE && !job->reported) {
+            if (count >= max_sockets) {
+                // leave the notifier readable for the remaining ones
+                send = notify(pool);
+                break;
+            }
+            job->reported = true;
+            out_sockets[count++] = job->socket;
+        }
+    }
+    avs_mutex_unlock(pool->mutex);
+    if (send) {
+        send_notification(pool);
+    }
+    return count;
+}
+
+static AVS_LIST(handshake_job_t) *find_job_ptr(avs_net_handshake_pool_t *pool,
+                                               avs_net_socket_t *socket) {
+    AVS_LIST(handshake_job_t) *job_ptr;
+    AVS_LIST_FOREACH_PTR(job_ptr, &pool->jobs) {
+        if ((*job_ptr)->socket == socket) {
+            return job_ptr;
+        }
+    }
+    return NULL;
+}
+
+avs_error_t _avs_net_handshake_pool_submit(avs_net_handshake_pool_t *pool,
+                                           avs_net_socket_t *socket,
+                                           _avs_net_handshake_step_t *step) {
+    AVS_LIST(handshake_job_t) job = AVS_LIST_NEW_ELEMENT(handshake_job_t);
+    if (!job) {
+        LOG(ERROR, _("out of memory"));
+        return avs_errno(AVS_ENOMEM);
+    }
+    job->socket = socket;
+    job->step = step;
+    job->state = JOB_QUEUED;
+
+    avs_mutex_lock(pool->mutex);
+    assert(!find_job_ptr(pool, socket));
+    if (pool->stopping) {
+        avs_mutex_unlock(pool->mutex);
+        AVS_LIST_DELETE(&job);
+        return avs_errno(AVS_EINTR);
+    }
+    AVS_LIST_APPEND(&pool->jobs, job);
+    avs_condvar_notify_all(pool->condvar);
+    avs_mutex_unlock(pool->mutex);
+    return AVS_OK;
+}
+
+bool _avs_net_handshake_pool_take_result(avs_net_handshake_pool_t *pool,
+                                         avs_net_socket_t *socket,
+                                         avs_error_t *out_err) {
+    bool result = true;
+    avs_mutex_lock(pool->mutex);
+    AVS_LIST(handshake_job_t) *job_ptr = find_job_ptr(pool, socket);
+    if (!job_ptr) {
+        *out_err = avs_errno(AVS_EBADF);
+    } else if ((*job_ptr)->state != JOB_DONE) {
+        result = false;
+    } else {
+        *out_err = (*job_ptr)->err;
+        AVS_LIST_DELETE(job_ptr);
+    }
+    avs_mutex_unlock(pool->mutex);
+    return result;
+}
+
+void _avs_net_handshake_pool_cancel(avs_net_handshake_pool_t *pool,
+                                    avs_net_socket_t *socket) {
+    avs_mutex_lock(pool->mutex);
+    AVS_LIST(handshake_job_t) *job_ptr;
+    bool wait_failed = false;
+    while ((job_ptr = find_job_ptr(pool, socket))
+           && (*job_ptr)->state == JOB_RUNNING) {
+        if (!wait_failed
+                && avs_condvar_wait(pool->condvar, pool->mutex,
+                                    AVS_TIME_MONOTONIC_INVALID)
+                           < 0) {
+            LOG(WARNING, _("could not wait for the handshake step to finish, "
+                           "polling instead"));
+            wait_failed = true;
+        }
+        if (wait_failed) {
+            // The socket is about to be closed, so the worker has to be done
+            // with it before returning. It needs the mutex to finish the job.
+            avs_mutex_unlock(pool->mutex);
+            avs_mutex_lock(pool->mutex);
+        }
+    }
+    if (job_ptr) {
+        AVS_LIST_DELETE(job_ptr);
+    }
+    avs_mutex_unlock(pool->mutex);
+}
+
+static handshake_job_t *find_queued(avs_net_handshake_pool_t *pool) {
+    AVS_LIST(handshake_job_t) job;
+    AVS_LIST_FOREACH(job, pool->jobs) {
+        if (job->state == JOB_QUEUED) {
+            return job;
+        }
+    }
+    return NULL;
+}
+
+int avs_net_handshake_pool_worker_run(avs_net_handshake_pool_t *pool) {
+    int result = 0;
+    avs_mutex_lock(pool->mutex);
+    ++pool->running_workers;
+    while (!pool->stopping) {
+        handshake_job_t *job = find_queued(pool);
+        if (!job) {
+            if (avs_condvar_wait(pool->condvar, pool->mutex,
+                                 AVS_TIME_MONOTONIC_INVALID)
+                    < 0) {
+                result = -1;
+                break;
+            }
+            continue;
+        }
+
+        // a job in the JOB_RUNNING state is not freed, and its socket is not
+        // touched by anyone else, so it's safe to use them unlocked
+        job->state = JOB_RUNNING;
+        avs_mutex_unlock(pool->mutex);
+        avs_error_t err = job->step(job->socket);
+        avs_mutex_lock(pool->mutex);
+        if (finish_job(pool, job, err)) {
+            avs_mutex_unlock(pool->mutex);
+            send_notification(pool);
+            avs_mutex_lock(pool->mutex);
+        }
+    }
+    --pool->running_workers;
+    avs_condvar_notify_all(pool->condvar);
+    avs_mutex_unlock(pool->mutex);
+    return result;
+}
+
+int avs_net_handshake_pool_workers_stop(avs_net_handshake_pool_t *pool) {
+    int result = 0;
+    bool send = false;
+    avs_mutex_lock(pool->mutex);
+    pool->stopping = true;
+    handshake_job_t *job;
+    while ((job = find_queued(pool))) {
+        send = finish_job(pool, job, avs_errno(AVS_EINTR)) || send;
+    }
+    avs_condvar_notify_all(pool->condvar);
+    if (send) {
+        avs_mutex_unlock(pool->mutex);
+        send_notification(pool);
+        avs_mutex_lock(pool->mutex);
+    }
+    while (pool->running_workers) {
+        if (avs_condvar_wait(pool->condvar, pool->mutex,
+                             AVS_TIME_MONOTONIC_INVALID)
+                < 0) {
+            result = -1;
+            break;
+        }
+    }
+    avs_mutex_unlock(pool->mutex);
+    return result;
+}
+
+#    ifdef AVS_UNIT_TESTING
+#        include "tests/net/handshake_pool.c"
+#    endif // AVS_UNIT_TESTING
+
+#endif // defined(AVS_COMMONS_WITH_AVS_NET) &&
+       // defined(AVS_COMMONS_NET_WITH_HANDSHAKE_POOL)
@@ -60,8 +60,158 @@ avs_error_t _avs_net_create_ssl_socket(avs_net_socket_t **socket,
                                        const void *socket_configuration);
 avs_error_t _avs_net_create_dtls_socket(avs_net_socket_t **socket,
                                         const void *socket_configuration);
+
+avs_error_t
+_avs_net_create_ssl_context(avs_net_ssl_context_t **out_context,
+                            const avs_net_ssl_configuration_t *configuration);
+avs_error_t
+_avs_net_create_dtls_context(avs_net_ssl_context_t **out_context,
+                             const avs_net_ssl_configuration_t *configuration);
+void _avs_net_release_ssl_context(avs_net_ssl_context_t **context);
+avs_error_t _avs_net_ssl_context_get_server_session_stats(
+        avs_net_ssl_context_t *context,
+        avs_net_ssl_server_session_stats_t *out_stats);
+
+/**
+ * State of a handshake started using avs_net_socket_decorate_async(), kept by
+ * the TLS backends that support it.
+ */
+typedef struct {
+    /** Pool to offload the handshake steps to, or NULL to perform inline. */
+    avs_net_handshake_pool_t *pool;
+    /** Set until the handshake finishes; reads do not block in the meantime. */
+    bool in_progress;
+    /** Whether a step has been submitted to the pool and not yet collected. */
+    bool submitted;
+    /** Whether the backend socket is a server-side one. */
+    bool accepted;
+#    ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+    avs_time_monotonic_t started;
+#    endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
+} _avs_net_ssl_async_handshake_t;
+
+#    ifdef AVS_COMMONS_NET_WITH_TLS_SESSION_CACHE
+typedef struct avs_net_session_cache_struct _avs_net_session_cache_t;
+
+/**
+ * Identifies the server with which a cached session may be resumed.
+ */
+typedef struct {
+    char host[NET_MAX_HOSTNAME_SIZE];
+    char port[NET_PORT_SIZE];
+    char server_name[NET_MAX_HOSTNAME_SIZE];
+} _avs_net_session_cache_key_t;
+
+/**
+ * State of a socket that exchanges sessions with a session cache, allocated
+ * along with the session resumption buffer used by the TLS backend.
+ */
+typedef struct {
+    /** Key of the current connection; empty host if not cacheable. */
+    _avs_net_session_cache_key_t key;
+    size_t buffer_size;
+    char buffer[];
+} _avs_net_session_cache_slot_t;
+
+avs_error_t
+_avs_net_session_cache_create(_avs_net_session_cache_t **out_cache,
+                              const avs_net_ssl_session_cache_config_t *config);
+
+void _avs_net_session_cache_cleanup(_avs_net_session_cache_t **cache);
+
+/**
+ * Allocates a slot with a buffer large enough for any session that may be
+ * stored in @p cache .
+ */
+_avs_net_session_cache_slot_t *
+_avs_net_session_cache_slot_new(const _avs_net_session_cache_t *cache);
+
+/**
+ * Fills the slot's buffer with the session cached for its key, zero-padded,
+ * or with zeroes if there is none.
+ */
+void _avs_net_session_cache_load(_avs_net_session_cache_t *cache,
+                                 _avs_net_session_cache_slot_t *slot);
+
+/**
+ * Stores the session from the slot's buffer under its key. As with
+ * user-provided session resumption buffers, trailing zeroes are assumed not to
+ * be a part of the session data, and are not kept. An all-zero buffer removes
+ * the entry.
+ */
+void _avs_net_session_cache_store(_avs_net_session_cache_t *cache,
+                                  const _avs_net_session_cache_slot_t *slot);
+
+avs_error_t _avs_net_session_cache_persistence(avs_persistence_context_t *ctx,
+                                               _avs_net_session_cache_t *cache);
+
+/**
+ * Returns the session cache of @p context , or NULL if it has none.
+ */
+_avs_net_session_cache_t *
+_avs_net_ssl_context_session_cache(avs_net_ssl_context_t *context);
+#    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_CACHE
 #endif // AVS_COMMONS_WITHOUT_TLS
 
+#ifdef AVS_COMMONS_NET_WITH_HANDSHAKE_POOL
+/**
+ * Single step of an asynchronous handshake, performed by a handshake pool
+ * worker. Returns the value to be reported by
+ * avs_net_socket_handshake_continue().
+ */
+typedef avs_error_t _avs_net_handshake_step_t(avs_net_socket_t *socket);
+
+/**
+ * Queues @p step to be performed on @p socket . Only one step may be submitted
+ * for a given socket at a time.
+ */
+avs_error_t _avs_net_handshake_pool_submit(avs_net_handshake_pool_t *pool,
+                                           avs_net_socket_t *socket,
+                                           _avs_net_handshake_step_t *step);
+
+/**
+ * Checks whether the step submitted for @p socket has been performed. If so,
+ * forgets about it, sets <c>*out_err</c> to its result and returns true.
+ */
+bool _avs_net_handshake_pool_take_result(avs_net_handshake_pool_t *pool,
+                                         avs_net_socket_t *socket,
+                                         avs_error_t *out_err);
+
+/**
+ * Forgets about the step submitted for @p socket , if any. If it is being
+ * performed right now, waits until it finishes.
+ */
+void _avs_net_handshake_pool_cancel(avs_net_handshake_pool_t *pool,
+                                    avs_net_socket_t *socket);
+#endif // AVS_COMMONS_NET_WITH_HANDSHAKE_POOL
+
+/**
+ * System call counters gathered by a socket implementation during a single
+ * operation, to be added to the socket's and global statistics at once.
+ */
+typedef struct {
+    uint64_t syscalls;
+    uint64_t would_block;
+    uint64_t polls;
+    avs_time_duration_t poll_wait_time;
+} _avs_net_io_counters_t;
+
+#ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+
+/**
+ * Adds @p counters to @p stats (if not NULL) and to the global statistics.
+ */
+void _avs_net_stats_record_io(avs_net_socket_stats_t *stats,
+                              const _avs_net_io_counters_t *counters);
+
+/**
+ * Records a (D)TLS handshake duration in @p stats (if not NULL) and in the
+ * global statistics.
+ */
+void _avs_net_stats_record_handshake(avs_net_socket_stats_t *stats,
+                                     avs_time_duration_t duration);
+#endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
+
 VISIBILITY_PRIVATE_HEADER_END
 
 #endif /* NET_H */
@@ -0,0 +1,499 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avs_commons_init.h>
+
+#if defined(AVS_COMMONS_WITH_AVS_NET) && defined(AVS_COMMONS_NET_WITH_RESOLVER)
+
+#    include <assert.h>
+#    include <string.h>
+
+#    include <avsystem/commons/avs_condvar.h>
+#    include <avsystem/commons/avs_list.h>
+#    include <avsystem/commons/avs_memory.h>
+#    include <avsystem/commons/avs_mutex.h>
+#    include <avsystem/commons/avs_net_resolver.h>
+#    include <avsystem/commons/avs_utils.h>
+
+#    include "avs_net_impl.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+typedef struct {
+    avs_net_resolver_callback_t *callback;
+    void *arg;
+} resolver_waiter_t;
+
+typedef enum {
+    /** Waiting for a worker to pick it up. */
+    ENTRY_QUEUED,
+    /** Lookup or delivery of its result in progress; may not be freed. */
+    ENTRY_RESOLVING,
+    /** Result cached in @c err and @c result . */
+    ENTRY_DONE
+} resolver_entry_state_t;
+
+typedef struct {
+    avs_net_socket_type_t socket_type;
+    avs_net_af_t family;
+    int flags;
+    char host[NET_MAX_HOSTNAME_SIZE];
+    char port[NET_PORT_SIZE];
+
+    resolver_entry_state_t state;
+    avs_time_monotonic_t expires;
+    avs_error_t err;
+    avs_net_resolver_result_t result;
+    AVS_LIST(resolver_waiter_t) waiters;
+} resolver_entry_t;
+
+struct avs_net_resolver_struct {
+    avs_net_resolver_config_t config;
+    avs_mutex_t *mutex;
+    /**
+     * Notified whenever an entry is queued, a callback delivery finishes, or
+     * a worker exits.
+     */
+    avs_condvar_t *condvar;
+
+    /** Cache entries and pending lookups, most recently used first. */
+    AVS_LIST(resolver_entry_t) entries;
+    /** Waiters whose callbacks are being called right now. */
+    AVS_LIST(resolver_waiter_t) deliveries;
+
+    size_t running_workers;
+    bool stopping;
+    avs_net_resolver_stats_t stats;
+};
+
+avs_error_t avs_net_resolver_create(avs_net_resolver_t **out_resolver,
+                                    const avs_net_resolver_config_t *config) {
+    assert(out_resolver && !*out_resolver);
+    if (!avs_time_duration_valid(config->positive_ttl)
+            || !avs_time_duration_valid(config->negative_ttl)) {
+        LOG(ERROR, _("invalid resolver TTL"));
+        return avs_errno(AVS_EINVAL);
+    }
+    avs_net_resolver_t *resolver =
+            (avs_net_resolver_t *) avs_calloc(1, sizeof(avs_net_resolver_t));
+    if (!resolver) {
+        LOG(ERROR, _("out of memory"));
+        return avs_errno(AVS_ENOMEM);
+    }
+    resolver->config = *config;
+    if (avs_mutex_create(&resolver->mutex)
+            || avs_condvar_create(&resolver->condvar)) {
+        LOG(ERROR, _("could not create synchronization primitives"));
+        avs_net_resolver_cleanup(&resolver);
+        return avs_errno(AVS_ENOMEM);
+    }
+    *out_resolver = resolver;
+    return AVS_OK;
+}
+
+void avs_net_resolver_cleanup(avs_net_resolver_t **resolver) {
+    if (!*resolver) {
+        return;
+    }
+    assert(!(*resolver)->running_workers);
+    assert(!(*resolver)->deliveries);
+    AVS_LIST_CLEAR(&(*resolver)->entries) {
+        AVS_LIST_CLEAR(&(*resolver)->entries->waiters);
+    }
+    avs_condvar_cleanup(&(*resolver)->condvar);
+    avs_mutex_cleanup(&(*resolver)->mutex);
+    avs_free(*resolver);
+    *resolver = NULL;
+}
+
+static avs_error_t init_entry(resolver_entry_t *entry,
+                              avs_net_socket_type_t socket_type,
+                              avs_net_af_t family,
+                              const char *host,
+                              const char *port,
+                              int flags) {
+    memset(entry, 0, sizeof(*entry));
+    if (avs_simple_snprintf(entry->host, sizeof(entry->host), "%s",
+                            host ? host : "")
+                    < 0
+            || avs_simple_snprintf(entry->port, sizeof(entry->port), "%s",
+                                   port ? port : "")
+                           < 0) {
+        LOG(ERROR, _("host name or port too long"));
+        return avs_errno(AVS_EINVAL);
+    }
+    entry->socket_type = socket_type;
+    entry->family = family;
+    entry->flags = flags;
+    return AVS_OK;
+}
+
+static bool same_key(const resolver_entry_t *a, const resolver_entry_t *b) {
+    return a->socket_type == b->socket_type && a->family == b->family
+           && a->flags == b->flags && strcmp(a->host, b->host) == 0
+           && strcmp(a->port, b->port) == 0;
+}
+
+/**
+ * Looks up an entry with the same key as @p key and moves it to the front of
+ * the list, as the most recently used one.
+ */
+static resolver_entry_t *find_entry(avs_net_resolver_t *resolver,
+                                    const resolver_entry_t *key) {
+    AVS_LIST(resolver_entry_t) *entry_ptr;
+    AVS_LIST_FOREACH_PTR(entry_ptr, &resolver->entries) {
+        if (same_key(*entry_ptr, key)) {
+            AVS_LIST(resolver_entry_t) entry = AVS_LIST_DETACH(entry_ptr);
+            AVS_LIST_INSERT(&resolver->entries, entry);
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static bool entry_expired(const resolver_entry_t *entry) {
+    return !avs_time_monotonic_before(avs_time_monotonic_now(),
+                                      entry->expires);
+}
+
+static bool entry_removable(const resolver_entry_t *entry) {
+    return entry->state == ENTRY_DONE && !entry->waiters;
+}
+
+/**
+ * Discards the least recently used complete entries, so that at most
+ * <c>config.cache_size</c> of them remain.
+ */
+static void evict_excess(avs_net_resolver_t *resolver) {
+    size_t cached = 0;
+    AVS_LIST(resolver_entry_t) *entry_ptr = &resolver->entries;
+    while (*entry_ptr) {
+        if (entry_removable(*entry_ptr)
+                && (++cached > resolver->config.cache_size
+                    || entry_expired(*entry_ptr))) {
+            AVS_LIST_DELETE(entry_ptr);
+        } else {
+            AVS_LIST_ADVANCE_PTR(&entry_ptr);
+        }
+    }
+}
+
+static avs_error_t lookup(const resolver_entry_t *key,
+                          avs_net_resolver_result_t *out_result) {
+    avs_net_addrinfo_t *info =
+            avs_net_addrinfo_resolve_ex(key->socket_type, key->family,
+                                        key->host, key->port, key->flags,
+                                        NULL);
+    out_result->count = 0;
+    if (info) {
+        while (out_result->count < AVS_ARRAY_SIZE(out_result->endpoints)
+               && !avs_net_addrinfo_next(
+                          info, &out_result->endpoints[out_result->count])) {
+            ++out_result->count;
+        }
+        avs_net_addrinfo_delete(&info);
+    }
+    if (!out_result->count) {
+        LOG(DEBUG, _("could not resolve ") "%s", key->host);
+        return avs_errno(AVS_EADDRNOTAVAIL);
+    }
+    return AVS_OK;
+}
+
+static void store_result(avs_net_resolver_t *resolver,
+                         resolver_entry_t *entry,
+                         avs_error_t err,
+                         const avs_net_resolver_result_t *result) {
+    entry->err = err;
+    if (avs_is_ok(err)) {
+        entry->result = *result;
+    }
+    entry->expires = avs_time_monotonic_add(
+            avs_time_monotonic_now(),
+            avs_is_ok(err) ? resolver->config.positive_ttl
+                           : resolver->config.negative_ttl);
+}
+
+/**
+ * Calls the callbacks of all waiters attached to @p entry , including ones
+ * attached while this function is running. Must be called with the mutex
+ * locked and @p entry in the ENTRY_RESOLVING state; the mutex is released for
+ * the duration of each call.
+ */
+static void deliver(avs_net_resolver_t *resolver,
+                    resolver_entry_t *entry,
+                    avs_error_t err) {
+    assert(entry->state == ENTRY_RESOLVING);
+    avs_net_resolver_result_t result = entry->result;
+    while (entry->waiters) {
+        AVS_LIST(resolver_waiter_t) waiter = AVS_LIST_DETACH(&entry->waiters);
+        AVS_LIST_INSERT(&resolver->deliveries, waiter);
+        avs_mutex_unlock(resolver->mutex);
+        waiter->callback(waiter->arg, err, avs_is_ok(err) ? &result : NULL);
+        avs_mutex_lock(resolver->mutex);
+        AVS_LIST(resolver_waiter_t) *waiter_ptr =
+                AVS_LIST_FIND_PTR(&resolver->deliveries, waiter);
+        assert(waiter_ptr);
+        AVS_LIST_DELETE(waiter_ptr);
+        avs_condvar_notify_all(resolver->condvar);
+    }
+}
+
+avs_error_t avs_net_resolver_resolve(avs_net_resolver_t *resolver,
+                                     avs_net_socket_type_t socket_type,
+                                     avs_net_af_t family,
+                                     const char *host,
+                                     const char *port,
+                                     int flags,
+                                     avs_net_resolver_result_t *out_result) {
+    resolver_entry_t key;
+    avs_error_t err =
+            init_entry(&key, socket_type, family, host, port, flags);
+    if (avs_is_err(err)) {
+        return err;
+    }
+
+    avs_mutex_lock(resolver->mutex);
+    resolver_entry_t *entry = find_entry(resolver, &key);
+    if (entry && entry->state == ENTRY_DONE && !entry_expired(entry)) {
+        ++resolver->stats.cache_hits;
+        if (avs_is_ok((err = entry->err))) {
+            *out_result = entry->result;
+        } else {
+            ++resolver->stats.negative_hits;
+        }
+        avs_mutex_unlock(resolver->mutex);
+        return err;
+    }
+    ++resolver->stats.cache_misses;
+    avs_mutex_unlock(resolver->mutex);
+
+    err = lookup(&key, out_result);
+
+    avs_mutex_lock(resolver->mutex);
+    // an asynchronous lookup may have been started in the meantime; leave the
+    // entry alone in that case, it will be updated by the worker
+    if (!(entry = find_entry(resolver, &key))) {
+        AVS_LIST(resolver_entry_t) new_entry =
+                AVS_LIST_NEW_ELEMENT(resolver_entry_t);
+        if (new_entry) {
+            *new_entry = key;
+            new_entry->state = ENTRY_DONE;
+            AVS_LIST_INSERT(&resolver->entries, new_entry);
+            entry = new_entry;
+        }
+    }
+    if (entry && entry->state == ENTRY_DONE) {
+        store_result(resolver, entry, err, out_result);
+        evict_excess(resolver);
+    }
+    avs_mutex_unlock(resolver->mutex);
+    return err;
+}
+
+avs_error_t avs_net_resolver_resolve_async(avs_net_resolver_t *resolver,
+                                           avs_net_socket_type_t socket_type,
+                                           avs_net_af_t family,
+                                           const char *host,
+                                           const char *port,
+                                           int flags,
+                                           avs_net_resolver_callback_t *callback,
+                                           void *arg) {
+    resolver_entry_t key;
+    avs_error_t err =
+            init_entry(&key, socket_type, family, host, port, flags);
+    if (avs_is_err(err)) {
+        return err;
+    }
+    AVS_LIST(resolver_waiter_t) waiter = AVS_LIST_NEW_ELEMENT(resolver_waiter_t);
+    if (!waiter) {
+        LOG(ERROR, _("out of memory"));
+        return avs_errno(AVS_ENOMEM);
+    }
+    waiter->callback = callback;
+    waiter->arg = arg;
+
+    avs_mutex_lock(resolver->mutex);
+    AVS_LIST(resolver_entry_t) entry = find_entry(resolver, &key);
+    if (entry && entry->state == ENTRY_DONE && !entry_expired(entry)) {
+        ++resolver->stats.cache_hits;
+        avs_net_resolver_result_t result;
+        if (avs_is_ok((err = entry->err))) {
+            result = entry->result;
+        } else {
+            ++resolver->stats.negative_hits;
+        }
+        avs_mutex_unlock(resolver->mutex);
+        AVS_LIST_DELETE(&waiter);
+        callback(arg, err, avs_is_ok(err) ? &result : NULL);
+        return AVS_OK;
+    }
+
+    if (entry && entry->state != ENTRY_DONE) {
+        ++resolver->stats.cache_hits;
+    } else if (resolver->stopping) {
+        avs_mutex_unlock(resolver->mutex);
+        AVS_LIST_DELETE(&waiter);
+        return avs_errno(AVS_EINTR);
+    } else {
+        if (!entry) {
+            if (!(entry = AVS_LIST_NEW_ELEMENT(resolver_entry_t))) {
+                avs_mutex_unlock(resolver->mutex);
+                AVS_LIST_DELETE(&waiter);
+                LOG(ERROR, _("out of memory"));
+                return avs_errno(AVS_ENOMEM);
+            }
+            *entry = key;
+            AVS_LIST_INSERT(&resolver->entries, entry);
+        }
+        ++resolver->stats.cache_misses;
+        entry->state = ENTRY_QUEUED;
+        avs_condvar_notify_all(resolver->condvar);
+    }
+    AVS_LIST_APPEND(&entry->waiters, waiter);
+    avs_mutex_unlock(resolver->mutex);
+    return AVS_OK;
+}
+
+size_t avs_net_resolver_cancel(avs_net_resolver_t *resolver,
+                               avs_net_resolver_callback_t *callback,
+                               void *arg) {
+    size_t cancelled = 0;
+    avs_mutex_lock(resolver->mutex);
+    AVS_LIST(resolver_entry_t) entry;
+    AVS_LIST_FOREACH(entry, resolver->entries) {
+        AVS_LIST(resolver_waiter_t) *waiter_ptr;
+        AVS_LIST(resolver_waiter_t) helper;
+        AVS_LIST_DELETABLE_FOREACH_PTR(waiter_ptr, helper, &entry->waiters) {
+            if ((*waiter_ptr)->callback == callback
+                    && (*waiter_ptr)->arg == arg) {
+                AVS_LIST_DELETE(waiter_ptr);
+                ++cancelled;
+            }
+        }
+    }
+    bool delivering;
+    do {
+        delivering = false;
+        AVS_LIST(resolver_waiter_t) waiter;
+        AVS_LIST_FOREACH(waiter, resolver->deliveries) {
+            if (waiter->callback == callback && waiter->arg == arg) {
+                delivering = true;
+                break;
+            }
+        }
+    } while (delivering
+             && avs_condvar_wait(resolver->condvar, resolver->mutex,
+                                 AVS_TIME_MONOTONIC_INVALID)
+                        >= 0);
+    avs_mutex_unlock(resolver->mutex);
+    return cancelled;
+}
+
+static resolver_entry_t *find_queued(avs_net_resolver_t *resolver) {
+    AVS_LIST(resolver_entry_t) entry;
+    AVS_LIST_FOREACH(entry, resolver->entries) {
+        if (entry->state == ENTRY_QUEUED) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+int avs_net_resolver_worker_run(avs_net_resolver_t *resolver) {
+    int result = 0;
+    avs_mutex_lock(resolver->mutex);
+    ++resolver->running_workers;
+    while (!resolver->stopping) {
+        resolver_entry_t *entry = find_queued(resolver);
+        if (!entry) {
+            if (avs_condvar_wait(resolver->condvar, resolver->mutex,
+                                 AVS_TIME_MONOTONIC_INVALID)
+                    < 0) {
+                result = -1;
+                break;
+            }
+            continue;
+        }
+
+        // the key of an entry in the ENTRY_RESOLVING state is not modified,
+        // and the entry itself is not freed, so it's safe to use unlocked
+        entry->state = ENTRY_RESOLVING;
+        avs_mutex_unlock(resolver->mutex);
+        avs_net_resolver_result_t lookup_result;
+        avs_error_t err = lookup(entry, &lookup_result);
+        avs_mutex_lock(resolver->mutex);
+
+        store_result(resolver, entry, err, &lookup_result);
+        deliver(resolver, entry, err);
+        entry->state = ENTRY_DONE;
+        evict_excess(resolver);
+    }
+    --resolver->running_workers;
+    avs_condvar_notify_all(resolver->condvar);
+    avs_mutex_unlock(resolver->mutex);
+    return result;
+}
+
+int avs_net_resolver_workers_stop(avs_net_resolver_t *resolver) {
+    int result = 0;
+    avs_mutex_lock(resolver->mutex);
+    resolver->stopping = true;
+    avs_condvar_notify_all(resolver->condvar);
+
+    resolver_entry_t *entry;
+    while ((entry = find_queued(resolver))) {
+        entry->state = ENTRY_RESOLVING;
+        deliver(resolver, entry, avs_errno(AVS_EINTR));
+        AVS_LIST(resolver_entry_t) *entry_ptr =
+                AVS_LIST_FIND_PTR(&resolver->entries, entry);
+        assert(entry_ptr);
+        AVS_LIST_DELETE(entry_ptr);
+    }
+
+    while (resolver->running_workers) {
+        if (avs_condvar_wait(resolver->condvar, resolver->mutex,
+                             AVS_TIME_MONOTONIC_INVALID)
+                < 0) {
+            result = -1;
+            break;
+        }
+    }
+    avs_mutex_unlock(resolver->mutex);
+    return result;
+}
+
+void avs_net_resolver_flush(avs_net_resolver_t *resolver) {
+    avs_mutex_lock(resolver->mutex);
+    AVS_LIST(resolver_entry_t) *entry_ptr;
+    AVS_LIST(resolver_entry_t) helper;
+    AVS_LIST_DELETABLE_FOREACH_PTR(entry_ptr, helper, &resolver->entries) {
+        if (entry_removable(*entry_ptr)) {
+            AVS_LIST_DELETE(entry_ptr);
+        }
+    }
+    avs_mutex_unlock(resolver->mutex);
+}
+
+void avs_net_resolver_stats(avs_net_resolver_t *resolver,
+                            avs_net_resolver_stats_t *out_stats) {
+    avs_mutex_lock(resolver->mutex);
+    *out_stats = resolver->stats;
+    avs_mutex_unlock(resolver->mutex);
+}
+
+#endif // defined(AVS_COMMONS_WITH_AVS_NET) &&
+       // defined(AVS_COMMONS_NET_WITH_RESOLVER)
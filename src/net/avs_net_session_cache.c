@@ -0,0 +1,325 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avs_commons_init.h>
+
+#if defined(AVS_COMMONS_WITH_AVS_NET)                  \
+        && defined(AVS_COMMONS_NET_WITH_TLS_SESSION_CACHE) \
+        && !defined(AVS_COMMONS_WITHOUT_TLS)
+
+#    include <assert.h>
+#    include <string.h>
+
+#    include <avsystem/commons/avs_list.h>
+#    include <avsystem/commons/avs_memory.h>
+#    include <avsystem/commons/avs_mutex.h>
+#    include <avsystem/commons/avs_persistence.h>
+#    include <avsystem/commons/avs_socket.h>
+#    include <avsystem/commons/avs_utils.h>
+
+#    include "avs_net_impl.h"
+
+#    ifdef AVS_UNIT_TESTING
+#        include "tests/net/session_cache_mocks.h"
+#    endif // AVS_UNIT_TESTING
+
+VISIBILITY_SOURCE_BEGIN
+
+typedef struct {
+    _avs_net_session_cache_key_t key;
+    avs_time_monotonic_t expires;
+    void *data;
+    size_t size;
+} session_entry_t;
+
+struct avs_net_session_cache_struct {
+    avs_net_ssl_session_cache_config_t config;
+    avs_mutex_t *mutex;
+    /** Cached sessions, most recently used first. */
+    AVS_LIST(session_entry_t) entries;
+};
+
+static const char PERSISTENCE_MAGIC[] = { 'A', 'S', 'C', '\1' };
+
+static void delete_entry(AVS_LIST(session_entry_t) *entry_ptr) {
+    avs_free((*entry_ptr)->data);
+    AVS_LIST_DELETE(entry_ptr);
+}
+
+static void clear_entries(AVS_LIST(session_entry_t) *entries) {
+    while (*entries) {
+        delete_entry(entries);
+    }
+}
+
+avs_error_t
+_avs_net_session_cache_create(_avs_net_session_cache_t **out_cache,
+                              const avs_net_ssl_session_cache_config_t *config) {
+    assert(out_cache && !*out_cache);
+    if (!config->max_entries || !config->max_session_size
+            || !avs_time_duration_valid(config->ttl)) {
+        LOG(ERROR, _("invalid session cache configuration"));
+        return avs_errno(AVS_EINVAL);
+    }
+    _avs_net_session_cache_t *cache = (_avs_net_session_cache_t *) avs_calloc(
+            1, sizeof(_avs_net_session_cache_t));
+    if (!cache) {
+        LOG(ERROR, _("out of memory"));
+        return avs_errno(AVS_ENOMEM);
+    }
+    cache->config = *config;
+    if (avs_mutex_create(&cache->mutex)) {
+        LOG(ERROR, _("could not create mutex"));
+        avs_free(cache);
+        return avs_errno(AVS_ENOMEM);
+    }
+    *out_cache = cache;
+    return AVS_OK;
+}
+
+void _avs_net_session_cache_cleanup(_avs_net_session_cache_t **cache) {
+    if (!*cache) {
+        return;
+    }
+    clear_entries(&(*cache)->entries);
+    avs_mutex_cleanup(&(*cache)->mutex);
+    avs_free(*cache);
+    *cache = NULL;
+}
+
+_avs_net_session_cache_slot_t *
+_avs_net_session_cache_slot_new(const _avs_net_session_cache_t *cache) {
+    _avs_net_session_cache_slot_t *slot =
+            (_avs_net_session_cache_slot_t *) avs_calloc(
+                    1, sizeof(_avs_net_session_cache_slot_t)
+                               + cache->config.max_session_size);
+    if (slot) {
+        slot->buffer_size = cache->config.max_session_size;
+    }
+    return slot;
+}
+
+static bool same_key(const _avs_net_session_cache_key_t *a,
+                     const _avs_net_session_cache_key_t *b) {
+    return strcmp(a->host, b->host) == 0 && strcmp(a->port, b->port) == 0
+           && strcmp(a->server_name, b->server_name) == 0;
+}
+
+static bool entry_expired(const session_entry_t *entry) {
+    return !avs_time_monotonic_before(avs_time_monotonic_now(),
+                                      entry->expires);
+}
+
+/**
+ * Looks up an entry for @p key , discarding it if expired. A valid entry is
+ * moved to the front of the list, as the most recently used one.
+ */
+static session_entry_t *find_entry(_avs_net_session_cache_t *cache,
+                                   const _avs_net_session_cache_key_t *key) {
+    AVS_LIST(session_entry_t) *entry_ptr;
+    AVS_LIST_FOREACH_PTR(entry_ptr, &cache->entries) {
+        if (same_key(&(*entry_ptr)->key, key)) {
+            if (entry_expired(*entry_ptr)) {
+                delete_entry(entry_ptr);
+                return NULL;
+            }
+            AVS_LIST(session_entry_t) entry = AVS_LIST_DETACH(entry_ptr);
+            AVS_LIST_INSERT(&cache->entries, entry);
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Discards expired entries, ones that would not fit in a slot (these may only
+ * come from persisted data), and the least recently used ones, so that at most
+ * <c>config.max_entries</c> of them remain.
+ */
+static void evict_excess(_avs_net_session_cache_t *cache) {
+    size_t cached = 0;
+    AVS_LIST(session_entry_t) *entry_ptr = &cache->entries;
+    while (*entry_ptr) {
+        if ((*entry_ptr)->size > cache->config.max_session_size
+                || entry_expired(*entry_ptr)
+                || ++cached > cache->config.max_entries) {
+            delete_entry(entry_ptr);
+        } else {
+            AVS_LIST_ADVANCE_PTR(&entry_ptr);
+        }
+    }
+}
+
+void _avs_net_session_cache_load(_avs_net_session_cache_t *cache,
+                                 _avs_net_session_cache_slot_t *slot) {
+    size_t size = 0;
+    avs_mutex_lock(cache->mutex);
+    session_entry_t *entry =
+            slot->key.host[0] ? find_entry(cache, &slot->key) : NULL;
+    if (entry && entry->size <= slot->buffer_size) {
+        memcpy(slot->buffer, entry->data, entry->size);
+        size = entry->size;
+    }
+    avs_mutex_unlock(cache->mutex);
+    memset(slot->buffer + size, 0, slot->buffer_size - size);
+}
+
+void _avs_net_session_cache_store(_avs_net_session_cache_t *cache,
+                                  const _avs_net_session_cache_slot_t *slot) {
+    if (!slot->key.host[0]) {
+        return;
+    }
+    size_t size = slot->buffer_size;
+    while (size && !slot->buffer[size - 1]) {
+        --size;
+    }
+    void *data = NULL;
+    if (size && !(data = avs_malloc(size))) {
+        LOG(WARNING, _("out of memory, session not cached"));
+    } else if (data) {
+        memcpy(data, slot->buffer, size);
+    }
+
+    avs_mutex_lock(cache->mutex);
+    session_entry_t *entry = find_entry(cache, &slot->key);
+    if (!data) {
+        if (entry) {
+            assert(entry == cache->entries);
+            delete_entry(&cache->entries);
+        }
+    } else {
+        if (!entry && (entry = AVS_LIST_NEW_ELEMENT(session_entry_t))) {
+            entry->key = slot->key;
+            AVS_LIST_INSERT(&cache->entries, entry);
+        }
+        if (entry) {
+            avs_free(entry->data);
+            entry->data = data;
+            entry->size = size;
+            entry->expires = avs_time_monotonic_add(avs_time_monotonic_now(),
+                                                    cache->config.ttl);
+            data = NULL;
+        } else {
+            LOG(WARNING, _("out of memory, session not cached"));
+        }
+        evict_excess(cache);
+    }
+    avs_mutex_unlock(cache->mutex);
+    avs_free(data);
+}
+
+static avs_error_t persist_string(avs_persistence_context_t *ctx,
+                                  char *buffer,
+                                  size_t buffer_size) {
+    uint16_t length = (uint16_t) strlen(buffer);
+    avs_error_t err = avs_persistence_u16(ctx, &length);
+    if (avs_is_ok(err) && length >= buffer_size) {
+        err = avs_errno(AVS_EBADMSG);
+    }
+    if (avs_is_ok(err)
+            && avs_is_ok((err = avs_persistence_bytes(ctx, buffer, length)))) {
+        buffer[length] = '\0';
+    }
+    return err;
+}
+
+/**
+ * Expiration times are stored as real time, so that they are still meaningful
+ * after e.g. a restart of the application.
+ */
+static avs_error_t persist_expiration(avs_persistence_context_t *ctx,
+                                      avs_time_monotonic_t *expires) {
+    avs_time_real_t real_now = avs_time_real_now();
+    avs_time_monotonic_t monotonic_now = avs_time_monotonic_now();
+    int64_t expires_ms;
+    if (avs_persistence_direction(ctx) == AVS_PERSISTENCE_STORE
+            && avs_time_real_to_scalar(
+                       &expires_ms, AVS_TIME_MS,
+                       avs_time_real_add(
+                               real_now, avs_time_monotonic_diff(
+                                                 *expires, monotonic_now)))) {
+        return avs_errno(AVS_EINVAL);
+    }
+    avs_error_t err = avs_persistence_i64(ctx, &expires_ms);
+    if (avs_is_ok(err)
+            && avs_persistence_direction(ctx) == AVS_PERSISTENCE_RESTORE) {
+        *expires = avs_time_monotonic_add(
+                monotonic_now,
+                avs_time_real_diff(
+                        avs_time_real_from_scalar(expires_ms, AVS_TIME_MS),
+                        real_now));
+    }
+    return err;
+}
+
+static avs_error_t persist_entry(avs_persistence_context_t *ctx,
+                                 void *entry_,
+                                 void *user_data) {
+    session_entry_t *entry = (session_entry_t *) entry_;
+    (void) user_data;
+    avs_error_t err;
+    (void) (avs_is_err((err = persist_string(ctx, entry->key.host,
+                                             sizeof(entry->key.host))))
+            || avs_is_err((err = persist_string(ctx, entry->key.port,
+                                                sizeof(entry->key.port))))
+            || avs_is_err((err = persist_string(
+                                   ctx, entry->key.server_name,
+                                   sizeof(entry->key.server_name))))
+            || avs_is_err((err = persist_expiration(ctx, &entry->expires)))
+            || avs_is_err((err = avs_persistence_sized_buffer(
+                                   ctx, &entry->data, &entry->size))));
+    return err;
+}
+
+static void cleanup_entry(void *entry) {
+    avs_free(((session_entry_t *) entry)->data);
+}
+
+avs_error_t _avs_net_session_cache_persistence(avs_persistence_context_t *ctx,
+                                               _avs_net_session_cache_t *cache) {
+    avs_error_t err = avs_persistence_magic(ctx, PERSISTENCE_MAGIC,
+                                            sizeof(PERSISTENCE_MAGIC));
+    if (avs_is_err(err)) {
+        return err;
+    }
+    avs_mutex_lock(cache->mutex);
+    if (avs_persistence_direction(ctx) == AVS_PERSISTENCE_STORE) {
+        evict_excess(cache);
+        err = avs_persistence_list(ctx, (AVS_LIST(void) *) &cache->entries,
+                                   sizeof(session_entry_t), persist_entry,
+                                   NULL, NULL);
+    } else {
+        AVS_LIST(session_entry_t) entries = NULL;
+        if (avs_is_ok((err = avs_persistence_list(
+                               ctx, (AVS_LIST(void) *) &entries,
+                               sizeof(session_entry_t), persist_entry, NULL,
+                               cleanup_entry)))) {
+            clear_entries(&cache->entries);
+            cache->entries = entries;
+            evict_excess(cache);
+        }
+    }
+    avs_mutex_unlock(cache->mutex);
+    return err;
+}
+
+#    ifdef AVS_UNIT_TESTING
+#        include "tests/net/session_cache.c"
+#    endif // AVS_UNIT_TESTING
+
+#endif // defined(AVS_COMMONS_WITH_AVS_NET) &&
+       // defined(AVS_COMMONS_NET_WITH_TLS_SESSION_CACHE) &&
+       // !defined(AVS_COMMONS_WITHOUT_TLS)
@@ -22,6 +22,7 @@
 #endif
 
 #include <avsystem/commons/avs_memory.h>
+#include <avsystem/commons/avs_utils.h>
 
 VISIBILITY_PRIVATE_HEADER_BEGIN
 
@@ -30,9 +31,41 @@ static bool is_ssl_started(ssl_socket_t *socket);
 static bool is_session_resumed(ssl_socket_t *socket);
 static bool has_buffered_data(ssl_socket_t *socket);
 static avs_error_t start_ssl(ssl_socket_t *socket, const char *host);
+#ifdef WITH_SSL_ASYNC_HANDSHAKE
+/*
+ * Asynchronous handshakes: prepare_ssl() does what start_ssl() does, except
+ * for the handshake itself. handshake_step() then continues the handshake
+ * until it needs to wait for data from the peer, in which case it returns
+ * avs_errno(AVS_EAGAIN). Reads from the backend socket shall not block while
+ * socket->async_handshake.in_progress is set.
+ */
+static avs_error_t prepare_ssl(ssl_socket_t *socket, const char *host);
+static avs_error_t handshake_step(ssl_socket_t *socket);
+#endif // WITH_SSL_ASYNC_HANDSHAKE
 static void close_ssl_raw(ssl_socket_t *socket);
 static avs_error_t
 get_dtls_overhead(ssl_socket_t *socket, int *out_header, int *out_padding_size);
+/*
+ * Prepares the shareable part of the configuration. Backends define
+ * struct avs_net_ssl_context_struct with at least the mutex, refcount and
+ * backend_type fields, which are managed by this file. cleanup_ssl_context()
+ * is also called on partially initialized contexts.
+ */
+static avs_error_t
+initialize_ssl_context(avs_net_ssl_context_t *context,
+                       const avs_net_ssl_configuration_t *configuration);
+static void cleanup_ssl_context(avs_net_ssl_context_t *context);
+#ifdef WITH_SSL_SERVER_SESSIONS
+/**
+ * Called after initialize_ssl_context() when creating a shared context with
+ * server_sessions configured. Anything allocated shall be freed by
+ * cleanup_ssl_context(), also if this function fails.
+ */
+static avs_error_t
+initialize_server_sessions(avs_net_ssl_context_t *context,
+                           const avs_net_ssl_server_session_config_t *config);
+#endif // WITH_SSL_SERVER_SESSIONS
+/* Called with socket->context already set */
 static avs_error_t
 initialize_ssl_socket(ssl_socket_t *socket,
                       avs_net_socket_type_t backend_type,
@@ -51,6 +84,12 @@ static avs_error_t cleanup_ssl(avs_net_socket_t **ssl_socket);
 /* avs_net_socket_v_table_t ssl handlers implemented in this file */
 static avs_error_t decorate_ssl(avs_net_socket_t *socket,
                                 avs_net_socket_t *backend_socket);
+#ifdef WITH_SSL_ASYNC_HANDSHAKE
+static avs_error_t decorate_async_ssl(avs_net_socket_t *socket,
+                                      avs_net_socket_t *backend_socket,
+                                      avs_net_handshake_pool_t *pool);
+static avs_error_t handshake_continue_ssl(avs_net_socket_t *socket);
+#endif // WITH_SSL_ASYNC_HANDSHAKE
 static avs_error_t close_ssl(avs_net_socket_t *ssl_socket);
 static const void *system_socket_ssl(avs_net_socket_t *ssl_socket);
 static avs_error_t interface_name_ssl(avs_net_socket_t *ssl_socket,
@@ -89,6 +128,170 @@ static avs_error_t ensure_have_backend_socket(ssl_socket_t *socket) {
     return AVS_OK;
 }
 
+/* Whether err means that an asynchronous handshake is not finished yet */
+static inline bool is_handshake_pending(avs_error_t err) {
+    return err.category == AVS_ERRNO_CATEGORY
+           && (err.code == AVS_EAGAIN || err.code == AVS_EINPROGRESS);
+}
+
+static avs_error_t configure_server_sessions(
+        avs_net_ssl_context_t *context,
+        const avs_net_ssl_server_session_config_t *config) {
+    int64_t lifetime_s;
+    if (avs_time_duration_to_scalar(&lifetime_s, AVS_TIME_S, config->lifetime)
+            || lifetime_s < 1 || lifetime_s > UINT32_MAX) {
+        LOG(ERROR, _("invalid server session lifetime"));
+        return avs_errno(AVS_EINVAL);
+    }
+#ifdef WITH_SSL_SERVER_SESSIONS
+    return initialize_server_sessions(context, config);
+#else  // WITH_SSL_SERVER_SESSIONS
+    (void) context;
+    LOG(ERROR, _("server-side session resumption not supported"));
+    return avs_errno(AVS_ENOTSUP);
+#endif // WITH_SSL_SERVER_SESSIONS
+}
+
+/*
+ * Contexts created for the public API are shared and have a mutex guarding the
+ * reference count. Ones implicitly created for sockets configured without
+ * a context are private to that socket and have none.
+ */
+static avs_error_t
+create_ssl_context(avs_net_ssl_context_t **out_context,
+                   avs_net_socket_type_t backend_type,
+                   const avs_net_ssl_configuration_t *configuration,
+                   bool shared) {
+    avs_net_ssl_context_t *context =
+            (avs_net_ssl_context_t *) avs_calloc(1, sizeof(*context));
+    if (!context) {
+        LOG(ERROR, _("Out of memory"));
+        return avs_errno(AVS_ENOMEM);
+    }
+    context->refcount = 1;
+    context->backend_type = backend_type;
+
+    avs_error_t err = AVS_OK;
+    if (shared && avs_mutex_create(&context->mutex)) {
+        err = avs_errno(AVS_ENOMEM);
+    } else if (shared && configuration->session_cache) {
+#ifdef WITH_SSL_SESSION_CACHE
+        err = _avs_net_session_cache_create(&context->session_cache,
+                                            configuration->session_cache);
+#else  // WITH_SSL_SESSION_CACHE
+        LOG(ERROR, _("session cache not supported"));
+        err = avs_errno(AVS_ENOTSUP);
+#endif // WITH_SSL_SESSION_CACHE
+    }
+    if (avs_is_ok(err)) {
+        err = initialize_ssl_context(context, configuration);
+    }
+    if (avs_is_ok(err) && shared && configuration->server_sessions) {
+        err = configure_server_sessions(context,
+                                        configuration->server_sessions);
+    }
+    if (avs_is_err(err)) {
+        LOG(ERROR, _("SSL context initialization error"));
+        cleanup_ssl_context(context);
+#ifdef WITH_SSL_SESSION_CACHE
+        _avs_net_session_cache_cleanup(&context->session_cache);
+#endif // WITH_SSL_SESSION_CACHE
+        avs_mutex_cleanup(&context->mutex);
+        avs_free(context);
+        return err;
+    }
+    *out_context = context;
+    return AVS_OK;
+}
+
+static avs_net_ssl_context_t *ref_ssl_context(avs_net_ssl_context_t *context) {
+    // private contexts are never referenced more than once
+    assert(context->mutex);
+    avs_mutex_lock(context->mutex);
+    ++context->refcount;
+    avs_mutex_unlock(context->mutex);
+    return context;
+}
+
+static void release_ssl_context(avs_net_ssl_context_t **context_ptr) {
+    avs_net_ssl_context_t *context = *context_ptr;
+    if (!context) {
+        return;
+    }
+    *context_ptr = NULL;
+
+    unsigned refcount;
+    if (context->mutex) {
+        avs_mutex_lock(context->mutex);
+        refcount = --context->refcount;
+        avs_mutex_unlock(context->mutex);
+    } else {
+        refcount = --context->refcount;
+    }
+    if (!refcount) {
+        cleanup_ssl_context(context);
+#ifdef WITH_SSL_SESSION_CACHE
+        _avs_net_session_cache_cleanup(&context->session_cache);
+#endif // WITH_SSL_SESSION_CACHE
+        avs_mutex_cleanup(&context->mutex);
+        avs_free(context);
+    }
+}
+
+#ifdef WITH_SSL_SESSION_CACHE
+/*
+ * Client sockets created from a context with a session cache, and not
+ * configured with a session resumption buffer of their own, are given one
+ * backed by a cache slot. connect_ssl() fills it from the cache, and the
+ * backend calls store_cached_session() whenever it saves a new session there.
+ */
+static avs_error_t
+attach_session_cache_slot(ssl_socket_t *socket,
+                          avs_net_ssl_configuration_t *configuration) {
+    if (!socket->context->session_cache
+            || configuration->session_resumption_buffer_size) {
+        return AVS_OK;
+    }
+    if (!(socket->session_cache_slot = _avs_net_session_cache_slot_new(
+                  socket->context->session_cache))) {
+        LOG(ERROR, _("Out of memory"));
+        return avs_errno(AVS_ENOMEM);
+    }
+    configuration->session_resumption_buffer =
+            socket->session_cache_slot->buffer;
+    configuration->session_resumption_buffer_size =
+            socket->session_cache_slot->buffer_size;
+    return AVS_OK;
+}
+
+static void load_cached_session(ssl_socket_t *socket,
+                                const char *host,
+                                const char *port) {
+    if (!socket->session_cache_slot) {
+        return;
+    }
+    _avs_net_session_cache_key_t *key = &socket->session_cache_slot->key;
+    if (avs_simple_snprintf(key->host, sizeof(key->host), "%s", host) < 0
+            || avs_simple_snprintf(key->port, sizeof(key->port), "%s", port)
+                           < 0
+            || avs_simple_snprintf(key->server_name, sizeof(key->server_name),
+                                   "%s", socket->server_name_indication)
+                           < 0) {
+        LOG(DEBUG, _("endpoint name too long, session will not be cached"));
+        key->host[0] = '\0';
+    }
+    _avs_net_session_cache_load(socket->context->session_cache,
+                                socket->session_cache_slot);
+}
+
+static void store_cached_session(ssl_socket_t *socket) {
+    if (socket->session_cache_slot) {
+        _avs_net_session_cache_store(socket->context->session_cache,
+                                     socket->session_cache_slot);
+    }
+}
+#endif // WITH_SSL_SESSION_CACHE
+
 static avs_error_t create_ssl_socket(avs_net_socket_t **socket,
                                      avs_net_socket_type_t backend_type,
                                      const void *socket_configuration) {
@@ -98,6 +301,23 @@ static avs_error_t create_ssl_socket(avs_net_socket_t **socket,
         LOG(ERROR, _("SSL configuration not specified"));
         return avs_errno(AVS_EINVAL);
     }
+    const avs_net_ssl_configuration_t *configuration =
+            (const avs_net_ssl_configuration_t *) socket_configuration;
+
+    avs_net_ssl_context_t *context = NULL;
+    if (configuration->context) {
+        if (configuration->context->backend_type != backend_type) {
+            LOG(ERROR, _("SSL context type does not match the socket type"));
+            return avs_errno(AVS_EINVAL);
+        }
+        context = ref_ssl_context(configuration->context);
+    } else {
+        avs_error_t err = create_ssl_context(&context, backend_type,
+                                             configuration, false);
+        if (avs_is_err(err)) {
+            return err;
+        }
+    }
 
     ssl_socket_t *ssl_sock =
             (ssl_socket_t *) avs_calloc(1, sizeof(ssl_socket_t));
@@ -107,9 +327,25 @@ static avs_error_t create_ssl_socket(avs_net_socket_t **socket,
             _("configure_ssl(socket=") "%p" _(", configuration=") "%p" _(")"),
             (void *) socket, (const void *) socket_configuration);
 
-        avs_error_t err = initialize_ssl_socket(
-                ssl_sock, backend_type,
-                (const avs_net_ssl_configuration_t *) socket_configuration);
+        ssl_sock->context = context;
+#ifdef WITH_SSL_SESSION_CACHE
+        avs_net_ssl_configuration_t slot_configuration = *configuration;
+        avs_error_t err =
+                attach_session_cache_slot(ssl_sock, &slot_configuration);
+        if (avs_is_err(err)) {
+            // initialize_ssl_socket() has not installed the v_table yet, so
+            // avs_net_socket_cleanup() cannot be used
+            release_ssl_context(&ssl_sock->context);
+            avs_free(ssl_sock);
+            *socket = NULL;
+            return err;
+        }
+        err = initialize_ssl_socket(ssl_sock, backend_type,
+                                    &slot_configuration);
+#else  // WITH_SSL_SESSION_CACHE
+        avs_error_t err =
+                initialize_ssl_socket(ssl_sock, backend_type, configuration);
+#endif // WITH_SSL_SESSION_CACHE
         if (avs_is_err(err)) {
             LOG(ERROR, _("socket initialization error"));
             avs_net_socket_cleanup(socket);
@@ -119,6 +355,7 @@ static avs_error_t create_ssl_socket(avs_net_socket_t **socket,
         }
     } else {
         LOG(ERROR, _("Out of memory"));
+        release_ssl_context(&context);
         return avs_errno(AVS_ENOMEM);
     }
 }
@@ -133,6 +370,27 @@ bind_ssl(avs_net_socket_t *socket_, const char *localaddr, const char *port) {
     return avs_net_socket_bind(socket->backend_socket, localaddr, port);
 }
 
+static avs_error_t start_ssl_timed(ssl_socket_t *socket, const char *host) {
+#ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+    const avs_time_monotonic_t started = avs_time_monotonic_now();
+    avs_error_t err = start_ssl(socket, host);
+    if (avs_is_ok(err)) {
+        _avs_net_stats_record_handshake(
+                &socket->stats,
+                avs_time_monotonic_diff(avs_time_monotonic_now(), started));
+    }
+    return err;
+#else  // AVS_COMMONS_NET_WITH_SOCKET_STATS
+    return start_ssl(socket, host);
+#endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
+}
+
+#ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+static avs_net_socket_stats_t *get_stats_ssl(avs_net_socket_t *socket) {
+    return &((ssl_socket_t *) socket)->stats;
+}
+#endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
+
 static avs_error_t
 connect_ssl(avs_net_socket_t *socket_, const char *host, const char *port) {
     ssl_socket_t *socket = (ssl_socket_t *) socket_;
@@ -154,13 +412,47 @@ connect_ssl(avs_net_socket_t *socket_, const char *host, const char *port) {
         LOG(ERROR, _("avs_net_socket_connect() on backend socket failed"));
         return err;
     }
+#ifdef WITH_SSL_SESSION_CACHE
+    load_cached_session(socket, host, port);
+#endif // WITH_SSL_SESSION_CACHE
 
-    if (avs_is_err((err = start_ssl(socket, host)))) {
+    if (avs_is_err((err = start_ssl_timed(socket, host)))) {
         close_ssl_raw(socket);
     }
     return err;
 }
 
+#ifdef WITH_SSL_SERVER_SESSIONS
+static void record_server_handshake(ssl_socket_t *socket) {
+    avs_net_ssl_context_t *context = socket->context;
+    // statistics are only available for shared contexts
+    if (context->mutex) {
+        avs_mutex_lock(context->mutex);
+        ++context->server_session_stats.handshakes;
+        if (is_session_resumed(socket)) {
+            ++context->server_session_stats.resumed;
+        }
+        avs_mutex_unlock(context->mutex);
+    }
+}
+#endif // WITH_SSL_SERVER_SESSIONS
+
+static void set_backend_socket(ssl_socket_t *socket,
+                               avs_net_socket_t *backend_socket) {
+    if (socket->backend_socket) {
+        avs_net_socket_cleanup(&socket->backend_socket);
+    }
+    socket->backend_socket = backend_socket;
+#ifdef WITH_SSL_SESSION_CACHE
+    // the remote endpoint is not known, so the session is not cacheable
+    if (socket->session_cache_slot) {
+        socket->session_cache_slot->key.host[0] = '\0';
+        memset(socket->session_cache_slot->buffer, 0,
+               socket->session_cache_slot->buffer_size);
+    }
+#endif // WITH_SSL_SESSION_CACHE
+}
+
 static avs_error_t decorate_ssl(avs_net_socket_t *socket_,
                                 avs_net_socket_t *backend_socket) {
     ssl_socket_t *socket = (ssl_socket_t *) socket_;
@@ -181,10 +473,7 @@ static avs_error_t decorate_ssl(avs_net_socket_t *socket_,
         return err;
     }
 
-    if (socket->backend_socket) {
-        avs_net_socket_cleanup(&socket->backend_socket);
-    }
-    socket->backend_socket = backend_socket;
+    set_backend_socket(socket, backend_socket);
 
     // If the backend socket is already connected, perform handshake immediately
     // (this is most likely the STARTTLS case). Otherwise, don't do anything,
@@ -195,16 +484,161 @@ static avs_error_t decorate_ssl(avs_net_socket_t *socket_,
         char host[NET_MAX_HOSTNAME_SIZE];
         if (avs_is_ok((err = avs_net_socket_get_remote_hostname(
                                backend_socket, host, sizeof(host))))) {
-            err = start_ssl(socket, host);
+            err = start_ssl_timed(socket, host);
         }
+#ifdef WITH_SSL_SERVER_SESSIONS
+        if (avs_is_ok(err)
+                && backend_state.state == AVS_NET_SOCKET_STATE_ACCEPTED) {
+            record_server_handshake(socket);
+        }
+#endif // WITH_SSL_SERVER_SESSIONS
+    }
+    if (avs_is_err(err)) {
+        socket->backend_socket = NULL;
+        close_ssl_raw(socket);
+    }
+    return err;
+}
+
+#ifdef WITH_SSL_ASYNC_HANDSHAKE
+/*
+ * Only the thread that performs a step, either the one that called
+ * avs_net_socket_decorate_async() or avs_net_socket_handshake_continue(), or
+ * a handshake pool worker, touches the socket while the step is in progress.
+ */
+static avs_error_t finish_handshake_step(ssl_socket_t *socket,
+                                         avs_error_t err) {
+    if (is_handshake_pending(err)) {
+        return err;
+    }
+    socket->async_handshake.in_progress = false;
+    if (avs_is_ok(err)) {
+#    ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+        _avs_net_stats_record_handshake(
+                &socket->stats,
+                avs_time_monotonic_diff(avs_time_monotonic_now(),
+                                        socket->async_handshake.started));
+#    endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
+#    ifdef WITH_SSL_SERVER_SESSIONS
+        if (socket->async_handshake.accepted) {
+            record_server_handshake(socket);
+        }
+#    endif // WITH_SSL_SERVER_SESSIONS
+    }
+    return err;
+}
+
+#    ifdef AVS_COMMONS_NET_WITH_HANDSHAKE_POOL
+static avs_error_t handshake_step_job(avs_net_socket_t *socket) {
+    return handshake_step((ssl_socket_t *) socket);
+}
+#    endif // AVS_COMMONS_NET_WITH_HANDSHAKE_POOL
+
+static avs_error_t run_handshake_step(ssl_socket_t *socket) {
+#    ifdef AVS_COMMONS_NET_WITH_HANDSHAKE_POOL
+    if (socket->async_handshake.pool) {
+        avs_error_t err = _avs_net_handshake_pool_submit(
+                socket->async_handshake.pool, (avs_net_socket_t *) socket,
+                handshake_step_job);
+        if (avs_is_err(err)) {
+            return finish_handshake_step(socket, err);
+        }
+        socket->async_handshake.submitted = true;
+        return avs_errno(AVS_EINPROGRESS);
+    }
+#    endif // AVS_COMMONS_NET_WITH_HANDSHAKE_POOL
+    return finish_handshake_step(socket, handshake_step(socket));
+}
+
+static avs_error_t decorate_async_ssl(avs_net_socket_t *socket_,
+                                      avs_net_socket_t *backend_socket,
+                                      avs_net_handshake_pool_t *pool) {
+    ssl_socket_t *socket = (ssl_socket_t *) socket_;
+    LOG(TRACE,
+        _("decorate_async_ssl(socket=") "%p" _(", backend_socket=") "%p" _(
+                ", pool=") "%p" _(")"),
+        (void *) socket, (void *) backend_socket, (void *) pool);
+
+    if (is_ssl_started(socket)) {
+        LOG(ERROR, _("SSL socket already connected"));
+        return avs_errno(AVS_EISCONN);
+    }
+    if (socket->backend_type != AVS_NET_TCP_SOCKET) {
+        LOG(ERROR, _("asynchronous handshakes are not supported for DTLS"));
+        return avs_errno(AVS_ENOTSUP);
+    }
+#    ifndef AVS_COMMONS_NET_WITH_HANDSHAKE_POOL
+    if (pool) {
+        LOG(ERROR, _("handshake pools not supported"));
+        return avs_errno(AVS_ENOTSUP);
     }
+#    endif // AVS_COMMONS_NET_WITH_HANDSHAKE_POOL
+    avs_net_socket_opt_value_t backend_state;
+    avs_error_t err =
+            avs_net_socket_get_opt(backend_socket, AVS_NET_SOCKET_OPT_STATE,
+                                   &backend_state);
     if (avs_is_err(err)) {
+        LOG(ERROR, _("Could not get backend socket state"));
+        return err;
+    }
+    if (backend_state.state != AVS_NET_SOCKET_STATE_ACCEPTED
+            && backend_state.state != AVS_NET_SOCKET_STATE_CONNECTED) {
+        LOG(ERROR, _("backend socket is not connected"));
+        return avs_errno(AVS_ENOTCONN);
+    }
+    char host[NET_MAX_HOSTNAME_SIZE];
+    if (avs_is_err((err = avs_net_socket_get_remote_hostname(
+                            backend_socket, host, sizeof(host))))) {
+        return err;
+    }
+
+    set_backend_socket(socket, backend_socket);
+    socket->async_handshake.pool = pool;
+    socket->async_handshake.accepted =
+            (backend_state.state == AVS_NET_SOCKET_STATE_ACCEPTED);
+#    ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+    socket->async_handshake.started = avs_time_monotonic_now();
+#    endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
+    socket->async_handshake.in_progress = true;
+    if (avs_is_err((err = prepare_ssl(socket, host)))) {
+        socket->async_handshake.in_progress = false;
+    } else {
+        err = run_handshake_step(socket);
+    }
+    if (avs_is_err(err) && !is_handshake_pending(err)) {
         socket->backend_socket = NULL;
         close_ssl_raw(socket);
     }
     return err;
 }
 
+static avs_error_t handshake_continue_ssl(avs_net_socket_t *socket_) {
+    ssl_socket_t *socket = (ssl_socket_t *) socket_;
+    if (!socket->async_handshake.in_progress) {
+        return is_ssl_started(socket) ? AVS_OK : avs_errno(AVS_EBADF);
+    }
+
+    avs_error_t err;
+#    ifdef AVS_COMMONS_NET_WITH_HANDSHAKE_POOL
+    if (socket->async_handshake.submitted) {
+        if (!_avs_net_handshake_pool_take_result(socket->async_handshake.pool,
+                                                 socket_, &err)) {
+            return avs_errno(AVS_EINPROGRESS);
+        }
+        socket->async_handshake.submitted = false;
+        err = finish_handshake_step(socket, err);
+    } else
+#    endif // AVS_COMMONS_NET_WITH_HANDSHAKE_POOL
+    {
+        err = run_handshake_step(socket);
+    }
+    if (avs_is_err(err) && !is_handshake_pending(err)) {
+        close_ssl_raw(socket);
+    }
+    return err;
+}
+#endif // WITH_SSL_ASYNC_HANDSHAKE
+
 static const void *system_socket_ssl(avs_net_socket_t *socket_) {
     ssl_socket_t *socket = (ssl_socket_t *) socket_;
     if (socket->backend_socket) {
@@ -223,6 +657,15 @@ static avs_error_t shutdown_ssl(avs_net_socket_t *socket_) {
 static avs_error_t close_ssl(avs_net_socket_t *socket_) {
     ssl_socket_t *socket = (ssl_socket_t *) socket_;
     LOG(TRACE, _("close_ssl(socket=") "%p" _(")"), (void *) socket);
+#ifdef WITH_SSL_ASYNC_HANDSHAKE
+#    ifdef AVS_COMMONS_NET_WITH_HANDSHAKE_POOL
+    if (socket->async_handshake.submitted) {
+        _avs_net_handshake_pool_cancel(socket->async_handshake.pool, socket_);
+        socket->async_handshake.submitted = false;
+    }
+#    endif // AVS_COMMONS_NET_WITH_HANDSHAKE_POOL
+    socket->async_handshake.in_progress = false;
+#endif // WITH_SSL_ASYNC_HANDSHAKE
     close_ssl_raw(socket);
     return AVS_OK;
 }
@@ -405,6 +848,10 @@ static avs_error_t get_opt_ssl(avs_net_socket_t *ssl_socket_,
     case AVS_NET_SOCKET_OPT_SESSION_RESUMED:
         out_option_value->flag = is_session_resumed(ssl_socket);
         return AVS_OK;
+    case AVS_NET_SOCKET_OPT_DATAGRAM:
+        out_option_value->flag =
+                (ssl_socket->backend_type == AVS_NET_UDP_SOCKET);
+        return AVS_OK;
     case AVS_NET_SOCKET_HAS_BUFFERED_DATA:
         if (has_buffered_data(ssl_socket)) {
             out_option_value->flag = true;
@@ -440,6 +887,52 @@ avs_error_t _avs_net_create_dtls_socket(avs_net_socket_t **socket,
     return create_ssl_socket(socket, AVS_NET_UDP_SOCKET, socket_configuration);
 }
 
+avs_error_t
+_avs_net_create_ssl_context(avs_net_ssl_context_t **out_context,
+                            const avs_net_ssl_configuration_t *configuration) {
+    return create_ssl_context(out_context, AVS_NET_TCP_SOCKET, configuration,
+                              true);
+}
+
+avs_error_t
+_avs_net_create_dtls_context(avs_net_ssl_context_t **out_context,
+                             const avs_net_ssl_configuration_t *configuration) {
+    return create_ssl_context(out_context, AVS_NET_UDP_SOCKET, configuration,
+                              true);
+}
+
+void _avs_net_release_ssl_context(avs_net_ssl_context_t **context) {
+    release_ssl_context(context);
+}
+
+avs_error_t _avs_net_ssl_context_get_server_session_stats(
+        avs_net_ssl_context_t *context,
+        avs_net_ssl_server_session_stats_t *out_stats) {
+#ifdef WITH_SSL_SERVER_SESSIONS
+    assert(context->mutex);
+    avs_mutex_lock(context->mutex);
+    *out_stats = context->server_session_stats;
+    avs_mutex_unlock(context->mutex);
+    return AVS_OK;
+#else  // WITH_SSL_SERVER_SESSIONS
+    (void) context;
+    (void) out_stats;
+    return avs_errno(AVS_ENOTSUP);
+#endif // WITH_SSL_SERVER_SESSIONS
+}
+
+#ifdef AVS_COMMONS_NET_WITH_TLS_SESSION_CACHE
+_avs_net_session_cache_t *
+_avs_net_ssl_context_session_cache(avs_net_ssl_context_t *context) {
+#    ifdef WITH_SSL_SESSION_CACHE
+    return context->session_cache;
+#    else  // WITH_SSL_SESSION_CACHE
+    (void) context;
+    return NULL;
+#    endif // WITH_SSL_SESSION_CACHE
+}
+#endif // AVS_COMMONS_NET_WITH_TLS_SESSION_CACHE
+
 static const avs_net_socket_v_table_t ssl_vtable = {
     .connect = connect_ssl,
     .decorate = decorate_ssl,
@@ -457,7 +950,14 @@ static const avs_net_socket_v_table_t ssl_vtable = {
     .get_local_host = local_host_ssl,
     .get_local_port = local_port_ssl,
     .get_opt = get_opt_ssl,
-    .set_opt = set_opt_ssl
+    .set_opt = set_opt_ssl,
+#ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+    .get_stats = get_stats_ssl,
+#endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
+#ifdef WITH_SSL_ASYNC_HANDSHAKE
+    .decorate_async = decorate_async_ssl,
+    .handshake_continue = handshake_continue_ssl
+#endif // WITH_SSL_ASYNC_HANDSHAKE
 };
 
 const avs_net_dtls_handshake_timeouts_t
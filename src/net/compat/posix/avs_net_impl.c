@@ -18,6 +18,11 @@
 
 #include <avsystem/commons/avs_commons_config.h>
 
+#if defined(AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_RECVMMSG) \
+        || defined(AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDMMSG)
+#    define _GNU_SOURCE // for recvmmsg() and sendmmsg()
+#endif
+
 #if defined(AVS_COMMONS_WITH_AVS_NET) \
         && defined(AVS_COMMONS_NET_WITH_POSIX_AVS_SOCKET)
 
@@ -41,6 +46,15 @@
 #        include <ifaddrs.h>
 #    endif
 
+#    if defined(AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_UDP_SEGMENT) \
+            || defined(AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_UDP_GRO)
+#        include <netinet/udp.h>
+#    endif
+
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDFILE
+#        include <sys/sendfile.h>
+#    endif
+
 #    include "avs_compat.h"
 
 VISIBILITY_SOURCE_BEGIN
@@ -166,6 +180,56 @@ static avs_error_t receive_from_net(avs_net_socket_t *net_socket,
                                     size_t host_size,
                                     char *port,
                                     size_t port_size);
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDMMSG
+static avs_error_t
+send_batch_net(avs_net_socket_t *net_socket,
+               const avs_net_socket_outgoing_datagram_t *datagrams,
+               size_t count,
+               size_t *out_sent);
+#    endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDMMSG
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_RECVMMSG
+static avs_error_t
+receive_batch_net(avs_net_socket_t *net_socket,
+                  avs_net_socket_received_datagram_t *datagrams,
+                  size_t count,
+                  size_t *out_received);
+#    endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_RECVMMSG
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_UDP_SEGMENT
+static avs_error_t send_segmented_net(avs_net_socket_t *net_socket,
+                                      const void *buffer,
+                                      size_t length,
+                                      size_t segment_size);
+#    endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_UDP_SEGMENT
+#    if defined(AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_UDP_GRO) \
+            && defined(AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_RECVMSG)
+#        define NET_HAVE_UDP_GRO
+static avs_error_t receive_segmented_net(avs_net_socket_t *net_socket,
+                                         size_t *out_bytes_received,
+                                         void *buffer,
+                                         size_t buffer_length,
+                                         size_t *out_segment_size);
+#    endif
+#    if defined(AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDFILE) \
+            && defined(AVS_COMMONS_STREAM_WITH_FILE)
+#        define NET_HAVE_SEND_FILE
+static avs_error_t send_file_net(avs_net_socket_t *net_socket,
+                                 FILE *file,
+                                 size_t length,
+                                 size_t *out_bytes_sent);
+#    endif // defined(AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDFILE) &&
+           // defined(AVS_COMMONS_STREAM_WITH_FILE)
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_RECVMSG
+static avs_error_t sendv_net(avs_net_socket_t *net_socket,
+                             const avs_net_socket_outgoing_buffer_t *buffers,
+                             size_t count);
+static avs_error_t receivev_net(avs_net_socket_t *net_socket,
+                                size_t *out_bytes_received,
+                                const avs_net_socket_incoming_buffer_t *buffers,
+                                size_t count);
+#    endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_RECVMSG
+#    ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+static avs_net_socket_stats_t *get_stats_net(avs_net_socket_t *net_socket);
+#    endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
 static avs_error_t
 bind_net(avs_net_socket_t *net_socket, const char *localaddr, const char *port);
 static avs_error_t accept_net(avs_net_socket_t *server_net_socket,
@@ -217,7 +281,29 @@ static const avs_net_socket_v_table_t net_vtable = {
     .get_local_host = local_host_net,
     .get_local_port = local_port_net,
     .get_opt = get_opt_net,
-    .set_opt = set_opt_net
+    .set_opt = set_opt_net,
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDMMSG
+    .send_batch = send_batch_net,
+#    endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDMMSG
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_RECVMMSG
+    .receive_batch = receive_batch_net,
+#    endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_RECVMMSG
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_UDP_SEGMENT
+    .send_segmented = send_segmented_net,
+#    endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_UDP_SEGMENT
+#    ifdef NET_HAVE_UDP_GRO
+    .receive_segmented = receive_segmented_net,
+#    endif // NET_HAVE_UDP_GRO
+#    ifdef NET_HAVE_SEND_FILE
+    .send_file = send_file_net,
+#    endif // NET_HAVE_SEND_FILE
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_RECVMSG
+    .sendv = sendv_net,
+    .receivev = receivev_net,
+#    endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_RECVMSG
+#    ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+    .get_stats = get_stats_net,
+#    endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
 };
 
 typedef struct {
@@ -231,6 +317,9 @@ typedef struct {
 
     uint64_t bytes_received;
     uint64_t bytes_sent;
+#    ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+    avs_net_socket_stats_t stats;
+#    endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
 
     avs_time_duration_t recv_timeout;
 } net_socket_impl_t;
@@ -411,6 +500,12 @@ static const void *system_socket_net(avs_net_socket_t *net_socket_) {
     }
 }
 
+#    ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+static avs_net_socket_stats_t *get_stats_net(avs_net_socket_t *net_socket) {
+    return &((net_socket_impl_t *) net_socket)->stats;
+}
+#    endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
+
 static void close_net_raw(net_socket_impl_t *net_socket) {
     if (net_socket->socket != INVALID_SOCKET) {
         close(net_socket->socket);
@@ -485,6 +580,10 @@ static sa_family_t get_connection_family(sockfd_t fd) {
 #        define IPV6_TRANSPARENT 75
 #    endif
 
+#    if !defined(SO_REUSEPORT) && defined(__linux__)
+#        define SO_REUSEPORT 15
+#    endif
+
 static avs_error_t configure_socket(net_socket_impl_t *net_socket) {
     errno = 0;
     LOG(TRACE, _("configuration '") "%s" _("' 0x") "%02x" _(" 0x") "%02x",
@@ -722,15 +821,63 @@ static avs_error_t wait_until_ready(const volatile sockfd_t *sockfd_ptr,
 
 typedef avs_error_t call_when_ready_cb_t(sockfd_t sockfd, void *arg);
 
-static avs_error_t call_when_ready(const volatile sockfd_t *sockfd_ptr,
-                                   avs_time_duration_t timeout,
-                                   int flags,
-                                   call_when_ready_cb_t *callback,
-                                   void *callback_arg) {
+static avs_error_t call_counted(call_when_ready_cb_t *callback,
+                                sockfd_t sockfd,
+                                void *callback_arg,
+                                _avs_net_io_counters_t *counters) {
+    avs_error_t error = callback(sockfd, callback_arg);
+    if (counters) {
+        ++counters->syscalls;
+        if (error.category == AVS_ERRNO_CATEGORY
+                && error.code == AVS_EAGAIN) {
+            ++counters->would_block;
+        }
+    }
+    return error;
+}
+
+static avs_error_t wait_counted(const volatile sockfd_t *sockfd_ptr,
+                                avs_time_monotonic_t deadline,
+                                int flags,
+                                _avs_net_io_counters_t *counters) {
+    if (!counters) {
+        return wait_until_ready(sockfd_ptr, deadline, flags);
+    }
+    const avs_time_monotonic_t started = avs_time_monotonic_now();
+    avs_error_t error = wait_until_ready(sockfd_ptr, deadline, flags);
+    ++counters->polls;
+    counters->poll_wait_time = avs_time_duration_add(
+            counters->poll_wait_time,
+            avs_time_monotonic_diff(avs_time_monotonic_now(), started));
+    return error;
+}
+
+static avs_error_t call_when_ready_impl(const volatile sockfd_t *sockfd_ptr,
+                                        avs_time_duration_t timeout,
+                                        int flags,
+                                        bool optimistic,
+                                        call_when_ready_cb_t *callback,
+                                        void *callback_arg,
+                                        _avs_net_io_counters_t *counters) {
     avs_error_t error;
+    if (optimistic) {
+        // The socket is non-blocking, so just try the operation first - if
+        // data is already queued (or there is space in the send buffer), this
+        // saves the poll() call.
+        sockfd_t sockfd = *sockfd_ptr;
+        if (sockfd == INVALID_SOCKET) {
+            return avs_errno(AVS_EBADF);
+        }
+        error = call_counted(callback, sockfd, callback_arg, counters);
+        if (error.category != AVS_ERRNO_CATEGORY
+                || (error.code != AVS_EAGAIN && error.code != AVS_EINTR)) {
+            return error;
+        }
+    }
     avs_time_monotonic_t deadline =
             avs_time_monotonic_add(avs_time_monotonic_now(), timeout);
-    while (avs_is_ok((error = wait_until_ready(sockfd_ptr, deadline, flags)))) {
+    while (avs_is_ok((error = wait_counted(sockfd_ptr, deadline, flags,
+                                           counters)))) {
         do {
             sockfd_t sockfd = *sockfd_ptr;
             if (sockfd == INVALID_SOCKET) {
@@ -738,7 +885,7 @@ static avs_error_t call_when_ready(const volatile sockfd_t *sockfd_ptr,
                 // or something like this
                 error = avs_errno(AVS_EBADF);
             } else {
-                error = callback(sockfd, callback_arg);
+                error = call_counted(callback, sockfd, callback_arg, counters);
             }
         } while (error.category == AVS_ERRNO_CATEGORY && error.code == AVS_EINTR
                  && !avs_time_monotonic_before(deadline,
@@ -759,6 +906,26 @@ static avs_error_t call_when_ready(const volatile sockfd_t *sockfd_ptr,
     return error;
 }
 
+static avs_error_t call_when_ready(net_socket_impl_t *net_socket,
+                                   avs_time_duration_t timeout,
+                                   int flags,
+                                   bool optimistic,
+                                   call_when_ready_cb_t *callback,
+                                   void *callback_arg) {
+#    ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+    _avs_net_io_counters_t counters;
+    memset(&counters, 0, sizeof(counters));
+    avs_error_t error =
+            call_when_ready_impl(&net_socket->socket, timeout, flags,
+                                 optimistic, callback, callback_arg, &counters);
+    _avs_net_stats_record_io(&net_socket->stats, &counters);
+    return error;
+#    else  // AVS_COMMONS_NET_WITH_SOCKET_STATS
+    return call_when_ready_impl(&net_socket->socket, timeout, flags,
+                                optimistic, callback, callback_arg, NULL);
+#    endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
+}
+
 static avs_error_t
 connect_with_timeout(const volatile sockfd_t *sockfd_ptr,
                      const sockaddr_endpoint_union_t *endpoint) {
@@ -1034,15 +1201,13 @@ resolve_addrinfo_for_socket(net_socket_impl_t *net_socket,
                     : NULL);
 }
 
-static avs_error_t
-try_connect_open_socket(net_socket_impl_t *net_socket,
-                        const sockaddr_endpoint_union_t *address) {
+static avs_error_t finish_connect(net_socket_impl_t *net_socket,
+                                  const sockaddr_endpoint_union_t *address) {
     bool socket_is_stream = (net_socket->type == AVS_NET_TCP_SOCKET);
     avs_error_t err;
-    if (avs_is_err((err = connect_with_timeout(&net_socket->socket, address)))
-            || (socket_is_stream
-                && avs_is_err((err = send_net((avs_net_socket_t *) net_socket,
-                                              NULL, 0))))) {
+    if (socket_is_stream
+            && avs_is_err((err = send_net((avs_net_socket_t *) net_socket,
+                                          NULL, 0)))) {
         return err;
     } else {
         /* SUCCESS */
@@ -1055,6 +1220,16 @@ try_connect_open_socket(net_socket_impl_t *net_socket,
     }
 }
 
+static avs_error_t
+try_connect_open_socket(net_socket_impl_t *net_socket,
+                        const sockaddr_endpoint_union_t *address) {
+    avs_error_t err = connect_with_timeout(&net_socket->socket, address);
+    if (avs_is_err(err)) {
+        return err;
+    }
+    return finish_connect(net_socket, address);
+}
+
 static avs_error_t try_connect(net_socket_impl_t *net_socket,
                                const sockaddr_endpoint_union_t *address) {
     char socket_was_already_open = (net_socket->socket != INVALID_SOCKET);
@@ -1083,6 +1258,280 @@ static avs_error_t try_connect(net_socket_impl_t *net_socket,
     return err;
 }
 
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_POLL
+/**
+ * Maximum number of connection attempts that may be in progress at the same
+ * time when connecting in the "Happy Eyeballs" (RFC 8305) mode.
+ */
+#        define NET_MAX_PARALLEL_CONNECTS 8
+
+typedef struct {
+    avs_net_addrinfo_t *info;
+    bool resolved;
+    bool exhausted;
+} connect_candidates_t;
+
+typedef struct {
+    net_socket_impl_t *net_socket;
+    const char *host;
+    const char *port;
+    /**
+     * If true, addresses of the preferred and the other family are tried
+     * alternately. Otherwise, the other family is only tried after all
+     * attempts using the preferred one have failed.
+     */
+    bool interleave;
+    /* [0] - preferred family, [1] - other families; resolved lazily */
+    connect_candidates_t candidates[2];
+    size_t next_family;
+
+    size_t num_attempts;
+    struct pollfd fds[NET_MAX_PARALLEL_CONNECTS];
+    sockaddr_endpoint_union_t addresses[NET_MAX_PARALLEL_CONNECTS];
+    avs_time_monotonic_t deadlines[NET_MAX_PARALLEL_CONNECTS];
+} parallel_connect_t;
+
+static bool connect_candidates_available(parallel_connect_t *ctx,
+                                         size_t family) {
+    connect_candidates_t *candidates = &ctx->candidates[family];
+    if (family > 0 && !ctx->interleave
+            && (!ctx->candidates[0].exhausted || ctx->num_attempts)) {
+        return false;
+    }
+    if (!candidates->resolved) {
+        candidates->resolved = true;
+        if (!(candidates->info = resolve_addrinfo_for_socket(
+                      ctx->net_socket, ctx->host, ctx->port, true,
+                      family > 0 ? PREFERRED_FAMILY_BLOCKED
+                                 : PREFERRED_FAMILY_ONLY))) {
+            candidates->exhausted = true;
+        }
+    }
+    return !candidates->exhausted;
+}
+
+static bool next_connect_candidate(parallel_connect_t *ctx,
+                                   sockaddr_endpoint_union_t *out_address) {
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(ctx->candidates); ++i) {
+        size_t family =
+                (ctx->next_family + i) % AVS_ARRAY_SIZE(ctx->candidates);
+        if (!connect_candidates_available(ctx, family)) {
+            continue;
+        }
+        if (!avs_net_addrinfo_next(ctx->candidates[family].info,
+                                   &out_address->api_ep)) {
+            if (ctx->interleave) {
+                ctx->next_family =
+                        (family + 1) % AVS_ARRAY_SIZE(ctx->candidates);
+            }
+            return true;
+        }
+        ctx->candidates[family].exhausted = true;
+    }
+    return false;
+}
+
+static avs_error_t
+start_connect_attempt(parallel_connect_t *ctx,
+                      const sockaddr_endpoint_union_t *address,
+                      avs_time_monotonic_t now) {
+    net_socket_impl_t *net_socket = ctx->net_socket;
+    assert(net_socket->socket == INVALID_SOCKET);
+    assert(ctx->num_attempts < NET_MAX_PARALLEL_CONNECTS);
+    avs_error_t err = AVS_OK;
+    if ((net_socket->socket =
+                 socket(address->sockaddr_ep.addr.sa_family,
+                        _avs_net_get_socket_type(net_socket->type),
+                        get_socket_proto(net_socket->type)))
+            == INVALID_SOCKET) {
+        err = failure_from_errno();
+        LOG(ERROR, _("cannot create socket: ") "%s",
+            avs_strerror((avs_errno_t) err.code));
+        return err;
+    }
+    if (avs_is_err((err = configure_socket(net_socket)))) {
+        LOG(WARNING, _("socket configuration problem"));
+    } else if (connect(net_socket->socket, &address->sockaddr_ep.addr,
+                       address->sockaddr_ep.header.size)
+                       == -1
+               && errno != EINPROGRESS) {
+        err = failure_from_errno();
+    }
+    if (avs_is_ok(err)) {
+        size_t i = ctx->num_attempts++;
+        ctx->fds[i].fd = net_socket->socket;
+        ctx->fds[i].events = POLLOUT;
+        ctx->fds[i].revents = 0;
+        ctx->addresses[i] = *address;
+        ctx->deadlines[i] = avs_time_monotonic_add(now, NET_CONNECT_TIMEOUT);
+    } else {
+        close(net_socket->socket);
+    }
+    net_socket->socket = INVALID_SOCKET;
+    return err;
+}
+
+static void remove_connect_attempt(parallel_connect_t *ctx, size_t index) {
+    assert(index < ctx->num_attempts);
+    --ctx->num_attempts;
+    ctx->fds[index] = ctx->fds[ctx->num_attempts];
+    ctx->addresses[index] = ctx->addresses[ctx->num_attempts];
+    ctx->deadlines[index] = ctx->deadlines[ctx->num_attempts];
+}
+
+static int parallel_connect_timeout_ms(const parallel_connect_t *ctx,
+                                       avs_time_monotonic_t next_attempt,
+                                       avs_time_monotonic_t now) {
+    avs_time_monotonic_t wake_up = ctx->deadlines[0];
+    for (size_t i = 1; i < ctx->num_attempts; ++i) {
+        if (avs_time_monotonic_before(ctx->deadlines[i], wake_up)) {
+            wake_up = ctx->deadlines[i];
+        }
+    }
+    if (ctx->num_attempts < NET_MAX_PARALLEL_CONNECTS
+            && avs_time_monotonic_before(next_attempt, wake_up)) {
+        wake_up = next_attempt;
+    }
+    avs_time_duration_t remaining = avs_time_monotonic_diff(wake_up, now);
+    int64_t timeout_ms;
+    if (avs_time_duration_to_scalar(&timeout_ms, AVS_TIME_MS, remaining)
+            || timeout_ms >= INT_MAX) {
+        return INT_MAX;
+    }
+    // round up, so that we don't wake up just before the deadline
+    if (avs_time_duration_less(
+                avs_time_duration_from_scalar(timeout_ms, AVS_TIME_MS),
+                remaining)) {
+        ++timeout_ms;
+    }
+    return timeout_ms < 0 ? 0 : (int) timeout_ms;
+}
+
+/**
+ * Checks the connection attempts after poll(). Finished attempts are removed;
+ * if one of them succeeded, the socket is stored in @p ctx->net_socket.
+ *
+ * @returns true if an attempt has been removed due to failure or timeout.
+ */
+static bool handle_connect_attempts(parallel_connect_t *ctx,
+                                    avs_time_monotonic_t now,
+                                    avs_error_t *inout_err) {
+    net_socket_impl_t *net_socket = ctx->net_socket;
+    bool any_failed = false;
+    for (size_t i = ctx->num_attempts; i-- > 0;) {
+        avs_error_t err;
+        if (ctx->fds[i].revents) {
+            int error_code = 0;
+            socklen_t length = sizeof(error_code);
+            if (getsockopt(ctx->fds[i].fd, SOL_SOCKET, SO_ERROR, &error_code,
+                           &length)) {
+                err = failure_from_errno();
+            } else if (error_code) {
+                err = avs_errno(avs_map_errno(error_code));
+            } else {
+                net_socket->socket = ctx->fds[i].fd;
+                if (avs_is_ok(
+                            (err = finish_connect(net_socket,
+                                                  &ctx->addresses[i])))) {
+                    remove_connect_attempt(ctx, i);
+                    *inout_err = AVS_OK;
+                    return any_failed;
+                }
+                net_socket->socket = INVALID_SOCKET;
+            }
+        } else if (!avs_time_monotonic_before(now, ctx->deadlines[i])) {
+            err = avs_errno(AVS_ETIMEDOUT);
+        } else {
+            continue;
+        }
+        LOG(DEBUG, _("connection attempt failed: ") "%s",
+            avs_strerror((avs_errno_t) err.code));
+        close(ctx->fds[i].fd);
+        remove_connect_attempt(ctx, i);
+        *inout_err = err;
+        any_failed = true;
+    }
+    return any_failed;
+}
+
+/**
+ * Connects a TCP socket using staggered, parallel connection attempts, as
+ * described in RFC 8305. A new attempt is started every @p attempt_delay, or
+ * immediately after a previous one failed, and the first attempt to succeed
+ * is used.
+ */
+static avs_error_t connect_parallel(net_socket_impl_t *net_socket,
+                                    const char *host,
+                                    const char *port,
+                                    avs_time_duration_t attempt_delay) {
+    parallel_connect_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.net_socket = net_socket;
+    ctx.host = host;
+    ctx.port = port;
+    ctx.interleave =
+            (net_socket->configuration.address_family == AVS_NET_AF_UNSPEC
+             && net_socket->configuration.preferred_family
+                            == AVS_NET_AF_UNSPEC);
+
+    avs_error_t err = avs_errno(AVS_EADDRNOTAVAIL);
+    avs_time_monotonic_t next_attempt = avs_time_monotonic_now();
+    while (net_socket->socket == INVALID_SOCKET) {
+        avs_time_monotonic_t now = avs_time_monotonic_now();
+        if (avs_time_monotonic_valid(next_attempt)
+                && !avs_time_monotonic_before(now, next_attempt)
+                && ctx.num_attempts < NET_MAX_PARALLEL_CONNECTS) {
+            sockaddr_endpoint_union_t address;
+            if (!next_connect_candidate(&ctx, &address)) {
+                next_attempt = AVS_TIME_MONOTONIC_INVALID;
+                if (!ctx.num_attempts) {
+                    break;
+                }
+            } else {
+                avs_error_t attempt_err =
+                        start_connect_attempt(&ctx, &address, now);
+                if (avs_is_err(attempt_err)) {
+                    // try the next address immediately
+                    err = attempt_err;
+                    continue;
+                }
+                next_attempt = avs_time_monotonic_add(now, attempt_delay);
+            }
+        }
+
+        assert(ctx.num_attempts > 0);
+        errno = 0;
+        if (poll(ctx.fds, (nfds_t) ctx.num_attempts,
+                 parallel_connect_timeout_ms(&ctx, next_attempt, now))
+                < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            err = failure_from_errno();
+            break;
+        }
+        now = avs_time_monotonic_now();
+        if (handle_connect_attempts(&ctx, now, &err)) {
+            next_attempt = now;
+        }
+    }
+
+    for (size_t i = 0; i < ctx.num_attempts; ++i) {
+        close(ctx.fds[i].fd);
+    }
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(ctx.candidates); ++i) {
+        avs_net_addrinfo_delete(&ctx.candidates[i].info);
+    }
+    if (net_socket->socket != INVALID_SOCKET) {
+        return AVS_OK;
+    }
+    LOG(ERROR, _("cannot establish connection to [") "%s" _("]:") "%s", host,
+        port);
+    assert(avs_is_err(err));
+    return err;
+}
+#    endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_POLL
+
 static avs_error_t connect_impl(net_socket_impl_t *net_socket,
                                 const char *host,
                                 const char *port) {
@@ -1098,6 +1547,19 @@ static avs_error_t connect_impl(net_socket_impl_t *net_socket,
 
     LOG(TRACE, _("connecting to [") "%s" _("]:") "%s", host, port);
 
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_POLL
+    if (net_socket->type == AVS_NET_TCP_SOCKET
+            && net_socket->socket == INVALID_SOCKET) {
+        avs_time_duration_t attempt_delay =
+                net_socket->configuration.connection_attempt_delay;
+        if (avs_time_duration_valid(attempt_delay)
+                && avs_time_duration_less(AVS_TIME_DURATION_ZERO,
+                                          attempt_delay)) {
+            return connect_parallel(net_socket, host, port, attempt_delay);
+        }
+    }
+#    endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_POLL
+
     errno = 0;
     avs_error_t err = avs_errno(AVS_EADDRNOTAVAIL);
     if ((info = resolve_addrinfo_for_socket(net_socket, host, port, true,
@@ -1192,8 +1654,10 @@ static avs_error_t send_net(avs_net_socket_t *net_socket_,
     /* send at least one datagram, even if zero-length - hence do..while */
     do {
         avs_error_t err =
-                call_when_ready(&net_socket->socket, NET_SEND_TIMEOUT,
-                                AVS_POLLOUT | AVS_POLLERR, send_internal, &arg);
+                call_when_ready(net_socket, NET_SEND_TIMEOUT,
+                                AVS_POLLOUT | AVS_POLLERR,
+                                net_socket->configuration.optimistic_io,
+                                send_internal, &arg);
         if (avs_is_err(err)) {
             LOG(ERROR, _("send failed"));
             return err;
@@ -1257,8 +1721,10 @@ static avs_error_t send_to_resolved(net_socket_impl_t *net_socket,
     };
 
     avs_error_t err =
-            call_when_ready(&net_socket->socket, NET_SEND_TIMEOUT,
-                            AVS_POLLOUT | AVS_POLLERR, send_to_internal, &arg);
+            call_when_ready(net_socket, NET_SEND_TIMEOUT,
+                            AVS_POLLOUT | AVS_POLLERR,
+                            net_socket->configuration.optimistic_io,
+                            send_to_internal, &arg);
     net_socket->bytes_sent += arg.bytes_sent;
     return err;
 }
@@ -1398,8 +1864,10 @@ static avs_error_t receive_net(avs_net_socket_t *net_socket_,
         .buffer_length = buffer_length
     };
     avs_error_t err =
-            call_when_ready(&net_socket->socket, net_socket->recv_timeout,
-                            AVS_POLLIN | AVS_POLLERR, recvfrom_internal, &arg);
+            call_when_ready(net_socket, net_socket->recv_timeout,
+                            AVS_POLLIN | AVS_POLLERR,
+                            net_socket->configuration.optimistic_io,
+                            recvfrom_internal, &arg);
     *out = arg.bytes_received;
     net_socket->bytes_received += arg.bytes_received;
     return err;
@@ -1430,8 +1898,10 @@ static avs_error_t receive_from_net(avs_net_socket_t *net_socket_,
         .src_addr_length = &src_addr_length
     };
     avs_error_t err =
-            call_when_ready(&net_socket->socket, net_socket->recv_timeout,
-                            AVS_POLLIN | AVS_POLLERR, recvfrom_internal, &arg);
+            call_when_ready(net_socket, net_socket->recv_timeout,
+                            AVS_POLLIN | AVS_POLLERR,
+                            net_socket->configuration.optimistic_io,
+                            recvfrom_internal, &arg);
     net_socket->bytes_received += arg.bytes_received;
     *out = arg.bytes_received;
     if (avs_is_ok(err)
@@ -1448,6 +1918,657 @@ static avs_error_t receive_from_net(avs_net_socket_t *net_socket_,
     return err;
 }
 
+#    if defined(AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_RECVMMSG) \
+            || defined(AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDMMSG)
+/**
+ * Maximum number of datagrams passed to a single recvmmsg() or sendmmsg()
+ * call. The message headers and addresses are allocated on stack, so this is
+ * a tradeoff between stack usage and the number of system calls.
+ */
+#        define NET_BATCH_CHUNK_SIZE 32
+#    endif
+
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDMMSG
+typedef struct {
+    struct mmsghdr *msgs;
+    size_t count;
+    size_t sent;
+    size_t bytes_sent;
+} sendmmsg_internal_arg_t;
+
+static avs_error_t sendmmsg_internal(sockfd_t sockfd, void *arg_) {
+    sendmmsg_internal_arg_t *arg = (sendmmsg_internal_arg_t *) arg_;
+    while (arg->sent < arg->count) {
+        errno = 0;
+        int result = sendmmsg(sockfd, &arg->msgs[arg->sent],
+                              (unsigned) (arg->count - arg->sent),
+                              MSG_NOSIGNAL);
+        if (result < 0) {
+            return failure_from_errno();
+        }
+        for (int i = 0; i < result; ++i) {
+            const struct mmsghdr *msg = &arg->msgs[arg->sent];
+            arg->bytes_sent += msg->msg_len;
+            if (msg->msg_len != msg->msg_hdr.msg_iov->iov_len) {
+                LOG(ERROR, _("sendmmsg fail (") "%lu" _("/") "%lu" _(")"),
+                    (unsigned long) msg->msg_len,
+                    (unsigned long) msg->msg_hdr.msg_iov->iov_len);
+                return avs_errno(AVS_EIO);
+            }
+            ++arg->sent;
+        }
+    }
+    return AVS_OK;
+}
+
+static avs_error_t resolve_for_sending(net_socket_impl_t *net_socket,
+                                       const char *host,
+                                       const char *port,
+                                       sockaddr_endpoint_union_t *out_address) {
+    avs_net_addrinfo_t *info =
+            resolve_addrinfo_for_socket(net_socket, host, port, false,
+                                        PREFERRED_FAMILY_ONLY);
+    if (!info) {
+        info = resolve_addrinfo_for_socket(net_socket, host, port, false,
+                                           PREFERRED_FAMILY_BLOCKED);
+    }
+    int result = info ? avs_net_addrinfo_next(info, &out_address->api_ep) : -1;
+    avs_net_addrinfo_delete(&info);
+    if (result) {
+        LOG(ERROR, _("cannot resolve address for sending: [") "%s" _("]:") "%s",
+            host, port);
+        return avs_errno(AVS_EADDRNOTAVAIL);
+    }
+    return AVS_OK;
+}
+
+static bool same_destination(const avs_net_socket_outgoing_datagram_t *a,
+                             const avs_net_socket_outgoing_datagram_t *b) {
+    return a->host && b->host && strcmp(a->host, b->host) == 0
+           && strcmp(a->port, b->port) == 0;
+}
+
+static avs_error_t
+send_batch_net(avs_net_socket_t *net_socket_,
+               const avs_net_socket_outgoing_datagram_t *datagrams,
+               size_t count,
+               size_t *out_sent) {
+    net_socket_impl_t *net_socket = (net_socket_impl_t *) net_socket_;
+    if (net_socket->type != AVS_NET_UDP_SOCKET) {
+        return avs_errno(AVS_ENOTSUP);
+    }
+
+    avs_error_t err = AVS_OK;
+    size_t sent = 0;
+    while (avs_is_ok(err) && sent < count) {
+        struct mmsghdr msgs[NET_BATCH_CHUNK_SIZE];
+        struct iovec iovs[NET_BATCH_CHUNK_SIZE];
+        sockaddr_endpoint_union_t addresses[NET_BATCH_CHUNK_SIZE];
+        size_t chunk_size = AVS_MIN(count - sent, NET_BATCH_CHUNK_SIZE);
+        size_t prepared;
+
+        memset(msgs, 0, chunk_size * sizeof(*msgs));
+        for (prepared = 0; prepared < chunk_size; ++prepared) {
+            const avs_net_socket_outgoing_datagram_t *datagram =
+                    &datagrams[sent + prepared];
+            iovs[prepared].iov_base = (void *) (intptr_t) datagram->data;
+            iovs[prepared].iov_len = datagram->data_length;
+            msgs[prepared].msg_hdr.msg_iov = &iovs[prepared];
+            msgs[prepared].msg_hdr.msg_iovlen = 1;
+            if (!datagram->host) {
+                continue;
+            }
+            // replies to many peers usually come in runs, so avoid resolving
+            // the same address over and over again
+            if (prepared > 0 && same_destination(datagram, &datagram[-1])) {
+                addresses[prepared] = addresses[prepared - 1];
+            } else if (avs_is_err((err = resolve_for_sending(
+                                           net_socket, datagram->host,
+                                           datagram->port,
+                                           &addresses[prepared])))) {
+                break;
+            }
+            msgs[prepared].msg_hdr.msg_name =
+                    &addresses[prepared].sockaddr_ep.addr;
+            msgs[prepared].msg_hdr.msg_namelen =
+                    addresses[prepared].sockaddr_ep.header.size;
+        }
+
+        if (prepared > 0) {
+            sendmmsg_internal_arg_t arg = {
+                .msgs = msgs,
+                .count = prepared
+            };
+            avs_error_t send_err = call_when_ready(
+                    net_socket, NET_SEND_TIMEOUT,
+                    AVS_POLLOUT | AVS_POLLERR,
+                    net_socket->configuration.optimistic_io, sendmmsg_internal,
+                    &arg);
+            net_socket->bytes_sent += arg.bytes_sent;
+            sent += arg.sent;
+            if (avs_is_err(send_err)) {
+                err = send_err;
+            }
+        }
+    }
+    if (out_sent) {
+        *out_sent = sent;
+    }
+    return err;
+}
+#    endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDMMSG
+
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_RECVMMSG
+typedef struct {
+    avs_net_socket_received_datagram_t *datagrams;
+    size_t count;
+    size_t received;
+    size_t bytes_received;
+} recvmmsg_internal_arg_t;
+
+static avs_error_t recvmmsg_internal(sockfd_t sockfd, void *arg_) {
+    recvmmsg_internal_arg_t *arg = (recvmmsg_internal_arg_t *) arg_;
+    size_t chunk_size;
+    int result;
+    do {
+        struct mmsghdr msgs[NET_BATCH_CHUNK_SIZE];
+        struct iovec iovs[NET_BATCH_CHUNK_SIZE];
+        sockaddr_union_t addresses[NET_BATCH_CHUNK_SIZE];
+        avs_net_socket_received_datagram_t *datagrams =
+                &arg->datagrams[arg->received];
+        chunk_size = AVS_MIN(arg->count - arg->received, NET_BATCH_CHUNK_SIZE);
+
+        memset(msgs, 0, chunk_size * sizeof(*msgs));
+        for (size_t i = 0; i < chunk_size; ++i) {
+            iovs[i].iov_base = datagrams[i].buffer;
+            iovs[i].iov_len = datagrams[i].buffer_length;
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            if (datagrams[i].host || datagrams[i].port) {
+                msgs[i].msg_hdr.msg_name = &addresses[i].addr;
+                msgs[i].msg_hdr.msg_namelen = (socklen_t) sizeof(addresses[i]);
+            }
+        }
+
+        // the socket is non-blocking, so this returns immediately with
+        // whatever number of datagrams is already queued
+        errno = 0;
+        result = recvmmsg(sockfd, msgs, (unsigned) chunk_size, 0, NULL);
+        if (result < 0) {
+            // errors after the first chunk will be reported by the next call
+            return arg->received ? AVS_OK : failure_from_errno();
+        }
+
+        for (int i = 0; i < result; ++i) {
+            avs_net_socket_received_datagram_t *datagram = &datagrams[i];
+            datagram->bytes_received =
+                    AVS_MIN((size_t) msgs[i].msg_len, datagram->buffer_length);
+            datagram->truncated = !!(msgs[i].msg_hdr.msg_flags & MSG_TRUNC);
+            arg->bytes_received += datagram->bytes_received;
+            if (msgs[i].msg_hdr.msg_name) {
+                if (datagram->host && datagram->host_size) {
+                    datagram->host[0] = '\0';
+                }
+                if (datagram->port && datagram->port_size) {
+                    datagram->port[0] = '\0';
+                }
+                host_port_to_string(
+                        &addresses[i].addr, msgs[i].msg_hdr.msg_namelen,
+                        datagram->host,
+                        datagram->host ? (socklen_t) datagram->host_size : 0,
+                        datagram->port,
+                        datagram->port ? (socklen_t) datagram->port_size : 0);
+            }
+        }
+        arg->received += (size_t) result;
+    } while ((size_t) result == chunk_size && arg->received < arg->count);
+    return AVS_OK;
+}
+
+static avs_error_t
+receive_batch_net(avs_net_socket_t *net_socket_,
+                  avs_net_socket_received_datagram_t *datagrams,
+                  size_t count,
+                  size_t *out_received) {
+    net_socket_impl_t *net_socket = (net_socket_impl_t *) net_socket_;
+    if (net_socket->type != AVS_NET_UDP_SOCKET) {
+        return avs_errno(AVS_ENOTSUP);
+    }
+    recvmmsg_internal_arg_t arg = {
+        .datagrams = datagrams,
+        .count = count
+    };
+    avs_error_t err =
+            call_when_ready(net_socket, net_socket->recv_timeout,
+                            AVS_POLLIN | AVS_POLLERR,
+                            net_socket->configuration.optimistic_io,
+                            recvmmsg_internal, &arg);
+    net_socket->bytes_received += arg.bytes_received;
+    *out_received = arg.received;
+    return err;
+}
+#    endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_RECVMMSG
+
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_UDP_SEGMENT
+/**
+ * Limits for a single send with the UDP_SEGMENT option: Linux refuses to split
+ * a buffer into more than 64 datagrams (UDP_MAX_SEGMENTS), and the whole
+ * buffer still needs to fit in a single maximum-sized UDP datagram.
+ */
+#        define NET_GSO_MAX_SEGMENTS 64
+#        define NET_GSO_MAX_LENGTH 65507
+
+typedef struct {
+    const char *data;
+    size_t data_length;
+    uint16_t segment_size;
+    size_t bytes_sent;
+} send_gso_internal_arg_t;
+
+static avs_error_t send_gso_internal(sockfd_t sockfd, void *arg_) {
+    send_gso_internal_arg_t *arg = (send_gso_internal_arg_t *) arg_;
+    struct iovec iov = {
+        .iov_base = (void *) (intptr_t) arg->data,
+        .iov_len = arg->data_length
+    };
+    union {
+        char buf[CMSG_SPACE(sizeof(uint16_t))];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = control.buf,
+        .msg_controllen = sizeof(control.buf)
+    };
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = IPPROTO_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+    memcpy(CMSG_DATA(cmsg), &arg->segment_size, sizeof(uint16_t));
+
+    errno = 0;
+    ssize_t result = sendmsg(sockfd, &msg, MSG_NOSIGNAL);
+    if (result < 0) {
+        return failure_from_errno();
+    }
+    arg->bytes_sent = (size_t) result;
+    if (arg->bytes_sent != arg->data_length) {
+        LOG(ERROR, _("sending fail (") "%lu" _("/") "%lu" _(")"),
+            (unsigned long) arg->bytes_sent, (unsigned long) arg->data_length);
+        return avs_errno(AVS_EIO);
+    }
+    return AVS_OK;
+}
+
+static avs_error_t send_segmented_net(avs_net_socket_t *net_socket_,
+                                      const void *buffer,
+                                      size_t length,
+                                      size_t segment_size) {
+    net_socket_impl_t *net_socket = (net_socket_impl_t *) net_socket_;
+    if (net_socket->type != AVS_NET_UDP_SOCKET
+            || segment_size > NET_GSO_MAX_LENGTH) {
+        return avs_errno(AVS_ENOTSUP);
+    }
+
+    const size_t max_chunk_length =
+            AVS_MIN(NET_GSO_MAX_SEGMENTS, NET_GSO_MAX_LENGTH / segment_size)
+            * segment_size;
+    size_t offset = 0;
+    do {
+        send_gso_internal_arg_t arg = {
+            .data = (const char *) buffer + offset,
+            .data_length = AVS_MIN(length - offset, max_chunk_length),
+            .segment_size = (uint16_t) segment_size
+        };
+        avs_error_t err =
+                call_when_ready(net_socket, NET_SEND_TIMEOUT,
+                                AVS_POLLOUT | AVS_POLLERR,
+                                net_socket->configuration.optimistic_io,
+                                send_gso_internal, &arg);
+        net_socket->bytes_sent += arg.bytes_sent;
+        if (avs_is_err(err)) {
+            if (offset == 0 && arg.bytes_sent == 0
+                    && err.category == AVS_ERRNO_CATEGORY
+                    && (err.code == AVS_EINVAL || err.code == AVS_ENOPROTOOPT
+                        || err.code == AVS_EIO)) {
+                // the kernel or the outgoing interface does not support GSO;
+                // let the generic layer send the datagrams one by one
+                LOG(DEBUG, _("UDP_SEGMENT not supported, falling back"));
+                return avs_errno(AVS_ENOTSUP);
+            }
+            LOG(ERROR, _("send failed"));
+            return err;
+        }
+        offset += arg.data_length;
+    } while (offset < length);
+    return AVS_OK;
+}
+#    endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_UDP_SEGMENT
+
+#    ifdef NET_HAVE_UDP_GRO
+typedef struct {
+    void *buffer;
+    size_t buffer_length;
+    size_t bytes_received;
+    size_t segment_size;
+} recv_gro_internal_arg_t;
+
+static avs_error_t recv_gro_internal(sockfd_t sockfd, void *arg_) {
+    recv_gro_internal_arg_t *arg = (recv_gro_internal_arg_t *) arg_;
+    struct iovec iov = {
+        .iov_base = arg->buffer,
+        .iov_len = arg->buffer_length
+    };
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = control.buf,
+        .msg_controllen = sizeof(control.buf)
+    };
+
+    errno = 0;
+    ssize_t recv_out = recvmsg(sockfd, &msg, 0);
+    if (recv_out < 0) {
+        arg->bytes_received = 0;
+        return failure_from_errno();
+    }
+    arg->bytes_received = AVS_MIN((size_t) recv_out, arg->buffer_length);
+    arg->segment_size = arg->bytes_received;
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == IPPROTO_UDP && cmsg->cmsg_type == UDP_GRO) {
+            int segment_size;
+            memcpy(&segment_size, CMSG_DATA(cmsg), sizeof(segment_size));
+            if (segment_size > 0) {
+                arg->segment_size = (size_t) segment_size;
+            }
+        }
+    }
+    if (msg.msg_flags & MSG_TRUNC) {
+        /* message too long to fit in the buffer */
+        return avs_errno(AVS_EMSGSIZE);
+    }
+    return AVS_OK;
+}
+
+static avs_error_t receive_segmented_net(avs_net_socket_t *net_socket_,
+                                         size_t *out_bytes_received,
+                                         void *buffer,
+                                         size_t buffer_length,
+                                         size_t *out_segment_size) {
+    net_socket_impl_t *net_socket = (net_socket_impl_t *) net_socket_;
+    if (net_socket->type != AVS_NET_UDP_SOCKET) {
+        return avs_errno(AVS_ENOTSUP);
+    }
+    recv_gro_internal_arg_t arg = {
+        .buffer = buffer,
+        .buffer_length = buffer_length
+    };
+    avs_error_t err =
+            call_when_ready(net_socket, net_socket->recv_timeout,
+                            AVS_POLLIN | AVS_POLLERR,
+                            net_socket->configuration.optimistic_io,
+                            recv_gro_internal, &arg);
+    *out_bytes_received = arg.bytes_received;
+    *out_segment_size = arg.segment_size;
+    net_socket->bytes_received += arg.bytes_received;
+    return err;
+}
+
+static avs_error_t get_udp_gro(net_socket_impl_t *net_socket, bool *out) {
+    int value = 0;
+    socklen_t length = (socklen_t) sizeof(value);
+    if (net_socket->type != AVS_NET_UDP_SOCKET) {
+        return avs_errno(AVS_ENOTSUP);
+    }
+    errno = 0;
+    if (getsockopt(net_socket->socket, IPPROTO_UDP, UDP_GRO, &value,
+                   &length)) {
+        return failure_from_errno();
+    }
+    *out = !!value;
+    return AVS_OK;
+}
+
+static avs_error_t set_udp_gro(net_socket_impl_t *net_socket, bool enabled) {
+    int value = enabled;
+    if (net_socket->type != AVS_NET_UDP_SOCKET) {
+        return avs_errno(AVS_ENOTSUP);
+    }
+    errno = 0;
+    if (setsockopt(net_socket->socket, IPPROTO_UDP, UDP_GRO, &value,
+                   (socklen_t) sizeof(value))) {
+        LOG(ERROR, _("cannot set UDP_GRO"));
+        return failure_from_errno();
+    }
+    return AVS_OK;
+}
+#    endif // NET_HAVE_UDP_GRO
+
+#    ifdef NET_HAVE_SEND_FILE
+/**
+ * Linux never transfers more than 0x7ffff000 bytes in a single sendfile()
+ * call; we use a round number below that.
+ */
+#        define NET_SENDFILE_MAX_CHUNK (1UL << 30)
+
+typedef struct {
+    int in_fd;
+    off_t offset;
+    size_t length;
+    size_t bytes_sent;
+} sendfile_internal_arg_t;
+
+static avs_error_t sendfile_internal(sockfd_t sockfd, void *arg_) {
+    sendfile_internal_arg_t *arg = (sendfile_internal_arg_t *) arg_;
+    errno = 0;
+    ssize_t result = sendfile(sockfd, arg->in_fd, &arg->offset, arg->length);
+    if (result < 0) {
+        return failure_from_errno();
+    }
+    arg->bytes_sent = (size_t) result;
+    return AVS_OK;
+}
+
+static avs_error_t send_file_net(avs_net_socket_t *net_socket_,
+                                 FILE *file,
+                                 size_t length,
+                                 size_t *out_bytes_sent) {
+    net_socket_impl_t *net_socket = (net_socket_impl_t *) net_socket_;
+    if (net_socket->type != AVS_NET_TCP_SOCKET) {
+        return avs_errno(AVS_ENOTSUP);
+    }
+    sendfile_internal_arg_t arg = {
+        .in_fd = fileno(file)
+    };
+    // sendfile() reads from an explicit offset, so the logical position of
+    // the stdio stream (which may differ from the descriptor's one due to
+    // buffering) is used and restored afterwards
+    if (arg.in_fd < 0 || (arg.offset = ftello(file)) < 0) {
+        return avs_errno(AVS_ENOTSUP);
+    }
+
+    avs_error_t err = AVS_OK;
+    while (*out_bytes_sent < length) {
+        arg.length = AVS_MIN(length - *out_bytes_sent, NET_SENDFILE_MAX_CHUNK);
+        arg.bytes_sent = 0;
+        err = call_when_ready(net_socket, NET_SEND_TIMEOUT,
+                              AVS_POLLOUT | AVS_POLLERR,
+                              net_socket->configuration.optimistic_io,
+                              sendfile_internal, &arg);
+        if (avs_is_err(err)) {
+            if (*out_bytes_sent == 0 && err.category == AVS_ERRNO_CATEGORY
+                    && (err.code == AVS_EINVAL || err.code == AVS_ENOSYS)) {
+                // the file cannot be used with sendfile() (e.g. it is a pipe);
+                // the caller needs to read it into a buffer
+                LOG(DEBUG, _("sendfile() not supported for this file"));
+                return avs_errno(AVS_ENOTSUP);
+            }
+            LOG(ERROR, _("send failed"));
+            break;
+        }
+        if (arg.bytes_sent == 0) {
+            // end of file
+            break;
+        }
+        *out_bytes_sent += arg.bytes_sent;
+        net_socket->bytes_sent += arg.bytes_sent;
+    }
+    if (fseeko(file, arg.offset, SEEK_SET) && avs_is_ok(err)) {
+        err = avs_errno(AVS_EIO);
+    }
+    return err;
+}
+#    endif // NET_HAVE_SEND_FILE
+
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_RECVMSG
+/**
+ * Maximum number of buffers passed to a single sendmsg() or recvmsg() call.
+ * The iovec array is allocated on stack; longer buffer lists are handled by
+ * the generic fallback, which still sends them as a single datagram on UDP
+ * sockets.
+ */
+#        define NET_MAX_IOVECS 16
+
+typedef struct {
+    struct msghdr msg;
+    size_t bytes_sent;
+} sendmsg_internal_arg_t;
+
+static avs_error_t sendmsg_internal(sockfd_t sockfd, void *arg_) {
+    sendmsg_internal_arg_t *arg = (sendmsg_internal_arg_t *) arg_;
+    errno = 0;
+    ssize_t result = sendmsg(sockfd, &arg->msg, MSG_NOSIGNAL);
+    if (result < 0) {
+        return failure_from_errno();
+    }
+    arg->bytes_sent = (size_t) result;
+    return AVS_OK;
+}
+
+static void skip_sent_iovecs(struct msghdr *msg, size_t bytes) {
+    while (msg->msg_iovlen > 0 && bytes >= msg->msg_iov->iov_len) {
+        bytes -= msg->msg_iov->iov_len;
+        ++msg->msg_iov;
+        --msg->msg_iovlen;
+    }
+    if (bytes) {
+        msg->msg_iov->iov_base = (char *) msg->msg_iov->iov_base + bytes;
+        msg->msg_iov->iov_len -= bytes;
+    }
+}
+
+static avs_error_t sendv_net(avs_net_socket_t *net_socket_,
+                             const avs_net_socket_outgoing_buffer_t *buffers,
+                             size_t count) {
+    net_socket_impl_t *net_socket = (net_socket_impl_t *) net_socket_;
+    if (count > NET_MAX_IOVECS) {
+        return avs_errno(AVS_ENOTSUP);
+    }
+    struct iovec iov[NET_MAX_IOVECS];
+    size_t total_length = 0;
+    for (size_t i = 0; i < count; ++i) {
+        iov[i].iov_base = (void *) (intptr_t) buffers[i].data;
+        iov[i].iov_len = buffers[i].data_length;
+        total_length += buffers[i].data_length;
+    }
+    sendmsg_internal_arg_t arg = {
+        .msg = {
+            .msg_iov = iov,
+            .msg_iovlen = count
+        }
+    };
+    size_t bytes_sent = 0;
+
+    /* send at least one datagram, even if zero-length - hence do..while */
+    do {
+        arg.bytes_sent = 0;
+        avs_error_t err =
+                call_when_ready(net_socket, NET_SEND_TIMEOUT,
+                                AVS_POLLOUT | AVS_POLLERR,
+                                net_socket->configuration.optimistic_io,
+                                sendmsg_internal, &arg);
+        if (avs_is_err(err)) {
+            LOG(ERROR, _("send failed"));
+            return err;
+        } else if (total_length != 0 && arg.bytes_sent == 0) {
+            LOG(ERROR, _("send returned 0"));
+            break;
+        }
+        bytes_sent += arg.bytes_sent;
+        net_socket->bytes_sent += arg.bytes_sent;
+        skip_sent_iovecs(&arg.msg, arg.bytes_sent);
+        /* call sendmsg() multiple times only if the socket is stream-oriented */
+    } while (net_socket->type == AVS_NET_TCP_SOCKET
+             && bytes_sent < total_length);
+
+    if (bytes_sent < total_length) {
+        LOG(ERROR, _("sending fail (") "%lu" _("/") "%lu" _(")"),
+            (unsigned long) bytes_sent, (unsigned long) total_length);
+        return avs_errno(AVS_EIO);
+    }
+    return AVS_OK;
+}
+
+typedef struct {
+    struct msghdr msg;
+    size_t buffer_length;
+    size_t bytes_received;
+} recvmsg_internal_arg_t;
+
+static avs_error_t recvmsg_internal(sockfd_t sockfd, void *arg_) {
+    recvmsg_internal_arg_t *arg = (recvmsg_internal_arg_t *) arg_;
+    errno = 0;
+    ssize_t recv_out = recvmsg(sockfd, &arg->msg, 0);
+    if (recv_out < 0) {
+        arg->bytes_received = 0;
+        return failure_from_errno();
+    }
+    arg->bytes_received = AVS_MIN((size_t) recv_out, arg->buffer_length);
+    if (arg->msg.msg_flags & MSG_TRUNC) {
+        /* message too long to fit in the buffers */
+        return avs_errno(AVS_EMSGSIZE);
+    }
+    return AVS_OK;
+}
+
+static avs_error_t receivev_net(avs_net_socket_t *net_socket_,
+                                size_t *out_bytes_received,
+                                const avs_net_socket_incoming_buffer_t *buffers,
+                                size_t count) {
+    net_socket_impl_t *net_socket = (net_socket_impl_t *) net_socket_;
+    if (count > NET_MAX_IOVECS) {
+        return avs_errno(AVS_ENOTSUP);
+    }
+    struct iovec iov[NET_MAX_IOVECS];
+    recvmsg_internal_arg_t arg = {
+        .msg = {
+            .msg_iov = iov,
+            .msg_iovlen = count
+        }
+    };
+    for (size_t i = 0; i < count; ++i) {
+        iov[i].iov_base = buffers[i].buffer;
+        iov[i].iov_len = buffers[i].buffer_length;
+        arg.buffer_length += buffers[i].buffer_length;
+    }
+    avs_error_t err =
+            call_when_ready(net_socket, net_socket->recv_timeout,
+                            AVS_POLLIN | AVS_POLLERR,
+                            net_socket->configuration.optimistic_io,
+                            recvmsg_internal, &arg);
+    *out_bytes_received = arg.bytes_received;
+    net_socket->bytes_received += arg.bytes_received;
+    return err;
+}
+#    endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_RECVMSG
+
 static avs_error_t create_listening_socket(net_socket_impl_t *net_socket,
                                            const struct sockaddr *addr,
                                            socklen_t addrlen) {
@@ -1472,6 +2593,21 @@ static avs_error_t create_listening_socket(net_socket_impl_t *net_socket,
         LOG(ERROR, _("can't set socket opt"));
         goto create_listening_socket_error;
     }
+    if (net_socket->configuration.reuse_port) {
+#    ifdef SO_REUSEPORT
+        const int reuse_port = 1;
+        if (setsockopt(net_socket->socket, SOL_SOCKET, SO_REUSEPORT,
+                       &reuse_port, sizeof(reuse_port))) {
+            err = failure_from_errno();
+            LOG(ERROR, _("can't set SO_REUSEPORT"));
+            goto create_listening_socket_error;
+        }
+#    else  // SO_REUSEPORT
+        LOG(ERROR, _("SO_REUSEPORT is not supported on this platform"));
+        err = avs_errno(AVS_ENOTSUP);
+        goto create_listening_socket_error;
+#    endif // SO_REUSEPORT
+    }
     if (avs_is_err((err = configure_socket(net_socket)))) {
         goto create_listening_socket_error;
     }
@@ -1579,10 +2715,11 @@ static avs_error_t peek_received_msg_host_port(net_socket_impl_t *net_socket,
                                                size_t port_size) {
     avs_error_t err;
     struct sockaddr addr;
-    (void) (avs_is_err((err = call_when_ready(&net_socket->socket,
-                                              net_socket->recv_timeout,
-                                              AVS_POLLIN | AVS_POLLERR,
-                                              peek_internal, &addr)))
+    (void) (avs_is_err((err = call_when_ready(
+                                net_socket, net_socket->recv_timeout,
+                                AVS_POLLIN | AVS_POLLERR,
+                                net_socket->configuration.optimistic_io,
+                                peek_internal, &addr)))
             || avs_is_err(
                        (err = host_port_to_string(&addr, sizeof(addr), host,
                                                   (socklen_t) host_size, port,
@@ -1600,10 +2737,15 @@ static void swap_socket_fd_and_state(net_socket_impl_t *socket1,
 
 static avs_error_t accept_udp(net_socket_impl_t *server_net_socket,
                               net_socket_impl_t *new_net_socket) {
-    if (!server_net_socket->configuration.reuse_addr
-            || !new_net_socket->configuration.reuse_addr) {
+    // the server socket is re-bound to the same address while the accepted
+    // one is still using it
+    if (!(server_net_socket->configuration.reuse_addr
+          || server_net_socket->configuration.reuse_port)
+            || !(new_net_socket->configuration.reuse_addr
+                 || new_net_socket->configuration.reuse_port)) {
         LOG(ERROR, _("Both server and client socket must have ")
-                           _("configuration.reuse_addr set to 1"));
+                           _("configuration.reuse_addr or ")
+                                   _("configuration.reuse_port set"));
         return avs_errno(AVS_EINVAL);
     }
 
@@ -1664,10 +2806,11 @@ static avs_error_t accept_tcp(net_socket_impl_t *server_net_socket,
         .client_sockfd = INVALID_SOCKET
     };
     avs_error_t err;
-    if (avs_is_err((err = call_when_ready(&server_net_socket->socket,
-                                          NET_ACCEPT_TIMEOUT,
-                                          AVS_POLLIN | AVS_POLLERR,
-                                          accept_internal, &arg)))) {
+    if (avs_is_err((err = call_when_ready(
+                            server_net_socket, NET_ACCEPT_TIMEOUT,
+                            AVS_POLLIN | AVS_POLLERR,
+                            server_net_socket->configuration.optimistic_io,
+                            accept_internal, &arg)))) {
         return err;
     }
 
@@ -1965,6 +3108,13 @@ static avs_error_t get_opt_net(avs_net_socket_t *net_socket_,
     case AVS_NET_SOCKET_HAS_BUFFERED_DATA:
         out_option_value->flag = false;
         return AVS_OK;
+    case AVS_NET_SOCKET_OPT_DATAGRAM:
+        out_option_value->flag = (net_socket->type == AVS_NET_UDP_SOCKET);
+        return AVS_OK;
+#    ifdef NET_HAVE_UDP_GRO
+    case AVS_NET_SOCKET_OPT_UDP_GRO:
+        return get_udp_gro(net_socket, &out_option_value->flag);
+#    endif // NET_HAVE_UDP_GRO
     default:
         LOG(DEBUG,
             _("get_opt_net: unknown or unsupported option key: ")
@@ -1982,6 +3132,10 @@ static avs_error_t set_opt_net(avs_net_socket_t *net_socket_,
     case AVS_NET_SOCKET_OPT_RECV_TIMEOUT:
         net_socket->recv_timeout = option_value.recv_timeout;
         return AVS_OK;
+#    ifdef NET_HAVE_UDP_GRO
+    case AVS_NET_SOCKET_OPT_UDP_GRO:
+        return set_udp_gro(net_socket, option_value.flag);
+#    endif // NET_HAVE_UDP_GRO
     default:
         LOG(DEBUG,
             _("set_opt_net: unknown or unsupported option key: ")
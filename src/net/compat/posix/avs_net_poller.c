@@ -0,0 +1,531 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _AVS_NEED_POSIX_SOCKET
+
+#include <avsystem/commons/avs_commons_config.h>
+
+#if defined(AVS_COMMONS_WITH_AVS_NET) \
+        && defined(AVS_COMMONS_NET_WITH_POSIX_AVS_SOCKET)
+
+#    include <avs_commons_posix_init.h>
+
+// Allows the poll() fallback to be tested on systems that support epoll.
+#    ifdef AVS_NET_POLLER_FORCE_POLL
+#        undef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_EPOLL
+#    endif // AVS_NET_POLLER_FORCE_POLL
+
+#    include <assert.h>
+#    include <errno.h>
+#    include <limits.h>
+#    include <string.h>
+
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_EPOLL
+#        include <sys/epoll.h>
+#    endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_EPOLL
+
+#    include <avsystem/commons/avs_errno_map.h>
+#    include <avsystem/commons/avs_memory.h>
+#    include <avsystem/commons/avs_net_poller.h>
+#    include <avsystem/commons/avs_utils.h>
+
+VISIBILITY_SOURCE_BEGIN
+
+typedef struct {
+    avs_net_socket_t *socket;
+    void *user_data;
+} poller_entry_t;
+
+struct avs_net_poller_struct {
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_EPOLL
+    int epoll_fd;
+    /**
+     * Registered sockets, indexed by the system socket descriptor. Unused
+     * entries have socket == NULL. Descriptors are small integers allocated
+     * lowest-first, so this is dense even for many thousands of sockets.
+     */
+    poller_entry_t *entries;
+    size_t entries_size;
+    struct epoll_event *epoll_events;
+    size_t epoll_events_size;
+#    elif defined(AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_POLL)
+    /**
+     * Registered sockets; entries[i] corresponds to pollfds[i]. Removal swaps
+     * the last element into the vacated slot.
+     */
+    poller_entry_t *entries;
+    struct pollfd *pollfds;
+    size_t count;
+    size_t capacity;
+    /**
+     * Index at which the next scan of poll() results starts, so that sockets
+     * at the end of the array are not starved when more of them are ready
+     * than fit in the caller's buffer.
+     */
+    size_t scan_start;
+#    else
+    char dummy;
+#    endif
+};
+
+static avs_error_t failure_from_errno(void) {
+    avs_errno_t err = avs_map_errno(errno);
+    if (err == AVS_NO_ERROR) {
+        err = AVS_UNKNOWN_ERROR;
+    }
+    return avs_errno(err);
+}
+
+static avs_error_t get_sockfd(avs_net_socket_t *socket, sockfd_t *out_fd) {
+    const void *fd_ptr = avs_net_socket_get_system(socket);
+    if (!fd_ptr || *(const sockfd_t *) fd_ptr == INVALID_SOCKET) {
+        return avs_errno(AVS_EBADF);
+    }
+    *out_fd = *(const sockfd_t *) fd_ptr;
+    return AVS_OK;
+}
+
+static int timeout_to_ms(avs_time_duration_t timeout) {
+    if (!avs_time_duration_valid(timeout)) {
+        return -1;
+    }
+    if (timeout.seconds < 0) {
+        return 0;
+    }
+    int64_t timeout_ms;
+    if (avs_time_duration_to_scalar(&timeout_ms, AVS_TIME_MS, timeout)
+            || timeout_ms >= INT_MAX) {
+        return -1;
+    }
+    // Round up, so that a job scheduled a fraction of a millisecond in the
+    // future is not polled for in a tight loop.
+    if (timeout.nanoseconds % 1000000) {
+        ++timeout_ms;
+    }
+    return (int) timeout_ms;
+}
+
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_EPOLL
+
+static uint32_t to_epoll_events(int events) {
+    uint32_t result = 0;
+    if (events & AVS_NET_POLLER_READ) {
+        result |= EPOLLIN;
+    }
+    if (events & AVS_NET_POLLER_WRITE) {
+        result |= EPOLLOUT;
+    }
+    return result;
+}
+
+static int from_epoll_events(uint32_t events) {
+    int result = 0;
+    if (events & (EPOLLIN | EPOLLPRI)) {
+        result |= AVS_NET_POLLER_READ;
+    }
+    if (events & EPOLLOUT) {
+        result |= AVS_NET_POLLER_WRITE;
+    }
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        result |= AVS_NET_POLLER_ERROR;
+    }
+    return result;
+}
+
+avs_error_t avs_net_poller_create(avs_net_poller_t **out_poller) {
+    assert(out_poller && !*out_poller);
+    avs_net_poller_t *poller =
+            (avs_net_poller_t *) avs_calloc(1, sizeof(avs_net_poller_t));
+    if (!poller) {
+        return avs_errno(AVS_ENOMEM);
+    }
+    if ((poller->epoll_fd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+        avs_error_t err = failure_from_errno();
+        avs_free(poller);
+        return err;
+    }
+    *out_poller = poller;
+    return AVS_OK;
+}
+
+void avs_net_poller_cleanup(avs_net_poller_t **poller) {
+    if (poller && *poller) {
+        close((*poller)->epoll_fd);
+        avs_free((*poller)->entries);
+        avs_free((*poller)->epoll_events);
+        avs_free(*poller);
+        *poller = NULL;
+    }
+}
+
+static poller_entry_t *find_entry(avs_net_poller_t *poller,
+                                  avs_net_socket_t *socket,
+                                  sockfd_t fd) {
+    if (fd >= 0 && (size_t) fd < poller->entries_size
+            && poller->entries[fd].socket == socket) {
+        return &poller->entries[fd];
+    }
+    return NULL;
+}
+
+avs_error_t avs_net_poller_add(avs_net_poller_t *poller,
+                               avs_net_socket_t *socket,
+                               int events,
+                               void *user_data) {
+    assert(poller);
+    assert(socket);
+    sockfd_t fd;
+    avs_error_t err = get_sockfd(socket, &fd);
+    if (avs_is_err(err)) {
+        return err;
+    }
+    if (find_entry(poller, socket, fd)) {
+        return avs_errno(AVS_EEXIST);
+    }
+    if ((size_t) fd >= poller->entries_size) {
+        size_t new_size = AVS_MAX(2 * poller->entries_size, (size_t) fd + 1);
+        poller_entry_t *new_entries = (poller_entry_t *) avs_realloc(
+                poller->entries, new_size * sizeof(poller_entry_t));
+        if (!new_entries) {
+            return avs_errno(AVS_ENOMEM);
+        }
+        memset(&new_entries[poller->entries_size], 0,
+               (new_size - poller->entries_size) * sizeof(poller_entry_t));
+        poller->entries = new_entries;
+        poller->entries_size = new_size;
+    }
+
+    // If entries[fd] is occupied by a different socket, that socket has been
+    // closed without being removed first, and the kernel has already dropped
+    // its registration; the entry is simply overwritten.
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = to_epoll_events(events);
+    event.data.fd = fd;
+    if (epoll_ctl(poller->epoll_fd, EPOLL_CTL_ADD, fd, &event)) {
+        return failure_from_errno();
+    }
+    poller->entries[fd].socket = socket;
+    poller->entries[fd].user_data = user_data;
+    return AVS_OK;
+}
+
+avs_error_t avs_net_poller_modify(avs_net_poller_t *poller,
+                                  avs_net_socket_t *socket,
+                                  int events) {
+    assert(poller);
+    assert(socket);
+    sockfd_t fd;
+    if (avs_is_err(get_sockfd(socket, &fd))
+            || !find_entry(poller, socket, fd)) {
+        return avs_errno(AVS_ENOENT);
+    }
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = to_epoll_events(events);
+    event.data.fd = fd;
+    if (epoll_ctl(poller->epoll_fd, EPOLL_CTL_MOD, fd, &event)) {
+        return failure_from_errno();
+    }
+    return AVS_OK;
+}
+
+avs_error_t avs_net_poller_remove(avs_net_poller_t *poller,
+                                  avs_net_socket_t *socket) {
+    assert(poller);
+    assert(socket);
+    sockfd_t fd;
+    poller_entry_t *entry;
+    if (avs_is_ok(get_sockfd(socket, &fd))
+            && (entry = find_entry(poller, socket, fd))) {
+        // Errors are ignored - the descriptor might have been closed and
+        // reopened elsewhere in the meantime, in which case it is not
+        // registered anymore anyway.
+        epoll_ctl(poller->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+        entry->socket = NULL;
+        entry->user_data = NULL;
+        return AVS_OK;
+    }
+    // The socket has already been closed, so the kernel has forgotten about
+    // it; we only need to find our own entry.
+    for (size_t i = 0; i < poller->entries_size; ++i) {
+        if (poller->entries[i].socket == socket) {
+            poller->entries[i].socket = NULL;
+            poller->entries[i].user_data = NULL;
+            return AVS_OK;
+        }
+    }
+    return avs_errno(AVS_ENOENT);
+}
+
+avs_error_t avs_net_poller_wait(avs_net_poller_t *poller,
+                                avs_net_poller_event_t *out_events,
+                                size_t max_events,
+                                size_t *out_count,
+                                avs_time_duration_t timeout) {
+    assert(poller);
+    assert(out_events);
+    assert(max_events > 0);
+    assert(out_count);
+    *out_count = 0;
+    if (max_events > INT_MAX) {
+        max_events = INT_MAX;
+    }
+    if (poller->epoll_events_size < max_events) {
+        struct epoll_event *new_events = (struct epoll_event *) avs_realloc(
+                poller->epoll_events, max_events * sizeof(struct epoll_event));
+        if (!new_events) {
+            return avs_errno(AVS_ENOMEM);
+        }
+        poller->epoll_events = new_events;
+        poller->epoll_events_size = max_events;
+    }
+
+    int result = epoll_wait(poller->epoll_fd, poller->epoll_events,
+                            (int) max_events, timeout_to_ms(timeout));
+    if (result < 0) {
+        return errno == EINTR ? AVS_OK : failure_from_errno();
+    }
+    for (int i = 0; i < result; ++i) {
+        int fd = poller->epoll_events[i].data.fd;
+        assert(fd >= 0 && (size_t) fd < poller->entries_size);
+        const poller_entry_t *entry = &poller->entries[fd];
+        if (!entry->socket) {
+            continue;
+        }
+        out_events[*out_count].socket = entry->socket;
+        out_events[*out_count].user_data = entry->user_data;
+        out_events[*out_count].events =
+                from_epoll_events(poller->epoll_events[i].events);
+        ++*out_count;
+    }
+    return AVS_OK;
+}
+
+#    elif defined(AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_POLL)
+
+static short to_poll_events(int events) {
+    short result = 0;
+    if (events & AVS_NET_POLLER_READ) {
+        result = (short) (result | POLLIN);
+    }
+    if (events & AVS_NET_POLLER_WRITE) {
+        result = (short) (result | POLLOUT);
+    }
+    return result;
+}
+
+static int from_poll_events(short events) {
+    int result = 0;
+    if (events & (POLLIN | POLLPRI)) {
+        result |= AVS_NET_POLLER_READ;
+    }
+    if (events & POLLOUT) {
+        result |= AVS_NET_POLLER_WRITE;
+    }
+    if (events & (POLLERR | POLLHUP | POLLNVAL)) {
+        result |= AVS_NET_POLLER_ERROR;
+    }
+    return result;
+}
+
+avs_error_t avs_net_poller_create(avs_net_poller_t **out_poller) {
+    assert(out_poller && !*out_poller);
+    if (!(*out_poller = (avs_net_poller_t *) avs_calloc(
+                  1, sizeof(avs_net_poller_t)))) {
+        return avs_errno(AVS_ENOMEM);
+    }
+    return AVS_OK;
+}
+
+void avs_net_poller_cleanup(avs_net_poller_t **poller) {
+    if (poller && *poller) {
+        avs_free((*poller)->entries);
+        avs_free((*poller)->pollfds);
+        avs_free(*poller);
+        *poller = NULL;
+    }
+}
+
+static size_t find_index(avs_net_poller_t *poller, avs_net_socket_t *socket) {
+    size_t i;
+    for (i = 0; i < poller->count; ++i) {
+        if (poller->entries[i].socket == socket) {
+            break;
+        }
+    }
+    return i;
+}
+
+avs_error_t avs_net_poller_add(avs_net_poller_t *poller,
+                               avs_net_socket_t *socket,
+                               int events,
+                               void *user_data) {
+    assert(poller);
+    assert(socket);
+    sockfd_t fd;
+    avs_error_t err = get_sockfd(socket, &fd);
+    if (avs_is_err(err)) {
+        return err;
+    }
+    if (find_index(poller, socket) < poller->count) {
+        return avs_errno(AVS_EEXIST);
+    }
+    if (poller->count >= poller->capacity) {
+        size_t new_capacity = AVS_MAX(2 * poller->capacity, 16);
+        poller_entry_t *new_entries = (poller_entry_t *) avs_realloc(
+                poller->entries, new_capacity * sizeof(poller_entry_t));
+        if (!new_entries) {
+            return avs_errno(AVS_ENOMEM);
+        }
+        poller->entries = new_entries;
+        struct pollfd *new_pollfds = (struct pollfd *) avs_realloc(
+                poller->pollfds, new_capacity * sizeof(struct pollfd));
+        if (!new_pollfds) {
+            return avs_errno(AVS_ENOMEM);
+        }
+        poller->pollfds = new_pollfds;
+        poller->capacity = new_capacity;
+    }
+    poller->entries[poller->count].socket = socket;
+    poller->entries[poller->count].user_data = user_data;
+    poller->pollfds[poller->count].fd = fd;
+    poller->pollfds[poller->count].events = to_poll_events(events);
+    poller->pollfds[poller->count].revents = 0;
+    ++poller->count;
+    return AVS_OK;
+}
+
+avs_error_t avs_net_poller_modify(avs_net_poller_t *poller,
+                                  avs_net_socket_t *socket,
+                                  int events) {
+    assert(poller);
+    assert(socket);
+    size_t index = find_index(poller, socket);
+    if (index >= poller->count) {
+        return avs_errno(AVS_ENOENT);
+    }
+    poller->pollfds[index].events = to_poll_events(events);
+    return AVS_OK;
+}
+
+avs_error_t avs_net_poller_remove(avs_net_poller_t *poller,
+                                  avs_net_socket_t *socket) {
+    assert(poller);
+    assert(socket);
+    size_t index = find_index(poller, socket);
+    if (index >= poller->count) {
+        return avs_errno(AVS_ENOENT);
+    }
+    --poller->count;
+    poller->entries[index] = poller->entries[poller->count];
+    poller->pollfds[index] = poller->pollfds[poller->count];
+    return AVS_OK;
+}
+
+avs_error_t avs_net_poller_wait(avs_net_poller_t *poller,
+                                avs_net_poller_event_t *out_events,
+                                size_t max_events,
+                                size_t *out_count,
+                                avs_time_duration_t timeout) {
+    assert(poller);
+    assert(out_events);
+    assert(max_events > 0);
+    assert(out_count);
+    *out_count = 0;
+    errno = 0;
+    int result = poll(poller->pollfds, (nfds_t) poller->count,
+                      timeout_to_ms(timeout));
+    if (result < 0) {
+        return errno == EINTR ? AVS_OK : failure_from_errno();
+    }
+    if (poller->scan_start >= poller->count) {
+        poller->scan_start = 0;
+    }
+    for (size_t n = 0; n < poller->count && result > 0; ++n) {
+        size_t index = (poller->scan_start + n) % poller->count;
+        if (!poller->pollfds[index].revents) {
+            continue;
+        }
+        --result;
+        out_events[*out_count].socket = poller->entries[index].socket;
+        out_events[*out_count].user_data = poller->entries[index].user_data;
+        out_events[*out_count].events =
+                from_poll_events(poller->pollfds[index].revents);
+        if (++*out_count >= max_events) {
+            poller->scan_start = index + 1;
+            break;
+        }
+    }
+    return AVS_OK;
+}
+
+#    else // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_POLL
+
+avs_error_t avs_net_poller_create(avs_net_poller_t **out_poller) {
+    assert(out_poller && !*out_poller);
+    (void) out_poller;
+    return avs_errno(AVS_ENOTSUP);
+}
+
+void avs_net_poller_cleanup(avs_net_poller_t **poller) {
+    (void) poller;
+}
+
+avs_error_t avs_net_poller_add(avs_net_poller_t *poller,
+                               avs_net_socket_t *socket,
+                               int events,
+                               void *user_data) {
+    (void) poller;
+    (void) socket;
+    (void) events;
+    (void) user_data;
+    return avs_errno(AVS_ENOTSUP);
+}
+
+avs_error_t avs_net_poller_modify(avs_net_poller_t *poller,
+                                  avs_net_socket_t *socket,
+                                  int events) {
+    (void) poller;
+    (void) socket;
+    (void) events;
+    return avs_errno(AVS_ENOTSUP);
+}
+
+avs_error_t avs_net_poller_remove(avs_net_poller_t *poller,
+                                  avs_net_socket_t *socket) {
+    (void) poller;
+    (void) socket;
+    return avs_errno(AVS_ENOTSUP);
+}
+
+avs_error_t avs_net_poller_wait(avs_net_poller_t *poller,
+                                avs_net_poller_event_t *out_events,
+                                size_t max_events,
+                                size_t *out_count,
+                                avs_time_duration_t timeout) {
+    (void) poller;
+    (void) out_events;
+    (void) max_events;
+    (void) timeout;
+    *out_count = 0;
+    return avs_errno(AVS_ENOTSUP);
+}
+
+#    endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_EPOLL
+
+#endif // defined(AVS_COMMONS_WITH_AVS_NET) &&
+       // defined(AVS_COMMONS_NET_WITH_POSIX_AVS_SOCKET)
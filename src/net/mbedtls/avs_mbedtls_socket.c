@@ -35,6 +35,7 @@
 #    include <assert.h>
 #    include <errno.h>
 #    include <inttypes.h>
+#    include <limits.h>
 #    include <string.h>
 
 #    if !defined(__STDC_VERSION__) || (__STDC_VERSION__ < 199901L)
@@ -51,10 +52,17 @@
 #        include <mbedtls/net.h>
 #    endif
 #    include <mbedtls/ssl.h>
+#    ifdef MBEDTLS_SSL_CACHE_C
+#        include <mbedtls/ssl_cache.h>
+#    endif // MBEDTLS_SSL_CACHE_C
+#    ifdef MBEDTLS_SSL_TICKET_C
+#        include <mbedtls/ssl_ticket.h>
+#    endif // MBEDTLS_SSL_TICKET_C
 #    include <mbedtls/timing.h>
 
 #    include <avsystem/commons/avs_errno_map.h>
 #    include <avsystem/commons/avs_memory.h>
+#    include <avsystem/commons/avs_mutex.h>
 #    include <avsystem/commons/avs_prng.h>
 #    include <avsystem/commons/avs_utils.h>
 
@@ -67,11 +75,20 @@
 #        include <mbedtls/sha256.h>
 #        include <mbedtls/sha512.h>
 #        define WITH_DANE_SUPPORT
-#        define dane_tlsa_array_field cert_security.dane_tlsa
 #    endif // defined(AVS_COMMONS_WITH_AVS_CRYPTO_PKI) &&
            // defined(MBEDTLS_SHA256_C) && defined(MBEDTLS_SHA512_C) &&
            // defined(MBEDTLS_PK_WRITE_C)
 
+#    ifdef AVS_COMMONS_NET_WITH_TLS_SESSION_CACHE
+#        define WITH_SSL_SESSION_CACHE
+#    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_CACHE
+
+#    ifdef MBEDTLS_SSL_SRV_C
+#        define WITH_SSL_SERVER_SESSIONS
+#    endif // MBEDTLS_SSL_SRV_C
+
+#    define WITH_SSL_ASYNC_HANDSHAKE
+
 #    include "../avs_net_impl.h"
 
 #    include "crypto/mbedtls/avs_mbedtls_private.h"
@@ -111,45 +128,94 @@ typedef struct {
     mbedtls_x509_crt *client_cert;
     mbedtls_pk_context *client_key;
 #        ifdef WITH_DANE_SUPPORT
-    // dane_ta_certs the original last element of ca_cert chain;
-    // if NULL, it means that DANE is disabled
-    mbedtls_x509_crt *dane_ta_certs;
-    avs_net_socket_dane_tlsa_array_t dane_tlsa;
-    dane_verify_state_t dane_verify_state;
+    /// Per-connection DANE state is stored in ssl_socket_t
+    bool dane;
 #        endif // WITH_DANE_SUPPORT
 } ssl_socket_certs_t;
 #    endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI
 
+/*
+ * Parsed credentials shared between sockets. mbedtls_ssl_config is still
+ * built per socket, as it is also used to store per-connection state: the
+ * endpoint type and callback arguments. It is cheap to set up, as it only
+ * refers to the certificates and ciphersuites stored here.
+ *
+ * If DANE is enabled, the TLSA records, the verification state and the trust
+ * store extended with DANE-TA certificates are kept in each socket instead.
+ */
+struct avs_net_ssl_context_struct {
+    avs_mutex_t *mutex;
+    unsigned refcount;
+    avs_net_socket_type_t backend_type;
+    // We might need the version numbers later, and they're write-only in config
+    int config_version_major;
+    int config_version_minor;
+    avs_net_security_mode_t security_mode;
+#    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PKI
+    ssl_socket_certs_t cert_security;
+#    endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI
+#    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PSK
+    avs_crypto_psk_key_info_t *psk_key;
+    avs_crypto_psk_identity_info_t *psk_identity;
+#    endif // AVS_COMMONS_WITH_AVS_CRYPTO_PSK
+    /// Subset of @ref avs_net_ssl_configuration_t#tls_ciphersuites appropriate
+    /// for security mode, 0-terminated array
+    int *effective_ciphersuites;
+    avs_crypto_prng_ctx_t *prng_ctx;
+    avs_ssl_additional_configuration_clb_t *additional_configuration_clb;
+#    ifdef WITH_SSL_SESSION_CACHE
+    _avs_net_session_cache_t *session_cache;
+#    endif // WITH_SSL_SESSION_CACHE
+#    ifdef WITH_SSL_SERVER_SESSIONS
+    avs_net_ssl_server_session_stats_t server_session_stats;
+#        ifdef MBEDTLS_SSL_CACHE_C
+    /// NULL if the server-side session cache is disabled; guarded by the mutex
+    mbedtls_ssl_cache_context *server_cache;
+#        endif // MBEDTLS_SSL_CACHE_C
+#        ifdef MBEDTLS_SSL_TICKET_C
+    /// NULL if session tickets are disabled; guarded by the mutex
+    mbedtls_ssl_ticket_context *ticket_ctx;
+#        endif // MBEDTLS_SSL_TICKET_C
+#    endif // WITH_SSL_SERVER_SESSIONS
+};
+
 typedef struct {
     const avs_net_socket_v_table_t *const operations;
     struct {
         bool context_valid : 1;
         bool session_fresh : 1;
     } flags;
-    mbedtls_ssl_context context;
+    avs_net_ssl_context_t *context;
+    mbedtls_ssl_context ssl_context;
     mbedtls_ssl_config config;
-    // We might need the version numbers later, and they're write-only in config
-    int config_version_major;
-    int config_version_minor;
 #    ifdef AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
     void *session_resumption_buffer;
     size_t session_resumption_buffer_size;
 #    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
-    avs_net_security_mode_t security_mode;
-#    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PKI
-    ssl_socket_certs_t cert_security;
-#    endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI
+#    ifdef WITH_SSL_SESSION_CACHE
+    /// Backs session_resumption_buffer if the context has a session cache.
+    _avs_net_session_cache_slot_t *session_cache_slot;
+#    endif // WITH_SSL_SESSION_CACHE
     mbedtls_timing_delay_context timer;
     avs_net_socket_type_t backend_type;
     avs_net_socket_t *backend_socket;
     avs_error_t bio_error;
     avs_net_socket_configuration_t backend_configuration;
-    /// Subset of @ref avs_net_ssl_configuration_t#tls_ciphersuites appropriate
-    /// for security mode, 0-terminated array
-    int *effective_ciphersuites;
     /// Non empty, when custom server hostname shall be used.
     char server_name_indication[256];
     bool use_connection_id;
+#    ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+    avs_net_socket_stats_t stats;
+#    endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
+    _avs_net_ssl_async_handshake_t async_handshake;
+#    ifdef WITH_DANE_SUPPORT
+    avs_net_socket_dane_tlsa_array_t dane_tlsa_array_field;
+    dane_verify_state_t dane_verify_state;
+    /// Trust store used instead of the context's CA chain: a copy of it
+    /// followed by the DANE-TA certificates from dane_tlsa_array_field, or
+    /// an empty one. NULL if the context's CA chain is used as is.
+    mbedtls_x509_crt *dane_ca_cert;
+#    endif // WITH_DANE_SUPPORT
 } ssl_socket_t;
 
 static bool is_ssl_started(ssl_socket_t *socket) {
@@ -162,7 +228,7 @@ static bool is_session_resumed(ssl_socket_t *socket) {
 
 static mbedtls_ssl_context *get_context(ssl_socket_t *socket) {
     assert(socket->flags.context_valid);
-    return &socket->context;
+    return &socket->ssl_context;
 }
 
 static bool has_buffered_data(ssl_socket_t *socket) {
@@ -232,13 +298,19 @@ avs_bio_recv(void *ctx, unsigned char *buf, size_t len, uint32_t timeout_ms) {
         new_timeout.recv_timeout =
                 avs_time_duration_from_scalar(timeout_ms, AVS_TIME_MS);
     }
+    if (socket->async_handshake.in_progress) {
+        new_timeout.recv_timeout = AVS_TIME_DURATION_ZERO;
+    }
     avs_net_socket_set_opt(socket->backend_socket,
                            AVS_NET_SOCKET_OPT_RECV_TIMEOUT, new_timeout);
     if (avs_is_err((socket->bio_error = avs_net_socket_receive(
                             socket->backend_socket, &read_bytes, buf, len)))) {
         if (socket->bio_error.category == AVS_ERRNO_CATEGORY
                 && socket->bio_error.code == AVS_ETIMEDOUT) {
-            result = MBEDTLS_ERR_SSL_TIMEOUT;
+            // no data yet; makes mbedtls_ssl_handshake() return early
+            result = socket->async_handshake.in_progress
+                             ? MBEDTLS_ERR_SSL_WANT_READ
+                             : MBEDTLS_ERR_SSL_TIMEOUT;
         } else {
             result = MBEDTLS_ERR_NET_RECV_FAILED;
         }
@@ -478,11 +550,11 @@ static bool dane_match(mbedtls_x509_crt *crt,
     return false;
 }
 
-static bool has_dane_ta_or_ee_entries(ssl_socket_t *socket) {
-    for (size_t i = 0; i < socket->cert_security.dane_tlsa.array_element_count;
+static bool has_dane_ta_or_ee_entries(const ssl_socket_t *socket) {
+    for (size_t i = 0; i < socket->dane_tlsa_array_field.array_element_count;
          ++i) {
         const avs_net_socket_dane_tlsa_record_t *const entry =
-                &socket->cert_security.dane_tlsa.array_ptr[i];
+                &socket->dane_tlsa_array_field.array_ptr[i];
         if (entry->certificate_usage
                         == AVS_NET_SOCKET_DANE_TRUST_ANCHOR_ASSERTION
                 || entry->certificate_usage
@@ -494,23 +566,22 @@ static bool has_dane_ta_or_ee_entries(ssl_socket_t *socket) {
 }
 
 static void reset_dane_verify_state(ssl_socket_t *socket) {
-    socket->cert_security.dane_verify_state.match_mask = 0;
-    socket->cert_security.dane_verify_state.verify_result_flags = 0;
-    socket->cert_security.dane_verify_state.verify_result = 0;
+    socket->dane_verify_state.match_mask = 0;
+    socket->dane_verify_state.verify_result_flags = 0;
+    socket->dane_verify_state.verify_result = 0;
 }
 
 static void update_dane_verify_state(ssl_socket_t *socket,
                                      mbedtls_x509_crt *crt,
                                      bool is_ee,
                                      uint32_t verify_result_flags) {
-    socket->cert_security.dane_verify_state.verify_result_flags |=
-            verify_result_flags;
+    socket->dane_verify_state.verify_result_flags |= verify_result_flags;
 
-    for (size_t i = 0; i < socket->cert_security.dane_tlsa.array_element_count;
+    for (size_t i = 0; i < socket->dane_tlsa_array_field.array_element_count;
          ++i) {
         const avs_net_socket_dane_tlsa_record_t *const entry =
-                &socket->cert_security.dane_tlsa.array_ptr[i];
-        if (socket->cert_security.dane_verify_state.match_mask
+                &socket->dane_tlsa_array_field.array_ptr[i];
+        if (socket->dane_verify_state.match_mask
                 & (1 << entry->certificate_usage)) {
             // Certificate usage already satisfied, no need to check again
             continue;
@@ -524,7 +595,7 @@ static void update_dane_verify_state(ssl_socket_t *socket,
             continue;
         }
         if (dane_match(crt, entry)) {
-            socket->cert_security.dane_verify_state.match_mask |=
+            socket->dane_verify_state.match_mask |=
                     (uint8_t) (1 << entry->certificate_usage);
         }
     }
@@ -534,28 +605,27 @@ static uint32_t perform_cert_verification(ssl_socket_t *socket) {
     // If the only problem with the certificate is that it failed PKIX
     // verification, but we are using DANE and have matched DANE-TA or
     // DANE-EE entry, it's a success
-    if (socket->cert_security.dane_verify_state.verify_result_flags
+    if (socket->dane_verify_state.verify_result_flags
                     == MBEDTLS_X509_BADCERT_NOT_TRUSTED
-            && (socket->cert_security.dane_verify_state.match_mask
+            && (socket->dane_verify_state.match_mask
                 & DANE_TA_OR_EE_MATCH_MASK)) {
         return 0;
     }
 
-    uint8_t dane_valid_matches = (socket->cert_security.ca_cert
-                                  == socket->cert_security.dane_ta_certs)
+    // without a global trust store, only DANE-TA and DANE-EE are usable
+    uint8_t dane_valid_matches = !socket->context->cert_security.ca_cert
                                          ? DANE_TA_OR_EE_MATCH_MASK
                                          : DANE_FULL_MATCH_MASK;
     // If verification succeeded,
     // check if DANE verification succeeded as well
-    if (!socket->cert_security.dane_verify_state.verify_result_flags
-            && socket->cert_security.dane_tlsa.array_element_count > 0
-            && !(socket->cert_security.dane_verify_state.match_mask
-                 & dane_valid_matches)) {
+    if (!socket->dane_verify_state.verify_result_flags
+            && socket->dane_tlsa_array_field.array_element_count > 0
+            && !(socket->dane_verify_state.match_mask & dane_valid_matches)) {
         LOG(ERROR, _("DANE certificate verification failed"));
         return MBEDTLS_X509_BADCERT_NOT_TRUSTED;
     }
 
-    return socket->cert_security.dane_verify_state.verify_result_flags;
+    return socket->dane_verify_state.verify_result_flags;
 }
 
 #            ifndef MBEDTLS_ERR_X509_FATAL_ERROR // Mbed TLS <2.6 ?
@@ -570,21 +640,21 @@ static int verify_cert_cb(void *socket_,
     // Starting for the topmost (root) certificate, with highest index
     // And then iterates down to index 0 (the actual peer certificate)
     ssl_socket_t *socket = (ssl_socket_t *) socket_;
-    assert(socket->security_mode == AVS_NET_SECURITY_CERTIFICATE);
-    assert(socket->cert_security.dane_ta_certs);
+    assert(socket->context->security_mode == AVS_NET_SECURITY_CERTIFICATE);
+    assert(socket->context->cert_security.dane);
 
-    if (socket->cert_security.ca_cert == socket->cert_security.dane_ta_certs
+    if (!socket->context->cert_security.ca_cert
             && !has_dane_ta_or_ee_entries(socket)) {
         // No global trust store (opportunistic DANE) and no DANE-TA or DANE-EE
         // entries; this is unusable, so fall back to no verification
         return 0;
     }
 
-    if (index != socket->cert_security.dane_verify_state.last_known_index - 1) {
+    if (index != socket->dane_verify_state.last_known_index - 1) {
         // First entry (root certificate)
         reset_dane_verify_state(socket);
     }
-    socket->cert_security.dane_verify_state.last_known_index = index;
+    socket->dane_verify_state.last_known_index = index;
     update_dane_verify_state(socket, crt, /* is_ee = */ index == 0,
                              *verify_result_flags);
 
@@ -600,7 +670,7 @@ static int verify_cert_cb(void *socket_,
             LOG(ERROR,
                 _("server certificate verification failure: ") "%" PRIu32,
                 verify_result);
-            socket->cert_security.dane_verify_state.verify_result =
+            socket->dane_verify_state.verify_result =
                     MBEDTLS_ERR_X509_CERT_VERIFY_FAILED;
             if (verify_result == MBEDTLS_X509_BADCERT_MISSING) {
                 return MBEDTLS_ERR_SSL_NO_CLIENT_CERTIFICATE;
@@ -614,27 +684,31 @@ static int verify_cert_cb(void *socket_,
 }
 
 static int wrap_handshake_result(ssl_socket_t *socket, int result) {
-    if (result >= 0 && socket->security_mode == AVS_NET_SECURITY_CERTIFICATE
-            && socket->cert_security.dane_ta_certs
-            && socket->cert_security.dane_verify_state.verify_result) {
-        return socket->cert_security.dane_verify_state.verify_result;
+    if (result >= 0
+            && socket->context->security_mode == AVS_NET_SECURITY_CERTIFICATE
+            && socket->context->cert_security.dane
+            && socket->dane_verify_state.verify_result) {
+        return socket->dane_verify_state.verify_result;
     }
     return result;
 }
 #        endif // WITH_DANE_SUPPORT
 
-static avs_error_t initialize_cert_security(
-        ssl_socket_t *socket,
-        const avs_net_socket_tls_ciphersuites_t *tls_ciphersuites) {
-    avs_free(socket->effective_ciphersuites);
-    if (!(socket->effective_ciphersuites =
-                  init_cert_ciphersuites(tls_ciphersuites))) {
-        return avs_errno(AVS_ENOMEM);
+static bool has_trust_store(const ssl_socket_certs_t *certs) {
+#        ifdef WITH_DANE_SUPPORT
+    if (certs->dane) {
+        // DANE-TA records may be used as trust anchors
+        return true;
     }
+#        endif // WITH_DANE_SUPPORT
+    return certs->ca_cert || certs->ca_crl;
+}
 
-    if (socket->cert_security.ca_cert || socket->cert_security.ca_crl) {
+static void configure_cert_security(ssl_socket_t *socket) {
+    ssl_socket_certs_t *certs = &socket->context->cert_security;
+    if (has_trust_store(certs)) {
 #        ifdef WITH_DANE_SUPPORT
-        if (socket->cert_security.dane_ta_certs) {
+        if (certs->dane) {
             // NOTE: When verify_cert_cb() fails, the whole verification routine
             // fails as well, so this is effectively equivalent to modified
             // MBEDTLS_SSL_VERIFY_REQUIRED.
@@ -647,64 +721,117 @@ static avs_error_t initialize_cert_security(
             mbedtls_ssl_conf_authmode(&socket->config,
                                       MBEDTLS_SSL_VERIFY_REQUIRED);
         }
-        mbedtls_ssl_conf_ca_chain(&socket->config,
-                                  socket->cert_security.ca_cert,
-                                  socket->cert_security.ca_crl);
+        mbedtls_ssl_conf_ca_chain(&socket->config, certs->ca_cert,
+                                  certs->ca_crl);
     } else {
         mbedtls_ssl_conf_authmode(&socket->config, MBEDTLS_SSL_VERIFY_NONE);
     }
 
-    if (socket->cert_security.client_cert && socket->cert_security.client_key) {
-        mbedtls_ssl_conf_own_cert(&socket->config,
-                                  socket->cert_security.client_cert,
-                                  socket->cert_security.client_key);
+    if (certs->client_cert && certs->client_key) {
+        mbedtls_ssl_conf_own_cert(&socket->config, certs->client_cert,
+                                  certs->client_key);
     }
 
     mbedtls_ssl_conf_ciphersuites(&socket->config,
-                                  socket->effective_ciphersuites);
+                                  socket->context->effective_ciphersuites);
+}
+
+#        ifdef WITH_DANE_SUPPORT
+static bool is_dane_ta_full_certificate(
+        const avs_net_socket_dane_tlsa_record_t *entry) {
+    return entry->certificate_usage
+                   == AVS_NET_SOCKET_DANE_TRUST_ANCHOR_ASSERTION
+           && entry->selector == AVS_NET_SOCKET_DANE_CERTIFICATE
+           && entry->matching_type == AVS_NET_SOCKET_DANE_MATCH_FULL;
+}
+
+static bool has_dane_ta_full_certificates(const ssl_socket_t *socket) {
+    for (size_t i = 0; i < socket->dane_tlsa_array_field.array_element_count;
+         ++i) {
+        if (is_dane_ta_full_certificate(
+                    &socket->dane_tlsa_array_field.array_ptr[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Rebuilds socket->dane_ca_cert, and returns the trust store to use for the
+ * next handshake. The context's CA chain is shared with other sockets, so
+ * DANE-TA certificates are appended to a private copy of it.
+ */
+static avs_error_t get_dane_ca_chain(ssl_socket_t *socket,
+                                     mbedtls_x509_crt **out_ca_cert) {
+    mbedtls_x509_crt *ca_cert = socket->context->cert_security.ca_cert;
+    const bool has_ta_certs = has_dane_ta_full_certificates(socket);
+    *out_ca_cert = ca_cert;
+    _avs_crypto_mbedtls_x509_crt_cleanup(&socket->dane_ca_cert);
+    if (ca_cert && !has_ta_certs) {
+        return AVS_OK;
+    }
+    // without any certificates, an empty trust store is still configured,
+    // so that verify_cert_cb() is called
+    if (!(socket->dane_ca_cert = (mbedtls_x509_crt *) mbedtls_calloc(
+                  1, sizeof(*socket->dane_ca_cert)))) {
+        LOG(ERROR, _("Out of memory"));
+        return avs_errno(AVS_ENOMEM);
+    }
+    mbedtls_x509_crt_init(socket->dane_ca_cert);
+    for (mbedtls_x509_crt *crt = has_ta_certs ? ca_cert : NULL; crt;
+         crt = *_avs_crypto_mbedtls_x509_crt_next_ptr(crt)) {
+        const unsigned char *raw_crt;
+        size_t raw_crt_size;
+        _avs_crypto_mbedtls_x509_crt_get_raw(crt, &raw_crt, &raw_crt_size);
+        if (raw_crt_size
+                && mbedtls_x509_crt_parse_der(socket->dane_ca_cert, raw_crt,
+                                              raw_crt_size)) {
+            _avs_crypto_mbedtls_x509_crt_cleanup(&socket->dane_ca_cert);
+            return avs_errno(AVS_ENOMEM);
+        }
+    }
+    // 2 0 0 (DANE-TA / Entire certificate / Entire information) data
+    // shall be included as part of the trust store
+    for (size_t i = 0; i < socket->dane_tlsa_array_field.array_element_count;
+         ++i) {
+        const avs_net_socket_dane_tlsa_record_t *const entry =
+                &socket->dane_tlsa_array_field.array_ptr[i];
+        if (is_dane_ta_full_certificate(entry)
+                && mbedtls_x509_crt_parse_der(
+                           socket->dane_ca_cert,
+                           (const unsigned char *) entry->association_data,
+                           entry->association_data_size)) {
+            _avs_crypto_mbedtls_x509_crt_cleanup(&socket->dane_ca_cert);
+            return avs_errno(AVS_EPROTO);
+        }
+    }
+    *out_ca_cert = socket->dane_ca_cert;
     return AVS_OK;
 }
+#        endif // WITH_DANE_SUPPORT
 
 static avs_error_t update_cert_configuration(ssl_socket_t *socket) {
-    if (socket->security_mode != AVS_NET_SECURITY_CERTIFICATE) {
+    if (socket->context->security_mode != AVS_NET_SECURITY_CERTIFICATE) {
         return AVS_OK;
     }
 
+    ssl_socket_certs_t *certs = &socket->context->cert_security;
+    mbedtls_x509_crt *ca_cert = certs->ca_cert;
+
 #        ifdef WITH_DANE_SUPPORT
-    if (socket->cert_security.dane_ta_certs) {
-        // 2 0 0 (DANE-TA / Entire certificate / Entire information) data
-        // shall be included as part of the trust store
-
-        // First, remove any previous entries
-        mbedtls_x509_crt_free(socket->cert_security.dane_ta_certs);
-        mbedtls_x509_crt_init(socket->cert_security.dane_ta_certs);
-        // And now, add the relevant entries
-        for (size_t i = 0;
-             i < socket->cert_security.dane_tlsa.array_element_count;
-             ++i) {
-            const avs_net_socket_dane_tlsa_record_t *const entry =
-                    &socket->cert_security.dane_tlsa.array_ptr[i];
-            if (entry->certificate_usage
-                            == AVS_NET_SOCKET_DANE_TRUST_ANCHOR_ASSERTION
-                    && entry->selector == AVS_NET_SOCKET_DANE_CERTIFICATE
-                    && entry->matching_type == AVS_NET_SOCKET_DANE_MATCH_FULL
-                    && mbedtls_x509_crt_parse_der(
-                               socket->cert_security.dane_ta_certs,
-                               (const unsigned char *) entry->association_data,
-                               entry->association_data_size)) {
-                return avs_errno(AVS_EPROTO);
-            }
+    if (certs->dane) {
+        avs_error_t err = get_dane_ca_chain(socket, &ca_cert);
+        if (avs_is_err(err)) {
+            return err;
         }
     }
 #        endif // WITH_DANE_SUPPORT
 
-    mbedtls_ssl_conf_ca_chain(&socket->config,
-                              socket->cert_security.ca_cert,
-                              socket->cert_security.ca_crl);
+    mbedtls_ssl_conf_ca_chain(&socket->config, ca_cert, certs->ca_crl);
     return AVS_OK;
 }
 #    else // AVS_COMMONS_WITH_AVS_CRYPTO_PKI
-#        define initialize_cert_security(...) avs_errno(AVS_ENOTSUP)
+#        define configure_cert_security(...) ((void) 0)
 #        define update_cert_configuration(...) AVS_OK
 #    endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI
 
@@ -775,33 +902,45 @@ static int *init_psk_ciphersuites(
     return psk_ciphers;
 }
 
-static avs_error_t initialize_psk_security(
-        ssl_socket_t *socket,
-        const avs_net_socket_tls_ciphersuites_t *tls_ciphersuites,
-        const avs_net_psk_info_t *psk_info) {
-    avs_free(socket->effective_ciphersuites);
-    if (!(socket->effective_ciphersuites =
-                  init_psk_ciphersuites(tls_ciphersuites))) {
-        return avs_errno(AVS_ENOMEM);
-    }
-
+static avs_error_t configure_psk_security(ssl_socket_t *socket) {
     avs_error_t err =
-            _avs_crypto_mbedtls_load_psk(&socket->config, &psk_info->key,
-                                         &psk_info->identity);
+            _avs_crypto_mbedtls_load_psk(&socket->config,
+                                         socket->context->psk_key,
+                                         socket->context->psk_identity);
     if (avs_is_err(err)) {
         return err;
     }
 
     mbedtls_ssl_conf_ciphersuites(&socket->config,
-                                  socket->effective_ciphersuites);
+                                  socket->context->effective_ciphersuites);
     return AVS_OK;
 }
+
+static avs_error_t initialize_psk_security(
+        avs_net_ssl_context_t *context,
+        const avs_net_socket_tls_ciphersuites_t *tls_ciphersuites,
+        const avs_net_psk_info_t *psk_info) {
+    if (!(context->effective_ciphersuites =
+                  init_psk_ciphersuites(tls_ciphersuites))) {
+        return avs_errno(AVS_ENOMEM);
+    }
+
+    avs_error_t err;
+    (void) (avs_is_err((err = avs_crypto_psk_key_info_copy(&context->psk_key,
+                                                           psk_info->key)))
+            || avs_is_err((err = avs_crypto_psk_identity_info_copy(
+                                   &context->psk_identity,
+                                   psk_info->identity))));
+    return err;
+}
 #    else  // AVS_COMMONS_WITH_AVS_CRYPTO_PSK
+#        define configure_psk_security(...) avs_errno(AVS_ENOTSUP)
+
 static inline avs_error_t initialize_psk_security(
-        ssl_socket_t *socket,
+        avs_net_ssl_context_t *context,
         const avs_net_socket_tls_ciphersuites_t *tls_ciphersuites,
         const avs_net_psk_info_t *psk_info) {
-    (void) socket;
+    (void) context;
     (void) tls_ciphersuites;
     (void) psk_info;
     LOG(ERROR, _("PSK support disabled"));
@@ -873,6 +1012,151 @@ static bool sessions_equal(const mbedtls_ssl_session *left,
 #        endif     // MBEDTLS_SSL_SRV_C
 #    endif         // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
 
+#    ifdef WITH_SSL_SERVER_SESSIONS
+/*
+ * The session cache and ticket key contexts are shared between all sockets
+ * created from a context, so they are accessed under its mutex. Successful
+ * lookups also mark the session as resumed, as Mbed TLS does not report that
+ * on the server side otherwise.
+ */
+#        ifdef MBEDTLS_SSL_CACHE_C
+static int server_cache_get(void *socket_,
+#            if MBEDTLS_VERSION_NUMBER >= 0x03000000
+                            unsigned char const *session_id,
+                            size_t session_id_len,
+#            endif // MBEDTLS_VERSION_NUMBER >= 0x03000000
+                            mbedtls_ssl_session *session) {
+    ssl_socket_t *socket = (ssl_socket_t *) socket_;
+    avs_mutex_lock(socket->context->mutex);
+    int result = mbedtls_ssl_cache_get(socket->context->server_cache,
+#            if MBEDTLS_VERSION_NUMBER >= 0x03000000
+                                       session_id, session_id_len,
+#            endif // MBEDTLS_VERSION_NUMBER >= 0x03000000
+                                       session);
+    avs_mutex_unlock(socket->context->mutex);
+    if (!result) {
+        socket->flags.session_fresh = false;
+    }
+    return result;
+}
+
+static int server_cache_set(void *socket_,
+#            if MBEDTLS_VERSION_NUMBER >= 0x03000000
+                            unsigned char const *session_id,
+                            size_t session_id_len,
+#            endif // MBEDTLS_VERSION_NUMBER >= 0x03000000
+                            const mbedtls_ssl_session *session) {
+    ssl_socket_t *socket = (ssl_socket_t *) socket_;
+    avs_mutex_lock(socket->context->mutex);
+    int result = mbedtls_ssl_cache_set(socket->context->server_cache,
+#            if MBEDTLS_VERSION_NUMBER >= 0x03000000
+                                       session_id, session_id_len,
+#            endif // MBEDTLS_VERSION_NUMBER >= 0x03000000
+                                       session);
+    avs_mutex_unlock(socket->context->mutex);
+    return result;
+}
+#        endif // MBEDTLS_SSL_CACHE_C
+
+#        ifdef MBEDTLS_SSL_TICKET_C
+static int server_ticket_write(void *socket_,
+                               const mbedtls_ssl_session *session,
+                               unsigned char *start,
+                               const unsigned char *end,
+                               size_t *tlen,
+                               uint32_t *lifetime) {
+    ssl_socket_t *socket = (ssl_socket_t *) socket_;
+    avs_mutex_lock(socket->context->mutex);
+    int result = mbedtls_ssl_ticket_write(socket->context->ticket_ctx, session,
+                                          start, end, tlen, lifetime);
+    avs_mutex_unlock(socket->context->mutex);
+    return result;
+}
+
+static int server_ticket_parse(void *socket_,
+                               mbedtls_ssl_session *session,
+                               unsigned char *buf,
+                               size_t len) {
+    ssl_socket_t *socket = (ssl_socket_t *) socket_;
+    avs_mutex_lock(socket->context->mutex);
+    int result = mbedtls_ssl_ticket_parse(socket->context->ticket_ctx, session,
+                                          buf, len);
+    avs_mutex_unlock(socket->context->mutex);
+    if (!result) {
+        socket->flags.session_fresh = false;
+    }
+    return result;
+}
+#        endif // MBEDTLS_SSL_TICKET_C
+
+static void configure_server_session_callbacks(ssl_socket_t *socket) {
+#        ifdef MBEDTLS_SSL_CACHE_C
+    if (socket->context->server_cache) {
+        mbedtls_ssl_conf_session_cache(&socket->config, socket,
+                                       server_cache_get, server_cache_set);
+    }
+#        endif // MBEDTLS_SSL_CACHE_C
+#        ifdef MBEDTLS_SSL_TICKET_C
+    if (socket->context->ticket_ctx) {
+        mbedtls_ssl_conf_session_tickets_cb(&socket->config,
+                                            server_ticket_write,
+                                            server_ticket_parse, socket);
+    }
+#        endif // MBEDTLS_SSL_TICKET_C
+    (void) socket;
+}
+
+static avs_error_t
+initialize_server_sessions(avs_net_ssl_context_t *context,
+                           const avs_net_ssl_server_session_config_t *config) {
+    int64_t lifetime_s;
+    (void) avs_time_duration_to_scalar(&lifetime_s, AVS_TIME_S,
+                                       config->lifetime);
+    if (config->max_sessions) {
+#        ifdef MBEDTLS_SSL_CACHE_C
+        if (!(context->server_cache = (mbedtls_ssl_cache_context *) avs_calloc(
+                      1, sizeof(mbedtls_ssl_cache_context)))) {
+            LOG(ERROR, _("Out of memory"));
+            return avs_errno(AVS_ENOMEM);
+        }
+        mbedtls_ssl_cache_init(context->server_cache);
+        mbedtls_ssl_cache_set_max_entries(
+                context->server_cache, (int) AVS_MIN(config->max_sessions,
+                                                     (size_t) INT_MAX));
+#            ifdef MBEDTLS_HAVE_TIME
+        mbedtls_ssl_cache_set_timeout(context->server_cache,
+                                      (int) AVS_MIN(lifetime_s, INT_MAX));
+#            endif // MBEDTLS_HAVE_TIME
+#        else      // MBEDTLS_SSL_CACHE_C
+        LOG(ERROR, _("server-side session cache requires MBEDTLS_SSL_CACHE_C"));
+        return avs_errno(AVS_ENOTSUP);
+#        endif     // MBEDTLS_SSL_CACHE_C
+    }
+    if (config->use_tickets) {
+#        ifdef MBEDTLS_SSL_TICKET_C
+        if (!(context->ticket_ctx = (mbedtls_ssl_ticket_context *) avs_calloc(
+                      1, sizeof(mbedtls_ssl_ticket_context)))) {
+            LOG(ERROR, _("Out of memory"));
+            return avs_errno(AVS_ENOMEM);
+        }
+        mbedtls_ssl_ticket_init(context->ticket_ctx);
+        // Mbed TLS rotates the key every lifetime, keeping the previous one
+        int result = mbedtls_ssl_ticket_setup(
+                context->ticket_ctx, rng_function, context->prng_ctx,
+                MBEDTLS_CIPHER_AES_256_GCM, (uint32_t) lifetime_s);
+        if (result) {
+            LOG(ERROR, _("mbedtls_ssl_ticket_setup() failed: ") "%d", result);
+            return avs_errno(AVS_EIO);
+        }
+#        else  // MBEDTLS_SSL_TICKET_C
+        LOG(ERROR, _("session tickets require MBEDTLS_SSL_TICKET_C"));
+        return avs_errno(AVS_ENOTSUP);
+#        endif // MBEDTLS_SSL_TICKET_C
+    }
+    return AVS_OK;
+}
+#    endif // WITH_SSL_SERVER_SESSIONS
+
 static int socket_set_dtls_handshake_timeouts(
         ssl_socket_t *socket,
         const avs_net_dtls_handshake_timeouts_t *dtls_handshake_timeouts) {
@@ -921,18 +1205,12 @@ configure_ssl(ssl_socket_t *socket,
     mbedtls_ssl_conf_dbg(&socket->config, debug_mbedtls, NULL);
 #    endif // AVS_COMMONS_NET_WITH_MBEDTLS_LOGS
 
-    if (ssl_version_as_mbedtls_pair(&socket->config_version_major,
-                                    &socket->config_version_minor,
-                                    configuration->version)) {
-        LOG(ERROR, _("Could not set SSL version configuration"));
-        return avs_errno(AVS_ENOTSUP);
-    }
-
-    mbedtls_ssl_conf_min_version(&socket->config, socket->config_version_major,
-                                 socket->config_version_minor);
+    mbedtls_ssl_conf_min_version(&socket->config,
+                                 socket->context->config_version_major,
+                                 socket->context->config_version_minor);
 
     mbedtls_ssl_conf_rng(&socket->config, rng_function,
-                         configuration->prng_ctx);
+                         socket->context->prng_ctx);
 
     if (socket_set_dtls_handshake_timeouts(
                 socket, configuration->dtls_handshake_timeouts)) {
@@ -986,13 +1264,13 @@ configure_ssl(ssl_socket_t *socket,
            // defined(MBEDTLS_SSL_SRV_C)
 
     avs_error_t err;
-    switch (socket->security_mode) {
+    switch (socket->context->security_mode) {
     case AVS_NET_SECURITY_PSK:
-        err = initialize_psk_security(socket, &configuration->ciphersuites,
-                                      &configuration->security.data.psk);
+        err = configure_psk_security(socket);
         break;
     case AVS_NET_SECURITY_CERTIFICATE:
-        err = initialize_cert_security(socket, &configuration->ciphersuites);
+        configure_cert_security(socket);
+        err = AVS_OK;
         break;
     default:
         AVS_UNREACHABLE("invalid enum value");
@@ -1002,8 +1280,9 @@ configure_ssl(ssl_socket_t *socket,
         return err;
     }
 
-    if (configuration->additional_configuration_clb
-            && configuration->additional_configuration_clb(&socket->config)) {
+    if (socket->context->additional_configuration_clb
+            && socket->context->additional_configuration_clb(
+                       &socket->config)) {
         LOG(ERROR, _("Error while setting additional SSL configuration"));
         return avs_errno(AVS_EPIPE);
     }
@@ -1035,6 +1314,9 @@ static avs_error_t update_ssl_endpoint_config(ssl_socket_t *socket,
         mbedtls_ssl_conf_session_tickets(&socket->config,
                                          MBEDTLS_SSL_SESSION_TICKETS_DISABLED);
 #    endif // MBEDTLS_SSL_SESSION_TICKETS
+#    ifdef WITH_SSL_SERVER_SESSIONS
+        configure_server_session_callbacks(socket);
+#    endif // WITH_SSL_SERVER_SESSIONS
     } else {
         LOG(ERROR, _("initialize_ssl_config: invalid socket state"));
         return avs_errno(AVS_EINVAL);
@@ -1061,6 +1343,9 @@ static void try_save_session(ssl_socket_t *socket) {
         _avs_net_mbedtls_session_save(&session,
                                       socket->session_resumption_buffer,
                                       socket->session_resumption_buffer_size);
+#        ifdef WITH_SSL_SESSION_CACHE
+        store_cached_session(socket);
+#        endif // WITH_SSL_SESSION_CACHE
     }
     mbedtls_ssl_session_free(&session);
 }
@@ -1077,7 +1362,7 @@ static inline void try_save_session_if_new(ssl_socket_t *socket) {
 }
 #    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
 
-static avs_error_t start_ssl(ssl_socket_t *socket, const char *host) {
+static avs_error_t prepare_ssl(ssl_socket_t *socket, const char *host) {
     int result;
     int endpoint = 0;
     avs_error_t err;
@@ -1093,7 +1378,7 @@ static avs_error_t start_ssl(ssl_socket_t *socket, const char *host) {
     mbedtls_ssl_session_init(&restored_session);
 #    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
 
-    mbedtls_ssl_init(&socket->context);
+    mbedtls_ssl_init(&socket->ssl_context);
     socket->flags.context_valid = true;
 
     mbedtls_ssl_set_bio(get_context(socket), socket, avs_bio_send, NULL,
@@ -1114,8 +1399,8 @@ static avs_error_t start_ssl(ssl_socket_t *socket, const char *host) {
         // has then minimum version higher than the maximum version. Let's set
         // the maximum version to be equal to the minimum one and retry...
         mbedtls_ssl_conf_max_version(&socket->config,
-                                     socket->config_version_major,
-                                     socket->config_version_minor);
+                                     socket->context->config_version_major,
+                                     socket->context->config_version_minor);
         result = mbedtls_ssl_setup(get_context(socket), &socket->config);
     }
 #    endif // MBEDTLS_ERR_SSL_BAD_CONFIG
@@ -1193,11 +1478,49 @@ static avs_error_t start_ssl(ssl_socket_t *socket, const char *host) {
         }
     }
     socket->flags.session_fresh = !restore_session;
+#    else  // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
+    // may be cleared by the server-side session lookup callbacks
+    socket->flags.session_fresh = true;
 #    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
 
+finish:
+#    ifdef AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
+    mbedtls_ssl_session_free(&restored_session);
+#    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
+    if (avs_is_err(err)) {
+        mbedtls_ssl_free(get_context(socket));
+        socket->flags.context_valid = false;
+    }
+    return err;
+}
+
+#    if defined(AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE) \
+            && !defined(MBEDTLS_SSL_SRV_C)
+static bool is_restored_session_used(ssl_socket_t *socket) {
+    // the resumption buffer is only overwritten after the handshake
+    mbedtls_ssl_session restored_session;
+    mbedtls_ssl_session_init(&restored_session);
+    bool result =
+            avs_is_ok(_avs_net_mbedtls_session_restore(
+                    &restored_session, socket->session_resumption_buffer,
+                    socket->session_resumption_buffer_size))
+            && sessions_equal(get_context(socket)->session, &restored_session);
+    mbedtls_ssl_session_free(&restored_session);
+    return result;
+}
+#    endif // defined(AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE) &&
+           // !defined(MBEDTLS_SSL_SRV_C)
+
+static avs_error_t handshake_step(ssl_socket_t *socket) {
+    int result;
+    avs_error_t err = AVS_OK;
     socket->bio_error = AVS_OK;
     do {
         result = mbedtls_ssl_handshake(get_context(socket));
+        if (socket->async_handshake.in_progress
+                && result == MBEDTLS_ERR_SSL_WANT_READ) {
+            return avs_errno(AVS_EAGAIN);
+        }
     } while (is_retry_result(get_context(socket), result));
     result = wrap_handshake_result(socket, result);
 
@@ -1220,8 +1543,7 @@ static avs_error_t start_ssl(ssl_socket_t *socket, const char *host) {
 #    ifdef AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
 #        ifndef MBEDTLS_SSL_SRV_C
         if (!socket->flags.session_fresh
-                && !sessions_equal(get_context(socket)->session,
-                                   &restored_session)) {
+                && !is_restored_session_used(socket)) {
             socket->flags.session_fresh = true;
         }
 #        endif // MBEDTLS_SSL_SRV_C
@@ -1230,8 +1552,6 @@ static avs_error_t start_ssl(ssl_socket_t *socket, const char *host) {
             // configuration.
             try_save_session(socket);
         }
-#    else  // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
-        socket->flags.session_fresh = true;
 #    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
         if (socket->flags.session_fresh) {
             LOG(TRACE, _("handshake success: new session started"));
@@ -1247,19 +1567,18 @@ static avs_error_t start_ssl(ssl_socket_t *socket, const char *host) {
             }
         }
         LOG(ERROR, _("handshake failed: ") "%d", result);
-    }
-
-finish:
-#    ifdef AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
-    mbedtls_ssl_session_free(&restored_session);
-#    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
-    if (avs_is_err(err)) {
         mbedtls_ssl_free(get_context(socket));
         socket->flags.context_valid = false;
-        return err;
-    } else {
-        return AVS_OK;
     }
+    return err;
+}
+
+static avs_error_t start_ssl(ssl_socket_t *socket, const char *host) {
+    avs_error_t err = prepare_ssl(socket, host);
+    if (avs_is_ok(err)) {
+        err = handshake_step(socket);
+    }
+    return err;
 }
 
 static avs_error_t
@@ -1391,11 +1710,6 @@ static void cleanup_security_cert(ssl_socket_certs_t *certs) {
     _avs_crypto_mbedtls_x509_crl_cleanup(&certs->ca_crl);
     _avs_crypto_mbedtls_x509_crt_cleanup(&certs->client_cert);
     _avs_crypto_mbedtls_pk_context_cleanup(&certs->client_key);
-#        ifdef WITH_DANE_SUPPORT
-    // NOTE: Not freeing dane_ta_certs, as it is supposed to be on the
-    // ca_cert chain, so has been freed together with ca_cert
-    avs_free((void *) (intptr_t) (const void *) certs->dane_tlsa.array_ptr);
-#        endif // WITH_DANE_SUPPORT
 }
 #    else // AVS_COMMONS_WITH_AVS_CRYPTO_PKI
 #        define cleanup_security_cert(...) (void) 0
@@ -1408,12 +1722,16 @@ static avs_error_t cleanup_ssl(avs_net_socket_t **socket_) {
     avs_error_t err = close_ssl(*socket_);
     add_err(&err, avs_net_socket_cleanup(&(*socket)->backend_socket));
 
-    if ((*socket)->security_mode == AVS_NET_SECURITY_CERTIFICATE) {
-        cleanup_security_cert(&(*socket)->cert_security);
-    }
-    avs_free((*socket)->effective_ciphersuites);
-
     mbedtls_ssl_config_free(&(*socket)->config);
+    release_ssl_context(&(*socket)->context);
+#    ifdef WITH_DANE_SUPPORT
+    avs_free((void *) (intptr_t) (const void *) (*socket)
+                     ->dane_tlsa_array_field.array_ptr);
+    _avs_crypto_mbedtls_x509_crt_cleanup(&(*socket)->dane_ca_cert);
+#    endif // WITH_DANE_SUPPORT
+#    ifdef WITH_SSL_SESSION_CACHE
+    avs_free((*socket)->session_cache_slot);
+#    endif // WITH_SSL_SESSION_CACHE
 
     avs_free(*socket);
     *socket = NULL;
@@ -1608,18 +1926,7 @@ configure_ssl_certs(ssl_socket_certs_t *certs,
 
     if (cert_info->dane) {
 #        ifdef WITH_DANE_SUPPORT
-        mbedtls_x509_crt **insert_ptr = &certs->ca_cert;
-        while (*insert_ptr) {
-            insert_ptr = _avs_crypto_mbedtls_x509_crt_next_ptr(*insert_ptr);
-        }
-        if (!(*insert_ptr = (mbedtls_x509_crt *) mbedtls_calloc(
-                      1, sizeof(**insert_ptr)))) {
-            LOG(ERROR, _("Out of memory"));
-            err = avs_errno(AVS_ENOMEM);
-        } else {
-            mbedtls_x509_crt_init(*insert_ptr);
-            certs->dane_ta_certs = *insert_ptr;
-        }
+        certs->dane = true;
 #        else  // WITH_DANE_SUPPORT
         LOG(ERROR, _("DANE not supported"));
         err = avs_errno(AVS_ENOTSUP);
@@ -1629,43 +1936,91 @@ configure_ssl_certs(ssl_socket_certs_t *certs,
     return err;
 }
 
+static avs_error_t initialize_cert_security(
+        avs_net_ssl_context_t *context,
+        const avs_net_socket_tls_ciphersuites_t *tls_ciphersuites,
+        const avs_net_certificate_info_t *cert_info) {
+    if (!(context->effective_ciphersuites =
+                  init_cert_ciphersuites(tls_ciphersuites))) {
+        return avs_errno(AVS_ENOMEM);
+    }
+    return configure_ssl_certs(&context->cert_security, cert_info,
+                               context->prng_ctx);
+}
 #    else // AVS_COMMONS_WITH_AVS_CRYPTO_PKI
-static inline avs_error_t configure_ssl_certs_impl(void) {
+static inline avs_error_t initialize_cert_security_impl(void) {
     LOG(ERROR, _("X.509 support disabled"));
     return avs_errno(AVS_ENOTSUP);
 }
 
-#        define configure_ssl_certs(...) configure_ssl_certs_impl()
+#        define initialize_cert_security(...) initialize_cert_security_impl()
 #    endif // AVS_COMMONS_WITH_AVS_CRYPTO_PKI
 
+static avs_error_t
+initialize_ssl_context(avs_net_ssl_context_t *context,
+                       const avs_net_ssl_configuration_t *configuration) {
+    if (ssl_version_as_mbedtls_pair(&context->config_version_major,
+                                    &context->config_version_minor,
+                                    configuration->version)) {
+        LOG(ERROR, _("Could not set SSL version configuration"));
+        return avs_errno(AVS_ENOTSUP);
+    }
+    context->prng_ctx = configuration->prng_ctx;
+    context->additional_configuration_clb =
+            configuration->additional_configuration_clb;
+
+    context->security_mode = configuration->security.mode;
+    switch (configuration->security.mode) {
+    case AVS_NET_SECURITY_PSK:
+        return initialize_psk_security(context, &configuration->ciphersuites,
+                                       &configuration->security.data.psk);
+    case AVS_NET_SECURITY_CERTIFICATE:
+        return initialize_cert_security(context, &configuration->ciphersuites,
+                                        &configuration->security.data.cert);
+    default:
+        AVS_UNREACHABLE("invalid enum value");
+        return avs_errno(AVS_EINVAL);
+    }
+}
+
+static void cleanup_ssl_context(avs_net_ssl_context_t *context) {
+    if (context->security_mode == AVS_NET_SECURITY_CERTIFICATE) {
+        cleanup_security_cert(&context->cert_security);
+    }
+#    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PSK
+    avs_free(context->psk_key);
+    avs_free(context->psk_identity);
+#    endif // AVS_COMMONS_WITH_AVS_CRYPTO_PSK
+    avs_free(context->effective_ciphersuites);
+#    ifdef WITH_SSL_SERVER_SESSIONS
+#        ifdef MBEDTLS_SSL_CACHE_C
+    if (context->server_cache) {
+        mbedtls_ssl_cache_free(context->server_cache);
+        avs_free(context->server_cache);
+        context->server_cache = NULL;
+    }
+#        endif // MBEDTLS_SSL_CACHE_C
+#        ifdef MBEDTLS_SSL_TICKET_C
+    if (context->ticket_ctx) {
+        mbedtls_ssl_ticket_free(context->ticket_ctx);
+        avs_free(context->ticket_ctx);
+        context->ticket_ctx = NULL;
+    }
+#        endif // MBEDTLS_SSL_TICKET_C
+#    endif // WITH_SSL_SERVER_SESSIONS
+}
+
 static avs_error_t
 initialize_ssl_socket(ssl_socket_t *socket,
                       avs_net_socket_type_t backend_type,
                       const avs_net_ssl_configuration_t *configuration) {
-    avs_error_t err = AVS_OK;
     *(const avs_net_socket_v_table_t **) (intptr_t) &socket->operations =
             &ssl_vtable;
 
     socket->flags.session_fresh = true;
     socket->backend_type = backend_type;
     socket->backend_configuration = configuration->backend_configuration;
-
-    socket->security_mode = configuration->security.mode;
-    switch (configuration->security.mode) {
-    case AVS_NET_SECURITY_PSK:
-        // do nothing right here
-        break;
-    case AVS_NET_SECURITY_CERTIFICATE:
-        err = configure_ssl_certs(&socket->cert_security,
-                                  &configuration->security.data.cert,
-                                  configuration->prng_ctx);
-        break;
-    default:
-        AVS_UNREACHABLE("invalid enum value");
-        err = avs_errno(AVS_EINVAL);
-    }
-
-    return avs_is_ok(err) ? configure_ssl(socket, configuration) : err;
+    return configure_ssl(socket, configuration);
 }
 
 #    ifdef AVS_UNIT_TESTING
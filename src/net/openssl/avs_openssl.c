@@ -24,6 +24,9 @@
 
 #    include <openssl/bn.h>
 #    include <openssl/hmac.h>
+#    if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#        include <openssl/core_names.h>
+#    endif // OPENSSL_VERSION_NUMBER >= 0x30000000L
 #    include <openssl/md5.h>
 #    include <openssl/rand.h>
 #    include <openssl/rsa.h>
@@ -41,6 +44,7 @@
 
 #    include <avsystem/commons/avs_errno_map.h>
 #    include <avsystem/commons/avs_memory.h>
+#    include <avsystem/commons/avs_mutex.h>
 #    include <avsystem/commons/avs_stream_membuf.h>
 #    include <avsystem/commons/avs_time.h>
 
@@ -80,6 +84,27 @@ VISIBILITY_SOURCE_BEGIN
 #        define WITH_DANE_SUPPORT
 #    endif
 
+#    ifdef AVS_COMMONS_NET_WITH_TLS_SESSION_CACHE
+#        define WITH_SSL_SESSION_CACHE
+#    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_CACHE
+
+// non-blocking reads need the custom BIO, and hostname verification performed
+// by OpenSSL itself
+#    if defined(BIO_TYPE_SOURCE_SINK) && OPENSSL_VERSION_NUMBER_GE(1, 0, 2)
+#        define WITH_SSL_ASYNC_HANDSHAKE
+#    endif
+
+#    if OPENSSL_VERSION_NUMBER_GE(1, 1, 0)
+#        define WITH_SSL_SERVER_SESSIONS
+
+typedef struct {
+    unsigned char name[16];
+    unsigned char aes_key[32];
+    unsigned char hmac_key[32];
+    avs_time_monotonic_t created;
+} ticket_key_t;
+#    endif // OPENSSL_VERSION_NUMBER_GE(1, 1, 0)
+
 typedef enum {
     SSL_VERIFY_DISABLED = 0,
     SSL_VERIFY_TRUSTSTORE,
@@ -87,11 +112,31 @@ typedef enum {
     SSL_VERIFY_DANE_OPPORTUNISTIC
 } ssl_verify_mode_t;
 
+struct avs_net_ssl_context_struct {
+    avs_mutex_t *mutex;
+    unsigned refcount;
+    avs_net_socket_type_t backend_type;
+    SSL_CTX *ctx;
+    ssl_verify_mode_t verify_mode;
+#    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PSK
+    avs_crypto_psk_key_info_t *psk_key;
+    avs_crypto_psk_identity_info_t *psk_identity;
+#    endif
+#    ifdef WITH_SSL_SESSION_CACHE
+    _avs_net_session_cache_t *session_cache;
+#    endif // WITH_SSL_SESSION_CACHE
+#    ifdef WITH_SSL_SERVER_SESSIONS
+    avs_net_ssl_server_session_stats_t server_session_stats;
+    avs_time_duration_t ticket_key_lifetime;
+    /// Current and previous session ticket key, guarded by the mutex
+    ticket_key_t ticket_keys[2];
+#    endif // WITH_SSL_SERVER_SESSIONS
+};
+
 typedef struct {
     const avs_net_socket_v_table_t *const operations;
-    SSL_CTX *ctx;
+    avs_net_ssl_context_t *context;
     SSL *ssl;
-    ssl_verify_mode_t verify_mode;
     avs_error_t bio_error;
     avs_time_real_t next_deadline;
     avs_net_socket_type_t backend_type;
@@ -102,19 +147,22 @@ typedef struct {
     } dtls_handshake_timeouts;
     avs_net_socket_configuration_t backend_configuration;
     avs_net_resolved_endpoint_t endpoint_buffer;
-
-#    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PSK
-    avs_crypto_psk_key_info_t *psk_key;
-    avs_crypto_psk_identity_info_t *psk_identity;
-#    endif
+#    ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+    avs_net_socket_stats_t stats;
+#    endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
+#    ifdef WITH_SSL_ASYNC_HANDSHAKE
+    _avs_net_ssl_async_handshake_t async_handshake;
+#    endif // WITH_SSL_ASYNC_HANDSHAKE
 
 #    ifdef AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
     void *session_resumption_buffer;
     size_t session_resumption_buffer_size;
 #    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
+#    ifdef WITH_SSL_SESSION_CACHE
+    /// Backs session_resumption_buffer if the context has a session cache.
+    _avs_net_session_cache_slot_t *session_cache_slot;
+#    endif // WITH_SSL_SESSION_CACHE
 
-    /// Set of ciphersuites configured by user
-    avs_net_socket_tls_ciphersuites_t enabled_ciphersuites;
     /// Non empty, when custom server hostname shall be used.
     char server_name_indication[256];
 
@@ -380,6 +428,12 @@ static int avs_bio_read(BIO *bio, char *buffer, int size) {
     if (socket_is_datagram(sock)) {
         prev_timeout = adjust_receive_timeout(sock);
     }
+#        ifdef WITH_SSL_ASYNC_HANDSHAKE
+    if (sock->async_handshake.in_progress) {
+        prev_timeout = get_socket_timeout(sock->backend_socket);
+        set_socket_timeout(sock->backend_socket, AVS_TIME_DURATION_ZERO);
+    }
+#        endif // WITH_SSL_ASYNC_HANDSHAKE
     if (avs_is_err((sock->bio_error = avs_net_socket_receive(
                             sock->backend_socket, &read_bytes, buffer,
                             (size_t) size)))) {
@@ -387,6 +441,16 @@ static int avs_bio_read(BIO *bio, char *buffer, int size) {
     } else {
         result = (int) read_bytes;
     }
+#        ifdef WITH_SSL_ASYNC_HANDSHAKE
+    if (sock->async_handshake.in_progress) {
+        set_socket_timeout(sock->backend_socket, prev_timeout);
+        if (sock->bio_error.category == AVS_ERRNO_CATEGORY
+                && sock->bio_error.code == AVS_ETIMEDOUT) {
+            // no data yet; makes SSL_do_handshake() report SSL_ERROR_WANT_READ
+            BIO_set_retry_read(bio);
+        }
+    }
+#        endif // WITH_SSL_ASYNC_HANDSHAKE
     if (socket_is_datagram(sock)) {
         set_socket_timeout(sock->backend_socket, prev_timeout);
     }
@@ -596,7 +660,7 @@ static int verify_peer_subject_cn(ssl_socket_t *ssl_socket, const char *host) {
 }
 #    endif // OPENSSL_VERSION_NUMBER_LT(1, 0, 2)
 
-static avs_error_t ssl_handshake(ssl_socket_t *socket) {
+static avs_error_t set_handshake_role(ssl_socket_t *socket) {
     avs_net_socket_opt_value_t state_opt;
     avs_error_t err =
             avs_net_socket_get_opt(socket->backend_socket,
@@ -605,8 +669,6 @@ static avs_error_t ssl_handshake(ssl_socket_t *socket) {
         LOG(ERROR, _("ssl_handshake: could not get socket state"));
         return err;
     }
-    socket->bio_error = AVS_OK;
-    int result;
     if (state_opt.state == AVS_NET_SOCKET_STATE_CONNECTED) {
 #    ifdef AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
         if (socket->session_resumption_buffer) {
@@ -626,14 +688,26 @@ static avs_error_t ssl_handshake(ssl_socket_t *socket) {
             SSL_SESSION_free(session);
         }
 #    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
-        result = SSL_connect(socket->ssl);
+        SSL_set_connect_state(socket->ssl);
     } else if (state_opt.state == AVS_NET_SOCKET_STATE_ACCEPTED) {
-        result = SSL_accept(socket->ssl);
+        SSL_set_accept_state(socket->ssl);
     } else {
         LOG(ERROR, _("ssl_handshake: invalid socket state"));
         return avs_errno(AVS_EBADF);
     }
+    return AVS_OK;
+}
+
+static avs_error_t ssl_handshake(ssl_socket_t *socket) {
+    socket->bio_error = AVS_OK;
+    int result = SSL_do_handshake(socket->ssl);
     if (result <= 0) {
+#    ifdef WITH_SSL_ASYNC_HANDSHAKE
+        if (socket->async_handshake.in_progress
+                && SSL_get_error(socket->ssl, result) == SSL_ERROR_WANT_READ) {
+            return avs_errno(AVS_EAGAIN);
+        }
+#    endif // WITH_SSL_ASYNC_HANDSHAKE
         if (avs_is_err(socket->bio_error)) {
             return socket->bio_error;
         } else {
@@ -669,13 +743,13 @@ static avs_error_t ssl_handshake(ssl_socket_t *socket) {
 // to any single particular version. These are two "eras" of TLS ciphersuites.
 
 static avs_error_t
-configure_ciphersuite_lists(ssl_socket_t *socket,
+configure_ciphersuite_lists(SSL_CTX *ctx,
                             const char *legacy_ciphersuite_list,
                             const char *session_ciphersuite_list) {
     bool error = false;
 
     LOG(DEBUG, _("TLS <=1.2 cipher list: ") "%s", legacy_ciphersuite_list);
-    if (!SSL_set_cipher_list(socket->ssl, legacy_ciphersuite_list)) {
+    if (!SSL_CTX_set_cipher_list(ctx, legacy_ciphersuite_list)) {
         if (session_ciphersuite_list && *session_ciphersuite_list
                 && ERR_GET_REASON(ERR_peek_last_error())
                                == SSL_R_NO_CIPHER_MATCH) {
@@ -692,7 +766,7 @@ configure_ciphersuite_lists(ssl_socket_t *socket,
     LOG(DEBUG, _("TLS 1.3 cipher list: ") "%s", session_ciphersuite_list);
     if (
 #    if OPENSSL_VERSION_NUMBER_GE(1, 1, 1)
-                !SSL_set_ciphersuites(socket->ssl, session_ciphersuite_list)
+                !SSL_CTX_set_ciphersuites(ctx, session_ciphersuite_list)
 #    else  // OPENSSL_VERSION_NUMBER_GE(1, 1, 1)
                 session_ciphersuite_list && *session_ciphersuite_list
                     && strcmp(session_ciphersuite_list,
@@ -725,7 +799,8 @@ static bool is_session_ciphersuite(const SSL_CIPHER *cipher) {
 #    endif // OPENSSL_VERSION_NUMBER_GE(1, 1, 1)
 
 static avs_error_t
-ids_to_ciphersuite_lists(ssl_socket_t *socket,
+ids_to_ciphersuite_lists(const avs_net_ssl_context_t *context,
+                         SSL *ssl,
                          const avs_net_socket_tls_ciphersuites_t *suites,
                          char **out_legacy_ciphersuite_list,
                          char **out_session_ciphersuite_list) {
@@ -759,7 +834,7 @@ ids_to_ciphersuite_lists(ssl_socket_t *socket,
         unsigned char id_as_chars[] = { (unsigned char) ((suites->ids[i]) >> 8),
                                         (unsigned char) ((suites->ids[i])
                                                          & 0xFF) };
-        const SSL_CIPHER *cipher = SSL_CIPHER_find(socket->ssl, id_as_chars);
+        const SSL_CIPHER *cipher = SSL_CIPHER_find(ssl, id_as_chars);
         if (!cipher) {
             LOG(DEBUG, _("ignoring unsupported cipher ID: 0x") "%04x",
                 suites->ids[i]);
@@ -774,7 +849,7 @@ ids_to_ciphersuite_lists(ssl_socket_t *socket,
         } else
 #    endif // OPENSSL_VERSION_NUMBER_GE(1, 1, 1)
 #    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PSK
-                if (socket->psk_key) {
+                if (context->psk_key) {
             if (!strstr(name, "PSK")) {
                 LOG(DEBUG, _("ignoring non-PSK cipher ID: 0x") "%04x",
                     suites->ids[i]);
@@ -830,6 +905,15 @@ finish:
 #    ifdef AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
 static int new_session_cb(SSL *ssl, SSL_SESSION *sess) {
     ssl_socket_t *socket = (ssl_socket_t *) SSL_get_app_data(ssl);
+    if (!socket->session_resumption_buffer) {
+        return 0;
+    }
+#        ifdef WITH_SSL_SERVER_SESSIONS
+    // called for server-side sessions if server_sessions are configured
+    if (SSL_is_server(ssl)) {
+        return 0;
+    }
+#        endif // WITH_SSL_SERVER_SESSIONS
 
     int result = 0;
     int serialized_size = i2d_SSL_SESSION(sess, NULL);
@@ -847,24 +931,183 @@ static int new_session_cb(SSL *ssl, SSL_SESSION *sess) {
     assert((size_t) result <= socket->session_resumption_buffer_size);
     memset(&((char *) socket->session_resumption_buffer)[result], 0,
            socket->session_resumption_buffer_size - (size_t) result);
+#        ifdef WITH_SSL_SESSION_CACHE
+    store_cached_session(socket);
+#        endif // WITH_SSL_SESSION_CACHE
     return 0;
 }
 
-static void enable_session_cache(ssl_socket_t *socket) {
-    avs_net_socket_opt_value_t state_opt;
-    if (avs_is_ok(avs_net_socket_get_opt((avs_net_socket_t *) socket,
-                                         AVS_NET_SOCKET_OPT_STATE, &state_opt))
-            && state_opt.state == AVS_NET_SOCKET_STATE_CONNECTED) {
-        SSL_CTX_set_session_cache_mode(
-                socket->ctx,
-                SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
-        SSL_CTX_sess_set_new_cb(socket->ctx, new_session_cb);
+/*
+ * SSL_CTX may be shared between sockets, so this is only done once. Server-side
+ * SSL objects never call new_session_cb(), as SSL_SESS_CACHE_SERVER is not set,
+ * unless enabled by initialize_server_sessions().
+ */
+static void enable_session_cache(SSL_CTX *ctx) {
+    SSL_CTX_set_session_cache_mode(
+            ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx, new_session_cb);
+}
+#    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
+
+#    ifdef WITH_SSL_SERVER_SESSIONS
+static int generate_ticket_key(ticket_key_t *out_key) {
+    ticket_key_t key;
+    if (RAND_bytes(key.name, sizeof(key.name)) <= 0
+            || RAND_bytes(key.aes_key, sizeof(key.aes_key)) <= 0
+            || RAND_bytes(key.hmac_key, sizeof(key.hmac_key)) <= 0) {
+        LOG(ERROR, _("could not generate session ticket key"));
+        return -1;
+    }
+    key.created = avs_time_monotonic_now();
+    *out_key = key;
+    OPENSSL_cleanse(&key, sizeof(key));
+    return 0;
+}
+
+/**
+ * Copies the key to protect a new ticket with, or the one that a ticket named
+ * @p key_name has been protected with, to @p out_key . The current key is
+ * rotated first if it is older than the configured lifetime.
+ *
+ * @returns 1 if the current key has been copied, 2 if the previous one has
+ *          been (so that the ticket is renewed), 0 if there is no key named
+ *          @p key_name , or -1 on error - as expected from the ticket key
+ *          callback.
+ */
+static int get_ticket_key(avs_net_ssl_context_t *context,
+                          const unsigned char *key_name,
+                          bool encrypt,
+                          ticket_key_t *out_key) {
+    int result = 0;
+    avs_mutex_lock(context->mutex);
+    if (!avs_time_monotonic_before(
+                avs_time_monotonic_now(),
+                avs_time_monotonic_add(context->ticket_keys[0].created,
+                                       context->ticket_key_lifetime))) {
+        ticket_key_t new_key;
+        if (generate_ticket_key(&new_key)) {
+            result = -1;
+        } else {
+            context->ticket_keys[1] = context->ticket_keys[0];
+            context->ticket_keys[0] = new_key;
+            OPENSSL_cleanse(&new_key, sizeof(new_key));
+        }
+    }
+    if (!result && encrypt) {
+        *out_key = context->ticket_keys[0];
+        result = 1;
+    } else if (!result) {
+        for (size_t i = 0; i < AVS_ARRAY_SIZE(context->ticket_keys); ++i) {
+            if (!memcmp(key_name, context->ticket_keys[i].name,
+                        sizeof(context->ticket_keys[i].name))) {
+                *out_key = context->ticket_keys[i];
+                result = (int) i + 1;
+                break;
+            }
+        }
+    }
+    avs_mutex_unlock(context->mutex);
+    return result;
+}
+
+#        if OPENSSL_VERSION_NUMBER_GE(3, 0, 0)
+typedef EVP_MAC_CTX ticket_mac_ctx_t;
+
+static int init_ticket_mac(EVP_MAC_CTX *mac_ctx, unsigned char *hmac_key,
+                           size_t hmac_key_size) {
+    char digest[] = "SHA256";
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, hmac_key,
+                                          hmac_key_size),
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0),
+        OSSL_PARAM_construct_end()
+    };
+    return EVP_MAC_CTX_set_params(mac_ctx, params) == 1 ? 0 : -1;
+}
+#        else  // OPENSSL_VERSION_NUMBER_GE(3, 0, 0)
+typedef HMAC_CTX ticket_mac_ctx_t;
+
+static int init_ticket_mac(HMAC_CTX *mac_ctx, unsigned char *hmac_key,
+                           size_t hmac_key_size) {
+    return HMAC_Init_ex(mac_ctx, hmac_key, (int) hmac_key_size, EVP_sha256(),
+                        NULL)
+                           == 1
+                   ? 0
+                   : -1;
+}
+#        endif // OPENSSL_VERSION_NUMBER_GE(3, 0, 0)
+
+static int ticket_key_cb(SSL *ssl,
+                         unsigned char *key_name,
+                         unsigned char *iv,
+                         EVP_CIPHER_CTX *cipher_ctx,
+                         ticket_mac_ctx_t *mac_ctx,
+                         int enc) {
+    ssl_socket_t *socket = (ssl_socket_t *) SSL_get_app_data(ssl);
+    const EVP_CIPHER *cipher = EVP_aes_256_cbc();
+    ticket_key_t key;
+    int result = get_ticket_key(socket->context, key_name, enc, &key);
+    if (result > 0 && enc) {
+        memcpy(key_name, key.name, sizeof(key.name));
+        if (RAND_bytes(iv, EVP_CIPHER_iv_length(cipher)) <= 0) {
+            result = -1;
+        }
+    }
+    if (result > 0
+            && (!EVP_CipherInit_ex(cipher_ctx, cipher, NULL, key.aes_key, iv,
+                                   enc)
+                || init_ticket_mac(mac_ctx, key.hmac_key,
+                                   sizeof(key.hmac_key)))) {
+        result = -1;
+    }
+    OPENSSL_cleanse(&key, sizeof(key));
+    return result;
+}
+
+static avs_error_t
+initialize_server_sessions(avs_net_ssl_context_t *context,
+                           const avs_net_ssl_server_session_config_t *config) {
+    static const unsigned char SESSION_ID_CONTEXT[] = "avs_net";
+    int64_t lifetime_s;
+    (void) avs_time_duration_to_scalar(&lifetime_s, AVS_TIME_S,
+                                       config->lifetime);
+    context->ticket_key_lifetime = config->lifetime;
+
+    // Client-side sessions, if any, are also stored in the internal cache once
+    // it is enabled; they are never looked up on the server side, though.
+    long mode = SSL_CTX_get_session_cache_mode(context->ctx)
+                & ~SSL_SESS_CACHE_NO_INTERNAL_STORE;
+    if (config->max_sessions) {
+        mode |= SSL_SESS_CACHE_SERVER;
+        SSL_CTX_sess_set_cache_size(
+                context->ctx, (long) AVS_MIN(config->max_sessions, LONG_MAX));
     } else {
-        SSL_CTX_set_session_cache_mode(socket->ctx, SSL_SESS_CACHE_OFF);
-        SSL_CTX_sess_set_new_cb(socket->ctx, NULL);
+        mode &= ~SSL_SESS_CACHE_SERVER;
+    }
+    SSL_CTX_set_session_cache_mode(context->ctx, mode);
+    SSL_CTX_set_timeout(context->ctx, (long) lifetime_s);
+    // required for resumption if client certificates are verified
+    if (!SSL_CTX_set_session_id_context(context->ctx, SESSION_ID_CONTEXT,
+                                        sizeof(SESSION_ID_CONTEXT) - 1)) {
+        return avs_errno(AVS_ENOMEM);
+    }
+
+    if (!config->use_tickets) {
+        SSL_CTX_set_options(context->ctx, SSL_OP_NO_TICKET);
+        return AVS_OK;
+    }
+    if (generate_ticket_key(&context->ticket_keys[0])
+            || generate_ticket_key(&context->ticket_keys[1])) {
+        return avs_errno(AVS_EIO);
     }
+#        if OPENSSL_VERSION_NUMBER_GE(3, 0, 0)
+    SSL_CTX_set_tlsext_ticket_key_evp_cb(context->ctx, ticket_key_cb);
+#        else  // OPENSSL_VERSION_NUMBER_GE(3, 0, 0)
+    SSL_CTX_set_tlsext_ticket_key_cb(context->ctx, ticket_key_cb);
+#        endif // OPENSSL_VERSION_NUMBER_GE(3, 0, 0)
+    return AVS_OK;
 }
-#    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
+#    endif // WITH_SSL_SERVER_SESSIONS
 
 #    if defined(AVS_COMMONS_NET_WITH_DTLS) && OPENSSL_VERSION_NUMBER_GE(1, 1, 1)
 static unsigned int dtls_timer_cb(SSL *ssl, unsigned int timer_us) {
@@ -893,58 +1136,59 @@ static unsigned int dtls_timer_cb(SSL *ssl, unsigned int timer_us) {
 #    endif // defined(AVS_COMMONS_NET_WITH_DTLS) && OPENSSL_VERSION_NUMBER_GE(1,
            // 1, 1)
 
-static avs_error_t fix_socket_ciphersuites(ssl_socket_t *socket) {
+static avs_error_t
+configure_ssl_ciphersuites(avs_net_ssl_context_t *context,
+                           const avs_net_socket_tls_ciphersuites_t *suites) {
     avs_error_t err = AVS_OK;
-    if (socket->enabled_ciphersuites.num_ids > 0) {
+    if (suites->num_ids > 0) {
+        // SSL_CIPHER_find() can only look the IDs up through an SSL object
+        SSL *ssl = SSL_new(context->ctx);
+        if (!ssl) {
+            log_openssl_error();
+            return avs_errno(AVS_ENOMEM);
+        }
         char *legacy_ciphersuites_string = NULL;
         char *session_ciphersuites_string = NULL;
-        err = ids_to_ciphersuite_lists(socket, &socket->enabled_ciphersuites,
+        err = ids_to_ciphersuite_lists(context, ssl, suites,
                                        &legacy_ciphersuites_string,
                                        &session_ciphersuites_string);
+        SSL_free(ssl);
         if (avs_is_err(err)) {
             assert(!legacy_ciphersuites_string);
             assert(!session_ciphersuites_string);
             return err;
         }
 
-        err = configure_ciphersuite_lists(socket, legacy_ciphersuites_string,
+        err = configure_ciphersuite_lists(context->ctx,
+                                          legacy_ciphersuites_string,
                                           session_ciphersuites_string);
         avs_free(legacy_ciphersuites_string);
         avs_free(session_ciphersuites_string);
     }
 #    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PSK
-    else if (socket->psk_key) {
-        err = configure_ciphersuite_lists(socket, "PSK",
+    else if (context->psk_key) {
+        err = configure_ciphersuite_lists(context->ctx, "PSK",
                                           TLS_DEFAULT_CIPHERSUITES);
     }
 #    endif // AVS_COMMONS_WITH_AVS_CRYPTO_PSK
     else {
-        err = configure_ciphersuite_lists(socket, "!PSK ALL",
+        err = configure_ciphersuite_lists(context->ctx, "!PSK ALL",
                                           TLS_DEFAULT_CIPHERSUITES);
     }
 
     return err;
 }
 
-static avs_error_t start_ssl(ssl_socket_t *socket, const char *host) {
+static avs_error_t prepare_ssl(ssl_socket_t *socket, const char *host) {
     BIO *bio = NULL;
-    LOG(TRACE, _("start_ssl(socket=") "%p" _(")"), (void *) socket);
-
-#    ifdef AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
-    enable_session_cache(socket);
-#    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
+    LOG(TRACE, _("prepare_ssl(socket=") "%p" _(")"), (void *) socket);
 
-    socket->ssl = SSL_new(socket->ctx);
+    socket->ssl = SSL_new(socket->context->ctx);
     if (!socket->ssl) {
         return avs_errno(AVS_ENOMEM);
     }
     SSL_set_app_data(socket->ssl, socket);
 
-    avs_error_t err;
-    if (avs_is_err((err = fix_socket_ciphersuites(socket)))) {
-        return err;
-    }
-
 #    ifdef SSL_MODE_AUTO_RETRY
     SSL_set_mode(socket->ssl, SSL_MODE_AUTO_RETRY);
 #    endif
@@ -953,12 +1197,12 @@ static avs_error_t start_ssl(ssl_socket_t *socket, const char *host) {
         host = socket->server_name_indication;
     }
 
-    bool verification = (socket->verify_mode != SSL_VERIFY_DISABLED);
+    bool verification = (socket->context->verify_mode != SSL_VERIFY_DISABLED);
 
     int result = 0;
 #    ifdef WITH_DANE_SUPPORT
-    if (socket->verify_mode == SSL_VERIFY_DANE_ENFORCED
-            || socket->verify_mode == SSL_VERIFY_DANE_OPPORTUNISTIC) {
+    if (socket->context->verify_mode == SSL_VERIFY_DANE_ENFORCED
+            || socket->context->verify_mode == SSL_VERIFY_DANE_OPPORTUNISTIC) {
         // NOTE: SSL_dane_enable() calls SSL_set_tlsext_host_name() internally
         if (SSL_dane_enable(socket->ssl, host) <= 0) {
             LOG(ERROR, _("cannot setup DANE extension"));
@@ -969,7 +1213,7 @@ static avs_error_t start_ssl(ssl_socket_t *socket, const char *host) {
         for (size_t i = 0;
              i < socket->dane_tlsa_array_field.array_element_count;
              ++i) {
-            if (socket->verify_mode == SSL_VERIFY_DANE_OPPORTUNISTIC
+            if (socket->context->verify_mode == SSL_VERIFY_DANE_OPPORTUNISTIC
                     && (socket->dane_tlsa_array_field.array_ptr[i]
                                         .certificate_usage
                                 == AVS_NET_SOCKET_DANE_CA_CONSTRAINT
@@ -1001,7 +1245,7 @@ static avs_error_t start_ssl(ssl_socket_t *socket, const char *host) {
             }
         }
 
-        if (socket->verify_mode == SSL_VERIFY_DANE_OPPORTUNISTIC) {
+        if (socket->context->verify_mode == SSL_VERIFY_DANE_OPPORTUNISTIC) {
             if (have_usable_tlsa_records) {
                 SSL_set_verify(socket->ssl, SSL_VERIFY_PEER, NULL);
             } else {
@@ -1055,6 +1299,7 @@ static avs_error_t start_ssl(ssl_socket_t *socket, const char *host) {
     }
 #    endif // defined(AVS_COMMONS_WITH_AVS_CRYPTO_PKI) &&
            // OPENSSL_VERSION_NUMBER_GE(1, 0, 2)
+    (void) verification;
 
     bio = avs_bio_spawn(socket);
     if (!bio) {
@@ -1070,17 +1315,35 @@ static avs_error_t start_ssl(ssl_socket_t *socket, const char *host) {
 #    endif // defined(AVS_COMMONS_NET_WITH_DTLS) && OPENSSL_VERSION_NUMBER_GE(1,
            // 1, 1)
 
+    return set_handshake_role(socket);
+}
+
+static avs_error_t handshake_step(ssl_socket_t *socket) {
     avs_net_socket_t *backend_socket = socket->backend_socket;
-    err = ssl_handshake(socket);
+    avs_error_t err = ssl_handshake(socket);
     // Restore backend socket that might have been disabled by dtls_timer_cb()
     socket->backend_socket = backend_socket;
-    if (avs_is_err(err)) {
+    if (avs_is_err(err) && !is_handshake_pending(err)) {
         LOG(ERROR, _("SSL handshake failed."));
         log_openssl_error();
+    }
+    return err;
+}
+
+static avs_error_t start_ssl(ssl_socket_t *socket, const char *host) {
+    LOG(TRACE, _("start_ssl(socket=") "%p" _(")"), (void *) socket);
+    avs_error_t err;
+    if (avs_is_err((err = prepare_ssl(socket, host)))
+            || avs_is_err((err = handshake_step(socket)))) {
         return err;
     }
 
 #    if OPENSSL_VERSION_NUMBER_LT(1, 0, 2)
+    if (socket->server_name_indication[0]) {
+        host = socket->server_name_indication;
+    }
+    // DANE is not supported in these versions
+    bool verification = (socket->context->verify_mode != SSL_VERIFY_DISABLED);
     if (verification && verify_peer_subject_cn(socket, host) != 0) {
         LOG(ERROR, _("server certificate verification failure"));
         return avs_errno(AVS_EPROTO);
@@ -1216,13 +1479,13 @@ static avs_error_t rebuild_client_cert_chain(SSL_CTX *ctx, X509 *first_cert) {
 }
 
 static avs_error_t
-configure_ssl_certs(ssl_socket_t *socket,
+configure_ssl_certs(avs_net_ssl_context_t *context,
                     const avs_net_certificate_info_t *cert_info) {
     LOG(TRACE, _("configure_ssl_certs"));
 
     if (cert_info->dane) {
 #        ifdef WITH_DANE_SUPPORT
-        if (SSL_CTX_dane_enable(socket->ctx) <= 0) {
+        if (SSL_CTX_dane_enable(context->ctx) <= 0) {
             LOG(ERROR, _("could not enable DANE"));
             log_openssl_error();
             return avs_errno(AVS_EPROTO);
@@ -1236,11 +1499,11 @@ configure_ssl_certs(ssl_socket_t *socket,
     if (cert_info->server_cert_validation
             || cert_info->rebuild_client_cert_chain) {
         if (!cert_info->ignore_system_trust_store
-                && !SSL_CTX_set_default_verify_paths(socket->ctx)) {
+                && !SSL_CTX_set_default_verify_paths(context->ctx)) {
             LOG(WARNING, _("could not set default CA verify paths"));
             log_openssl_error();
         }
-        X509_STORE *store = SSL_CTX_get_cert_store(socket->ctx);
+        X509_STORE *store = SSL_CTX_get_cert_store(context->ctx);
         avs_error_t err;
         if (avs_is_err((err = _avs_crypto_openssl_load_ca_certs(
                                 store, &cert_info->trusted_certs)))) {
@@ -1256,21 +1519,21 @@ configure_ssl_certs(ssl_socket_t *socket,
 
     if (cert_info->server_cert_validation) {
         if (cert_info->dane) {
-            socket->verify_mode = SSL_VERIFY_DANE_ENFORCED;
+            context->verify_mode = SSL_VERIFY_DANE_ENFORCED;
         } else {
-            socket->verify_mode = SSL_VERIFY_TRUSTSTORE;
+            context->verify_mode = SSL_VERIFY_TRUSTSTORE;
         }
     } else {
         if (cert_info->dane) {
-            socket->verify_mode = SSL_VERIFY_DANE_OPPORTUNISTIC;
+            context->verify_mode = SSL_VERIFY_DANE_OPPORTUNISTIC;
         }
         LOG(DEBUG, _("Server authentication disabled"));
-        SSL_CTX_set_verify(socket->ctx, SSL_VERIFY_NONE, NULL);
+        SSL_CTX_set_verify(context->ctx, SSL_VERIFY_NONE, NULL);
     }
 
     if (cert_info->client_cert.desc.source != AVS_CRYPTO_DATA_SOURCE_EMPTY) {
         load_cert_ctx_t load_cert_ctx = {
-            .ctx = socket->ctx
+            .ctx = context->ctx
         };
         avs_error_t err = _avs_crypto_openssl_load_client_certs(
                 &cert_info->client_cert, load_cert, &load_cert_ctx);
@@ -1281,7 +1544,7 @@ configure_ssl_certs(ssl_socket_t *socket,
             if (avs_is_ok((err = _avs_crypto_openssl_load_private_key(
                                    &key, &cert_info->client_key)))) {
                 assert(key);
-                if (SSL_CTX_use_PrivateKey(socket->ctx, key) != 1) {
+                if (SSL_CTX_use_PrivateKey(context->ctx, key) != 1) {
                     log_openssl_error();
                     err = avs_errno(AVS_EPROTO);
                 }
@@ -1293,7 +1556,7 @@ configure_ssl_certs(ssl_socket_t *socket,
                        && cert_info->rebuild_client_cert_chain
                        && avs_is_err(
                                   (err = rebuild_client_cert_chain(
-                                           socket->ctx,
+                                           context->ctx,
                                            load_cert_ctx.first_cert_loaded)))) {
                 LOG(ERROR, _("could not rebuild client certificate chain"));
             }
@@ -1307,9 +1570,9 @@ configure_ssl_certs(ssl_socket_t *socket,
 }
 #    else
 static avs_error_t
-configure_ssl_certs(ssl_socket_t *socket,
+configure_ssl_certs(avs_net_ssl_context_t *context,
                     const avs_net_certificate_info_t *cert_info) {
-    (void) socket;
+    (void) context;
     (void) cert_info;
     LOG(ERROR, _("X.509 support disabled"));
     return avs_errno(AVS_ENOTSUP);
@@ -1327,44 +1590,48 @@ static unsigned int psk_client_cb(SSL *ssl,
 
     (void) hint;
 
-    if (!socket || !socket->psk_key
-            || socket->psk_key->desc.source != AVS_CRYPTO_DATA_SOURCE_BUFFER
-            || max_psk_len < socket->psk_key->desc.info.buffer.buffer_size
-            || !socket->psk_identity
-            || socket->psk_identity->desc.source
+    if (!socket) {
+        return 0;
+    }
+    const avs_net_ssl_context_t *context = socket->context;
+    if (!context->psk_key
+            || context->psk_key->desc.source != AVS_CRYPTO_DATA_SOURCE_BUFFER
+            || max_psk_len < context->psk_key->desc.info.buffer.buffer_size
+            || !context->psk_identity
+            || context->psk_identity->desc.source
                            != AVS_CRYPTO_DATA_SOURCE_BUFFER
             || max_identity_len
-                           < socket->psk_identity->desc.info.buffer.buffer_size
+                           < context->psk_identity->desc.info.buffer.buffer_size
                                          + 1) {
         return 0;
     }
 
-    memcpy(psk, socket->psk_key->desc.info.buffer.buffer,
-           socket->psk_key->desc.info.buffer.buffer_size);
-    memcpy(identity, socket->psk_identity->desc.info.buffer.buffer,
-           socket->psk_identity->desc.info.buffer.buffer_size);
-    identity[socket->psk_identity->desc.info.buffer.buffer_size] = '\0';
+    memcpy(psk, context->psk_key->desc.info.buffer.buffer,
+           context->psk_key->desc.info.buffer.buffer_size);
+    memcpy(identity, context->psk_identity->desc.info.buffer.buffer,
+           context->psk_identity->desc.info.buffer.buffer_size);
+    identity[context->psk_identity->desc.info.buffer.buffer_size] = '\0';
 
-    return (unsigned int) socket->psk_key->desc.info.buffer.buffer_size;
+    return (unsigned int) context->psk_key->desc.info.buffer.buffer_size;
 }
 
-static avs_error_t configure_ssl_psk(ssl_socket_t *socket,
+static avs_error_t configure_ssl_psk(avs_net_ssl_context_t *context,
                                      const avs_net_psk_info_t *psk) {
     LOG(TRACE, _("configure_ssl_psk"));
 
     avs_error_t err;
     if (avs_is_ok((
-                err = avs_crypto_psk_key_info_copy(&socket->psk_key, psk->key)))
+                err = avs_crypto_psk_key_info_copy(&context->psk_key, psk->key)))
             && avs_is_ok((err = avs_crypto_psk_identity_info_copy(
-                                  &socket->psk_identity, psk->identity)))) {
-        SSL_CTX_set_psk_client_callback(socket->ctx, psk_client_cb);
+                                  &context->psk_identity, psk->identity)))) {
+        SSL_CTX_set_psk_client_callback(context->ctx, psk_client_cb);
     }
     return err;
 }
 #    else
-static avs_error_t configure_ssl_psk(ssl_socket_t *socket,
+static avs_error_t configure_ssl_psk(avs_net_ssl_context_t *context,
                                      const avs_net_psk_info_t *psk) {
-    (void) socket;
+    (void) context;
     (void) psk;
     LOG(ERROR, _("PSK not supported in this version of OpenSSL"));
     return avs_errno(AVS_ENOTSUP);
@@ -1398,6 +1665,42 @@ static int socket_set_dtls_handshake_timeouts(
     return 0;
 }
 
+static avs_error_t
+configure_ssl_context(avs_net_ssl_context_t *context,
+                      const avs_net_ssl_configuration_t *configuration) {
+    ERR_clear_error();
+    SSL_CTX_set_options(context->ctx, SSL_OP_ALL | SSL_OP_NO_SSLv2);
+    SSL_CTX_set_verify(context->ctx, SSL_VERIFY_PEER, NULL);
+#    ifdef AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
+    enable_session_cache(context->ctx);
+#    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
+
+    avs_error_t err;
+    switch (configuration->security.mode) {
+    case AVS_NET_SECURITY_PSK:
+        err = configure_ssl_psk(context, &configuration->security.data.psk);
+        break;
+    case AVS_NET_SECURITY_CERTIFICATE:
+        err = configure_ssl_certs(context, &configuration->security.data.cert);
+        break;
+    default:
+        AVS_UNREACHABLE("invalid enum value");
+        err = avs_errno(AVS_EBADF);
+    }
+    if (avs_is_err(err)) {
+        return err;
+    }
+
+    if (configuration->additional_configuration_clb
+            && configuration->additional_configuration_clb(context->ctx)) {
+        LOG(ERROR, _("Error while setting additional SSL configuration"));
+        return avs_errno(AVS_EPIPE);
+    }
+    // Set up last, so that every SSL object created from the context uses the
+    // configured ciphersuites, regardless of additional_configuration_clb
+    return configure_ssl_ciphersuites(context, &configuration->ciphersuites);
+}
+
 static avs_error_t
 configure_ssl(ssl_socket_t *socket,
               const avs_net_ssl_configuration_t *configuration) {
@@ -1416,26 +1719,6 @@ configure_ssl(ssl_socket_t *socket,
                 &socket->endpoint_buffer;
     }
 
-    ERR_clear_error();
-    SSL_CTX_set_options(socket->ctx, SSL_OP_ALL | SSL_OP_NO_SSLv2);
-    SSL_CTX_set_verify(socket->ctx, SSL_VERIFY_PEER, NULL);
-
-    avs_error_t err;
-    switch (configuration->security.mode) {
-    case AVS_NET_SECURITY_PSK:
-        err = configure_ssl_psk(socket, &configuration->security.data.psk);
-        break;
-    case AVS_NET_SECURITY_CERTIFICATE:
-        err = configure_ssl_certs(socket, &configuration->security.data.cert);
-        break;
-    default:
-        AVS_UNREACHABLE("invalid enum value");
-        err = avs_errno(AVS_EBADF);
-    }
-    if (avs_is_err(err)) {
-        return err;
-    }
-
     if (socket_set_dtls_handshake_timeouts(
                 socket, configuration->dtls_handshake_timeouts)) {
         LOG(ERROR, _("Invalid DTLS handshake timeouts passed"));
@@ -1463,27 +1746,6 @@ configure_ssl(ssl_socket_t *socket,
         memcpy(socket->server_name_indication,
                configuration->server_name_indication, len + 1);
     }
-
-    if (configuration->ciphersuites.num_ids > 0) {
-        if (!(socket->enabled_ciphersuites.ids = (uint32_t *) avs_malloc(
-                      configuration->ciphersuites.num_ids
-                      * sizeof(*configuration->ciphersuites.ids)))) {
-            LOG(ERROR, _("Out of memory"));
-            return avs_errno(AVS_ENOMEM);
-        }
-        socket->enabled_ciphersuites.num_ids =
-                configuration->ciphersuites.num_ids;
-        memcpy(socket->enabled_ciphersuites.ids,
-               configuration->ciphersuites.ids,
-               configuration->ciphersuites.num_ids
-                       * sizeof(*configuration->ciphersuites.ids));
-    }
-
-    if (configuration->additional_configuration_clb
-            && configuration->additional_configuration_clb(socket->ctx)) {
-        LOG(ERROR, _("Error while setting additional SSL configuration"));
-        return avs_errno(AVS_EPIPE);
-    }
     return AVS_OK;
 }
 
@@ -1565,24 +1827,16 @@ static avs_error_t cleanup_ssl(avs_net_socket_t **socket_) {
     ssl_socket_t **socket = (ssl_socket_t **) socket_;
     LOG(TRACE, _("cleanup_ssl(*socket=") "%p" _(")"), (void *) *socket);
 
-#    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PSK
-    avs_free((*socket)->psk_key);
-    (*socket)->psk_key = NULL;
-    avs_free((*socket)->psk_identity);
-    (*socket)->psk_identity = NULL;
-#    endif
-
     avs_error_t err = close_ssl(*socket_);
     add_err(&err, avs_net_socket_cleanup(&(*socket)->backend_socket));
-    if ((*socket)->ctx) {
-        SSL_CTX_free((*socket)->ctx);
-        (*socket)->ctx = NULL;
-    }
-    avs_free((*socket)->enabled_ciphersuites.ids);
+    release_ssl_context(&(*socket)->context);
 #    ifdef WITH_DANE_SUPPORT
     avs_free((void *) (intptr_t) (const void *) (*socket)
                      ->dane_tlsa_array_field.array_ptr);
 #    endif // WITH_DANE_SUPPORT
+#    ifdef WITH_SSL_SESSION_CACHE
+    avs_free((*socket)->session_cache_slot);
+#    endif // WITH_SSL_SESSION_CACHE
     avs_free(*socket);
     *socket = NULL;
     return err;
@@ -1765,6 +2019,35 @@ make_ssl_context(SSL_CTX **out_ctx, bool dtls, avs_net_ssl_version_t version) {
 }
 #    endif
 
+static avs_error_t
+initialize_ssl_context(avs_net_ssl_context_t *context,
+                       const avs_net_ssl_configuration_t *configuration) {
+    avs_error_t err =
+            make_ssl_context(&context->ctx,
+                             context->backend_type == AVS_NET_UDP_SOCKET,
+                             configuration->version);
+    if (avs_is_ok(err)) {
+        err = configure_ssl_context(context, configuration);
+    }
+    return err;
+}
+
+static void cleanup_ssl_context(avs_net_ssl_context_t *context) {
+#    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PSK
+    avs_free(context->psk_key);
+    context->psk_key = NULL;
+    avs_free(context->psk_identity);
+    context->psk_identity = NULL;
+#    endif
+    if (context->ctx) {
+        SSL_CTX_free(context->ctx);
+        context->ctx = NULL;
+    }
+#    ifdef WITH_SSL_SERVER_SESSIONS
+    OPENSSL_cleanse(context->ticket_keys, sizeof(context->ticket_keys));
+#    endif // WITH_SSL_SERVER_SESSIONS
+}
+
 static avs_error_t
 initialize_ssl_socket(ssl_socket_t *socket,
                       avs_net_socket_type_t backend_type,
@@ -1772,16 +2055,7 @@ initialize_ssl_socket(ssl_socket_t *socket,
     *(const avs_net_socket_v_table_t **) (intptr_t) &socket->operations =
             &ssl_vtable;
     socket->backend_type = backend_type;
-
-    avs_error_t err = make_ssl_context(&socket->ctx, socket_is_datagram(socket),
-                                       configuration->version);
-    if (avs_is_ok(err)
-            && avs_is_err((err = configure_ssl(socket, configuration)))) {
-        SSL_CTX_free(socket->ctx);
-        socket->ctx = NULL;
-    }
-
-    return err;
+    return configure_ssl(socket, configuration);
 }
 
 #    ifdef AVS_UNIT_TESTING
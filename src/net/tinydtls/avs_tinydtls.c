@@ -24,6 +24,7 @@
 
 #    include <avsystem/commons/avs_errno.h>
 #    include <avsystem/commons/avs_memory.h>
+#    include <avsystem/commons/avs_mutex.h>
 
 #    define uthash_malloc(Size) avs_malloc(Size)
 #    define uthash_free(Ptr, Size) avs_free(Ptr)
@@ -42,8 +43,18 @@ typedef struct {
     size_t *out_bytes_read;
 } ssl_read_context_t;
 
+struct avs_net_ssl_context_struct {
+    avs_mutex_t *mutex;
+    unsigned refcount;
+    avs_net_socket_type_t backend_type;
+    avs_crypto_psk_key_info_t *psk_key;
+    avs_crypto_psk_identity_info_t *psk_identity;
+    avs_ssl_additional_configuration_clb_t *additional_configuration_clb;
+};
+
 typedef struct {
     const avs_net_socket_v_table_t *const operations;
+    avs_net_ssl_context_t *context;
     dtls_context_t *ctx;
 
     avs_net_socket_type_t backend_type;
@@ -53,8 +64,9 @@ typedef struct {
 
     ssl_read_context_t *read_ctx;
 
-    avs_crypto_psk_key_info_t *psk_key;
-    avs_crypto_psk_identity_info_t *psk_identity;
+#    ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+    avs_net_socket_stats_t stats;
+#    endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
 } ssl_socket_t;
 
 #    define NET_SSL_COMMON_INTERNALS
@@ -175,14 +187,9 @@ static avs_error_t cleanup_ssl(avs_net_socket_t **socket_) {
     ssl_socket_t *socket = *(ssl_socket_t **) socket_;
     LOG(TRACE, _("cleanup_ssl(*socket=") "%p" _(")"), (void *) socket);
 
-#    ifdef DTLS_PSK
-    avs_free(socket->psk_key);
-    socket->psk_key = NULL;
-    avs_free(socket->psk_identity);
-    socket->psk_identity = NULL;
-#    endif
     avs_error_t err = close_ssl(*socket_);
     add_err(&err, avs_net_socket_cleanup(&socket->backend_socket));
+    release_ssl_context(&socket->context);
     avs_free(socket);
     *socket_ = NULL;
     return err;
@@ -276,7 +283,7 @@ static avs_error_t start_ssl(ssl_socket_t *socket, const char *host) {
     }
 }
 
-static avs_error_t configure_ssl_psk(ssl_socket_t *socket,
+static avs_error_t configure_ssl_psk(avs_net_ssl_context_t *context,
                                      const avs_net_psk_info_t *psk) {
     LOG(TRACE, _("configure_ssl_psk"));
 
@@ -285,18 +292,18 @@ static avs_error_t configure_ssl_psk(ssl_socket_t *socket,
     return avs_errno(AVS_ENOTSUP);
 #    else
     avs_error_t err;
-    (void) (avs_is_err((err = avs_crypto_psk_key_info_copy(&socket->psk_key,
+    (void) (avs_is_err((err = avs_crypto_psk_key_info_copy(&context->psk_key,
                                                            psk->key)))
             || avs_is_err((err = avs_crypto_psk_identity_info_copy(
-                                   &socket->psk_identity, psk->identity))));
+                                   &context->psk_identity, psk->identity))));
     return err;
 #    endif /* DTLS_PSK */
 }
 
 static avs_error_t
-configure_ssl_certs(ssl_socket_t *socket,
+configure_ssl_certs(avs_net_ssl_context_t *context,
                     const avs_net_certificate_info_t *cert_info) {
-    (void) socket;
+    (void) context;
     (void) cert_info;
     LOG(ERROR, _("support for certificate mode is not yet implemented"));
     return avs_errno(AVS_ENOTSUP);
@@ -307,24 +314,8 @@ configure_ssl(ssl_socket_t *socket,
               const avs_net_ssl_configuration_t *configuration) {
     socket->backend_configuration = configuration->backend_configuration;
 
-    avs_error_t err;
-    switch (configuration->security.mode) {
-    case AVS_NET_SECURITY_PSK:
-        err = configure_ssl_psk(socket, &configuration->security.data.psk);
-        break;
-    case AVS_NET_SECURITY_CERTIFICATE:
-        err = configure_ssl_certs(socket, &configuration->security.data.cert);
-        break;
-    default:
-        AVS_UNREACHABLE("invalid enum value");
-        err = avs_errno(AVS_EINVAL);
-    }
-    if (avs_is_err(err)) {
-        return err;
-    }
-
-    if (configuration->additional_configuration_clb
-            && configuration->additional_configuration_clb(socket->ctx)) {
+    if (socket->context->additional_configuration_clb
+            && socket->context->additional_configuration_clb(socket->ctx)) {
         LOG(ERROR, _("Error while setting additional SSL configuration"));
         return avs_errno(AVS_EPIPE);
     }
@@ -373,8 +364,9 @@ static int dtls_get_psk_info_handler(dtls_context_t *ctx,
     (void) session;
 
     ssl_socket_t *socket = (ssl_socket_t *) dtls_get_app_data(ctx);
-    assert(socket->psk_key);
-    assert(socket->psk_identity);
+    const avs_net_ssl_context_t *context = socket->context;
+    assert(context->psk_key);
+    assert(context->psk_identity);
 
     switch (type) {
     case DTLS_PSK_HINT:
@@ -385,39 +377,40 @@ static int dtls_get_psk_info_handler(dtls_context_t *ctx,
          */
         (void) id;
 
-        if (socket->psk_identity->desc.source
+        if (context->psk_identity->desc.source
                 != AVS_CRYPTO_DATA_SOURCE_BUFFER) {
             LOG(WARNING, _("unsupported source of PSK identity"));
             return dtls_alert_fatal_create(DTLS_ALERT_INTERNAL_ERROR);
         }
-        if (size < socket->psk_identity->desc.info.buffer.buffer_size) {
+        if (size < context->psk_identity->desc.info.buffer.buffer_size) {
             LOG(WARNING, _("tinyDTLS buffer for PSK identity is too small"));
             return dtls_alert_fatal_create(DTLS_ALERT_INTERNAL_ERROR);
         }
-        assert(socket->psk_identity->desc.info.buffer.buffer_size <= INT_MAX);
-        memcpy(out_buffer, socket->psk_identity->desc.info.buffer.buffer,
-               socket->psk_identity->desc.info.buffer.buffer_size);
-        return (int) socket->psk_identity->desc.info.buffer.buffer_size;
+        assert(context->psk_identity->desc.info.buffer.buffer_size <= INT_MAX);
+        memcpy(out_buffer, context->psk_identity->desc.info.buffer.buffer,
+               context->psk_identity->desc.info.buffer.buffer_size);
+        return (int) context->psk_identity->desc.info.buffer.buffer_size;
     case DTLS_PSK_KEY:
-        if (socket->psk_identity->desc.source != AVS_CRYPTO_DATA_SOURCE_BUFFER
-                || socket->psk_identity->desc.info.buffer.buffer_size != id_size
-                || memcmp(socket->psk_identity->desc.info.buffer.buffer, id,
+        if (context->psk_identity->desc.source != AVS_CRYPTO_DATA_SOURCE_BUFFER
+                || context->psk_identity->desc.info.buffer.buffer_size
+                           != id_size
+                || memcmp(context->psk_identity->desc.info.buffer.buffer, id,
                           id_size)) {
             return dtls_alert_fatal_create(DTLS_ALERT_DECRYPT_ERROR);
         }
 
-        if (socket->psk_key->desc.source != AVS_CRYPTO_DATA_SOURCE_BUFFER) {
+        if (context->psk_key->desc.source != AVS_CRYPTO_DATA_SOURCE_BUFFER) {
             LOG(WARNING, _("unsupported source of PSK key"));
             return dtls_alert_fatal_create(DTLS_ALERT_INTERNAL_ERROR);
         }
-        if (size < socket->psk_key->desc.info.buffer.buffer_size) {
+        if (size < context->psk_key->desc.info.buffer.buffer_size) {
             LOG(WARNING, _("tinyDTLS buffer for PSK key is too small"));
             return dtls_alert_fatal_create(DTLS_ALERT_INTERNAL_ERROR);
         }
-        assert(socket->psk_key->desc.info.buffer.buffer_size <= INT_MAX);
-        memcpy(out_buffer, socket->psk_key->desc.info.buffer.buffer,
-               socket->psk_key->desc.info.buffer.buffer_size);
-        return (int) socket->psk_key->desc.info.buffer.buffer_size;
+        assert(context->psk_key->desc.info.buffer.buffer_size <= INT_MAX);
+        memcpy(out_buffer, context->psk_key->desc.info.buffer.buffer,
+               context->psk_key->desc.info.buffer.buffer_size);
+        return (int) context->psk_key->desc.info.buffer.buffer_size;
     default:
         LOG(ERROR, _("unsupported request type ") "%d", (int) type);
         break;
@@ -467,6 +460,33 @@ static int dtls_event_handler(dtls_context_t *ctx,
     return 0;
 }
 
+static avs_error_t
+initialize_ssl_context(avs_net_ssl_context_t *context,
+                       const avs_net_ssl_configuration_t *configuration) {
+    if (context->backend_type != AVS_NET_UDP_SOCKET) {
+        LOG(ERROR, _("tinyDTLS backend supports UDP sockets only"));
+        return avs_errno(AVS_ENOTSUP);
+    }
+    context->additional_configuration_clb =
+            configuration->additional_configuration_clb;
+
+    switch (configuration->security.mode) {
+    case AVS_NET_SECURITY_PSK:
+        return configure_ssl_psk(context, &configuration->security.data.psk);
+    case AVS_NET_SECURITY_CERTIFICATE:
+        return configure_ssl_certs(context,
+                                   &configuration->security.data.cert);
+    default:
+        AVS_UNREACHABLE("invalid enum value");
+        return avs_errno(AVS_EINVAL);
+    }
+}
+
+static void cleanup_ssl_context(avs_net_ssl_context_t *context) {
+    avs_free(context->psk_key);
+    avs_free(context->psk_identity);
+}
+
 static avs_error_t
 initialize_ssl_socket(ssl_socket_t *socket,
                       avs_net_socket_type_t backend_type,
@@ -0,0 +1,804 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avs_commons_init.h>
+
+#if defined(AVS_COMMONS_WITH_AVS_NET) && defined(AVS_COMMONS_WITH_TINYDTLS)
+
+#    include <assert.h>
+#    include <stdint.h>
+#    include <string.h>
+
+#    include <avsystem/commons/avs_errno.h>
+#    include <avsystem/commons/avs_memory.h>
+#    include <avsystem/commons/avs_net_dtls_server.h>
+#    include <avsystem/commons/avs_socket_v_table.h>
+#    include <avsystem/commons/avs_time.h>
+#    include <avsystem/commons/avs_utils.h>
+
+#    define uthash_malloc(Size) avs_malloc(Size)
+#    define uthash_free(Ptr, Size) avs_free(Ptr)
+
+#    include <tinydtls/dtls.h>
+
+#    include "../avs_net_global.h"
+
+#    include "../avs_net_impl.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+/* tinyDTLS supports AES-128-CCM-8 ciphersuite only */
+#    define DTLS_RECORD_OVERHEAD (13 /* header */ + 8 /* nonce */ + 8 /* ICV */)
+
+/* minimum interval between unsuccessful scans for peers to reclaim */
+#    define RECLAIM_INTERVAL_MS 1000
+
+/**
+ * Virtual socket representing a single peer. All of them are allocated along
+ * with the server, and reused for subsequent peers.
+ *
+ * A peer is in one of the following states:
+ * - free - on the free list, neither linked nor owned,
+ * - linked - reachable through the hash table, because tinyDTLS knows about
+ *   the peer or a handshake with it has just begun,
+ * - owned - reported to the application, which has not cleaned it up yet.
+ *
+ * A peer that is both linked and owned is a regular established session.
+ * Peers that are linked but not owned are additionally kept on a separate
+ * list, as tinyDTLS may forget about them without us noticing.
+ */
+typedef struct dtls_server_peer_struct {
+    const avs_net_socket_v_table_t *const operations;
+    avs_net_dtls_server_t *server;
+    /** Next peer in the same hash bucket, or on the free list. */
+    struct dtls_server_peer_struct *next;
+    /** Next peer on the list of linked, but not owned ones. */
+    struct dtls_server_peer_struct *unowned_next;
+    /** Pointer to this peer on that list, or NULL if not on it. */
+    struct dtls_server_peer_struct **unowned_prev_ptr;
+    bool linked;
+    bool owned;
+    /** Whether the tinyDTLS session was established when last checked. */
+    bool connected;
+    char host[AVS_ADDRSTRLEN];
+    char port[NET_PORT_SIZE];
+} dtls_server_peer_t;
+
+struct avs_net_dtls_server_struct {
+    dtls_context_t *ctx;
+    avs_net_socket_t *backend_socket;
+    avs_error_t bio_error;
+
+    avs_crypto_psk_key_info_t *psk_key;
+    avs_crypto_psk_identity_info_t *psk_identity;
+    avs_net_dtls_server_psk_lookup_t *psk_lookup;
+    void *psk_lookup_arg;
+
+    size_t max_peers;
+    dtls_server_peer_t *peers;
+    /** Hash table of linked peers, with @c max_peers buckets. */
+    dtls_server_peer_t **buckets;
+    dtls_server_peer_t *free_peers;
+    dtls_server_peer_t *unowned_peers;
+    /** Time before which reclaim_peers() does not scan the peers again. */
+    avs_time_monotonic_t next_reclaim;
+
+    /**
+     * Peer for which the decrypted application data, moved to the beginning
+     * of @c buffer , is waiting to be received.
+     */
+    dtls_server_peer_t *pending_peer;
+    size_t pending_size;
+
+    /** Shared by all peers for incoming datagrams. */
+    uint8 buffer[DTLS_MAX_BUF];
+};
+
+static uint32_t hash_address(const char *host, const char *port) {
+    /* FNV-1a; the separator makes "1.2.3.4":"56" differ from "1.2.3.45":"6" */
+    uint32_t hash = UINT32_C(2166136261);
+    for (const char *ch = host; *ch; ++ch) {
+        hash = (hash ^ (uint8_t) *ch) * UINT32_C(16777619);
+    }
+    hash = (hash ^ (uint8_t) ':') * UINT32_C(16777619);
+    for (const char *ch = port; *ch; ++ch) {
+        hash = (hash ^ (uint8_t) *ch) * UINT32_C(16777619);
+    }
+    return hash;
+}
+
+static dtls_server_peer_t **get_bucket(avs_net_dtls_server_t *server,
+                                       const char *host,
+                                       const char *port) {
+    return &server->buckets[hash_address(host, port) % server->max_peers];
+}
+
+static dtls_server_peer_t *
+find_peer(avs_net_dtls_server_t *server, const char *host, const char *port) {
+    for (dtls_server_peer_t *peer = *get_bucket(server, host, port); peer;
+         peer = peer->next) {
+        if (!strcmp(peer->host, host) && !strcmp(peer->port, port)) {
+            return peer;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Keeps @p peer on the list of unowned peers if and only if it is linked, but
+ * not owned. Shall be called whenever either of these flags changes.
+ */
+static void update_unowned_list(dtls_server_peer_t *peer) {
+    bool should_be_listed = peer->linked && !peer->owned;
+    if (should_be_listed == !!peer->unowned_prev_ptr) {
+        return;
+    }
+    if (should_be_listed) {
+        dtls_server_peer_t **head = &peer->server->unowned_peers;
+        if ((peer->unowned_next = *head)) {
+            peer->unowned_next->unowned_prev_ptr = &peer->unowned_next;
+        }
+        peer->unowned_prev_ptr = head;
+        *head = peer;
+    } else {
+        if ((*peer->unowned_prev_ptr = peer->unowned_next)) {
+            peer->unowned_next->unowned_prev_ptr = peer->unowned_prev_ptr;
+        }
+        peer->unowned_next = NULL;
+        peer->unowned_prev_ptr = NULL;
+    }
+}
+
+static void unlink_peer(dtls_server_peer_t *peer) {
+    assert(peer->linked);
+    dtls_server_peer_t **peer_ptr =
+            get_bucket(peer->server, peer->host, peer->port);
+    while (*peer_ptr != peer) {
+        assert(*peer_ptr);
+        peer_ptr = &(*peer_ptr)->next;
+    }
+    *peer_ptr = peer->next;
+    peer->next = NULL;
+    peer->linked = false;
+    update_unowned_list(peer);
+}
+
+static void release_peer(dtls_server_peer_t *peer) {
+    assert(!peer->owned);
+    if (peer->linked) {
+        unlink_peer(peer);
+    }
+    if (peer->server->pending_peer == peer) {
+        peer->server->pending_peer = NULL;
+    }
+    peer->connected = false;
+    peer->next = peer->server->free_peers;
+    peer->server->free_peers = peer;
+}
+
+/**
+ * Just like in avs_tinydtls.c, the session_t passed to tinyDTLS does not
+ * contain the actual peer address, which is hard to obtain through the avs_net
+ * API. Instead, it is a fake IPv4 address holding the index of the peer,
+ * which is unique and simplifies mapping the sessions back to the peers.
+ */
+static void get_session(const dtls_server_peer_t *peer, session_t *out) {
+    uint32_t index = (uint32_t) (peer - peer->server->peers);
+    /* tinyDTLS compares whole session_t structures, so no garbage allowed */
+    memset(out, 0, sizeof(*out));
+    out->size = sizeof(out->addr.sin);
+    out->addr.sin.sin_family = AF_INET;
+    memcpy(&out->addr.sin.sin_addr, &index, sizeof(index));
+}
+
+static dtls_server_peer_t *get_session_peer(avs_net_dtls_server_t *server,
+                                            const session_t *session) {
+    uint32_t index;
+    memcpy(&index, &session->addr.sin.sin_addr, sizeof(index));
+    if (session->addr.sin.sin_family != AF_INET || index >= server->max_peers
+            || (!server->peers[index].linked && !server->peers[index].owned)) {
+        return NULL;
+    }
+    return &server->peers[index];
+}
+
+static dtls_peer_t *get_dtls_peer(const dtls_server_peer_t *peer) {
+    session_t session;
+    get_session(peer, &session);
+    return dtls_get_peer(peer->server->ctx, &session);
+}
+
+/**
+ * Releases the peers that tinyDTLS has forgotten about without us noticing,
+ * e.g. after giving up on retransmissions. Only the unowned peers need to be
+ * checked. If none of them can be released, further scans are postponed, so
+ * that a flood of datagrams from new addresses does not trigger one each.
+ */
+static void reclaim_peers(avs_net_dtls_server_t *server) {
+    avs_time_monotonic_t now = avs_time_monotonic_now();
+    if (avs_time_monotonic_before(now, server->next_reclaim)) {
+        return;
+    }
+    dtls_server_peer_t *peer = server->unowned_peers;
+    while (peer) {
+        dtls_server_peer_t *next = peer->unowned_next;
+        if (!get_dtls_peer(peer)) {
+            release_peer(peer);
+        }
+        peer = next;
+    }
+    if (!server->free_peers) {
+        server->next_reclaim = avs_time_monotonic_add(
+                now, avs_time_duration_from_scalar(RECLAIM_INTERVAL_MS,
+                                                   AVS_TIME_MS));
+    }
+}
+
+static dtls_server_peer_t *allocate_peer(avs_net_dtls_server_t *server,
+                                         const char *host,
+                                         const char *port) {
+    if (!server->free_peers) {
+        reclaim_peers(server);
+    }
+    dtls_server_peer_t *peer = server->free_peers;
+    if (!peer) {
+        return NULL;
+    }
+    if (avs_simple_snprintf(peer->host, sizeof(peer->host), "%s", host) < 0
+            || avs_simple_snprintf(peer->port, sizeof(peer->port), "%s", port)
+                           < 0) {
+        LOG(WARNING, _("address ") "%s:%s" _(" too long"), host, port);
+        return NULL;
+    }
+    server->free_peers = peer->next;
+
+    dtls_server_peer_t **bucket = get_bucket(server, host, port);
+    peer->next = *bucket;
+    *bucket = peer;
+    peer->linked = true;
+    update_unowned_list(peer);
+    return peer;
+}
+
+/**
+ * Updates the state of @p peer after tinyDTLS has processed a datagram from
+ * it. Returns the AVS_NET_DTLS_SERVER_PEER_* flags describing the change to
+ * be reported to the application, except for AVS_NET_DTLS_SERVER_PEER_DATA.
+ */
+static int update_peer(dtls_server_peer_t *peer) {
+    dtls_peer_t *dtls_peer = get_dtls_peer(peer);
+    bool connected = dtls_peer && dtls_peer_is_connected(dtls_peer);
+    bool changed = (connected != peer->connected);
+    peer->connected = connected;
+
+    if (!dtls_peer && peer->linked) {
+        /* further datagrams from that address will start a new session */
+        unlink_peer(peer);
+    }
+    if (!peer->owned) {
+        if (connected) {
+            peer->owned = true;
+            update_unowned_list(peer);
+            return AVS_NET_DTLS_SERVER_PEER_NEW;
+        }
+        if (!dtls_peer) {
+            /* cookie exchange, failed handshake, or closed after cleanup */
+            release_peer(peer);
+        }
+        return 0;
+    }
+    return changed && !connected ? AVS_NET_DTLS_SERVER_PEER_CLOSED : 0;
+}
+
+static avs_error_t peer_send(avs_net_socket_t *peer_socket,
+                             const void *buffer,
+                             size_t buffer_length) {
+    dtls_server_peer_t *peer = (dtls_server_peer_t *) peer_socket;
+    avs_net_dtls_server_t *server = peer->server;
+    if (!peer->connected) {
+        return avs_errno(AVS_ECONNRESET);
+    }
+
+    session_t session;
+    get_session(peer, &session);
+    while (buffer_length > 0) {
+        server->bio_error = AVS_OK;
+        /* see send_ssl() in avs_tinydtls.c for the reason of this const-cast */
+        int result = dtls_write(server->ctx, &session,
+                                (uint8 *) (intptr_t) buffer, buffer_length);
+        if (result < 0) {
+            LOG(ERROR, _("peer_send() failed"));
+            if (avs_is_err(server->bio_error)) {
+                return server->bio_error;
+            } else {
+                return avs_errno(AVS_EPROTO);
+            }
+        } else if (result == 0) {
+            /* tinyDTLS does not consider the session established anymore */
+            return avs_errno(AVS_ECONNRESET);
+        }
+        assert((size_t) result <= buffer_length);
+        buffer = (const uint8_t *) buffer + result;
+        buffer_length -= (size_t) result;
+    }
+    return AVS_OK;
+}
+
+static avs_error_t peer_receive(avs_net_socket_t *peer_socket,
+                                size_t *out_bytes_received,
+                                void *buffer,
+                                size_t buffer_length) {
+    dtls_server_peer_t *peer = (dtls_server_peer_t *) peer_socket;
+    avs_net_dtls_server_t *server = peer->server;
+    *out_bytes_received = 0;
+    if (server->pending_peer != peer) {
+        return peer->connected ? avs_errno(AVS_ETIMEDOUT)
+                               : avs_errno(AVS_ECONNRESET);
+    }
+
+    server->pending_peer = NULL;
+    if (server->pending_size > buffer_length) {
+        memcpy(buffer, server->buffer, buffer_length);
+        *out_bytes_received = buffer_length;
+        return avs_errno(AVS_EMSGSIZE);
+    }
+    memcpy(buffer, server->buffer, server->pending_size);
+    *out_bytes_received = server->pending_size;
+    return AVS_OK;
+}
+
+static avs_error_t peer_close(avs_net_socket_t *peer_socket) {
+    dtls_server_peer_t *peer = (dtls_server_peer_t *) peer_socket;
+    avs_net_dtls_server_t *server = peer->server;
+    avs_error_t err = AVS_OK;
+    if (server->pending_peer == peer) {
+        server->pending_peer = NULL;
+    }
+    if (peer->connected) {
+        session_t session;
+        get_session(peer, &session);
+        server->bio_error = AVS_OK;
+        if (dtls_close(server->ctx, &session) < 0) {
+            LOG(WARNING, _("could not send close_notify to ") "%s:%s",
+                peer->host, peer->port);
+            err = avs_is_err(server->bio_error) ? server->bio_error
+                                                : avs_errno(AVS_EPROTO);
+        }
+        peer->connected = false;
+    }
+    return err;
+}
+
+static avs_error_t peer_cleanup(avs_net_socket_t **peer_socket) {
+    dtls_server_peer_t *peer = (dtls_server_peer_t *) *peer_socket;
+    avs_error_t err = peer_close(*peer_socket);
+    peer->owned = false;
+    if (!get_dtls_peer(peer)) {
+        release_peer(peer);
+    } else {
+        /* the peer stays linked until tinyDTLS forgets about it */
+        update_unowned_list(peer);
+    }
+    *peer_socket = NULL;
+    return err;
+}
+
+static const void *peer_get_system(avs_net_socket_t *peer_socket) {
+    return avs_net_socket_get_system(
+            ((dtls_server_peer_t *) peer_socket)->server->backend_socket);
+}
+
+static avs_error_t peer_get_remote_host(avs_net_socket_t *peer_socket,
+                                        char *out_buffer,
+                                        size_t out_buffer_size) {
+    if (avs_simple_snprintf(out_buffer, out_buffer_size, "%s",
+                            ((dtls_server_peer_t *) peer_socket)->host)
+            < 0) {
+        return avs_errno(AVS_ERANGE);
+    }
+    return AVS_OK;
+}
+
+static avs_error_t peer_get_remote_port(avs_net_socket_t *peer_socket,
+                                        char *out_buffer,
+                                        size_t out_buffer_size) {
+    if (avs_simple_snprintf(out_buffer, out_buffer_size, "%s",
+                            ((dtls_server_peer_t *) peer_socket)->port)
+            < 0) {
+        return avs_errno(AVS_ERANGE);
+    }
+    return AVS_OK;
+}
+
+static avs_error_t peer_get_local_host(avs_net_socket_t *peer_socket,
+                                       char *out_buffer,
+                                       size_t out_buffer_size) {
+    return avs_net_socket_get_local_host(
+            ((dtls_server_peer_t *) peer_socket)->server->backend_socket,
+            out_buffer, out_buffer_size);
+}
+
+static avs_error_t peer_get_local_port(avs_net_socket_t *peer_socket,
+                                       char *out_buffer,
+                                       size_t out_buffer_size) {
+    return avs_net_socket_get_local_port(
+            ((dtls_server_peer_t *) peer_socket)->server->backend_socket,
+            out_buffer, out_buffer_size);
+}
+
+static avs_error_t peer_get_opt(avs_net_socket_t *peer_socket,
+                                avs_net_socket_opt_key_t option_key,
+                                avs_net_socket_opt_value_t *out_option_value) {
+    dtls_server_peer_t *peer = (dtls_server_peer_t *) peer_socket;
+    switch (option_key) {
+    case AVS_NET_SOCKET_OPT_STATE:
+        out_option_value->state = peer->connected
+                                          ? AVS_NET_SOCKET_STATE_ACCEPTED
+                                          : AVS_NET_SOCKET_STATE_CLOSED;
+        return AVS_OK;
+    case AVS_NET_SOCKET_OPT_MTU:
+        return avs_net_socket_get_opt(peer->server->backend_socket,
+                                      AVS_NET_SOCKET_OPT_MTU, out_option_value);
+    case AVS_NET_SOCKET_OPT_INNER_MTU: {
+        avs_error_t err =
+                avs_net_socket_get_opt(peer->server->backend_socket,
+                                       AVS_NET_SOCKET_OPT_INNER_MTU,
+                                       out_option_value);
+        if (avs_is_ok(err)) {
+            out_option_value->mtu -= DTLS_RECORD_OVERHEAD;
+        }
+        return err;
+    }
+    case AVS_NET_SOCKET_OPT_DATAGRAM:
+        out_option_value->flag = true;
+        return AVS_OK;
+    default:
+        return avs_errno(AVS_ENOTSUP);
+    }
+}
+
+static const avs_net_socket_v_table_t peer_vtable = {
+    .send = peer_send,
+    .receive = peer_receive,
+    .close = peer_close,
+    .cleanup = peer_cleanup,
+    .get_system_socket = peer_get_system,
+    .get_remote_host = peer_get_remote_host,
+    .get_remote_hostname = peer_get_remote_host,
+    .get_remote_port = peer_get_remote_port,
+    .get_local_host = peer_get_local_host,
+    .get_local_port = peer_get_local_port,
+    .get_opt = peer_get_opt
+};
+
+static int dtls_server_write_handler(dtls_context_t *ctx,
+                                     session_t *session,
+                                     uint8 *buffer,
+                                     size_t length) {
+    avs_net_dtls_server_t *server =
+            (avs_net_dtls_server_t *) dtls_get_app_data(ctx);
+    dtls_server_peer_t *peer = get_session_peer(server, session);
+    if (!peer) {
+        LOG(WARNING, _("tinyDTLS attempted to write to an unknown peer"));
+        return -1;
+    }
+    if (avs_is_err((server->bio_error = avs_net_socket_send_to(
+                            server->backend_socket, (const void *) buffer,
+                            length, peer->host, peer->port)))) {
+        return -1;
+    }
+    assert(length <= INT_MAX);
+    return (int) length;
+}
+
+static int dtls_server_read_handler(dtls_context_t *ctx,
+                                    session_t *session,
+                                    uint8 *buf,
+                                    size_t len) {
+    avs_net_dtls_server_t *server =
+            (avs_net_dtls_server_t *) dtls_get_app_data(ctx);
+    dtls_server_peer_t *peer = get_session_peer(server, session);
+    if (!peer) {
+        return 0;
+    }
+    if (server->pending_peer) {
+        LOG(DEBUG,
+            _("dropping another application data record from ") "%s:%s",
+            peer->host, peer->port);
+        return 0;
+    }
+    /* the record is decrypted in place, so it always fits in the buffer; the
+     * records following it in the same datagram are not overwritten */
+    assert(buf >= server->buffer
+           && buf + len <= server->buffer + sizeof(server->buffer));
+    memmove(server->buffer, buf, len);
+    server->pending_peer = peer;
+    server->pending_size = len;
+    return 0;
+}
+
+static int dtls_server_event_handler(dtls_context_t *ctx,
+                                     session_t *session,
+                                     dtls_alert_level_t level,
+                                     unsigned short code) {
+    (void) ctx;
+    (void) session;
+    LOG(DEBUG,
+        _("tinyDTLS reported an event (level=") "%d" _(", code=") "%d" _(")"),
+        (int) level, (int) code);
+    (void) level;
+    (void) code;
+    return 0;
+}
+
+#    ifdef DTLS_PSK
+static int get_configured_psk(const avs_net_dtls_server_t *server,
+                              const unsigned char *id,
+                              size_t id_size,
+                              unsigned char *out_buffer,
+                              size_t size) {
+    if (server->psk_identity->desc.info.buffer.buffer_size != id_size
+            || memcmp(server->psk_identity->desc.info.buffer.buffer, id,
+                      id_size)) {
+        return dtls_alert_fatal_create(DTLS_ALERT_DECRYPT_ERROR);
+    }
+    if (size < server->psk_key->desc.info.buffer.buffer_size) {
+        LOG(WARNING, _("tinyDTLS buffer for PSK key is too small"));
+        return dtls_alert_fatal_create(DTLS_ALERT_INTERNAL_ERROR);
+    }
+    assert(server->psk_key->desc.info.buffer.buffer_size <= INT_MAX);
+    memcpy(out_buffer, server->psk_key->desc.info.buffer.buffer,
+           server->psk_key->desc.info.buffer.buffer_size);
+    return (int) server->psk_key->desc.info.buffer.buffer_size;
+}
+
+static int dtls_server_get_psk_info_handler(dtls_context_t *ctx,
+                                            const session_t *session,
+                                            dtls_credentials_type_t type,
+                                            const unsigned char *id,
+                                            size_t id_size,
+                                            unsigned char *out_buffer,
+                                            size_t size) {
+    (void) session;
+    avs_net_dtls_server_t *server =
+            (avs_net_dtls_server_t *) dtls_get_app_data(ctx);
+
+    switch (type) {
+    case DTLS_PSK_HINT:
+        /* no PSK identity hint */
+        return 0;
+    case DTLS_PSK_KEY:
+        if (!server->psk_lookup) {
+            return get_configured_psk(server, id, id_size, out_buffer, size);
+        } else {
+            size_t key_size = 0;
+            if (avs_is_err(server->psk_lookup(server->psk_lookup_arg, id,
+                                              id_size, out_buffer, size,
+                                              &key_size))) {
+                return dtls_alert_fatal_create(DTLS_ALERT_DECRYPT_ERROR);
+            }
+            assert(key_size <= size && key_size <= INT_MAX);
+            return (int) key_size;
+        }
+    default:
+        LOG(ERROR, _("unsupported request type ") "%d", (int) type);
+        break;
+    }
+    return dtls_alert_fatal_create(DTLS_ALERT_INTERNAL_ERROR);
+}
+#    endif /* #ifdef DTLS_PSK */
+
+static avs_error_t configure_psk(avs_net_dtls_server_t *server,
+                                 const avs_net_dtls_server_config_t *config) {
+#    ifndef DTLS_PSK
+    (void) server;
+    (void) config;
+    LOG(ERROR, _("support for psk is disabled"));
+    return avs_errno(AVS_ENOTSUP);
+#    else
+    server->psk_lookup = config->psk_lookup;
+    server->psk_lookup_arg = config->psk_lookup_arg;
+    if (server->psk_lookup) {
+        return AVS_OK;
+    }
+    if (config->psk.key.desc.source != AVS_CRYPTO_DATA_SOURCE_BUFFER
+            || config->psk.identity.desc.source
+                           != AVS_CRYPTO_DATA_SOURCE_BUFFER) {
+        LOG(ERROR, _("unsupported source of PSK key or identity"));
+        return avs_errno(AVS_EINVAL);
+    }
+    avs_error_t err;
+    (void) (avs_is_err((err = avs_crypto_psk_key_info_copy(&server->psk_key,
+                                                           config->psk.key)))
+            || avs_is_err((err = avs_crypto_psk_identity_info_copy(
+                                   &server->psk_identity,
+                                   config->psk.identity))));
+    return err;
+#    endif /* DTLS_PSK */
+}
+
+avs_error_t
+avs_net_dtls_server_create(avs_net_dtls_server_t **out_server,
+                           const avs_net_dtls_server_config_t *config) {
+    assert(out_server && !*out_server);
+    if (!config->max_peers || config->max_peers > UINT32_MAX) {
+        LOG(ERROR, _("invalid maximum number of peers"));
+        return avs_errno(AVS_EINVAL);
+    }
+    avs_error_t err = _avs_net_ensure_global_state();
+    if (avs_is_err(err)) {
+        return err;
+    }
+
+    avs_net_dtls_server_t *server = (avs_net_dtls_server_t *) avs_calloc(
+            1, sizeof(avs_net_dtls_server_t));
+    if (!server
+            || !(server->peers = (dtls_server_peer_t *) avs_calloc(
+                         config->max_peers, sizeof(dtls_server_peer_t)))
+            || !(server->buckets = (dtls_server_peer_t **) avs_calloc(
+                         config->max_peers, sizeof(dtls_server_peer_t *)))) {
+        LOG(ERROR, _("out of memory"));
+        avs_net_dtls_server_cleanup(&server);
+        return avs_errno(AVS_ENOMEM);
+    }
+    server->max_peers = config->max_peers;
+    for (size_t i = server->max_peers; i-- > 0;) {
+        dtls_server_peer_t *peer = &server->peers[i];
+        *(const avs_net_socket_v_table_t **) (intptr_t) &peer->operations =
+                &peer_vtable;
+        peer->server = server;
+        peer->next = server->free_peers;
+        server->free_peers = peer;
+    }
+
+    if (avs_is_err((err = configure_psk(server, config)))
+            || avs_is_err((err = avs_net_udp_socket_create(
+                                   &server->backend_socket,
+                                   &config->backend_configuration)))) {
+        avs_net_dtls_server_cleanup(&server);
+        return err;
+    }
+    if (!(server->ctx = dtls_new_context(server))) {
+        LOG(ERROR, _("could not instantiate tinyDTLS context"));
+        avs_net_dtls_server_cleanup(&server);
+        return avs_errno(AVS_ENOMEM);
+    }
+
+    static dtls_handler_t handlers = {
+        .write = dtls_server_write_handler,
+        .read = dtls_server_read_handler,
+        .event = dtls_server_event_handler,
+#    ifdef DTLS_PSK
+        .get_psk_info = dtls_server_get_psk_info_handler
+#    endif
+    };
+    dtls_set_handler(server->ctx, &handlers);
+
+    *out_server = server;
+    return AVS_OK;
+}
+
+void avs_net_dtls_server_cleanup(avs_net_dtls_server_t **server) {
+    if (!*server) {
+        return;
+    }
+#    ifndef NDEBUG
+    if ((*server)->peers) {
+        for (size_t i = 0; i < (*server)->max_peers; ++i) {
+            assert(!(*server)->peers[i].owned);
+        }
+    }
+#    endif // NDEBUG
+    if ((*server)->ctx) {
+        dtls_free_context((*server)->ctx);
+    }
+    avs_net_socket_cleanup(&(*server)->backend_socket);
+    avs_free((*server)->psk_key);
+    avs_free((*server)->psk_identity);
+    avs_free((*server)->buckets);
+    avs_free((*server)->peers);
+    avs_free(*server);
+    *server = NULL;
+}
+
+avs_error_t avs_net_dtls_server_bind(avs_net_dtls_server_t *server,
+                                     const char *address,
+                                     const char *port) {
+    return avs_net_socket_bind(server->backend_socket, address, port);
+}
+
+avs_net_socket_t *avs_net_dtls_server_socket(avs_net_dtls_server_t *server) {
+    return server->backend_socket;
+}
+
+avs_time_monotonic_t
+avs_net_dtls_server_next_timeout(avs_net_dtls_server_t *server) {
+    clock_time_t next = 0;
+    server->bio_error = AVS_OK;
+    dtls_check_retransmit(server->ctx, &next);
+    if (avs_is_err(server->bio_error)) {
+        LOG(WARNING, _("could not retransmit handshake messages"));
+    }
+    if (!next) {
+        return AVS_TIME_MONOTONIC_INVALID;
+    }
+    dtls_tick_t now;
+    dtls_ticks(&now);
+    avs_time_monotonic_t result = avs_time_monotonic_now();
+    if (next > now) {
+        result = avs_time_monotonic_add(
+                result,
+                avs_time_duration_from_scalar(
+                        (int64_t) (next - now) * 1000 / CLOCK_SECOND,
+                        AVS_TIME_MS));
+    }
+    return result;
+}
+
+avs_error_t avs_net_dtls_server_process(avs_net_dtls_server_t *server,
+                                        avs_net_socket_t **out_peer,
+                                        int *out_events) {
+    *out_peer = NULL;
+    *out_events = 0;
+    server->pending_peer = NULL;
+    dtls_check_retransmit(server->ctx, NULL);
+
+    char host[AVS_ADDRSTRLEN];
+    char port[NET_PORT_SIZE];
+    size_t datagram_size;
+    avs_error_t err = avs_net_socket_receive_from(
+            server->backend_socket, &datagram_size, server->buffer,
+            sizeof(server->buffer), host, sizeof(host), port, sizeof(port));
+    if (err.category == AVS_ERRNO_CATEGORY && err.code == AVS_EMSGSIZE) {
+        LOG(DEBUG, _("dropping oversized datagram"));
+        return AVS_OK;
+    } else if (avs_is_err(err)) {
+        return err;
+    }
+
+    dtls_server_peer_t *peer = find_peer(server, host, port);
+    if (!peer && !(peer = allocate_peer(server, host, port))) {
+        LOG(WARNING,
+            _("no room for new peer ") "%s:%s" _(", dropping datagram"), host,
+            port);
+        return AVS_OK;
+    }
+
+    session_t session;
+    get_session(peer, &session);
+    assert(datagram_size <= INT_MAX);
+    server->bio_error = AVS_OK;
+    if (dtls_handle_message(server->ctx, &session, server->buffer,
+                            (int) datagram_size)) {
+        LOG(DEBUG, _("could not handle datagram from ") "%s:%s", host, port);
+    }
+    if (avs_is_err(server->bio_error)) {
+        LOG(WARNING, _("could not send response to ") "%s:%s", host, port);
+    }
+
+    *out_events = update_peer(peer);
+    if (server->pending_peer == peer) {
+        /* may come along with the end of the handshake */
+        *out_events |= AVS_NET_DTLS_SERVER_PEER_DATA;
+    }
+    if (*out_events) {
+        *out_peer = (avs_net_socket_t *) peer;
+    }
+    return AVS_OK;
+}
+
+#endif // defined(AVS_COMMONS_WITH_AVS_NET) &&
+       // defined(AVS_COMMONS_WITH_TINYDTLS)
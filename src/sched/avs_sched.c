@@ -31,6 +31,7 @@
 #        include <avsystem/commons/avs_condvar.h>
 #        include <avsystem/commons/avs_init_once.h>
 #        include <avsystem/commons/avs_mutex.h>
+#        include <avsystem/commons/avs_rwlock.h>
 #    else // AVS_COMMONS_SCHED_THREAD_SAFE
 #        define avs_condvar_create(...) 0
 #        define avs_condvar_cleanup(...) ((void) 0)
@@ -55,7 +56,19 @@ struct avs_sched_job_struct {
     /** Instant in time at which the job is scheduled. */
     avs_time_monotonic_t instant;
 
-#    ifdef AVS_COMMONS_WITH_INTERNAL_LOGS
+#    ifdef AVS_COMMONS_SCHED_WITH_HEAP
+    /**
+     * Sequence number assigned when the job was (re)scheduled. Used to
+     * preserve FIFO order of jobs scheduled at the same instant.
+     */
+    uint64_t seq;
+
+    /** Position of the job in the scheduler's heap array. */
+    size_t heap_index;
+#    endif // AVS_COMMONS_SCHED_WITH_HEAP
+
+#    if defined(AVS_COMMONS_WITH_INTERNAL_LOGS) \
+            || defined(AVS_COMMONS_SCHED_WITH_STATS)
     struct {
         /** File from which AVS_SCHED*() was called. */
         const char *file;
@@ -64,7 +77,35 @@ struct avs_sched_job_struct {
         /** Stringified value of what was passed as the callback function. */
         const char *name;
     } log_info;
-#    endif // AVS_COMMONS_WITH_INTERNAL_LOGS
+#    endif // defined(AVS_COMMONS_WITH_INTERNAL_LOGS) ||
+           // defined(AVS_COMMONS_SCHED_WITH_STATS)
+
+#    ifdef AVS_COMMONS_SCHED_WITH_STATS
+    /** Measurements of the job's execution, filled in by execute_job(). */
+    struct {
+        /** Time between the scheduled instant and start of execution. */
+        avs_time_duration_t lateness;
+        /** Time spent in the callback function. */
+        avs_time_duration_t exec_time;
+    } stats;
+#    endif // AVS_COMMONS_SCHED_WITH_STATS
+
+#    ifdef AVS_COMMONS_SCHED_WITH_JOB_POOL
+    /**
+     * Size of the @ref avs_sched_job_struct::clb_data buffer, if the job record
+     * has been allocated for one of the job pool size classes, or
+     * @ref POOL_NO_CLASS otherwise.
+     */
+    size_t pool_data_size;
+#    endif // AVS_COMMONS_SCHED_WITH_JOB_POOL
+
+#    ifdef AVS_COMMONS_SCHED_THREAD_SAFE
+    /**
+     * Affinity key of the job. Jobs with the same non-NULL affinity key are
+     * never executed concurrently.
+     */
+    const void *affinity_key;
+#    endif // AVS_COMMONS_SCHED_THREAD_SAFE
 
     /** Callback function to execute. */
     avs_sched_clb_t *clb;
@@ -74,6 +115,19 @@ struct avs_sched_job_struct {
     avs_max_align_t clb_data[];
 };
 
+#    ifdef AVS_COMMONS_SCHED_WITH_JOB_POOL
+typedef struct {
+    /** Size of callback data that job records in this class can hold. */
+    size_t data_size;
+
+    /** Job records that are not currently in use. */
+    AVS_LIST(avs_sched_job_t) free_jobs;
+
+    /** Number of elements in @ref free_jobs . */
+    size_t free_count;
+} sched_pool_class_t;
+#    endif // AVS_COMMONS_SCHED_WITH_JOB_POOL
+
 struct avs_sched_struct {
 #    ifdef AVS_COMMONS_WITH_INTERNAL_LOGS
     /** Name of the scheduler. */
@@ -91,13 +145,70 @@ struct avs_sched_struct {
 
     /**
      * Condition variable that can be used to wake up the
-     * @ref avs_sched_wait_until_next call.
+     * @ref avs_sched_wait_until_next and @ref avs_sched_worker_run calls.
      */
     avs_condvar_t *task_condvar;
+
+    /**
+     * Jobs currently being executed, either by @ref avs_sched_run or by worker
+     * threads. Used to enforce the affinity key constraints.
+     */
+    AVS_LIST(avs_sched_job_t) running;
+
+    struct {
+        /** Number of threads currently in @ref avs_sched_worker_run . */
+        size_t active;
+
+        /** Flag that makes all @ref avs_sched_worker_run calls return. */
+        bool stopping;
+    } workers;
 #    endif // AVS_COMMONS_SCHED_THREAD_SAFE
 
-    /** Scheduled jobs. */
+#    ifdef AVS_COMMONS_SCHED_WITH_HEAP
+    /**
+     * Scheduled jobs, organized as a binary min-heap ordered by instant and
+     * sequence number.
+     */
+    struct {
+        avs_sched_job_t **jobs;
+        size_t size;
+        size_t capacity;
+        uint64_t next_seq;
+    } heap;
+#    else  // AVS_COMMONS_SCHED_WITH_HEAP
+    /** Scheduled jobs, sorted by instant. */
     AVS_LIST(avs_sched_job_t) jobs;
+#    endif // AVS_COMMONS_SCHED_WITH_HEAP
+
+#    ifdef AVS_COMMONS_SCHED_WITH_JOB_POOL
+    /**
+     * Free lists of job records, used to avoid allocating and freeing memory
+     * for each job. See @ref avs_sched_pool_configure .
+     */
+    struct {
+        /** Size classes, sorted by data size. */
+        sched_pool_class_t classes[AVS_SCHED_POOL_MAX_CLASSES];
+        size_t class_count;
+
+        /** Maximum number of free job records to keep for each class. */
+        size_t max_cached;
+
+        uint64_t hits;
+        uint64_t misses;
+    } pool;
+#    endif // AVS_COMMONS_SCHED_WITH_JOB_POOL
+
+#    ifdef AVS_COMMONS_SCHED_WITH_STATS
+    /** Execution statistics, see @ref avs_sched_stats . */
+    avs_sched_stats_t stats;
+#    endif // AVS_COMMONS_SCHED_WITH_STATS
+
+    /**
+     * Timer slack, i.e. amount of time by which wake-ups may be delayed so
+     * that jobs scheduled close to each other are executed together. See
+     * @ref avs_sched_set_slack .
+     */
+    avs_time_duration_t slack;
 
     /**
      * A flag that prevents scheduling new jobs while the scheduler is shutting
@@ -108,18 +219,19 @@ struct avs_sched_struct {
 
 #    ifdef AVS_COMMONS_SCHED_THREAD_SAFE
 /**
- * The global mutex that guards accesses to all @ref avs_sched_handle_t
- * variables.
+ * The global lock that guards accesses to all @ref avs_sched_handle_t
+ * variables. Most accesses only read the handles, so they take it in shared
+ * mode; it is only taken exclusively when a handle is being set or reset.
  *
  * That could be guarded by the normal per-scheduler mutexes, but that would
  * require passing the scheduler to functions such as @ref avs_sched_del .
  */
-static avs_mutex_t *g_handle_access_mutex;
+static avs_rwlock_t *g_handle_access_lock;
 static volatile avs_init_once_handle_t g_init_handle;
 
 static int init_globals(void *dummy) {
     (void) dummy;
-    return avs_mutex_create(&g_handle_access_mutex);
+    return avs_rwlock_create(&g_handle_access_lock);
 }
 
 static void nonfailing_mutex_lock(avs_mutex_t *mutex) {
@@ -127,14 +239,38 @@ static void nonfailing_mutex_lock(avs_mutex_t *mutex) {
         AVS_UNREACHABLE("could not lock mutex");
     }
 }
+
+static void handles_read_lock(void) {
+    if (avs_rwlock_read_lock(g_handle_access_lock)) {
+        AVS_UNREACHABLE("could not lock handle access lock");
+    }
+}
+
+static void handles_read_unlock(void) {
+    avs_rwlock_read_unlock(g_handle_access_lock);
+}
+
+static void handles_write_lock(void) {
+    if (avs_rwlock_write_lock(g_handle_access_lock)) {
+        AVS_UNREACHABLE("could not lock handle access lock");
+    }
+}
+
+static void handles_write_unlock(void) {
+    avs_rwlock_write_unlock(g_handle_access_lock);
+}
 #    else // AVS_COMMONS_SCHED_THREAD_SAFE
 #        define nonfailing_mutex_lock(...) ((void) 0)
+#        define handles_read_lock() ((void) 0)
+#        define handles_read_unlock() ((void) 0)
+#        define handles_write_lock() ((void) 0)
+#        define handles_write_unlock() ((void) 0)
 #    endif // AVS_COMMONS_SCHED_THREAD_SAFE
 
 void _avs_sched_cleanup_global_state(void);
 void _avs_sched_cleanup_global_state(void) {
 #    ifdef AVS_COMMONS_SCHED_THREAD_SAFE
-    avs_mutex_cleanup(&g_handle_access_mutex);
+    avs_rwlock_cleanup(&g_handle_access_lock);
     g_init_handle = NULL;
 #    endif // AVS_COMMONS_SCHED_THREAD_SAFE
 }
@@ -189,6 +325,374 @@ static const char *job_log_id_impl(char buf[static JOB_LOG_ID_MAX_LENGTH],
 
 #    endif // AVS_COMMONS_WITH_INTERNAL_LOGS
 
+/**
+ * Checks whether @p job may be executed right now, i.e. that no other job with
+ * the same affinity key is currently being executed.
+ */
+static bool job_runnable_locked(avs_sched_t *sched,
+                                const avs_sched_job_t *job) {
+#    ifdef AVS_COMMONS_SCHED_THREAD_SAFE
+    if (job->affinity_key) {
+        AVS_LIST(avs_sched_job_t) running;
+        AVS_LIST_FOREACH(running, sched->running) {
+            if (running->affinity_key == job->affinity_key) {
+                return false;
+            }
+        }
+    }
+#    else  // AVS_COMMONS_SCHED_THREAD_SAFE
+    (void) sched;
+    (void) job;
+#    endif // AVS_COMMONS_SCHED_THREAD_SAFE
+    return true;
+}
+
+#    ifdef AVS_COMMONS_SCHED_WITH_HEAP
+
+#        define HEAP_INITIAL_CAPACITY 8
+
+static bool job_before(const avs_sched_job_t *a, const avs_sched_job_t *b) {
+    if (avs_time_monotonic_before(a->instant, b->instant)) {
+        return true;
+    } else if (avs_time_monotonic_before(b->instant, a->instant)) {
+        return false;
+    }
+    return a->seq < b->seq;
+}
+
+static void heap_set(avs_sched_t *sched, size_t index, avs_sched_job_t *job) {
+    sched->heap.jobs[index] = job;
+    job->heap_index = index;
+}
+
+static void heap_sift_up(avs_sched_t *sched, size_t index) {
+    avs_sched_job_t *job = sched->heap.jobs[index];
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (!job_before(job, sched->heap.jobs[parent])) {
+            break;
+        }
+        heap_set(sched, index, sched->heap.jobs[parent]);
+        index = parent;
+    }
+    heap_set(sched, index, job);
+}
+
+static void heap_sift_down(avs_sched_t *sched, size_t index) {
+    avs_sched_job_t *job = sched->heap.jobs[index];
+    while (true) {
+        size_t child = 2 * index + 1;
+        if (child >= sched->heap.size) {
+            break;
+        }
+        if (child + 1 < sched->heap.size
+                && job_before(sched->heap.jobs[child + 1],
+                              sched->heap.jobs[child])) {
+            ++child;
+        }
+        if (!job_before(sched->heap.jobs[child], job)) {
+            break;
+        }
+        heap_set(sched, index, sched->heap.jobs[child]);
+        index = child;
+    }
+    heap_set(sched, index, job);
+}
+
+static int heap_resize(avs_sched_t *sched, size_t capacity) {
+    avs_sched_job_t **jobs = (avs_sched_job_t **) avs_realloc(
+            sched->heap.jobs, capacity * sizeof(*sched->heap.jobs));
+    if (!jobs) {
+        return -1;
+    }
+    sched->heap.jobs = jobs;
+    sched->heap.capacity = capacity;
+    return 0;
+}
+
+static avs_sched_job_t *queue_front(avs_sched_t *sched) {
+    return sched->heap.size ? sched->heap.jobs[0] : NULL;
+}
+
+static avs_sched_job_t *heap_first_runnable(avs_sched_t *sched,
+                                            size_t index,
+                                            avs_sched_job_t *best) {
+    if (index >= sched->heap.size) {
+        return best;
+    }
+    avs_sched_job_t *job = sched->heap.jobs[index];
+    if (best && !job_before(job, best)) {
+        // all jobs in this subtree are scheduled after the best candidate
+        return best;
+    }
+    if (job_runnable_locked(sched, job)) {
+        return job;
+    }
+    best = heap_first_runnable(sched, 2 * index + 1, best);
+    return heap_first_runnable(sched, 2 * index + 2, best);
+}
+
+static avs_sched_job_t *queue_first_runnable(avs_sched_t *sched) {
+    return heap_first_runnable(sched, 0, NULL);
+}
+
+static int queue_reserve(avs_sched_t *sched, size_t count) {
+    if (count <= sched->heap.capacity - sched->heap.size) {
+        return 0;
+    }
+    if (count > SIZE_MAX / sizeof(*sched->heap.jobs) / 2 - sched->heap.size) {
+        return -1;
+    }
+    size_t capacity = sched->heap.capacity ? sched->heap.capacity
+                                           : HEAP_INITIAL_CAPACITY;
+    while (capacity < sched->heap.size + count) {
+        capacity *= 2;
+    }
+    return heap_resize(sched, capacity);
+}
+
+static void queue_insert(avs_sched_t *sched, avs_sched_job_t *job) {
+    // queue_reserve() shall have been called before
+    assert(sched->heap.size < sched->heap.capacity);
+    job->seq = sched->heap.next_seq++;
+    heap_set(sched, sched->heap.size++, job);
+    heap_sift_up(sched, job->heap_index);
+}
+
+static AVS_LIST(avs_sched_job_t) queue_detach(avs_sched_t *sched,
+                                              avs_sched_job_t *job) {
+    size_t index = job->heap_index;
+    assert(index < sched->heap.size);
+    assert(sched->heap.jobs[index] == job);
+    avs_sched_job_t *last = sched->heap.jobs[--sched->heap.size];
+    if (last != job) {
+        heap_set(sched, index, last);
+        if (index > 0 && job_before(last, sched->heap.jobs[(index - 1) / 2])) {
+            heap_sift_up(sched, index);
+        } else {
+            heap_sift_down(sched, index);
+        }
+    }
+    return job;
+}
+
+static void queue_trim(avs_sched_t *sched) {
+    if (sched->heap.capacity > HEAP_INITIAL_CAPACITY
+            && sched->heap.size <= sched->heap.capacity / 4) {
+        // shrinking may fail; the old array is still valid in that case
+        (void) heap_resize(sched, sched->heap.capacity / 2);
+    }
+}
+
+static void queue_update(avs_sched_t *sched, avs_sched_job_t *job) {
+    job->seq = sched->heap.next_seq++;
+    heap_sift_up(sched, job->heap_index);
+    heap_sift_down(sched, job->heap_index);
+}
+
+static void queue_leap(avs_sched_t *sched, avs_time_duration_t diff) {
+    // moving all jobs by the same amount does not affect the heap order
+    for (size_t i = 0; i < sched->heap.size; ++i) {
+        sched->heap.jobs[i]->instant =
+                avs_time_monotonic_add(sched->heap.jobs[i]->instant, diff);
+    }
+}
+
+static AVS_LIST(avs_sched_job_t) queue_pop_any(avs_sched_t *sched) {
+    return sched->heap.size ? sched->heap.jobs[--sched->heap.size] : NULL;
+}
+
+static void queue_cleanup(avs_sched_t *sched) {
+    assert(!sched->heap.size);
+    avs_free(sched->heap.jobs);
+    sched->heap.jobs = NULL;
+    sched->heap.capacity = 0;
+}
+
+#    else // AVS_COMMONS_SCHED_WITH_HEAP
+
+static avs_sched_job_t *queue_front(avs_sched_t *sched) {
+    return sched->jobs;
+}
+
+static avs_sched_job_t *queue_first_runnable(avs_sched_t *sched) {
+    AVS_LIST(avs_sched_job_t) job;
+    AVS_LIST_FOREACH(job, sched->jobs) {
+        if (job_runnable_locked(sched, job)) {
+            return job;
+        }
+    }
+    return NULL;
+}
+
+static int queue_reserve(avs_sched_t *sched, size_t count) {
+    (void) sched;
+    (void) count;
+    return 0;
+}
+
+static void queue_insert(avs_sched_t *sched, avs_sched_job_t *job) {
+    AVS_LIST(avs_sched_job_t) *insert_ptr = &sched->jobs;
+    while (*insert_ptr
+           && !avs_time_monotonic_before(job->instant,
+                                         (*insert_ptr)->instant)) {
+        AVS_LIST_ADVANCE_PTR(&insert_ptr);
+    }
+    AVS_LIST_INSERT(insert_ptr, job);
+}
+
+static AVS_LIST(avs_sched_job_t) queue_detach(avs_sched_t *sched,
+                                              avs_sched_job_t *job) {
+    AVS_LIST(avs_sched_job_t) *job_ptr =
+            (AVS_LIST(avs_sched_job_t) *) AVS_LIST_FIND_PTR(&sched->jobs, job);
+    AVS_ASSERT(job_ptr, "dangling handle detected");
+    return AVS_LIST_DETACH(job_ptr);
+}
+
+static void queue_trim(avs_sched_t *sched) {
+    (void) sched;
+}
+
+static void queue_update(avs_sched_t *sched, avs_sched_job_t *job) {
+    queue_insert(sched, queue_detach(sched, job));
+}
+
+static void queue_leap(avs_sched_t *sched, avs_time_duration_t diff) {
+    AVS_LIST(avs_sched_job_t) job;
+    AVS_LIST_FOREACH(job, sched->jobs) {
+        job->instant = avs_time_monotonic_add(job->instant, diff);
+    }
+}
+
+static AVS_LIST(avs_sched_job_t) queue_pop_any(avs_sched_t *sched) {
+    return sched->jobs ? AVS_LIST_DETACH(&sched->jobs) : NULL;
+}
+
+static void queue_cleanup(avs_sched_t *sched) {
+    assert(!sched->jobs);
+    (void) sched;
+}
+
+#    endif // AVS_COMMONS_SCHED_WITH_HEAP
+
+/**
+ * Checks whether the job that @p handle_ptr was observed to point to is still
+ * scheduled on @p sched. It might not be the case if it has been concurrently
+ * fetched for execution or cancelled by another thread.
+ *
+ * The check relies on the invariant that a job is always removed from the
+ * queue together with resetting its handle while holding
+ * @ref g_handle_access_lock - so as long as the handle still points to the
+ * job, it is safe to dereference it.
+ */
+static bool job_still_scheduled_locked(avs_sched_t *sched,
+                                       avs_sched_handle_t *handle_ptr,
+                                       avs_sched_job_t *job) {
+    handles_read_lock();
+    bool result = (*handle_ptr == job && job->sched == sched);
+    handles_read_unlock();
+#    ifndef AVS_COMMONS_SCHED_THREAD_SAFE
+    AVS_ASSERT(result, "dangling handle detected");
+#    endif // AVS_COMMONS_SCHED_THREAD_SAFE
+    return result;
+}
+
+#    ifdef AVS_COMMONS_SCHED_WITH_JOB_POOL
+
+#        define POOL_NO_CLASS SIZE_MAX
+#        define DEFAULT_POOL_MAX_CACHED 32
+
+static const size_t DEFAULT_POOL_CLASS_DATA_SIZES[] = { 16, 64, 256 };
+
+static sched_pool_class_t *pool_class_for_size(avs_sched_t *sched,
+                                               size_t data_size) {
+    for (size_t i = 0; i < sched->pool.class_count; ++i) {
+        if (data_size <= sched->pool.classes[i].data_size) {
+            return &sched->pool.classes[i];
+        }
+    }
+    return NULL;
+}
+
+static void pool_clear_locked(avs_sched_t *sched) {
+    for (size_t i = 0; i < sched->pool.class_count; ++i) {
+        AVS_LIST_CLEAR(&sched->pool.classes[i].free_jobs);
+        sched->pool.classes[i].free_count = 0;
+    }
+}
+
+static void pool_configure_locked(avs_sched_t *sched,
+                                  const size_t *class_data_sizes,
+                                  size_t class_count,
+                                  size_t max_cached_per_class) {
+    assert(class_count <= AVS_SCHED_POOL_MAX_CLASSES);
+    pool_clear_locked(sched);
+    for (size_t i = 0; i < class_count; ++i) {
+        sched->pool.classes[i].data_size = class_data_sizes[i];
+    }
+    sched->pool.class_count = class_count;
+    sched->pool.max_cached = max_cached_per_class;
+}
+
+#    endif // AVS_COMMONS_SCHED_WITH_JOB_POOL
+
+/**
+ * Allocates a job record able to hold @p clb_data_size bytes of callback data,
+ * reusing a cached one if possible. All the fields of the job structure are
+ * zeroed.
+ */
+static AVS_LIST(avs_sched_job_t) job_alloc_locked(avs_sched_t *sched,
+                                                  size_t clb_data_size) {
+#    ifdef AVS_COMMONS_SCHED_WITH_JOB_POOL
+    sched_pool_class_t *cls = pool_class_for_size(sched, clb_data_size);
+    AVS_LIST(avs_sched_job_t) job = NULL;
+    if (cls && cls->free_jobs) {
+        ++sched->pool.hits;
+        --cls->free_count;
+        job = AVS_LIST_DETACH(&cls->free_jobs);
+        memset(job, 0, sizeof(*job));
+    } else {
+        ++sched->pool.misses;
+        if (!(job = (avs_sched_job_t *) AVS_LIST_NEW_BUFFER(
+                      sizeof(avs_sched_job_t)
+                      + (cls ? cls->data_size : clb_data_size)))) {
+            return NULL;
+        }
+    }
+    job->pool_data_size = (cls ? cls->data_size : POOL_NO_CLASS);
+    return job;
+#    else  // AVS_COMMONS_SCHED_WITH_JOB_POOL
+    (void) sched;
+    return (avs_sched_job_t *) AVS_LIST_NEW_BUFFER(sizeof(avs_sched_job_t)
+                                                   + clb_data_size);
+#    endif // AVS_COMMONS_SCHED_WITH_JOB_POOL
+}
+
+/**
+ * Releases a job record that is no longer scheduled nor executed, either by
+ * caching it for reuse, or freeing it.
+ */
+static void job_free_locked(avs_sched_t *sched, AVS_LIST(avs_sched_job_t) job) {
+    // make sure that the job is detached
+    assert(!AVS_LIST_NEXT(job));
+#    ifdef AVS_COMMONS_SCHED_WITH_JOB_POOL
+    for (size_t i = 0; i < sched->pool.class_count; ++i) {
+        sched_pool_class_t *cls = &sched->pool.classes[i];
+        if (cls->data_size == job->pool_data_size) {
+            if (cls->free_count < sched->pool.max_cached) {
+                AVS_LIST_INSERT(&cls->free_jobs, job);
+                ++cls->free_count;
+                return;
+            }
+            break;
+        }
+    }
+#    else  // AVS_COMMONS_SCHED_WITH_JOB_POOL
+    (void) sched;
+#    endif // AVS_COMMONS_SCHED_WITH_JOB_POOL
+    AVS_LIST_DELETE(&job);
+}
+
 avs_sched_t *avs_sched_new(const char *name, void *data) {
 #    ifdef AVS_COMMONS_SCHED_THREAD_SAFE
     if (avs_init_once(&g_init_handle, init_globals, NULL)) {
@@ -215,6 +719,12 @@ avs_sched_t *avs_sched_new(const char *name, void *data) {
         return NULL;
     }
     sched->data = data;
+    sched->slack = AVS_TIME_DURATION_ZERO;
+#    ifdef AVS_COMMONS_SCHED_WITH_JOB_POOL
+    pool_configure_locked(sched, DEFAULT_POOL_CLASS_DATA_SIZES,
+                          AVS_ARRAY_SIZE(DEFAULT_POOL_CLASS_DATA_SIZES),
+                          DEFAULT_POOL_MAX_CACHED);
+#    endif // AVS_COMMONS_SCHED_WITH_JOB_POOL
     LOG(DEBUG, _("Scheduler \"") "%s" _("\" created, data == ") "%p",
         (sched->name = (name ? name : "(unknown)")), data);
     return sched;
@@ -231,13 +741,19 @@ void avs_sched_cleanup(avs_sched_t **sched_ptr) {
     // execute any tasks remaining for now
     avs_sched_run(*sched_ptr);
 
-    nonfailing_mutex_lock(g_handle_access_mutex);
-    AVS_LIST_CLEAR(&(*sched_ptr)->jobs) {
-        if ((*sched_ptr)->jobs->handle_ptr) {
-            *(*sched_ptr)->jobs->handle_ptr = NULL;
+    handles_write_lock();
+    AVS_LIST(avs_sched_job_t) job;
+    while ((job = queue_pop_any(*sched_ptr))) {
+        if (job->handle_ptr) {
+            *job->handle_ptr = NULL;
         }
+        AVS_LIST_DELETE(&job);
     }
-    avs_mutex_unlock(g_handle_access_mutex);
+    handles_write_unlock();
+    queue_cleanup(*sched_ptr);
+#    ifdef AVS_COMMONS_SCHED_WITH_JOB_POOL
+    pool_clear_locked(*sched_ptr);
+#    endif // AVS_COMMONS_SCHED_WITH_JOB_POOL
 
     avs_condvar_cleanup(&(*sched_ptr)->task_condvar);
     avs_mutex_cleanup(&(*sched_ptr)->mutex);
@@ -247,6 +763,84 @@ void avs_sched_cleanup(avs_sched_t **sched_ptr) {
     *sched_ptr = NULL;
 }
 
+int avs_sched_pool_configure(avs_sched_t *sched,
+                             const size_t *class_data_sizes,
+                             size_t class_count,
+                             size_t max_cached_per_class) {
+    assert(sched);
+#    ifdef AVS_COMMONS_SCHED_WITH_JOB_POOL
+    if (class_count > AVS_SCHED_POOL_MAX_CLASSES
+            || (class_count && !class_data_sizes)) {
+        SCHED_LOG(sched, ERROR, _("invalid job pool configuration"));
+        return -1;
+    }
+    for (size_t i = 1; i < class_count; ++i) {
+        if (class_data_sizes[i] <= class_data_sizes[i - 1]) {
+            SCHED_LOG(sched, ERROR,
+                      _("job pool size classes shall be strictly increasing"));
+            return -1;
+        }
+    }
+    nonfailing_mutex_lock(sched->mutex);
+    pool_configure_locked(sched, class_data_sizes, class_count,
+                          max_cached_per_class);
+    avs_mutex_unlock(sched->mutex);
+    return 0;
+#    else  // AVS_COMMONS_SCHED_WITH_JOB_POOL
+    (void) class_data_sizes;
+    (void) class_count;
+    (void) max_cached_per_class;
+    SCHED_LOG(sched, ERROR, _("job pool support is not compiled in"));
+    return -1;
+#    endif // AVS_COMMONS_SCHED_WITH_JOB_POOL
+}
+
+int avs_sched_pool_stats(avs_sched_t *sched,
+                         avs_sched_pool_stats_t *out_stats) {
+    assert(sched);
+    assert(out_stats);
+#    ifdef AVS_COMMONS_SCHED_WITH_JOB_POOL
+    nonfailing_mutex_lock(sched->mutex);
+    out_stats->hits = sched->pool.hits;
+    out_stats->misses = sched->pool.misses;
+    out_stats->cached = 0;
+    for (size_t i = 0; i < sched->pool.class_count; ++i) {
+        out_stats->cached += sched->pool.classes[i].free_count;
+    }
+    avs_mutex_unlock(sched->mutex);
+    return 0;
+#    else  // AVS_COMMONS_SCHED_WITH_JOB_POOL
+    (void) out_stats;
+    return -1;
+#    endif // AVS_COMMONS_SCHED_WITH_JOB_POOL
+}
+
+int avs_sched_stats(avs_sched_t *sched, avs_sched_stats_t *out_stats) {
+    assert(sched);
+    assert(out_stats);
+#    ifdef AVS_COMMONS_SCHED_WITH_STATS
+    nonfailing_mutex_lock(sched->mutex);
+    *out_stats = sched->stats;
+    avs_mutex_unlock(sched->mutex);
+    return 0;
+#    else  // AVS_COMMONS_SCHED_WITH_STATS
+    (void) out_stats;
+    return -1;
+#    endif // AVS_COMMONS_SCHED_WITH_STATS
+}
+
+int avs_sched_stats_reset(avs_sched_t *sched) {
+    assert(sched);
+#    ifdef AVS_COMMONS_SCHED_WITH_STATS
+    nonfailing_mutex_lock(sched->mutex);
+    memset(&sched->stats, 0, sizeof(sched->stats));
+    avs_mutex_unlock(sched->mutex);
+    return 0;
+#    else  // AVS_COMMONS_SCHED_WITH_STATS
+    return -1;
+#    endif // AVS_COMMONS_SCHED_WITH_STATS
+}
+
 void *avs_sched_data(avs_sched_t *sched) {
     assert(sched);
     return sched->data;
@@ -254,8 +848,9 @@ void *avs_sched_data(avs_sched_t *sched) {
 
 static avs_time_monotonic_t sched_time_of_next_locked(avs_sched_t *sched) {
     assert(sched);
-    if (sched->jobs) {
-        return sched->jobs->instant;
+    avs_sched_job_t *front = queue_front(sched);
+    if (front) {
+        return avs_time_monotonic_add(front->instant, sched->slack);
     }
     return AVS_TIME_MONOTONIC_INVALID;
 }
@@ -268,6 +863,20 @@ avs_time_monotonic_t avs_sched_time_of_next(avs_sched_t *sched) {
     return result;
 }
 
+int avs_sched_set_slack(avs_sched_t *sched, avs_time_duration_t slack) {
+    assert(sched);
+    if (!avs_time_duration_valid(slack)
+            || avs_time_duration_less(slack, AVS_TIME_DURATION_ZERO)) {
+        SCHED_LOG(sched, ERROR, _("attempted to set invalid timer slack"));
+        return -1;
+    }
+    nonfailing_mutex_lock(sched->mutex);
+    sched->slack = slack;
+    avs_condvar_notify_all(sched->task_condvar);
+    avs_mutex_unlock(sched->mutex);
+    return 0;
+}
+
 int avs_sched_wait_until_next(avs_sched_t *sched,
                               avs_time_monotonic_t deadline) {
 #    ifdef AVS_COMMONS_SCHED_THREAD_SAFE
@@ -307,33 +916,164 @@ int avs_sched_wait_until_next(avs_sched_t *sched,
 #    endif // AVS_COMMONS_SCHED_THREAD_SAFE
 }
 
-static AVS_LIST(avs_sched_job_t) fetch_job(avs_sched_t *sched,
-                                           avs_time_monotonic_t deadline) {
+static AVS_LIST(avs_sched_job_t) take_job_locked(avs_sched_t *sched,
+                                                 avs_sched_job_t *job) {
+    if (job->handle_ptr) {
+        handles_write_lock();
+        assert(*job->handle_ptr == job);
+        *job->handle_ptr = NULL;
+        handles_write_unlock();
+        job->handle_ptr = NULL;
+    }
+    AVS_LIST(avs_sched_job_t) result = queue_detach(sched, job);
+    queue_trim(sched);
+#    ifdef AVS_COMMONS_SCHED_THREAD_SAFE
+    if (result->affinity_key) {
+        AVS_LIST_INSERT(&sched->running, result);
+    }
+#    endif // AVS_COMMONS_SCHED_THREAD_SAFE
+    return result;
+}
+
+#    ifdef AVS_COMMONS_SCHED_WITH_STATS
+static void histogram_record(avs_sched_histogram_t *histogram,
+                             avs_time_duration_t value) {
+    int64_t value_us;
+    size_t bucket = 0;
+    if (!avs_time_duration_to_scalar(&value_us, AVS_TIME_US, value)
+            && value_us > 0) {
+        bucket = 1;
+        while (bucket < AVS_SCHED_HISTOGRAM_BUCKETS - 1
+               && value_us >= ((int64_t) 1 << bucket)) {
+            ++bucket;
+        }
+    }
+    ++histogram->buckets[bucket];
+    ++histogram->count;
+    histogram->total = avs_time_duration_add(histogram->total, value);
+    if (avs_time_duration_less(histogram->max, value)) {
+        histogram->max = value;
+    }
+}
+
+static bool slow_job_matches(const avs_sched_slow_job_t *entry,
+                             const avs_sched_job_t *job) {
+    if (entry->line != job->log_info.line) {
+        return false;
+    }
+    if (!entry->file || !job->log_info.file) {
+        return entry->file == job->log_info.file;
+    }
+    return strcmp(entry->file, job->log_info.file) == 0;
+}
+
+/**
+ * Updates the list of slowest jobs, which is kept sorted by the maximum
+ * execution time, in descending order.
+ */
+static void slow_jobs_record(avs_sched_stats_t *stats,
+                             const avs_sched_job_t *job) {
+    size_t i;
+    for (i = 0; i < stats->slow_jobs_count; ++i) {
+        if (slow_job_matches(&stats->slow_jobs[i], job)) {
+            break;
+        }
+    }
+    if (i == stats->slow_jobs_count) {
+        if (i == AVS_SCHED_STATS_SLOW_JOBS) {
+            // all slots taken - replace the fastest of the tracked jobs
+            --i;
+            if (!avs_time_duration_less(stats->slow_jobs[i].max_exec_time,
+                                        job->stats.exec_time)) {
+                return;
+            }
+        } else {
+            ++stats->slow_jobs_count;
+        }
+        stats->slow_jobs[i] = (avs_sched_slow_job_t) {
+            .file = job->log_info.file,
+            .line = job->log_info.line,
+            .name = job->log_info.name,
+            .max_exec_time = AVS_TIME_DURATION_ZERO
+        };
+    }
+    if (avs_time_duration_less(stats->slow_jobs[i].max_exec_time,
+                               job->stats.exec_time)) {
+        stats->slow_jobs[i].max_exec_time = job->stats.exec_time;
+        for (; i > 0
+               && avs_time_duration_less(stats->slow_jobs[i - 1].max_exec_time,
+                                         stats->slow_jobs[i].max_exec_time);
+             --i) {
+            avs_sched_slow_job_t tmp = stats->slow_jobs[i - 1];
+            stats->slow_jobs[i - 1] = stats->slow_jobs[i];
+            stats->slow_jobs[i] = tmp;
+        }
+    }
+}
+#    endif // AVS_COMMONS_SCHED_WITH_STATS
+
+/**
+ * Releases a job that has just been executed.
+ */
+static void finish_job_locked(avs_sched_t *sched,
+                              AVS_LIST(avs_sched_job_t) job) {
+#    ifdef AVS_COMMONS_SCHED_WITH_STATS
+    histogram_record(&sched->stats.lateness, job->stats.lateness);
+    histogram_record(&sched->stats.exec_time, job->stats.exec_time);
+    slow_jobs_record(&sched->stats, job);
+#    endif // AVS_COMMONS_SCHED_WITH_STATS
+#    ifdef AVS_COMMONS_SCHED_THREAD_SAFE
+    if (job->affinity_key) {
+        AVS_LIST(avs_sched_job_t) *job_ptr =
+                (AVS_LIST(avs_sched_job_t) *) AVS_LIST_FIND_PTR(
+                        &sched->running, job);
+        assert(job_ptr);
+        AVS_LIST_DETACH(job_ptr);
+        // other jobs with the same affinity key might be waiting for this one
+        avs_condvar_notify_all(sched->task_condvar);
+    }
+#    endif // AVS_COMMONS_SCHED_THREAD_SAFE
+    job_free_locked(sched, job);
+}
+
+/**
+ * Fetches the next job to execute. @p finished_job, if not NULL, is the job
+ * executed previously; it is released while the scheduler is locked anyway.
+ */
+static AVS_LIST(avs_sched_job_t)
+fetch_job(avs_sched_t *sched,
+          avs_time_monotonic_t deadline,
+          AVS_LIST(avs_sched_job_t) finished_job) {
     AVS_LIST(avs_sched_job_t) result = NULL;
     nonfailing_mutex_lock(sched->mutex);
-    if (sched->jobs
-            && avs_time_monotonic_before(sched->jobs->instant, deadline)) {
-        if (sched->jobs->handle_ptr) {
-            nonfailing_mutex_lock(g_handle_access_mutex);
-            assert(*sched->jobs->handle_ptr == sched->jobs);
-            *sched->jobs->handle_ptr = NULL;
-            avs_mutex_unlock(g_handle_access_mutex);
-            sched->jobs->handle_ptr = NULL;
-        }
-        result = AVS_LIST_DETACH(&sched->jobs);
+    if (finished_job) {
+        finish_job_locked(sched, finished_job);
+    }
+    avs_sched_job_t *job = queue_first_runnable(sched);
+    if (job && avs_time_monotonic_before(job->instant, deadline)) {
+        result = take_job_locked(sched, job);
     }
     avs_mutex_unlock(sched->mutex);
     return result;
 }
 
-static void execute_job(avs_sched_t *sched, AVS_LIST(avs_sched_job_t) job) {
-    // make sure that the task is detached
-    assert(!AVS_LIST_NEXT(job));
-
+static void execute_job(avs_sched_t *sched, avs_sched_job_t *job) {
     SCHED_LOG(sched, TRACE, _("executing job") "%s", JOB_LOG_ID(job));
 
+#    ifdef AVS_COMMONS_SCHED_WITH_STATS
+    const avs_time_monotonic_t started = avs_time_monotonic_now();
+    job->stats.lateness = avs_time_monotonic_diff(started, job->instant);
+    if (avs_time_duration_less(job->stats.lateness, AVS_TIME_DURATION_ZERO)) {
+        job->stats.lateness = AVS_TIME_DURATION_ZERO;
+    }
+#    endif // AVS_COMMONS_SCHED_WITH_STATS
+
     job->clb(sched, job->clb_data);
-    AVS_LIST_DELETE(&job);
+
+#    ifdef AVS_COMMONS_SCHED_WITH_STATS
+    job->stats.exec_time =
+            avs_time_monotonic_diff(avs_time_monotonic_now(), started);
+#    endif // AVS_COMMONS_SCHED_WITH_STATS
 }
 
 void avs_sched_run(avs_sched_t *sched) {
@@ -342,7 +1082,7 @@ void avs_sched_run(avs_sched_t *sched) {
 
     uint32_t tasks_executed = 0;
     AVS_LIST(avs_sched_job_t) job = NULL;
-    while ((job = fetch_job(sched, now))) {
+    while ((job = fetch_job(sched, now, job))) {
         assert(job->sched == sched);
         execute_job(sched, job);
         ++tasks_executed;
@@ -364,90 +1104,182 @@ void avs_sched_run(avs_sched_t *sched) {
 #    endif // AVS_COMMONS_WITH_INTERNAL_TRACE
 }
 
-static void schedule_job(avs_sched_t *sched, avs_sched_job_t *job) {
-    AVS_LIST(avs_sched_job_t) *insert_ptr = &sched->jobs;
-    while (*insert_ptr
-           && !avs_time_monotonic_before(job->instant,
-                                         (*insert_ptr)->instant)) {
-        AVS_LIST_ADVANCE_PTR(&insert_ptr);
+int avs_sched_worker_run(avs_sched_t *sched) {
+    assert(sched);
+#    ifdef AVS_COMMONS_SCHED_THREAD_SAFE
+    int result = 0;
+    nonfailing_mutex_lock(sched->mutex);
+    ++sched->workers.active;
+    SCHED_LOG(sched, DEBUG, _("worker started"));
+    while (!sched->workers.stopping) {
+        avs_sched_job_t *job = queue_first_runnable(sched);
+        if (job
+                && avs_time_monotonic_before(job->instant,
+                                             avs_time_monotonic_now())) {
+            AVS_LIST(avs_sched_job_t) taken = take_job_locked(sched, job);
+            avs_mutex_unlock(sched->mutex);
+            execute_job(sched, taken);
+            nonfailing_mutex_lock(sched->mutex);
+            finish_job_locked(sched, taken);
+        } else if ((result = avs_condvar_wait(
+                            sched->task_condvar, sched->mutex,
+                            job ? avs_time_monotonic_add(job->instant,
+                                                         sched->slack)
+                                : AVS_TIME_MONOTONIC_INVALID))
+                   < 0) {
+            SCHED_LOG(sched, ERROR, _("could not wait on condition variable"));
+            break;
+        } else {
+            result = 0;
+        }
     }
-    AVS_LIST_INSERT(insert_ptr, job);
+    SCHED_LOG(sched, DEBUG, _("worker stopped"));
+    --sched->workers.active;
+    avs_condvar_notify_all(sched->task_condvar);
+    avs_mutex_unlock(sched->mutex);
+    return result;
+#    else  // AVS_COMMONS_SCHED_THREAD_SAFE
+    (void) sched;
+    SCHED_LOG(sched, ERROR,
+              _("avs_sched_worker_run() is not supported because avs_sched ")
+                      _("was compiled with thread safety disabled"));
+    return -1;
+#    endif // AVS_COMMONS_SCHED_THREAD_SAFE
 }
 
-static int sched_at_locked(avs_sched_t *sched,
-                           avs_sched_handle_t *out_handle,
-                           avs_time_monotonic_t instant,
-                           const char *log_file,
-                           unsigned log_line,
-                           const char *log_name,
-                           avs_sched_clb_t *clb,
-                           const void *clb_data,
-                           size_t clb_data_size) {
-    (void) log_file;
-    (void) log_line;
-    (void) log_name;
+int avs_sched_workers_stop(avs_sched_t *sched) {
     assert(sched);
-    assert(clb);
-    assert(avs_time_monotonic_valid(instant));
-    if (sched->shutting_down) {
-        SCHED_LOG(sched, DEBUG,
-                  _("scheduler already shut down when attempting ")
-                          _("to schedule") "%s",
-                  JOB_LOG_ID_EXPLICIT(log_file, log_line, log_name));
-        return -1;
+#    ifdef AVS_COMMONS_SCHED_THREAD_SAFE
+    int result = 0;
+    nonfailing_mutex_lock(sched->mutex);
+    sched->workers.stopping = true;
+    avs_condvar_notify_all(sched->task_condvar);
+    while (sched->workers.active) {
+        if ((result = avs_condvar_wait(sched->task_condvar, sched->mutex,
+                                       AVS_TIME_MONOTONIC_INVALID))
+                < 0) {
+            SCHED_LOG(sched, ERROR,
+                      _("could not wait on condition variable"));
+            break;
+        }
+        result = 0;
     }
+    avs_mutex_unlock(sched->mutex);
+    return result;
+#    else  // AVS_COMMONS_SCHED_THREAD_SAFE
+    (void) sched;
+    SCHED_LOG(sched, ERROR,
+              _("avs_sched_workers_stop() is not supported because avs_sched ")
+                      _("was compiled with thread safety disabled"));
+    return -1;
+#    endif // AVS_COMMONS_SCHED_THREAD_SAFE
+}
 
-    AVS_LIST(avs_sched_job_t) job = (avs_sched_job_t *) AVS_LIST_NEW_BUFFER(
-            sizeof(avs_sched_job_t) + clb_data_size);
+static AVS_LIST(avs_sched_job_t) job_new_locked(avs_sched_t *sched,
+                                                avs_time_monotonic_t instant,
+                                                const void *affinity_key,
+                                                const char *log_file,
+                                                unsigned log_line,
+                                                const char *log_name,
+                                                avs_sched_clb_t *clb,
+                                                const void *clb_data,
+                                                size_t clb_data_size) {
+    (void) affinity_key;
+    (void) log_file;
+    (void) log_line;
+    (void) log_name;
+    AVS_LIST(avs_sched_job_t) job = job_alloc_locked(sched, clb_data_size);
     if (!job) {
-        SCHED_LOG(sched, ERROR, _("could not allocate scheduler task"));
-        return -1;
+        return NULL;
     }
-
     job->sched = sched;
     job->instant = instant;
-#    ifdef AVS_COMMONS_WITH_INTERNAL_LOGS
+#    ifdef AVS_COMMONS_SCHED_THREAD_SAFE
+    job->affinity_key = affinity_key;
+#    endif // AVS_COMMONS_SCHED_THREAD_SAFE
+#    if defined(AVS_COMMONS_WITH_INTERNAL_LOGS) \
+            || defined(AVS_COMMONS_SCHED_WITH_STATS)
     job->log_info.file = log_file;
     job->log_info.line = log_line;
     job->log_info.name = log_name;
-#    endif // AVS_COMMONS_WITH_INTERNAL_LOGS
+#    endif // defined(AVS_COMMONS_WITH_INTERNAL_LOGS) ||
+           // defined(AVS_COMMONS_SCHED_WITH_STATS)
     job->clb = clb;
     if (clb_data_size) {
         memcpy(job->clb_data, clb_data, clb_data_size);
     }
+    return job;
+}
 
+/**
+ * Inserts a newly created @p job into the queue, replacing the job referred to
+ * by @p out_handle, if any. This cannot fail, provided that
+ * @ref queue_reserve has been called beforehand.
+ */
+static void schedule_job_locked(avs_sched_t *sched,
+                                avs_sched_handle_t *out_handle,
+                                AVS_LIST(avs_sched_job_t) job) {
     if (out_handle) {
         job->handle_ptr = out_handle;
-        nonfailing_mutex_lock(g_handle_access_mutex);
+        handles_write_lock();
         if (*out_handle) {
             AVS_ASSERT((*out_handle)->sched == sched,
                        "Replacing handles used by a different scheduler is "
                        "not supported");
-            AVS_LIST(avs_sched_job_t) *job_ptr =
-                    (AVS_LIST(avs_sched_job_t) *) AVS_LIST_FIND_PTR(
-                            &sched->jobs, *out_handle);
-            AVS_ASSERT(job_ptr, "dangling handle detected");
+            AVS_LIST(avs_sched_job_t) old_job =
+                    queue_detach(sched, *out_handle);
             SCHED_LOG(sched, TRACE,
                       _("cancelling job") "%s" _(
                               " due to reschedule policy for job") "%s",
-                      JOB_LOG_ID(*job_ptr),
-                      JOB_LOG_ID_EXPLICIT(log_file, log_line, log_name));
-            AVS_LIST_DELETE(job_ptr);
+                      JOB_LOG_ID(old_job), JOB_LOG_ID(job));
+            job_free_locked(sched, old_job);
         }
         *out_handle = job;
-        avs_mutex_unlock(g_handle_access_mutex);
+        handles_write_unlock();
     }
 
-    schedule_job(sched, job);
+    queue_insert(sched, job);
 #    ifdef AVS_COMMONS_WITH_INTERNAL_TRACE
     avs_time_duration_t remaining =
-            avs_time_monotonic_diff(instant, avs_time_monotonic_now());
+            avs_time_monotonic_diff(job->instant, avs_time_monotonic_now());
     SCHED_LOG(sched, TRACE,
               _("scheduled job") "%s" _(" at ") "%s" _(" (+") "%s" _(")"),
               JOB_LOG_ID(job),
-              AVS_TIME_DURATION_AS_STRING(instant.since_monotonic_epoch),
+              AVS_TIME_DURATION_AS_STRING(job->instant.since_monotonic_epoch),
               AVS_TIME_DURATION_AS_STRING(remaining));
 #    endif // AVS_COMMONS_WITH_INTERNAL_TRACE
+}
+
+static int sched_at_locked(avs_sched_t *sched,
+                           avs_sched_handle_t *out_handle,
+                           avs_time_monotonic_t instant,
+                           const void *affinity_key,
+                           const char *log_file,
+                           unsigned log_line,
+                           const char *log_name,
+                           avs_sched_clb_t *clb,
+                           const void *clb_data,
+                           size_t clb_data_size) {
+    assert(sched);
+    assert(clb);
+    assert(avs_time_monotonic_valid(instant));
+    if (sched->shutting_down) {
+        SCHED_LOG(sched, DEBUG,
+                  _("scheduler already shut down when attempting ")
+                          _("to schedule") "%s",
+                  JOB_LOG_ID_EXPLICIT(log_file, log_line, log_name));
+        return -1;
+    }
+
+    AVS_LIST(avs_sched_job_t) job = NULL;
+    if (queue_reserve(sched, 1)
+            || !(job = job_new_locked(sched, instant, affinity_key, log_file,
+                                      log_line, log_name, clb, clb_data,
+                                      clb_data_size))) {
+        SCHED_LOG(sched, ERROR, _("could not allocate scheduler task"));
+        return -1;
+    }
+    schedule_job_locked(sched, out_handle, job);
     return 0;
 }
 
@@ -460,6 +1292,21 @@ int avs_sched_at_impl__(avs_sched_t *sched,
                         avs_sched_clb_t *clb,
                         const void *clb_data,
                         size_t clb_data_size) {
+    return avs_sched_at_with_affinity_impl__(sched, out_handle, instant, NULL,
+                                             log_file, log_line, log_name, clb,
+                                             clb_data, clb_data_size);
+}
+
+int avs_sched_at_with_affinity_impl__(avs_sched_t *sched,
+                                      avs_sched_handle_t *out_handle,
+                                      avs_time_monotonic_t instant,
+                                      const void *affinity_key,
+                                      const char *log_file,
+                                      unsigned log_line,
+                                      const char *log_name,
+                                      avs_sched_clb_t *clb,
+                                      const void *clb_data,
+                                      size_t clb_data_size) {
     assert(sched);
     if (!clb) {
         SCHED_LOG(sched, ERROR,
@@ -477,8 +1324,8 @@ int avs_sched_at_impl__(avs_sched_t *sched,
 
     int result = -1;
     nonfailing_mutex_lock(sched->mutex);
-    if (!(result = sched_at_locked(sched, out_handle, instant, log_file,
-                                   log_line, log_name, clb, clb_data,
+    if (!(result = sched_at_locked(sched, out_handle, instant, affinity_key,
+                                   log_file, log_line, log_name, clb, clb_data,
                                    clb_data_size))) {
         avs_condvar_notify_all(sched->task_condvar);
     }
@@ -486,53 +1333,164 @@ int avs_sched_at_impl__(avs_sched_t *sched,
     return result;
 }
 
+int avs_sched_at_batch(avs_sched_t *sched,
+                       const avs_sched_batch_entry_t *entries,
+                       size_t count) {
+    assert(sched);
+    assert(entries || !count);
+    for (size_t i = 0; i < count; ++i) {
+        if (!entries[i].clb) {
+            SCHED_LOG(sched, ERROR,
+                      _("attempted to schedule a null callback pointer ")
+                              _("in batch entry ") "%lu",
+                      (unsigned long) i);
+            return -1;
+        }
+        if (!avs_time_monotonic_valid(entries[i].instant)) {
+            SCHED_LOG(sched, ERROR,
+                      _("attempted to schedule batch entry ") "%lu" _(
+                              " at an invalid time point"),
+                      (unsigned long) i);
+            return -1;
+        }
+    }
+
+    int result = -1;
+    nonfailing_mutex_lock(sched->mutex);
+    if (sched->shutting_down) {
+        SCHED_LOG(sched, DEBUG,
+                  _("scheduler already shut down when attempting ")
+                          _("to schedule a batch of jobs"));
+    } else if (queue_reserve(sched, count)) {
+        SCHED_LOG(sched, ERROR, _("could not allocate scheduler task"));
+    } else {
+        // allocate all the jobs first, so that the batch is scheduled
+        // atomically; the jobs are temporarily chained into a list
+        AVS_LIST(avs_sched_job_t) jobs = NULL;
+        AVS_LIST(avs_sched_job_t) *tail_ptr = &jobs;
+        size_t allocated;
+        for (allocated = 0; allocated < count; ++allocated) {
+            const avs_sched_batch_entry_t *entry = &entries[allocated];
+            if (!(*tail_ptr = job_new_locked(
+                          sched, entry->instant, entry->affinity_key, NULL, 0,
+                          NULL, entry->clb, entry->clb_data,
+                          entry->clb_data_size))) {
+                break;
+            }
+            AVS_LIST_ADVANCE_PTR(&tail_ptr);
+        }
+        if (allocated < count) {
+            SCHED_LOG(sched, ERROR, _("could not allocate scheduler task"));
+            while (jobs) {
+                job_free_locked(sched, AVS_LIST_DETACH(&jobs));
+            }
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                schedule_job_locked(sched, entries[i].out_handle,
+                                    AVS_LIST_DETACH(&jobs));
+            }
+            assert(!jobs);
+            SCHED_LOG(sched, TRACE, _("scheduled a batch of ") "%lu" _(" jobs"),
+                      (unsigned long) count);
+            avs_condvar_notify_all(sched->task_condvar);
+            result = 0;
+        }
+    }
+    avs_mutex_unlock(sched->mutex);
+    return result;
+}
+
 avs_time_monotonic_t avs_sched_time(avs_sched_handle_t *handle_ptr) {
     avs_time_monotonic_t result = AVS_TIME_MONOTONIC_INVALID;
-    nonfailing_mutex_lock(g_handle_access_mutex);
+    handles_read_lock();
     if (handle_ptr && *handle_ptr) {
         result = (*handle_ptr)->instant;
     }
-    avs_mutex_unlock(g_handle_access_mutex);
+    handles_read_unlock();
     return result;
 }
 
-void avs_sched_del(avs_sched_handle_t *handle_ptr) {
-    if (!handle_ptr) {
-        return;
-    }
-    avs_sched_t *sched = NULL;
+/**
+ * Reads the job referred to by @p handle_ptr, along with the scheduler it is
+ * scheduled on. Returns NULL if the handle is not set.
+ */
+static avs_sched_job_t *handle_job(avs_sched_handle_t *handle_ptr,
+                                   avs_sched_t **out_sched) {
     avs_sched_job_t *job = NULL;
-    nonfailing_mutex_lock(g_handle_access_mutex);
+    handles_read_lock();
     if (*handle_ptr) {
         AVS_ASSERT(handle_ptr == (*handle_ptr)->handle_ptr,
                    "accessing job via non-original handle");
         job = *handle_ptr;
-        sched = (*handle_ptr)->sched;
+        *out_sched = (*handle_ptr)->sched;
+    }
+    handles_read_unlock();
+    return job;
+}
+
+static void del_job_locked(avs_sched_t *sched,
+                           avs_sched_handle_t *handle_ptr,
+                           avs_sched_job_t *job) {
+    if (!job_still_scheduled_locked(sched, handle_ptr, job)) {
+        // Job might have been removed by another thread, don't do anything
+        return;
+    }
+    SCHED_LOG(sched, TRACE, _("cancelling job") "%s", JOB_LOG_ID(job));
+    handles_write_lock();
+    assert(*job->handle_ptr == job);
+    *job->handle_ptr = NULL;
+    handles_write_unlock();
+
+    job_free_locked(sched, queue_detach(sched, job));
+}
+
+void avs_sched_del(avs_sched_handle_t *handle_ptr) {
+    if (!handle_ptr) {
+        return;
     }
-    avs_mutex_unlock(g_handle_access_mutex);
+    avs_sched_t *sched = NULL;
+    avs_sched_job_t *job = handle_job(handle_ptr, &sched);
     if (!job) {
         return;
     }
 
     assert(sched);
     nonfailing_mutex_lock(sched->mutex);
-    AVS_LIST(avs_sched_job_t) *job_ptr =
-            (AVS_LIST(avs_sched_job_t) *) AVS_LIST_FIND_PTR(&sched->jobs, job);
-    if (!job_ptr) {
-#    ifndef AVS_COMMONS_SCHED_THREAD_SAFE
-        AVS_ASSERT(job_ptr, "dangling handle detected");
-#    endif // AVS_COMMONS_SCHED_THREAD_SAFE
-           // Job might have been removed by another thread, don't do anything
-    } else {
-        SCHED_LOG(sched, TRACE, _("cancelling job") "%s", JOB_LOG_ID(job));
-        nonfailing_mutex_lock(g_handle_access_mutex);
-        assert(*job->handle_ptr == job);
-        *job->handle_ptr = NULL;
-        avs_mutex_unlock(g_handle_access_mutex);
+    del_job_locked(sched, handle_ptr, job);
+    queue_trim(sched);
+    avs_mutex_unlock(sched->mutex);
+}
 
-        AVS_LIST_DELETE(job_ptr);
+void avs_sched_del_batch(avs_sched_handle_t *const *handle_ptrs,
+                         size_t count) {
+    assert(handle_ptrs || !count);
+    avs_sched_t *locked_sched = NULL;
+    for (size_t i = 0; i < count; ++i) {
+        if (!handle_ptrs[i]) {
+            continue;
+        }
+        avs_sched_t *sched = NULL;
+        avs_sched_job_t *job = handle_job(handle_ptrs[i], &sched);
+        if (!job) {
+            continue;
+        }
+        assert(sched);
+        // handles are typically all related to the same scheduler, so keep
+        // its mutex locked for as long as possible
+        if (sched != locked_sched) {
+            if (locked_sched) {
+                queue_trim(locked_sched);
+                avs_mutex_unlock(locked_sched->mutex);
+            }
+            nonfailing_mutex_lock(sched->mutex);
+            locked_sched = sched;
+        }
+        del_job_locked(sched, handle_ptrs[i], job);
+    }
+    if (locked_sched) {
+        queue_trim(locked_sched);
+        avs_mutex_unlock(locked_sched->mutex);
     }
-    avs_mutex_unlock(sched->mutex);
 }
 
 void avs_sched_detach(avs_sched_handle_t *handle_ptr) {
@@ -541,32 +1499,27 @@ void avs_sched_detach(avs_sched_handle_t *handle_ptr) {
     }
     avs_sched_t *sched = NULL;
     avs_sched_job_t *job = NULL;
-    nonfailing_mutex_lock(g_handle_access_mutex);
+    handles_read_lock();
     if (*handle_ptr) {
         AVS_ASSERT(handle_ptr == (*handle_ptr)->handle_ptr,
                    "accessing job via non-original handle");
         job = *handle_ptr;
         sched = (*handle_ptr)->sched;
     }
-    avs_mutex_unlock(g_handle_access_mutex);
+    handles_read_unlock();
     if (!job) {
         return;
     }
 
     assert(sched);
     nonfailing_mutex_lock(sched->mutex);
-    AVS_LIST(avs_sched_job_t) *job_ptr =
-            (AVS_LIST(avs_sched_job_t) *) AVS_LIST_FIND_PTR(&sched->jobs, job);
-    if (!job_ptr) {
-#    ifndef AVS_COMMONS_SCHED_THREAD_SAFE
-        AVS_ASSERT(job_ptr, "dangling handle detected");
-#    endif // AVS_COMMONS_SCHED_THREAD_SAFE
-           // Job might have been removed by another thread, don't do anything
+    if (!job_still_scheduled_locked(sched, handle_ptr, job)) {
+        // Job might have been removed by another thread, don't do anything
     } else {
-        nonfailing_mutex_lock(g_handle_access_mutex);
+        handles_write_lock();
         assert(*job->handle_ptr == job);
         *job->handle_ptr = NULL;
-        avs_mutex_unlock(g_handle_access_mutex);
+        handles_write_unlock();
 
         job->handle_ptr = NULL;
     }
@@ -585,10 +1538,7 @@ int avs_sched_leap_time(avs_sched_t *sched, avs_time_duration_t diff) {
     SCHED_LOG(sched, INFO, _("moving all jobs by ") "%s" _(" s"),
               AVS_TIME_DURATION_AS_STRING(diff));
 
-    AVS_LIST(avs_sched_job_t) job;
-    AVS_LIST_FOREACH(job, sched->jobs) {
-        job->instant = avs_time_monotonic_add(job->instant, diff);
-    }
+    queue_leap(sched, diff);
     avs_condvar_notify_all(sched->task_condvar);
 
     avs_mutex_unlock(sched->mutex);
@@ -607,14 +1557,14 @@ int avs_resched_at_impl__(avs_sched_handle_t *handle_ptr,
 
     avs_sched_t *sched = NULL;
     avs_sched_job_t *job = NULL;
-    nonfailing_mutex_lock(g_handle_access_mutex);
+    handles_read_lock();
     if (*handle_ptr) {
         AVS_ASSERT(handle_ptr == (*handle_ptr)->handle_ptr,
                    "accessing job via non-original handle");
         sched = (*handle_ptr)->sched;
         job = *handle_ptr;
     }
-    avs_mutex_unlock(g_handle_access_mutex);
+    handles_read_unlock();
     if (!job) {
         return -1;
     }
@@ -622,21 +1572,13 @@ int avs_resched_at_impl__(avs_sched_handle_t *handle_ptr,
     int retval = 0;
     assert(sched);
     nonfailing_mutex_lock(sched->mutex);
-    AVS_LIST(avs_sched_job_t) *job_ptr =
-            (AVS_LIST(avs_sched_job_t) *) AVS_LIST_FIND_PTR(&sched->jobs, job);
-    if (job_ptr) {
-        SCHED_LOG(sched, TRACE, _("rescheduling job") "%s",
-                  JOB_LOG_ID(*job_ptr));
+    if (job_still_scheduled_locked(sched, handle_ptr, job)) {
+        SCHED_LOG(sched, TRACE, _("rescheduling job") "%s", JOB_LOG_ID(job));
 
-        avs_sched_job_t *detached_job = AVS_LIST_DETACH(job_ptr);
-        detached_job->instant = instant;
-
-        schedule_job(sched, detached_job);
+        job->instant = instant;
+        queue_update(sched, job);
         avs_condvar_notify_all(sched->task_condvar);
     } else {
-#    ifndef AVS_COMMONS_SCHED_THREAD_SAFE
-        AVS_ASSERT(job_ptr, "dangling handle detected");
-#    endif // AVS_COMMONS_SCHED_THREAD_SAFE
         retval = -1;
     }
 
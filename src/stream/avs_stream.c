@@ -408,6 +408,17 @@ avs_error_t avs_stream_peekline(avs_stream_t *stream,
 
 avs_error_t avs_stream_copy(avs_stream_t *output_stream,
                             avs_stream_t *input_stream) {
+    const avs_stream_v_table_extension_copy_t *copy =
+            (const avs_stream_v_table_extension_copy_t *)
+                    avs_stream_v_table_find_extension(
+                            output_stream, AVS_STREAM_V_TABLE_EXTENSION_COPY);
+    if (copy && copy->copy_from) {
+        avs_error_t err = copy->copy_from(output_stream, input_stream);
+        if (err.category != AVS_ERRNO_CATEGORY || err.code != AVS_ENOTSUP) {
+            return err;
+        }
+    }
+
     char buf[AVS_STREAM_STACK_BUFFER_SIZE];
     size_t bytes_read;
     bool message_finished = false;
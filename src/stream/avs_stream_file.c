@@ -241,6 +241,14 @@ error:
     return NULL;
 }
 
+FILE *avs_stream_file_get_fp(avs_stream_t *stream) {
+    avs_stream_file_t *file = (avs_stream_file_t *) stream;
+    if (!file || file->vtable != &file_stream_vtable) {
+        return NULL;
+    }
+    return file->fp;
+}
+
 #    ifdef AVS_UNIT_TESTING
 #        include "tests/stream/test_stream_file.c"
 #    endif
@@ -20,6 +20,7 @@
         && defined(AVS_COMMONS_WITH_AVS_BUFFER) \
         && defined(AVS_COMMONS_WITH_AVS_NET)
 
+#    include <stdint.h>
 #    include <stdio.h>
 #    include <string.h>
 
@@ -27,6 +28,7 @@
 #    include <avsystem/commons/avs_errno.h>
 #    include <avsystem/commons/avs_memory.h>
 #    include <avsystem/commons/avs_net.h>
+#    include <avsystem/commons/avs_stream_file.h>
 #    include <avsystem/commons/avs_stream_netbuf.h>
 #    include <avsystem/commons/avs_stream_v_table.h>
 
@@ -56,6 +58,13 @@ static avs_error_t out_buffer_flush(buffered_netstream_t *stream) {
     return err;
 }
 
+static bool is_stream_socket(avs_net_socket_t *socket) {
+    avs_net_socket_opt_value_t datagram;
+    return avs_is_ok(avs_net_socket_get_opt(socket, AVS_NET_SOCKET_OPT_DATAGRAM,
+                                            &datagram))
+           && !datagram.flag;
+}
+
 static avs_error_t buffered_netstream_write_some(avs_stream_t *stream_,
                                                  const void *data,
                                                  size_t *inout_data_length) {
@@ -66,11 +75,31 @@ static avs_error_t buffered_netstream_write_some(avs_stream_t *stream_,
                                                  *inout_data_length)
                                  ? AVS_ENOBUFS
                                  : AVS_NO_ERROR);
-    } else if (avs_is_err((err = out_buffer_flush(stream)))) {
-        return err;
-    } else {
+    } else if (!is_stream_socket(stream->socket)) {
+        // each send is a separate datagram; don't change the message framing
+        if (avs_is_err((err = out_buffer_flush(stream)))) {
+            return err;
+        }
         return avs_net_socket_send(stream->socket, data, *inout_data_length);
     }
+    // send the buffered data (e.g. protocol headers) and the new data
+    // (e.g. payload) together, without copying them into a common buffer
+    const avs_net_socket_outgoing_buffer_t buffers[] = {
+        {
+            .data = avs_buffer_data(stream->out_buffer),
+            .data_length = avs_buffer_data_size(stream->out_buffer)
+        },
+        {
+            .data = data,
+            .data_length = *inout_data_length
+        }
+    };
+    err = avs_net_socket_sendv(stream->socket, buffers,
+                               AVS_ARRAY_SIZE(buffers));
+    if (avs_is_ok(err)) {
+        avs_buffer_reset(stream->out_buffer);
+    }
+    return err;
 }
 
 static size_t buffered_netstream_nonblock_write_ready(avs_stream_t *stream) {
@@ -298,6 +327,23 @@ static avs_error_t buffered_netstream_close(avs_stream_t *stream_) {
     return err;
 }
 
+#    ifdef AVS_COMMONS_STREAM_WITH_FILE
+static avs_error_t buffered_netstream_copy_from(avs_stream_t *stream_,
+                                                avs_stream_t *input_stream) {
+    buffered_netstream_t *stream = (buffered_netstream_t *) stream_;
+    FILE *file = avs_stream_file_get_fp(input_stream);
+    if (!file) {
+        return avs_errno(AVS_ENOTSUP);
+    }
+    // data written earlier needs to go first
+    avs_error_t err = out_buffer_flush(stream);
+    if (avs_is_err(err)) {
+        return err;
+    }
+    return avs_net_socket_send_file(stream->socket, file, SIZE_MAX, NULL);
+}
+#    endif // AVS_COMMONS_STREAM_WITH_FILE
+
 static avs_net_socket_t *buffered_netstream_getsock(avs_stream_t *stream) {
     return ((buffered_netstream_t *) stream)->socket;
 }
@@ -327,6 +373,11 @@ static const avs_stream_v_table_t buffered_netstream_vtable = {
                       &(const avs_stream_v_table_extension_nonblock_t) {
                               buffered_netstream_nonblock_read_ready,
                               buffered_netstream_nonblock_write_ready } },
+#    ifdef AVS_COMMONS_STREAM_WITH_FILE
+                    { AVS_STREAM_V_TABLE_EXTENSION_COPY,
+                      &(const avs_stream_v_table_extension_copy_t) {
+                              buffered_netstream_copy_from } },
+#    endif // AVS_COMMONS_STREAM_WITH_FILE
                     AVS_STREAM_V_TABLE_EXTENSION_NULL }
 };
 
@@ -418,6 +469,10 @@ void avs_stream_netbuf_set_recv_timeout(avs_stream_t *str,
                            timeout_opt);
 }
 
+#    ifdef AVS_UNIT_TESTING
+#        include "tests/stream/test_stream_netbuf.c"
+#    endif
+
 #endif // defined(AVS_COMMONS_WITH_AVS_STREAM) &&
        // defined(AVS_COMMONS_WITH_AVS_BUFFER) &&
        // defined(AVS_COMMONS_WITH_AVS_NET)
@@ -786,6 +786,12 @@ static avs_error_t mock_get_opt(avs_net_socket_t *socket_,
         return AVS_OK;
     }
 
+    if (option_key == AVS_NET_SOCKET_OPT_DATAGRAM) {
+        out_option_value->flag =
+                (socket->type == AVS_UNIT_MOCKSOCK_TYPE_DATAGRAM);
+        return AVS_OK;
+    }
+
     assert_command_expected(socket->expected_commands,
                             MOCKSOCK_COMMAND_GET_OPT);
 
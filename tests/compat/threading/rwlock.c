@@ -0,0 +1,112 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avs_commons_posix_init.h>
+
+#include <avsystem/commons/avs_rwlock.h>
+
+#include <pthread.h>
+
+#include <avsystem/commons/avs_unit_test.h>
+
+typedef struct {
+    avs_rwlock_t *rwlock;
+    const size_t num_iterations;
+    // both are only modified under the write lock, so they shall always be
+    // equal when observed by a reader
+    unsigned long first;
+    unsigned long second;
+    bool inconsistency_detected;
+} thread_func_args_t;
+
+static void *writer_func(void *args_) {
+    thread_func_args_t *args = (thread_func_args_t *) args_;
+
+    for (size_t i = 0; i < args->num_iterations; ++i) {
+        avs_rwlock_write_lock(args->rwlock);
+        ++args->first;
+        ++args->second;
+        avs_rwlock_write_unlock(args->rwlock);
+    }
+
+    return NULL;
+}
+
+static void *reader_func(void *args_) {
+    thread_func_args_t *args = (thread_func_args_t *) args_;
+
+    for (size_t i = 0; i < args->num_iterations; ++i) {
+        avs_rwlock_read_lock(args->rwlock);
+        if (args->first != args->second) {
+            args->inconsistency_detected = true;
+        }
+        avs_rwlock_read_unlock(args->rwlock);
+    }
+
+    return NULL;
+}
+
+AVS_UNIT_TEST(rwlock, readers_and_writers) {
+    pthread_t writers[2];
+    pthread_t readers[4];
+
+    avs_rwlock_t *rwlock = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_rwlock_create(&rwlock));
+
+    thread_func_args_t args = {
+        .rwlock = rwlock,
+        .num_iterations = 1000
+    };
+
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(writers); ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(
+                pthread_create(&writers[i], NULL, writer_func, &args));
+    }
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(readers); ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(
+                pthread_create(&readers[i], NULL, reader_func, &args));
+    }
+
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(writers); ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(pthread_join(writers[i], NULL));
+    }
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(readers); ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(pthread_join(readers[i], NULL));
+    }
+
+    avs_rwlock_cleanup(&rwlock);
+    AVS_UNIT_ASSERT_NULL(rwlock);
+
+    AVS_UNIT_ASSERT_FALSE(args.inconsistency_detected);
+    AVS_UNIT_ASSERT_EQUAL(args.first,
+                          AVS_ARRAY_SIZE(writers) * args.num_iterations);
+}
+
+AVS_UNIT_TEST(rwlock, multiple_readers) {
+    avs_rwlock_t *rwlock = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_rwlock_create(&rwlock));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_rwlock_read_lock(rwlock));
+    AVS_UNIT_ASSERT_SUCCESS(avs_rwlock_read_lock(rwlock));
+    AVS_UNIT_ASSERT_SUCCESS(avs_rwlock_read_unlock(rwlock));
+    AVS_UNIT_ASSERT_SUCCESS(avs_rwlock_read_unlock(rwlock));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_rwlock_write_lock(rwlock));
+    AVS_UNIT_ASSERT_SUCCESS(avs_rwlock_write_unlock(rwlock));
+
+    avs_rwlock_cleanup(&rwlock);
+    AVS_UNIT_ASSERT_NULL(rwlock);
+}
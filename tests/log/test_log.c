@@ -19,6 +19,14 @@
 
 #include <stdlib.h>
 
+#if defined(AVS_COMMONS_LOG_WITH_ASYNC) \
+        && defined(AVS_COMMONS_COMPAT_THREADING_WITH_PTHREAD)
+#    include <pthread.h>
+#    include <sched.h>
+#    include <stdint.h>
+#endif // defined(AVS_COMMONS_LOG_WITH_ASYNC) &&
+       // defined(AVS_COMMONS_COMPAT_THREADING_WITH_PTHREAD)
+
 static avs_log_level_t EXPECTED_LEVEL;
 static char EXPECTED_MODULE[64];
 static char EXPECTED_FILE[256];
@@ -315,6 +323,301 @@ AVS_UNIT_TEST(log, lazy_log) {
     reset_everything();
 }
 
+enum { SINGLE_CALL_SITE_LINE = __LINE__ + 3 };
+
+static void log_from_single_call_site(void) {
+    avs_log(cached_module, DEBUG, "Testing cached level");
+}
+
+AVS_UNIT_TEST(log, cached_level_changes) {
+    /* default level is INFO */
+    log_from_single_call_site();
+    ASSERT_LOG_CLEAN;
+
+    avs_log_set_level(cached_module, AVS_LOG_DEBUG);
+    ASSERT_LOG(cached_module,
+               DEBUG,
+               "DEBUG [cached_module] [" __FILE__
+               ":%d]: Testing cached level",
+               SINGLE_CALL_SITE_LINE);
+    log_from_single_call_site();
+    ASSERT_LOG_CLEAN;
+
+    avs_log_set_level(other_module, AVS_LOG_ERROR);
+    ASSERT_LOG(cached_module,
+               DEBUG,
+               "DEBUG [cached_module] [" __FILE__
+               ":%d]: Testing cached level",
+               SINGLE_CALL_SITE_LINE);
+    log_from_single_call_site();
+    ASSERT_LOG_CLEAN;
+
+    avs_log_set_level(cached_module, AVS_LOG_INFO);
+    log_from_single_call_site();
+    ASSERT_LOG_CLEAN;
+
+    avs_log_set_default_level(AVS_LOG_DEBUG);
+    log_from_single_call_site();
+    ASSERT_LOG_CLEAN;
+
+    avs_log_reset();
+    avs_log_set_handler(mock_handler);
+    avs_log_set_default_level(AVS_LOG_DEBUG);
+    ASSERT_LOG(cached_module,
+               DEBUG,
+               "DEBUG [cached_module] [" __FILE__
+               ":%d]: Testing cached level",
+               SINGLE_CALL_SITE_LINE);
+    log_from_single_call_site();
+    ASSERT_LOG_CLEAN;
+
+    reset_everything();
+}
+
+#ifdef AVS_COMMONS_LOG_WITH_LEVEL_CACHE
+AVS_UNIT_TEST(log, cached_level_generation_wrap) {
+    /* fill the cache entry for cached_module */
+    log_from_single_call_site();
+    ASSERT_LOG_CLEAN;
+
+    atomic_store(&g_log_level_generation, LEVEL_CACHE_MAX_GENERATION);
+    avs_log_set_level(other_module, AVS_LOG_ERROR);
+    AVS_UNIT_ASSERT_EQUAL(atomic_load(&g_log_level_generation), 1);
+    for (size_t i = 0; i < LEVEL_CACHE_SIZE; ++i) {
+        AVS_UNIT_ASSERT_EQUAL(atomic_load(&g_log_level_cache[i].value), 0);
+    }
+
+    avs_log_set_level(cached_module, AVS_LOG_DEBUG);
+    ASSERT_LOG(cached_module,
+               DEBUG,
+               "DEBUG [cached_module] [" __FILE__
+               ":%d]: Testing cached level",
+               SINGLE_CALL_SITE_LINE);
+    log_from_single_call_site();
+    ASSERT_LOG_CLEAN;
+
+    reset_everything();
+}
+
+AVS_UNIT_TEST(log, cached_level_table_full) {
+    /* each buffer is a distinct module name string, so that there are more of
+     * them than the cache can hold */
+    static char modules[LEVEL_CACHE_SIZE * 2][8];
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(modules); ++i) {
+        snprintf(modules[i], sizeof(modules[i]), "mod%u", (unsigned) i);
+        avs_log_set_level__(modules[i],
+                            i % 2 ? AVS_LOG_DEBUG : AVS_LOG_WARNING);
+    }
+    for (int pass = 0; pass < 2; ++pass) {
+        for (size_t i = 0; i < AVS_ARRAY_SIZE(modules); ++i) {
+            AVS_UNIT_ASSERT_EQUAL(
+                    avs_log_should_log__(AVS_LOG_DEBUG, modules[i]), i % 2);
+            AVS_UNIT_ASSERT_TRUE(
+                    avs_log_should_log__(AVS_LOG_WARNING, modules[i]));
+        }
+    }
+    reset_everything();
+}
+#endif // AVS_COMMONS_LOG_WITH_LEVEL_CACHE
+
+#ifdef AVS_COMMONS_LOG_WITH_ASYNC
+AVS_UNIT_TEST(log, async) {
+    avs_log_async_stats_t stats_before;
+    AVS_UNIT_ASSERT_SUCCESS(avs_log_async_stats(&stats_before));
+    AVS_UNIT_ASSERT_SUCCESS(avs_log_async_start());
+
+    /* messages are passed to the handler when flushed */
+    ASSERT_LOG(test,
+               INFO,
+               "INFO [test] [" __FILE__ ":%d]: Queued 42",
+               __LINE__ + 1);
+    avs_log(test, INFO, "Queued %d", 42);
+    avs_log(test, DEBUG, "Not queued");
+    avs_log_async_flush();
+    ASSERT_LOG_CLEAN;
+
+    /* stopping flushes the queue and restores synchronous logging */
+    ASSERT_LOG(test,
+               WARNING,
+               "WARNING [test] [" __FILE__ ":%d]: Queued again",
+               __LINE__ + 1);
+    avs_log(test, WARNING, "Queued again");
+    avs_log_async_stop();
+    ASSERT_LOG_CLEAN;
+    ASSERT_LOG(test,
+               ERROR,
+               "ERROR [test] [" __FILE__ ":%d]: Not queued",
+               __LINE__ + 1);
+    avs_log(test, ERROR, "Not queued");
+    ASSERT_LOG_CLEAN;
+
+    /* the drainer does not run if the asynchronous mode is stopped */
+    AVS_UNIT_ASSERT_FAILED(avs_log_async_drainer_run());
+
+    avs_log_async_stats_t stats;
+    AVS_UNIT_ASSERT_SUCCESS(avs_log_async_stats(&stats));
+    AVS_UNIT_ASSERT_EQUAL(stats.queued, stats_before.queued + 2);
+    AVS_UNIT_ASSERT_EQUAL(stats.dropped, stats_before.dropped);
+
+    reset_everything();
+}
+
+static size_t COUNTED_MESSAGES;
+static size_t COUNTED_DROP_WARNINGS;
+
+static void counting_handler(avs_log_level_t level,
+                             const char *module,
+                             const char *message) {
+    if (strcmp(module, "avs_log") == 0) {
+        AVS_UNIT_ASSERT_EQUAL(level, AVS_LOG_WARNING);
+        AVS_UNIT_ASSERT_NOT_NULL(strstr(message, "5 log messages dropped"));
+        ++COUNTED_DROP_WARNINGS;
+    } else {
+        AVS_UNIT_ASSERT_EQUAL_STRING(module, "test");
+        ++COUNTED_MESSAGES;
+    }
+}
+
+AVS_UNIT_TEST(log, async_dropped) {
+    avs_log_set_handler(counting_handler);
+    COUNTED_MESSAGES = 0;
+    COUNTED_DROP_WARNINGS = 0;
+
+    avs_log_async_stats_t stats_before;
+    AVS_UNIT_ASSERT_SUCCESS(avs_log_async_stats(&stats_before));
+    AVS_UNIT_ASSERT_SUCCESS(avs_log_async_start());
+    for (size_t i = 0; i < AVS_COMMONS_LOG_ASYNC_QUEUE_SIZE + 5; ++i) {
+        avs_log(test, INFO, "Message %u", (unsigned) i);
+    }
+    AVS_UNIT_ASSERT_EQUAL(COUNTED_MESSAGES, 0);
+
+    avs_log_async_stats_t stats;
+    AVS_UNIT_ASSERT_SUCCESS(avs_log_async_stats(&stats));
+    AVS_UNIT_ASSERT_EQUAL(stats.queued,
+                          stats_before.queued
+                                  + AVS_COMMONS_LOG_ASYNC_QUEUE_SIZE);
+    AVS_UNIT_ASSERT_EQUAL(stats.dropped, stats_before.dropped + 5);
+
+    avs_log_async_flush();
+    AVS_UNIT_ASSERT_EQUAL(COUNTED_MESSAGES, AVS_COMMONS_LOG_ASYNC_QUEUE_SIZE);
+    AVS_UNIT_ASSERT_EQUAL(COUNTED_DROP_WARNINGS, 1);
+
+    /* the queue is usable again after being drained */
+    avs_log(test, INFO, "Message after flush");
+    avs_log_async_stop();
+    AVS_UNIT_ASSERT_EQUAL(COUNTED_MESSAGES,
+                          AVS_COMMONS_LOG_ASYNC_QUEUE_SIZE + 1);
+    AVS_UNIT_ASSERT_EQUAL(COUNTED_DROP_WARNINGS, 1);
+
+    reset_everything();
+}
+
+#    ifdef AVS_COMMONS_COMPAT_THREADING_WITH_PTHREAD
+#        define CONCURRENT_PRODUCERS 4
+#        define MESSAGES_PER_PRODUCER 2000
+
+static volatile atomic_size_t HANDLED_MESSAGES;
+static volatile atomic_size_t PRODUCED_MESSAGES;
+static volatile atomic_uint PRODUCER_PROGRESS[CONCURRENT_PRODUCERS];
+static volatile atomic_bool PRODUCERS_GO;
+
+static void concurrent_handler(avs_log_level_t level,
+                               const char *module,
+                               const char *message) {
+    (void) level;
+    (void) message;
+    if (strcmp(module, "avs_log") != 0) {
+        atomic_fetch_add(&HANDLED_MESSAGES, 1);
+    }
+}
+
+static void *producer_thread(void *index) {
+    volatile atomic_uint *progress = &PRODUCER_PROGRESS[(uintptr_t) index];
+    while (!atomic_load(&PRODUCERS_GO)) {
+        sched_yield();
+    }
+    for (unsigned i = 0; i < MESSAGES_PER_PRODUCER; ++i) {
+        avs_log(test, INFO, "Message %u", i);
+        atomic_store(progress, i + 1);
+        atomic_fetch_add(&PRODUCED_MESSAGES, 1);
+        // let the drainer and the controlling thread run on single-core hosts
+        sched_yield();
+    }
+    return NULL;
+}
+
+static void *drainer_thread(void *unused) {
+    (void) unused;
+    avs_log_async_drainer_run();
+    return NULL;
+}
+
+AVS_UNIT_TEST(log, async_concurrent_producers) {
+    avs_log_set_handler(concurrent_handler);
+    atomic_store(&HANDLED_MESSAGES, 0);
+    atomic_store(&PRODUCED_MESSAGES, 0);
+    atomic_store(&PRODUCERS_GO, false);
+
+    avs_log_async_stats_t stats_before;
+    AVS_UNIT_ASSERT_SUCCESS(avs_log_async_stats(&stats_before));
+
+    pthread_t producers[CONCURRENT_PRODUCERS];
+    for (size_t i = 0; i < CONCURRENT_PRODUCERS; ++i) {
+        atomic_store(&PRODUCER_PROGRESS[i], 0);
+        AVS_UNIT_ASSERT_SUCCESS(pthread_create(&producers[i], NULL,
+                                               producer_thread,
+                                               (void *) (uintptr_t) i));
+    }
+    atomic_store(&PRODUCERS_GO, true);
+
+    /* repeatedly start and stop the asynchronous mode while the producers are
+     * logging, so that some of them race with stopping; every message needs
+     * to be handled anyway, either through the queue or synchronously */
+    for (size_t round = 0; round < 20; ++round) {
+        AVS_UNIT_ASSERT_SUCCESS(avs_log_async_start());
+        pthread_t drainer;
+        AVS_UNIT_ASSERT_SUCCESS(
+                pthread_create(&drainer, NULL, drainer_thread, NULL));
+        size_t target = atomic_load(&PRODUCED_MESSAGES) + 100;
+        while (atomic_load(&PRODUCED_MESSAGES) < target
+               && atomic_load(&PRODUCED_MESSAGES)
+                          < CONCURRENT_PRODUCERS * MESSAGES_PER_PRODUCER) {
+            sched_yield();
+        }
+        avs_log_async_stop();
+        AVS_UNIT_ASSERT_SUCCESS(pthread_join(drainer, NULL));
+
+        /* once every producer has finished the message it might have been
+         * logging while stopping, nothing may have been queued since then */
+        avs_log_async_stats_t stats_at_stop;
+        AVS_UNIT_ASSERT_SUCCESS(avs_log_async_stats(&stats_at_stop));
+        for (size_t i = 0; i < CONCURRENT_PRODUCERS; ++i) {
+            unsigned progress = atomic_load(&PRODUCER_PROGRESS[i]);
+            while (progress < MESSAGES_PER_PRODUCER
+                   && atomic_load(&PRODUCER_PROGRESS[i]) < progress + 2) {
+                sched_yield();
+            }
+        }
+        avs_log_async_stats_t stats_after;
+        AVS_UNIT_ASSERT_SUCCESS(avs_log_async_stats(&stats_after));
+        AVS_UNIT_ASSERT_EQUAL(stats_after.queued, stats_at_stop.queued);
+    }
+
+    for (size_t i = 0; i < CONCURRENT_PRODUCERS; ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(pthread_join(producers[i], NULL));
+    }
+
+    avs_log_async_stats_t stats;
+    AVS_UNIT_ASSERT_SUCCESS(avs_log_async_stats(&stats));
+    AVS_UNIT_ASSERT_EQUAL(atomic_load(&HANDLED_MESSAGES),
+                          CONCURRENT_PRODUCERS * MESSAGES_PER_PRODUCER
+                                  - (stats.dropped - stats_before.dropped));
+
+    reset_everything();
+}
+#    endif // AVS_COMMONS_COMPAT_THREADING_WITH_PTHREAD
+#endif // AVS_COMMONS_LOG_WITH_ASYNC
+
 AVS_UNIT_TEST(log, truncated) {
 #define LOG_MSG "log to be truncated"
 #define TEST_BUF_SIZE 32
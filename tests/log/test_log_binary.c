@@ -0,0 +1,287 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avsystem/commons/avs_log.h>
+#include <avsystem/commons/avs_unit_test.h>
+
+#include <stdio.h>
+
+static uint8_t WRITTEN[1024];
+static size_t WRITTEN_SIZE;
+
+static void test_writer(const void *data, size_t size, void *arg) {
+    AVS_UNIT_ASSERT_TRUE(arg == WRITTEN);
+    AVS_UNIT_ASSERT_TRUE(WRITTEN_SIZE + size <= sizeof(WRITTEN));
+    memcpy(WRITTEN + WRITTEN_SIZE, data, size);
+    WRITTEN_SIZE += size;
+}
+
+typedef struct {
+    uint8_t data[1024];
+    size_t size;
+} expected_t;
+
+static void expect_bytes(expected_t *expected, const void *data, size_t size) {
+    AVS_UNIT_ASSERT_TRUE(expected->size + size <= sizeof(expected->data));
+    memcpy(expected->data + expected->size, data, size);
+    expected->size += size;
+}
+
+static void expect_varint(expected_t *expected, uint64_t value) {
+    do {
+        uint8_t byte = (uint8_t) ((value & 0x7F) | (value > 0x7F ? 0x80 : 0));
+        expect_bytes(expected, &byte, 1);
+        value >>= 7;
+    } while (value);
+}
+
+static void expect_string(expected_t *expected, const char *str) {
+    expect_varint(expected, strlen(str));
+    expect_bytes(expected, str, strlen(str));
+}
+
+static void expect_record(expected_t *expected,
+                          uint8_t type,
+                          const expected_t *payload) {
+    expect_varint(expected, type);
+    expect_varint(expected, payload->size);
+    expect_bytes(expected, payload->data, payload->size);
+}
+
+static void expect_string_def(expected_t *expected,
+                              uint64_t id,
+                              const char *str) {
+    expected_t payload = { .size = 0 };
+    expect_varint(&payload, id);
+    expect_string(&payload, str);
+    expect_record(expected, AVS_LOG_BINARY_STRING, &payload);
+}
+
+static void expect_message_header(expected_t *payload,
+                                  avs_log_level_t level,
+                                  uint64_t module_id,
+                                  uint64_t file_id,
+                                  unsigned line,
+                                  uint64_t msg_id) {
+    expect_varint(payload, (uint64_t) level);
+    expect_varint(payload, module_id);
+    expect_varint(payload, file_id);
+    expect_varint(payload, line);
+    expect_varint(payload, msg_id);
+}
+
+#define ASSERT_WRITTEN(Expected)                                     \
+    do {                                                             \
+        AVS_UNIT_ASSERT_EQUAL(WRITTEN_SIZE, (Expected)->size);       \
+        AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(WRITTEN, (Expected)->data, \
+                                          (Expected)->size);         \
+        WRITTEN_SIZE = 0;                                            \
+    } while (0)
+
+#define BINARY_FORMAT "x=%d s=%s"
+
+enum { BINARY_MESSAGE_LINE = __LINE__ + 3 };
+
+static void log_binary_message(int x, const char *s) {
+    avs_log(binary_test, INFO, BINARY_FORMAT, x, s);
+}
+
+AVS_UNIT_TEST(log_binary, strings_sent_once) {
+    WRITTEN_SIZE = 0;
+    AVS_UNIT_ASSERT_SUCCESS(avs_log_set_binary_writer(test_writer, WRITTEN));
+
+    expected_t expected = { .size = 0 };
+    expect_bytes(&expected, AVS_LOG_BINARY_MAGIC, 4);
+    expect_varint(&expected, AVS_LOG_BINARY_VERSION);
+    ASSERT_WRITTEN(&expected);
+
+    log_binary_message(-3, "ab");
+    expected.size = 0;
+    expect_string_def(&expected, 1, "binary_test");
+    expect_string_def(&expected, 2, __FILE__);
+    expect_string_def(&expected, 3, BINARY_FORMAT);
+    expected_t payload = { .size = 0 };
+    expect_message_header(&payload, AVS_LOG_INFO, 1, 2, BINARY_MESSAGE_LINE,
+                          3);
+    expect_varint(&payload, 5);
+    expect_string(&payload, "ab");
+    expect_record(&expected, AVS_LOG_BINARY_MESSAGE, &payload);
+    ASSERT_WRITTEN(&expected);
+
+    log_binary_message(64, "");
+    expected.size = 0;
+    payload.size = 0;
+    expect_message_header(&payload, AVS_LOG_INFO, 1, 2, BINARY_MESSAGE_LINE,
+                          3);
+    expect_varint(&payload, 128);
+    expect_string(&payload, "");
+    expect_record(&expected, AVS_LOG_BINARY_MESSAGE, &payload);
+    ASSERT_WRITTEN(&expected);
+
+    /* messages below the module's level are not written */
+    avs_log(binary_test, DEBUG, "Not written");
+    AVS_UNIT_ASSERT_EQUAL(WRITTEN_SIZE, 0);
+
+    /* a new stream sends all strings again */
+    AVS_UNIT_ASSERT_SUCCESS(avs_log_set_binary_writer(test_writer, WRITTEN));
+    WRITTEN_SIZE = 0;
+    log_binary_message(0, NULL);
+    expected.size = 0;
+    expect_string_def(&expected, 1, "binary_test");
+    expect_string_def(&expected, 2, __FILE__);
+    expect_string_def(&expected, 3, BINARY_FORMAT);
+    payload.size = 0;
+    expect_message_header(&payload, AVS_LOG_INFO, 1, 2, BINARY_MESSAGE_LINE,
+                          3);
+    expect_varint(&payload, 0);
+    expect_string(&payload, "(null)");
+    expect_record(&expected, AVS_LOG_BINARY_MESSAGE, &payload);
+    ASSERT_WRITTEN(&expected);
+
+    avs_log_reset();
+    AVS_UNIT_ASSERT_EQUAL(WRITTEN_SIZE, 0);
+}
+
+#define ARGUMENTS_FORMAT "%hhd|%-5llu|%*d|%.*f|%.3s|%c|%%|%p|%n|%zx"
+
+AVS_UNIT_TEST(log_binary, arguments) {
+    int count;
+    WRITTEN_SIZE = 0;
+    AVS_UNIT_ASSERT_SUCCESS(avs_log_set_binary_writer(test_writer, WRITTEN));
+    WRITTEN_SIZE = 0;
+
+    const unsigned line = __LINE__ + 1;
+    avs_log(binary_test, ERROR, ARGUMENTS_FORMAT, 300,
+            (unsigned long long) UINT64_MAX, 4, -7, 2, 0.5, "abcdef", 'Z',
+            (void *) (uintptr_t) 0x1234, &count, (size_t) 300);
+
+    expected_t expected = { .size = 0 };
+    expect_string_def(&expected, 1, "binary_test");
+    expect_string_def(&expected, 2, __FILE__);
+    expect_string_def(&expected, 3, ARGUMENTS_FORMAT);
+    expected_t payload = { .size = 0 };
+    expect_message_header(&payload, AVS_LOG_ERROR, 1, 2, line, 3);
+    /* %hhd: 300 truncated to signed char is 44, zigzag-encoded */
+    expect_varint(&payload, 88);
+    /* %-5llu */
+    expect_varint(&payload, UINT64_MAX);
+    /* %*d: width 4, then -7 */
+    expect_varint(&payload, 8);
+    expect_varint(&payload, 13);
+    /* %.*f: precision 2, then 0.5 as a little-endian double */
+    expect_varint(&payload, 4);
+    expect_bytes(&payload, "\x00\x00\x00\x00\x00\x00\xE0\x3F", 8);
+    /* %.3s */
+    expect_string(&payload, "abc");
+    /* %c */
+    expect_varint(&payload, 2 * 'Z');
+    /* %p */
+    expect_varint(&payload, 0x1234);
+    /* %zx */
+    expect_varint(&payload, 300);
+    expect_record(&expected, AVS_LOG_BINARY_MESSAGE, &payload);
+    ASSERT_WRITTEN(&expected);
+
+    avs_log_reset();
+}
+
+static int write_binary_message(avs_log_binary_t *binary,
+                                const char *module,
+                                const char *msg,
+                                ...) {
+    va_list ap;
+    va_start(ap, msg);
+    int result = _avs_log_binary_write_v(binary, AVS_LOG_INFO, module,
+                                         "file.c", 1, msg, ap);
+    va_end(ap);
+    return result;
+}
+
+AVS_UNIT_TEST(log_binary, strings_compared_by_contents) {
+    avs_log_binary_t binary;
+    memset(&binary, 0, sizeof(binary));
+    _avs_log_binary_start(&binary, test_writer, WRITTEN);
+    WRITTEN_SIZE = 0;
+
+    char module[] = "module";
+    char same_module[] = "module";
+    AVS_UNIT_ASSERT_SUCCESS(write_binary_message(&binary, module, "msg"));
+    expected_t expected = { .size = 0 };
+    expect_string_def(&expected, 1, "module");
+    expect_string_def(&expected, 2, "file.c");
+    expect_string_def(&expected, 3, "msg");
+    expected_t payload = { .size = 0 };
+    expect_message_header(&payload, AVS_LOG_INFO, 1, 2, 1, 3);
+    expect_record(&expected, AVS_LOG_BINARY_MESSAGE, &payload);
+    ASSERT_WRITTEN(&expected);
+
+    /* the same contents at a different address are not sent again */
+    AVS_UNIT_ASSERT_SUCCESS(write_binary_message(&binary, same_module, "msg"));
+    expected.size = 0;
+    expect_record(&expected, AVS_LOG_BINARY_MESSAGE, &payload);
+    ASSERT_WRITTEN(&expected);
+
+    /* different contents at the same address are */
+    strcpy(module, "other");
+    AVS_UNIT_ASSERT_SUCCESS(write_binary_message(&binary, module, "msg"));
+    expected.size = 0;
+    expect_string_def(&expected, 4, "other");
+    payload.size = 0;
+    expect_message_header(&payload, AVS_LOG_INFO, 4, 2, 1, 3);
+    expect_record(&expected, AVS_LOG_BINARY_MESSAGE, &payload);
+    ASSERT_WRITTEN(&expected);
+
+    _avs_log_binary_start(&binary, NULL, NULL);
+    AVS_UNIT_ASSERT_NULL(binary.strings);
+}
+
+AVS_UNIT_TEST(log_binary, string_table_bounded) {
+    avs_log_binary_t binary;
+    memset(&binary, 0, sizeof(binary));
+    _avs_log_binary_start(&binary, test_writer, WRITTEN);
+
+    for (unsigned i = 0; i < 2 * MAX_STRINGS; ++i) {
+        char msg[16];
+        snprintf(msg, sizeof(msg), "msg %u", i);
+        WRITTEN_SIZE = 0;
+        AVS_UNIT_ASSERT_SUCCESS(write_binary_message(&binary, "module", msg));
+        AVS_UNIT_ASSERT_TRUE(binary.strings_count <= MAX_STRINGS);
+        AVS_UNIT_ASSERT_TRUE(binary.strings_size <= MAX_STRINGS_SIZE);
+    }
+
+    /* after the table has been cleared, IDs are reused and all strings used
+     * by a message are defined again before it */
+    binary.strings_count = MAX_STRINGS - 1;
+    WRITTEN_SIZE = 0;
+    AVS_UNIT_ASSERT_SUCCESS(write_binary_message(&binary, "module", "last"));
+    AVS_UNIT_ASSERT_EQUAL(binary.strings_count, 3);
+    expected_t expected = { .size = 0 };
+    expect_string_def(&expected, 1, "module");
+    expect_string_def(&expected, 2, "file.c");
+    expect_string_def(&expected, 3, "last");
+    expected_t payload = { .size = 0 };
+    expect_message_header(&payload, AVS_LOG_INFO, 1, 2, 1, 3);
+    expect_record(&expected, AVS_LOG_BINARY_MESSAGE, &payload);
+    ASSERT_WRITTEN(&expected);
+
+    /* strings that would not fit even in an empty table are rejected */
+    static char huge[MAX_STRINGS_SIZE + 1];
+    memset(huge, 'x', sizeof(huge) - 1);
+    AVS_UNIT_ASSERT_FAILED(write_binary_message(&binary, "module", huge));
+    AVS_UNIT_ASSERT_EQUAL(WRITTEN_SIZE, 0);
+
+    _avs_log_binary_start(&binary, NULL, NULL);
+}
@@ -0,0 +1,261 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fork_client.h"
+
+#include <avsystem/commons/avs_net_poller.h>
+#include <avsystem/commons/avs_utils.h>
+
+#ifdef AVS_COMMONS_NET_WITH_HANDSHAKE_POOL
+#    include <avsystem/commons/avs_net_handshake_pool.h>
+#    ifdef AVS_COMMONS_COMPAT_THREADING_WITH_PTHREAD
+#        define WITH_WORKER_TESTS
+#        include <pthread.h>
+#    endif // AVS_COMMONS_COMPAT_THREADING_WITH_PTHREAD
+#endif     // AVS_COMMONS_NET_WITH_HANDSHAKE_POOL
+
+#define CONNECTIONS 8
+
+static void spawn_clients(const char *port, pid_t *children) {
+    for (size_t i = 0; i < CONNECTIONS; ++i) {
+        children[i] = spawn_tls_client(port, 1);
+    }
+}
+
+static void wait_for_clients(const pid_t *children) {
+    for (size_t i = 0; i < CONNECTIONS; ++i) {
+        wait_for_client(children[i]);
+    }
+}
+
+/**
+ * Acts on the result of avs_net_socket_decorate_async() or
+ * avs_net_socket_handshake_continue(). Returns true if the socket is done.
+ */
+static bool handle_handshake_result(avs_net_poller_t *poller,
+                                    avs_net_socket_t **ssl_socket,
+                                    avs_error_t err) {
+    if (is_errno(err, AVS_EAGAIN)) {
+        avs_error_t add_err =
+                avs_net_poller_add(poller, *ssl_socket, AVS_NET_POLLER_READ,
+                                   NULL);
+        if (!is_errno(add_err, AVS_EEXIST)) {
+            AVS_UNIT_ASSERT_SUCCESS(add_err);
+        }
+        return false;
+    }
+    // no readiness to wait for until the step is reported as completed
+    (void) avs_net_poller_remove(poller, *ssl_socket);
+    if (is_errno(err, AVS_EINPROGRESS)) {
+        return false;
+    }
+    AVS_UNIT_ASSERT_SUCCESS(err);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(*ssl_socket, "!", 1));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(ssl_socket));
+    return true;
+}
+
+/**
+ * Accepts CONNECTIONS clients and performs all the handshakes concurrently,
+ * in a single thread, using @p pool if not NULL.
+ */
+static void serve_async(tls_server_env_t *env, avs_net_handshake_pool_t *pool) {
+    avs_net_poller_t *poller = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_create(&poller));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_add(poller, env->listener,
+                                               AVS_NET_POLLER_READ, NULL));
+#ifdef AVS_COMMONS_NET_WITH_HANDSHAKE_POOL
+    if (pool) {
+        AVS_UNIT_ASSERT_SUCCESS(
+                avs_net_poller_add(poller,
+                                   avs_net_handshake_pool_notifier(pool),
+                                   AVS_NET_POLLER_READ, NULL));
+    }
+#endif // AVS_COMMONS_NET_WITH_HANDSHAKE_POOL
+
+    size_t accepted = 0;
+    size_t done = 0;
+    while (done < CONNECTIONS) {
+        avs_net_poller_event_t events[CONNECTIONS + 2];
+        size_t count;
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_wait(
+                poller, events, AVS_ARRAY_SIZE(events), &count,
+                avs_time_duration_from_scalar(10, AVS_TIME_S)));
+        AVS_UNIT_ASSERT_NOT_EQUAL(count, 0);
+        for (size_t i = 0; i < count; ++i) {
+            avs_net_socket_t *socket = events[i].socket;
+            if (socket == env->listener) {
+                AVS_UNIT_ASSERT_TRUE(accepted < CONNECTIONS);
+                ++accepted;
+                avs_net_socket_t *tcp_socket = tls_server_accept_tcp(env);
+                avs_net_socket_t *ssl_socket = tls_server_create_socket(env);
+                if (handle_handshake_result(
+                            poller, &ssl_socket,
+                            avs_net_socket_decorate_async(
+                                    ssl_socket, tcp_socket, pool))) {
+                    ++done;
+                }
+                continue;
+            }
+#ifdef AVS_COMMONS_NET_WITH_HANDSHAKE_POOL
+            if (pool && socket == avs_net_handshake_pool_notifier(pool)) {
+                avs_net_socket_t *completed[CONNECTIONS];
+                size_t completed_count = avs_net_handshake_pool_get_completed(
+                        pool, completed, AVS_ARRAY_SIZE(completed));
+                for (size_t j = 0; j < completed_count; ++j) {
+                    if (handle_handshake_result(
+                                poller, &completed[j],
+                                avs_net_socket_handshake_continue(
+                                        completed[j]))) {
+                        ++done;
+                    }
+                }
+                continue;
+            }
+#endif // AVS_COMMONS_NET_WITH_HANDSHAKE_POOL
+            if (handle_handshake_result(
+                        poller, &socket,
+                        avs_net_socket_handshake_continue(socket))) {
+                ++done;
+            }
+        }
+    }
+    AVS_UNIT_ASSERT_EQUAL(accepted, CONNECTIONS);
+    avs_net_poller_cleanup(&poller);
+}
+
+AVS_UNIT_TEST(async_handshake, inline) {
+    tls_server_env_t env;
+    tls_server_env_init(&env, NULL);
+    pid_t children[CONNECTIONS];
+    spawn_clients(env.port, children);
+    serve_async(&env, NULL);
+    wait_for_clients(children);
+    tls_server_env_cleanup(&env);
+}
+
+AVS_UNIT_TEST(async_handshake, not_decorated) {
+    tls_server_env_t env;
+    tls_server_env_init(&env, NULL);
+    avs_net_socket_t *ssl_socket = tls_server_create_socket(&env);
+    avs_error_t err = avs_net_socket_handshake_continue(ssl_socket);
+    AVS_UNIT_ASSERT_TRUE(is_errno(err, AVS_EBADF));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&ssl_socket));
+    tls_server_env_cleanup(&env);
+}
+
+AVS_UNIT_TEST(async_handshake, not_connected) {
+    tls_server_env_t env;
+    tls_server_env_init(&env, NULL);
+    avs_net_socket_t *tcp_socket = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(&tcp_socket, NULL));
+    avs_net_socket_t *ssl_socket = tls_server_create_socket(&env);
+    avs_error_t err =
+            avs_net_socket_decorate_async(ssl_socket, tcp_socket, NULL);
+    AVS_UNIT_ASSERT_TRUE(is_errno(err, AVS_ENOTCONN));
+    // not taken over by the SSL socket
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&tcp_socket));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&ssl_socket));
+    tls_server_env_cleanup(&env);
+}
+
+#ifdef AVS_COMMONS_NET_WITH_HANDSHAKE_POOL
+#    ifdef WITH_WORKER_TESTS
+#        define WORKERS 2
+
+static void *worker_thread(void *pool) {
+    avs_net_handshake_pool_worker_run((avs_net_handshake_pool_t *) pool);
+    return NULL;
+}
+
+AVS_UNIT_TEST(async_handshake, pool) {
+    tls_server_env_t env;
+    tls_server_env_init(&env, NULL);
+    pid_t children[CONNECTIONS];
+    spawn_clients(env.port, children);
+
+    avs_net_handshake_pool_t *pool = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_handshake_pool_create(&pool));
+    pthread_t threads[WORKERS];
+    for (size_t i = 0; i < WORKERS; ++i) {
+        AVS_UNIT_ASSERT_EQUAL(
+                pthread_create(&threads[i], NULL, worker_thread, pool), 0);
+    }
+
+    serve_async(&env, pool);
+
+    AVS_UNIT_ASSERT_EQUAL(avs_net_handshake_pool_workers_stop(pool), 0);
+    for (size_t i = 0; i < WORKERS; ++i) {
+        AVS_UNIT_ASSERT_EQUAL(pthread_join(threads[i], NULL), 0);
+    }
+    avs_net_handshake_pool_cleanup(&pool);
+    wait_for_clients(children);
+    tls_server_env_cleanup(&env);
+}
+#    endif // WITH_WORKER_TESTS
+
+AVS_UNIT_TEST(async_handshake, stopped_pool) {
+    tls_server_env_t env;
+    tls_server_env_init(&env, NULL);
+    avs_net_handshake_pool_t *pool = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_handshake_pool_create(&pool));
+    AVS_UNIT_ASSERT_EQUAL(avs_net_handshake_pool_workers_stop(pool), 0);
+
+    avs_net_socket_t *client = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(&client, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_connect(client, "127.0.0.1", env.port));
+    avs_net_socket_t *tcp_socket = tls_server_accept_tcp(&env);
+    avs_net_socket_t *ssl_socket = tls_server_create_socket(&env);
+    avs_error_t err =
+            avs_net_socket_decorate_async(ssl_socket, tcp_socket, pool);
+    AVS_UNIT_ASSERT_TRUE(is_errno(err, AVS_EINTR));
+    // not taken over by the SSL socket
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&tcp_socket));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&ssl_socket));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&client));
+    avs_net_handshake_pool_cleanup(&pool);
+    tls_server_env_cleanup(&env);
+}
+
+AVS_UNIT_TEST(async_handshake, cleanup_while_queued) {
+    tls_server_env_t env;
+    tls_server_env_init(&env, NULL);
+    avs_net_handshake_pool_t *pool = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_handshake_pool_create(&pool));
+
+    avs_net_socket_t *client = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(&client, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_connect(client, "127.0.0.1", env.port));
+    avs_net_socket_t *ssl_socket = tls_server_create_socket(&env);
+    avs_error_t err = avs_net_socket_decorate_async(
+            ssl_socket, tls_server_accept_tcp(&env), pool);
+    // there are no workers, so the step stays queued
+    AVS_UNIT_ASSERT_TRUE(is_errno(err, AVS_EINPROGRESS));
+    err = avs_net_socket_handshake_continue(ssl_socket);
+    AVS_UNIT_ASSERT_TRUE(is_errno(err, AVS_EINPROGRESS));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&ssl_socket));
+
+    avs_net_socket_t *completed[1];
+    AVS_UNIT_ASSERT_EQUAL(
+            avs_net_handshake_pool_get_completed(pool, completed, 1), 0);
+    AVS_UNIT_ASSERT_EQUAL(avs_net_handshake_pool_workers_stop(pool), 0);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&client));
+    avs_net_handshake_pool_cleanup(&pool);
+    tls_server_env_cleanup(&env);
+}
+#endif // AVS_COMMONS_NET_WITH_HANDSHAKE_POOL
@@ -0,0 +1,183 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include <avsystem/commons/avs_unit_mocksock.h>
+
+#include "socket_common.h"
+
+AVS_UNIT_TEST(socket_batch, udp_roundtrip) {
+    avs_net_socket_t *server = NULL;
+    avs_net_socket_t *client = NULL;
+    create_udp_pair(&client, &server);
+
+    static const char *const PAYLOADS[] = { "a", "bb", "ccc", "dddd", "" };
+    avs_net_socket_outgoing_datagram_t out[AVS_ARRAY_SIZE(PAYLOADS)];
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(PAYLOADS); ++i) {
+        out[i].data = PAYLOADS[i];
+        out[i].data_length = strlen(PAYLOADS[i]);
+        out[i].host = NULL;
+        out[i].port = NULL;
+    }
+    size_t sent;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send_batch(
+            client, out, AVS_ARRAY_SIZE(out), &sent));
+    AVS_UNIT_ASSERT_EQUAL(sent, AVS_ARRAY_SIZE(out));
+
+    char client_port[16];
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_local_port(
+            client, client_port, sizeof(client_port)));
+
+    char buffers[8][4];
+    char hosts[8][64];
+    char ports[8][8];
+    avs_net_socket_received_datagram_t in[8];
+    memset(in, 0, sizeof(in));
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(in); ++i) {
+        in[i].buffer = buffers[i];
+        in[i].buffer_length = sizeof(buffers[i]);
+        in[i].host = hosts[i];
+        in[i].host_size = sizeof(hosts[i]);
+        in[i].port = ports[i];
+        in[i].port_size = sizeof(ports[i]);
+    }
+    size_t received;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_receive_batch(
+            server, in, AVS_ARRAY_SIZE(in), &received));
+    AVS_UNIT_ASSERT_EQUAL(received, AVS_ARRAY_SIZE(PAYLOADS));
+    for (size_t i = 0; i < received; ++i) {
+        AVS_UNIT_ASSERT_EQUAL(in[i].bytes_received, strlen(PAYLOADS[i]));
+        AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buffers[i], PAYLOADS[i],
+                                          in[i].bytes_received);
+        AVS_UNIT_ASSERT_FALSE(in[i].truncated);
+        AVS_UNIT_ASSERT_EQUAL_STRING(ports[i], client_port);
+    }
+
+    // reply to the sender, using the reported address
+    out[0].host = hosts[0];
+    out[0].port = ports[0];
+    out[1].host = hosts[1];
+    out[1].port = ports[1];
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send_batch(server, out, 2, NULL));
+
+    // datagram longer than the buffer, without sender address
+    in[1].buffer_length = 1;
+    in[1].host = NULL;
+    in[1].port = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_receive_batch(client, in, 2, &received));
+    AVS_UNIT_ASSERT_EQUAL(received, 2);
+    AVS_UNIT_ASSERT_EQUAL(in[0].bytes_received, 1);
+    AVS_UNIT_ASSERT_FALSE(in[0].truncated);
+    AVS_UNIT_ASSERT_EQUAL(in[1].bytes_received, 1);
+    AVS_UNIT_ASSERT_TRUE(in[1].truncated);
+
+    // nothing more to receive
+    avs_net_socket_opt_value_t timeout = {
+        .recv_timeout = AVS_TIME_DURATION_ZERO
+    };
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_set_opt(
+            server, AVS_NET_SOCKET_OPT_RECV_TIMEOUT, timeout));
+    avs_error_t err = avs_net_socket_receive_batch(server, in, 1, &received);
+    AVS_UNIT_ASSERT_EQUAL(err.code, AVS_ETIMEDOUT);
+    AVS_UNIT_ASSERT_EQUAL(received, 0);
+
+    avs_net_socket_opt_value_t bytes;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_opt(
+            client, AVS_NET_SOCKET_OPT_BYTES_SENT, &bytes));
+    AVS_UNIT_ASSERT_EQUAL(bytes.bytes_sent, 10);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_opt(
+            server, AVS_NET_SOCKET_OPT_BYTES_RECEIVED, &bytes));
+    AVS_UNIT_ASSERT_EQUAL(bytes.bytes_received, 10);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&server));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&client));
+}
+
+AVS_UNIT_TEST(socket_batch, send_unresolvable) {
+    avs_net_socket_t *socket = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_udp_socket_create(&socket, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_bind(socket, DEFAULT_ADDRESS, DEFAULT_PORT));
+    char port[16];
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_get_local_port(socket, port, sizeof(port)));
+
+    const avs_net_socket_outgoing_datagram_t out[] = {
+        { "a", 1, DEFAULT_ADDRESS, port },
+        { "b", 1, DEFAULT_ADDRESS, port },
+        { "c", 1, DEFAULT_ADDRESS, "no such port" }
+    };
+    size_t sent;
+    avs_error_t err =
+            avs_net_socket_send_batch(socket, out, AVS_ARRAY_SIZE(out), &sent);
+    AVS_UNIT_ASSERT_EQUAL(err.code, AVS_EADDRNOTAVAIL);
+    AVS_UNIT_ASSERT_EQUAL(sent, 2);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&socket));
+}
+
+AVS_UNIT_TEST(socket_batch, fallback) {
+    // mock sockets do not implement batch operations natively
+    avs_net_socket_t *socket = NULL;
+    avs_unit_mocksock_create_datagram(&socket);
+    avs_unit_mocksock_enable_recv_timeout_getsetopt(
+            socket, avs_time_duration_from_scalar(30, AVS_TIME_S));
+    avs_unit_mocksock_expect_connect(socket, "host", "1234");
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_connect(socket, "host", "1234"));
+
+    avs_unit_mocksock_expect_output(socket, "x", 1);
+    avs_unit_mocksock_expect_output(socket, "yz", 2);
+    const avs_net_socket_outgoing_datagram_t out[] = {
+        { "x", 1, NULL, NULL },
+        { "yz", 2, NULL, NULL }
+    };
+    size_t sent;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send_batch(
+            socket, out, AVS_ARRAY_SIZE(out), &sent));
+    AVS_UNIT_ASSERT_EQUAL(sent, 2);
+
+    avs_unit_mocksock_input(socket, "a", 1);
+    avs_unit_mocksock_input(socket, "bcd", 3);
+    avs_unit_mocksock_input_fail(socket, avs_errno(AVS_ETIMEDOUT));
+    char buffers[3][2];
+    avs_net_socket_received_datagram_t in[3];
+    memset(in, 0, sizeof(in));
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(in); ++i) {
+        in[i].buffer = buffers[i];
+        in[i].buffer_length = sizeof(buffers[i]);
+    }
+    size_t received;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_receive_batch(
+            socket, in, AVS_ARRAY_SIZE(in), &received));
+    AVS_UNIT_ASSERT_EQUAL(received, 2);
+    AVS_UNIT_ASSERT_EQUAL(in[0].bytes_received, 1);
+    AVS_UNIT_ASSERT_FALSE(in[0].truncated);
+    AVS_UNIT_ASSERT_EQUAL(in[1].bytes_received, 2);
+    AVS_UNIT_ASSERT_TRUE(in[1].truncated);
+
+    // the original receive timeout shall be restored
+    avs_net_socket_opt_value_t timeout;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_opt(
+            socket, AVS_NET_SOCKET_OPT_RECV_TIMEOUT, &timeout));
+    AVS_UNIT_ASSERT_TRUE(avs_time_duration_equal(
+            timeout.recv_timeout,
+            avs_time_duration_from_scalar(30, AVS_TIME_S)));
+
+    avs_unit_mocksock_assert_io_clean(socket);
+    avs_net_socket_cleanup(&socket);
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fork_client.h"
+
+#include <avsystem/commons/avs_net_dtls_server.h>
+#include <avsystem/commons/avs_utils.h>
+
+#define CLIENTS 4
+#define MESSAGE "hello"
+
+typedef struct {
+    avs_net_dtls_server_t *server;
+    char port[16];
+} server_env_t;
+
+static void server_env_init(server_env_t *env,
+                            size_t max_peers,
+                            avs_net_dtls_server_psk_lookup_t *psk_lookup) {
+    memset(env, 0, sizeof(*env));
+    avs_net_dtls_server_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.max_peers = max_peers;
+    config.psk = (avs_net_psk_info_t) {
+        .key = avs_crypto_psk_key_info_from_buffer(DEFAULT_PSK,
+                                                   sizeof(DEFAULT_PSK) - 1),
+        .identity = avs_crypto_psk_identity_info_from_buffer(
+                DEFAULT_IDENTITY, sizeof(DEFAULT_IDENTITY) - 1)
+    };
+    config.psk_lookup = psk_lookup;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_dtls_server_create(&env->server, &config));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_dtls_server_bind(env->server, "127.0.0.1", "0"));
+    avs_net_socket_t *socket = avs_net_dtls_server_socket(env->server);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_local_port(socket, env->port,
+                                                          sizeof(env->port)));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_set_opt(
+            socket, AVS_NET_SOCKET_OPT_RECV_TIMEOUT,
+            (avs_net_socket_opt_value_t) {
+                .recv_timeout = avs_time_duration_from_scalar(100, AVS_TIME_MS)
+            }));
+}
+
+/**
+ * Runs in a child process: connects to the server using an ordinary tinyDTLS
+ * client socket, and expects MESSAGE to be echoed back.
+ */
+static int run_dtls_client(const char *port, void *arg) {
+    (void) arg;
+    avs_net_ssl_configuration_t config = create_default_ssl_config();
+    avs_net_socket_t *socket = NULL;
+    char buffer[sizeof(MESSAGE)];
+    size_t received = 0;
+    int result = 0;
+    if (avs_is_err(avs_net_dtls_socket_create(&socket, &config))
+            || avs_is_err(avs_net_socket_connect(socket, "127.0.0.1", port))
+            || avs_is_err(avs_net_socket_send(socket, MESSAGE,
+                                              sizeof(MESSAGE) - 1))
+            || avs_is_err(avs_net_socket_receive(socket, &received, buffer,
+                                                 sizeof(buffer)))
+            || received != sizeof(MESSAGE) - 1
+            || memcmp(buffer, MESSAGE, received)) {
+        result = -1;
+    }
+    avs_net_socket_cleanup(&socket);
+    cleanup_default_ssl_config(&config);
+    return result;
+}
+
+static int run_rejected_dtls_client(const char *port, void *arg) {
+    return !run_dtls_client(port, arg);
+}
+
+AVS_UNIT_TEST(dtls_server, invalid_config) {
+    avs_net_dtls_server_t *server = NULL;
+    avs_net_dtls_server_config_t config;
+    memset(&config, 0, sizeof(config));
+    AVS_UNIT_ASSERT_TRUE(
+            is_errno(avs_net_dtls_server_create(&server, &config), AVS_EINVAL));
+    AVS_UNIT_ASSERT_NULL(server);
+}
+
+AVS_UNIT_TEST(dtls_server, idle) {
+    server_env_t env;
+    server_env_init(&env, 1, NULL);
+    AVS_UNIT_ASSERT_FALSE(avs_time_monotonic_valid(
+            avs_net_dtls_server_next_timeout(env.server)));
+    avs_net_socket_t *peer = NULL;
+    int events;
+    AVS_UNIT_ASSERT_TRUE(
+            is_errno(avs_net_dtls_server_process(env.server, &peer, &events),
+                     AVS_ETIMEDOUT));
+    AVS_UNIT_ASSERT_NULL(peer);
+    AVS_UNIT_ASSERT_EQUAL(events, 0);
+    avs_net_dtls_server_cleanup(&env.server);
+}
+
+AVS_UNIT_TEST(dtls_server, echo) {
+    server_env_t env;
+    server_env_init(&env, CLIENTS, NULL);
+    pid_t children[CLIENTS];
+    for (size_t i = 0; i < CLIENTS; ++i) {
+        children[i] = spawn_client(run_dtls_client, env.port, NULL);
+    }
+
+    avs_net_socket_t *peers[CLIENTS];
+    size_t peer_count = 0;
+    size_t echoed = 0;
+    size_t idle_rounds = 0;
+    while (echoed < CLIENTS) {
+        avs_net_socket_t *peer = NULL;
+        int events;
+        avs_error_t err =
+                avs_net_dtls_server_process(env.server, &peer, &events);
+        if (is_errno(err, AVS_ETIMEDOUT)) {
+            AVS_UNIT_ASSERT_TRUE(++idle_rounds < 100);
+            avs_net_dtls_server_next_timeout(env.server);
+            continue;
+        }
+        AVS_UNIT_ASSERT_SUCCESS(err);
+        if (!peer) {
+            AVS_UNIT_ASSERT_EQUAL(events, 0);
+            continue;
+        }
+        AVS_UNIT_ASSERT_FALSE(events & AVS_NET_DTLS_SERVER_PEER_CLOSED);
+
+        bool known = false;
+        for (size_t i = 0; i < peer_count; ++i) {
+            known = known || peers[i] == peer;
+        }
+        AVS_UNIT_ASSERT_EQUAL(known, !(events & AVS_NET_DTLS_SERVER_PEER_NEW));
+        if (!known) {
+            AVS_UNIT_ASSERT_TRUE(peer_count < CLIENTS);
+            peers[peer_count++] = peer;
+            avs_net_socket_opt_value_t state;
+            AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_opt(
+                    peer, AVS_NET_SOCKET_OPT_STATE, &state));
+            AVS_UNIT_ASSERT_EQUAL(state.state, AVS_NET_SOCKET_STATE_ACCEPTED);
+        }
+
+        char buffer[64];
+        size_t received;
+        err = avs_net_socket_receive(peer, &received, buffer, sizeof(buffer));
+        if (!(events & AVS_NET_DTLS_SERVER_PEER_DATA)) {
+            AVS_UNIT_ASSERT_TRUE(is_errno(err, AVS_ETIMEDOUT));
+            continue;
+        }
+        AVS_UNIT_ASSERT_SUCCESS(err);
+        AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buffer, MESSAGE, received);
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(peer, buffer, received));
+        // the record is only delivered once
+        AVS_UNIT_ASSERT_TRUE(is_errno(
+                avs_net_socket_receive(peer, &received, buffer, sizeof(buffer)),
+                AVS_ETIMEDOUT));
+        ++echoed;
+    }
+
+    for (size_t i = 0; i < CLIENTS; ++i) {
+        wait_for_client(children[i]);
+    }
+    for (size_t i = 0; i < peer_count; ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&peers[i]));
+    }
+    avs_net_dtls_server_cleanup(&env.server);
+}
+
+static avs_error_t reject_all(void *arg,
+                              const void *identity,
+                              size_t identity_size,
+                              void *out_key,
+                              size_t key_capacity,
+                              size_t *out_key_size) {
+    (void) arg;
+    (void) identity;
+    (void) identity_size;
+    (void) out_key;
+    (void) key_capacity;
+    (void) out_key_size;
+    return avs_errno(AVS_ENOENT);
+}
+
+AVS_UNIT_TEST(dtls_server, unknown_identity) {
+    server_env_t env;
+    server_env_init(&env, 1, reject_all);
+    pid_t child = spawn_client(run_rejected_dtls_client, env.port, NULL);
+
+    size_t idle_rounds = 0;
+    while (idle_rounds < 20) {
+        avs_net_socket_t *peer = NULL;
+        int events;
+        avs_error_t err =
+                avs_net_dtls_server_process(env.server, &peer, &events);
+        if (is_errno(err, AVS_ETIMEDOUT)) {
+            ++idle_rounds;
+            avs_net_dtls_server_next_timeout(env.server);
+            continue;
+        }
+        AVS_UNIT_ASSERT_SUCCESS(err);
+        AVS_UNIT_ASSERT_NULL(peer);
+        AVS_UNIT_ASSERT_EQUAL(events, 0);
+    }
+
+    wait_for_client(child);
+    avs_net_dtls_server_cleanup(&env.server);
+}
@@ -0,0 +1,186 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AVS_COMMONS_TEST_FORK_CLIENT_H
+#define AVS_COMMONS_TEST_FORK_CLIENT_H
+
+/*
+ * Helpers for tests that run clients in child processes, so that they do not
+ * share any state with the server under test. Test files that are not a part
+ * of a library source file need to include this header first, for fork() and
+ * waitpid() to be declared.
+ */
+#ifndef _POSIX_C_SOURCE
+#    define _POSIX_C_SOURCE 200809L
+#endif // _POSIX_C_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <avsystem/commons/avs_socket.h>
+#include <avsystem/commons/avs_unit_test.h>
+
+#include "socket_common.h"
+
+#define SERVER_CERT_FILE "../certs/server.crt"
+#define SERVER_KEY_FILE "../certs/server.key"
+
+/**
+ * Client code to run in a child process. It shall return 0 on success.
+ */
+typedef int forked_client_t(const char *port, void *arg);
+
+static inline pid_t
+spawn_client(forked_client_t *client, const char *port, void *arg) {
+    pid_t child = fork();
+    AVS_UNIT_ASSERT_NOT_EQUAL(child, -1);
+    if (!child) {
+        _exit(client(port, arg) ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
+    return child;
+}
+
+static inline void wait_for_client(pid_t child) {
+    int status;
+    AVS_UNIT_ASSERT_EQUAL(waitpid(child, &status, 0), child);
+    AVS_UNIT_ASSERT_TRUE(WIFEXITED(status));
+    AVS_UNIT_ASSERT_EQUAL(WEXITSTATUS(status), EXIT_SUCCESS);
+}
+
+/**
+ * TLS server context using the test certificate, and a TCP socket listening
+ * for its clients on an ephemeral port on 127.0.0.1.
+ */
+typedef struct {
+    avs_crypto_prng_ctx_t *prng_ctx;
+    avs_net_ssl_context_t *context;
+    avs_net_socket_t *listener;
+    char port[16];
+} tls_server_env_t;
+
+static inline avs_net_ssl_configuration_t
+tls_server_config(avs_crypto_prng_ctx_t *prng_ctx,
+                  const avs_net_ssl_server_session_config_t *server_sessions) {
+    avs_net_ssl_configuration_t config;
+    memset(&config, 0, sizeof(config));
+    config.prng_ctx = prng_ctx;
+    config.server_sessions = server_sessions;
+    config.security = avs_net_security_info_from_certificates(
+            (avs_net_certificate_info_t) {
+                .ignore_system_trust_store = true,
+                .client_cert = avs_crypto_certificate_chain_info_from_file(
+                        SERVER_CERT_FILE),
+                .client_key = avs_crypto_private_key_info_from_file(
+                        SERVER_KEY_FILE, NULL)
+            });
+    return config;
+}
+
+static inline void
+tls_server_env_init(tls_server_env_t *env,
+                    const avs_net_ssl_server_session_config_t *server_sessions) {
+    memset(env, 0, sizeof(*env));
+    env->prng_ctx = avs_crypto_prng_new(NULL, NULL);
+    AVS_UNIT_ASSERT_NOT_NULL(env->prng_ctx);
+    const avs_net_ssl_configuration_t config =
+            tls_server_config(env->prng_ctx, server_sessions);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_ssl_context_create(&env->context, &config));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(&env->listener, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_bind(env->listener, "127.0.0.1", "0"));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_local_port(
+            env->listener, env->port, sizeof(env->port)));
+}
+
+static inline void tls_server_env_cleanup(tls_server_env_t *env) {
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&env->listener));
+    avs_net_ssl_context_cleanup(&env->context);
+    avs_crypto_prng_free(&env->prng_ctx);
+}
+
+static inline avs_net_socket_t *tls_server_accept_tcp(tls_server_env_t *env) {
+    avs_net_socket_t *tcp_socket = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(&tcp_socket, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_accept(env->listener, tcp_socket));
+    return tcp_socket;
+}
+
+static inline avs_net_socket_t *tls_server_create_socket(tls_server_env_t *env) {
+    const avs_net_ssl_configuration_t config = {
+        .context = env->context
+    };
+    avs_net_socket_t *ssl_socket = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_ssl_socket_create(&ssl_socket, &config));
+    return ssl_socket;
+}
+
+/**
+ * Accepts a client and performs a blocking handshake with it.
+ */
+static inline avs_net_socket_t *tls_server_accept(tls_server_env_t *env) {
+    avs_net_socket_t *tcp_socket = tls_server_accept_tcp(env);
+    avs_net_socket_t *ssl_socket = tls_server_create_socket(env);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_decorate(ssl_socket, tcp_socket));
+    return ssl_socket;
+}
+
+/**
+ * forked_client_t connecting <c>*(const size_t *) connections</c> times in a
+ * row, resuming the previous session if possible. Each connection reads a byte
+ * sent by the server after the handshake, so that TLS 1.3 session tickets are
+ * received as well.
+ */
+static inline int run_tls_client(const char *port, void *connections) {
+    avs_crypto_prng_ctx_t *prng_ctx = avs_crypto_prng_new(NULL, NULL);
+    char session[4096] = "";
+    avs_net_ssl_configuration_t config;
+    memset(&config, 0, sizeof(config));
+    config.prng_ctx = prng_ctx;
+    config.security = avs_net_security_info_from_certificates(
+            (avs_net_certificate_info_t) {
+                .server_cert_validation = false
+            });
+    config.session_resumption_buffer = session;
+    config.session_resumption_buffer_size = sizeof(session);
+
+    int result = prng_ctx ? 0 : -1;
+    for (size_t i = 0; !result && i < *(const size_t *) connections; ++i) {
+        avs_net_socket_t *socket = NULL;
+        char byte;
+        size_t received = 0;
+        if (avs_is_err(avs_net_ssl_socket_create(&socket, &config))
+                || avs_is_err(avs_net_socket_connect(socket, "127.0.0.1", port))
+                || avs_is_err(avs_net_socket_receive(socket, &received, &byte,
+                                                     1))
+                || received != 1) {
+            result = -1;
+        }
+        avs_net_socket_cleanup(&socket);
+    }
+    avs_crypto_prng_free(&prng_ctx);
+    return result;
+}
+
+static inline pid_t spawn_tls_client(const char *port, size_t connections) {
+    return spawn_client(run_tls_client, port, &connections);
+}
+
+#endif /* AVS_COMMONS_TEST_FORK_CLIENT_H */
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avsystem/commons/avs_unit_test.h>
+
+#include "socket_common.h"
+
+#ifdef AVS_COMMONS_COMPAT_THREADING_WITH_PTHREAD
+#    include <errno.h>
+#    include <pthread.h>
+
+/**
+ * State of blocking_step(). Plain pthread primitives are used, as
+ * avs_condvar_wait() may be mocked.
+ */
+static struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool started;
+    bool released;
+    bool finished;
+    bool finished_before_cancel_returned;
+} g_step = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER
+};
+
+/** The pool never dereferences the sockets, any unique address will do. */
+static char g_dummy_socket;
+#    define DUMMY_SOCKET ((avs_net_socket_t *) &g_dummy_socket)
+
+static void sleep_ms(int64_t ms) {
+    const avs_time_real_t deadline =
+            avs_time_real_add(avs_time_real_now(),
+                              avs_time_duration_from_scalar(ms, AVS_TIME_MS));
+    const struct timespec deadline_ts = {
+        .tv_sec = (time_t) deadline.since_real_epoch.seconds,
+        .tv_nsec = deadline.since_real_epoch.nanoseconds
+    };
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+    pthread_mutex_lock(&mutex);
+    while (pthread_cond_timedwait(&cond, &mutex, &deadline_ts) != ETIMEDOUT) {
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
+static avs_error_t blocking_step(avs_net_socket_t *socket) {
+    (void) socket;
+    pthread_mutex_lock(&g_step.mutex);
+    g_step.started = true;
+    pthread_cond_broadcast(&g_step.cond);
+    while (!g_step.released) {
+        pthread_cond_wait(&g_step.cond, &g_step.mutex);
+    }
+    pthread_mutex_unlock(&g_step.mutex);
+    // give a broken cancel a chance to return early
+    sleep_ms(20);
+    pthread_mutex_lock(&g_step.mutex);
+    g_step.finished = true;
+    pthread_mutex_unlock(&g_step.mutex);
+    return AVS_OK;
+}
+
+static void *worker_thread(void *pool) {
+    avs_net_handshake_pool_worker_run((avs_net_handshake_pool_t *) pool);
+    return NULL;
+}
+
+static void *cancel_thread(void *pool) {
+    _avs_net_handshake_pool_cancel((avs_net_handshake_pool_t *) pool,
+                                   DUMMY_SOCKET);
+    pthread_mutex_lock(&g_step.mutex);
+    g_step.finished_before_cancel_returned = g_step.finished;
+    pthread_mutex_unlock(&g_step.mutex);
+    return NULL;
+}
+
+typedef int condvar_wait_func_t(avs_condvar_t *condvar,
+                                avs_mutex_t *mutex,
+                                avs_time_monotonic_t deadline);
+
+static void test_cancel_running(condvar_wait_func_t *condvar_wait_mock) {
+    g_step.started = false;
+    g_step.released = false;
+    g_step.finished = false;
+    g_step.finished_before_cancel_returned = false;
+
+    avs_net_handshake_pool_t *pool = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_handshake_pool_create(&pool));
+    pthread_t worker;
+    AVS_UNIT_ASSERT_EQUAL(pthread_create(&worker, NULL, worker_thread, pool),
+                          0);
+    AVS_UNIT_ASSERT_SUCCESS(
+            _avs_net_handshake_pool_submit(pool, DUMMY_SOCKET, blocking_step));
+    pthread_mutex_lock(&g_step.mutex);
+    while (!g_step.started) {
+        pthread_cond_wait(&g_step.cond, &g_step.mutex);
+    }
+    pthread_mutex_unlock(&g_step.mutex);
+
+    AVS_UNIT_MOCK(avs_condvar_wait) = condvar_wait_mock;
+    pthread_t canceller;
+    AVS_UNIT_ASSERT_EQUAL(
+            pthread_create(&canceller, NULL, cancel_thread, pool), 0);
+    sleep_ms(50);
+    pthread_mutex_lock(&g_step.mutex);
+    g_step.released = true;
+    pthread_cond_broadcast(&g_step.cond);
+    pthread_mutex_unlock(&g_step.mutex);
+    AVS_UNIT_ASSERT_EQUAL(pthread_join(canceller, NULL), 0);
+    AVS_UNIT_MOCK(avs_condvar_wait) = NULL;
+    AVS_UNIT_ASSERT_TRUE(g_step.finished_before_cancel_returned);
+
+    // the job is forgotten, and not reported as completed
+    avs_error_t err;
+    AVS_UNIT_ASSERT_TRUE(
+            _avs_net_handshake_pool_take_result(pool, DUMMY_SOCKET, &err));
+    AVS_UNIT_ASSERT_TRUE(is_errno(err, AVS_EBADF));
+    avs_net_socket_t *completed[1];
+    AVS_UNIT_ASSERT_EQUAL(
+            avs_net_handshake_pool_get_completed(pool, completed, 1), 0);
+
+    // the worker might have exited already if avs_condvar_wait() was failing
+    AVS_UNIT_ASSERT_EQUAL(avs_net_handshake_pool_workers_stop(pool), 0);
+    AVS_UNIT_ASSERT_EQUAL(pthread_join(worker, NULL), 0);
+    avs_net_handshake_pool_cleanup(&pool);
+}
+
+AVS_UNIT_TEST(handshake_pool, cancel_running) {
+    test_cancel_running(NULL);
+}
+
+static int failing_condvar_wait(avs_condvar_t *condvar,
+                                avs_mutex_t *mutex,
+                                avs_time_monotonic_t deadline) {
+    (void) condvar;
+    (void) mutex;
+    (void) deadline;
+    return -1;
+}
+
+AVS_UNIT_TEST(handshake_pool, cancel_running_condvar_failure) {
+    test_cancel_running(failing_condvar_wait);
+}
+#endif // AVS_COMMONS_COMPAT_THREADING_WITH_PTHREAD
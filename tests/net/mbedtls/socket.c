@@ -16,6 +16,7 @@
 
 #define DISABLE_SOCKET_OPT_TEST_CASES
 #include "../socket_common.h"
+#include "../ssl_context_testcases.h"
 
 #include <avs_commons_posix_init.h>
 
@@ -27,7 +28,7 @@ AVS_UNIT_TEST(socket, ciphersuites_psk) {
     AVS_UNIT_ASSERT_SUCCESS(avs_net_ssl_socket_create(&socket, &config));
 
     ssl_socket_t *ssl_socket = (ssl_socket_t *) socket;
-    int *ciphers = ssl_socket->effective_ciphersuites;
+    int *ciphers = ssl_socket->context->effective_ciphersuites;
 
     AVS_UNIT_ASSERT_EQUAL(ciphers[0], 0xC0A8);
     AVS_UNIT_ASSERT_EQUAL(ciphers[1], 0);
@@ -44,7 +45,7 @@ AVS_UNIT_TEST(socket, ciphersuites_cert) {
     AVS_UNIT_ASSERT_SUCCESS(avs_net_ssl_socket_create(&socket, &config));
 
     ssl_socket_t *ssl_socket = (ssl_socket_t *) socket;
-    int *ciphers = ssl_socket->effective_ciphersuites;
+    int *ciphers = ssl_socket->context->effective_ciphersuites;
 
     AVS_UNIT_ASSERT_EQUAL(ciphers[0], 0xC0AE);
     AVS_UNIT_ASSERT_EQUAL(ciphers[1], 0);
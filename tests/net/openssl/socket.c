@@ -17,7 +17,9 @@
 #include <openssl/ssl.h>
 
 #define DISABLE_SOCKET_OPT_TEST_CASES
+#include "../fork_client.h"
 #include "../socket_common.h"
+#include "../ssl_context_testcases.h"
 
 #include <avs_commons_posix_init.h>
 
@@ -30,22 +32,21 @@ AVS_UNIT_TEST(socket, ciphersuites_psk) {
 
     ssl_socket_t *ssl_socket = (ssl_socket_t *) socket;
 
-    AVS_UNIT_ASSERT_EQUAL(ssl_socket->enabled_ciphersuites.num_ids, 2);
-
-    ssl_socket->ssl = SSL_new(ssl_socket->ctx);
-    AVS_UNIT_ASSERT_NOT_NULL(ssl_socket->ssl);
-
-    AVS_UNIT_ASSERT_SUCCESS(fix_socket_ciphersuites(ssl_socket));
+    // ciphersuites are configured on the SSL_CTX, so that every SSL object
+    // created from it inherits them
+    SSL *ssl = SSL_new(ssl_socket->context->ctx);
+    AVS_UNIT_ASSERT_NOT_NULL(ssl);
 
     // We remove TLS 1.3 ciphersuites, because all of them can be used with both
     // PSK and certs, so they are not interesting in terms of this test
-    SSL_set_ciphersuites(ssl_socket->ssl, "");
+    SSL_set_ciphersuites(ssl, "");
 
-    STACK_OF(SSL_CIPHER) *ciphers = SSL_get1_supported_ciphers(ssl_socket->ssl);
+    STACK_OF(SSL_CIPHER) *ciphers = SSL_get1_supported_ciphers(ssl);
     AVS_UNIT_ASSERT_EQUAL(sk_SSL_CIPHER_num(ciphers), 1);
     const char *cipher_name =
             SSL_CIPHER_get_name(sk_SSL_CIPHER_value(ciphers, 0));
     sk_SSL_CIPHER_free(ciphers);
+    SSL_free(ssl);
 
     AVS_UNIT_ASSERT_EQUAL(strcmp(cipher_name, "PSK-AES128-CCM8"), 0);
 
@@ -60,25 +61,111 @@ AVS_UNIT_TEST(socket, ciphersuites_cert) {
 
     ssl_socket_t *ssl_socket = (ssl_socket_t *) socket;
 
-    AVS_UNIT_ASSERT_EQUAL(ssl_socket->enabled_ciphersuites.num_ids, 2);
-
-    ssl_socket->ssl = SSL_new(ssl_socket->ctx);
-    AVS_UNIT_ASSERT_NOT_NULL(ssl_socket->ssl);
-
-    AVS_UNIT_ASSERT_SUCCESS(fix_socket_ciphersuites(ssl_socket));
+    // ciphersuites are configured on the SSL_CTX, so that every SSL object
+    // created from it inherits them
+    SSL *ssl = SSL_new(ssl_socket->context->ctx);
+    AVS_UNIT_ASSERT_NOT_NULL(ssl);
 
     // We remove TLS 1.3 ciphersuites, because all of them can be used with both
     // PSK and certs, so they are not interesting in terms of this test
-    SSL_set_ciphersuites(ssl_socket->ssl, "");
+    SSL_set_ciphersuites(ssl, "");
 
-    STACK_OF(SSL_CIPHER) *ciphers = SSL_get1_supported_ciphers(ssl_socket->ssl);
+    STACK_OF(SSL_CIPHER) *ciphers = SSL_get1_supported_ciphers(ssl);
     AVS_UNIT_ASSERT_EQUAL(sk_SSL_CIPHER_num(ciphers), 1);
     const char *cipher_name =
             SSL_CIPHER_get_name(sk_SSL_CIPHER_value(ciphers, 0));
     sk_SSL_CIPHER_free(ciphers);
+    SSL_free(ssl);
 
     AVS_UNIT_ASSERT_EQUAL(strcmp(cipher_name, "ECDHE-ECDSA-AES128-CCM8"), 0);
 
     AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&socket));
     cleanup_default_ssl_config(&config);
 }
+
+#ifdef WITH_SSL_SERVER_SESSIONS
+AVS_UNIT_TEST(socket, ticket_key_rotation) {
+    const avs_net_ssl_server_session_config_t server_sessions = {
+        .use_tickets = true,
+        .lifetime = avs_time_duration_from_scalar(1, AVS_TIME_HOUR)
+    };
+    avs_net_ssl_configuration_t config = create_default_ssl_config();
+    config.server_sessions = &server_sessions;
+    avs_net_ssl_context_t *context = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_ssl_context_create(&context, &config));
+
+    ticket_key_t old_key;
+    AVS_UNIT_ASSERT_EQUAL(get_ticket_key(context, NULL, true, &old_key), 1);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(old_key.name,
+                                      context->ticket_keys[0].name,
+                                      sizeof(old_key.name));
+
+    // the key is rotated once it is older than the lifetime
+    context->ticket_keys[0].created = avs_time_monotonic_add(
+            avs_time_monotonic_now(),
+            avs_time_duration_from_scalar(-2, AVS_TIME_HOUR));
+    ticket_key_t key;
+    AVS_UNIT_ASSERT_EQUAL(get_ticket_key(context, NULL, true, &key), 1);
+    AVS_UNIT_ASSERT_NOT_EQUAL(memcmp(key.name, old_key.name, sizeof(key.name)),
+                              0);
+
+    // tickets protected with the previous key are accepted and renewed
+    AVS_UNIT_ASSERT_EQUAL(get_ticket_key(context, old_key.name, false, &key),
+                          2);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(key.hmac_key, old_key.hmac_key,
+                                      sizeof(key.hmac_key));
+
+    // tickets protected with unknown keys are not
+    unsigned char unknown_name[sizeof(key.name)] = { 0 };
+    AVS_UNIT_ASSERT_EQUAL(get_ticket_key(context, unknown_name, false, &key),
+                          0);
+
+    avs_net_ssl_context_cleanup(&context);
+    cleanup_default_ssl_config(&config);
+}
+
+#    ifdef AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
+AVS_UNIT_TEST(socket, ticket_key_rotation_resumption) {
+    const avs_net_ssl_server_session_config_t server_sessions = {
+        .use_tickets = true,
+        .lifetime = avs_time_duration_from_scalar(1, AVS_TIME_MIN)
+    };
+    tls_server_env_t env;
+    tls_server_env_init(&env, &server_sessions);
+    unsigned char first_key_name[sizeof(env.context->ticket_keys[0].name)];
+    memcpy(first_key_name, env.context->ticket_keys[0].name,
+           sizeof(first_key_name));
+    pid_t child = spawn_tls_client(env.port, 3);
+
+    for (size_t i = 0; i < 3; ++i) {
+        if (i == 1) {
+            // The client now holds a ticket protected with the first key. Make
+            // the rotation interval elapse without waiting for it; sessions
+            // share the lifetime, so they would expire along with the key.
+            env.context->ticket_keys[0].created = avs_time_monotonic_add(
+                    env.context->ticket_keys[0].created,
+                    avs_time_duration_mul(server_sessions.lifetime, -1));
+        }
+        avs_net_socket_t *ssl_socket = tls_server_accept(&env);
+        avs_net_ssl_server_session_stats_t stats;
+        AVS_UNIT_ASSERT_SUCCESS(
+                avs_net_ssl_context_get_server_session_stats(env.context,
+                                                             &stats));
+        // the second connection resumes with a ticket protected with the
+        // previous key, and the third one - with the renewed ticket
+        AVS_UNIT_ASSERT_EQUAL(stats.handshakes, i + 1);
+        AVS_UNIT_ASSERT_EQUAL(stats.resumed, i);
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(ssl_socket, "!", 1));
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&ssl_socket));
+    }
+    wait_for_client(child);
+
+    AVS_UNIT_ASSERT_NOT_EQUAL(memcmp(env.context->ticket_keys[0].name,
+                                     first_key_name, sizeof(first_key_name)),
+                              0);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(env.context->ticket_keys[1].name,
+                                      first_key_name, sizeof(first_key_name));
+    tls_server_env_cleanup(&env);
+}
+#    endif // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
+#endif     // WITH_SSL_SERVER_SESSIONS
@@ -0,0 +1,166 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avsystem/commons/avs_net_poller.h>
+
+#include "socket_common.h"
+
+typedef struct {
+    avs_net_socket_t *server;
+    avs_net_socket_t *client;
+} udp_pair_t;
+
+static udp_pair_t udp_pair_create(void) {
+    udp_pair_t pair = { NULL, NULL };
+    create_udp_pair(&pair.client, &pair.server);
+    return pair;
+}
+
+static void udp_pair_cleanup(udp_pair_t *pair) {
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&pair->server));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&pair->client));
+}
+
+AVS_UNIT_TEST(poller, readiness) {
+    avs_net_poller_t *poller = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_create(&poller));
+    udp_pair_t pair = udp_pair_create();
+    int user_data;
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_add(poller, pair.server,
+                                               AVS_NET_POLLER_READ, &user_data));
+
+    avs_net_poller_event_t events[4];
+    size_t count;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_wait(poller, events,
+                                                AVS_ARRAY_SIZE(events), &count,
+                                                AVS_TIME_DURATION_ZERO));
+    AVS_UNIT_ASSERT_EQUAL(count, 0);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(pair.client, "x", 1));
+    // invalid timeout means waiting indefinitely, as with avs_sched_time_to_next()
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_wait(poller, events,
+                                                AVS_ARRAY_SIZE(events), &count,
+                                                AVS_TIME_DURATION_INVALID));
+    AVS_UNIT_ASSERT_EQUAL(count, 1);
+    AVS_UNIT_ASSERT_TRUE(events[0].socket == pair.server);
+    AVS_UNIT_ASSERT_TRUE(events[0].user_data == &user_data);
+    AVS_UNIT_ASSERT_EQUAL(events[0].events, AVS_NET_POLLER_READ);
+
+    // level-triggered: still readable until the data is received
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_wait(
+            poller, events, AVS_ARRAY_SIZE(events), &count,
+            avs_time_duration_from_scalar(-1, AVS_TIME_S)));
+    AVS_UNIT_ASSERT_EQUAL(count, 1);
+
+    char buf[16];
+    size_t received;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_receive(pair.server, &received, buf, sizeof(buf)));
+    AVS_UNIT_ASSERT_EQUAL(received, 1);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_wait(
+            poller, events, AVS_ARRAY_SIZE(events), &count,
+            avs_time_duration_from_scalar(1500, AVS_TIME_US)));
+    AVS_UNIT_ASSERT_EQUAL(count, 0);
+
+    avs_net_poller_cleanup(&poller);
+    AVS_UNIT_ASSERT_NULL(poller);
+    udp_pair_cleanup(&pair);
+}
+
+AVS_UNIT_TEST(poller, modify_and_remove) {
+    avs_net_poller_t *poller = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_create(&poller));
+    udp_pair_t pair = udp_pair_create();
+
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_poller_add(poller, pair.server, AVS_NET_POLLER_READ, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_poller_add(poller, pair.client, AVS_NET_POLLER_READ, NULL));
+    AVS_UNIT_ASSERT_EQUAL(avs_net_poller_add(poller, pair.client,
+                                             AVS_NET_POLLER_WRITE, NULL)
+                                  .code,
+                          AVS_EEXIST);
+
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_poller_modify(poller, pair.client, AVS_NET_POLLER_WRITE));
+    avs_net_poller_event_t events[4];
+    size_t count;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_wait(poller, events,
+                                                AVS_ARRAY_SIZE(events), &count,
+                                                AVS_TIME_DURATION_ZERO));
+    AVS_UNIT_ASSERT_EQUAL(count, 1);
+    AVS_UNIT_ASSERT_TRUE(events[0].socket == pair.client);
+    AVS_UNIT_ASSERT_EQUAL(events[0].events, AVS_NET_POLLER_WRITE);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_remove(poller, pair.client));
+    AVS_UNIT_ASSERT_EQUAL(avs_net_poller_remove(poller, pair.client).code,
+                          AVS_ENOENT);
+    AVS_UNIT_ASSERT_EQUAL(
+            avs_net_poller_modify(poller, pair.client, AVS_NET_POLLER_READ)
+                    .code,
+            AVS_ENOENT);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_wait(poller, events,
+                                                AVS_ARRAY_SIZE(events), &count,
+                                                AVS_TIME_DURATION_ZERO));
+    AVS_UNIT_ASSERT_EQUAL(count, 0);
+
+    // removal of an already closed socket
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_close(pair.server));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_remove(poller, pair.server));
+
+    AVS_UNIT_ASSERT_EQUAL(
+            avs_net_poller_add(poller, pair.server, AVS_NET_POLLER_READ, NULL)
+                    .code,
+            AVS_EBADF);
+
+    avs_net_poller_cleanup(&poller);
+    udp_pair_cleanup(&pair);
+}
+
+AVS_UNIT_TEST(poller, many_ready) {
+    avs_net_poller_t *poller = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_create(&poller));
+    udp_pair_t pairs[5];
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(pairs); ++i) {
+        pairs[i] = udp_pair_create();
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_add(
+                poller, pairs[i].server, AVS_NET_POLLER_READ, &pairs[i]));
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(pairs[i].client, "x", 1));
+    }
+
+    // all sockets shall be reported eventually even with a small buffer
+    bool reported[AVS_ARRAY_SIZE(pairs)] = { false };
+    for (size_t round = 0; round < AVS_ARRAY_SIZE(pairs); ++round) {
+        avs_net_poller_event_t events[2];
+        size_t count;
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_wait(
+                poller, events, AVS_ARRAY_SIZE(events), &count,
+                avs_time_duration_from_scalar(1, AVS_TIME_S)));
+        AVS_UNIT_ASSERT_TRUE(count > 0 && count <= AVS_ARRAY_SIZE(events));
+        for (size_t i = 0; i < count; ++i) {
+            udp_pair_t *pair = (udp_pair_t *) events[i].user_data;
+            AVS_UNIT_ASSERT_TRUE(events[i].socket == pair->server);
+            reported[pair - pairs] = true;
+        }
+    }
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(pairs); ++i) {
+        AVS_UNIT_ASSERT_TRUE(reported[i]);
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_remove(poller, pairs[i].server));
+        udp_pair_cleanup(&pairs[i]);
+    }
+    avs_net_poller_cleanup(&poller);
+}
@@ -0,0 +1,266 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avs_commons_posix_init.h>
+
+#include <string.h>
+#include <time.h>
+
+#include <avsystem/commons/avs_net_resolver.h>
+#include <avsystem/commons/avs_unit_test.h>
+
+#if defined(AVS_COMMONS_NET_WITH_RESOLVER)                     \
+        && defined(AVS_COMMONS_COMPAT_THREADING_WITH_PTHREAD)
+#    define WITH_WORKER_TESTS
+#    include <pthread.h>
+
+#    include <avsystem/commons/avs_mutex.h>
+#endif
+
+#ifdef AVS_COMMONS_NET_WITH_RESOLVER
+
+static avs_net_resolver_t *create_resolver(size_t cache_size,
+                                           avs_time_duration_t ttl) {
+    const avs_net_resolver_config_t config = {
+        .cache_size = cache_size,
+        .positive_ttl = ttl,
+        .negative_ttl = ttl
+    };
+    avs_net_resolver_t *resolver = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_resolver_create(&resolver, &config));
+    return resolver;
+}
+
+static avs_error_t resolve(avs_net_resolver_t *resolver, const char *port) {
+    avs_net_resolver_result_t result;
+    avs_error_t err =
+            avs_net_resolver_resolve(resolver, AVS_NET_UDP_SOCKET,
+                                     AVS_NET_AF_INET4, "localhost", port, 0,
+                                     &result);
+    if (avs_is_ok(err)) {
+        AVS_UNIT_ASSERT_TRUE(result.count > 0);
+        char host[64];
+        char resolved_port[8];
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_resolved_endpoint_get_host_port(
+                &result.endpoints[0], host, sizeof(host), resolved_port,
+                sizeof(resolved_port)));
+        AVS_UNIT_ASSERT_EQUAL_STRING(host, "127.0.0.1");
+        AVS_UNIT_ASSERT_EQUAL_STRING(resolved_port, port);
+    }
+    return err;
+}
+
+static void assert_stats(avs_net_resolver_t *resolver,
+                         uint64_t hits,
+                         uint64_t misses,
+                         uint64_t negative_hits) {
+    avs_net_resolver_stats_t stats;
+    avs_net_resolver_stats(resolver, &stats);
+    AVS_UNIT_ASSERT_EQUAL(stats.cache_hits, hits);
+    AVS_UNIT_ASSERT_EQUAL(stats.cache_misses, misses);
+    AVS_UNIT_ASSERT_EQUAL(stats.negative_hits, negative_hits);
+}
+
+AVS_UNIT_TEST(resolver, cache) {
+    avs_net_resolver_t *resolver =
+            create_resolver(8, avs_time_duration_from_scalar(1, AVS_TIME_HOUR));
+
+    AVS_UNIT_ASSERT_SUCCESS(resolve(resolver, "1234"));
+    AVS_UNIT_ASSERT_SUCCESS(resolve(resolver, "1234"));
+    assert_stats(resolver, 1, 1, 0);
+
+    // different port is a different key
+    AVS_UNIT_ASSERT_SUCCESS(resolve(resolver, "4321"));
+    assert_stats(resolver, 1, 2, 0);
+
+    // failures are cached as well
+    AVS_UNIT_ASSERT_EQUAL(resolve(resolver, "99999").code,
+                          AVS_EADDRNOTAVAIL);
+    AVS_UNIT_ASSERT_EQUAL(resolve(resolver, "99999").code,
+                          AVS_EADDRNOTAVAIL);
+    assert_stats(resolver, 2, 3, 1);
+
+    avs_net_resolver_flush(resolver);
+    AVS_UNIT_ASSERT_SUCCESS(resolve(resolver, "1234"));
+    assert_stats(resolver, 2, 4, 1);
+
+    avs_net_resolver_cleanup(&resolver);
+    AVS_UNIT_ASSERT_NULL(resolver);
+}
+
+AVS_UNIT_TEST(resolver, expiry_and_eviction) {
+    avs_net_resolver_t *resolver =
+            create_resolver(8, AVS_TIME_DURATION_ZERO);
+    AVS_UNIT_ASSERT_SUCCESS(resolve(resolver, "1234"));
+    AVS_UNIT_ASSERT_SUCCESS(resolve(resolver, "1234"));
+    assert_stats(resolver, 0, 2, 0);
+    avs_net_resolver_cleanup(&resolver);
+
+    resolver =
+            create_resolver(2, avs_time_duration_from_scalar(1, AVS_TIME_HOUR));
+    AVS_UNIT_ASSERT_SUCCESS(resolve(resolver, "1"));
+    AVS_UNIT_ASSERT_SUCCESS(resolve(resolver, "2"));
+    AVS_UNIT_ASSERT_SUCCESS(resolve(resolver, "1"));
+    // evicts "2", as "1" has been used more recently
+    AVS_UNIT_ASSERT_SUCCESS(resolve(resolver, "3"));
+    AVS_UNIT_ASSERT_SUCCESS(resolve(resolver, "1"));
+    assert_stats(resolver, 2, 3, 0);
+    AVS_UNIT_ASSERT_SUCCESS(resolve(resolver, "2"));
+    assert_stats(resolver, 2, 4, 0);
+    avs_net_resolver_cleanup(&resolver);
+}
+
+typedef struct {
+    size_t succeeded;
+    size_t failed;
+    size_t cancelled;
+#    ifdef WITH_WORKER_TESTS
+    avs_mutex_t *mutex;
+#    endif // WITH_WORKER_TESTS
+} async_test_state_t;
+
+static void async_test_callback(void *state_,
+                                avs_error_t err,
+                                const avs_net_resolver_result_t *result) {
+    async_test_state_t *state = (async_test_state_t *) state_;
+#    ifdef WITH_WORKER_TESTS
+    avs_mutex_lock(state->mutex);
+#    endif // WITH_WORKER_TESTS
+    if (avs_is_ok(err)) {
+        AVS_UNIT_ASSERT_NOT_NULL(result);
+        AVS_UNIT_ASSERT_TRUE(result->count > 0);
+        ++state->succeeded;
+    } else if (err.category == AVS_ERRNO_CATEGORY
+               && err.code == AVS_EINTR) {
+        ++state->cancelled;
+    } else {
+        ++state->failed;
+    }
+#    ifdef WITH_WORKER_TESTS
+    avs_mutex_unlock(state->mutex);
+#    endif // WITH_WORKER_TESTS
+}
+
+static avs_error_t resolve_async(avs_net_resolver_t *resolver,
+                                 const char *port,
+                                 async_test_state_t *state) {
+    return avs_net_resolver_resolve_async(resolver, AVS_NET_UDP_SOCKET,
+                                          AVS_NET_AF_INET4, "localhost", port,
+                                          0, async_test_callback, state);
+}
+
+AVS_UNIT_TEST(resolver, async_cancel) {
+    avs_net_resolver_t *resolver =
+            create_resolver(8, avs_time_duration_from_scalar(1, AVS_TIME_HOUR));
+    async_test_state_t state;
+    memset(&state, 0, sizeof(state));
+#    ifdef WITH_WORKER_TESTS
+    AVS_UNIT_ASSERT_SUCCESS(avs_mutex_create(&state.mutex));
+#    endif // WITH_WORKER_TESTS
+    async_test_state_t other_state = state;
+
+    // answered from the cache synchronously
+    AVS_UNIT_ASSERT_SUCCESS(resolve(resolver, "1234"));
+    AVS_UNIT_ASSERT_SUCCESS(resolve_async(resolver, "1234", &state));
+    AVS_UNIT_ASSERT_EQUAL(state.succeeded, 1);
+
+    // no workers are running, so these remain queued
+    AVS_UNIT_ASSERT_SUCCESS(resolve_async(resolver, "1", &state));
+    AVS_UNIT_ASSERT_SUCCESS(resolve_async(resolver, "1", &other_state));
+    AVS_UNIT_ASSERT_SUCCESS(resolve_async(resolver, "2", &state));
+    AVS_UNIT_ASSERT_EQUAL(avs_net_resolver_cancel(resolver, async_test_callback,
+                                                  &state),
+                          2);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_resolver_workers_stop(resolver));
+    AVS_UNIT_ASSERT_EQUAL(state.succeeded, 1);
+    AVS_UNIT_ASSERT_EQUAL(state.cancelled, 0);
+    AVS_UNIT_ASSERT_EQUAL(other_state.cancelled, 1);
+    AVS_UNIT_ASSERT_EQUAL(avs_net_resolver_worker_run(resolver), 0);
+    AVS_UNIT_ASSERT_EQUAL(resolve_async(resolver, "1", &state).code,
+                          AVS_EINTR);
+    AVS_UNIT_ASSERT_SUCCESS(resolve_async(resolver, "1234", &state));
+    AVS_UNIT_ASSERT_EQUAL(state.succeeded, 2);
+
+#    ifdef WITH_WORKER_TESTS
+    avs_mutex_cleanup(&state.mutex);
+#    endif // WITH_WORKER_TESTS
+    avs_net_resolver_cleanup(&resolver);
+}
+
+#    ifdef WITH_WORKER_TESTS
+static void *worker_thread(void *resolver) {
+    return (void *) (intptr_t) avs_net_resolver_worker_run(
+            (avs_net_resolver_t *) resolver);
+}
+
+AVS_UNIT_TEST(resolver, async_workers) {
+    enum { QUERIES = 16 };
+    avs_net_resolver_t *resolver =
+            create_resolver(8, avs_time_duration_from_scalar(1, AVS_TIME_HOUR));
+    async_test_state_t state;
+    memset(&state, 0, sizeof(state));
+    AVS_UNIT_ASSERT_SUCCESS(avs_mutex_create(&state.mutex));
+
+    // identical queries made before the lookup completes are coalesced
+    for (int i = 0; i < QUERIES; ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(resolve_async(resolver, "1234", &state));
+        AVS_UNIT_ASSERT_SUCCESS(resolve_async(resolver, "99999",
+                                              &state));
+    }
+    assert_stats(resolver, 2 * (QUERIES - 1), 2, 0);
+
+    pthread_t threads[2];
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(threads); ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(
+                pthread_create(&threads[i], NULL, worker_thread, resolver));
+    }
+
+    const avs_time_monotonic_t deadline = avs_time_monotonic_add(
+            avs_time_monotonic_now(),
+            avs_time_duration_from_scalar(30, AVS_TIME_S));
+    size_t done;
+    do {
+        nanosleep(&(const struct timespec) { 0, 1000000 }, NULL);
+        avs_mutex_lock(state.mutex);
+        done = state.succeeded + state.failed;
+        avs_mutex_unlock(state.mutex);
+    } while (done < 2 * QUERIES
+             && avs_time_monotonic_before(avs_time_monotonic_now(),
+                                          deadline));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_resolver_workers_stop(resolver));
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(threads); ++i) {
+        void *result = NULL;
+        AVS_UNIT_ASSERT_SUCCESS(pthread_join(threads[i], &result));
+        AVS_UNIT_ASSERT_NULL(result);
+    }
+    AVS_UNIT_ASSERT_EQUAL(state.succeeded, QUERIES);
+    AVS_UNIT_ASSERT_EQUAL(state.failed, QUERIES);
+    AVS_UNIT_ASSERT_EQUAL(state.cancelled, 0);
+
+    // results of asynchronous lookups are cached, too
+    AVS_UNIT_ASSERT_SUCCESS(resolve(resolver, "1234"));
+    AVS_UNIT_ASSERT_EQUAL(resolve(resolver, "99999").code,
+                          AVS_EADDRNOTAVAIL);
+    assert_stats(resolver, 2 * QUERIES, 2, 1);
+
+    avs_mutex_cleanup(&state.mutex);
+    avs_net_resolver_cleanup(&resolver);
+}
+#    endif // WITH_WORKER_TESTS
+
+#endif // AVS_COMMONS_NET_WITH_RESOLVER
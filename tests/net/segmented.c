@@ -0,0 +1,133 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include <avsystem/commons/avs_unit_mocksock.h>
+
+#include "socket_common.h"
+
+AVS_UNIT_TEST(socket_segmented, udp_roundtrip) {
+    avs_net_socket_t *server = NULL;
+    avs_net_socket_t *client = NULL;
+    char port[16];
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_udp_socket_create(&server, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_bind(server, DEFAULT_ADDRESS, DEFAULT_PORT));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_get_local_port(server, port, sizeof(port)));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_udp_socket_create(&client, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_connect(client, DEFAULT_ADDRESS, port));
+
+    // GRO is not supported everywhere; the results shall be the same either
+    // way, only the number of receive calls differs
+    avs_net_socket_opt_value_t gro = {
+        .flag = true
+    };
+    if (avs_is_ok(avs_net_socket_set_opt(server, AVS_NET_SOCKET_OPT_UDP_GRO,
+                                         gro))) {
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_opt(
+                server, AVS_NET_SOCKET_OPT_UDP_GRO, &gro));
+        AVS_UNIT_ASSERT_TRUE(gro.flag);
+    }
+
+    static char payload[10 * 100 + 50];
+    for (size_t i = 0; i < sizeof(payload); ++i) {
+        payload[i] = (char) ('a' + i % 26);
+    }
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send_segmented(
+            client, payload, sizeof(payload), 100));
+
+    static char received[sizeof(payload)];
+    static char buffer[65536];
+    size_t total = 0;
+    while (total < sizeof(payload)) {
+        size_t bytes_received;
+        size_t segment_size;
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_receive_segmented(
+                server, &bytes_received, buffer, sizeof(buffer),
+                &segment_size));
+        AVS_UNIT_ASSERT_TRUE(bytes_received > 0);
+        AVS_UNIT_ASSERT_TRUE(total + bytes_received <= sizeof(payload));
+        if (bytes_received == 50) {
+            AVS_UNIT_ASSERT_EQUAL(segment_size, 50);
+        } else {
+            AVS_UNIT_ASSERT_EQUAL(segment_size, 100);
+        }
+        memcpy(&received[total], buffer, bytes_received);
+        total += bytes_received;
+    }
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(received, payload, sizeof(payload));
+
+    avs_net_socket_opt_value_t bytes;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_opt(
+            client, AVS_NET_SOCKET_OPT_BYTES_SENT, &bytes));
+    AVS_UNIT_ASSERT_EQUAL(bytes.bytes_sent, sizeof(payload));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_opt(
+            server, AVS_NET_SOCKET_OPT_BYTES_RECEIVED, &bytes));
+    AVS_UNIT_ASSERT_EQUAL(bytes.bytes_received, sizeof(payload));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&server));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&client));
+}
+
+AVS_UNIT_TEST(socket_segmented, tcp_not_supported) {
+    avs_net_socket_t *socket = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(&socket, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_bind(socket, DEFAULT_ADDRESS, DEFAULT_PORT));
+    avs_net_socket_opt_value_t gro = {
+        .flag = true
+    };
+    AVS_UNIT_ASSERT_FAILED(
+            avs_net_socket_set_opt(socket, AVS_NET_SOCKET_OPT_UDP_GRO, gro));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&socket));
+}
+
+AVS_UNIT_TEST(socket_segmented, fallback) {
+    // mock sockets do not implement segmentation offload natively
+    avs_net_socket_t *socket = NULL;
+    avs_unit_mocksock_create_datagram(&socket);
+    avs_unit_mocksock_expect_connect(socket, "host", "1234");
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_connect(socket, "host", "1234"));
+
+    avs_unit_mocksock_expect_output(socket, "abc", 3);
+    avs_unit_mocksock_expect_output(socket, "def", 3);
+    avs_unit_mocksock_expect_output(socket, "g", 1);
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_send_segmented(socket, "abcdefg", 7, 3));
+
+    // segment size defaults to the inner MTU
+    avs_unit_mocksock_enable_inner_mtu_getopt(socket, 4);
+    avs_unit_mocksock_expect_output(socket, "abcd", 4);
+    avs_unit_mocksock_expect_output(socket, "efg", 3);
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_send_segmented(socket, "abcdefg", 7, 0));
+
+    avs_unit_mocksock_input(socket, "xyz", 3);
+    char buffer[8];
+    size_t bytes_received;
+    size_t segment_size;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_receive_segmented(
+            socket, &bytes_received, buffer, sizeof(buffer), &segment_size));
+    AVS_UNIT_ASSERT_EQUAL(bytes_received, 3);
+    AVS_UNIT_ASSERT_EQUAL(segment_size, 3);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buffer, "xyz", 3);
+
+    avs_unit_mocksock_assert_io_clean(socket);
+    avs_net_socket_cleanup(&socket);
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avs_commons_posix_init.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <avsystem/commons/avs_memory.h>
+#include <avsystem/commons/avs_unit_mocksock.h>
+
+#include "socket_common.h"
+
+#ifdef AVS_COMMONS_STREAM_WITH_FILE
+
+#    ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDFILE
+#        define FILE_SIZE 100000
+
+static char *make_pattern(void) {
+    char *data = (char *) avs_malloc(FILE_SIZE);
+    AVS_UNIT_ASSERT_NOT_NULL(data);
+    for (size_t i = 0; i < FILE_SIZE; ++i) {
+        data[i] = (char) (i * 7 + i / 256);
+    }
+    return data;
+}
+
+static void receive_exactly(avs_net_socket_t *socket,
+                            char *buffer,
+                            size_t length) {
+    size_t total = 0;
+    while (total < length) {
+        size_t received = 0;
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_receive(
+                socket, &received, buffer + total, length - total));
+        AVS_UNIT_ASSERT_NOT_EQUAL(received, 0);
+        total += received;
+    }
+}
+
+AVS_UNIT_TEST(socket_send_file, tcp) {
+    avs_net_socket_t *client = NULL;
+    avs_net_socket_t *server = NULL;
+    create_tcp_pair(&client, &server);
+
+    char *data = make_pattern();
+    char *received = (char *) avs_malloc(FILE_SIZE);
+    AVS_UNIT_ASSERT_NOT_NULL(received);
+    FILE *file = tmpfile();
+    AVS_UNIT_ASSERT_NOT_NULL(file);
+    AVS_UNIT_ASSERT_EQUAL(fwrite(data, 1, FILE_SIZE, file), FILE_SIZE);
+
+    // send a range from the middle of the file, after some buffered reads
+    AVS_UNIT_ASSERT_SUCCESS(fseek(file, 0, SEEK_SET));
+    char first[10];
+    AVS_UNIT_ASSERT_EQUAL(fread(first, 1, sizeof(first), file), sizeof(first));
+    size_t bytes_sent = 0;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_send_file(client, file, 50000, &bytes_sent));
+    AVS_UNIT_ASSERT_EQUAL(bytes_sent, 50000);
+    AVS_UNIT_ASSERT_EQUAL(ftell(file), 50010);
+    receive_exactly(server, received, 50000);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(received, data + 10, 50000);
+
+    // send the rest of the file
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_send_file(client, file, SIZE_MAX, &bytes_sent));
+    AVS_UNIT_ASSERT_EQUAL(bytes_sent, FILE_SIZE - 50010);
+    AVS_UNIT_ASSERT_EQUAL(ftell(file), FILE_SIZE);
+    receive_exactly(server, received, FILE_SIZE - 50010);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(received, data + 50010,
+                                      FILE_SIZE - 50010);
+
+    // nothing more to send
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_send_file(client, file, SIZE_MAX, &bytes_sent));
+    AVS_UNIT_ASSERT_EQUAL(bytes_sent, 0);
+
+    avs_net_socket_opt_value_t stat;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_opt(
+            client, AVS_NET_SOCKET_OPT_BYTES_SENT, &stat));
+    AVS_UNIT_ASSERT_EQUAL(stat.bytes_sent, FILE_SIZE - 10);
+
+    fclose(file);
+    avs_free(received);
+    avs_free(data);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&client));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&server));
+}
+
+AVS_UNIT_TEST(socket_send_file, tcp_from_pipe) {
+    // pipes cannot be used with sendfile()
+    avs_net_socket_t *client = NULL;
+    avs_net_socket_t *server = NULL;
+    create_tcp_pair(&client, &server);
+
+    int fds[2];
+    AVS_UNIT_ASSERT_SUCCESS(pipe(fds));
+    AVS_UNIT_ASSERT_EQUAL(write(fds[1], "pipe data", 9), 9);
+    close(fds[1]);
+    FILE *file = fdopen(fds[0], "r");
+    AVS_UNIT_ASSERT_NOT_NULL(file);
+
+    size_t bytes_sent = 0;
+    avs_error_t err =
+            avs_net_socket_send_file(client, file, SIZE_MAX, &bytes_sent);
+    AVS_UNIT_ASSERT_EQUAL(err.category, AVS_ERRNO_CATEGORY);
+    AVS_UNIT_ASSERT_EQUAL(err.code, AVS_ENOTSUP);
+    AVS_UNIT_ASSERT_EQUAL(bytes_sent, 0);
+    // nothing has been consumed
+    char buf[9];
+    AVS_UNIT_ASSERT_EQUAL(fread(buf, 1, sizeof(buf), file), sizeof(buf));
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, "pipe data", 9);
+
+    fclose(file);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&client));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&server));
+}
+#    endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_SENDFILE
+
+AVS_UNIT_TEST(socket_send_file, unsupported_socket) {
+    // mock sockets do not implement sending files
+    avs_net_socket_t *socket = NULL;
+    avs_unit_mocksock_create(&socket);
+    avs_unit_mocksock_expect_connect(socket, "host", "1234");
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_connect(socket, "host", "1234"));
+
+    FILE *file = tmpfile();
+    AVS_UNIT_ASSERT_NOT_NULL(file);
+    AVS_UNIT_ASSERT_EQUAL(fwrite("hello world", 1, 11, file), 11);
+    AVS_UNIT_ASSERT_SUCCESS(fseek(file, 6, SEEK_SET));
+
+    size_t bytes_sent = 1;
+    avs_error_t err =
+            avs_net_socket_send_file(socket, file, SIZE_MAX, &bytes_sent);
+    AVS_UNIT_ASSERT_EQUAL(err.category, AVS_ERRNO_CATEGORY);
+    AVS_UNIT_ASSERT_EQUAL(err.code, AVS_ENOTSUP);
+    AVS_UNIT_ASSERT_EQUAL(bytes_sent, 0);
+    AVS_UNIT_ASSERT_EQUAL(ftell(file), 6);
+
+    fclose(file);
+    avs_unit_mocksock_assert_io_clean(socket);
+    avs_net_socket_cleanup(&socket);
+}
+
+#endif // AVS_COMMONS_STREAM_WITH_FILE
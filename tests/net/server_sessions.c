@@ -0,0 +1,89 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fork_client.h"
+
+#ifdef AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
+
+#    define CONNECTIONS 4
+
+static avs_net_ssl_server_session_stats_t
+serve_connections(const avs_net_ssl_server_session_config_t *server_sessions) {
+    tls_server_env_t env;
+    tls_server_env_init(&env, server_sessions);
+    pid_t child = spawn_tls_client(env.port, CONNECTIONS);
+
+    for (int i = 0; i < CONNECTIONS; ++i) {
+        avs_net_socket_t *ssl_socket = tls_server_accept(&env);
+#    ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+        avs_net_socket_stats_t socket_stats;
+        AVS_UNIT_ASSERT_SUCCESS(
+                avs_net_socket_get_stats(ssl_socket, &socket_stats));
+        AVS_UNIT_ASSERT_EQUAL(socket_stats.handshake_time.count, 1);
+        AVS_UNIT_ASSERT_TRUE(avs_time_duration_less(
+                AVS_TIME_DURATION_ZERO, socket_stats.handshake_time.total));
+#    endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(ssl_socket, "!", 1));
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&ssl_socket));
+    }
+    wait_for_client(child);
+
+    avs_net_ssl_server_session_stats_t stats;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_ssl_context_get_server_session_stats(env.context, &stats));
+    tls_server_env_cleanup(&env);
+    return stats;
+}
+
+AVS_UNIT_TEST(server_sessions, cache) {
+    const avs_net_ssl_server_session_config_t server_sessions = {
+        .max_sessions = 16,
+        .lifetime = avs_time_duration_from_scalar(1, AVS_TIME_MIN)
+    };
+    avs_net_ssl_server_session_stats_t stats =
+            serve_connections(&server_sessions);
+    AVS_UNIT_ASSERT_EQUAL(stats.handshakes, CONNECTIONS);
+    AVS_UNIT_ASSERT_EQUAL(stats.resumed, CONNECTIONS - 1);
+}
+
+AVS_UNIT_TEST(server_sessions, tickets) {
+    const avs_net_ssl_server_session_config_t server_sessions = {
+        .use_tickets = true,
+        .lifetime = avs_time_duration_from_scalar(1, AVS_TIME_MIN)
+    };
+    avs_net_ssl_server_session_stats_t stats =
+            serve_connections(&server_sessions);
+    AVS_UNIT_ASSERT_EQUAL(stats.handshakes, CONNECTIONS);
+    AVS_UNIT_ASSERT_EQUAL(stats.resumed, CONNECTIONS - 1);
+}
+
+AVS_UNIT_TEST(server_sessions, invalid_lifetime) {
+    avs_crypto_prng_ctx_t *prng_ctx = avs_crypto_prng_new(NULL, NULL);
+    AVS_UNIT_ASSERT_NOT_NULL(prng_ctx);
+    const avs_net_ssl_server_session_config_t server_sessions = {
+        .use_tickets = true,
+        .lifetime = avs_time_duration_from_scalar(10, AVS_TIME_MS)
+    };
+    const avs_net_ssl_configuration_t config =
+            tls_server_config(prng_ctx, &server_sessions);
+    avs_net_ssl_context_t *context = NULL;
+    avs_error_t err = avs_net_ssl_context_create(&context, &config);
+    AVS_UNIT_ASSERT_TRUE(is_errno(err, AVS_EINVAL));
+    AVS_UNIT_ASSERT_NULL(context);
+    avs_crypto_prng_free(&prng_ctx);
+}
+
+#endif // AVS_COMMONS_NET_WITH_TLS_SESSION_PERSISTENCE
@@ -0,0 +1,184 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avsystem/commons/avs_stream_membuf.h>
+#include <avsystem/commons/avs_unit_test.h>
+
+#include "socket_common.h"
+
+static _avs_net_session_cache_t *
+create_cache(size_t max_entries, size_t max_session_size, int64_t ttl_s) {
+    const avs_net_ssl_session_cache_config_t config = {
+        .max_entries = max_entries,
+        .max_session_size = max_session_size,
+        .ttl = avs_time_duration_from_scalar(ttl_s, AVS_TIME_S)
+    };
+    _avs_net_session_cache_t *cache = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(_avs_net_session_cache_create(&cache, &config));
+    return cache;
+}
+
+static _avs_net_session_cache_slot_t *
+create_slot(_avs_net_session_cache_t *cache, const char *host) {
+    _avs_net_session_cache_slot_t *slot =
+            _avs_net_session_cache_slot_new(cache);
+    AVS_UNIT_ASSERT_NOT_NULL(slot);
+    AVS_UNIT_ASSERT_TRUE(strlen(host) < sizeof(slot->key.host));
+    strcpy(slot->key.host, host);
+    strcpy(slot->key.port, "4433");
+    return slot;
+}
+
+/**
+ * Stores a session consisting of @p size bytes equal to @p fill under
+ * @p host .
+ */
+static void store_session(_avs_net_session_cache_t *cache,
+                          const char *host,
+                          char fill,
+                          size_t size) {
+    _avs_net_session_cache_slot_t *slot = create_slot(cache, host);
+    AVS_UNIT_ASSERT_TRUE(size <= slot->buffer_size);
+    memset(slot->buffer, fill, size);
+    _avs_net_session_cache_store(cache, slot);
+    avs_free(slot);
+}
+
+/**
+ * Returns the number of leading bytes of the session cached under @p host that
+ * are equal to @p fill , checking that the rest of the slot is zeroed.
+ */
+static size_t load_session(_avs_net_session_cache_t *cache,
+                           const char *host,
+                           char fill) {
+    _avs_net_session_cache_slot_t *slot = create_slot(cache, host);
+    _avs_net_session_cache_load(cache, slot);
+    size_t size = 0;
+    while (size < slot->buffer_size && slot->buffer[size] == fill) {
+        ++size;
+    }
+    for (size_t i = size; i < slot->buffer_size; ++i) {
+        AVS_UNIT_ASSERT_EQUAL(slot->buffer[i], 0);
+    }
+    avs_free(slot);
+    return size;
+}
+
+AVS_UNIT_TEST(session_cache, lru_eviction) {
+    _avs_net_session_cache_t *cache = create_cache(2, 16, 60);
+    store_session(cache, "a", 'a', 4);
+    store_session(cache, "b", 'b', 5);
+    // makes "b" the least recently used one
+    AVS_UNIT_ASSERT_EQUAL(load_session(cache, "a", 'a'), 4);
+    store_session(cache, "c", 'c', 6);
+
+    AVS_UNIT_ASSERT_EQUAL(load_session(cache, "b", 'b'), 0);
+    AVS_UNIT_ASSERT_EQUAL(load_session(cache, "a", 'a'), 4);
+    AVS_UNIT_ASSERT_EQUAL(load_session(cache, "c", 'c'), 6);
+
+    // replacing a session does not evict anything
+    store_session(cache, "a", 'A', 7);
+    AVS_UNIT_ASSERT_EQUAL(load_session(cache, "a", 'A'), 7);
+    AVS_UNIT_ASSERT_EQUAL(load_session(cache, "c", 'c'), 6);
+    _avs_net_session_cache_cleanup(&cache);
+}
+
+AVS_UNIT_TEST(session_cache, ttl_expiry) {
+    _avs_net_session_cache_t *cache = create_cache(2, 16, 60);
+    store_session(cache, "a", 'a', 4);
+    AVS_UNIT_ASSERT_EQUAL(load_session(cache, "a", 'a'), 4);
+    _avs_net_session_cache_cleanup(&cache);
+
+    cache = create_cache(2, 16, 0);
+    store_session(cache, "a", 'a', 4);
+    AVS_UNIT_ASSERT_EQUAL(load_session(cache, "a", 'a'), 0);
+    // expired entries do not take space of valid ones
+    store_session(cache, "b", 'b', 5);
+    store_session(cache, "c", 'c', 6);
+    AVS_UNIT_ASSERT_EQUAL(load_session(cache, "b", 'b'), 0);
+    _avs_net_session_cache_cleanup(&cache);
+}
+
+AVS_UNIT_TEST(session_cache, oversized_session_rejected) {
+    _avs_net_session_cache_t *large = create_cache(4, 16, 60);
+    store_session(large, "a", 'a', 12);
+    store_session(large, "b", 'b', 8);
+
+    avs_stream_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    avs_persistence_context_t ctx =
+            avs_persistence_store_context_create(stream);
+    AVS_UNIT_ASSERT_SUCCESS(_avs_net_session_cache_persistence(&ctx, large));
+    _avs_net_session_cache_cleanup(&large);
+
+    _avs_net_session_cache_t *small = create_cache(4, 8, 60);
+    ctx = avs_persistence_restore_context_create(stream);
+    AVS_UNIT_ASSERT_SUCCESS(_avs_net_session_cache_persistence(&ctx, small));
+    AVS_UNIT_ASSERT_EQUAL(load_session(small, "a", 'a'), 0);
+    AVS_UNIT_ASSERT_EQUAL(load_session(small, "b", 'b'), 8);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+    _avs_net_session_cache_cleanup(&small);
+}
+
+static void *failing_calloc(size_t nmemb, size_t size) {
+    (void) nmemb;
+    (void) size;
+    return NULL;
+}
+
+AVS_UNIT_TEST(session_cache, slot_out_of_memory) {
+    _avs_net_session_cache_t *cache = create_cache(2, 16, 60);
+    unsigned invocations = AVS_UNIT_MOCK_INVOCATIONS(avs_calloc);
+    AVS_UNIT_MOCK(avs_calloc) = failing_calloc;
+    AVS_UNIT_ASSERT_NULL(_avs_net_session_cache_slot_new(cache));
+    AVS_UNIT_ASSERT_EQUAL(AVS_UNIT_MOCK_INVOCATIONS(avs_calloc),
+                          invocations + 1);
+    _avs_net_session_cache_cleanup(&cache);
+}
+
+#ifndef AVS_COMMONS_TINYDTLS_TEST
+AVS_UNIT_TEST(session_cache, socket_create_out_of_memory) {
+    const avs_net_ssl_session_cache_config_t cache_config = {
+        .max_entries = 2,
+        .max_session_size = 4096,
+        .ttl = avs_time_duration_from_scalar(1, AVS_TIME_MIN)
+    };
+    avs_net_ssl_configuration_t config = create_default_ssl_config();
+    config.session_cache = &cache_config;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_ssl_context_create(&config.context,
+                                                       &config));
+
+    // the only allocation made in this file is the one of the cache slot
+    unsigned invocations = AVS_UNIT_MOCK_INVOCATIONS(avs_calloc);
+    AVS_UNIT_MOCK(avs_calloc) = failing_calloc;
+    avs_net_socket_t *socket = NULL;
+    avs_error_t err = avs_net_ssl_socket_create(&socket, &config);
+    AVS_UNIT_ASSERT_EQUAL(err.category, AVS_ERRNO_CATEGORY);
+    AVS_UNIT_ASSERT_EQUAL(err.code, AVS_ENOMEM);
+    AVS_UNIT_ASSERT_NULL(socket);
+    AVS_UNIT_ASSERT_EQUAL(AVS_UNIT_MOCK_INVOCATIONS(avs_calloc),
+                          invocations + 1);
+
+    // the context is still usable
+    AVS_UNIT_MOCK(avs_calloc) = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_ssl_socket_create(&socket, &config));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&socket));
+
+    avs_net_ssl_context_cleanup(&config.context);
+    cleanup_default_ssl_config(&config);
+}
+#endif // AVS_COMMONS_TINYDTLS_TEST
@@ -0,0 +1,26 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AVS_COMMONS_TEST_NET_SESSION_CACHE_MOCKS_H
+#define AVS_COMMONS_TEST_NET_SESSION_CACHE_MOCKS_H
+
+#include <avsystem/commons/avs_memory.h>
+#include <avsystem/commons/avs_unit_mock_helpers.h>
+
+AVS_UNIT_MOCK_CREATE(avs_calloc)
+#define avs_calloc(...) AVS_UNIT_MOCK_WRAPPER(avs_calloc)(__VA_ARGS__)
+
+#endif /* AVS_COMMONS_TEST_NET_SESSION_CACHE_MOCKS_H */
@@ -0,0 +1,217 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include <avsystem/commons/avs_net_poller.h>
+
+#include "socket_common.h"
+
+#define SHARDS 3
+
+static avs_net_socket_configuration_t shard_config(void) {
+    avs_net_socket_configuration_t config;
+    memset(&config, 0, sizeof(config));
+    config.reuse_port = true;
+    return config;
+}
+
+static void cleanup_shards(avs_net_socket_t **shards, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&shards[i]));
+    }
+}
+
+// returns false if SO_REUSEPORT is not supported on this platform
+static bool bind_shards(avs_net_socket_t **shards, size_t count) {
+    avs_error_t err = avs_net_socket_bind_shards(shards, count, DEFAULT_ADDRESS,
+                                                 DEFAULT_PORT);
+    if (err.category == AVS_ERRNO_CATEGORY && err.code == AVS_ENOTSUP) {
+        cleanup_shards(shards, count);
+        return false;
+    }
+    AVS_UNIT_ASSERT_SUCCESS(err);
+    return true;
+}
+
+static void assert_same_port(avs_net_socket_t *const *shards, size_t count) {
+    char first_port[16];
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_local_port(
+            shards[0], first_port, sizeof(first_port)));
+    for (size_t i = 1; i < count; ++i) {
+        char port[16];
+        AVS_UNIT_ASSERT_SUCCESS(
+                avs_net_socket_get_local_port(shards[i], port, sizeof(port)));
+        AVS_UNIT_ASSERT_EQUAL_STRING(port, first_port);
+    }
+}
+
+AVS_UNIT_TEST(socket_shards, tcp_accept) {
+    const avs_net_socket_configuration_t config = shard_config();
+    avs_net_socket_t *shards[SHARDS] = { NULL };
+    for (size_t i = 0; i < SHARDS; ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(&shards[i], &config));
+    }
+    if (!bind_shards(shards, SHARDS)) {
+        return;
+    }
+    assert_same_port(shards, SHARDS);
+
+    char port[16];
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_get_local_port(shards[0], port, sizeof(port)));
+    // enough connections that all of them being hashed to a single shard is
+    // practically impossible
+    avs_net_socket_t *clients[32] = { NULL };
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(clients); ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(&clients[i], NULL));
+        AVS_UNIT_ASSERT_SUCCESS(
+                avs_net_socket_connect(clients[i], DEFAULT_ADDRESS, port));
+    }
+
+    // every connection is accepted by exactly one of the shards
+    avs_net_poller_t *poller = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_create(&poller));
+    for (size_t i = 0; i < SHARDS; ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_add(
+                poller, shards[i], AVS_NET_POLLER_READ, NULL));
+    }
+    size_t accepted = 0;
+    size_t accepted_by_shard[SHARDS] = { 0 };
+    while (accepted < AVS_ARRAY_SIZE(clients)) {
+        avs_net_poller_event_t event;
+        size_t count;
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_wait(
+                poller, &event, 1, &count,
+                avs_time_duration_from_scalar(5, AVS_TIME_S)));
+        AVS_UNIT_ASSERT_EQUAL(count, 1);
+        avs_net_socket_t *server = NULL;
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(&server, NULL));
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_accept(event.socket, server));
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&server));
+        for (size_t i = 0; i < SHARDS; ++i) {
+            if (shards[i] == event.socket) {
+                ++accepted_by_shard[i];
+            }
+        }
+        ++accepted;
+    }
+    // the connections shall have been spread across the shards
+    size_t busy_shards = 0;
+    for (size_t i = 0; i < SHARDS; ++i) {
+        if (accepted_by_shard[i]) {
+            ++busy_shards;
+        }
+    }
+    AVS_UNIT_ASSERT_TRUE(busy_shards >= 2);
+    avs_net_poller_event_t event;
+    size_t count;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_wait(
+            poller, &event, 1, &count,
+            avs_time_duration_from_scalar(50, AVS_TIME_MS)));
+    AVS_UNIT_ASSERT_EQUAL(count, 0);
+
+    for (size_t i = 0; i < SHARDS; ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_remove(poller, shards[i]));
+    }
+    avs_net_poller_cleanup(&poller);
+    cleanup_shards(shards, SHARDS);
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(clients); ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&clients[i]));
+    }
+}
+
+AVS_UNIT_TEST(socket_shards, udp_accept) {
+    // reuse_port alone is enough for UDP accept
+    const avs_net_socket_configuration_t config = shard_config();
+    avs_net_socket_t *shards[2] = { NULL };
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(shards); ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_udp_socket_create(&shards[i], &config));
+    }
+    if (!bind_shards(shards, AVS_ARRAY_SIZE(shards))) {
+        return;
+    }
+    assert_same_port(shards, AVS_ARRAY_SIZE(shards));
+
+    char port[16];
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_get_local_port(shards[0], port, sizeof(port)));
+    avs_net_socket_t *client = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_udp_socket_create(&client, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_connect(client, DEFAULT_ADDRESS, port));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(client, "hello", 5));
+
+    avs_net_poller_t *poller = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_create(&poller));
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(shards); ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_add(
+                poller, shards[i], AVS_NET_POLLER_READ, NULL));
+    }
+    avs_net_poller_event_t event;
+    size_t count;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_wait(
+            poller, &event, 1, &count,
+            avs_time_duration_from_scalar(5, AVS_TIME_S)));
+    AVS_UNIT_ASSERT_EQUAL(count, 1);
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(shards); ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_poller_remove(poller, shards[i]));
+    }
+    avs_net_poller_cleanup(&poller);
+
+    avs_net_socket_t *server = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_udp_socket_create(&server, &config));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_accept(event.socket, server));
+
+    char buffer[16];
+    size_t bytes_received;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_receive(server, &bytes_received,
+                                                   buffer, sizeof(buffer)));
+    AVS_UNIT_ASSERT_EQUAL(bytes_received, 5);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buffer, "hello", 5);
+
+    // the shard has been re-bound to the same port
+    assert_same_port(shards, AVS_ARRAY_SIZE(shards));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&server));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&client));
+    cleanup_shards(shards, AVS_ARRAY_SIZE(shards));
+}
+
+AVS_UNIT_TEST(socket_shards, without_reuse_port) {
+    avs_net_socket_t *shards[2] = { NULL };
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(shards); ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(&shards[i], NULL));
+    }
+    AVS_UNIT_ASSERT_FAILED(
+            avs_net_socket_bind_shards(shards, AVS_ARRAY_SIZE(shards),
+                                       DEFAULT_ADDRESS, DEFAULT_PORT));
+
+    // the first shard shall have been closed again
+    avs_net_socket_opt_value_t state;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_opt(
+            shards[0], AVS_NET_SOCKET_OPT_STATE, &state));
+    AVS_UNIT_ASSERT_EQUAL(state.state, AVS_NET_SOCKET_STATE_CLOSED);
+
+    cleanup_shards(shards, AVS_ARRAY_SIZE(shards));
+}
+
+AVS_UNIT_TEST(socket_shards, empty) {
+    avs_error_t err =
+            avs_net_socket_bind_shards(NULL, 0, DEFAULT_ADDRESS, DEFAULT_PORT);
+    AVS_UNIT_ASSERT_EQUAL(err.category, AVS_ERRNO_CATEGORY);
+    AVS_UNIT_ASSERT_EQUAL(err.code, AVS_EINVAL);
+}
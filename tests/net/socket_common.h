@@ -31,6 +31,10 @@ static uint32_t default_ciphersuites[] = { 0xC0A8, 0xC0AE };
 static uint32_t default_ciphersuites_num =
         sizeof(default_ciphersuites) / sizeof(uint32_t);
 
+static inline bool is_errno(avs_error_t err, avs_errno_t code) {
+    return err.category == AVS_ERRNO_CATEGORY && err.code == code;
+}
+
 static inline avs_net_ssl_configuration_t create_default_ssl_config() {
     avs_net_ssl_configuration_t config = {
         .version = AVS_NET_SSL_VERSION_DEFAULT,
@@ -71,4 +75,42 @@ cleanup_default_ssl_config(avs_net_ssl_configuration_t *config) {
     avs_crypto_prng_free(&config->prng_ctx);
 }
 
+/**
+ * Creates a UDP socket bound to an ephemeral port on DEFAULT_ADDRESS, and
+ * another UDP socket connected to it.
+ */
+static inline void create_udp_pair(avs_net_socket_t **out_client,
+                                   avs_net_socket_t **out_server) {
+    char port[16];
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_udp_socket_create(out_server, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_bind(*out_server, DEFAULT_ADDRESS, DEFAULT_PORT));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_get_local_port(*out_server, port, sizeof(port)));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_udp_socket_create(out_client, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_connect(*out_client, DEFAULT_ADDRESS, port));
+}
+
+/**
+ * Creates a connected pair of TCP sockets, using a temporary listening socket
+ * bound to an ephemeral port on DEFAULT_ADDRESS.
+ */
+static inline void create_tcp_pair(avs_net_socket_t **out_client,
+                                   avs_net_socket_t **out_server) {
+    avs_net_socket_t *listener = NULL;
+    char port[16];
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(&listener, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_bind(listener, DEFAULT_ADDRESS, DEFAULT_PORT));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_get_local_port(listener, port, sizeof(port)));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(out_client, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_connect(*out_client, DEFAULT_ADDRESS, port));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(out_server, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_accept(listener, *out_server));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&listener));
+}
+
 #endif /* AVS_COMMONS_TEST_SOCKET_COMMON_H */
@@ -69,6 +69,8 @@ run_socket_set_opt_test_cases(avs_net_socket_t *socket,
             break;
         case AVS_NET_SOCKET_OPT_SESSION_RESUMED:
         case AVS_NET_SOCKET_HAS_BUFFERED_DATA:
+        case AVS_NET_SOCKET_OPT_UDP_GRO:
+        case AVS_NET_SOCKET_OPT_DATAGRAM:
             opt_val.flag = true;
             break;
         case AVS_NET_SOCKET_OPT_BYTES_SENT:
@@ -44,7 +44,8 @@ AVS_UNIT_TEST(socket, udp_get_opt) {
         { SUCCESS, AVS_NET_SOCKET_OPT_BYTES_SENT },
         { SUCCESS, AVS_NET_SOCKET_OPT_BYTES_RECEIVED },
         { SUCCESS, AVS_NET_SOCKET_HAS_BUFFERED_DATA },
-        { FAIL, AVS_NET_SOCKET_OPT_DTLS_HANDSHAKE_TIMEOUTS }
+        { FAIL, AVS_NET_SOCKET_OPT_DTLS_HANDSHAKE_TIMEOUTS },
+        { SUCCESS, AVS_NET_SOCKET_OPT_DATAGRAM }
     };
     run_socket_get_opt_test_cases(socket, test_cases,
                                   AVS_ARRAY_SIZE(test_cases));
@@ -69,7 +70,8 @@ AVS_UNIT_TEST(socket, tcp_get_opt) {
         { SUCCESS, AVS_NET_SOCKET_OPT_BYTES_SENT },
         { SUCCESS, AVS_NET_SOCKET_OPT_BYTES_RECEIVED },
         { SUCCESS, AVS_NET_SOCKET_HAS_BUFFERED_DATA },
-        { FAIL, AVS_NET_SOCKET_OPT_DTLS_HANDSHAKE_TIMEOUTS }
+        { FAIL, AVS_NET_SOCKET_OPT_DTLS_HANDSHAKE_TIMEOUTS },
+        { SUCCESS, AVS_NET_SOCKET_OPT_DATAGRAM }
     };
     run_socket_get_opt_test_cases(socket, test_cases,
                                   AVS_ARRAY_SIZE(test_cases));
@@ -97,7 +99,8 @@ AVS_UNIT_TEST(socket, udp_get_opt_after_close) {
         { SUCCESS, AVS_NET_SOCKET_OPT_BYTES_SENT },
         { SUCCESS, AVS_NET_SOCKET_OPT_BYTES_RECEIVED },
         { SUCCESS, AVS_NET_SOCKET_HAS_BUFFERED_DATA },
-        { FAIL, AVS_NET_SOCKET_OPT_DTLS_HANDSHAKE_TIMEOUTS }
+        { FAIL, AVS_NET_SOCKET_OPT_DTLS_HANDSHAKE_TIMEOUTS },
+        { SUCCESS, AVS_NET_SOCKET_OPT_DATAGRAM }
     };
     run_socket_get_opt_test_cases(socket, test_cases,
                                   AVS_ARRAY_SIZE(test_cases));
@@ -123,7 +126,8 @@ AVS_UNIT_TEST(socket, tcp_get_opt_after_close) {
         { SUCCESS, AVS_NET_SOCKET_OPT_BYTES_SENT },
         { SUCCESS, AVS_NET_SOCKET_OPT_BYTES_RECEIVED },
         { SUCCESS, AVS_NET_SOCKET_HAS_BUFFERED_DATA },
-        { FAIL, AVS_NET_SOCKET_OPT_DTLS_HANDSHAKE_TIMEOUTS }
+        { FAIL, AVS_NET_SOCKET_OPT_DTLS_HANDSHAKE_TIMEOUTS },
+        { SUCCESS, AVS_NET_SOCKET_OPT_DATAGRAM }
     };
     run_socket_get_opt_test_cases(socket, test_cases,
                                   AVS_ARRAY_SIZE(test_cases));
@@ -150,7 +154,8 @@ AVS_UNIT_TEST(socket, udp_set_opt) {
         { FAIL, AVS_NET_SOCKET_OPT_BYTES_SENT },
         { FAIL, AVS_NET_SOCKET_OPT_BYTES_RECEIVED },
         { FAIL, AVS_NET_SOCKET_HAS_BUFFERED_DATA },
-        { FAIL, AVS_NET_SOCKET_OPT_DTLS_HANDSHAKE_TIMEOUTS }
+        { FAIL, AVS_NET_SOCKET_OPT_DTLS_HANDSHAKE_TIMEOUTS },
+        { FAIL, AVS_NET_SOCKET_OPT_DATAGRAM }
     };
     run_socket_set_opt_test_cases(socket, test_cases,
                                   AVS_ARRAY_SIZE(test_cases));
@@ -175,7 +180,8 @@ AVS_UNIT_TEST(socket, tcp_set_opt) {
         { FAIL, AVS_NET_SOCKET_OPT_BYTES_SENT },
         { FAIL, AVS_NET_SOCKET_OPT_BYTES_RECEIVED },
         { FAIL, AVS_NET_SOCKET_HAS_BUFFERED_DATA },
-        { FAIL, AVS_NET_SOCKET_OPT_DTLS_HANDSHAKE_TIMEOUTS }
+        { FAIL, AVS_NET_SOCKET_OPT_DTLS_HANDSHAKE_TIMEOUTS },
+        { FAIL, AVS_NET_SOCKET_OPT_DATAGRAM }
     };
     run_socket_set_opt_test_cases(socket, test_cases,
                                   AVS_ARRAY_SIZE(test_cases));
@@ -203,7 +209,8 @@ AVS_UNIT_TEST(socket, udp_set_opt_after_close) {
         { FAIL, AVS_NET_SOCKET_OPT_BYTES_SENT },
         { FAIL, AVS_NET_SOCKET_OPT_BYTES_RECEIVED },
         { FAIL, AVS_NET_SOCKET_HAS_BUFFERED_DATA },
-        { FAIL, AVS_NET_SOCKET_OPT_DTLS_HANDSHAKE_TIMEOUTS }
+        { FAIL, AVS_NET_SOCKET_OPT_DTLS_HANDSHAKE_TIMEOUTS },
+        { FAIL, AVS_NET_SOCKET_OPT_DATAGRAM }
     };
     run_socket_set_opt_test_cases(socket, test_cases,
                                   AVS_ARRAY_SIZE(test_cases));
@@ -229,10 +236,247 @@ AVS_UNIT_TEST(socket, tcp_set_opt_after_close) {
         { FAIL, AVS_NET_SOCKET_OPT_BYTES_SENT },
         { FAIL, AVS_NET_SOCKET_OPT_BYTES_RECEIVED },
         { FAIL, AVS_NET_SOCKET_HAS_BUFFERED_DATA },
-        { FAIL, AVS_NET_SOCKET_OPT_DTLS_HANDSHAKE_TIMEOUTS }
+        { FAIL, AVS_NET_SOCKET_OPT_DTLS_HANDSHAKE_TIMEOUTS },
+        { FAIL, AVS_NET_SOCKET_OPT_DATAGRAM }
     };
     run_socket_set_opt_test_cases(socket, test_cases,
                                   AVS_ARRAY_SIZE(test_cases));
 
     AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&socket));
 }
+
+//// optimistic I/O ////////////////////////////////////////////////////////////
+
+#ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+static uint64_t get_poll_count(avs_net_socket_t *socket) {
+    avs_net_socket_stats_t stats;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_stats(socket, &stats));
+    return stats.polls;
+}
+#endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
+
+AVS_UNIT_TEST(socket, udp_optimistic_io) {
+    avs_net_socket_configuration_t config;
+    memset(&config, 0, sizeof(config));
+    config.optimistic_io = true;
+
+    avs_net_socket_t *server = NULL;
+    avs_net_socket_t *client = NULL;
+    char port[16];
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_udp_socket_create(&server, &config));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_bind(server, DEFAULT_ADDRESS, DEFAULT_PORT));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_get_local_port(server, port, sizeof(port)));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_udp_socket_create(&client, &config));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_connect(client, DEFAULT_ADDRESS, port));
+
+    // nothing queued: falls back to waiting, which times out
+    avs_net_socket_opt_value_t timeout = {
+        .recv_timeout = avs_time_duration_from_scalar(10, AVS_TIME_MS)
+    };
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_set_opt(
+            server, AVS_NET_SOCKET_OPT_RECV_TIMEOUT, timeout));
+    char buf[16];
+    size_t received;
+    avs_error_t err =
+            avs_net_socket_receive(server, &received, buf, sizeof(buf));
+    AVS_UNIT_ASSERT_EQUAL(err.category, AVS_ERRNO_CATEGORY);
+    AVS_UNIT_ASSERT_EQUAL(err.code, AVS_ETIMEDOUT);
+#ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+    const uint64_t server_polls = get_poll_count(server);
+    const uint64_t client_polls = get_poll_count(client);
+    AVS_UNIT_ASSERT_TRUE(server_polls > 0);
+#endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
+
+    // data queued: received immediately, even with zero timeout
+    timeout.recv_timeout = AVS_TIME_DURATION_ZERO;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_set_opt(
+            server, AVS_NET_SOCKET_OPT_RECV_TIMEOUT, timeout));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(client, "ping", 4));
+    char host[64];
+    char client_port[16];
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_receive_from(
+            server, &received, buf, sizeof(buf), host, sizeof(host),
+            client_port, sizeof(client_port)));
+    AVS_UNIT_ASSERT_EQUAL(received, 4);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, "ping", 4);
+
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_send_to(server, "pong", 4, host, client_port));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_receive(client, &received, buf, sizeof(buf)));
+    AVS_UNIT_ASSERT_EQUAL(received, 4);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, "pong", 4);
+#ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+    // none of the operations above needed to wait
+    AVS_UNIT_ASSERT_EQUAL(get_poll_count(server), server_polls);
+    AVS_UNIT_ASSERT_EQUAL(get_poll_count(client), client_polls);
+#endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&server));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&client));
+}
+
+AVS_UNIT_TEST(socket, tcp_optimistic_io) {
+    avs_net_socket_configuration_t config;
+    memset(&config, 0, sizeof(config));
+    config.optimistic_io = true;
+
+    avs_net_socket_t *listener = NULL;
+    avs_net_socket_t *server = NULL;
+    avs_net_socket_t *client = NULL;
+    char port[16];
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(&listener, &config));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_bind(listener, DEFAULT_ADDRESS, DEFAULT_PORT));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_get_local_port(listener, port, sizeof(port)));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(&client, &config));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_connect(client, DEFAULT_ADDRESS, port));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(&server, &config));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_accept(listener, server));
+#ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+    const uint64_t client_polls = get_poll_count(client);
+#endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(client, "hello", 5));
+    char buf[16];
+    size_t received = 0;
+    size_t total = 0;
+    while (total < 5) {
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_receive(
+                server, &received, buf + total, sizeof(buf) - total));
+        total += received;
+    }
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, "hello", 5);
+#ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+    // the connection was already queued when accepting, and the data was
+    // already queued when receiving
+    AVS_UNIT_ASSERT_EQUAL(get_poll_count(listener), 0);
+    AVS_UNIT_ASSERT_EQUAL(get_poll_count(client), client_polls);
+    AVS_UNIT_ASSERT_EQUAL(get_poll_count(server), 0);
+#endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&server));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&client));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&listener));
+}
+
+AVS_UNIT_TEST(socket, tcp_connection_attempt_delay) {
+    const avs_time_duration_t delays[] = {
+        AVS_TIME_DURATION_ZERO, avs_time_duration_from_scalar(10, AVS_TIME_MS),
+        AVS_NET_SOCKET_RECOMMENDED_CONNECTION_ATTEMPT_DELAY,
+        AVS_TIME_DURATION_INVALID
+    };
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(delays); ++i) {
+        avs_net_resolved_endpoint_t preferred_endpoint;
+        memset(&preferred_endpoint, 0, sizeof(preferred_endpoint));
+        avs_net_socket_configuration_t config;
+        memset(&config, 0, sizeof(config));
+        config.connection_attempt_delay = delays[i];
+        config.preferred_endpoint = &preferred_endpoint;
+
+        avs_net_socket_t *listener = NULL;
+        avs_net_socket_t *server = NULL;
+        avs_net_socket_t *client = NULL;
+        char port[16];
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(&listener, NULL));
+        AVS_UNIT_ASSERT_SUCCESS(
+                avs_net_socket_bind(listener, DEFAULT_ADDRESS, DEFAULT_PORT));
+        AVS_UNIT_ASSERT_SUCCESS(
+                avs_net_socket_get_local_port(listener, port, sizeof(port)));
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(&client, &config));
+        AVS_UNIT_ASSERT_SUCCESS(
+                avs_net_socket_connect(client, DEFAULT_ADDRESS, port));
+        AVS_UNIT_ASSERT_TRUE(preferred_endpoint.size > 0);
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(&server, NULL));
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_accept(listener, server));
+
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(client, "hello", 5));
+        char buf[16];
+        size_t received = 0;
+        size_t total = 0;
+        while (total < 5) {
+            AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_receive(
+                    server, &received, buf + total, sizeof(buf) - total));
+            total += received;
+        }
+        AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, "hello", 5);
+
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&server));
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&client));
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&listener));
+    }
+}
+
+AVS_UNIT_TEST(socket, tcp_parallel_connect_refused) {
+    avs_net_socket_t *listener = NULL;
+    avs_net_socket_t *client = NULL;
+    char port[16];
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(&listener, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_bind(listener, DEFAULT_ADDRESS, DEFAULT_PORT));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_get_local_port(listener, port, sizeof(port)));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&listener));
+
+    // a refused attempt shall not wait for the attempt delay, nor time out
+    avs_net_socket_configuration_t config;
+    memset(&config, 0, sizeof(config));
+    config.connection_attempt_delay =
+            AVS_NET_SOCKET_RECOMMENDED_CONNECTION_ATTEMPT_DELAY;
+    avs_time_monotonic_t start = avs_time_monotonic_now();
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_tcp_socket_create(&client, &config));
+    avs_error_t err = avs_net_socket_connect(client, DEFAULT_ADDRESS, port);
+    AVS_UNIT_ASSERT_EQUAL(err.category, AVS_ERRNO_CATEGORY);
+    AVS_UNIT_ASSERT_EQUAL(err.code, AVS_ECONNREFUSED);
+    AVS_UNIT_ASSERT_TRUE(avs_time_duration_less(
+            avs_time_monotonic_diff(avs_time_monotonic_now(), start),
+            avs_time_duration_from_scalar(5, AVS_TIME_S)));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&client));
+}
+
+//// avs_net_socket_debug //////////////////////////////////////////////////////
+
+#ifdef AVS_COMMONS_NET_WITH_SOCKET_LOG
+AVS_UNIT_TEST(socket, debug_socket_forwards_extended_operations) {
+    int prev_debug = avs_net_socket_debug(1);
+    avs_net_socket_t *client = NULL;
+    avs_net_socket_t *server = NULL;
+    create_udp_pair(&client, &server);
+
+    const avs_net_socket_outgoing_buffer_t out_buffers[] = {
+        { "pi", 2 },
+        { "ng", 2 }
+    };
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_sendv(
+            client, out_buffers, AVS_ARRAY_SIZE(out_buffers)));
+
+    char buf[16];
+    avs_net_socket_received_datagram_t datagram;
+    memset(&datagram, 0, sizeof(datagram));
+    datagram.buffer = buf;
+    datagram.buffer_length = sizeof(buf);
+    size_t received;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_receive_batch(server, &datagram, 1, &received));
+    AVS_UNIT_ASSERT_EQUAL(received, 1);
+    AVS_UNIT_ASSERT_EQUAL(datagram.bytes_received, 4);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, "ping", 4);
+
+#    ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+    avs_net_socket_stats_t stats;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_stats(client, &stats));
+    AVS_UNIT_ASSERT_EQUAL(stats.send_latency.count, 1);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_stats(server, &stats));
+    AVS_UNIT_ASSERT_EQUAL(stats.receive_latency.count, 1);
+#    endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&client));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&server));
+    avs_net_socket_debug(prev_debug);
+}
+#endif // AVS_COMMONS_NET_WITH_SOCKET_LOG
@@ -50,7 +50,8 @@ AVS_UNIT_TEST(socket, ssl_get_opt) {
         { SUCCESS, AVS_NET_SOCKET_OPT_BYTES_SENT },
         { SUCCESS, AVS_NET_SOCKET_OPT_BYTES_RECEIVED },
         { SUCCESS, AVS_NET_SOCKET_HAS_BUFFERED_DATA },
-        { FAIL, AVS_NET_SOCKET_OPT_DTLS_HANDSHAKE_TIMEOUTS }
+        { FAIL, AVS_NET_SOCKET_OPT_DTLS_HANDSHAKE_TIMEOUTS },
+        { SUCCESS, AVS_NET_SOCKET_OPT_DATAGRAM }
     };
     run_socket_get_opt_test_cases(socket, test_cases,
                                   AVS_ARRAY_SIZE(test_cases));
@@ -80,7 +81,8 @@ AVS_UNIT_TEST(socket, ssl_get_opt_after_close) {
         { SUCCESS, AVS_NET_SOCKET_OPT_BYTES_SENT },
         { SUCCESS, AVS_NET_SOCKET_OPT_BYTES_RECEIVED },
         { SUCCESS, AVS_NET_SOCKET_HAS_BUFFERED_DATA },
-        { FAIL, AVS_NET_SOCKET_OPT_DTLS_HANDSHAKE_TIMEOUTS }
+        { FAIL, AVS_NET_SOCKET_OPT_DTLS_HANDSHAKE_TIMEOUTS },
+        { SUCCESS, AVS_NET_SOCKET_OPT_DATAGRAM }
     };
     run_socket_get_opt_test_cases(socket, test_cases,
                                   AVS_ARRAY_SIZE(test_cases));
@@ -109,7 +111,8 @@ AVS_UNIT_TEST(socket, ssl_set_opt) {
         { FAIL, AVS_NET_SOCKET_OPT_BYTES_SENT },
         { FAIL, AVS_NET_SOCKET_OPT_BYTES_RECEIVED },
         { FAIL, AVS_NET_SOCKET_HAS_BUFFERED_DATA },
-        { FAIL, AVS_NET_SOCKET_OPT_DTLS_HANDSHAKE_TIMEOUTS }
+        { FAIL, AVS_NET_SOCKET_OPT_DTLS_HANDSHAKE_TIMEOUTS },
+        { FAIL, AVS_NET_SOCKET_OPT_DATAGRAM }
     };
     run_socket_set_opt_test_cases(socket, test_cases,
                                   AVS_ARRAY_SIZE(test_cases));
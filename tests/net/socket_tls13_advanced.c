@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <avsystem/commons/avs_stream_membuf.h>
+
 #include "socket_tls13_common.h"
 
 AVS_UNIT_TEST(tls13, verify_with_explicit_version) {
@@ -66,6 +68,62 @@ AVS_UNIT_TEST(tls13, session_resumption) {
     AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&socket));
 }
 
+#ifdef AVS_COMMONS_NET_WITH_TLS_SESSION_CACHE
+static bool connect_from_context(avs_net_ssl_context_t *context,
+                                 const char *port) {
+    const avs_net_ssl_configuration_t socket_config = {
+        .context = context
+    };
+    avs_net_socket_t *socket = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_ssl_socket_create(&socket, &socket_config));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_connect(socket, "localhost", port));
+    // session tickets are received after the handshake
+    socket_tls13_test_assert_connectivity(socket);
+
+    avs_net_socket_opt_value_t opt_value;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_opt(
+            socket, AVS_NET_SOCKET_OPT_SESSION_RESUMED, &opt_value));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&socket));
+    return opt_value.flag;
+}
+
+AVS_UNIT_TEST(tls13, session_cache) {
+    INIT_TLS13_TEST(SERVER_CERT_NOVERIFY);
+    const avs_net_ssl_session_cache_config_t cache_config = {
+        .max_entries = 8,
+        .max_session_size = 8192,
+        .ttl = avs_time_duration_from_scalar(1, AVS_TIME_MIN)
+    };
+    config.version = AVS_NET_SSL_VERSION_TLSv1_3;
+    config.session_cache = &cache_config;
+
+    avs_net_ssl_context_t *context = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_ssl_context_create(&context, &config));
+    AVS_UNIT_ASSERT_FALSE(connect_from_context(context, port));
+    AVS_UNIT_ASSERT_TRUE(connect_from_context(context, port));
+
+    // sessions survive a round trip through persistence
+    avs_stream_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    avs_persistence_context_t persistence =
+            avs_persistence_store_context_create(stream);
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_ssl_context_session_cache_persistence(&persistence,
+                                                          context));
+    avs_net_ssl_context_cleanup(&context);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_ssl_context_create(&context, &config));
+    persistence = avs_persistence_restore_context_create(stream);
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_ssl_context_session_cache_persistence(&persistence,
+                                                          context));
+    AVS_UNIT_ASSERT_TRUE(connect_from_context(context, port));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+    avs_net_ssl_context_cleanup(&context);
+}
+#endif // AVS_COMMONS_NET_WITH_TLS_SESSION_CACHE
+
 AVS_UNIT_TEST(tls13, psk) {
     INIT_TLS13_TEST(SERVER_PSK);
     config.version = AVS_NET_SSL_VERSION_TLSv1_3;
@@ -203,3 +203,36 @@ AVS_UNIT_TEST(tls13, ciphersuites) {
     socket_tls13_test_assert_connectivity(socket);
     AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&socket));
 }
+
+AVS_UNIT_TEST(tls13, shared_context) {
+    INIT_TLS13_TEST(SERVER_CERT_VERIFY, "-num_tickets 0");
+    avs_net_ssl_context_t *context = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_ssl_context_create(&context, &config));
+
+    // the trust store and client credentials are only loaded once
+    avs_net_ssl_configuration_t socket_config = {
+        .context = context
+    };
+    for (int i = 0; i < 3; ++i) {
+        avs_net_socket_t *socket = NULL;
+        AVS_UNIT_ASSERT_SUCCESS(
+                avs_net_ssl_socket_create(&socket, &socket_config));
+        AVS_UNIT_ASSERT_SUCCESS(
+                avs_net_socket_connect(socket, "localhost", port));
+        socket_tls13_test_assert_connectivity(socket);
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&socket));
+    }
+
+    // a DTLS context cannot be used for a TLS socket
+    avs_net_ssl_context_t *dtls_context = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_dtls_context_create(&dtls_context, &config));
+    socket_config.context = dtls_context;
+    avs_net_socket_t *socket = NULL;
+    avs_error_t err = avs_net_ssl_socket_create(&socket, &socket_config);
+    AVS_UNIT_ASSERT_EQUAL(err.category, AVS_ERRNO_CATEGORY);
+    AVS_UNIT_ASSERT_EQUAL(err.code, AVS_EINVAL);
+    AVS_UNIT_ASSERT_NULL(socket);
+
+    avs_net_ssl_context_cleanup(&dtls_context);
+    avs_net_ssl_context_cleanup(&context);
+}
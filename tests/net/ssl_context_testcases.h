@@ -0,0 +1,107 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Test cases for shared SSL contexts, common for all backends. Meant to be
+ * included in the backend-specific unit tests, as they need access to the
+ * ssl_socket_t and avs_net_ssl_context_t internals.
+ */
+
+#ifndef AVS_COMMONS_TEST_SSL_CONTEXT_TESTCASES_H
+#define AVS_COMMONS_TEST_SSL_CONTEXT_TESTCASES_H
+
+#include <avsystem/commons/avs_socket.h>
+#include <avsystem/commons/avs_unit_test.h>
+
+#ifdef AVS_COMMONS_COMPAT_THREADING_WITH_PTHREAD
+#    include <pthread.h>
+#endif // AVS_COMMONS_COMPAT_THREADING_WITH_PTHREAD
+
+#include "socket_common.h"
+
+AVS_UNIT_TEST(socket, shared_context) {
+    avs_net_ssl_configuration_t config = create_default_ssl_config();
+    avs_net_ssl_context_t *context = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_ssl_context_create(&context, &config));
+    AVS_UNIT_ASSERT_EQUAL(context->refcount, 1);
+
+    avs_net_ssl_configuration_t socket_config = {
+        .context = context
+    };
+    avs_net_socket_t *sockets[2] = { NULL };
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(sockets); ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(
+                avs_net_ssl_socket_create(&sockets[i], &socket_config));
+        AVS_UNIT_ASSERT_TRUE(((ssl_socket_t *) sockets[i])->context == context);
+    }
+    AVS_UNIT_ASSERT_EQUAL(context->refcount, 3);
+
+    // the sockets keep the context alive
+    avs_net_ssl_context_t *context_ref = context;
+    avs_net_ssl_context_cleanup(&context);
+    AVS_UNIT_ASSERT_NULL(context);
+    AVS_UNIT_ASSERT_EQUAL(context_ref->refcount, 2);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&sockets[0]));
+    AVS_UNIT_ASSERT_EQUAL(context_ref->refcount, 1);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&sockets[1]));
+
+    cleanup_default_ssl_config(&config);
+}
+
+#ifdef AVS_COMMONS_COMPAT_THREADING_WITH_PTHREAD
+#    define SHARED_CONTEXT_THREADS 4
+#    define SHARED_CONTEXT_ITERATIONS 500
+
+static void *create_sockets_with_context(void *context) {
+    const avs_net_ssl_configuration_t socket_config = {
+        .context = (avs_net_ssl_context_t *) context
+    };
+    for (size_t i = 0; i < SHARED_CONTEXT_ITERATIONS; ++i) {
+        avs_net_socket_t *socket = NULL;
+        if (avs_is_err(avs_net_ssl_socket_create(&socket, &socket_config))
+                || avs_is_err(avs_net_socket_cleanup(&socket))) {
+            return context;
+        }
+    }
+    return NULL;
+}
+
+AVS_UNIT_TEST(socket, shared_context_threads) {
+    avs_net_ssl_configuration_t config = create_default_ssl_config();
+    avs_net_ssl_context_t *context = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_ssl_context_create(&context, &config));
+
+    pthread_t threads[SHARED_CONTEXT_THREADS];
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(threads); ++i) {
+        AVS_UNIT_ASSERT_EQUAL(pthread_create(&threads[i], NULL,
+                                             create_sockets_with_context,
+                                             context),
+                              0);
+    }
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(threads); ++i) {
+        void *failed;
+        AVS_UNIT_ASSERT_EQUAL(pthread_join(threads[i], &failed), 0);
+        AVS_UNIT_ASSERT_NULL(failed);
+    }
+    // every reference taken by the threads shall have been released
+    AVS_UNIT_ASSERT_EQUAL(context->refcount, 1);
+
+    avs_net_ssl_context_cleanup(&context);
+    cleanup_default_ssl_config(&config);
+}
+#endif // AVS_COMMONS_COMPAT_THREADING_WITH_PTHREAD
+
+#endif /* AVS_COMMONS_TEST_SSL_CONTEXT_TESTCASES_H */
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avsystem/commons/avs_unit_mocksock.h>
+
+#include "socket_common.h"
+
+static void assert_enotsup(avs_error_t err) {
+    AVS_UNIT_ASSERT_EQUAL(err.category, AVS_ERRNO_CATEGORY);
+    AVS_UNIT_ASSERT_EQUAL(err.code, AVS_ENOTSUP);
+}
+
+#ifdef AVS_COMMONS_NET_WITH_SOCKET_STATS
+static uint64_t histogram_sum(const avs_net_socket_histogram_t *histogram) {
+    uint64_t result = 0;
+    for (size_t i = 0; i < AVS_NET_SOCKET_HISTOGRAM_BUCKETS; ++i) {
+        result += histogram->buckets[i];
+    }
+    return result;
+}
+
+AVS_UNIT_TEST(socket_stats, udp_roundtrip) {
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_reset_global_stats());
+
+    avs_net_socket_t *client = NULL;
+    avs_net_socket_t *server = NULL;
+    char port[16];
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_udp_socket_create(&server, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_bind(server, DEFAULT_ADDRESS, DEFAULT_PORT));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_get_local_port(server, port, sizeof(port)));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_udp_socket_create(&client, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_connect(client, DEFAULT_ADDRESS, port));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(client, "ping", 4));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(client, "pong", 4));
+    char buffer[16];
+    size_t bytes_received;
+    for (int i = 0; i < 2; ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_receive(
+                server, &bytes_received, buffer, sizeof(buffer)));
+        AVS_UNIT_ASSERT_EQUAL(bytes_received, 4);
+    }
+
+    avs_net_socket_stats_t stats;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_stats(client, &stats));
+    AVS_UNIT_ASSERT_EQUAL(stats.send_latency.count, 2);
+    AVS_UNIT_ASSERT_EQUAL(histogram_sum(&stats.send_latency), 2);
+    AVS_UNIT_ASSERT_EQUAL(stats.receive_latency.count, 0);
+    AVS_UNIT_ASSERT_EQUAL(stats.handshake_time.count, 0);
+    AVS_UNIT_ASSERT_TRUE(stats.syscalls >= 2);
+    AVS_UNIT_ASSERT_FALSE(avs_time_duration_less(stats.send_latency.total,
+                                                 stats.send_latency.max));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_stats(server, &stats));
+    AVS_UNIT_ASSERT_EQUAL(stats.send_latency.count, 0);
+    AVS_UNIT_ASSERT_EQUAL(stats.receive_latency.count, 2);
+    AVS_UNIT_ASSERT_EQUAL(histogram_sum(&stats.receive_latency), 2);
+    AVS_UNIT_ASSERT_TRUE(stats.syscalls >= 2);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_get_global_stats(&stats));
+    AVS_UNIT_ASSERT_EQUAL(stats.send_latency.count, 2);
+    AVS_UNIT_ASSERT_EQUAL(stats.receive_latency.count, 2);
+    AVS_UNIT_ASSERT_TRUE(stats.syscalls >= 4);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_reset_global_stats());
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_get_global_stats(&stats));
+    AVS_UNIT_ASSERT_EQUAL(stats.send_latency.count, 0);
+    AVS_UNIT_ASSERT_EQUAL(stats.receive_latency.count, 0);
+    AVS_UNIT_ASSERT_EQUAL(stats.syscalls, 0);
+
+    // resetting global statistics does not affect per-socket ones
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_stats(server, &stats));
+    AVS_UNIT_ASSERT_EQUAL(stats.receive_latency.count, 2);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&client));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&server));
+}
+
+AVS_UNIT_TEST(socket_stats, receive_timeout) {
+    avs_net_socket_t *socket = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_udp_socket_create(&socket, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_bind(socket, DEFAULT_ADDRESS, DEFAULT_PORT));
+    avs_net_socket_opt_value_t timeout = {
+        .recv_timeout = avs_time_duration_from_scalar(50, AVS_TIME_MS)
+    };
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_set_opt(
+            socket, AVS_NET_SOCKET_OPT_RECV_TIMEOUT, timeout));
+
+    char buffer[16];
+    size_t bytes_received;
+    avs_error_t err = avs_net_socket_receive(socket, &bytes_received, buffer,
+                                             sizeof(buffer));
+    AVS_UNIT_ASSERT_EQUAL(err.category, AVS_ERRNO_CATEGORY);
+    AVS_UNIT_ASSERT_EQUAL(err.code, AVS_ETIMEDOUT);
+
+    avs_net_socket_stats_t stats;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_stats(socket, &stats));
+    // failed operations are counted as well
+    AVS_UNIT_ASSERT_EQUAL(stats.receive_latency.count, 1);
+    AVS_UNIT_ASSERT_TRUE(stats.polls >= 1);
+    AVS_UNIT_ASSERT_FALSE(avs_time_duration_less(
+            stats.poll_wait_time,
+            avs_time_duration_from_scalar(40, AVS_TIME_MS)));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&socket));
+}
+#else  // AVS_COMMONS_NET_WITH_SOCKET_STATS
+AVS_UNIT_TEST(socket_stats, disabled) {
+    avs_net_socket_t *socket = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_udp_socket_create(&socket, NULL));
+    avs_net_socket_stats_t stats;
+    assert_enotsup(avs_net_socket_get_stats(socket, &stats));
+    assert_enotsup(avs_net_get_global_stats(&stats));
+    assert_enotsup(avs_net_reset_global_stats());
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&socket));
+}
+#endif // AVS_COMMONS_NET_WITH_SOCKET_STATS
+
+AVS_UNIT_TEST(socket_stats, unsupported_socket) {
+    // mock sockets do not gather statistics
+    avs_net_socket_t *socket = NULL;
+    avs_unit_mocksock_create(&socket);
+    avs_net_socket_stats_t stats;
+    assert_enotsup(avs_net_socket_get_stats(socket, &stats));
+    avs_net_socket_cleanup(&socket);
+}
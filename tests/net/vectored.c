@@ -0,0 +1,204 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include <avsystem/commons/avs_unit_mocksock.h>
+
+#include "socket_common.h"
+
+AVS_UNIT_TEST(socket_vectored, tcp_send) {
+    avs_net_socket_t *client = NULL;
+    avs_net_socket_t *server = NULL;
+    create_tcp_pair(&client, &server);
+
+    static char payload[50000];
+    for (size_t i = 0; i < sizeof(payload); ++i) {
+        payload[i] = (char) ('a' + i % 26);
+    }
+    const avs_net_socket_outgoing_buffer_t buffers[] = {
+        { "1000\r\n", 6 },
+        { NULL, 0 },
+        { payload, sizeof(payload) },
+        { "\r\n", 2 }
+    };
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_sendv(client, buffers, AVS_ARRAY_SIZE(buffers)));
+
+    static char received[sizeof(payload) + 8];
+    size_t total = 0;
+    while (total < sizeof(received)) {
+        size_t bytes_received;
+        AVS_UNIT_ASSERT_SUCCESS(
+                avs_net_socket_receive(server, &bytes_received,
+                                       received + total,
+                                       sizeof(received) - total));
+        AVS_UNIT_ASSERT_NOT_EQUAL(bytes_received, 0);
+        total += bytes_received;
+    }
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(received, "1000\r\n", 6);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(received + 6, payload, sizeof(payload));
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(received + 6 + sizeof(payload), "\r\n",
+                                      2);
+
+    avs_net_socket_opt_value_t bytes;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_opt(
+            client, AVS_NET_SOCKET_OPT_BYTES_SENT, &bytes));
+    AVS_UNIT_ASSERT_EQUAL(bytes.bytes_sent, sizeof(received));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&client));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&server));
+}
+
+// without recvmsg(), receivev() only fills the first buffer
+#ifdef AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_RECVMSG
+AVS_UNIT_TEST(socket_vectored, udp_roundtrip) {
+    avs_net_socket_t *client = NULL;
+    avs_net_socket_t *server = NULL;
+    create_udp_pair(&client, &server);
+
+    const avs_net_socket_outgoing_buffer_t out_buffers[] = {
+        { "head", 4 },
+        { "payload", 7 }
+    };
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_sendv(client, out_buffers,
+                                                 AVS_ARRAY_SIZE(out_buffers)));
+
+    char header[4];
+    char body[32];
+    const avs_net_socket_incoming_buffer_t in_buffers[] = {
+        { header, sizeof(header) },
+        { body, sizeof(body) }
+    };
+    size_t bytes_received;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_receivev(server, &bytes_received, in_buffers,
+                                    AVS_ARRAY_SIZE(in_buffers)));
+    // the fragments shall have been sent as a single datagram
+    AVS_UNIT_ASSERT_EQUAL(bytes_received, 11);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(header, "head", 4);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(body, "payload", 7);
+
+    avs_net_socket_opt_value_t bytes;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_opt(
+            server, AVS_NET_SOCKET_OPT_BYTES_RECEIVED, &bytes));
+    AVS_UNIT_ASSERT_EQUAL(bytes.bytes_received, 11);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&client));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&server));
+}
+
+AVS_UNIT_TEST(socket_vectored, udp_truncated) {
+    avs_net_socket_t *client = NULL;
+    avs_net_socket_t *server = NULL;
+    create_udp_pair(&client, &server);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(client, "0123456789", 10));
+
+    char first[3];
+    char second[4];
+    const avs_net_socket_incoming_buffer_t in_buffers[] = {
+        { first, sizeof(first) },
+        { second, sizeof(second) }
+    };
+    size_t bytes_received;
+    avs_error_t err = avs_net_socket_receivev(server, &bytes_received,
+                                              in_buffers,
+                                              AVS_ARRAY_SIZE(in_buffers));
+    AVS_UNIT_ASSERT_EQUAL(err.category, AVS_ERRNO_CATEGORY);
+    AVS_UNIT_ASSERT_EQUAL(err.code, AVS_EMSGSIZE);
+    AVS_UNIT_ASSERT_EQUAL(bytes_received, 7);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(first, "012", 3);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(second, "3456", 4);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&client));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&server));
+}
+
+#endif // AVS_COMMONS_NET_POSIX_AVS_SOCKET_HAVE_RECVMSG
+
+AVS_UNIT_TEST(socket_vectored, udp_many_buffers) {
+    avs_net_socket_t *client = NULL;
+    avs_net_socket_t *server = NULL;
+    create_udp_pair(&client, &server);
+
+    // more buffers than a single sendmsg() call is passed natively
+    static const char DATA[] = "0123456789abcdefghij";
+    avs_net_socket_outgoing_buffer_t out_buffers[sizeof(DATA) - 1];
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(out_buffers); ++i) {
+        out_buffers[i].data = &DATA[i];
+        out_buffers[i].data_length = 1;
+    }
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_sendv(client, out_buffers,
+                                                 AVS_ARRAY_SIZE(out_buffers)));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(client, "next", 4));
+
+    // the fragments shall still have been sent as a single datagram
+    char buffer[64];
+    size_t bytes_received;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_receive(server, &bytes_received,
+                                                   buffer, sizeof(buffer)));
+    AVS_UNIT_ASSERT_EQUAL(bytes_received, sizeof(DATA) - 1);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buffer, DATA, sizeof(DATA) - 1);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_receive(server, &bytes_received,
+                                                   buffer, sizeof(buffer)));
+    AVS_UNIT_ASSERT_EQUAL(bytes_received, 4);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buffer, "next", 4);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&client));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&server));
+}
+
+AVS_UNIT_TEST(socket_vectored, fallback) {
+    // mock sockets do not implement vectored I/O natively
+    avs_net_socket_t *socket = NULL;
+    avs_unit_mocksock_create(&socket);
+    avs_unit_mocksock_expect_connect(socket, "host", "1234");
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_connect(socket, "host", "1234"));
+
+    const avs_net_socket_outgoing_buffer_t out_buffers[] = {
+        { "head", 4 },
+        { NULL, 0 },
+        { "payload", 7 }
+    };
+    avs_unit_mocksock_expect_output(socket, "head", 4);
+    avs_unit_mocksock_expect_output(socket, "payload", 7);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_sendv(socket, out_buffers,
+                                                 AVS_ARRAY_SIZE(out_buffers)));
+
+    char first[8];
+    char second[8];
+    const avs_net_socket_incoming_buffer_t in_buffers[] = {
+        { NULL, 0 },
+        { first, sizeof(first) },
+        { second, sizeof(second) }
+    };
+    size_t bytes_received;
+    avs_unit_mocksock_input(socket, "0123456789", 10);
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_receivev(socket, &bytes_received, in_buffers,
+                                    AVS_ARRAY_SIZE(in_buffers)));
+    AVS_UNIT_ASSERT_EQUAL(bytes_received, 8);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(first, "01234567", 8);
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_receivev(socket, &bytes_received, in_buffers,
+                                    AVS_ARRAY_SIZE(in_buffers)));
+    AVS_UNIT_ASSERT_EQUAL(bytes_received, 2);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(first, "89", 2);
+
+    avs_unit_mocksock_assert_io_clean(socket);
+    avs_net_socket_cleanup(&socket);
+}
@@ -17,6 +17,7 @@
 #define _GNU_SOURCE // for RTLD_NEXT
 #include <avs_commons_posix_init.h>
 
+#include <string.h>
 #include <time.h>
 
 #include <dlfcn.h>
@@ -25,6 +26,14 @@
 #include <avsystem/commons/avs_time.h>
 #include <avsystem/commons/avs_unit_test.h>
 
+#if defined(AVS_COMMONS_SCHED_THREAD_SAFE) \
+        && defined(AVS_COMMONS_COMPAT_THREADING_WITH_PTHREAD)
+#    define WITH_WORKER_TESTS
+#    include <pthread.h>
+
+#    include <avsystem/commons/avs_mutex.h>
+#endif
+
 #define MODULE_NAME sched_test
 #include <avs_x_log_config.h>
 
@@ -285,4 +294,450 @@ AVS_UNIT_TEST(sched, rescheduling_in_callback) {
     teardown_test(&env);
 }
 
+typedef struct {
+    int *log;
+    size_t *log_size;
+    int value;
+} order_logger_args_t;
+
+static void order_logger(avs_sched_t *sched, const void *args_) {
+    (void) sched;
+    const order_logger_args_t *args = (const order_logger_args_t *) args_;
+    args->log[(*args->log_size)++] = args->value;
+}
+
+AVS_UNIT_TEST(sched, fifo_order_for_equal_instants) {
+    sched_test_env_t env = setup_test();
+
+    int log[8];
+    size_t log_size = 0;
+    const avs_time_monotonic_t instant =
+            avs_time_monotonic_from_scalar(1, AVS_TIME_S);
+    avs_sched_handle_t handles[8] = { NULL };
+    for (int i = 0; i < 8; ++i) {
+        const order_logger_args_t args = { log, &log_size, i };
+        AVS_UNIT_ASSERT_SUCCESS(AVS_SCHED_AT(env.sched, &handles[i], instant,
+                                             order_logger, &args,
+                                             sizeof(args)));
+    }
+    // rescheduling to the same instant moves the job to the end of the queue
+    AVS_UNIT_ASSERT_SUCCESS(AVS_RESCHED_AT(&handles[2], instant));
+    avs_sched_del(&handles[5]);
+
+    mock_clock_advance(avs_time_duration_from_scalar(2, AVS_TIME_S));
+    avs_sched_run(env.sched);
+
+    AVS_UNIT_ASSERT_EQUAL(log_size, 7);
+    const int expected[] = { 0, 1, 3, 4, 6, 7, 2 };
+    for (size_t i = 0; i < log_size; ++i) {
+        AVS_UNIT_ASSERT_EQUAL(log[i], expected[i]);
+    }
+
+    teardown_test(&env);
+}
+
+AVS_UNIT_TEST(sched, many_jobs_ordering) {
+    sched_test_env_t env = setup_test();
+
+    enum { JOB_COUNT = 1000 };
+    static int log[JOB_COUNT];
+    static avs_sched_handle_t handles[JOB_COUNT];
+    size_t log_size = 0;
+    memset(handles, 0, sizeof(handles));
+
+    // values are scheduled in a scrambled order, at instants equal to them
+    for (int i = 0; i < JOB_COUNT; ++i) {
+        const order_logger_args_t args = { log, &log_size,
+                                           (i * 7919) % JOB_COUNT };
+        AVS_UNIT_ASSERT_SUCCESS(AVS_SCHED_AT(
+                env.sched, &handles[args.value],
+                avs_time_monotonic_from_scalar(args.value + 1, AVS_TIME_MS),
+                order_logger, &args, sizeof(args)));
+    }
+    // cancel every third job, and move every fifth one to the end
+    for (int i = 0; i < JOB_COUNT; ++i) {
+        if (i % 3 == 0) {
+            avs_sched_del(&handles[i]);
+            AVS_UNIT_ASSERT_NULL(handles[i]);
+        } else if (i % 5 == 0) {
+            AVS_UNIT_ASSERT_SUCCESS(AVS_RESCHED_AT(
+                    &handles[i],
+                    avs_time_monotonic_from_scalar(JOB_COUNT + 1,
+                                                   AVS_TIME_MS)));
+        }
+    }
+    AVS_UNIT_ASSERT_TRUE(avs_time_monotonic_equal(
+            avs_sched_time_of_next(env.sched),
+            avs_time_monotonic_from_scalar(2, AVS_TIME_MS)));
+
+    mock_clock_advance(avs_time_duration_from_scalar(JOB_COUNT, AVS_TIME_MS));
+    avs_sched_run(env.sched);
+    for (size_t i = 1; i < log_size; ++i) {
+        AVS_UNIT_ASSERT_TRUE(log[i - 1] < log[i]);
+    }
+    size_t executed = log_size;
+
+    mock_clock_advance(avs_time_duration_from_scalar(1, AVS_TIME_S));
+    avs_sched_run(env.sched);
+    AVS_UNIT_ASSERT_FALSE(
+            avs_time_monotonic_valid(avs_sched_time_of_next(env.sched)));
+    for (size_t i = executed + 1; i < log_size; ++i) {
+        AVS_UNIT_ASSERT_TRUE(log[i - 1] < log[i]);
+    }
+    for (size_t i = executed; i < log_size; ++i) {
+        AVS_UNIT_ASSERT_TRUE(log[i] % 5 == 0 && log[i] % 3 != 0);
+    }
+    AVS_UNIT_ASSERT_EQUAL(log_size, JOB_COUNT - (JOB_COUNT + 2) / 3);
+    for (int i = 0; i < JOB_COUNT; ++i) {
+        AVS_UNIT_ASSERT_NULL(handles[i]);
+    }
+
+    teardown_test(&env);
+}
+
+AVS_UNIT_TEST(sched, batch) {
+    sched_test_env_t env = setup_test();
+
+    int counters[4] = { 0 };
+    int *counter_ptrs[4];
+    avs_sched_handle_t handles[4] = { NULL };
+    avs_sched_batch_entry_t entries[4];
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(entries); ++i) {
+        counter_ptrs[i] = &counters[i];
+        entries[i] = (avs_sched_batch_entry_t) {
+            .out_handle = &handles[i],
+            .instant = avs_time_monotonic_from_scalar((int64_t) i + 1,
+                                                      AVS_TIME_S),
+            .clb = increment_task,
+            .clb_data = &counter_ptrs[i],
+            .clb_data_size = sizeof(int *)
+        };
+    }
+    // the second entry replaces the first one
+    entries[1].out_handle = &handles[0];
+
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_sched_at_batch(env.sched, entries, AVS_ARRAY_SIZE(entries)));
+    AVS_UNIT_ASSERT_NOT_NULL(handles[0]);
+    AVS_UNIT_ASSERT_NULL(handles[1]);
+    AVS_UNIT_ASSERT_NOT_NULL(handles[2]);
+    AVS_UNIT_ASSERT_NOT_NULL(handles[3]);
+
+    avs_sched_handle_t *to_delete[] = { &handles[2], NULL, &handles[1] };
+    avs_sched_del_batch(to_delete, AVS_ARRAY_SIZE(to_delete));
+    AVS_UNIT_ASSERT_NULL(handles[2]);
+
+    mock_clock_advance(avs_time_duration_from_scalar(5, AVS_TIME_S));
+    avs_sched_run(env.sched);
+    AVS_UNIT_ASSERT_EQUAL(counters[0], 0);
+    AVS_UNIT_ASSERT_EQUAL(counters[1], 1);
+    AVS_UNIT_ASSERT_EQUAL(counters[2], 0);
+    AVS_UNIT_ASSERT_EQUAL(counters[3], 1);
+    AVS_UNIT_ASSERT_NULL(handles[0]);
+    AVS_UNIT_ASSERT_NULL(handles[3]);
+
+    teardown_test(&env);
+}
+
+AVS_UNIT_TEST(sched, batch_is_atomic) {
+    sched_test_env_t env = setup_test();
+
+    int counter = 0;
+    avs_sched_handle_t handle = NULL;
+    const avs_sched_batch_entry_t entries[] = {
+        {
+            .out_handle = &handle,
+            .instant = avs_time_monotonic_now(),
+            .clb = increment_task,
+            .clb_data = &(int *) { &counter },
+            .clb_data_size = sizeof(int *)
+        },
+        {
+            .instant = avs_time_monotonic_now()
+        }
+    };
+    AVS_UNIT_ASSERT_FAILED(
+            avs_sched_at_batch(env.sched, entries, AVS_ARRAY_SIZE(entries)));
+    AVS_UNIT_ASSERT_NULL(handle);
+    AVS_UNIT_ASSERT_FALSE(
+            avs_time_monotonic_valid(avs_sched_time_of_next(env.sched)));
+
+    teardown_test(&env);
+}
+
+AVS_UNIT_TEST(sched, slack_coalesces_wakeups) {
+    sched_test_env_t env = setup_test();
+
+    int counter = 0;
+    AVS_UNIT_ASSERT_FAILED(avs_sched_set_slack(
+            env.sched, avs_time_duration_from_scalar(-1, AVS_TIME_S)));
+    AVS_UNIT_ASSERT_SUCCESS(avs_sched_set_slack(
+            env.sched, avs_time_duration_from_scalar(500, AVS_TIME_MS)));
+    const int64_t instants_ms[] = { 1000, 1300, 2000 };
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(instants_ms); ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(AVS_SCHED_AT(
+                env.sched, NULL,
+                avs_time_monotonic_from_scalar(instants_ms[i], AVS_TIME_MS),
+                increment_task, &(int *) { &counter }, sizeof(int *)));
+    }
+
+    AVS_UNIT_ASSERT_TRUE(avs_time_monotonic_equal(
+            avs_sched_time_of_next(env.sched),
+            avs_time_monotonic_from_scalar(1500, AVS_TIME_MS)));
+    mock_clock_advance(avs_time_duration_from_scalar(1500, AVS_TIME_MS));
+    avs_sched_run(env.sched);
+    AVS_UNIT_ASSERT_EQUAL(counter, 2);
+
+    AVS_UNIT_ASSERT_TRUE(avs_time_monotonic_equal(
+            avs_sched_time_of_next(env.sched),
+            avs_time_monotonic_from_scalar(2500, AVS_TIME_MS)));
+
+    teardown_test(&env);
+}
+
+#ifdef WITH_WORKER_TESTS
+// worker tests use the real clock, as the mock one is not thread-safe
+static avs_sched_t *worker_test_sched_new(void) {
+    MOCK_CLOCK = AVS_TIME_MONOTONIC_INVALID;
+    avs_sched_t *sched = avs_sched_new("workers", NULL);
+    AVS_UNIT_ASSERT_NOT_NULL(sched);
+    return sched;
+}
+
+typedef struct {
+    avs_mutex_t *mutex;
+    int in_progress[2];
+    int last_seq[2];
+    int running;
+    int max_running;
+    int done;
+    bool violation;
+} worker_test_state_t;
+
+typedef struct {
+    worker_test_state_t *state;
+    int key;
+    int seq;
+} worker_test_job_args_t;
+
+static void worker_test_job(avs_sched_t *sched, const void *args_) {
+    (void) sched;
+    const worker_test_job_args_t *args =
+            (const worker_test_job_args_t *) args_;
+    worker_test_state_t *state = args->state;
+
+    avs_mutex_lock(state->mutex);
+    if (state->in_progress[args->key]++
+            || state->last_seq[args->key] >= args->seq) {
+        state->violation = true;
+    }
+    state->last_seq[args->key] = args->seq;
+    if (++state->running > state->max_running) {
+        state->max_running = state->running;
+    }
+    avs_mutex_unlock(state->mutex);
+
+    nanosleep(&(const struct timespec) { 0, 100000 }, NULL);
+
+    avs_mutex_lock(state->mutex);
+    --state->in_progress[args->key];
+    --state->running;
+    ++state->done;
+    avs_mutex_unlock(state->mutex);
+}
+
+static void *worker_thread(void *sched) {
+    return (void *) (intptr_t) avs_sched_worker_run((avs_sched_t *) sched);
+}
+
+AVS_UNIT_TEST(sched, workers_respect_affinity) {
+    enum { JOBS_PER_KEY = 50 };
+    avs_sched_t *sched = worker_test_sched_new();
+
+    worker_test_state_t state = {
+        .last_seq = { -1, -1 }
+    };
+    AVS_UNIT_ASSERT_SUCCESS(avs_mutex_create(&state.mutex));
+
+    pthread_t threads[4];
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(threads); ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(
+                pthread_create(&threads[i], NULL, worker_thread, sched));
+    }
+
+    for (int seq = 0; seq < JOBS_PER_KEY; ++seq) {
+        for (int key = 0; key < 2; ++key) {
+            const worker_test_job_args_t args = { &state, key, seq };
+            AVS_UNIT_ASSERT_SUCCESS(AVS_SCHED_NOW_WITH_AFFINITY(
+                    sched, NULL, &state.in_progress[key], worker_test_job,
+                    &args, sizeof(args)));
+        }
+    }
+
+    const avs_time_monotonic_t deadline = avs_time_monotonic_add(
+            avs_time_monotonic_now(),
+            avs_time_duration_from_scalar(30, AVS_TIME_S));
+    int done;
+    do {
+        nanosleep(&(const struct timespec) { 0, 1000000 }, NULL);
+        avs_mutex_lock(state.mutex);
+        done = state.done;
+        avs_mutex_unlock(state.mutex);
+    } while (done < 2 * JOBS_PER_KEY
+             && avs_time_monotonic_before(avs_time_monotonic_now(),
+                                          deadline));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_sched_workers_stop(sched));
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(threads); ++i) {
+        void *result = NULL;
+        AVS_UNIT_ASSERT_SUCCESS(pthread_join(threads[i], &result));
+        AVS_UNIT_ASSERT_NULL(result);
+    }
+
+    AVS_UNIT_ASSERT_EQUAL(state.done, 2 * JOBS_PER_KEY);
+    AVS_UNIT_ASSERT_FALSE(state.violation);
+    AVS_UNIT_ASSERT_TRUE(state.max_running <= 2);
+
+    avs_mutex_cleanup(&state.mutex);
+    avs_sched_cleanup(&sched);
+}
+
+AVS_UNIT_TEST(sched, workers_stop_leaves_future_jobs) {
+    avs_sched_t *sched = worker_test_sched_new();
+
+    pthread_t thread;
+    AVS_UNIT_ASSERT_SUCCESS(pthread_create(&thread, NULL, worker_thread, sched));
+
+    int counter = 0;
+    avs_sched_handle_t task = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(AVS_SCHED_DELAYED(
+            sched, &task, avs_time_duration_from_scalar(1, AVS_TIME_HOUR),
+            increment_task, &(int *) { &counter }, sizeof(int *)));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_sched_workers_stop(sched));
+    void *result = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(pthread_join(thread, &result));
+    AVS_UNIT_ASSERT_NULL(result);
+
+    AVS_UNIT_ASSERT_NOT_NULL(task);
+    AVS_UNIT_ASSERT_EQUAL(counter, 0);
+    avs_sched_cleanup(&sched);
+    AVS_UNIT_ASSERT_NULL(task);
+}
+#endif // WITH_WORKER_TESTS
+
+#ifdef AVS_COMMONS_SCHED_WITH_JOB_POOL
+AVS_UNIT_TEST(sched, job_pool_reuses_records) {
+    sched_test_env_t env = setup_test();
+
+    const size_t unsorted_classes[] = { 64, 8 };
+    AVS_UNIT_ASSERT_FAILED(avs_sched_pool_configure(
+            env.sched, unsorted_classes, AVS_ARRAY_SIZE(unsorted_classes), 4));
+    const size_t classes[] = { sizeof(int *), 64 };
+    AVS_UNIT_ASSERT_SUCCESS(avs_sched_pool_configure(
+            env.sched, classes, AVS_ARRAY_SIZE(classes), 2));
+
+    int counter = 0;
+    avs_sched_handle_t handles[3] = { NULL };
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(handles); ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(AVS_SCHED_NOW(env.sched, &handles[i],
+                                              increment_task,
+                                              &(int *) { &counter },
+                                              sizeof(int *)));
+    }
+    avs_sched_pool_stats_t stats;
+    AVS_UNIT_ASSERT_SUCCESS(avs_sched_pool_stats(env.sched, &stats));
+    AVS_UNIT_ASSERT_EQUAL(stats.hits, 0);
+    AVS_UNIT_ASSERT_EQUAL(stats.misses, 3);
+    AVS_UNIT_ASSERT_EQUAL(stats.cached, 0);
+
+    // only two records shall be cached, the third one is freed
+    avs_sched_run(env.sched);
+    AVS_UNIT_ASSERT_EQUAL(counter, 3);
+    AVS_UNIT_ASSERT_SUCCESS(avs_sched_pool_stats(env.sched, &stats));
+    AVS_UNIT_ASSERT_EQUAL(stats.cached, 2);
+
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(handles); ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(AVS_SCHED_NOW(env.sched, &handles[i],
+                                              increment_task,
+                                              &(int *) { &counter },
+                                              sizeof(int *)));
+    }
+    AVS_UNIT_ASSERT_SUCCESS(avs_sched_pool_stats(env.sched, &stats));
+    AVS_UNIT_ASSERT_EQUAL(stats.hits, 2);
+    AVS_UNIT_ASSERT_EQUAL(stats.misses, 4);
+    AVS_UNIT_ASSERT_EQUAL(stats.cached, 0);
+
+    // cancelled jobs are returned to the pool as well
+    avs_sched_del(&handles[0]);
+    AVS_UNIT_ASSERT_SUCCESS(avs_sched_pool_stats(env.sched, &stats));
+    AVS_UNIT_ASSERT_EQUAL(stats.cached, 1);
+
+    avs_sched_run(env.sched);
+    AVS_UNIT_ASSERT_EQUAL(counter, 5);
+
+    teardown_test(&env);
+}
+#endif // AVS_COMMONS_SCHED_WITH_JOB_POOL
+
+#ifdef AVS_COMMONS_SCHED_WITH_STATS
+static void sleeping_task(avs_sched_t *sched, const void *duration_ms_ptr) {
+    (void) sched;
+    mock_clock_advance(avs_time_duration_from_scalar(
+            *(const int64_t *) duration_ms_ptr, AVS_TIME_MS));
+}
+
+static void schedule_sleeping_task(avs_sched_t *sched,
+                                   unsigned line,
+                                   int64_t duration_ms) {
+    AVS_UNIT_ASSERT_SUCCESS(avs_sched_at_impl__(
+            sched, NULL, avs_time_monotonic_now(), "slow.c", line,
+            "sleeping_task", sleeping_task, &duration_ms, sizeof(duration_ms)));
+}
+
+AVS_UNIT_TEST(sched, stats) {
+    sched_test_env_t env = setup_test();
+
+    int counter = 0;
+    AVS_UNIT_ASSERT_SUCCESS(AVS_SCHED_AT(
+            env.sched, NULL,
+            avs_time_monotonic_from_scalar(1000, AVS_TIME_MS), increment_task,
+            &(int *) { &counter }, sizeof(int *)));
+    mock_clock_advance(avs_time_duration_from_scalar(1500, AVS_TIME_MS));
+    avs_sched_run(env.sched);
+    AVS_UNIT_ASSERT_EQUAL(counter, 1);
+
+    avs_sched_stats_t stats;
+    AVS_UNIT_ASSERT_SUCCESS(avs_sched_stats(env.sched, &stats));
+    AVS_UNIT_ASSERT_EQUAL(stats.lateness.count, 1);
+    // 500 ms is in range [2^18, 2^19) us
+    AVS_UNIT_ASSERT_EQUAL(stats.lateness.buckets[19], 1);
+    AVS_UNIT_ASSERT_EQUAL(stats.exec_time.count, 1);
+    AVS_UNIT_ASSERT_EQUAL(stats.exec_time.buckets[0], 1);
+    AVS_UNIT_ASSERT_EQUAL(stats.slow_jobs_count, 1);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_sched_stats_reset(env.sched));
+    for (unsigned i = 0; i < AVS_SCHED_STATS_SLOW_JOBS + 2; ++i) {
+        schedule_sleeping_task(env.sched, i, 10 * (int64_t) i);
+    }
+    schedule_sleeping_task(env.sched, 3, 200);
+    avs_sched_run(env.sched);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_sched_stats(env.sched, &stats));
+    AVS_UNIT_ASSERT_EQUAL(stats.exec_time.count, AVS_SCHED_STATS_SLOW_JOBS + 3);
+    AVS_UNIT_ASSERT_EQUAL(stats.slow_jobs_count, AVS_SCHED_STATS_SLOW_JOBS);
+    AVS_UNIT_ASSERT_EQUAL_STRING(stats.slow_jobs[0].file, "slow.c");
+    AVS_UNIT_ASSERT_EQUAL(stats.slow_jobs[0].line, 3);
+    AVS_UNIT_ASSERT_EQUAL(stats.slow_jobs[1].line,
+                          AVS_SCHED_STATS_SLOW_JOBS + 1);
+    AVS_UNIT_ASSERT_EQUAL(stats.slow_jobs[AVS_SCHED_STATS_SLOW_JOBS - 1].line,
+                          2);
+    AVS_UNIT_ASSERT_TRUE(avs_time_duration_less(
+            avs_time_duration_from_scalar(200, AVS_TIME_MS),
+            stats.exec_time.max));
+
+    teardown_test(&env);
+}
+#endif // AVS_COMMONS_SCHED_WITH_STATS
+
 #warning "TODO: More tests"
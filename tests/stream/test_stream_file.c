@@ -169,3 +169,27 @@ AVS_UNIT_TEST(stream_file, extensions_length) {
     AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
     unlink(filename);
 }
+
+AVS_UNIT_TEST(stream_file, get_fp) {
+    char filename[sizeof(TEMPLATE)];
+    char data[] = "TEST";
+    char buf[sizeof(data)];
+    avs_stream_t *stream;
+    AVS_UNIT_ASSERT_SUCCESS(make_temporary(filename));
+    AVS_UNIT_ASSERT_NOT_NULL(
+            (stream = avs_stream_file_create(
+                     filename, AVS_STREAM_FILE_READ | AVS_STREAM_FILE_WRITE)));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, data, sizeof(data)));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_file_seek(stream, 1));
+
+    FILE *fp = avs_stream_file_get_fp(stream);
+    AVS_UNIT_ASSERT_NOT_NULL(fp);
+    AVS_UNIT_ASSERT_EQUAL(fread(buf, 1, 2, fp), 2);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, "ES", 2);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_read_reliably(stream, buf, 1));
+    AVS_UNIT_ASSERT_EQUAL(buf[0], 'T');
+
+    AVS_UNIT_ASSERT_NULL(avs_stream_file_get_fp(NULL));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+    unlink(filename);
+}
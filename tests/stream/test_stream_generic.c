@@ -23,6 +23,7 @@
 #include <avsystem/commons/avs_stream_file.h>
 #include <avsystem/commons/avs_stream_membuf.h>
 #include <avsystem/commons/avs_stream_simple_io.h>
+#include <avsystem/commons/avs_stream_v_table.h>
 
 #include "test_stream_common.h"
 
@@ -618,3 +619,60 @@ AVS_UNIT_TEST(stream_generic, copy_stream) {
     cleanup_output_streams(istreams, ictx, istream_num);
     cleanup_output_streams(ostreams, octx, ostream_num);
 }
+
+typedef struct {
+    const avs_stream_v_table_t *const vtable;
+    avs_stream_t *copied_from;
+    avs_error_t copy_result;
+    size_t bytes_written;
+} copying_stream_t;
+
+static avs_error_t copying_stream_write_some(avs_stream_t *stream,
+                                             const void *buffer,
+                                             size_t *inout_data_length) {
+    (void) buffer;
+    ((copying_stream_t *) stream)->bytes_written += *inout_data_length;
+    return AVS_OK;
+}
+
+static avs_error_t copying_stream_copy_from(avs_stream_t *stream,
+                                            avs_stream_t *input_stream) {
+    copying_stream_t *copying_stream = (copying_stream_t *) stream;
+    copying_stream->copied_from = input_stream;
+    return copying_stream->copy_result;
+}
+
+static const avs_stream_v_table_t COPYING_STREAM_VTABLE = {
+    .write_some = copying_stream_write_some,
+    .extension_list =
+            (const avs_stream_v_table_extension_t[]) {
+                    { AVS_STREAM_V_TABLE_EXTENSION_COPY,
+                      &(const avs_stream_v_table_extension_copy_t) {
+                              copying_stream_copy_from } },
+                    AVS_STREAM_V_TABLE_EXTENSION_NULL }
+};
+
+AVS_UNIT_TEST(stream_generic, copy_stream_extension) {
+    copying_stream_t output = {
+        .vtable = &COPYING_STREAM_VTABLE
+    };
+    avs_stream_t *input = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(input);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(input, "data", 4));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_copy((avs_stream_t *) &output, input));
+    AVS_UNIT_ASSERT_TRUE(output.copied_from == input);
+    AVS_UNIT_ASSERT_EQUAL(output.bytes_written, 0);
+
+    // unsupported input streams are copied through a buffer
+    output.copy_result = avs_errno(AVS_ENOTSUP);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_copy((avs_stream_t *) &output, input));
+    AVS_UNIT_ASSERT_EQUAL(output.bytes_written, 4);
+
+    // other errors are passed through
+    output.copy_result = avs_errno(AVS_EIO);
+    avs_error_t err = avs_stream_copy((avs_stream_t *) &output, input);
+    AVS_UNIT_ASSERT_EQUAL(err.code, AVS_EIO);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&input));
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avsystem/commons/avs_unit_mocksock.h>
+#include <avsystem/commons/avs_unit_test.h>
+
+#include "tests/net/socket_common.h"
+
+static avs_stream_t *netbuf_create(avs_net_socket_t *socket) {
+    avs_stream_t *stream = NULL;
+    avs_unit_mocksock_expect_connect(socket, "host", "1234");
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_connect(socket, "host", "1234"));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_netbuf_create(&stream, socket, 16, 8));
+    return stream;
+}
+
+static void netbuf_cleanup(avs_stream_t **stream, avs_net_socket_t *socket) {
+    avs_unit_mocksock_assert_io_clean(socket);
+    avs_unit_mocksock_expect_shutdown(socket);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(stream));
+}
+
+AVS_UNIT_TEST(stream_netbuf, stream_write_overflow) {
+    avs_net_socket_t *socket = NULL;
+    avs_unit_mocksock_create(&socket);
+    avs_stream_t *stream = netbuf_create(socket);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, "head", 4));
+    // the buffered data and the new data may be sent together
+    avs_unit_mocksock_expect_output(socket, "head0123456789", 14);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, "0123456789", 10));
+
+    netbuf_cleanup(&stream, socket);
+}
+
+AVS_UNIT_TEST(stream_netbuf, datagram_write_overflow) {
+    avs_net_socket_t *client = NULL;
+    avs_net_socket_t *server = NULL;
+    create_udp_pair(&client, &server);
+    avs_stream_t *stream = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_netbuf_create(&stream, client, 16, 8));
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, "head", 4));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, "0123456789", 10));
+
+    // the buffered data shall have been sent as a separate datagram
+    char buffer[32];
+    size_t bytes_received;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_receive(server, &bytes_received,
+                                                   buffer, sizeof(buffer)));
+    AVS_UNIT_ASSERT_EQUAL(bytes_received, 4);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buffer, "head", 4);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_receive(server, &bytes_received,
+                                                   buffer, sizeof(buffer)));
+    AVS_UNIT_ASSERT_EQUAL(bytes_received, 10);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buffer, "0123456789", 10);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_cleanup(&stream));
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_cleanup(&server));
+}
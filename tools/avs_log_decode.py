@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Copyright 2022 AVSystem <avsystem@avsystem.com>
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import argparse
+import re
+import struct
+import sys
+
+# Keep in sync with src/log/avs_log_binary.h
+MAGIC = b'AVSB'
+VERSION = 2
+RECORD_STRING = 0x01
+RECORD_MESSAGE = 0x02
+
+LEVELS = ['TRACE', 'DEBUG', 'INFO', 'WARNING', 'ERROR']
+
+CONVERSION_SPEC = re.compile(
+    r'%(?P<flags>[-+ #0]*)(?P<width>\*|[0-9]+)?(?:\.(?P<precision>\*|[0-9]*))?'
+    r'(?P<length>hh|h|ll|l|j|z|t|L)?(?P<conversion>.)', re.DOTALL)
+
+
+class TruncatedStream(Exception):
+    pass
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.offset = 0
+
+    def at_end(self):
+        return self.offset >= len(self.data)
+
+    def read_bytes(self, size):
+        if self.offset + size > len(self.data):
+            raise TruncatedStream()
+        result = self.data[self.offset:self.offset + size]
+        self.offset += size
+        return result
+
+    def read_byte(self):
+        return self.read_bytes(1)[0]
+
+    def read_varint(self):
+        result = 0
+        shift = 0
+        while True:
+            byte = self.read_byte()
+            result |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                return result
+
+    def read_zigzag(self):
+        value = self.read_varint()
+        return -((value + 1) >> 1) if value & 1 else value >> 1
+
+    def read_double(self):
+        return struct.unpack('<d', self.read_bytes(8))[0]
+
+    def read_string(self):
+        return self.read_bytes(self.read_varint()).decode('utf-8', errors='replace')
+
+
+def format_message(fmt, reader):
+    '''
+    Formats a message using a C printf-style format string, reading the
+    arguments from the binary stream in the same order as avs_log encoded them.
+    '''
+    output = []
+    position = 0
+    while True:
+        start = fmt.find('%', position)
+        if start < 0:
+            output.append(fmt[position:])
+            return ''.join(output)
+        output.append(fmt[position:start])
+        match = CONVERSION_SPEC.match(fmt, start)
+        if not match:
+            output.append(fmt[start:])
+            return ''.join(output)
+        position = match.end()
+
+        conversion = match.group('conversion')
+        if conversion == '%':
+            output.append('%')
+            continue
+
+        flags = match.group('flags')
+        width = match.group('width')
+        if width == '*':
+            width = reader.read_zigzag()
+            if width < 0:
+                flags += '-'
+                width = -width
+        precision = match.group('precision')
+        if precision == '*':
+            precision = reader.read_zigzag()
+            if precision < 0:
+                precision = None
+        elif precision is not None:
+            precision = int(precision or '0')
+
+        if conversion in 'di':
+            value, conversion = reader.read_zigzag(), 'd'
+        elif conversion in 'uoxX':
+            value = reader.read_varint()
+            if conversion == 'u':
+                conversion = 'd'
+            elif conversion == 'o' and '#' in flags:
+                # C prefixes octal values with '0', not '0o'
+                flags = flags.replace('#', '')
+                value, conversion = '0%o' % (value,) if value else '0', 's'
+        elif conversion == 'c':
+            value, conversion = chr(reader.read_zigzag() & 0xFF), 's'
+        elif conversion in 'eEfFgG':
+            value = reader.read_double()
+        elif conversion in 'aA':
+            # float.hex() does not strip trailing zeros, unlike printf()
+            value = re.sub(r'\.?0+p', 'p', reader.read_double().hex())
+            conversion = 's'
+            if match.group('conversion') == 'A':
+                value = value.upper()
+            precision = None
+        elif conversion == 's':
+            if match.group('length'):
+                # wide strings are not encoded
+                output.append(fmt[start:])
+                return ''.join(output)
+            value = reader.read_string()
+        elif conversion == 'p':
+            value, conversion = '0x%x' % (reader.read_varint(),), 's'
+        elif conversion == 'n':
+            continue
+        else:
+            # the encoder stops at unrecognized conversions as well
+            output.append(fmt[start:])
+            return ''.join(output)
+
+        spec = '%' + flags + (str(width) if width is not None else '')
+        if precision is not None:
+            spec += '.%d' % (precision,)
+        output.append((spec + conversion) % (value,))
+
+
+def decode(data, out):
+    reader = Reader(data)
+    if reader.read_bytes(len(MAGIC)) != MAGIC:
+        raise ValueError('not an avs_log binary stream')
+    version = reader.read_byte()
+    if version != VERSION:
+        raise ValueError('unsupported stream version: %d' % (version,))
+
+    strings = {0: None}
+    while not reader.at_end():
+        record_type = reader.read_byte()
+        if record_type == MAGIC[0] and data[reader.offset - 1:].startswith(MAGIC):
+            # another stream has been started, e.g. after the device rebooted
+            reader.read_bytes(len(MAGIC) - 1)
+            if reader.read_byte() != VERSION:
+                raise ValueError('unsupported stream version')
+            strings = {0: None}
+            continue
+
+        # trailing payload bytes not understood by this decoder are ignored
+        payload = Reader(reader.read_bytes(reader.read_varint()))
+        if record_type == RECORD_STRING:
+            string_id = payload.read_varint()
+            strings[string_id] = payload.read_string()
+        elif record_type == RECORD_MESSAGE:
+            level = payload.read_byte()
+            module = strings[payload.read_varint()]
+            file = strings[payload.read_varint()]
+            line = payload.read_varint()
+            fmt = strings[payload.read_varint()]
+            message = format_message(fmt, payload) if fmt is not None else '(null)'
+            level_str = LEVELS[level] if level < len(LEVELS) else 'WTF'
+            out.write('%s [%s] [%s:%u]: %s\n' % (level_str, module, file, line, message))
+
+
+def _main():
+    parser = argparse.ArgumentParser(
+        description='Decode avs_log binary mode streams into text log lines')
+    parser.add_argument('file', nargs='?',
+                        help='File containing the binary stream (default: standard input)')
+    args = parser.parse_args()
+
+    if args.file:
+        with open(args.file, 'rb') as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+
+    try:
+        decode(data, sys.stdout)
+    except TruncatedStream:
+        sys.stderr.write('warning: stream ends with an incomplete record\n')
+    except (KeyError, ValueError) as e:
+        sys.stderr.write('error: %s\n' % (e,))
+        return 1
+
+
+if __name__ == '__main__':
+    sys.exit(_main())
@@ -0,0 +1,176 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Loopback ping-pong benchmark for avs_net sockets.
+ *
+ * Built on demand:
+ *
+ *     make avs_net_ping_pong_benchmark
+ *     ./output/bin/avs_net_ping_pong_benchmark [ROUNDS] [SIZE]
+ *
+ * Exchanges ROUNDS request-response pairs of SIZE bytes each between two
+ * loopback UDP sockets and two connected TCP sockets, first with default
+ * socket configuration, then with optimistic_io enabled. Both ends are driven
+ * from a single thread, so data is always already queued when a receive
+ * operation is called - which is the case optimistic I/O is designed for.
+ */
+
+#include <avsystem/commons/avs_net.h>
+#include <avsystem/commons/avs_time.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int receive_exactly(avs_net_socket_t *socket, char *buf, size_t size) {
+    size_t total = 0;
+    while (total < size) {
+        size_t received;
+        if (avs_is_err(avs_net_socket_receive(socket, &received, buf + total,
+                                              size - total))
+                || !received) {
+            return -1;
+        }
+        total += received;
+    }
+    return 0;
+}
+
+static int ping_pong(avs_net_socket_t *a,
+                     avs_net_socket_t *b,
+                     unsigned long rounds,
+                     char *buf,
+                     size_t size) {
+    for (unsigned long i = 0; i < rounds; ++i) {
+        if (avs_is_err(avs_net_socket_send(a, buf, size))
+                || receive_exactly(b, buf, size)
+                || avs_is_err(avs_net_socket_send(b, buf, size))
+                || receive_exactly(a, buf, size)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int create_udp_pair(const avs_net_socket_configuration_t *config,
+                           avs_net_socket_t **out_a,
+                           avs_net_socket_t **out_b) {
+    char port_a[16];
+    char port_b[16];
+    return avs_is_ok(avs_net_udp_socket_create(out_a, config))
+                           && avs_is_ok(avs_net_udp_socket_create(out_b, config))
+                           && avs_is_ok(avs_net_socket_bind(*out_a, "127.0.0.1",
+                                                            "0"))
+                           && avs_is_ok(avs_net_socket_bind(*out_b, "127.0.0.1",
+                                                            "0"))
+                           && avs_is_ok(avs_net_socket_get_local_port(
+                                      *out_a, port_a, sizeof(port_a)))
+                           && avs_is_ok(avs_net_socket_get_local_port(
+                                      *out_b, port_b, sizeof(port_b)))
+                           && avs_is_ok(avs_net_socket_connect(
+                                      *out_a, "127.0.0.1", port_b))
+                           && avs_is_ok(avs_net_socket_connect(
+                                      *out_b, "127.0.0.1", port_a))
+                   ? 0
+                   : -1;
+}
+
+static int create_tcp_pair(const avs_net_socket_configuration_t *config,
+                           avs_net_socket_t **out_a,
+                           avs_net_socket_t **out_b) {
+    avs_net_socket_t *listener = NULL;
+    char port[16];
+    int result =
+            avs_is_ok(avs_net_tcp_socket_create(&listener, config))
+                            && avs_is_ok(avs_net_socket_bind(listener,
+                                                             "127.0.0.1", "0"))
+                            && avs_is_ok(avs_net_socket_get_local_port(
+                                       listener, port, sizeof(port)))
+                            && avs_is_ok(avs_net_tcp_socket_create(out_a,
+                                                                   config))
+                            && avs_is_ok(avs_net_socket_connect(
+                                       *out_a, "127.0.0.1", port))
+                            && avs_is_ok(avs_net_tcp_socket_create(out_b,
+                                                                   config))
+                            && avs_is_ok(avs_net_socket_accept(listener,
+                                                               *out_b))
+                    ? 0
+                    : -1;
+    avs_net_socket_cleanup(&listener);
+    return result;
+}
+
+static int run(const char *name,
+               int (*create_pair)(const avs_net_socket_configuration_t *,
+                                  avs_net_socket_t **,
+                                  avs_net_socket_t **),
+               bool optimistic_io,
+               unsigned long rounds,
+               char *buf,
+               size_t size) {
+    avs_net_socket_configuration_t config;
+    memset(&config, 0, sizeof(config));
+    config.address_family = AVS_NET_AF_INET4;
+    config.optimistic_io = optimistic_io;
+    avs_net_socket_t *a = NULL;
+    avs_net_socket_t *b = NULL;
+    int result = create_pair(&config, &a, &b);
+    if (result) {
+        fprintf(stderr, "%s: could not create loopback sockets\n", name);
+    } else {
+        avs_time_monotonic_t start = avs_time_monotonic_now();
+        if ((result = ping_pong(a, b, rounds, buf, size))) {
+            fprintf(stderr, "%s: I/O failed\n", name);
+        } else {
+            double seconds = avs_time_duration_to_fscalar(
+                    avs_time_monotonic_diff(avs_time_monotonic_now(), start),
+                    AVS_TIME_S);
+            printf("%-4s optimistic_io=%d rounds=%-10lu time=%8.3f s  %10.0f "
+                   "round trips/s\n",
+                   name, (int) optimistic_io, rounds, seconds,
+                   (double) rounds / seconds);
+        }
+    }
+    avs_net_socket_cleanup(&a);
+    avs_net_socket_cleanup(&b);
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    unsigned long rounds = (argc > 1 ? strtoul(argv[1], NULL, 10) : 200000UL);
+    size_t size = (argc > 2 ? (size_t) strtoul(argv[2], NULL, 10) : 64);
+    if (!rounds || !size) {
+        fprintf(stderr, "usage: %s [ROUNDS] [SIZE]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    char *buf = (char *) calloc(1, size);
+    if (!buf) {
+        fprintf(stderr, "out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    int result = 0;
+    for (int optimistic_io = 0; !result && optimistic_io <= 1;
+         ++optimistic_io) {
+        (void) ((result = run("udp", create_udp_pair, optimistic_io, rounds,
+                              buf, size))
+                || (result = run("tcp", create_tcp_pair, optimistic_io, rounds,
+                                 buf, size)));
+    }
+    free(buf);
+    return result ? EXIT_FAILURE : EXIT_SUCCESS;
+}
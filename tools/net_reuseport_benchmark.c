@@ -0,0 +1,277 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Loopback TCP connection rate benchmark for sharded listeners.
+ *
+ * Built on demand:
+ *
+ *     make avs_net_reuseport_benchmark
+ *     ./output/bin/avs_net_reuseport_benchmark [THREADS] [CONNECTIONS]
+ *
+ * THREADS client threads open and immediately close CONNECTIONS loopback TCP
+ * connections in total. They are accepted first by a single listening socket
+ * owned by a single thread, then by THREADS listening sockets bound to the
+ * same port using avs_net_socket_bind_shards(), each owned by its own thread.
+ *
+ * Clients run on the same machine, so the accept rate can only be expected to
+ * scale up to about half of the available CPU cores. Keep CONNECTIONS well
+ * below the ephemeral port range, as closed connections linger in TIME_WAIT.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <avsystem/commons/avs_net.h>
+#include <avsystem/commons/avs_net_poller.h>
+#include <avsystem/commons/avs_time.h>
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    pthread_mutex_t mutex;
+    unsigned long accepted;
+    unsigned long total;
+    bool aborted;
+} shared_state_t;
+
+typedef struct {
+    shared_state_t *shared;
+    avs_net_socket_t *listener;
+    char port[16];
+    unsigned long connections;
+    int result;
+} thread_arg_t;
+
+static bool is_done(shared_state_t *shared) {
+    pthread_mutex_lock(&shared->mutex);
+    bool result = shared->aborted || shared->accepted >= shared->total;
+    pthread_mutex_unlock(&shared->mutex);
+    return result;
+}
+
+static void count_accepted(shared_state_t *shared) {
+    pthread_mutex_lock(&shared->mutex);
+    ++shared->accepted;
+    pthread_mutex_unlock(&shared->mutex);
+}
+
+static void abort_run(shared_state_t *shared) {
+    pthread_mutex_lock(&shared->mutex);
+    shared->aborted = true;
+    pthread_mutex_unlock(&shared->mutex);
+}
+
+static void *acceptor_thread(void *arg_) {
+    thread_arg_t *arg = (thread_arg_t *) arg_;
+    avs_net_poller_t *poller = NULL;
+    if (avs_is_err(avs_net_poller_create(&poller))
+            || avs_is_err(avs_net_poller_add(poller, arg->listener,
+                                             AVS_NET_POLLER_READ, NULL))) {
+        arg->result = -1;
+    }
+    // the poller timeout only bounds the time it takes to notice that the
+    // other shards have accepted the remaining connections
+    while (!arg->result && !is_done(arg->shared)) {
+        avs_net_poller_event_t event;
+        size_t count;
+        avs_net_socket_t *socket = NULL;
+        if (avs_is_err(avs_net_poller_wait(
+                    poller, &event, 1, &count,
+                    avs_time_duration_from_scalar(10, AVS_TIME_MS)))) {
+            arg->result = -1;
+        } else if (count
+                   && (avs_is_err(avs_net_tcp_socket_create(&socket, NULL))
+                       || avs_is_err(avs_net_socket_accept(arg->listener,
+                                                           socket)))) {
+            arg->result = -1;
+        } else if (count) {
+            count_accepted(arg->shared);
+        }
+        avs_net_socket_cleanup(&socket);
+    }
+    if (arg->result) {
+        abort_run(arg->shared);
+    }
+    if (poller) {
+        avs_net_poller_remove(poller, arg->listener);
+        avs_net_poller_cleanup(&poller);
+    }
+    return NULL;
+}
+
+static void *connector_thread(void *arg_) {
+    thread_arg_t *arg = (thread_arg_t *) arg_;
+    for (unsigned long i = 0; !arg->result && i < arg->connections; ++i) {
+        avs_net_socket_t *socket = NULL;
+        if (avs_is_err(avs_net_tcp_socket_create(&socket, NULL))
+                || avs_is_err(
+                           avs_net_socket_connect(socket, "127.0.0.1",
+                                                  arg->port))) {
+            arg->result = -1;
+        }
+        avs_net_socket_cleanup(&socket);
+    }
+    if (arg->result) {
+        abort_run(arg->shared);
+    }
+    return NULL;
+}
+
+static size_t start_threads(pthread_t *threads,
+                            thread_arg_t *args,
+                            size_t count,
+                            void *(*func)(void *)) {
+    size_t started = 0;
+    for (; started < count; ++started) {
+        if (pthread_create(&threads[started], NULL, func, &args[started])) {
+            break;
+        }
+    }
+    return started;
+}
+
+static int join_threads(pthread_t *threads, thread_arg_t *args, size_t count) {
+    int result = 0;
+    for (size_t i = 0; i < count; ++i) {
+        pthread_join(threads[i], NULL);
+        if (args[i].result) {
+            result = -1;
+        }
+    }
+    return result;
+}
+
+static int run(size_t num_shards,
+               size_t num_clients,
+               unsigned long connections) {
+    avs_net_socket_configuration_t config;
+    memset(&config, 0, sizeof(config));
+    config.address_family = AVS_NET_AF_INET4;
+    config.reuse_port = true;
+
+    shared_state_t shared = {
+        .total = connections
+    };
+    pthread_t *threads =
+            (pthread_t *) calloc(num_shards + num_clients, sizeof(pthread_t));
+    thread_arg_t *args = (thread_arg_t *) calloc(num_shards + num_clients,
+                                                 sizeof(thread_arg_t));
+    avs_net_socket_t **listeners = (avs_net_socket_t **) calloc(
+            num_shards, sizeof(avs_net_socket_t *));
+    int result = (threads && args && listeners
+                  && !pthread_mutex_init(&shared.mutex, NULL))
+                         ? 0
+                         : -1;
+    if (result) {
+        fprintf(stderr, "out of memory\n");
+        free(threads);
+        free(args);
+        free(listeners);
+        return result;
+    }
+
+    char port[16];
+    for (size_t i = 0; !result && i < num_shards; ++i) {
+        if (avs_is_err(avs_net_tcp_socket_create(&listeners[i], &config))) {
+            result = -1;
+        }
+    }
+    if (result
+            || avs_is_err(avs_net_socket_bind_shards(listeners, num_shards,
+                                                     "127.0.0.1", "0"))
+            || avs_is_err(avs_net_socket_get_local_port(listeners[0], port,
+                                                        sizeof(port)))) {
+        fprintf(stderr, "could not create listening sockets\n");
+        result = -1;
+    }
+
+    if (!result) {
+        for (size_t i = 0; i < num_shards + num_clients; ++i) {
+            args[i].shared = &shared;
+            if (i < num_shards) {
+                args[i].listener = listeners[i];
+            } else {
+                size_t client = i - num_shards;
+                strcpy(args[i].port, port);
+                args[i].connections = connections / num_clients;
+                if (client < connections % num_clients) {
+                    ++args[i].connections;
+                }
+            }
+        }
+
+        avs_time_monotonic_t start = avs_time_monotonic_now();
+        size_t acceptors =
+                start_threads(threads, args, num_shards, acceptor_thread);
+        size_t clients = 0;
+        if (acceptors == num_shards) {
+            clients = start_threads(threads + num_shards, args + num_shards,
+                                    num_clients, connector_thread);
+        }
+        if (acceptors < num_shards || clients < num_clients) {
+            fprintf(stderr, "could not start threads\n");
+            abort_run(&shared);
+            result = -1;
+        }
+        if (join_threads(threads + num_shards, args + num_shards, clients)) {
+            result = -1;
+        }
+        if (join_threads(threads, args, acceptors)) {
+            result = -1;
+        }
+        double seconds = avs_time_duration_to_fscalar(
+                avs_time_monotonic_diff(avs_time_monotonic_now(), start),
+                AVS_TIME_S);
+
+        if (result) {
+            fprintf(stderr, "shards=%zu: I/O failed\n", num_shards);
+        } else {
+            printf("shards=%-4zu clients=%-4zu connections=%-8lu time=%8.3f s  "
+                   "%10.0f connections/s\n",
+                   num_shards, num_clients, shared.accepted, seconds,
+                   (double) shared.accepted / seconds);
+        }
+    }
+
+    for (size_t i = 0; i < num_shards; ++i) {
+        avs_net_socket_cleanup(&listeners[i]);
+    }
+    pthread_mutex_destroy(&shared.mutex);
+    free(threads);
+    free(args);
+    free(listeners);
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    size_t num_threads = (argc > 1 ? (size_t) strtoul(argv[1], NULL, 10) : 4);
+    unsigned long connections =
+            (argc > 2 ? strtoul(argv[2], NULL, 10) : 10000UL);
+    if (!num_threads || !connections) {
+        fprintf(stderr, "usage: %s [THREADS] [CONNECTIONS]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int result = run(1, num_threads, connections);
+    if (!result && num_threads > 1) {
+        result = run(num_threads, num_threads, connections);
+    }
+    return result ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,219 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Loopback TLS handshake rate benchmark for server-side session resumption.
+ *
+ * Built on demand:
+ *
+ *     make avs_net_tls_resumption_benchmark
+ *     ./output/bin/avs_net_tls_resumption_benchmark [HANDSHAKES] [CERT] [KEY]
+ *
+ * A client thread performs HANDSHAKES consecutive TLS handshakes with a server
+ * running in the main thread, which sends a single byte over each connection.
+ * This is done three times: with full handshakes only, then with resumption
+ * from the server-side session cache, and finally with resumption from
+ * session tickets. CERT and KEY default to the test certificates generated in
+ * the build directory.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <avsystem/commons/avs_net.h>
+#include <avsystem/commons/avs_time.h>
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    char port[16];
+    unsigned long handshakes;
+    bool resume;
+    int result;
+} client_arg_t;
+
+static void *client_thread(void *arg_) {
+    client_arg_t *arg = (client_arg_t *) arg_;
+    char session[4096] = "";
+    avs_crypto_prng_ctx_t *prng_ctx = avs_crypto_prng_new(NULL, NULL);
+    avs_net_ssl_configuration_t config;
+    memset(&config, 0, sizeof(config));
+    config.prng_ctx = prng_ctx;
+    config.security = avs_net_security_info_from_certificates(
+            (avs_net_certificate_info_t) {
+                .server_cert_validation = false
+            });
+    if (arg->resume) {
+        config.session_resumption_buffer = session;
+        config.session_resumption_buffer_size = sizeof(session);
+    }
+
+    arg->result = prng_ctx ? 0 : -1;
+    for (unsigned long i = 0; !arg->result && i < arg->handshakes; ++i) {
+        avs_net_socket_t *socket = NULL;
+        char byte;
+        size_t received = 0;
+        if (avs_is_err(avs_net_ssl_socket_create(&socket, &config))
+                || avs_is_err(
+                           avs_net_socket_connect(socket, "127.0.0.1",
+                                                  arg->port))
+                || avs_is_err(avs_net_socket_receive(socket, &received, &byte,
+                                                     1))
+                || received != 1) {
+            arg->result = -1;
+        }
+        avs_net_socket_cleanup(&socket);
+    }
+    avs_crypto_prng_free(&prng_ctx);
+    return NULL;
+}
+
+static int serve(avs_net_ssl_context_t *context,
+                 avs_net_socket_t *listener,
+                 unsigned long handshakes) {
+    const avs_net_ssl_configuration_t config = {
+        .context = context
+    };
+    int result = 0;
+    for (unsigned long i = 0; !result && i < handshakes; ++i) {
+        avs_net_socket_t *tcp_socket = NULL;
+        avs_net_socket_t *ssl_socket = NULL;
+        if (avs_is_err(avs_net_tcp_socket_create(&tcp_socket, NULL))
+                || avs_is_err(avs_net_socket_accept(listener, tcp_socket))
+                || avs_is_err(avs_net_ssl_socket_create(&ssl_socket, &config))
+                || avs_is_err(avs_net_socket_decorate(ssl_socket, tcp_socket))) {
+            avs_net_socket_cleanup(&tcp_socket);
+            result = -1;
+        } else if (avs_is_err(avs_net_socket_send(ssl_socket, "!", 1))) {
+            result = -1;
+        }
+        // the TCP socket, if decorated, is owned by the SSL one
+        avs_net_socket_cleanup(&ssl_socket);
+    }
+    return result;
+}
+
+static int run(const char *mode,
+               const avs_net_ssl_server_session_config_t *server_sessions,
+               unsigned long handshakes,
+               const char *cert_file,
+               const char *key_file) {
+    avs_crypto_prng_ctx_t *prng_ctx = avs_crypto_prng_new(NULL, NULL);
+    avs_net_ssl_configuration_t config;
+    memset(&config, 0, sizeof(config));
+    config.prng_ctx = prng_ctx;
+    config.server_sessions = server_sessions;
+    config.security = avs_net_security_info_from_certificates(
+            (avs_net_certificate_info_t) {
+                .ignore_system_trust_store = true,
+                .client_cert = avs_crypto_certificate_chain_info_from_file(
+                        cert_file),
+                .client_key =
+                        avs_crypto_private_key_info_from_file(key_file, NULL)
+            });
+
+    avs_net_ssl_context_t *context = NULL;
+    avs_net_socket_t *listener = NULL;
+    client_arg_t arg = {
+        .handshakes = handshakes,
+        .resume = !!server_sessions
+    };
+    int result = 0;
+    if (!prng_ctx
+            || avs_is_err(avs_net_ssl_context_create(&context, &config))) {
+        fprintf(stderr, "could not create SSL context\n");
+        result = -1;
+    } else if (avs_is_err(avs_net_tcp_socket_create(&listener, NULL))
+               || avs_is_err(avs_net_socket_bind(listener, "127.0.0.1", "0"))
+               || avs_is_err(avs_net_socket_get_local_port(
+                          listener, arg.port, sizeof(arg.port)))) {
+        fprintf(stderr, "could not create listening socket\n");
+        result = -1;
+    }
+
+    if (!result) {
+        pthread_t thread;
+        avs_time_monotonic_t start = avs_time_monotonic_now();
+        if (pthread_create(&thread, NULL, client_thread, &arg)) {
+            fprintf(stderr, "could not start thread\n");
+            result = -1;
+        } else {
+            result = serve(context, listener, handshakes);
+            if (result) {
+                // unblock the client, in case it waits for the server
+                avs_net_socket_close(listener);
+            }
+            pthread_join(thread, NULL);
+            if (arg.result) {
+                result = -1;
+            }
+        }
+        double seconds = avs_time_duration_to_fscalar(
+                avs_time_monotonic_diff(avs_time_monotonic_now(), start),
+                AVS_TIME_S);
+
+        avs_net_ssl_server_session_stats_t stats = { 0 };
+        if (result) {
+            fprintf(stderr, "%s: handshakes failed\n", mode);
+        } else if (server_sessions
+                   && avs_is_err(avs_net_ssl_context_get_server_session_stats(
+                              context, &stats))) {
+            fprintf(stderr, "%s: could not get statistics\n", mode);
+            result = -1;
+        } else {
+            printf("%-8s handshakes=%-8lu resumed=%-8llu time=%8.3f s  "
+                   "%10.0f handshakes/s\n",
+                   mode, handshakes, (unsigned long long) stats.resumed,
+                   seconds, (double) handshakes / seconds);
+        }
+    }
+
+    avs_net_socket_cleanup(&listener);
+    avs_net_ssl_context_cleanup(&context);
+    avs_crypto_prng_free(&prng_ctx);
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    unsigned long handshakes =
+            (argc > 1 ? strtoul(argv[1], NULL, 10) : 1000UL);
+    const char *cert_file = (argc > 2 ? argv[2] : "output/certs/server.crt");
+    const char *key_file = (argc > 3 ? argv[3] : "output/certs/server.key");
+    if (!handshakes) {
+        fprintf(stderr, "usage: %s [HANDSHAKES] [CERT] [KEY]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const avs_net_ssl_server_session_config_t cache = {
+        .max_sessions = 1024,
+        .lifetime = avs_time_duration_from_scalar(1, AVS_TIME_HOUR)
+    };
+    const avs_net_ssl_server_session_config_t tickets = {
+        .use_tickets = true,
+        .lifetime = avs_time_duration_from_scalar(1, AVS_TIME_HOUR)
+    };
+    int result = run("full", NULL, handshakes, cert_file, key_file);
+    if (!result) {
+        result = run("cache", &cache, handshakes, cert_file, key_file);
+    }
+    if (!result) {
+        result = run("tickets", &tickets, handshakes, cert_file, key_file);
+    }
+    return result ? EXIT_FAILURE : EXIT_SUCCESS;
+}
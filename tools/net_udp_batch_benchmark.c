@@ -0,0 +1,192 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Loopback throughput benchmark for batched UDP I/O in avs_net.
+ *
+ * Built on demand:
+ *
+ *     make avs_net_udp_batch_benchmark
+ *     ./output/bin/avs_net_udp_batch_benchmark [DATAGRAMS] [BATCH] [SIZE]
+ *
+ * Sends DATAGRAMS datagrams of SIZE bytes each over a loopback UDP socket pair,
+ * in rounds of BATCH datagrams, and receives them on the other end. This is
+ * done twice: using one avs_net_socket_send() / avs_net_socket_receive() call
+ * per datagram, and using avs_net_socket_send_batch() /
+ * avs_net_socket_receive_batch().
+ *
+ * BATCH datagrams need to fit in the receive buffer of the socket, otherwise
+ * some of them will be dropped and the benchmark will fail.
+ */
+
+#include <avsystem/commons/avs_net.h>
+#include <avsystem/commons/avs_time.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    avs_net_socket_t *server;
+    avs_net_socket_t *client;
+    size_t batch_size;
+    size_t datagram_size;
+    char *send_buffer;
+    char *recv_buffers;
+    avs_net_socket_outgoing_datagram_t *outgoing;
+    avs_net_socket_received_datagram_t *received;
+} benchmark_t;
+
+static int send_single(benchmark_t *bench) {
+    for (size_t i = 0; i < bench->batch_size; ++i) {
+        if (avs_is_err(avs_net_socket_send(bench->client, bench->send_buffer,
+                                           bench->datagram_size))) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int receive_single(benchmark_t *bench) {
+    for (size_t i = 0; i < bench->batch_size; ++i) {
+        size_t bytes_received;
+        if (avs_is_err(avs_net_socket_receive(bench->server, &bytes_received,
+                                              bench->recv_buffers,
+                                              bench->datagram_size))) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int send_batch(benchmark_t *bench) {
+    return avs_is_ok(avs_net_socket_send_batch(bench->client, bench->outgoing,
+                                               bench->batch_size, NULL))
+                   ? 0
+                   : -1;
+}
+
+static int receive_batch(benchmark_t *bench) {
+    size_t total = 0;
+    while (total < bench->batch_size) {
+        size_t received;
+        if (avs_is_err(avs_net_socket_receive_batch(
+                    bench->server, bench->received,
+                    bench->batch_size - total, &received))) {
+            return -1;
+        }
+        total += received;
+    }
+    return 0;
+}
+
+static int run(const char *name,
+               benchmark_t *bench,
+               unsigned long rounds,
+               int (*send_func)(benchmark_t *),
+               int (*receive_func)(benchmark_t *)) {
+    avs_time_monotonic_t start = avs_time_monotonic_now();
+    for (unsigned long i = 0; i < rounds; ++i) {
+        if (send_func(bench) || receive_func(bench)) {
+            fprintf(stderr, "%s: I/O failed in round %lu\n", name, i);
+            return -1;
+        }
+    }
+    double seconds = avs_time_duration_to_fscalar(
+            avs_time_monotonic_diff(avs_time_monotonic_now(), start),
+            AVS_TIME_S);
+    double datagrams = (double) rounds * (double) bench->batch_size;
+    printf("%-8s batch=%-4zu datagrams=%-10.0f time=%8.3f s  %12.0f "
+           "datagrams/s\n",
+           name, bench->batch_size, datagrams, seconds, datagrams / seconds);
+    return 0;
+}
+
+static int init(benchmark_t *bench) {
+    char port[16];
+    avs_net_socket_opt_value_t timeout = {
+        .recv_timeout = avs_time_duration_from_scalar(1, AVS_TIME_S)
+    };
+    if (avs_is_err(avs_net_udp_socket_create(&bench->server, NULL))
+            || avs_is_err(avs_net_socket_bind(bench->server, "127.0.0.1", "0"))
+            || avs_is_err(avs_net_socket_set_opt(
+                       bench->server, AVS_NET_SOCKET_OPT_RECV_TIMEOUT, timeout))
+            || avs_is_err(avs_net_socket_get_local_port(bench->server, port,
+                                                        sizeof(port)))
+            || avs_is_err(avs_net_udp_socket_create(&bench->client, NULL))
+            || avs_is_err(
+                       avs_net_socket_connect(bench->client, "127.0.0.1", port))) {
+        fprintf(stderr, "could not create loopback sockets\n");
+        return -1;
+    }
+
+    bench->send_buffer = (char *) calloc(1, bench->datagram_size);
+    bench->recv_buffers =
+            (char *) calloc(bench->batch_size, bench->datagram_size);
+    bench->outgoing = (avs_net_socket_outgoing_datagram_t *) calloc(
+            bench->batch_size, sizeof(*bench->outgoing));
+    bench->received = (avs_net_socket_received_datagram_t *) calloc(
+            bench->batch_size, sizeof(*bench->received));
+    if (!bench->send_buffer || !bench->recv_buffers || !bench->outgoing
+            || !bench->received) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+    for (size_t i = 0; i < bench->batch_size; ++i) {
+        bench->outgoing[i].data = bench->send_buffer;
+        bench->outgoing[i].data_length = bench->datagram_size;
+        bench->received[i].buffer =
+                &bench->recv_buffers[i * bench->datagram_size];
+        bench->received[i].buffer_length = bench->datagram_size;
+    }
+    return 0;
+}
+
+static void cleanup(benchmark_t *bench) {
+    avs_net_socket_cleanup(&bench->server);
+    avs_net_socket_cleanup(&bench->client);
+    free(bench->send_buffer);
+    free(bench->recv_buffers);
+    free(bench->outgoing);
+    free(bench->received);
+}
+
+int main(int argc, char *argv[]) {
+    unsigned long datagrams =
+            (argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000UL);
+    benchmark_t bench = {
+        .batch_size = (argc > 2 ? (size_t) strtoul(argv[2], NULL, 10) : 32),
+        .datagram_size = (argc > 3 ? (size_t) strtoul(argv[3], NULL, 10) : 64)
+    };
+    if (!datagrams || !bench.batch_size || !bench.datagram_size) {
+        fprintf(stderr, "usage: %s [DATAGRAMS] [BATCH] [SIZE]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    unsigned long rounds = datagrams / bench.batch_size;
+    if (!rounds) {
+        rounds = 1;
+    }
+
+    int result = init(&bench);
+    if (!result) {
+        result = run("single", &bench, rounds, send_single, receive_single);
+    }
+    if (!result) {
+        result = run("batch", &bench, rounds, send_batch, receive_batch);
+    }
+    cleanup(&bench);
+    return result ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright 2022 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Contention benchmark for avs_compat_threading implementations.
+ *
+ * Built on demand for each enabled implementation, e.g.:
+ *
+ *     make avs_compat_threading_futex_benchmark
+ *     ./output/bin/avs_compat_threading_futex_benchmark [THREADS] [ITERATIONS]
+ *
+ * Runs two scenarios:
+ * - THREADS threads incrementing a shared counter ITERATIONS times each, with
+ *   a short critical section guarded by a single avs_mutex_t,
+ * - two threads passing a token back and forth ITERATIONS times using
+ *   avs_condvar_t.
+ *
+ * Run it with more threads than available CPU cores to see the behaviour of an
+ * implementation on an oversubscribed machine.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <avsystem/commons/avs_condvar.h>
+#include <avsystem/commons/avs_mutex.h>
+#include <avsystem/commons/avs_time.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct {
+    avs_mutex_t *mutex;
+    avs_condvar_t *condvar;
+    unsigned long iterations;
+    unsigned long counter;
+    int turn;
+} shared_state_t;
+
+typedef struct {
+    shared_state_t *shared;
+    int id;
+} thread_arg_t;
+
+static void *mutex_thread(void *arg_) {
+    thread_arg_t *arg = (thread_arg_t *) arg_;
+    for (unsigned long i = 0; i < arg->shared->iterations; ++i) {
+        avs_mutex_lock(arg->shared->mutex);
+        ++arg->shared->counter;
+        avs_mutex_unlock(arg->shared->mutex);
+    }
+    return NULL;
+}
+
+static void *ping_pong_thread(void *arg_) {
+    thread_arg_t *arg = (thread_arg_t *) arg_;
+    avs_mutex_lock(arg->shared->mutex);
+    for (unsigned long i = 0; i < arg->shared->iterations; ++i) {
+        while (arg->shared->turn != arg->id) {
+            avs_condvar_wait(arg->shared->condvar, arg->shared->mutex,
+                             AVS_TIME_MONOTONIC_INVALID);
+        }
+        arg->shared->turn = !arg->id;
+        ++arg->shared->counter;
+        avs_condvar_notify_all(arg->shared->condvar);
+    }
+    avs_mutex_unlock(arg->shared->mutex);
+    return NULL;
+}
+
+static double elapsed_s(avs_time_monotonic_t start) {
+    return avs_time_duration_to_fscalar(
+            avs_time_monotonic_diff(avs_time_monotonic_now(), start),
+            AVS_TIME_S);
+}
+
+static int run(const char *name,
+               void *(*func)(void *),
+               shared_state_t *shared,
+               size_t num_threads) {
+    pthread_t *threads = (pthread_t *) calloc(num_threads, sizeof(pthread_t));
+    thread_arg_t *args =
+            (thread_arg_t *) calloc(num_threads, sizeof(thread_arg_t));
+    if (!threads || !args) {
+        free(threads);
+        free(args);
+        return -1;
+    }
+
+    shared->counter = 0;
+    shared->turn = 0;
+    avs_time_monotonic_t start = avs_time_monotonic_now();
+    size_t started = 0;
+    for (; started < num_threads; ++started) {
+        args[started].shared = shared;
+        args[started].id = (int) started;
+        if (pthread_create(&threads[started], NULL, func, &args[started])) {
+            break;
+        }
+    }
+    for (size_t i = 0; i < started; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    double seconds = elapsed_s(start);
+    free(threads);
+    free(args);
+    if (started < num_threads) {
+        fprintf(stderr, "could not start %s threads\n", name);
+        return -1;
+    }
+
+    printf("%-10s threads=%-4zu ops=%-10lu time=%8.3f s  %12.0f ops/s\n", name,
+           num_threads, shared->counter, seconds,
+           (double) shared->counter / seconds);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    size_t num_threads = (argc > 1 ? (size_t) strtoul(argv[1], NULL, 10) : 8);
+    unsigned long iterations =
+            (argc > 2 ? strtoul(argv[2], NULL, 10) : 1000000UL);
+    if (!num_threads || !iterations) {
+        fprintf(stderr, "usage: %s [THREADS] [ITERATIONS]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    shared_state_t shared = {
+        .iterations = iterations
+    };
+    if (avs_mutex_create(&shared.mutex)
+            || avs_condvar_create(&shared.condvar)) {
+        fprintf(stderr, "could not create synchronization primitives\n");
+        avs_mutex_cleanup(&shared.mutex);
+        return EXIT_FAILURE;
+    }
+
+    int result = run("mutex", mutex_thread, &shared, num_threads);
+    if (!result) {
+        shared.iterations = iterations / 10 ? iterations / 10 : 1;
+        result = run("ping-pong", ping_pong_thread, &shared, 2);
+    }
+
+    avs_condvar_cleanup(&shared.condvar);
+    avs_mutex_cleanup(&shared.mutex);
+    return result ? EXIT_FAILURE : EXIT_SUCCESS;
+}